@@ -24,6 +24,14 @@ cmake_dependent_option( ENABLE_SCITOKENS "Enable SciTokens plugin." TRUE "NOT XR
 cmake_dependent_option( ENABLE_MACAROONS "Enable Macaroons plugin." TRUE "NOT XRDCL_ONLY" FALSE )
 option( FORCE_ENABLED    "Fail build if enabled components cannot be built."              FALSE )
 
+# Maximum number of nodes a cmsd manager tracks without a supervisor. Values
+# above 64 (multiples of 64) switch the server mask to a wide bit vector.
+set( XRDCMS_MAXNODES 64 CACHE STRING "Maximum number of nodes per cmsd cell." )
+
+if(NOT XRDCMS_MAXNODES MATCHES "^[0-9]+$" OR XRDCMS_MAXNODES LESS 64)
+  message(FATAL_ERROR "XRDCMS_MAXNODES must be a number not less than 64")
+endif()
+
 # backward compatibility
 if(XRDCEPH_SUBMODULE)
   set(ENABLE_CEPH TRUE)
@@ -40,6 +40,12 @@ endif()
 check_include_file( shadow.h HAVE_SHADOWPW )
 compiler_define_if_found( HAVE_SHADOWPW HAVE_SHADOWPW )
 
+check_include_file( linux/io_uring.h HAVE_IO_URING_H )
+if( HAVE_IO_URING_H )
+  check_symbol_exists( __NR_io_uring_setup "sys/syscall.h" HAVE_IO_URING )
+  compiler_define_if_found( HAVE_IO_URING HAVE_IO_URING )
+endif()
+
 #-------------------------------------------------------------------------------
 # Some socket related functions
 #-------------------------------------------------------------------------------
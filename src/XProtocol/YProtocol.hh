@@ -115,6 +115,7 @@ enum CmsReqCode            // Request Codes
      kYR_update  = 25,
      kYR_usage   = 26,
      kYR_xauth   = 27,
+     kYR_summary = 28,
      kYR_MaxReq            // Count of request numbers (highest + 1)
 };
 
@@ -599,6 +600,33 @@ enum  {kYR_Stage  = 0x01, kYR_noStage = 0x02,  // Modifier
       };
 };
 
+/******************************************************************************/
+/*                       s u m m a r y   R e q u e s t                        */
+/******************************************************************************/
+
+// Request: summary <gen> <offset> <total> <ttl> <hashes> <bits>
+// Respond: n/a
+//
+// A server sends the Bloom filter of its namespace in one or more pieces, in
+// order, all with the same generation number. The request is always raw and
+// the data starts with CmsSummaryData in network byte order. The filter
+// remains valid for ttl seconds after the last piece arrives.
+//
+struct CmsSummaryRequest
+{      CmsRRHdr      Hdr;
+//     CmsSummaryData Info;
+//     kXR_char       Bits[];
+};
+
+struct CmsSummaryData
+{      kXR_unt32     Gen;      // Generation number of the filter
+       kXR_unt32     Offset;   // Offset of the bits in this piece
+       kXR_unt32     Total;    // Total number of bytes in the filter
+       kXR_unt16     TTL;      // Seconds the filter remains valid
+       kXR_char      Hashes;   // Number of hash functions
+       kXR_char      Rsvd;
+};
+
 /******************************************************************************/
 /*                         t r u n c   R e q u e s t                          */
 /******************************************************************************/
@@ -0,0 +1,373 @@
+/******************************************************************************/
+/*                                                                            */
+/*                          X r d C m s S i m . c c                           */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+// xrdcmssim replays a trace of transfer requests against a simulated cell and
+// compares the cmsd selection policies. Each node serves its transfers by
+// processor sharing at a given speed, reports its load every so often, and
+// answers state queries with a delay that grows with its number of transfers.
+// The trace file holds one request per line: "<arrival sec> <work sec>" where
+// work is the time the transfer takes on an idle node of speed 1. Without a
+// trace, Poisson arrivals with exponential work are generated. The p2c policy
+// uses the same arithmetic as the cmsd (see XrdCms/XrdCmsP2C.hh).
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "XrdCms/XrdCmsP2C.hh"
+#include "XrdSys/XrdSysE2T.hh"
+
+/******************************************************************************/
+/*                         L o c a l   D e f i n e s                          */
+/******************************************************************************/
+
+#define EMSG(x) std::cerr <<"xrdcmssim: "<<x<<std::endl
+
+/******************************************************************************/
+/*                         L o c a l   C l a s s e s                          */
+/******************************************************************************/
+
+namespace
+{
+struct Request {double Arrive; double Work;};
+
+struct Node
+{
+double              Speed;
+std::vector<double> Left;      // Remaining work of each active transfer
+std::vector<double> Start;     // Arrival time of each active transfer
+int                 rptLoad;   // Load as of the last report (0 - 100)
+int                 RefR;      // Redirects since the last report
+int                 rspLat;    // p2c: moving average of query response usec
+int                 selRecent; // p2c: recent redirects
+long long           selStamp;  // p2c: decay time stamp
+
+     Node(double s) : Speed(s), rptLoad(0), RefR(0), rspLat(0),
+                      selRecent(0), selStamp(0) {}
+};
+
+struct Config
+{
+int    Slots;      // Transfers per unit of speed that make a 100% load
+int    Fuzz;       // Load difference treated as equal
+int    RptInt;     // Seconds between load reports
+int    Decay;      // p2c half-life in seconds
+double QryBase;    // Seconds to answer a state query when idle
+double QryPer;     // Additional seconds per active transfer
+};
+}
+
+/******************************************************************************/
+/*                                G e t N u m                                 */
+/******************************************************************************/
+
+namespace
+{
+bool GetNum(const char *emsg, const char *item, double *val, double minv)
+{
+    char *eP;
+
+    if (!item || !*item)
+       {EMSG(emsg<<" value not specified"); return false;}
+
+    errno = 0;
+    *val  = strtod(item, &eP);
+    if (errno || *eP)
+       {EMSG(emsg<<" '"<<item<<"' is not a number");
+        return false;
+       }
+
+    if (*val < minv)
+       {EMSG(emsg<<" may not be less than "<<minv); return false;}
+
+    return true;
+}
+}
+
+/******************************************************************************/
+/*                                 U s a g e                                  */
+/******************************************************************************/
+
+namespace
+{
+void Usage(int rc)
+{
+std::cerr<<"\nUsage: xrdcmssim [-c count] [-d decay] [-l rptint] [-m work] "
+           "[-n nodes] [-p policy]\n"
+           "                 [-r rate] [-s slow] [-f trace]\n\n"
+           "policy: load | random | rr | p2c (default all)\n" <<std::endl;
+exit(rc);
+}
+}
+
+/******************************************************************************/
+/*                                S e l e c t                                 */
+/******************************************************************************/
+
+namespace
+{
+// The load, random, and rr policies mirror SelbyLoad(), SelbyLoadR(), and
+// SelbyRef() in XrdCmsCluster.cc; all of them only see reported loads.
+//
+int Select(const std::string &policy, std::vector<Node> &nodes,
+           const Config &cfg, long long now, std::minstd_rand &rng)
+{
+   int i, n = nodes.size(), sp = 0;
+
+   if (policy == "p2c")
+      {long long latSum = 0;
+       int latCnt = 0;
+       for (i = 0; i < n; i++)
+           if (nodes[i].rspLat) {latSum += nodes[i].rspLat; latCnt++;}
+       auto score = [&](int k)
+                    {Node &x = nodes[k];
+                     x.selRecent = XrdCmsP2C::Decay(x.selRecent, x.selStamp,
+                                                    now, cfg.Decay*1000000LL);
+                     return XrdCmsP2C::Score(XrdCmsP2C::Latency(x.rspLat,
+                                                            latSum, latCnt),
+                                             x.selRecent, x.rptLoad);
+                    };
+       sp = XrdCmsP2C::Pick(n, rng, score);
+       nodes[sp].selRecent++;
+      }
+   else if (policy == "random")
+      {std::vector<int> wt(n);
+       int tot = 0;
+       for (i = 0; i < n; i++)
+           wt[i] = (tot += cfg.Fuzz + 100 - nodes[i].rptLoad);
+       int pick = static_cast<int>(rng() % tot) + 1;
+       while(sp < n-1 && wt[sp] < pick) sp++;
+      }
+   else if (policy == "rr")
+      {for (i = 1; i < n; i++) if (nodes[sp].RefR > nodes[i].RefR) sp = i;
+      }
+   else
+      {for (i = 1; i < n; i++)
+           {if (abs(nodes[sp].rptLoad - nodes[i].rptLoad) <= cfg.Fuzz)
+               {if (nodes[sp].RefR > nodes[i].RefR) sp = i;}
+               else if (nodes[sp].rptLoad > nodes[i].rptLoad) sp = i;
+           }
+      }
+
+   nodes[sp].RefR++;
+   return sp;
+}
+}
+
+/******************************************************************************/
+/*                                   R u n                                    */
+/******************************************************************************/
+
+namespace
+{
+void Run(const std::string &policy, const std::vector<Request> &reqs,
+         const std::vector<double> &speeds, const Config &cfg)
+{
+   std::vector<Node> nodes(speeds.begin(), speeds.end());
+   std::vector<double> resp;
+   std::vector<long> served(nodes.size(), 0);
+   std::minstd_rand rng(1);
+   double now = 0, nextRpt = cfg.RptInt;
+   size_t r = 0;
+   int maxAct = 0;
+
+// Advance from event to event. An event is either the next arrival or the
+// next transfer completion; in between, every active transfer on a node
+// progresses at the node's speed divided by its number of transfers.
+//
+   resp.reserve(reqs.size());
+   while(r < reqs.size() || resp.size() < reqs.size())
+        {double tNext = (r < reqs.size() ? reqs[r].Arrive : 1e300);
+         int nDone = -1;
+         size_t jDone = 0;
+         for (size_t i = 0; i < nodes.size(); i++)
+             {Node &nd = nodes[i];
+              double rate = nd.Speed / (nd.Left.size() ? nd.Left.size() : 1);
+              for (size_t j = 0; j < nd.Left.size(); j++)
+                  if (now + nd.Left[j]/rate < tNext)
+                     {tNext = now + nd.Left[j]/rate; nDone = i; jDone = j;}
+             }
+         if (nextRpt <= tNext) {tNext = nextRpt; nDone = -1;}
+
+         // Progress all transfers up to the event
+         //
+         for (auto &nd : nodes)
+             {double done = (tNext - now) * nd.Speed
+                          / (nd.Left.size() ? nd.Left.size() : 1);
+              for (auto &w : nd.Left) w -= done;
+             }
+         now = tNext;
+
+         // Deliver load reports; the manager resets its redirect counts
+         //
+         if (now >= nextRpt)
+            {for (auto &nd : nodes)
+                 {nd.rptLoad = std::min(100, static_cast<int>(nd.Left.size()
+                             * 100 / (nd.Speed * cfg.Slots)));
+                  nd.RefR = 0;
+                 }
+             nextRpt += cfg.RptInt;
+             continue;
+            }
+
+         // Complete a transfer
+         //
+         if (nDone >= 0)
+            {Node &nd = nodes[nDone];
+             resp.push_back(now - nd.Start[jDone]);
+             nd.Left.erase(nd.Left.begin() + jDone);
+             nd.Start.erase(nd.Start.begin() + jDone);
+             continue;
+            }
+
+         // Handle an arrival. The state query that precedes the selection is
+         // answered by every node and, for p2c, timed.
+         //
+         long long usNow = static_cast<long long>(now * 1e6);
+         for (auto &nd : nodes)
+             {double qry = cfg.QryBase + cfg.QryPer*nd.Left.size()/nd.Speed;
+              nd.rspLat = XrdCmsP2C::Ewma(nd.rspLat, static_cast<int>(qry*1e6));
+             }
+         int sel = Select(policy, nodes, cfg, usNow, rng);
+         nodes[sel].Left.push_back(reqs[r].Work);
+         nodes[sel].Start.push_back(now);
+         maxAct = std::max(maxAct, static_cast<int>(nodes[sel].Left.size()));
+         served[sel]++;
+         r++;
+        }
+
+// Display the result
+//
+   std::sort(resp.begin(), resp.end());
+   double sum = 0;
+   for (auto v : resp) sum += v;
+   auto pct = [&resp](double p) {return resp[(size_t)(p*(resp.size()-1))];};
+   auto mm  = std::minmax_element(served.begin(), served.end());
+   printf("%-7s mean %9.3f p50 %9.3f p90 %9.3f p99 %9.3f maxact %5d "
+          "served %ld-%ld\n", policy.c_str(), sum/resp.size(), pct(0.50),
+          pct(0.90), pct(0.99), maxAct, *mm.first, *mm.second);
+}
+}
+
+/******************************************************************************/
+/*                                  m a i n                                   */
+/******************************************************************************/
+
+int main(int argc, char **argv)
+{
+   extern char *optarg;
+   extern int  optind, opterr;
+
+   std::vector<Request> reqs;
+   std::vector<double>  speeds;
+   std::vector<std::string> policies = {"load", "random", "rr", "p2c"};
+   Config cfg = {20, 20, 60, 4, 0.0002, 0.0005};
+   double Count = 20000, Decay = 4, Mean = 2, Nodes = 8, Rate = 3, Rpt = 60;
+   double Slow = 2;
+   char *inFile = 0;
+   char c;
+
+// Process the options
+//
+   opterr = 0;
+   while ((c = getopt(argc,argv,"c:d:f:hl:m:n:p:r:s:"))
+          && ((unsigned char)c != 0xff))
+     { switch(c)
+       {
+       case 'c': if (!GetNum("count", optarg, &Count, 1)) exit(1);
+                 break;
+       case 'd': if (!GetNum("decay", optarg, &Decay, 1)) exit(1);
+                 break;
+       case 'f': inFile = optarg;
+                 break;
+       case 'h': Usage(0);
+                 break;
+       case 'l': if (!GetNum("report interval", optarg, &Rpt, 1)) exit(1);
+                 break;
+       case 'm': if (!GetNum("mean work", optarg, &Mean, 0.001)) exit(1);
+                 break;
+       case 'n': if (!GetNum("nodes", optarg, &Nodes, 2)) exit(1);
+                 break;
+       case 'p': policies.assign(1, optarg);
+                 break;
+       case 'r': if (!GetNum("rate", optarg, &Rate, 0.001)) exit(1);
+                 break;
+       case 's': if (!GetNum("slow nodes", optarg, &Slow, 0)) exit(1);
+                 break;
+       default:  EMSG("Invalid option '-"<<argv[optind-1]<<"'");
+                 Usage(1);
+       }
+     }
+   cfg.Decay = static_cast<int>(Decay); cfg.RptInt = static_cast<int>(Rpt);
+
+// Establish the cell; slow nodes run at half speed
+//
+   for (int i = 0; i < static_cast<int>(Nodes); i++)
+       speeds.push_back(i < static_cast<int>(Slow) ? 0.5 : 1.0);
+
+// Read the trace or generate one
+//
+   if (inFile)
+      {FILE *Stream;
+       char lBuff[256];
+       Request rq;
+       if (!(Stream = fopen(inFile, "r")))
+          {EMSG("Unable to open "<<inFile<<"; "<<XrdSysE2T(errno));
+           exit(4);
+          }
+       while(fgets(lBuff, sizeof(lBuff), Stream))
+            if (*lBuff != '#'
+            &&  sscanf(lBuff, "%lf %lf", &rq.Arrive, &rq.Work) == 2
+            &&  rq.Work > 0) reqs.push_back(rq);
+       fclose(Stream);
+       std::stable_sort(reqs.begin(), reqs.end(),
+                        [](const Request &a, const Request &b)
+                          {return a.Arrive < b.Arrive;});
+       if (reqs.empty()) {EMSG("No requests found in "<<inFile); exit(4);}
+      } else {
+       std::mt19937_64 gen(12345);
+       std::exponential_distribution<double> gap(Rate), work(1.0/Mean);
+       double t = 0;
+       for (long i = 0; i < static_cast<long>(Count); i++)
+           {t += gap(gen); reqs.push_back({t, work(gen)});}
+      }
+
+// Run each policy over the same requests
+//
+   for (auto &p : policies)
+       {if (p != "load" && p != "random" && p != "rr" && p != "p2c")
+           {EMSG("Invalid policy '"<<p<<"'"); Usage(1);}
+        Run(p, reqs, speeds, cfg);
+       }
+   exit(0);
+}
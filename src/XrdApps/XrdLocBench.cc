@@ -0,0 +1,268 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d L o c B e n c h . c c                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+// xrdlocbench replays a recorded list of paths as kXR_locate requests against
+// a redirector using a number of concurrent clients and reports the lookup
+// rate and latency distribution. It is meant to measure the cmsd location
+// cache under realistic traffic. The path file holds one path per line, as
+// extracted from a redirector log or an xrdreplay recording.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/param.h>
+
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdSys/XrdSysE2T.hh"
+#include "XrdCl/XrdClFileSystem.hh"
+
+using namespace XrdCl;
+
+/******************************************************************************/
+/*                         L o c a l   D e f i n e s                          */
+/******************************************************************************/
+
+#define EMSG(x) std::cerr <<"xrdlocbench: "<<x<<std::endl
+
+/******************************************************************************/
+/*                                G e t N u m                                 */
+/******************************************************************************/
+
+namespace
+{
+bool GetNum(const char *emsg, const char *item, int *val, int minv, int maxv=-1)
+{
+    char *eP;
+
+    if (!item || !*item)
+       {EMSG(emsg<<" value not specified"); return false;}
+
+    errno = 0;
+    *val  = strtol(item, &eP, 10);
+    if (errno || *eP)
+       {EMSG(emsg<<" '"<<item<<"' is not a number");
+        return false;
+       }
+
+    if (*val < minv)
+       {EMSG(emsg<<" may not be less than "<<minv); return false;}
+    if (maxv >= 0 && *val > maxv)
+       {EMSG(emsg<<" may not be greater than "<<maxv); return false;}
+
+    return true;
+}
+}
+
+/******************************************************************************/
+/*                                 U s a g e                                  */
+/******************************************************************************/
+
+namespace
+{
+void Usage(int rc)
+{
+std::cerr<<"\nUsage: xrdlocbench [-d n] [-n passes] [-r] [-t threads] "
+           "-f fn host[:port]\n" <<std::endl;
+exit(rc);
+}
+}
+
+/******************************************************************************/
+/*                                R e p l a y                                 */
+/******************************************************************************/
+
+namespace
+{
+struct Replayer
+{
+FileSystem                     *Admin;
+const std::vector<std::string> *fList;
+OpenFlags::Flags                Opts;
+std::atomic<size_t>             Next;
+std::atomic<int>                Fails;
+size_t                          Total;
+
+void Run(std::vector<double> &lats)
+{
+   LocationInfo *info;
+   size_t n;
+
+// Each thread takes the next path in the replay so that the original
+// request order is preserved as closely as concurrency allows.
+//
+   while((n = Next++) < Total)
+        {info = 0;
+         auto t0 = std::chrono::steady_clock::now();
+         XRootDStatus st = Admin->Locate((*fList)[n % fList->size()], Opts, info);
+         auto t1 = std::chrono::steady_clock::now();
+         lats.push_back(std::chrono::duration<double,std::micro>(t1-t0).count());
+         if (!st.IsOK()) Fails++;
+         delete info;
+        }
+}
+
+     Replayer() : Admin(0), fList(0), Opts(OpenFlags::None), Next(0),
+                  Fails(0), Total(0) {}
+};
+}
+
+/******************************************************************************/
+/*                                  m a i n                                   */
+/******************************************************************************/
+
+int main(int argc, char **argv)
+{
+   extern char *optarg;
+   extern int  optind, opterr;
+
+   static const int MaxPathLen = MAXPATHLEN+1;
+
+   std::vector<std::string> fList;
+   FILE *Stream = 0;
+   char Target[512];
+   char *inFile = 0;
+   int rc, Debug = 0, Passes = 1, Threads = 16;
+   char c;
+   Replayer Rep;
+
+// See simple help is needed
+//
+   if (argc <= 1) Usage(0);
+
+// Process the options
+//
+   opterr = 0;
+   if (argc > 1 && '-' == *argv[1])
+      while ((c = getopt(argc,argv,"d:f:n:rt:")) && ((unsigned char)c != 0xff))
+     { switch(c)
+       {
+       case 'd': if (!GetNum("debug level", optarg, &Debug, 0, 5)) exit(1);
+                 break;
+       case 'f': inFile = optarg;
+                 break;
+       case 'n': if (!GetNum("passes", optarg, &Passes, 1)) exit(1);
+                 break;
+       case 'r': Rep.Opts |= OpenFlags::Refresh;
+                 break;
+       case 't': if (!GetNum("threads", optarg, &Threads, 1, 1024)) exit(1);
+                 break;
+       default:  EMSG("Invalid option '-"<<argv[optind-1]<<"'");
+                 Usage(1);
+       }
+     }
+
+// Make sure a host and a path file have been specified
+//
+   if (optind >= argc || !isalnum(*argv[optind]))
+      {EMSG("target host name not specified");
+       Usage(1);
+      }
+   if (!inFile)
+      {EMSG("replay file not specified");
+       Usage(1);
+      }
+   strcpy(Target, "root://");
+   strncat(Target, argv[optind], sizeof(Target)-8);
+
+// Read the recorded paths
+//
+   if (!(Stream = fopen(inFile, "r")))
+      {EMSG("Unable to open "<<inFile<<"; "<<XrdSysE2T(errno));
+       exit(4);
+      }
+   char *sP, fBuff[MaxPathLen];
+   std::string strArg;
+   do {if (!(sP = fgets(fBuff, MaxPathLen, Stream))) break;
+       while(*sP && *sP == ' ') sP++;
+       if (*sP == '/')
+          {strArg = sP;
+           if (strArg.size() && strArg.back() == '\n') strArg.pop_back();
+           while(strArg.size() && strArg.back() == ' ') strArg.pop_back();
+           fList.push_back(strArg);
+          }
+      } while(!feof(Stream) && !ferror(Stream));
+   if ((rc = ferror(Stream)))
+      {EMSG("unable to read "<<inFile<<"; "<<XrdSysE2T(rc));
+       exit(4);
+      }
+   fclose(Stream);
+   if (fList.empty())
+      {EMSG("No paths found in "<<inFile);
+       exit(4);
+      }
+
+// Establish debugging level
+//
+  if (Debug > 0)
+     {const char *dbg[] = {"Info","Warning","Error","Debug","Dump"};
+      if (Debug > 5) Debug = 5;
+      XrdOucEnv::Export("XRD_LOGLEVEL", dbg[Debug-1]);
+     }
+
+// Replay the requests
+//
+   FileSystem Admin(Target);
+   std::vector<std::vector<double>> tLats(Threads);
+   std::vector<std::thread> tList;
+   Rep.Admin = &Admin;
+   Rep.fList = &fList;
+   Rep.Total = fList.size() * Passes;
+
+   auto t0 = std::chrono::steady_clock::now();
+   for (int i = 0; i < Threads; i++)
+       tList.emplace_back(&Replayer::Run, &Rep, std::ref(tLats[i]));
+   for (auto &t : tList) t.join();
+   auto t1 = std::chrono::steady_clock::now();
+
+// Compute the latency distribution
+//
+   std::vector<double> lats;
+   lats.reserve(Rep.Total);
+   for (auto &v : tLats) lats.insert(lats.end(), v.begin(), v.end());
+   std::sort(lats.begin(), lats.end());
+   double secs = std::chrono::duration<double>(t1-t0).count();
+   auto pct = [&lats](double p) {return lats[(size_t)(p*(lats.size()-1))];};
+
+// Display the result
+//
+   std::cout <<"locates " <<lats.size() <<" failed " <<Rep.Fails
+             <<" threads " <<Threads <<" secs " <<secs
+             <<" rate " <<(secs > 0 ? lats.size()/secs : 0) <<"/s" <<std::endl;
+   std::cout <<"latency usec p50 " <<pct(0.50) <<" p90 " <<pct(0.90)
+             <<" p99 " <<pct(0.99) <<" max " <<lats.back() <<std::endl;
+
+// All done
+//
+   exit(Rep.Fails ? 8 : 0);
+}
@@ -103,6 +103,10 @@ XrdBwm::XrdBwm()
    PolParm       = 0;
    PolSlotsIn    = 1;
    PolSlotsOut   = 1;
+   PolSRF        = 0;
+   PolAging      = 1.0;
+   PolRate       = 0;
+   PolPreempt    = 0;
 
 // Obtain port number we will be using
 //
@@ -264,6 +268,8 @@ int XrdBwmFile::open(const char          *path,      // In
             info      - Opaque information:
                         bwm.src=<src  host>
                         bwm.dst=<dest host>
+                        bwm.size=<bytes to transfer>           (optional)
+                        bwm.deadline=<seconds to complete in>  (optional)
 
   Output:   Returns SFS_OK upon success, otherwise SFS_ERROR is returned.
 */
@@ -271,7 +277,11 @@ int XrdBwmFile::open(const char          *path,      // In
    EPNAME("open");
    XrdBwmHandle *hP;
    int incoming;
+   long long theSize = 0;
+   time_t theDeadline = 0;
    const char *miss, *theUsr, *theSrc, *theDst=0, *theLfn=0, *lclNode, *rmtNode;
+   const char *theVal;
+   char *eP;
    XrdOucEnv Open_Env(info);
 
 // Trace entry
@@ -310,6 +320,18 @@ int XrdBwmFile::open(const char          *path,      // In
    if (miss) return XrdBwmFS.Emsg("open", error, miss, "open", path);
    theUsr = error.getErrUser();
 
+// Pick up the optional size and deadline of the transfer. These only serve
+// as hints to the policy, so a malformed value is the same as none.
+//
+   if ((theVal = Open_Env.Get("bwm.size")))
+      {theSize = strtoll(theVal, &eP, 10);
+       if (*eP || theSize < 0) theSize = 0;
+      }
+   if ((theVal = Open_Env.Get("bwm.deadline")))
+      {long long dSec = strtoll(theVal, &eP, 10);
+       if (!*eP && dSec > 0) theDeadline = time(0) + dSec;
+      }
+
 // Determine the direction of flow
 //
         if (XrdOucUtils::endsWith(theSrc,XrdBwmFS.myDomain,XrdBwmFS.myDomLen))
@@ -320,7 +342,8 @@ int XrdBwmFile::open(const char          *path,      // In
 
 // Get a handle for this file.
 //
-   if (!(hP = XrdBwmHandle::Alloc(theUsr,theLfn,lclNode,rmtNode,incoming)))
+   if (!(hP = XrdBwmHandle::Alloc(theUsr,theLfn,lclNode,rmtNode,incoming,
+                                  theSize,theDeadline)))
       return XrdBwmFS.Stall(error, 13, path);
 
 // All done
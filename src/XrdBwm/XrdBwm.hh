@@ -281,6 +281,10 @@ char             *locResp;        //    ->Locate Response
 int               locRlen;        //      Length of locResp;
 int               PolSlotsIn;
 int               PolSlotsOut;
+int               PolSRF;         //      Use the shortest-remaining-first policy
+double            PolAging;       //      Its aging factor
+long long         PolRate;        //      Its initial link throughput
+double            PolPreempt;     //      Its preemption factor (0 -> none)
 
 static XrdBwmHandle     *dummyHandle;
 XrdSysMutex              ocMutex; // Global mutex for open/close
@@ -299,6 +303,7 @@ int           setupPolicy(XrdSysError &);
 int           xalib(XrdOucStream &, XrdSysError &);
 int           xlog(XrdOucStream &, XrdSysError &);
 int           xpol(XrdOucStream &, XrdSysError &);
+int           xpolf(XrdOucStream &, XrdSysError &, const char *, double &);
 int           xtrace(XrdOucStream &, XrdSysError &);
 };
 #endif
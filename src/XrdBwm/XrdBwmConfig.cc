@@ -41,6 +41,7 @@
 #include "XrdBwm/XrdBwmLogger.hh"
 #include "XrdBwm/XrdBwmPolicy.hh"
 #include "XrdBwm/XrdBwmPolicy1.hh"
+#include "XrdBwm/XrdBwmPolicy2.hh"
 #include "XrdBwm/XrdBwmTrace.hh"
 
 #include "XrdOuc/XrdOuca2x.hh"
@@ -131,6 +132,8 @@ int XrdBwm::Configure(XrdSysError &Eroute) {
 // Establish scheduling policy
 //
    if (PolLib) NoGo |= setupPolicy(Eroute);
+      else if (PolSRF) Policy = new XrdBwmPolicy2(PolSlotsIn, PolSlotsOut,
+                                     PolAging, PolRate, PolPreempt);
       else Policy = new XrdBwmPolicy1(PolSlotsIn, PolSlotsOut);
 
 // Start logger object
@@ -256,9 +259,19 @@ int XrdBwm::xlog(XrdOucStream &Config, XrdSysError &Eroute)
 
    Purpose:  To parse the directive: policy args
 
-             Args: {maxslots <innum> <outnum> | lib <path> [<parms>]}
+             Args: {maxslots <innum> <outnum> | srf <innum> <outnum> [<opts>]
+                   | lib <path> [<parms>]}
 
              <num>     maximum number of slots available.
+             srf       serve the request with the shortest expected transfer
+                       time first instead of the oldest one.
+             <opts>    aging <f>      seconds of expected transfer time
+                                      credited per second waited (default 1).
+                       linkrate <bw>  throughput in bytes per second assumed
+                                      until one is observed.
+                       preempt <f>    mark the longest running transfer for
+                                      preemption when it outlasts a queued one
+                                      by this factor (default 0, i.e. never).
              <path>    if preceeded by lib, the path of the policy library to 
                        be used; otherwise, the file that describes policy.
              <parms>   optional parms to be passed
@@ -282,10 +295,13 @@ int XrdBwm::xpol(XrdOucStream &Config, XrdSysError &Eroute)
    if (PolParm) {free(PolParm); PolParm = 0;}
    PolSlotsIn = PolSlotsOut = 0;
 
-// If the word maxslots then this is a simple policy
+   PolSRF = 0; PolAging = 1.0; PolRate = 0; PolPreempt = 0;
+
+// If the word maxslots then this is a simple policy; srf adds options
 //
-   if (!strcmp("maxslots", val))
-      {if (!(val = Config.GetWord()) || !val[0])
+   if (!strcmp("maxslots", val) || !strcmp("srf", val))
+      {PolSRF = !strcmp("srf", val);
+       if (!(val = Config.GetWord()) || !val[0])
           {Eroute.Emsg("Config", "policy in slots not specified"); return 1;}
        if (XrdOuca2x::a2i(Eroute,"policy in slots",val,&pl,0,32767)) return 1;
        PolSlotsIn = pl;
@@ -293,6 +309,24 @@ int XrdBwm::xpol(XrdOucStream &Config, XrdSysError &Eroute)
           {Eroute.Emsg("Config", "policy out slots not specified"); return 1;}
        if (XrdOuca2x::a2i(Eroute,"policy out slots",val,&pl,0,32767)) return 1;
        PolSlotsOut = pl;
+       if (!PolSRF) return 0;
+       while((val = Config.GetWord()))
+            {     if (!strcmp("aging", val))
+                     {if (xpolf(Config, Eroute, val, PolAging)) return 1;}
+             else if (!strcmp("preempt", val))
+                     {if (xpolf(Config, Eroute, val, PolPreempt)) return 1;}
+             else if (!strcmp("linkrate", val))
+                     {if (!(val = Config.GetWord()) || !val[0])
+                         {Eroute.Emsg("Config","policy linkrate not specified");
+                          return 1;
+                         }
+                      if (XrdOuca2x::a2sz(Eroute, "policy linkrate", val,
+                                          &PolRate, 0)) return 1;
+                     }
+             else {Eroute.Emsg("Config", "invalid srf policy option -", val);
+                   return 1;
+                  }
+            }
        return 0;
       }
 
@@ -318,6 +352,33 @@ int XrdBwm::xpol(XrdOucStream &Config, XrdSysError &Eroute)
    return 0;
 }
 
+/******************************************************************************/
+/*                                 x p o l f                                  */
+/******************************************************************************/
+
+/* Function: xpolf
+
+   Purpose:  To parse the non-negative factor following the srf policy option
+             named by opt into val.
+
+  Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdBwm::xpolf(XrdOucStream &Config, XrdSysError &Eroute,
+                  const char *opt, double &val)
+{
+   char *word, *eP;
+   double num;
+
+   if (!(word = Config.GetWord()) || !word[0])
+      {Eroute.Emsg("Config", "policy", opt, "value not specified"); return 1;}
+   num = strtod(word, &eP);
+   if (*eP || num < 0)
+      {Eroute.Emsg("Config", "invalid policy", opt, word); return 1;}
+   val = num;
+   return 0;
+}
+
 /******************************************************************************/
 /*                                x t r a c e                                 */
 /******************************************************************************/
@@ -33,6 +33,7 @@
 
 #include "XrdBwm/XrdBwmHandle.hh"
 #include "XrdBwm/XrdBwmLogger.hh"
+#include "XrdBwm/XrdBwmPolicy2.hh"
 #include "XrdBwm/XrdBwmTrace.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
 #include "XrdSys/XrdSysError.hh"
@@ -46,6 +47,7 @@
   
 XrdBwmLogger   *XrdBwmHandle::Logger = 0;
 XrdBwmPolicy   *XrdBwmHandle::Policy = 0;
+XrdBwmPolicy2  *XrdBwmHandle::Policy2 = 0;
 XrdBwmHandle   *XrdBwmHandle::Free = 0;
 unsigned int    XrdBwmHandle::numQueued = 0;
 
@@ -115,8 +117,15 @@ int XrdBwmHandle::Activate(XrdOucErrInfo &einfo)
    char *rBuff;
    int  rSize, rc;
 
-// Check the status of this request.
+// Check the status of this request. A dispatched request may ask for its
+// current visa if the policy maintains one.
 //
+   if (Status == Dispatched && Policy2)
+      {rBuff = einfo.getMsgBuff(rSize);
+       Policy2->Query(rHandle, rBuff, rSize);
+       einfo.setErrCode(strlen(rBuff));
+       return (*rBuff ? SFS_DATA : SFS_OK);
+      }
    if (Status != Idle)
       {if (Status == Scheduled)
           einfo.setErrInfo(kXR_inProgress, "Request already scheduled.");
@@ -167,7 +176,8 @@ int XrdBwmHandle::Activate(XrdOucErrInfo &einfo)
   
 XrdBwmHandle *XrdBwmHandle::Alloc(const char *theUsr,  const char *thePath,
                                   const char *LclNode, const char *RmtNode,
-                                  int Incoming)
+                                  int Incoming, long long theSize,
+                                  time_t theDeadline)
 {
    XrdBwmHandle *hP = Alloc();
 
@@ -180,10 +190,12 @@ XrdBwmHandle *XrdBwmHandle::Alloc(const char *theUsr,  const char *thePath,
        hP->Parms.RmtNode   = strdup(RmtNode);
        hP->Parms.Direction = (Incoming ? XrdBwmPolicy::Incoming
                                         : XrdBwmPolicy::Outgoing);
+       hP->Parms.Size      = theSize;
+       hP->Parms.Deadline  = theDeadline;
        hP->Status          = Idle;
        hP->qTime           = 0;
        hP->rTime           = 0;
-       hP->xSize           = 0;
+       hP->xSize           = theSize;
        hP->xTime           = 0;
       }
 
@@ -381,7 +393,8 @@ int XrdBwmHandle::setPolicy(XrdBwmPolicy *pP, XrdBwmLogger *lP)
 
 // Set the policy and then start a thread to do dispatching if we have none
 //
-   Policy = pP;
+   Policy  = pP;
+   Policy2 = dynamic_cast<XrdBwmPolicy2 *>(pP);
    if (startThread)
       if ((rc = XrdSysThread::Run(&tid, XrdBwmHanXeq, (void *)0,
                                   0, "Handle Dispatcher")))
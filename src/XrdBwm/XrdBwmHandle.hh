@@ -37,6 +37,7 @@
 #include "XrdSys/XrdSysPthread.hh"
 
 class XrdBwmLogger;
+class XrdBwmPolicy2;
   
 class XrdBwmHandle
 {
@@ -50,7 +51,8 @@ enum HandleState {Idle = 0, Scheduled, Dispatched};
 
 static XrdBwmHandle *Alloc(const char *theUsr,  const char *thePath,
                            const char *lclNode, const char *rmtNode,
-                           int Incoming);
+                           int Incoming, long long theSize=0,
+                           time_t theDeadline=0);
 
 static void         *Dispatch();
 
@@ -71,6 +73,7 @@ static XrdBwmHandle *Alloc(XrdBwmHandle *oldHandle=0);
 static XrdBwmHandle *refHandle(int refID, XrdBwmHandle *hP=0);
 
 static XrdBwmPolicy      *Policy;
+static XrdBwmPolicy2     *Policy2;    // Policy if it is the builtin srf one
 static XrdBwmLogger      *Logger;
 static XrdBwmHandle      *Free;       // List of free handles
 static unsigned int       numQueued;
@@ -30,6 +30,8 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <ctime>
+
 class XrdBwmPolicy
 {
 public:
@@ -121,6 +123,8 @@ const char  *Tident;     // In: -> Client's trace identity
       char  *LclNode;    // In: -> Local  node involved in the request
       char  *RmtNode;    // In: -> Remote node involved in the request
       Flow   Direction;  // In: -> Data flow relative to Lclpoint (see enum)
+long long    Size;       // In: -> Bytes to be transferred or 0 if unknown
+      time_t Deadline;   // In: -> Time by which transfer should end or 0
 };
 
 virtual int  Schedule(char *RespBuff, int RespSize, SchedParms &Parms) = 0;
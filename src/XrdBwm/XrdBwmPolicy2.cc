@@ -0,0 +1,420 @@
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d B w m P o l i c y 2 . c c                       */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <sys/time.h>
+
+#include "XrdBwm/XrdBwmPolicy2.hh"
+
+/******************************************************************************/
+/*                         L o c a l   D e f i n e s                          */
+/******************************************************************************/
+
+namespace
+{
+// Completions quicker than this say nothing about the link's throughput.
+//
+const double minSample = 0.01;
+
+// A single completion may raise the throughput estimate by at most this much.
+//
+const double maxGrowth = 4.0;
+
+// Weight of a new observation in the throughput and size averages.
+//
+const int    avgWeight = 8;
+}
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdBwmPolicy2::XrdBwmPolicy2(int inslots, int outslots, double aging,
+                             long long linkrate, double preempt)
+              : pSem(0), Aging(aging), Preempt(preempt), refID(1)
+{
+// Initialize values
+//
+   theDir[In ].maxSlots = theDir[In ].curSlots = inslots;
+   theDir[Out].maxSlots = theDir[Out].curSlots = outslots;
+   for (int i = 0; i < IOX; i++)
+       {theDir[i].linkRate = static_cast<double>(linkrate);
+        theDir[i].avgSize  = 0;
+        theDir[i].Learned  = false;
+       }
+}
+
+/******************************************************************************/
+/*                              D i s p a t c h                               */
+/******************************************************************************/
+
+int  XrdBwmPolicy2::Dispatch(char *RespBuff, int RespSize)
+{
+   refReq *rP, *inP, *outP;
+   double  now, inPrio, outPrio;
+   int     rID;
+
+// Obtain mutex and check if we have any queued requests that can run. When
+// both directions have one, the one with the lower priority key goes first.
+//
+   do {pMutex.Lock();
+       now  = Now();
+       inP  = Best(In,  now, inPrio);
+       outP = Best(Out, now, outPrio);
+       if (inP && outP) rP = (outPrio < inPrio ? outP : inP);
+          else rP = (inP ? inP : outP);
+       if (rP)
+          {refDir &dir = theDir[rP->Way];
+           dir.Queue.Yank(rP->refID);
+           dir.curSlots--;
+           rP->xTime = now;
+           dir.Active.Add(rP);
+           rID = rP->refID;
+           Visa(rP, now, RespBuff, RespSize);
+           pMutex.UnLock();
+           return rID;
+          }
+       pMutex.UnLock();
+       pSem.Wait();
+      } while(1);
+
+// Should never get here
+//
+   strcpy(RespBuff, "Fatal logic error!");
+   return 0;
+}
+
+/******************************************************************************/
+/*                                  D o n e                                   */
+/******************************************************************************/
+
+int  XrdBwmPolicy2::Done(int rHandle)
+{
+   refReq *rP = 0;
+   int i, rc = 0;
+
+// Make sure we have a positive value here
+//
+   if (rHandle < 0) rHandle = -rHandle;
+
+// Remove the element from whichever list it is in
+//
+   pMutex.Lock();
+   for (i = 0; i < IOX && !rP; i++)
+       {refDir &dir = theDir[i];
+        if ((rP = dir.Active.Yank(rHandle)))
+           {double elapsed = Now() - rP->xTime;
+
+        // A transfer that held its slot to the end tells us what the link
+        // delivered while shared with the others then active. Preempted
+        // transfers end early, so they tell us nothing.
+        //
+            if (rP->Size > 0 && elapsed >= minSample && !rP->Preempt)
+               {double rate = rP->Size / elapsed * (dir.Active.Num + 1);
+                if (!dir.Learned) {dir.linkRate = rate; dir.Learned = true;}
+                   else {if (rate > dir.linkRate * maxGrowth)
+                             rate = dir.linkRate * maxGrowth;
+                         dir.linkRate += (rate - dir.linkRate) / avgWeight;
+                        }
+               }
+            if (dir.curSlots++ == 0) pSem.Post();
+            rc = 1;
+           } else if ((rP = dir.Queue.Yank(rHandle))) rc = -1;
+       }
+   pMutex.UnLock();
+
+// delete the element and return
+//
+   if (rP) delete rP;
+   return rc;
+}
+
+/******************************************************************************/
+/*                                 Q u e r y                                  */
+/******************************************************************************/
+
+int  XrdBwmPolicy2::Query(int rHandle, char *RespBuff, int RespSize)
+{
+   XrdSysMutexHelper myHelper(pMutex);
+   refReq *rP;
+
+// Make sure we have a positive value here
+//
+   if (rHandle < 0) rHandle = -rHandle;
+
+// Only active requests have a visa
+//
+   if ((rP = theDir[In].Active.Find(rHandle))
+   ||  (rP = theDir[Out].Active.Find(rHandle)))
+      {Visa(rP, Now(), RespBuff, RespSize);
+       return 1;
+      }
+   *RespBuff = '\0';
+   return 0;
+}
+
+/******************************************************************************/
+/*                              S c h e d u l e                               */
+/******************************************************************************/
+
+int  XrdBwmPolicy2::Schedule(char *RespBuff, int RespSize, SchedParms &Parms)
+{
+   static const char *theWay[] = {"Incoming", "Outgoing"};
+   refReq *rP;
+   double  now;
+   int myID;
+
+// Get the global lock and generate a reference ID
+//
+   *RespBuff = '\0';
+   pMutex.Lock();
+   myID = ++refID;
+   now  = Now();
+   rP = new refReq(myID, Parms, now);
+   refDir &dir = theDir[rP->Way];
+
+// Track the typical request size; it stands in for requests of unknown size
+//
+   if (rP->Size > 0)
+      {if (!dir.avgSize) dir.avgSize = rP->Size;
+          else dir.avgSize += (rP->Size - dir.avgSize) / avgWeight;
+      }
+
+// Check if we can immediately schedule this request or must defer it
+//
+        if (dir.curSlots > 0)
+           {dir.curSlots--;
+            rP->xTime = now;
+            dir.Active.Add(rP);
+            Visa(rP, now, RespBuff, RespSize);
+           }
+   else if (dir.maxSlots)
+           {dir.Queue.Add(rP); myID = -myID;
+            Hint(rP, now);
+           }
+   else {strcpy(RespBuff, theWay[rP->Way]);
+         strcat(RespBuff, " requests are not allowed.");
+         delete rP;
+         myID = 0;
+        }
+
+// All done
+//
+   pMutex.UnLock();
+   return myID;
+}
+
+/******************************************************************************/
+/*                                S t a t u s                                 */
+/******************************************************************************/
+
+void XrdBwmPolicy2::Status(int &numqIn, int &numqOut, int &numXeq)
+{
+
+// Get the global lock and return the values
+//
+   pMutex.Lock();
+   numqIn  = theDir[In ].Queue.Num;
+   numqOut = theDir[Out].Queue.Num;
+   numXeq  = theDir[In].Active.Num + theDir[Out].Active.Num;
+   pMutex.UnLock();
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                  B e s t                                   */
+/******************************************************************************/
+
+// The mutex must be held upon entry.
+
+XrdBwmPolicy2::refReq *XrdBwmPolicy2::Best(Flow way, double now, double &prio)
+{
+   refReq *rP, *bP = 0;
+   double  key;
+
+// Nothing can be dispatched without a free slot
+//
+   if (theDir[way].curSlots <= 0) return 0;
+
+// Find the queued request with the lowest key; ties go to the earlier one
+//
+   for (rP = theDir[way].Queue.First; rP; rP = rP->Next)
+       {key = Key(rP, now);
+        if (!bP || key < prio || (key == prio && rP->qTime < bP->qTime))
+           {bP = rP; prio = key;}
+       }
+   return bP;
+}
+
+/******************************************************************************/
+/*                                  H i n t                                   */
+/******************************************************************************/
+
+// The mutex must be held upon entry. A queued request marks at most one
+// active transfer in its direction for preemption and only when no other
+// mark is outstanding, so a burst of small requests does not preempt them all.
+
+void XrdBwmPolicy2::Hint(refReq *qP, double now)
+{
+   refReq *rP, *vP = 0;
+   double  rem, vRem = -1, minRem = -1, svc;
+
+// Check if preemption is wanted at all
+//
+   if (Preempt <= 0) return;
+
+// Find the active transfer with the longest time to go and the time the next
+// slot is expected to free up.
+//
+   for (rP = theDir[qP->Way].Active.First; rP; rP = rP->Next)
+       {if (rP->Preempt) return;
+        if ((rem = Remaining(rP, now)) < 0) continue;
+        if (rem > vRem) {vP = rP; vRem = rem;}
+        if (minRem < 0 || rem < minRem) minRem = rem;
+       }
+   if (!vP) return;
+
+// Mark the victim if it would hold up the queued request for far longer than
+// the request itself takes or if waiting would make the request miss its
+// deadline.
+//
+   svc = Service(qP);
+   if ((svc > 0 && vRem > svc * Preempt)
+   ||  (qP->Deadline > 0 && now + minRem + svc > qP->Deadline))
+      vP->Preempt = true;
+}
+
+/******************************************************************************/
+/*                                   K e y                                    */
+/******************************************************************************/
+
+// The mutex must be held upon entry. Lower keys are dispatched first.
+
+double XrdBwmPolicy2::Key(refReq *rP, double now)
+{
+   double svc = Service(rP), key, slack;
+
+// The expected transfer time less the credit for waiting. A deadline bounds
+// the key by the slack left before the request must start.
+//
+   key = svc - Aging * (now - rP->qTime);
+   if (rP->Deadline > 0)
+      {slack = rP->Deadline - now - svc;
+       if (slack < key) key = slack;
+      }
+   return key;
+}
+
+/******************************************************************************/
+/*                                   N o w                                    */
+/******************************************************************************/
+
+double XrdBwmPolicy2::Now()
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, 0);
+   return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/******************************************************************************/
+/*                             R e m a i n i n g                              */
+/******************************************************************************/
+
+// The mutex must be held upon entry. Returns the expected seconds until an
+// active transfer completes or -1 if that cannot be predicted.
+
+double XrdBwmPolicy2::Remaining(refReq *rP, double now)
+{
+   refDir &dir = theDir[rP->Way];
+   double rate, rem;
+
+   if (rP->Size <= 0 || dir.linkRate <= 0 || !dir.Active.Num) return -1;
+   rate = dir.linkRate / dir.Active.Num;
+   rem  = rP->Size / rate - (now - rP->xTime);
+   return (rem > 0 ? rem : 0);
+}
+
+/******************************************************************************/
+/*                               S e r v i c e                                */
+/******************************************************************************/
+
+// The mutex must be held upon entry. Returns the expected seconds a queued
+// request takes once it has a slot, assuming all slots are in use.
+
+double XrdBwmPolicy2::Service(refReq *rP)
+{
+   refDir &dir = theDir[rP->Way];
+   long long size = (rP->Size > 0 ? rP->Size : dir.avgSize);
+
+   if (size <= 0 || dir.linkRate <= 0 || dir.maxSlots <= 0) return 0;
+   return size / (dir.linkRate / dir.maxSlots);
+}
+
+/******************************************************************************/
+/*                                  V i s a                                   */
+/******************************************************************************/
+
+// The mutex must be held upon entry.
+
+void XrdBwmPolicy2::Visa(refReq *rP, double now, char *RespBuff, int RespSize)
+{
+   refDir &dir = theDir[rP->Way];
+   double  rem;
+   int     n = 0;
+
+// Report the predicted completion time and throughput when we know them
+//
+   *RespBuff = '\0';
+   if ((rem = Remaining(rP, now)) >= 0)
+      n = snprintf(RespBuff, RespSize, "bwm.eta=%lld&bwm.rate=%lld",
+                   static_cast<long long>(now + rem),
+                   static_cast<long long>(dir.linkRate / dir.Active.Num));
+
+// Add the preemption hint
+//
+   if (rP->Preempt && n >= 0 && n < RespSize)
+      snprintf(RespBuff+n, RespSize-n, "%sbwm.preempt=1", (n ? "&" : ""));
+}
+
+/******************************************************************************/
+/*                          r e f L s t : : Y a n k                           */
+/******************************************************************************/
+
+XrdBwmPolicy2::refReq *XrdBwmPolicy2::refLst::Yank(int rID)
+{
+   refReq *pP = 0, *rP = First;
+
+   while(rP && rID != rP->refID) {pP = rP; rP = rP->Next;}
+   if (rP)
+      {if (pP) pP->Next = rP->Next;
+          else    First = rP->Next;
+       Num--;
+      }
+   return rP;
+}
@@ -0,0 +1,149 @@
+#ifndef __BWM_POLICY2_HH__
+#define __BWM_POLICY2_HH__
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d B w m P o l i c y 2 . h h                       */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include "XrdBwm/XrdBwmPolicy.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+/* XrdBwmPolicy2 has the same per-direction slot limits as XrdBwmPolicy1 but
+   does not serve queued requests in arrival order. Instead, the request with
+   the shortest expected transfer time goes first. The expected time is the
+   request's size divided by the observed per-transfer throughput of its
+   direction. To keep large transfers from starving, each second a request
+   waits is credited against its expected time by the aging factor. A request
+   with a deadline is moved forward as its slack (the time left to the deadline
+   less its expected time) runs out.
+
+   Throughput is learned from the requests that complete: the size of the
+   request divided by the time it held its slot, scaled by the number of
+   concurrently active requests, gives an estimate of the link's throughput.
+
+   The visa sent to the client holds the predicted completion time of the
+   transfer (bwm.eta, a Unix time) and the throughput it is expected to get
+   (bwm.rate, bytes per second). When preemption is enabled and a queued
+   request is much shorter than, or would miss its deadline behind, the
+   longest running transfer, that transfer is marked for preemption. The
+   mark is returned to the transfer agent (bwm.preempt=1) when it queries its
+   visa again; the agent may then checkpoint the transfer, release its slot by
+   closing the handle, and request a new one for the remainder.
+*/
+
+class XrdBwmPolicy2 : public XrdBwmPolicy
+{
+public:
+
+int  Dispatch(char *RespBuff, int RespSize);
+
+int  Done(int rHandle);
+
+// Return the current visa of an active request in RespBuff. Returns 1 if the
+// request is active and 0 otherwise.
+//
+int  Query(int rHandle, char *RespBuff, int RespSize);
+
+int  Schedule(char *RespBuff, int RespSize, SchedParms &Parms);
+
+void Status(int &numqIn, int &numqOut, int &numXeq);
+
+// aging    - seconds of expected transfer time credited per second waited.
+// linkrate - throughput, in bytes per second, assumed until one is observed.
+// preempt  - the factor by which the longest active transfer must outlast a
+//            queued one for it to be marked for preemption; 0 disables it.
+//
+     XrdBwmPolicy2(int inslots, int outslots, double aging,
+                   long long linkrate, double preempt);
+    ~XrdBwmPolicy2() {}
+
+enum Flow {In = 0, Out = 1, IOX = 2};
+
+struct refReq
+      {refReq   *Next;
+       int       refID;
+       Flow      Way;
+       bool      Preempt;
+       long long Size;
+       double    Deadline;
+       double    qTime;
+       double    xTime;
+
+       refReq(int id, XrdBwmPolicy::SchedParms &Parms, double now)
+             : Next(0), refID(id),
+               Way(Parms.Direction == XrdBwmPolicy::Incoming ? In : Out),
+               Preempt(false), Size(Parms.Size),
+               Deadline(static_cast<double>(Parms.Deadline)),
+               qTime(now), xTime(0) {}
+      ~refReq() {}
+      };
+
+protected:
+
+// Returns the current time in seconds; tests substitute their own clock.
+//
+virtual double Now();
+
+private:
+
+struct refLst
+      {refReq *First;
+       int     Num;
+
+       void    Add(refReq *rP) {rP->Next = First; First = rP; Num++;}
+
+       refReq *Find(int rID)
+                   {refReq *rP = First;
+                    while(rP && rID != rP->refID) rP = rP->Next;
+                    return rP;
+                   }
+
+       refReq *Yank(int rID);
+
+               refLst() : First(0), Num(0) {}
+      };
+
+struct refDir
+      {refLst    Queue;
+       refLst    Active;
+       int       curSlots;
+       int       maxSlots;
+       double    linkRate;
+       long long avgSize;
+       bool      Learned;
+      }          theDir[IOX];
+
+refReq *Best(Flow way, double now, double &prio);
+void    Hint(refReq *rP, double now);
+double  Key(refReq *rP, double now);
+double  Remaining(refReq *rP, double now);
+double  Service(refReq *rP);
+void    Visa(refReq *rP, double now, char *RespBuff, int RespSize);
+
+XrdSysSemaphore pSem;
+XrdSysMutex     pMutex;
+double          Aging;
+double          Preempt;
+int             refID;
+};
+#endif
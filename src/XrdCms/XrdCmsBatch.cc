@@ -0,0 +1,257 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d C m s B a t c h . c c                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <cerrno>
+#include <cstdio>
+
+#include "XrdCms/XrdCmsBatch.hh"
+#include "XrdSys/XrdSysTimer.hh"
+
+using namespace XrdCms;
+
+/******************************************************************************/
+/*                        G l o b a l   O b j e c t s                         */
+/******************************************************************************/
+
+       XrdCmsBatch   XrdCms::Batch;
+
+/******************************************************************************/
+/*                    E x t e r n a l   F u n c t i o n s                     */
+/******************************************************************************/
+
+void *XrdCmsBatch_StartFlusher(void *parg)
+{
+   return static_cast<XrdCmsBatch *>(parg)->Flusher();
+}
+
+/******************************************************************************/
+/*                                 F l u s h                                  */
+/******************************************************************************/
+
+void XrdCmsBatch::Flush(XrdCmsNode *nP)
+{
+   PendQ pq;
+   size_t i;
+
+// Take the node's batch, if any. Batches already taken off the queue may not
+// have been sent yet and one of them may be for this node. So, unless none
+// are outstanding, we wait for the send lock which orders us behind them.
+//
+   myMutex.Lock();
+   for (i = 0; i < pendQ.size(); i++) if (pendQ[i].nodeP == nP) break;
+   if (i < pendQ.size()) Take(i, pq);
+      else if (!numBusy) {myMutex.UnLock(); return;}
+   sendMutex.Lock();
+   myMutex.UnLock();
+   if (pq.nodeP) Send(pq);
+   sendMutex.UnLock();
+}
+
+/******************************************************************************/
+/*                               F l u s h e r                                */
+/******************************************************************************/
+
+void *XrdCmsBatch::Flusher()
+{
+   std::vector<PendQ> sendQ;
+
+// Wait for the first message of a batch to arrive, then let the window run
+// and send whatever accumulated. Messages that arrive after we take the queue
+// start a new batch.
+//
+   do {isReady.Wait();
+       XrdSysTimer::Wait(winMS);
+       myMutex.Lock();
+       sendQ.swap(pendQ);
+       numBusy += static_cast<int>(sendQ.size());
+       sendMutex.Lock();
+       myMutex.UnLock();
+       for (auto &pq : sendQ) Send(pq);
+       sendMutex.UnLock();
+       sendQ.clear();
+      } while(1);
+
+   return (void *)0;
+}
+
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+
+int XrdCmsBatch::Init(int wms, int mmax)
+{
+   pthread_t tid;
+   int rc;
+
+// Start the flusher thread. Batching only becomes active if we succeed.
+//
+   if (wms <= 0) return 0;
+   winMS   = wms;
+   maxMsgs = (mmax > 0 ? mmax : 64);
+   if ((rc = XrdSysThread::Run(&tid, XrdCmsBatch_StartFlusher, (void *)this,
+                               0, "Message batcher")))
+      winMS = 0;
+   return rc;
+}
+
+/******************************************************************************/
+/*                                 Q u e u e                                  */
+/******************************************************************************/
+
+bool XrdCmsBatch::Queue(XrdCmsNode *nP, const struct iovec *iov, int iovcnt,
+                        int iotot)
+{
+   PendQ fullQ, lastQ;
+   size_t i;
+
+// Make sure batching is in effect and compute the message size if need be
+//
+   if (!winMS) return false;
+   if (!iotot) for (int k = 0; k < iovcnt; k++) iotot += iov[k].iov_len;
+   if (iotot > maxBytes) return false;
+
+// Find the pending queue for this node, if any. Should the message not fit
+// into it, the batch is sent first and the message starts a new one.
+//
+   myMutex.Lock();
+   for (i = 0; i < pendQ.size(); i++) if (pendQ[i].nodeP == nP) break;
+   if (i < pendQ.size() && (int)pendQ[i].Buff.size() + iotot > maxBytes)
+      {Take(i, fullQ);
+       i = pendQ.size();
+      }
+
+// Start a new queue if need be. A new queue keeps a reference to the node
+// until the batch is sent. If this is the first queue then wake up the
+// flusher so that the window starts.
+//
+   if (i >= pendQ.size())
+      {Hold(nP);
+       pendQ.emplace_back();
+       pendQ[i].nodeP   = nP;
+       pendQ[i].numMsgs = 0;
+       pendQ[i].Born    = std::chrono::steady_clock::now();
+       pendQ[i].Buff.reserve(4096);
+       if (pendQ.size() == 1) isReady.Post();
+      }
+
+// Add the message to the batch. If the batch is now full, take it off the
+// queue as well.
+//
+   PendQ &pq = pendQ[i];
+   for (int k = 0; k < iovcnt; k++)
+       pq.Buff.insert(pq.Buff.end(), (const char *)iov[k].iov_base,
+                      (const char *)iov[k].iov_base + iov[k].iov_len);
+   pq.numMsgs++;
+   if (pq.numMsgs >= maxMsgs || (int)pq.Buff.size() >= maxBytes)
+      Take(i, lastQ);
+
+// If nothing needs to be sent we are done
+//
+   if (!fullQ.nodeP && !lastQ.nodeP)
+      {myMutex.UnLock();
+       return true;
+      }
+
+// Batches must reach a node in the order they were taken off the queue. So,
+// the send lock is obtained before the queue lock is released.
+//
+   sendMutex.Lock();
+   myMutex.UnLock();
+   if (fullQ.nodeP) {numFull++; Send(fullQ);}
+   if (lastQ.nodeP) {numFull++; Send(lastQ);}
+   sendMutex.UnLock();
+   return true;
+}
+
+/******************************************************************************/
+/*                                 S t a t s                                  */
+/******************************************************************************/
+
+int XrdCmsBatch::Stats(char *bfr, int bln)
+{
+   static const char statfmt[] = "<bat><n>%lld</n><m>%lld</m><f>%lld</f>"
+          "<mx>%d</mx><dly>%lld</dly><dmx>%lld</dmx></bat>";
+   long long lclSends, lclMsgs;
+   int mlen;
+
+// Check if actual length wanted
+//
+   if (!bfr) return (winMS ? sizeof(statfmt) + 16*5 + 10 : 0);
+   if (!winMS) return 0;
+
+// Format the statistics. The delay is the average time, in microseconds, a
+// message waited to be sent; this is the latency that batching adds.
+//
+   lclSends = numSends; lclMsgs = numMsgs;
+   mlen = snprintf(bfr, bln, statfmt, lclSends, lclMsgs, numFull.load(),
+                   maxBatch.load(), (lclMsgs ? dlyTot/lclMsgs : 0LL),
+                   dlyMax.load());
+   return (mlen < bln ? mlen : 0);
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                  T a k e                                   */
+/******************************************************************************/
+
+// The queue lock must be held upon entry.
+
+void XrdCmsBatch::Take(size_t i, PendQ &pq)
+{
+   pq = std::move(pendQ[i]);
+   if (i != pendQ.size()-1) pendQ[i] = std::move(pendQ.back());
+   pendQ.pop_back();
+   numBusy++;
+}
+
+/******************************************************************************/
+/*                                  S e n d                                   */
+/******************************************************************************/
+
+// The send lock must be held upon entry.
+
+void XrdCmsBatch::Send(PendQ &pq)
+{
+   long long dly;
+
+// Send the batch as a single write and drop the node reference
+//
+   Write(pq.nodeP, pq.Buff.data(), (int)pq.Buff.size(), pq.numMsgs);
+   Drop(pq.nodeP);
+   numBusy--;
+
+// Update statistics. The delay of the first message, which waited the longest,
+// is charged to every message in the batch so the average is an upper bound.
+//
+   dly = std::chrono::duration_cast<std::chrono::microseconds>
+         (std::chrono::steady_clock::now() - pq.Born).count();
+   numSends++;
+   numMsgs += pq.numMsgs;
+   dlyTot  += dly * pq.numMsgs;
+   if (dly > dlyMax) dlyMax = dly;
+   if (pq.numMsgs > maxBatch) maxBatch = pq.numMsgs;
+}
@@ -0,0 +1,128 @@
+#ifndef __CMS_BATCH__H
+#define __CMS_BATCH__H
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d C m s B a t c h . h h                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <chrono>
+#include <vector>
+#include <sys/uio.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+#include "XrdSys/XrdSysRAtomic.hh"
+
+class XrdCmsNode;
+
+/******************************************************************************/
+/*                           X r d C m s B a t c h                            */
+/******************************************************************************/
+
+// The XrdCmsBatch object coalesces small messages that are headed to the same
+// node within a short window and sends them with a single write. Managers use
+// it for state queries and servers for the corresponding have responses as
+// well as for everything sent to managers via XrdCmsManager::Inform(). The
+// messages themselves are unchanged so the receiver need not know about it,
+// though it reads them in bulk (see XrdCmsProtocol::Dispatch()). Batching is
+// only in effect when enabled via the batch directive. A message sent directly
+// to a node must not overtake those queued for it, so XrdCmsNode::Send()
+// flushes the node's batch first.
+//
+class XrdCmsBatch
+{
+public:
+
+// Batching is in effect only after a successful Init().
+//
+inline bool  Active() {return winMS != 0;}
+
+// Init() starts the flusher thread. It returns 0 on success and errno o/w.
+//
+int          Init(int wms, int mmax);
+
+// Queue() adds a message for the indicated node. The caller must have the node
+// referenced or locked. False is returned if batching is not active or the
+// message is too large, in which case the caller must send it directly.
+//
+bool         Queue(XrdCmsNode *nP, const struct iovec *iov, int iovcnt,
+                   int iotot=0);
+
+// Flush() sends any messages pending for the node and waits for batches that
+// are being sent to complete. Afterwards a message may be sent directly.
+//
+void         Flush(XrdCmsNode *nP);
+
+// Flusher() sends pending messages once the window closes (internal thread).
+//
+void        *Flusher();
+
+// Stats() formats batching statistics into the supplied buffer. When bfr is
+// nil the maximum length is returned.
+//
+int          Stats(char *bfr, int bln);
+
+             XrdCmsBatch() : isReady(0), winMS(0), maxMsgs(0) {}
+            ~XrdCmsBatch() {}
+
+static const int maxBytes = 65536; // Maximum bytes in a batch
+
+private:
+
+struct PendQ
+      {XrdCmsNode                            *nodeP = 0;
+       std::vector<char>                      Buff;
+       int                                    numMsgs;
+       std::chrono::steady_clock::time_point  Born;
+      };
+
+void             Send(PendQ &pq);
+void             Take(size_t i, PendQ &pq);
+
+// The following deal with the node itself. They are in XrdCmsBatchSend.cc so
+// that the batcher can be tested without a cluster.
+//
+static void      Hold(XrdCmsNode *nP);
+static void      Drop(XrdCmsNode *nP);
+static void      Write(XrdCmsNode *nP, const char *buff, int blen, int mnum);
+
+XrdSysMutex      myMutex;
+XrdSysMutex      sendMutex;    // Serializes sends so batches stay in order
+XrdSysSemaphore  isReady;
+std::vector<PendQ> pendQ;
+int              winMS;
+int              maxMsgs;
+
+RAtomic_int      numBusy{0};   // Batches taken off the queue but not sent
+RAtomic_llong    numSends{0};  // Number of batched writes
+RAtomic_llong    numMsgs{0};   // Number of messages in those writes
+RAtomic_llong    numFull{0};   // Writes forced by a full batch
+RAtomic_llong    dlyTot{0};    // Total usec messages waited for a write
+RAtomic_llong    dlyMax{0};    // Longest  usec a message waited
+RAtomic_int      maxBatch{0};  // Largest number of messages in one write
+};
+
+namespace XrdCms
+{
+extern    XrdCmsBatch Batch;
+}
+#endif
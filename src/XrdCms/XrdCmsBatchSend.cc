@@ -0,0 +1,61 @@
+/******************************************************************************/
+/*                                                                            */
+/*                    X r d C m s B a t c h S e n d . c c                     */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include "XrdCms/XrdCmsBatch.hh"
+#include "XrdCms/XrdCmsNode.hh"
+#include "XrdCms/XrdCmsTrace.hh"
+
+using namespace XrdCms;
+
+// Note: These are the parts of the batcher that deal with the node itself.
+//       They are kept apart so that the rest can be tested on its own.
+
+/******************************************************************************/
+/*                                  H o l d                                   */
+/******************************************************************************/
+
+// The caller must have the node referenced or locked.
+
+void XrdCmsBatch::Hold(XrdCmsNode *nP) {nP->Ref();}
+
+/******************************************************************************/
+/*                                  D r o p                                   */
+/******************************************************************************/
+
+void XrdCmsBatch::Drop(XrdCmsNode *nP) {nP->unRef();}
+
+/******************************************************************************/
+/*                                 W r i t e                                  */
+/******************************************************************************/
+
+// The batch is sent via Post() as Send() would try to flush it again.
+
+void XrdCmsBatch::Write(XrdCmsNode *nP, const char *buff, int blen, int mnum)
+{
+   EPNAME("Batch");
+
+   if (nP->Post(buff, blen) < 0)
+      {DEBUG(nP->Ident <<" is unreachable; " <<mnum <<" message(s) lost");}
+}
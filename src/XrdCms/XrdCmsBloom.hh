@@ -0,0 +1,148 @@
+#ifndef XRDCMSBLOOM__H
+#define XRDCMSBLOOM__H
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d C m s B l o o m . h h                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+// The XrdCmsBloom object is a Bloom filter over file names. Servers build one
+// for their namespace and send it to their managers who then need not ask a
+// node about a file that the node's filter says it does not have. The filter
+// may give false positives but never false negatives. The bit array travels
+// as is, so the hash must be the same everywhere; it is a 64-bit FNV-1a and
+// the probe positions are derived from it by double hashing. Bits are atomic
+// so that names may be added while others test the filter.
+//
+class XrdCmsBloom
+{
+public:
+
+// Return the hash of a file name. The trailing null byte is not included.
+//
+static unsigned long long Hash(const char *name)
+                  {unsigned long long h = 0xcbf29ce484222325ULL;
+                   while(*name)
+                        {h ^= static_cast<unsigned char>(*name++);
+                         h *= 0x100000001b3ULL;
+                        }
+                   return h;
+                  }
+
+// Add a name, or its hash, to the filter.
+//
+inline void       Add(const char *name) {Add(Hash(name));}
+
+       void       Add(unsigned long long h)
+                     {unsigned long long b = h, s = (h >> 32) | 1;
+                      for (int i = 0; i < numHash; i++, b += s)
+                          {unsigned long long n = b % numBits;
+                           Bits[n >> 3].fetch_or(static_cast<unsigned char>
+                                  (1 << (n & 7)), std::memory_order_relaxed);
+                          }
+                     }
+
+// Test whether a name, or its hash, may be in the filter. False means that it
+// is certainly not in it.
+//
+inline bool       Test(const char *name) const {return Test(Hash(name));}
+
+       bool       Test(unsigned long long h) const
+                     {unsigned long long b = h, s = (h >> 32) | 1;
+                      for (int i = 0; i < numHash; i++, b += s)
+                          {unsigned long long n = b % numBits;
+                           if (!(Bits[n >> 3].load(std::memory_order_relaxed)
+                               & (1 << (n & 7)))) return false;
+                          }
+                      return true;
+                     }
+
+// Copy a range of the bit array out of or into the filter. The return value
+// is the number of bytes actually copied.
+//
+       int        Get(int offs, char *buff, int blen) const
+                     {if (offs < 0 || offs >= numBytes) return 0;
+                      if (blen > numBytes - offs) blen = numBytes - offs;
+                      for (int i = 0; i < blen; i++)
+                          buff[i] = static_cast<char>
+                                  (Bits[offs+i].load(std::memory_order_relaxed));
+                      return blen;
+                     }
+
+       int        Put(int offs, const char *buff, int blen)
+                     {if (offs < 0 || offs >= numBytes) return 0;
+                      if (blen > numBytes - offs) blen = numBytes - offs;
+                      for (int i = 0; i < blen; i++)
+                          Bits[offs+i].store(static_cast<unsigned char>(buff[i]),
+                                             std::memory_order_relaxed);
+                      return blen;
+                     }
+
+inline int        Bytes()  const {return numBytes;}
+inline int        Hashes() const {return numHash;}
+
+// Return the number of bytes a filter should have to hold the indicated
+// number of names at the indicated number of bits per name and the number of
+// hash functions that minimize false positives for it (about 0.7 per bit).
+//
+static int        Size(long long names, int bitsPer)
+                      {long long n = (names < 1024 ? 1024 : names) * bitsPer / 8;
+                       return static_cast<int>(n > maxBytes ? maxBytes : n);
+                      }
+
+static int        HashCnt(int bitsPer)
+                         {int k = (bitsPer * 7 + 5) / 10;
+                          return (k < 1 ? 1 : (k > 16 ? 16 : k));
+                         }
+
+static constexpr int maxBytes = 64*1024*1024;
+
+// The expiration time is set by whoever uses the filter; zero means never.
+//
+time_t            Expires;
+
+                  XrdCmsBloom(int bytes, int hashes)
+                             : Expires(0),
+                               numBytes(bytes < 8 ? 8 : bytes),
+                               numHash(hashes < 1 ? 1 : hashes),
+                               numBits(static_cast<unsigned long long>
+                                       (numBytes) * 8),
+                               Bits(new std::atomic<unsigned char>[numBytes])
+                             {for (int i = 0; i < numBytes; i++) Bits[i] = 0;}
+
+                 ~XrdCmsBloom() {}
+
+private:
+                  XrdCmsBloom(const XrdCmsBloom &) = delete;
+XrdCmsBloom      &operator=(const XrdCmsBloom &) = delete;
+
+int                                         numBytes;
+int                                         numHash;
+unsigned long long                          numBits;
+std::unique_ptr<std::atomic<unsigned char>[]> Bits;
+};
+#endif
@@ -61,15 +61,16 @@ class XrdCmsCacheJob : XrdJob
 {
 public:
 
-void   DoIt() {Cache.Recycle(myList); delete this;}
+void   DoIt() {Cache.Recycle(myList, myShard); delete this;}
 
-       XrdCmsCacheJob(XrdCmsKeyItem *List)
-                     : XrdJob("cache scrubber"), myList(List) {}
+       XrdCmsCacheJob(XrdCmsKeyItem *List, int sNum)
+                     : XrdJob("cache scrubber"), myList(List), myShard(sNum) {}
       ~XrdCmsCacheJob() {}
 
 private:
 
 XrdCmsKeyItem *myList;
+int            myShard;
 };
 
 /******************************************************************************/
@@ -116,18 +117,19 @@ void *XrdCmsStartTickTock(void *carg)
   
 int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
 {
+   CacheShard &S = Shard4(Sel.Path);
    XrdCmsKeyItem *iP;
    SMask_t xmask;
    int isrw = (Sel.Opts & XrdCmsSelect::Write), isnew = 0;
 
 // Serialize processing
 //
-   myMutex.Lock();
+   S.Mutex.Lock();
 
 // Check for fast path processing
 //
    if (  !(iP = Sel.Path.TODRef) || !(iP->Key.Equiv(Sel.Path)))
-      if ((iP = Sel.Path.TODRef = CTable.Find(Sel.Path)))
+      if ((iP = Sel.Path.TODRef = S.Table.Find(Sel.Path)))
          Sel.Path.Ref = iP->Key.Ref;
 
 // Add/Modify the entry
@@ -138,7 +140,7 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
            iP->Loc.lifeline = nilTMO + iP->Loc.deadline;
            iP->Loc.hfvec = 0; iP->Loc.pfvec = 0; iP->Loc.qfvec = 0;
            iP->Loc.TOD_B = BClock;
-           iP->Key.TOD = Tock;
+           iP->Key.TOD = S.Tock;
           } else {
            xmask = iP->Loc.pfvec;
            if (Sel.Opts & XrdCmsSelect::Pending) iP->Loc.pfvec |= mask;
@@ -155,8 +157,8 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
                      }
           }
       } else if (!(Sel.Opts & XrdCmsSelect::Advisory))
-                {Sel.Path.TOD = Tock;
-                 if ((iP = CTable.Add(Sel.Path)))
+                {Sel.Path.TOD = S.Tock;
+                 if ((iP = S.Table.Add(Sel.Path)))
                     {iP->Loc.pfvec    = (Sel.Opts&XrdCmsSelect::Pending?mask:0);
                      iP->Loc.hfvec    = mask;
                      iP->Loc.TOD_B    = BClock;
@@ -170,7 +172,7 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
 
 // All done
 //
-   myMutex.UnLock();
+   S.Mutex.UnLock();
    return isnew;
 }
   
@@ -190,29 +192,31 @@ int XrdCmsCache::AddFile(XrdCmsSelect &Sel, SMask_t mask)
   
 int XrdCmsCache::DelFile(XrdCmsSelect &Sel, SMask_t mask)
 {
+   CacheShard &S = Shard4(Sel.Path);
    XrdCmsKeyItem *iP;
    int gone4good;
 
 // Lock the hash table
 //
-   myMutex.Lock();
+   S.Mutex.Lock();
 
 // Look up the entry and remove server
 //
-   if ((iP = CTable.Find(Sel.Path)))
+   if ((iP = S.Table.Find(Sel.Path)))
       {iP->Loc.hfvec &= ~mask;
        iP->Loc.pfvec &= ~mask;
        if ((gone4good = (iP->Loc.hfvec == 0)))
           {if (nilTMO) iP->Loc.lifeline = nilTMO + time(0);
            if (!(Sel.Opts & XrdCmsSelect::Advisory)
-           &&  XrdCmsKeyItem::Unload(iP) && !CTable.Recycle(iP))
+           &&  XrdCmsKeyItem::Unload(S.Table.Items, iP)
+           &&  !S.Table.Recycle(iP))
               Say.Emsg("DelFile", "Delete failed for", iP->Key.Val);
           }
       } else gone4good = 0;
 
 // All done
 //
-   myMutex.UnLock();
+   S.Mutex.UnLock();
    return gone4good;
 }
   
@@ -231,17 +235,18 @@ int XrdCmsCache::DelFile(XrdCmsSelect &Sel, SMask_t mask)
   
 int  XrdCmsCache::GetFile(XrdCmsSelect &Sel, SMask_t mask)
 {
+   CacheShard &S = Shard4(Sel.Path);
    XrdCmsKeyItem *iP;
-   SMask_t bVec;
+   SMask_t bVec, vVec = okVec;
    int retc;
 
 // Lock the hash table
 //
-   myMutex.Lock();
+   S.Mutex.Lock();
 
 // Look up the entry and return location information
 //
-   if ((iP = CTable.Find(Sel.Path)))
+   if ((iP = S.Table.Find(Sel.Path)))
       {if ((bVec = (iP->Loc.TOD_B < BClock 
                  ? getBVec(iP->Key.TOD, iP->Loc.TOD_B) & mask : 0)))
           {iP->Loc.hfvec &= ~bVec; 
@@ -258,15 +263,15 @@ int  XrdCmsCache::GetFile(XrdCmsSelect &Sel, SMask_t mask)
        if (nilTMO && retc == 1 && iP->Loc.hfvec == 0
        &&  iP->Loc.lifeline <= time(0)) retc = 0;
 
-       Sel.Vec.hf      = okVec & iP->Loc.hfvec;
-       Sel.Vec.pf      = okVec & iP->Loc.pfvec;
-       Sel.Vec.bf      = okVec & (bVec | iP->Loc.qfvec); iP->Loc.qfvec = 0;
+       Sel.Vec.hf      = vVec & iP->Loc.hfvec;
+       Sel.Vec.pf      = vVec & iP->Loc.pfvec;
+       Sel.Vec.bf      = vVec & (bVec | iP->Loc.qfvec); iP->Loc.qfvec = 0;
        Sel.Path.Ref    = iP->Key.Ref;
       } else retc = 0;
 
 // All done
 //
-   myMutex.UnLock();
+   S.Mutex.UnLock();
    Sel.Path.TODRef = iP;
    return retc;
 }
@@ -278,11 +283,12 @@ int  XrdCmsCache::GetFile(XrdCmsSelect &Sel, SMask_t mask)
 int XrdCmsCache::UnkFile(XrdCmsSelect &Sel, SMask_t mask)
 {
    EPNAME("UnkFile");
+   CacheShard &S = Shard4(Sel.Path);
    XrdCmsKeyItem *iP;
 
 // Make sure we have the proper information. If so, lock the hash table
 //
-   myMutex.Lock();
+   S.Mutex.Lock();
 
 // Look up the entry and if valid update the unqueried vector. Note that
 // this method may only be called after GetFile() or AddFile() for a new entry
@@ -294,7 +300,7 @@ int XrdCmsCache::UnkFile(XrdCmsSelect &Sel, SMask_t mask)
 
 // Return result
 //
-   myMutex.UnLock();
+   S.Mutex.UnLock();
    DEBUG("rc=" <<(iP ? 1 : 0) <<" path=" <<Sel.Path.Val);
    return (iP ? 1 : 0);
 }
@@ -313,7 +319,8 @@ int XrdCmsCache::WT4File(XrdCmsSelect &Sel, SMask_t mask)
 // Make sure we have the proper information. If so, lock the hash table
 //
    if (!Sel.InfoP) return DLTime;
-   myMutex.Lock();
+   CacheShard &S = Shard4(Sel.Path);
+   S.Mutex.Lock();
 
 // Look up the entry and if valid add it to the callback queue. Note that
 // this method may only be called after GetFile() or AddFile() for a new entry
@@ -328,7 +335,7 @@ int XrdCmsCache::WT4File(XrdCmsSelect &Sel, SMask_t mask)
 
 // Return result
 //
-   myMutex.UnLock();
+   S.Mutex.UnLock();
    DEBUG("rc=" <<retc <<" path=" <<Sel.Path.Val);
    return retc;
 }
@@ -345,11 +352,11 @@ void XrdCmsCache::Bounce(SMask_t smask, int SNum)
 
 // Simply indicate that this server bounced
 //
-   myMutex.Lock();
+   bvMutex.Lock();
    Bounced[SNum] = ++BClock;
-   okVec |= smask;
+   okVec = okVec.load() | smask;
    if (SNum > vecHi) vecHi = SNum;
-   myMutex.UnLock();
+   bvMutex.UnLock();
 }
 
 /******************************************************************************/
@@ -366,11 +373,11 @@ void XrdCmsCache::Drop(SMask_t smask, int SNum, int xHi)
 
 // Remove the node from the list of valid nodes
 //
-   myMutex.Lock();
+   bvMutex.Lock();
    Bounced[SNum] = 0;
-   okVec &= nmask;
+   okVec = okVec.load() & nmask;
    vecHi = xHi;
-   myMutex.UnLock();
+   bvMutex.UnLock();
 }
 
 /******************************************************************************/
@@ -379,8 +386,8 @@ void XrdCmsCache::Drop(SMask_t smask, int SNum, int xHi)
   
 int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold)
 {
-   XrdCmsKeyItem *iP;
    pthread_t tid;
+   int i;
 
 // Indicate whether we are a shared-everything setup as this changes how we
 // dispatch clients to newly discovered files (see Dispatch()).
@@ -409,11 +416,13 @@ int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold
        return 0;
       }
 
-// Get the first reserve of cache items
+// Get the first reserve of cache items for each shard
 //
-   iP = XrdCmsKeyItem::Alloc(0);
-   XrdCmsKeyItem::Unload((unsigned int)0);
-   iP->Recycle();
+   for (i = 0; i < numShards; i++)
+       {Shard[i].Mutex.Lock();
+        XrdCmsKeyItem::Replenish(Shard[i].Table.Items);
+        Shard[i].Mutex.UnLock();
+       }
 
 // All done
 //
@@ -427,16 +436,23 @@ int XrdCmsCache::Init(int fxHold, int fxDelay, int fxQuery, int seFS, int nxHold
 void *XrdCmsCache::TickTock()
 {
    XrdCmsKeyItem *iP;
+   int i;
 
-// Simply adjust the clock and trim old entries
+// Simply adjust the clock and trim old entries. This is done one shard at a
+// time so that lookups in the other shards proceed while a shard is trimmed.
 //
    do {XrdSysTimer::Snooze(Tick);
-       myMutex.Lock();
        Tock = (Tock+1) & XrdCmsKeyItem::TickMask;
+       for (i = 0; i < numShards; i++)
+           {Shard[i].Mutex.Lock();
+            Shard[i].Tock = Tock;
+            iP = XrdCmsKeyItem::Unload(Shard[i].Table.Items, Tock);
+            Shard[i].Mutex.UnLock();
+            if (iP) Sched->Schedule((XrdJob *)new XrdCmsCacheJob(iP, i));
+           }
+       bvMutex.Lock();
        Bhistory[Tock].Start = Bhistory[Tock].End = 0;
-       iP = XrdCmsKeyItem::Unload(Tock);
-       myMutex.UnLock();
-       if (iP) Sched->Schedule((XrdJob *)new XrdCmsCacheJob(iP));
+       bvMutex.UnLock();
       } while(1);
 
 // Keep compiler happy
@@ -505,6 +521,7 @@ void XrdCmsCache::Dispatch(XrdCmsSelect &Sel, XrdCmsKeyItem *iP,
 SMask_t XrdCmsCache::getBVec(unsigned int TODa, unsigned int &TODb)
 {
    EPNAME("getBVec");
+   XrdSysMutexHelper bvHelper(bvMutex);
    SMask_t BVec(0);
    long long i;
 
@@ -516,7 +533,7 @@ SMask_t XrdCmsCache::getBVec(unsigned int TODa, unsigned int &TODb)
 // Calculate the new vector
 //
    for (i = 0; i <= vecHi; i++)
-       if (TODb < Bounced[i]) BVec |= 1ULL << i;
+       if (TODb < Bounced[i]) BVec |= XrdCmsMaskBit(i);
 
    Bhistory[TODa].Vec   = BVec;
    Bhistory[TODa].Start = TODb;
@@ -531,8 +548,9 @@ SMask_t XrdCmsCache::getBVec(unsigned int TODa, unsigned int &TODb)
 /*                               R e c y c l e                                */
 /******************************************************************************/
   
-void XrdCmsCache::Recycle(XrdCmsKeyItem *theList)
+void XrdCmsCache::Recycle(XrdCmsKeyItem *theList, int sNum)
 {
+   CacheShard &S = Shard[sNum];
    XrdCmsKeyItem *iP;
    char msgBuff[100];
    int numNull, numHave, numFree, numRecycled = 0;
@@ -543,28 +561,28 @@ void XrdCmsCache::Recycle(XrdCmsKeyItem *theList)
         {theList = iP->Key.TODRef;
          if (iP->Loc.roPend) RRQ.Del(iP->Loc.roPend, iP);
          if (iP->Loc.rwPend) RRQ.Del(iP->Loc.rwPend, iP);
-         myMutex.Lock(); CTable.Recycle(iP); myMutex.UnLock();
+         S.Mutex.Lock(); S.Table.Recycle(iP); S.Mutex.UnLock();
          numRecycled++;
         }
 
 // See if we have enough items in reserve
 //
-   myMutex.Lock();
-   XrdCmsKeyItem::Stats(numHave, numFree, numNull);
+   S.Mutex.Lock();
+   XrdCmsKeyItem::Stats(S.Table.Items, numHave, numFree, numNull);
    if (numFree < XrdCmsKeyItem::minFree)
-      {myMutex.UnLock();
+      {S.Mutex.UnLock();
        if (!(numNull /= 4)) numNull = 1;
        numHave += XrdCmsKeyItem::minAlloc * numNull;
        while(numNull--)
-            {myMutex.Lock();
-             numFree = XrdCmsKeyItem::Replenish();
-             myMutex.UnLock();
+            {S.Mutex.Lock();
+             numFree = XrdCmsKeyItem::Replenish(S.Table.Items);
+             S.Mutex.UnLock();
             }
-      } else myMutex.UnLock();
+      } else S.Mutex.UnLock();
 
 // Log the stats
 //
-   sprintf(msgBuff, "%d cache items; %d allocated %d free",
-           numRecycled, numHave, numFree);
+   sprintf(msgBuff, "%d cache items; %d allocated %d free in shard %d",
+           numRecycled, numHave, numFree, sNum);
    Say.Emsg("Recycle", msgBuff);
 }
@@ -30,6 +30,7 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <atomic>
 #include <cstring>
   
 #include "Xrd/XrdJob.hh"
@@ -85,30 +86,55 @@ static const int min_nxTime = 60;
                             DLTime(5), QDelay(5), Bhits(0), Bmiss(0), vecHi(-1),
                             isDFS(0)
                           {memset(Bounced,  0, sizeof(Bounced));
-                           memset(Bhistory, 0, sizeof(Bhistory));
+                           for (unsigned int i = 0; i < XrdCmsKeyItem::TickRate; i++)
+                               {Bhistory[i].Vec = 0;
+                                Bhistory[i].Start = Bhistory[i].End = 0;
+                               }
                           }
            ~XrdCmsCache() {}   // Never gets deleted
 
 private:
 
+// The location cache is split into shards selected by the high order bits of
+// the path hash. Each shard has its own lock, hash table, item pool and clock
+// so that lookups and updates of unrelated paths never contend and expiry
+// proceeds one shard at a time. Lock order is shard Mutex then bvMutex.
+//
+static const int shardBits = 4;
+static const int numShards = 1 << shardBits;
+
+struct CacheShard
+      {XrdSysMutex   Mutex;
+       XrdCmsNash    Table;
+       unsigned int  Tock;
+
+                     CacheShard() : Table(1597, 2584), Tock(0) {}
+                    ~CacheShard() {}
+      };
+
+inline CacheShard &Shard4(XrdCmsKey &Key)
+                         {if (!Key.Hash) Key.setHash();
+                          return Shard[Key.Hash >> (32 - shardBits)];
+                         }
+
 void          Add2Q(XrdCmsRRQInfo *Info, XrdCmsKeyItem *cp, int selOpts);
 void          Dispatch(XrdCmsSelect &Sel, XrdCmsKeyItem *cinfo,
                        short roQ, short rwQ);
 SMask_t       getBVec(unsigned int todA, unsigned int &todB);
-void          Recycle(XrdCmsKeyItem *theList);
+void          Recycle(XrdCmsKeyItem *theList, int sNum);
 
 struct  {SMask_t      Vec;
          unsigned int Start;
          unsigned int End;
         }             Bhistory[XrdCmsKeyItem::TickRate];
 
-XrdSysMutex   myMutex;
-XrdCmsNash    CTable;
+CacheShard    Shard[numShards];
+XrdSysMutex   bvMutex;         // Serializes the bounce vector information
 unsigned int  Bounced[STMax];
-SMask_t       okVec;
+std::atomic<SMask_t> okVec;
 unsigned int  Tick;
 unsigned int  Tock;
-unsigned int  BClock;
+std::atomic<unsigned int> BClock;
          int  nilTMO;
          int  DLTime;
          int  QDelay;
@@ -29,6 +29,7 @@
 /******************************************************************************/
 
 #include <cerrno>
+#include <chrono>
 #include <fcntl.h>
 #include <cstdio>
 #include <cstdlib>
@@ -44,12 +45,16 @@
 #include "Xrd/XrdScheduler.hh"
 
 #include "XrdCms/XrdCmsBaseFS.hh"
+#include "XrdCms/XrdCmsBatch.hh"
 #include "XrdCms/XrdCmsBlackList.hh"
+#include "XrdCms/XrdCmsBloom.hh"
 #include "XrdCms/XrdCmsCache.hh"
 #include "XrdCms/XrdCmsConfig.hh"
 #include "XrdCms/XrdCmsCluster.hh"
 #include "XrdCms/XrdCmsClustID.hh"
+#include "XrdCms/XrdCmsHRW.hh"
 #include "XrdCms/XrdCmsNode.hh"
+#include "XrdCms/XrdCmsP2C.hh"
 #include "XrdCms/XrdCmsRole.hh"
 #include "XrdCms/XrdCmsRRQ.hh"
 #include "XrdCms/XrdCmsState.hh"
@@ -117,6 +122,11 @@ XrdCmsCluster::XrdCmsCluster()
      SelWtot = 0;
      SelRtot = 0;
      SelTcnt = 0;
+     SumQskip  = 0;
+     SumDirect = 0;
+     SumNil    = 0;
+     SumSeen   = false;
+     for (int i = 0; i < SelLatN; i++) SelLat[i] = 0;
      peerHost  = 0;
      peerMask  = ~peerHost;
 }
@@ -250,6 +260,10 @@ XrdCmsNode *XrdCmsCluster::Add(XrdLink *lp, int port, int Status, int sport,
       else         peerHost &= ~nP->NodeMask;
    peerMask = ~peerHost;
 
+// Make the updated table visible to the selection paths
+//
+   SnapPublish();
+
 // Document login
 //
    if (QTRACE(Debug))
@@ -375,34 +389,35 @@ SMask_t XrdCmsCluster::Broadcast(SMask_t smask, const struct iovec *iod,
                                  int iovcnt, int iotot)
 {
    EPNAME("Broadcast")
-   int i;
-   XrdCmsNode *nP;
+   XrdCmsNode *nP, *nList[STMax];
    SMask_t bmask, unQueried(0);
+   int i, nNum = 0;
 
-// Obtain a lock on the table and screen out peer nodes
+// Pick up the eligible nodes from the current snapshot and screen out peer
+// nodes. We up the reference count of each node to keep the node pointer valid
+// for the duration of the send() (may or may not block) which we must do
+// after we let go of the snapshot.
 //
-   STMutex.ReadLock(); // Sufficient to prevent modifications
-   bmask = smask & peerMask;
+  {XrdCmsSnapshot<NodeSnap>::Reader Snap(SelSnap);
+   bmask = smask & Snap->peerMask;
+   for (i = 0; i <= Snap->Hi; i++)
+       {if ((nP = Snap->Tab[i]) && nP->isNode(bmask))
+           {if (nP->isOffline) unQueried |= nP->Mask();
+               else {nP->Ref(); nList[nNum++] = nP;}
+           }
+       }
+  }
 
-// Run through the table looking for nodes to send messages to. We don't need
-// the node lock for this but we do need to up the reference count to keep the
-// node pointer valid for the duration of the send() (may or may not block).
+// Run through the list sending the message to each node
 //
-   for (i = 0; i <= STHi; i++)
-       {if ((nP = NodeTab[i]) && nP->isNode(bmask))
-           {if (nP->isOffline) unQueried |= nP->Mask();
-               else {nP->Ref();
-                     STMutex.UnLock();
-                     if (nP->Send(iod, iovcnt, iotot) < 0)
-                        {unQueried |= nP->Mask();
-                         DEBUG(nP->Ident <<" is unreachable");
-                        }
-                     nP->unRef();
-                     STMutex.ReadLock();
-                    }
+   for (i = 0; i < nNum; i++)
+       {nP = nList[i];
+        if (nP->Send(iod, iovcnt, iotot) < 0)
+           {unQueried |= nP->Mask();
+            DEBUG(nP->Ident <<" is unreachable");
            }
+        nP->unRef();
        }
-   STMutex.UnLock();
    return unQueried;
 }
 
@@ -597,15 +612,16 @@ int XrdCmsCluster::Locate(XrdCmsSelect &Sel)
 {
    EPNAME("Locate");
    XrdCmsPInfo   pinfo;
-   SMask_t       qfVec(0);
+   SMask_t       qfVec(0), sumSkip(0);
    char         *Path;
    int           retc = 0;
+   bool          isNew = false;
 
 // Check if this is a locate for all current servers
 //
    if (*Sel.Path.Val != '*') Path = Sel.Path.Val;
       else {if (*(Sel.Path.Val+1) == '\0')
-               {Sel.Vec.hf = ~0LL; Sel.Vec.pf = Sel.Vec.wf = 0;
+               {Sel.Vec.hf = FULLMASK; Sel.Vec.pf = Sel.Vec.wf = 0;
                 return 0;
                }
             Path = Sel.Path.Val+1;
@@ -656,9 +672,26 @@ int XrdCmsCluster::Locate(XrdCmsSelect &Sel)
    if (Sel.Opts & XrdCmsSelect::Refresh
    || !(retc = Cache.GetFile(Sel, pinfo.rovec)))
       {Cache.AddFile(Sel, 0);
-       qfVec = pinfo.rovec; Sel.Vec.hf = 0;
+       qfVec = pinfo.rovec; Sel.Vec.hf = 0; isNew = true;
       } else qfVec = Sel.Vec.bf;
 
+// For a new entry, don't ask nodes whose namespace summary says they don't
+// have the file. A summary may be stale, so skipped nodes are only marked as
+// unqueried and are asked on the next lookup. Should the summaries rule out
+// every node, all of them are asked now as nothing would be gained.
+//
+   if (qfVec && isNew && SumSeen)
+      {SMask_t sumMask;
+       sumSkip = SumSkip(qfVec & ~pinfo.ssvec, Sel.Path.Val, sumMask);
+       if (sumSkip == qfVec)
+          {SumNil++; sumSkip = 0;
+           TRACE(Files, "summaries rule out " <<Sel.Path.Val);
+          } else if (sumSkip)
+                    {qfVec &= ~sumSkip;
+                     SumQskip += XrdCmsMaskCnt(sumSkip);
+                    }
+      }
+
 // Compute the delay, if any
 //
    if ((!qfVec && retc >= 0) || (Sel.Vec.hf && Sel.InfoP)) retc =  0;
@@ -671,9 +704,8 @@ int XrdCmsCluster::Locate(XrdCmsSelect &Sel)
        if (Sel.Opts & XrdCmsSelect::Refresh)
           QReq.Hdr.modifier |= CmsStateRequest::kYR_refresh;
        TRACE(Files, "seeking " <<Sel.Path.Val);
-       qfVec = Cluster.Broadcast(qfVec, QReq.Hdr,
-                                 (void *)Sel.Path.Val, Sel.Path.Len+1);
-       if (qfVec) Cache.UnkFile(Sel, qfVec);
+       qfVec = Query(qfVec, QReq.Hdr, (void *)Sel.Path.Val, Sel.Path.Len+1);
+       if (qfVec | sumSkip) Cache.UnkFile(Sel, qfVec | sumSkip);
       }
    return retc;
 }
@@ -688,7 +720,7 @@ void *XrdCmsCluster::MonPerf()
    struct iovec ioV[] = {{(char *)&Usage, sizeof(Usage)}};
    int ioVnum = sizeof(ioV)/sizeof(struct iovec);
    int ioVtot = sizeof(Usage);
-   SMask_t allNodes(~0);
+   SMask_t allNodes(FULLMASK);
    int uInterval = Config.AskPing*Config.AskPerf;
 
 // Sleep for the indicated amount of time, then ask for load on each server
@@ -745,6 +777,64 @@ void *XrdCmsCluster::MonRefs()
    return (void *)0;
 }
 
+/******************************************************************************/
+/*                                 Q u e r y                                  */
+/******************************************************************************/
+
+SMask_t XrdCmsCluster::Query(SMask_t smask, XrdCms::CmsRRHdr &Hdr,
+                             void *Data,    int Dlen)
+{
+   EPNAME("Query")
+   struct iovec ioV[2] = {{(char *)&Hdr, sizeof(Hdr)},
+                          {(char *)Data, (size_t)Dlen}};
+   XrdCmsNode *nP, *nList[STMax];
+   SMask_t bmask, unQueried(0);
+   long long qTime = 0;
+   int i, nNum = 0, ioTot = Dlen+sizeof(Hdr);
+   bool doBatch;
+
+// Determine if we can batch this query and whether its response will arrive
+// so that it may be timed for the p2c selection policy.
+//
+   Hdr.datalen = htons(static_cast<unsigned short>(Dlen));
+   doBatch = Batch.Active() && ioTot <= XrdCmsBatch::maxBytes;
+   if (Config.sched_P2C && Hdr.rrCode == kYR_state
+   &&  !(Hdr.modifier & CmsStateRequest::kYR_noresp)) qTime = XrdCmsP2C::Now();
+
+// Pick up the eligible nodes from the current snapshot, referencing each one,
+// as sending or queueing a query may block and we must not block while we
+// hold the snapshot.
+//
+  {XrdCmsSnapshot<NodeSnap>::Reader Snap(SelSnap);
+   bmask = smask & Snap->peerMask;
+   for (i = 0; i <= Snap->Hi; i++)
+       {if ((nP = Snap->Tab[i]) && nP->isNode(bmask))
+           {if (nP->isOffline) unQueried |= nP->Mask();
+               else {nP->Ref(); nList[nNum++] = nP;}
+           }
+       }
+  }
+
+// Send or queue the query for each node. The batcher keeps its own reference
+// for as long as the query is pending. Queries that fail when the batch is
+// sent are lost; that only happens when the node is going away and its cache
+// entries are dropped at that point. Each node times one query at a time.
+//
+   for (i = 0; i < nNum; i++)
+       {nP = nList[i];
+        if (qTime && (!nP->prbTime || qTime-nP->prbTime > XrdCmsP2C::prbWait))
+           {nP->prbHash = Hdr.streamid; nP->prbTime = qTime;}
+        if (!doBatch || !Batch.Queue(nP, ioV, 2, ioTot))
+           {if (nP->Send(ioV, 2, ioTot) < 0)
+               {unQueried |= nP->Mask();
+                DEBUG(nP->Ident <<" is unreachable");
+               }
+           }
+        nP->unRef();
+       }
+   return unQueried;
+}
+
 /******************************************************************************/
 /*                                R e m o v e                                 */
 /******************************************************************************/
@@ -848,6 +938,7 @@ void XrdCmsCluster::Remove(const char *reason, XrdCmsNode *theNode, int immed)
    if (theNode->isBound)
       {theNode->isBound = 0;
        NodeCnt--;
+       SnapPublish();
        if (Config.asManager())
           CmsState.Update(XrdCmsState::Counts,
                           theNode->isBad & XrdCmsNode::isSuspend ? 0 : -1,
@@ -861,6 +952,7 @@ void XrdCmsCluster::Remove(const char *reason, XrdCmsNode *theNode, int immed)
    && (altNode = theNode->cidP->RemNode(theNode)))
       {if (altNode->isBound) NodeCnt++;
        NodeTab[NodeID] = altNode;
+       SnapPublish();
        if (Config.asManager())
           CmsState.Update(XrdCmsState::Counts,
                           altNode->isBad & XrdCmsNode::isSuspend ? 0 :  1,
@@ -935,6 +1027,8 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
    const char  *Amode;
    int dowt = 0, retc = 0, isRW, fRD, noSel = (Sel.Opts & XrdCmsSelect::Defer);
    SMask_t amask, smask, pmask;
+   SMask_t sumSkip = 0;
+   bool isNew = false;
 
 // Establish some local options
 //
@@ -1027,7 +1121,28 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
        Cache.AddFile(Sel, 0);
        Sel.Vec.bf = pinfo.rovec;
        Sel.Vec.hf = Sel.Vec.pf = pmask = smask = 0;
-       retc = 0;
+       retc = 0; isNew = true;
+      }
+
+// For reads of a new entry, don't ask nodes whose namespace summary says they
+// don't have the file. A summary may be stale, so skipped nodes are only
+// marked as unqueried and are asked on the next lookup. Should the summaries
+// rule out every node, all of them are asked now. If a single node is left and
+// its summary says that it may have the file, it is selected now and the query
+// confirms it later. Writes always ask all nodes as a summary may not yet
+// include a recently created file.
+//
+   if (!isRW && isNew && Sel.Vec.bf && SumSeen)
+      {SMask_t sumMask;
+       sumSkip = SumSkip(Sel.Vec.bf & ~pinfo.ssvec, Sel.Path.Val, sumMask);
+       if (sumSkip == Sel.Vec.bf) {SumNil++; sumSkip = 0;}
+          else if (sumSkip)
+                  {Sel.Vec.bf &= ~sumSkip;
+                   SumQskip += XrdCmsMaskCnt(sumSkip);
+                   if (!pmask && !smask && !XrdCmsMaskMulti(Sel.Vec.bf)
+                   &&  (Sel.Vec.bf & sumMask & amask) == Sel.Vec.bf)
+                      {pmask = Sel.Vec.bf; SumDirect++;}
+                  }
       }
 
 // A wait is required if we don't have any primary or seconday servers
@@ -1043,9 +1158,9 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
           QReq.Hdr.modifier |= CmsStateRequest::kYR_refresh;
        if (dowt) retc= (fRD ? Cache.WT4File(Sel,Sel.Vec.hf) : Config.LUPDelay);
        TRACE(Files, "seeking " <<Sel.Path.Val);
-       amask = Cluster.Broadcast(Sel.Vec.bf, QReq.Hdr,
-                                 (void *)Sel.Path.Val,Sel.Path.Len+1);
-       if (amask) Cache.UnkFile(Sel, amask);
+       amask = Query(Sel.Vec.bf, QReq.Hdr,
+                     (void *)Sel.Path.Val, Sel.Path.Len+1);
+       if (amask | sumSkip) Cache.UnkFile(Sel, amask | sumSkip);
        if (dowt) return retc;
       } else if (dowt && retc < 0 && !noSel)
                 return (fRD ? Cache.WT4File(Sel,Sel.Vec.hf) : Config.LUPDelay);
@@ -1054,7 +1169,7 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
 //
    if ((Sel.Opts & XrdCmsSelect::Freshen) && (amask = pmask & ~Sel.Vec.bf))
       {CmsStateRequest Qupt={{0,kYR_state,(kXR_char)kYR_raw|(kXR_char)CmsStateRequest::kYR_noresp,0}};
-       Cluster.Broadcast(amask, Qupt.Hdr,(void *)Sel.Path.Val,Sel.Path.Len+1);
+       Query(amask, Qupt.Hdr, (void *)Sel.Path.Val, Sel.Path.Len+1);
       }
 
 // If we need to defer selection, simply return as this is a mindless prepare
@@ -1088,11 +1203,9 @@ int XrdCmsCluster::Select(XrdCmsSelect &Sel)
 int XrdCmsCluster::Select(SMask_t pmask, int &port, char *hbuff, int &hlen,
                           int isrw, int isMulti, int ifWant)
 {
-   static const SMask_t smLow(255);
    XrdCmsSelector selR;
    XrdCmsNode *nP = 0;
-   SMask_t tmask;
-   int Snum = 0;
+   int Snum;
    XrdNetIF::ifType nType = static_cast<XrdNetIF::ifType>(ifWant);
 
 // If there is nothing to select from, return failure
@@ -1114,31 +1227,30 @@ int XrdCmsCluster::Select(SMask_t pmask, int &port, char *hbuff, int &hlen,
 // If we are exporting a shared-everything system then the incoming mask
 // may have more than one server indicated. So, we need to do a full select.
 // This is forced when isMulti is true, indicating a choice may exist. Note
-// that the node, if any, is returned unlocked but we have the global mutex.
+// that the node, if any, is returned unlocked but we hold the snapshot.
 //
    if (isMulti || baseFS.isDFS())
-      {STMutex.ReadLock();
-       nP = (Config.sched_RR ? SelbyRef(pmask,selR)
-                             : Config.sched_LoadR == 0 ? SelbyLoad(pmask,selR)
-                                                       : SelbyLoadR(pmask, selR));
+      {XrdCmsSnapshot<NodeSnap>::Reader Snap(SelSnap);
+       nP = (Config.sched_P2C ? SelbyP2C(*Snap,pmask,selR)
+                             : Config.sched_RR ? SelbyRef(*Snap,pmask,selR)
+                             : Config.sched_LoadR == 0
+                             ? SelbyLoad(*Snap,pmask,selR)
+                             : SelbyLoadR(*Snap,pmask,selR));
 
        if (nP) hlen = nP->netIF.GetName(hbuff, port, nType) + 1;
           else hlen = 0;
-       STMutex.UnLock();
        return hlen != 1;
       }
 
 // In shared-nothing systems the incoming mask will only have a single node.
 // Compute the a single node number that is contained in the mask.
 //
-   do {if (!(tmask = pmask & smLow)) Snum += 8;
-         else {while((tmask = tmask>>1)) Snum++; break;}
-      } while((pmask = pmask >> 8));
+   if ((Snum = XrdCmsMaskLow(pmask)) < 0) return 0;
 
 // See if the node passes muster
 //
-   STMutex.ReadLock();
-   if ((nP = NodeTab[Snum]))
+   XrdCmsSnapshot<NodeSnap>::Reader Snap(SelSnap);
+   if ((nP = Snap->Tab[Snum]))
       {     if (nP->isBad) nP = 0;
        else if (!Config.sched_RR && (nP->myLoad > Config.MaxLoad)) nP = 0;
        else if (!(selR.needNet & nP->hasNet))                      nP = 0;
@@ -1155,10 +1267,8 @@ int XrdCmsCluster::Select(SMask_t pmask, int &port, char *hbuff, int &hlen,
    if (nP)
       {hlen = nP->netIF.GetName(hbuff, port, nType) + 1;
        nP->RefR++;
-       STMutex.UnLock();
        return hlen != 1;
       }
-   STMutex.UnLock();
    return 0;
 }
 
@@ -1256,20 +1366,31 @@ void XrdCmsCluster::Space(SpaceData &sData, SMask_t smask)
 
 int XrdCmsCluster::Stats(char *bfr, int bln)
 {
+   static const char statfmt0[] = "</stats>";
    static const char statfmt1[] = "<stats id=\"cms\">"
-                     "<role>%s</role></stats>";
-   int mlen;
+                     "<role>%s</role>";
+   int mlen, tlen;
 
 // Check if actual length wanted
 //
-   if (!bfr) return  sizeof(statfmt1) + 8;
+   if (!bfr) return  sizeof(statfmt0) + sizeof(statfmt1) + 8 + Batch.Stats(0,0);
 
 // Format the statistics (not much here for now)
 //
    mlen = snprintf(bfr, bln, statfmt1, Config.myRType);
-
    if ((bln -= mlen) <= 0) return 0;
-   return mlen;
+   tlen = mlen; bfr += mlen;
+
+// Add batching statistics if batching is in effect
+//
+   mlen = Batch.Stats(bfr, bln);
+   bfr += mlen; bln -= mlen; tlen += mlen;
+
+// Finish up
+//
+   if (bln < (int)sizeof(statfmt0)) return 0;
+   strcpy(bfr, statfmt0);
+   return tlen + sizeof(statfmt0) - 1;
 }
 
 /******************************************************************************/
@@ -1280,7 +1401,9 @@ int XrdCmsCluster::Statt(char *bfr, int bln)
 {
    static const char statfmt0[] = "</stats>";
    static const char statfmt1[] = "<stats id=\"cmsm\">"
-          "<role>%s</role><sel><t>%lld</t><r>%lld</r><w>%lld</w></sel>"
+          "<role>%s</role><sel><t>%lld</t><r>%lld</r><w>%lld</w>"
+          "<lat><p50>%lld</p50><p90>%lld</p90><p99>%lld</p99></lat>"
+          "<sum><skip>%lld</skip><dir>%lld</dir><nil>%lld</nil></sum></sel>"
           "<node>%d";
    static const char statfmt2[] = "<stats id=\"%d\">"
           "<host>%s</host><role>%s</role>"
@@ -1289,7 +1412,9 @@ int XrdCmsCluster::Statt(char *bfr, int bln)
    static const char statfmt4[] = "</node>";
    static const char statfmt5[] =
           "<frq><add>%lld<d>%lld</d></add><rsp>%lld<m>%lld</m></rsp>"
-          "<lf>%lld</lf><ls>%lld</ls><rf>%lld</rf><rs>%lld</rs></frq>";
+          "<lf>%lld</lf><ls>%lld</ls><rf>%lld</rf><rs>%lld</rs>"
+          "<wt>%lld<avg>%lld</avg><p50>%lld</p50><p99>%lld</p99>"
+          "<max>%lld</max></wt></frq>";
 
    static int AddFrq = (Config.RepStats & XrdCmsConfig::RepStat_frq);
    static int AddShr = (Config.RepStats & XrdCmsConfig::RepStat_shr)
@@ -1314,11 +1439,11 @@ int XrdCmsCluster::Statt(char *bfr, int bln)
 //
    if (!bfr)
       {n = sizeof(statfmt0) +
-           sizeof(statfmt1) + 12*3 + 3 + 3 +
+           sizeof(statfmt1) + 12*3 + 12*3 + 12*3 + 3 + 3 +
           (sizeof(statfmt2) + 10*2 + 256 + 16) * STMax + sizeof(statfmt4);
        if (AddShr) n += sizeof(statfmt3) + 12;
-       if (AddFrq) n += sizeof(statfmt4) + (10*8);
-       return n;
+       if (AddFrq) n += sizeof(statfmt5) + (20*13);
+       return n + Batch.Stats(0,0);
       }
 
 // Get the statistics
@@ -1334,8 +1459,12 @@ int XrdCmsCluster::Statt(char *bfr, int bln)
 // Format the statistics
 //
    long long lclTcnt = SelTcnt, lclRtot = SelRtot, lclWtot = SelWtot;
+   long long latP[3];
+   SelPctl(latP);
+   long long sumS = SumQskip, sumD = SumDirect, sumN = SumNil;
    mlen = snprintf(bfr, bln, statfmt1,
-          Config.myRType, lclTcnt, lclRtot, lclWtot, n);
+          Config.myRType, lclTcnt, lclRtot, lclWtot,
+          latP[0], latP[1], latP[2], sumS, sumD, sumN, n);
 
    if ((bln -= mlen) <= 0) return 0;
    tlen = mlen; bfr += mlen; n = 0; *shrBuff = 0;
@@ -1364,7 +1493,13 @@ int XrdCmsCluster::Statt(char *bfr, int bln)
 
    if (AddFrq && bln > 0)
       {mlen = snprintf(bfr, bln, statfmt5, Frq.Add2Q, Frq.PBack, Frq.Resp,
-              Frq.Multi, Frq.luFast, Frq.luSlow, Frq.rdFast, Frq.rdSlow);
+              Frq.Multi, Frq.luFast, Frq.luSlow, Frq.rdFast, Frq.rdSlow,
+              Frq.Waits, Frq.WaitAvg, Frq.WaitP50, Frq.WaitP99, Frq.WaitMax);
+       bfr += mlen; bln -= mlen; tlen += mlen;
+      }
+
+   if (bln > 0)
+      {mlen = Batch.Stats(bfr, bln);
        bfr += mlen; bln -= mlen; tlen += mlen;
       }
 
@@ -1375,6 +1510,71 @@ int XrdCmsCluster::Statt(char *bfr, int bln)
    return tlen + sizeof(statfmt0) - 1;
 }
 
+/******************************************************************************/
+/*                                S u m A d d                                 */
+/******************************************************************************/
+
+void XrdCmsCluster::SumAdd(XrdCmsNode *nP, const char *path)
+{
+   XrdCmsSnapshot<NodeSnap>::Reader Snap(SelSnap);
+   XrdCmsBloom *bP;
+
+// The snapshot keeps the filter from being deleted while we use it
+//
+   if ((bP = nP->sumBloom.load())) bP->Add(path);
+}
+
+/******************************************************************************/
+/*                            S u m I n s t a l l                             */
+/******************************************************************************/
+
+void XrdCmsCluster::SumInstall(XrdCmsNode *nP, XrdCmsBloom *bP)
+{
+   XrdCmsBloom *oldP;
+
+// Replace the filter. Filters are only used while holding a snapshot, so
+// publishing one assures us that no one is using the old filter.
+//
+   STMutex.WriteLock();
+   if ((oldP = nP->sumBloom.exchange(bP))) SnapPublish();
+   SumSeen = true;
+   STMutex.UnLock();
+   delete oldP;
+}
+
+/******************************************************************************/
+/*                               S u m S k i p                                */
+/******************************************************************************/
+
+SMask_t XrdCmsCluster::SumSkip(SMask_t qmask, const char *path,
+                               SMask_t &sumMask)
+{
+   XrdCmsBloom *bP;
+   XrdCmsNode  *nP;
+   SMask_t      noMask(0);
+   unsigned long long pHash;
+   time_t       Now;
+
+// Avoid doing anything if no node ever sent us a summary
+//
+   sumMask = 0;
+   if (!SumSeen) return noMask;
+   pHash = XrdCmsBloom::Hash(path);
+   Now   = time(0);
+
+// Check the filter of each node that has a current one
+//
+   XrdCmsSnapshot<NodeSnap>::Reader Snap(SelSnap);
+   for (int i = 0; i <= Snap->Hi; i++)
+       {if ((nP = Snap->Tab[i]) && nP->isNode(qmask)
+        &&  (bP = nP->sumBloom.load()) && (!bP->Expires || bP->Expires > Now))
+           {sumMask |= nP->Mask();
+            if (!bP->Test(pHash)) noMask |= nP->Mask();
+           }
+       }
+   return noMask;
+}
+
 /******************************************************************************/
 /*                       P r i v a t e   M e t h o d s                        */
 /******************************************************************************/
@@ -1477,6 +1677,10 @@ int XrdCmsCluster::Drop(int sent, int sinst, XrdCmsDrop *djp)
 //
    if (sent == STHi) while(STHi >= 0 && !NodeTab[STHi]) STHi--;
 
+// Republish the table. Once this returns no selection can see the node.
+//
+   SnapPublish();
+
 // Invalidate any cached entries for this node
 //
    if (nP->NodeMask) Cache.Drop(nP->NodeMask, sent, STHi);
@@ -1500,30 +1704,7 @@ int XrdCmsCluster::Drop(int sent, int sinst, XrdCmsDrop *djp)
 
 int XrdCmsCluster::Multiple(SMask_t mVec)
 {
-   static const unsigned long long Left32  = 0xffffffff00000000LL;
-   static const unsigned long long Right32 = 0x00000000ffffffffLL;
-   static const unsigned long long Left16  = 0x00000000ffff0000LL;
-   static const unsigned long long Right16 = 0x000000000000ffffLL;
-   static const unsigned long long Left08  = 0x000000000000ff00LL;
-   static const unsigned long long Right08 = 0x00000000000000ffLL;
-   static const unsigned long long Left04  = 0x00000000000000f0LL;
-   static const unsigned long long Right04 = 0x000000000000000fLL;
-//                                0 1 2 3 4 5 6 7 8 9 A B C D E F
-   static const int isMult[16] = {0,0,0,1,0,1,1,1,0,1,1,1,1,1,1,1};
-
-   if (mVec & Left32) {if (mVec & Right32) return 1;
-                          else mVec = mVec >> 32LL;
-                      }
-   if (mVec & Left16) {if (mVec & Right16) return 1;
-                          else mVec = mVec >> 16LL;
-                      }
-   if (mVec & Left08) {if (mVec & Right08) return 1;
-                          else mVec = mVec >>  8LL;
-                      }
-   if (mVec & Left04) {if (mVec & Right04) return 1;
-                          else mVec = mVec >>  4LL;
-                      }
-   return isMult[mVec];
+   return XrdCmsMaskMulti(mVec) ? 1 : 0;
 }
 
 /******************************************************************************/
@@ -1532,19 +1713,9 @@ int XrdCmsCluster::Multiple(SMask_t mVec)
 
 bool XrdCmsCluster::maxBits(SMask_t mVec, int mbits)
 {
-   int count = 0;
-
-// Count bits. This is the fastest way assuming few bits are set
-//
-   while(mVec)
-        {mVec &= (mVec - 1);
-         count++;
-         if (count >= mbits) return true;
-        }
-
-// Indicate we have not reached the maximum bits set
+// Count bits using the population count instruction
 //
-   return false;
+   return XrdCmsMaskCnt(mVec) >= mbits;
 }
 
 /******************************************************************************/
@@ -1574,7 +1745,8 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
 {
     EPNAME("SelNode")
     const char *act=0;
-    int affsel = 1, count = 0, isalt = 0, pass = 2;
+    int affsel = 1, count = 0, isalt = 0, nodeCnt, pass = 2;
+    bool isPeer = false;
     SMask_t mask;
     XrdCmsNode *nP = 0;
     XrdCmsSelector selR;
@@ -1589,8 +1761,7 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
    if (!(Sel.Opts & XrdCmsSelect::Pack)) selR.selPack = 0;
       else {unsigned int theHash = (Sel.Opts & XrdCmsSelect::UseAH
                                  ?  Sel.AltHash : Sel.Path.Hash);
-            SMask_t sVec = pmask;
-            for (count = 0; sVec; count++) sVec &= (sVec - 1);
+            count = XrdCmsMaskCnt(pmask);
             if (count > 1) selR.selPack = affsel = (theHash % count) + 1;
                else        selR.selPack = 0;
            }
@@ -1603,37 +1774,67 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
                           ?  XrdCmsNode::allowsRW : 0);
 
 // Scan for a primary and alternate node (alternates do staging). At this
-// point we omit all peer nodes as they are our last resort. Note that Selbyxxx
-// returns the node unlocked but we have the global mutex so that is OK.
-//
-   STMutex.ReadLock();
-   mask = pmask & peerMask;
+// point we omit all peer nodes as they are our last resort. The scan works off
+// the current snapshot of the node table so no lock is needed. Selbyxxx
+// returns the node unlocked so we must reference it before we let go of the
+// snapshot as only that keeps the node object valid afterwards.
+//
+   auto selBeg = std::chrono::steady_clock::now();
+  {XrdCmsSnapshot<NodeSnap>::Reader Snap(SelSnap);
+   mask = pmask & Snap->peerMask;
    while(pass--)
         {if (mask)
-            {nP = (Config.sched_RR || (Sel.Opts & XrdCmsSelect::UseRef)
-                ?  SelbyRef(mask,selR)
-                :  Config.sched_LoadR == 0 ? SelbyLoad(pmask,selR)
-                                           : SelbyLoadR(pmask, selR));
+            {nP = (Config.sched_P2C && !selR.selPack
+                &&  !(Sel.Opts & XrdCmsSelect::UseRef)
+                ?  SelbyP2C(*Snap,mask,selR)
+                :  Config.sched_Hash && !selR.selPack
+                &&  !(Sel.Opts & XrdCmsSelect::UseRef)
+                ?  SelbyHash(*Snap,mask,selR,XrdCmsHRW::Hash(Sel.Path.Val))
+                :  Config.sched_RR || (Sel.Opts & XrdCmsSelect::UseRef)
+                ?  SelbyRef(*Snap,mask,selR)
+                :  Config.sched_LoadR == 0 ? SelbyLoad(*Snap,pmask,selR)
+                                           : SelbyLoadR(*Snap,pmask,selR));
              if (nP || (selR.nPick && selR.delay)
-             ||  NodeCnt < Config.SUPCount) break;
+             ||  Snap->NodeCnt < Config.SUPCount) break;
             }
-         mask = amask & peerMask; isalt = XrdCmsNode::allowsSS;
+         mask = amask & Snap->peerMask; isalt = XrdCmsNode::allowsSS;
          if (!(Sel.Opts & XrdCmsSelect::isMeta)) selR.needSpace |= isalt;
         }
+   nodeCnt = Snap->NodeCnt;
+
+// If we found nothing, we have a sufficient number of local nodes, and the
+// client need not be delayed, attempt a peer node selection (choice of last
+// resort). We do not forward to a peer unless we have enough local nodes.
+//
+   if (!nP && (selR.delay || nodeCnt >= Config.SUPCount)
+   &&  !(selR.delay && selR.delay < Config.PSDelay)
+   &&  (Sel.Opts & XrdCmsSelect::Peers))
+      {const char *reason1 = selR.reason;
+       int delay1 = selR.delay;
+       bool noNet = selR.xNoNet;
+       if ((mask = (pmask | amask) & Snap->peerHost))
+          isPeer = (nP = SelbyCost(*Snap, mask, selR)) != 0;
+       if (!nP && !selR.delay)
+          {selR.delay = delay1; selR.reason = reason1; selR.xNoNet = noNet;}
+      }
+   if (nP) nP->Ref();
+  }
+   SelTime(std::chrono::duration_cast<std::chrono::microseconds>
+          (std::chrono::steady_clock::now() - selBeg).count());
 
 // Produce affinity result trace
 //
-   if (Sel.Opts & XrdCmsSelect::Pack && nP)
+   if (Sel.Opts & XrdCmsSelect::Pack && nP && !isPeer)
       {TRACE(Redirect, "affinity " <<affsel <<'/' <<count <<'/'
                        <<(int)selR.selPack <<(selR.selPack ? " go " : " ng ")
                        <<nP->Name() <<' ' <<Sel.Path.Val);
       }
 
-// If we found an eligible node then dispatch the client to it. We will
-// swap the global mutex for the node mutex to minimize interefrence.
+// If we found an eligible node then dispatch the client to it. We trade the
+// reference we have for the node lock to minimize interefrence.
 //
    if (nP)
-      {nP->g2nLock(STMutex);
+      {nP->Lock(); nP->unRef();
        Sel.Resp.DLen = nP->netIF.GetName(Sel.Resp.Data, Sel.Resp.Port, nType);
        if (!Sel.Resp.DLen) {nP->UnLock(); return Unreachable(Sel, false);}
        Sel.Resp.DLen++; Sel.smask = nP->NodeMask;
@@ -1642,6 +1843,14 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
        //
        if (Sel.iovN && Sel.iovP) nP->Send(Sel.iovP, Sel.iovN);
 
+       // Peer nodes handle their own scheduling so we are done
+       //
+       if (isPeer)
+          {nP->UnLock();
+           TRACE(Stage, "Peer " <<Sel.Resp.Data <<" handling " <<Sel.Path.Val);
+           return 0;
+          }
+
        // Do special post proccessing when any of:
        // a) isalt true: Secondary selection occurred
        // b) Create set: File creation will occur
@@ -1663,50 +1872,13 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
        return 0;
       }
 
-// No node so check if we have a sufficient number to continue. Note that we
-// do not forward to a peer unless we have a suffficient number of local nodes.
+// No node so check if we have a sufficient number to continue.
 //
-   if (!selR.delay && NodeCnt < Config.SUPCount)
-      {STMutex.UnLock();
-       Record(Sel.Path.Val, "insufficient number of nodes", true);
+   if (!selR.delay && nodeCnt < Config.SUPCount)
+      {Record(Sel.Path.Val, "insufficient number of nodes", true);
        return Config.SUPDelay;
       }
 
-// Return delay if we should avoid selecting a peer manager
-//
-   if (selR.delay && selR.delay < Config.PSDelay)
-      {STMutex.UnLock();
-       Record(Sel.Path.Val, selR.reason);
-       return selR.delay;
-      }
-
-// At this point, we attempt a peer node selection (choice of last resort). Note
-// that we are still holding the global lock! If we find a peer node we will
-// swap it with the node lock.
-//
-   if (Sel.Opts & XrdCmsSelect::Peers)
-      {const char *reason1 = selR.reason;
-       int delay1 = selR.delay;
-       bool noNet = selR.xNoNet;
-       if ((mask = (pmask | amask) & peerHost)) nP = SelbyCost(mask, selR);
-       if (nP)
-          {nP->g2nLock(STMutex);
-           Sel.Resp.DLen = nP->netIF.GetName(Sel.Resp.Data,Sel.Resp.Port,nType);
-           if (!Sel.Resp.DLen) {nP->UnLock(); return Unreachable(Sel, false);}
-           Sel.Resp.DLen++; Sel.smask = nP->NodeMask;
-           if (Sel.iovN && Sel.iovP) nP->Send(Sel.iovP, Sel.iovN);
-           nP->UnLock();
-           TRACE(Stage, "Peer " <<Sel.Resp.Data <<" handling " <<Sel.Path.Val);
-           return 0;
-          }
-       if (!selR.delay)
-          {selR.delay = delay1; selR.reason = reason1; selR.xNoNet = noNet;}
-      }
-
-// At this point we don't need the global lock so let it go.
-//
-   STMutex.UnLock();
-
 // At this point we either don't have enough nodes or simply can't handle this
 //
    if (selR.delay)
@@ -1742,9 +1914,10 @@ int XrdCmsCluster::SelNode(XrdCmsSelect &Sel, SMask_t pmask, SMask_t amask)
 // Cost selection is used only for peer node selection as peers do not
 // report a load and handle their own scheduling.
 
-// Caller must have the STMutex locked. The returned node, if any, is unlocked.
+// Caller must hold a snapshot reader. The returned node, if any, is unlocked.
 
-XrdCmsNode *XrdCmsCluster::SelbyCost(SMask_t mask, XrdCmsSelector &selR)
+XrdCmsNode *XrdCmsCluster::SelbyCost(const NodeSnap &snap, SMask_t mask,
+                                     XrdCmsSelector &selR)
 {
     XrdCmsNode *np, *sp = 0;
     bool Multi = false;
@@ -1752,8 +1925,8 @@ XrdCmsNode *XrdCmsCluster::SelbyCost(SMask_t mask, XrdCmsSelector &selR)
 // Scan for a node (sp points to the selected one)
 //
    selR.Reset(); SelTcnt++;
-   for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
+   for (int i = 0; i <= snap.Hi; i++)
+       if ((np = snap.Tab[i]) && (np->NodeMask & mask))
           {if (!(selR.needNet &  np->hasNet))    {selR.xNoNet= true; continue;}
            selR.nPick++;
            if (np->isOffline)                    {selR.xOff  = true; continue;}
@@ -1787,9 +1960,10 @@ XrdCmsNode *XrdCmsCluster::SelbyCost(SMask_t mask, XrdCmsSelector &selR)
 /*                             S e l b y L o a d                              */
 /******************************************************************************/
 
-// Caller must have the STMutex locked. The returned node, if any, is unlocked.
+// Caller must hold a snapshot reader. The returned node, if any, is unlocked.
 
-XrdCmsNode *XrdCmsCluster::SelbyLoad(SMask_t mask, XrdCmsSelector &selR)
+XrdCmsNode *XrdCmsCluster::SelbyLoad(const NodeSnap &snap, SMask_t mask,
+                                     XrdCmsSelector &selR)
 {
     XrdCmsNode *np, *sp = 0;
     bool Multi = false, reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
@@ -1797,8 +1971,8 @@ XrdCmsNode *XrdCmsCluster::SelbyLoad(SMask_t mask, XrdCmsSelector &selR)
 // Scan for a node (preset possible, suspended, overloaded, full, and dead)
 //
    selR.Reset(); SelTcnt++;
-   for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
+   for (int i = 0; i <= snap.Hi; i++)
+       if ((np = snap.Tab[i]) && (np->NodeMask & mask))
           {if (!(selR.needNet & np->hasNet))      {selR.xNoNet= true; continue;}
            selR.nPick++;
            if (np->isOffline)                     {selR.xOff  = true; continue;}
@@ -1837,9 +2011,10 @@ XrdCmsNode *XrdCmsCluster::SelbyLoad(SMask_t mask, XrdCmsSelector &selR)
 /*                             S e l b y L o a d R                            */
 /******************************************************************************/
 
-// Caller must have the STMutex locked. The returned node, if any, is unlocked.
+// Caller must hold a snapshot reader. The returned node, if any, is unlocked.
 
-XrdCmsNode *XrdCmsCluster::SelbyLoadR(SMask_t mask, XrdCmsSelector &selR)
+XrdCmsNode *XrdCmsCluster::SelbyLoadR(const NodeSnap &snap, SMask_t mask,
+                                      XrdCmsSelector &selR)
 {
   static std::random_device rand_dev;
   static std::default_random_engine generator(rand_dev());
@@ -1852,12 +2027,12 @@ XrdCmsNode *XrdCmsCluster::SelbyLoadR(SMask_t mask, XrdCmsSelector &selR)
   selR.Reset();
   SelTcnt++;
 
-  int totWeight = 0;
+  int totWeight = 0, NodeWeight[STMax];
 
-  for (int i = 0; i <= STHi; ++i) {
+  for (int i = 0; i <= snap.Hi; ++i) {
     NodeWeight[i] = 0; // make node unselectable first
 
-    if (!((np = NodeTab[i]) && (np->NodeMask & mask)))
+    if (!((np = snap.Tab[i]) && (np->NodeMask & mask)))
       continue;
 
     if (!(selR.needNet & np->hasNet)) { selR.xNoNet = true; continue; }
@@ -1883,24 +2058,142 @@ XrdCmsNode *XrdCmsCluster::SelbyLoadR(SMask_t mask, XrdCmsSelector &selR)
   std::uniform_int_distribution<int> distr(1, totWeight);
   int selected = distr(generator);
 
-  for (int i = 0; i <= STHi; ++i) {
+  for (int i = 0; i <= snap.Hi; ++i) {
     if (NodeWeight[i] < selected)
       continue;
 
-    sp = NodeTab[i];
+    sp = snap.Tab[i];
     break;
   }
 
   return sp ? sp : calcDelay(selR);
 }
 
+/******************************************************************************/
+/*                             S e l b y H a s h                              */
+/******************************************************************************/
+
+// Caller must hold a snapshot reader. The returned node, if any, is unlocked.
+// The candidates are screened as for load based selection and the file then
+// goes to its highest ranking candidate that is not over its share of recent
+// selections (see XrdCmsHRW.hh).
+
+XrdCmsNode *XrdCmsCluster::SelbyHash(const NodeSnap &snap, SMask_t mask,
+                                     XrdCmsSelector &selR,
+                                     unsigned long long fileKey)
+{
+    XrdCmsNode *np, *sp, *cand[STMax];
+    long long now = XrdCmsP2C::Now(), hLife = Config.P2CDecay * 1000000LL;
+    long long totWeight = 0;
+    bool reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
+    int i, n = 0, totRecent = 0, recent[STMax], weight[STMax];
+
+// Scan for candidate nodes (preset possible, suspended, overloaded, full, and
+// dead). A node's weight is its total space in GB when so configured.
+//
+   selR.Reset(); SelTcnt++;
+   for (i = 0; i <= snap.Hi; i++)
+       if ((np = snap.Tab[i]) && (np->NodeMask & mask))
+          {if (!(selR.needNet & np->hasNet))      {selR.xNoNet= true; continue;}
+           selR.nPick++;
+           if (np->isOffline)                     {selR.xOff  = true; continue;}
+           if (np->isBad)                         {selR.xSusp = true; continue;}
+           if (np->myLoad > Config.MaxLoad)       {selR.xOvld = true; continue;}
+           if (selR.needSpace && (np->DiskFree < np->DiskMinF
+                                  || (reqSS && np->isNoStage)))
+              {selR.xFull = true; continue;}
+           recent[n] = np->selRecent.Count(now, hLife);
+           weight[n] = (Config.sched_HashW && np->DiskTotal
+                     ? static_cast<int>(np->DiskTotal) : 1);
+           totRecent += recent[n]; totWeight += weight[n];
+           cand[n++] = np;
+          }
+
+// Pick the file's node. Concurrent selections may see slightly stale recent
+// counts but they only serve to bound the load.
+//
+   if (!n) return calcDelay(selR);
+   auto node = [&](int k) {return cand[k]->hrwKey;};
+   auto wght = [&](int k) {return weight[k];};
+   auto full = [&](int k) {return XrdCmsHRW::Full(recent[k], weight[k],
+                                                  totRecent, totWeight,
+                                                  Config.HashLoad);};
+   sp = cand[XrdCmsHRW::Pick(n, fileKey, node, wght, full)];
+
+// Account for the selection and return the node
+//
+   sp->selRecent.Count(now, hLife, 1);
+   RefCount(sp, n > 1, selR.needSpace);
+   return sp;
+}
+
+/******************************************************************************/
+/*                              S e l b y P 2 C                               */
+/******************************************************************************/
+
+// Caller must hold a snapshot reader. The returned node, if any, is unlocked.
+// The candidates are screened as for load based selection and two of them are
+// then compared using the feedback score (see XrdCmsP2C.hh).
+
+XrdCmsNode *XrdCmsCluster::SelbyP2C(const NodeSnap &snap, SMask_t mask,
+                                    XrdCmsSelector &selR)
+{
+    static thread_local std::minstd_rand rng(std::random_device{}());
+    XrdCmsNode *np, *sp, *cand[STMax];
+    long long now = XrdCmsP2C::Now(), hLife = Config.P2CDecay * 1000000LL;
+    bool reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
+    long long latSum = 0;
+    int i, n = 0, latCnt = 0, load[STMax], lat[STMax];
+
+// Scan for candidate nodes (preset possible, suspended, overloaded, full, and
+// dead). The load only counts if load reports are requested. The latency of
+// the candidates that were timed is summed to score those that were not.
+//
+   selR.Reset(); SelTcnt++;
+   for (i = 0; i <= snap.Hi; i++)
+       if ((np = snap.Tab[i]) && (np->NodeMask & mask))
+          {if (!(selR.needNet & np->hasNet))      {selR.xNoNet= true; continue;}
+           selR.nPick++;
+           if (np->isOffline)                     {selR.xOff  = true; continue;}
+           if (np->isBad)                         {selR.xSusp = true; continue;}
+           if (!Config.sched_RR && np->myLoad > Config.MaxLoad)
+              {selR.xOvld = true; continue;}
+           if (selR.needSpace && (np->DiskFree < np->DiskMinF
+                                  || (reqSS && np->isNoStage)))
+              {selR.xFull = true; continue;}
+           load[n] = (Config.sched_RR ? 0
+                   : (selR.needSpace ? np->myMass : np->myLoad));
+           if ((lat[n] = np->rspLat)) {latSum += lat[n]; latCnt++;}
+           cand[n++] = np;
+          }
+
+// Pick between two of the candidates. The redirect count is decayed as a side
+// effect.
+//
+   if (!n) return calcDelay(selR);
+   auto score = [&](int k)
+               {int cnt = cand[k]->selRecent.Count(now, hLife);
+                return XrdCmsP2C::Score(XrdCmsP2C::Latency(lat[k], latSum,
+                                                           latCnt),
+                                        cnt, load[k]);
+               };
+   sp = cand[(n == 1 ? 0 : XrdCmsP2C::Pick(n, rng, score))];
+
+// Account for the selection and return the node
+//
+   sp->selRecent.Count(now, hLife, 1);
+   RefCount(sp, n > 1, selR.needSpace);
+   return sp;
+}
+
 /******************************************************************************/
 /*                              S e l b y R e f                               */
 /******************************************************************************/
 
-// Caller must have the STMutex locked. The returned node, if any, is unlocked.
+// Caller must hold a snapshot reader. The returned node, if any, is unlocked.
 
-XrdCmsNode *XrdCmsCluster::SelbyRef(SMask_t mask, XrdCmsSelector &selR)
+XrdCmsNode *XrdCmsCluster::SelbyRef(const NodeSnap &snap, SMask_t mask,
+                                    XrdCmsSelector &selR)
 {
     XrdCmsNode *np, *sp = 0;
     bool Multi = false, reqSS = (selR.needSpace & XrdCmsNode::allowsSS) != 0;
@@ -1908,8 +2201,8 @@ XrdCmsNode *XrdCmsCluster::SelbyRef(SMask_t mask, XrdCmsSelector &selR)
 // Scan for a node (sp points to the selected one)
 //
    selR.Reset(); SelTcnt++;
-   for (int i = 0; i <= STHi; i++)
-       if ((np = NodeTab[i]) && (np->NodeMask & mask))
+   for (int i = 0; i <= snap.Hi; i++)
+       if ((np = snap.Tab[i]) && (np->NodeMask & mask))
           {if (!(selR.needNet & np->hasNet))    {selR.xNoNet= true; continue;}
            selR.nPick++;
            if (np->isOffline)                   {selR.xOff  = true; continue;}
@@ -1944,7 +2237,7 @@ int XrdCmsCluster::SelDFS(XrdCmsSelect &Sel, SMask_t amask,
                           SMask_t &pmask, SMask_t &smask, int isRW)
 {
    EPNAME("SelDFS");
-   static const SMask_t allNodes(~0);
+   static const SMask_t allNodes(FULLMASK);
    int oldOpts, rc;
 
 // The first task is to find out if the file exists somewhere. If we are doing
@@ -1996,6 +2289,45 @@ int XrdCmsCluster::SelDFS(XrdCmsSelect &Sel, SMask_t amask,
    return 1;
 }
 
+/******************************************************************************/
+/*                               S e l T i m e                                */
+/******************************************************************************/
+
+// Record the time a selection took in the selection latency histogram and
+// report latency percentiles from it.
+
+void XrdCmsCluster::SelPctl(long long pVal[3])
+{
+   static const int pctl[3] = {50, 90, 99};
+   long long hist[SelLatN], tot = 0, sum;
+   int i, j;
+
+// Take a copy of the histogram as it may be updated while we look at it
+//
+   for (i = 0; i < SelLatN; i++) tot += (hist[i] = SelLat[i]);
+
+// Report the upper bound, in microseconds, of the bucket holding each
+// percentile. Nothing is reported if no selections have been made.
+//
+   for (j = 0; j < 3; j++)
+       {pVal[j] = 0;
+        if (!tot) continue;
+        for (i = 0, sum = 0; i < SelLatN; i++)
+            if ((sum += hist[i])*100 >= tot*pctl[j]) break;
+        pVal[j] = 1LL << (i < SelLatN ? i : SelLatN-1);
+       }
+}
+
+/******************************************************************************/
+
+void XrdCmsCluster::SelTime(long long usec)
+{
+   int i = 0;
+
+   while(i < SelLatN-1 && usec >= (1LL << i)) i++;
+   SelLat[i]++;
+}
+
 /******************************************************************************/
 /*                             s e n d A L i s t                              */
 /******************************************************************************/
@@ -2070,6 +2402,25 @@ void XrdCmsCluster::setAltMan(int snum, XrdLink *lp, int port)
    if (ap >= AltMend) {AltMend = ap + AltSize; AltMent = snum;}
 }
 
+/******************************************************************************/
+/*                           S n a p P u b l i s h                            */
+/******************************************************************************/
+
+// Warning: STMutex must be held in write mode by the caller! Upon return no
+//          selection can see a node that is no longer in the node table.
+
+void XrdCmsCluster::SnapPublish()
+{
+   NodeSnap newSnap;
+
+   for (int i = 0; i <= STHi; i++) newSnap.Tab[i] = NodeTab[i];
+   newSnap.peerHost = peerHost;
+   newSnap.peerMask = peerMask;
+   newSnap.Hi       = STHi;
+   newSnap.NodeCnt  = NodeCnt;
+   SelSnap.Publish(newSnap);
+}
+
 /******************************************************************************/
 /*                           U n r e a c h a b l e                            */
 /******************************************************************************/
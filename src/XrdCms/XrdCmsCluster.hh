@@ -35,6 +35,7 @@
 #include <strings.h>
 #include <netinet/in.h>
   
+#include "XrdCms/XrdCmsSnapshot.hh"
 #include "XrdCms/XrdCmsTypes.hh"
 #include "XrdOuc/XrdOucTList.hh"
 #include "XrdOuc/XrdOucEnum.hh"
@@ -107,6 +108,7 @@ int       sUtil;    // Average utilization (largest one)
 // This a single-instance global class
 //
 class XrdCmsBaseFR;
+class XrdCmsBloom;
 class XrdCmsClustID;
 class XrdCmsSelected;
 class XrdOucTList;
@@ -169,6 +171,14 @@ void           *MonPerf();
 //
 void           *MonRefs();
 
+// Sends a file state query to all nodes matching smask. When batching is in
+// effect the query is coalesced with others headed to the same node. When the
+// p2c policy is in effect the query may be timed. Like Broadcast(), the mask
+// of nodes that could not be queried is returned.
+//
+SMask_t         Query(SMask_t smask, XrdCms::CmsRRHdr &Hdr,
+                      void *Data,    int Dlen);
+
 // Return total number of redirect references
 //
 long long       Refs() {return SelWtot+SelRtot;}
@@ -209,6 +219,17 @@ void            SLock(bool dolock, bool wrmode=true)
 //
 void            Space(XrdCms::SpaceData &sData, SMask_t smask);
 
+// Manage the namespace summaries nodes send us (see XrdCmsSummary). SumAdd()
+// adds a file to the node's filter and SumInstall() replaces the filter with
+// a new one. SumSkip() returns the nodes in qmask whose current filter says
+// that they do not have the file and, in sumMask, those having a current one.
+//
+void            SumAdd(XrdCmsNode *nP, const char *path);
+
+void            SumInstall(XrdCmsNode *nP, XrdCmsBloom *bP);
+
+SMask_t         SumSkip(SMask_t qmask, const char *path, SMask_t &sumMask);
+
 // Called to return statistics
 //
 int             Stats(char *bfr, int bln); // Server
@@ -218,6 +239,23 @@ int             Statt(char *bfr, int bln); // Manager
 virtual        ~XrdCmsCluster() {} // This object should never be deleted
 
 private:
+
+// The selection paths work off a snapshot of the node table so that they need
+// not take the STMutex. The snapshot is republished, with the STMutex held in
+// write mode, whenever the table, the peer mask, or the node count changes.
+// Nodes in the snapshot are unlocked; a reader must Ref() a node before it
+// lets go of the snapshot if it needs the node afterwards.
+//
+struct NodeSnap
+      {XrdCmsNode *Tab[STMax];
+       SMask_t     peerHost;
+       SMask_t     peerMask;
+       int         Hi;
+       int         NodeCnt;
+       NodeSnap() : peerHost(0), peerMask(FULLMASK), Hi(-1), NodeCnt(0)
+                  {for (int i = 0; i < STMax; i++) Tab[i] = 0;}
+      };
+
 XrdCmsNode *AddAlt(XrdCmsClustID *cidP, XrdLink *lp, int port, int Status,
                    int sport, const char *theNID, const char *theIF);
 XrdCmsNode *calcDelay(XrdCmsSelector &selR);
@@ -228,10 +266,16 @@ int         Multiple(SMask_t mVec);
 enum        {eExists, eDups, eROfs, eNoRep, eNoSel, eNoEnt}; // Passed to SelFail
 int         SelFail(XrdCmsSelect &Sel, int rc);
 int         SelNode(XrdCmsSelect &Sel, SMask_t  pmask, SMask_t  amask);
-XrdCmsNode *SelbyCost(SMask_t, XrdCmsSelector &selR);
-XrdCmsNode *SelbyLoad(SMask_t, XrdCmsSelector &selR);
-XrdCmsNode *SelbyLoadR(SMask_t, XrdCmsSelector &selR);
-XrdCmsNode *SelbyRef (SMask_t, XrdCmsSelector &selR);
+XrdCmsNode *SelbyCost(const NodeSnap &, SMask_t, XrdCmsSelector &selR);
+XrdCmsNode *SelbyLoad(const NodeSnap &, SMask_t, XrdCmsSelector &selR);
+XrdCmsNode *SelbyLoadR(const NodeSnap &, SMask_t, XrdCmsSelector &selR);
+XrdCmsNode *SelbyHash(const NodeSnap &, SMask_t, XrdCmsSelector &selR,
+                      unsigned long long fileKey);
+XrdCmsNode *SelbyP2C (const NodeSnap &, SMask_t, XrdCmsSelector &selR);
+XrdCmsNode *SelbyRef (const NodeSnap &, SMask_t, XrdCmsSelector &selR);
+void        SelPctl(long long pVal[3]);
+void        SelTime(long long usec);
+void        SnapPublish();
 int         SelDFS(XrdCmsSelect &Sel, SMask_t amask,
                    SMask_t &pmask, SMask_t &smask, int isRW);
 void        sendAList(XrdLink *lp);
@@ -245,13 +289,23 @@ static const  int AltSize = 254; // We may revert to IP address
 
 XrdSysRWLock  STMutex;          // Protects all node information  variables
 XrdCmsNode   *NodeTab[STMax];   // Current  set of nodes
-int           NodeWeight[STMax]; // Current set of load balancing weights
+XrdCmsSnapshot<NodeSnap> SelSnap; // Lock-free copy of the above for selection
 
 int           STHi;             // NodeTab high watermark
 int           Reserved;
 RAtomic_llong SelWtot;          // Total number of r/w selections (successful)
 RAtomic_llong SelRtot;          // Total number of r/o selections (successful)
 RAtomic_llong SelTcnt;          // Total number of all selections
+RAtomic_llong SumQskip;         // Queries not sent due to a summary
+RAtomic_llong SumDirect;        // Selections made without waiting for a query
+RAtomic_llong SumNil;           // Lookups where summaries ruled out every node
+RAtomic_bool  SumSeen;          // True once any node has sent a summary
+
+// Selection latency histogram. Bucket i counts selections that took less than
+// 2**i microseconds; the last bucket counts everything else.
+//
+static const int SelLatN = 16;
+RAtomic_llong SelLat[SelLatN];
 
 // The following is a list of IP:Port tokens that identify supervisor nodes.
 // The information is sent via the try request to redirect nodes; as needed.
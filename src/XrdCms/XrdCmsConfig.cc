@@ -51,6 +51,7 @@
 
 #include "XrdCms/XrdCmsAdmin.hh"
 #include "XrdCms/XrdCmsBaseFS.hh"
+#include "XrdCms/XrdCmsBatch.hh"
 #include "XrdCms/XrdCmsBlackList.hh"
 #include "XrdCms/XrdCmsCache.hh"
 #include "XrdCms/XrdCmsCluster.hh"
@@ -66,6 +67,7 @@
 #include "XrdCms/XrdCmsSecurity.hh"
 #include "XrdCms/XrdCmsSelect.hh"
 #include "XrdCms/XrdCmsState.hh"
+#include "XrdCms/XrdCmsSummary.hh"
 #include "XrdCms/XrdCmsSupervisor.hh"
 #include "XrdCms/XrdCmsTrace.hh"
 #include "XrdCms/XrdCmsUtils.hh"
@@ -550,6 +552,7 @@ int XrdCmsConfig::ConfigXeq(char *var, XrdOucStream &CFile, XrdSysError *eDest)
    TS_Xeq("adminpath",     xapath);  // Any,     non-dynamic
    TS_Xeq("allow",         xallow);  // Manager, non-dynamic
    TS_Xeq("altds",         xaltds);  // Server,  non-dynamic
+   TS_Xeq("batch",         xbatch);  // Any,     non-dynamic
    TS_Xeq("blacklist",     xblk);    // Manager, non-dynamic
    TS_Xeq("cidtag",        xcid);    // Any,     non-dynamic
    TS_Xeq("defaults",      xdefs);   // Server,  non-dynamic
@@ -570,6 +573,7 @@ int XrdCmsConfig::ConfigXeq(char *var, XrdOucStream &CFile, XrdSysError *eDest)
    TS_Xeq("role",          xrole);   // Server,  non-dynamic
    TS_Xeq("seclib",        xsecl);   // Server,  non-dynamic
    TS_Xeq("subcluster",    xsubc);   // Manager, non-dynamic
+   TS_Xeq("summary",       xsummary);// Server,  non-dynamic
    TS_Xeq("superport",     xsupp);   // Super,   non-dynamic
    TS_Xeq("vnid",          xvnid);   // Server,  non-dynamic
    TS_Set("wait",          doWait);  // Server,  non-dynamic (backward compat)
@@ -625,6 +629,16 @@ void XrdCmsConfig::DoIt()
                              (void *)0, 0, "Prep handler"))
       Say.Emsg("cmsd", errno, "start prep handler");
 
+// Start message batching if so wanted
+//
+   if (BatchWin && Batch.Init(BatchWin, BatchMax))
+      Say.Emsg("cmsd", errno, "start message batcher");
+
+// Start sending namespace summaries if so wanted and we have a namespace
+//
+   if (SumInt && DiskOK && ossFS && (errno = Summary.Init(SumInt, SumBits)))
+      Say.Emsg("cmsd", errno, "start namespace summary");
+
 // Start the supervisor subsystem
 //
    if (XrdCmsSupervisor::superOK)
@@ -712,6 +726,10 @@ void XrdCmsConfig::ConfigDefaults(void)
    LUPDelay = 5;
    QryDelay =-1;
    QryMinum = 0;
+   BatchWin = 0;
+   BatchMax = 64;
+   SumInt   = 0;
+   SumBits  = 10;
    LUPHold  = 178;
    DELDelay = 960;  // 15 minutes
    DRPDelay = 10*60;
@@ -755,6 +773,7 @@ void XrdCmsConfig::ConfigDefaults(void)
    myPaths  = (char *)""; // Default is 'r /'
    ConfigFN = 0;
    sched_RR = sched_Pack = sched_AffPC = sched_Level = sched_LoadR = 0; sched_Force = 1;
+   sched_P2C = sched_Hash = sched_HashW = 0;
    isManager= 0;
    isMeta   = 0;
    isPeer   = 0;
@@ -804,6 +823,8 @@ void XrdCmsConfig::ConfigDefaults(void)
    doWait   = 1;
    RefReset = 60*60;
    RefTurn  = 3*STMax*(DiskLinger+1);
+   P2CDecay = 4;
+   HashLoad = 25;
    DirFlags    = 0;
    blkList     = 0;
    blkChk      = 0;
@@ -1129,6 +1150,20 @@ int XrdCmsConfig::setupManager()
       {Say.Say("Config round robin scheduling in effect.");
        sched_Level = 0;
       }
+   if (sched_P2C)
+      {if (P2CDecay < 1) P2CDecay = 1;
+       Say.Say("Config p2c scheduling in effect; redirect counts halve every ",
+               std::to_string(P2CDecay).c_str(), "s.");
+      }
+   if (sched_Hash)
+      {if (P2CDecay < 1) P2CDecay = 1;
+       if (sched_P2C)
+          {Say.Say("Config warning: p2c scheduling overrides hash scheduling.");
+           sched_Hash = 0;
+          } else Say.Say("Config hash scheduling in effect; nodes may take ",
+                         std::to_string(HashLoad).c_str(),
+                         "% over their share", (sched_HashW ? " by space." : "."));
+      }
 
 // Create statistical monitoring thread
 //
@@ -1428,6 +1463,54 @@ int XrdCmsConfig::xapath(XrdSysError *eDest, XrdOucStream &CFile)
    return 0;
 }
 
+/******************************************************************************/
+/*                                x b a t c h                                 */
+/******************************************************************************/
+
+/* Function: xbatch
+
+   Purpose:  To parse the directive: batch <ms> [max <n>]
+
+             <ms>      the number of milliseconds to coalesce file state queries
+                       and responses headed to the same node before sending
+                       them in a single write. Zero turns batching off.
+             <n>       the maximum number of messages in a batch. A batch is
+                       sent as soon as it is full.
+
+   Defaults: 0 max 64
+
+  Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdCmsConfig::xbatch(XrdSysError *eDest, XrdOucStream &CFile)
+{
+    char *val;
+    int  ival;
+
+//  Get the window
+//
+    if (!(val = CFile.GetWord()))
+       {eDest->Emsg("Config","batch window not specified"); return 1;}
+    if (XrdOuca2x::a2i(*eDest,"batch window",val,&ival,0,1000)) return 1;
+    BatchWin = ival;
+
+// Now scan for the other options
+//
+   while((val = CFile.GetWord()) && *val)
+        {if (!strcmp(val, "max"))
+            {if (!(val = CFile.GetWord()) || !*val)
+                {eDest->Emsg("Config","batch max argument not specified");
+                 return 1;
+                }
+             if (XrdOuca2x::a2i(*eDest,"batch max",val,&ival,1,4096)) return 1;
+             BatchMax = ival;
+            }
+            else eDest->Say("Config warning: ignoring invalid batch option '",
+                            val,"'.");
+        }
+   return 0;
+}
+
 /******************************************************************************/
 /*                                  x b l k                                   */
 /******************************************************************************/
@@ -2652,6 +2735,8 @@ int XrdCmsConfig::xrole(XrdSysError *eDest, XrdOucStream &CFile)
                                        [nomultisrc[@<host>:<port>]]
                 [affinity [default] {none | weak | strong | strict}]
                 [affpath {all | first m | last n}]
+                [p2c] [p2cdecay <sec>]
+                [hash] [hashload <pct>] [hashweight {equal | space}]
 
              <p>      is the percentage to include in the load as a value
                       between 0 and 100. For fuzz this is the largest
@@ -2663,6 +2748,23 @@ int XrdCmsConfig::xrole(XrdSysError *eDest, XrdOucStream &CFile)
                       metamanager (i.e. global share). The gsdflt is the
                       default to be used by the metamanager.
 
+             p2c      selects the node by comparing two eligible nodes chosen at
+                      random using each node's state query response time and
+                      number of recent redirects (and load, if reported).
+                      p2cdecay is the number of seconds it takes for a node's
+                      recent redirect count to halve (default 4).
+
+             hash     selects the node by rendezvous hashing the file name with
+                      each eligible node's host name and port so that a file
+                      keeps going to the same node (e.g. a cache) and only the
+                      files of a node that comes or goes are remapped. A node
+                      that took more than hashload percent (default 25) over
+                      its share of the recent redirects is passed over for the
+                      next node in the file's ranking. Recent redirects decay
+                      as given by p2cdecay. With hashweight space a node's
+                      share is proportional to its total disk space; the
+                      default is equal shares.
+
    Type: Any, dynamic.
 
    Output: retc upon success or -EINVAL upon failure.
@@ -2686,6 +2788,8 @@ int XrdCmsConfig::xsched(XrdSysError *eDest, XrdOucStream &CFile)
         {"space",    100, &P_dsk},
         {"maxload",  100, &MaxLoad},
         {"refreset", -1,  &RefReset},
+        {"p2cdecay", -1,  &P2CDecay},
+        {"hashload", 1000,&HashLoad},
         {"affinity", -2,  0},
         {"affpath",  -3,  0},
         {"tryhname",   1, &V_hntry}
@@ -2818,6 +2922,27 @@ int XrdCmsConfig::xschedx(char *val, XrdSysError *eDest, XrdOucStream &CFile)
        return 0;
       }
 
+// Check for feedback based selection
+//
+   if (!strcmp(val, "p2c")) {sched_P2C = 1; return 0;}
+
+// Check for hash based selection and its weighting
+//
+   if (!strcmp(val, "hash")) {sched_Hash = 1; return 0;}
+
+   if (!strcmp(val, "hashweight"))
+      {if (!(val = CFile.GetWord()))
+          {eDest->Emsg("Config","sched ","hashweight argument not specified.");
+           return -1;
+          }
+            if (!strcmp(val, "equal")) sched_HashW = 0;
+       else if (!strcmp(val, "space")) sched_HashW = 1;
+       else {eDest->Emsg("Config", "invalid sched hashweight -", val);
+             return -1;
+            }
+       return 0;
+      }
+
 // Check for unqualified nomultisrc
 //
    if (!strcmp(val, "nomultisrc"))
@@ -3111,6 +3236,67 @@ int XrdCmsConfig::xsubc(XrdSysError *eDest, XrdOucStream &CFile)
    return (XrdCmsUtils::ParseMan(eDest, &SanList, hSpec, hPort) ? 0 : 1);
 }
   
+/******************************************************************************/
+/*                              x s u m m a r y                               */
+/******************************************************************************/
+
+/* Function: xsummary
+
+   Purpose:  To parse the directive: summary {off | every <sec>} [bits <n>]
+
+             off       does not send namespace summaries (the default).
+             <sec>     the time (seconds, M, H) between walks of the exported
+                       namespace. A Bloom filter of the files found is sent to
+                       each manager after every walk and whenever we log in.
+                       Managers then need not query us about files we do not
+                       have. Files created in between are added via the admin
+                       interface; deleted ones linger until the next walk.
+             <n>       the number of filter bits per file (4 to 32). More bits
+                       mean fewer false hits at the cost of a larger filter.
+
+   Defaults: off bits 10
+
+   Type: Server only, non-dynamic.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdCmsConfig::xsummary(XrdSysError *eDest, XrdOucStream &CFile)
+{
+    char *val;
+    int  ival;
+
+//  Get the interval
+//
+    if (!(val = CFile.GetWord()))
+       {eDest->Emsg("Config","summary interval not specified"); return 1;}
+    if (!strcmp(val, "off")) SumInt = 0;
+       else {if (strcmp(val, "every") || !(val = CFile.GetWord()))
+                {eDest->Emsg("Config","summary interval not specified");
+                 return 1;
+                }
+             if (XrdOuca2x::a2tm(*eDest,"summary interval",val,&ival,10))
+                return 1;
+             SumInt = ival;
+            }
+
+// Now scan for the other options
+//
+   while((val = CFile.GetWord()) && *val)
+        {if (!strcmp(val, "bits"))
+            {if (!(val = CFile.GetWord()) || !*val)
+                {eDest->Emsg("Config","summary bits argument not specified");
+                 return 1;
+                }
+             if (XrdOuca2x::a2i(*eDest,"summary bits",val,&ival,4,32)) return 1;
+             SumBits = ival;
+            }
+            else eDest->Say("Config warning: ignoring invalid summary option '",
+                            val,"'.");
+        }
+   return 0;
+}
+
 /******************************************************************************/
 /*                                 x s u p p                                  */
 /******************************************************************************/
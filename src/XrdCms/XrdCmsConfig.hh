@@ -89,6 +89,8 @@ int         MaxRetries;   // Maximum number of non-DFS select retries
 int         MsgTTL;       // Maximum msg lifetime
 int         RefReset;     // Min seconds    before a global ref count reset
 int         RefTurn;      // Min references before a global ref count reset
+int         P2CDecay;     // Seconds for a p2c redirect count to halve
+int         HashLoad;     // Percent over its share a hash node may take
 int         AskPerf;      // Seconds between perf queries
 int         AskPing;      // Number of ping requests per AskPerf window
 int         PingTick;     // Ping clock value
@@ -111,6 +113,10 @@ int         P_pag;        // % PAG Capacity in load factor
 char        DoMWChk;      // When true (default) perform multiple write check
 char        DoHnTry;      // When true (default) use hostnames for try redirs
 char        nbSQ;         // Non-blocking send queue handling option
+int         BatchWin;     // Milliseconds to coalesce queries (0 -> off)
+int         BatchMax;     // Maximum number of messages per batch
+int         SumInt;       // Seconds between namespace summaries (0 -> off)
+int         SumBits;      // Summary filter bits per file
 char        MultiSrc;     // Allow retries via 'tried=' and 'cms.sadd' cgi
 
 int         DiskMin;      // Minimum MB needed of space in a partition
@@ -133,6 +139,9 @@ char        sched_AffPC;  // Affinity path component count (-255 <= n <= 255)
 char        sched_Level;  // 1 -> Use load-based level for "pack" selection
 char        sched_Force;  // 1 -> Client cannot select mode
 char        sched_LoadR;  // 1 -> Use randomized load-based weighting for selection
+char        sched_P2C;    // 1 -> Use feedback and two random choices for selection
+char        sched_Hash;   // 1 -> Use rendezvous hashing of the path for selection
+char        sched_HashW;  // 1 -> Weigh hash selection by node disk space
 int         doWait;       // 1 -> Wait for a data end-point
 
 int         adsPort;      // Alternate server port
@@ -226,6 +235,7 @@ int  xapath(XrdSysError *edest, XrdOucStream &CFile);
 int  xallow(XrdSysError *edest, XrdOucStream &CFile);
 int  xaltds(XrdSysError *edest, XrdOucStream &CFile);
 int  Fsysadd(XrdSysError *edest, int chk, char *fn);
+int  xbatch(XrdSysError *edest, XrdOucStream &CFile);
 int  xblk(XrdSysError *edest, XrdOucStream &CFile, bool iswl=false);
 int  xcid(XrdSysError *edest, XrdOucStream &CFile);
 int  xdelay(XrdSysError *edest, XrdOucStream &CFile);
@@ -253,6 +263,7 @@ bool xschedy(char *val, XrdSysError *eDest, char *&host, int &hlen, int &port);
 int  xsecl(XrdSysError *edest, XrdOucStream &CFile);
 int  xspace(XrdSysError *edest, XrdOucStream &CFile);
 int  xsubc(XrdSysError *edest, XrdOucStream &CFile);
+int  xsummary(XrdSysError *edest, XrdOucStream &CFile);
 int  xsupp(XrdSysError *edest, XrdOucStream &CFile);
 int  xtrace(XrdSysError *edest, XrdOucStream &CFile);
 int  xvnid(XrdSysError *edest, XrdOucStream &CFile);
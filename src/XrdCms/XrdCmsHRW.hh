@@ -0,0 +1,111 @@
+#ifndef XRDCMSHRW__H
+#define XRDCMSHRW__H
+/******************************************************************************/
+/*                                                                            */
+/*                          X r d C m s H R W . h h                           */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <cmath>
+
+// XrdCmsHRW holds the arithmetic behind the "hash" selection policy. It uses
+// weighted rendezvous (highest random weight) hashing: every node scores each
+// file by hashing the file name together with the node's host name and port,
+// and the file goes to the highest scoring node. When a node leaves, only the
+// files it owned move and they spread over the remaining nodes; when it comes
+// back (even after a restart) it gets the very same files back. A node's
+// weight scales its share of files. To bound load, a node that has already
+// taken more than its share of recent selections is passed over in favour of
+// the next node in the file's ranking. The functions are kept free of cluster
+// state so that they can be tested on their own.
+//
+namespace XrdCmsHRW
+{
+// Return the 64-bit FNV-1a hash of a name and, optionally, a port number.
+//
+inline unsigned long long Hash(const char *name, int port=0)
+          {unsigned long long h = 0xcbf29ce484222325ULL;
+           while(*name)
+                {h ^= static_cast<unsigned char>(*name++);
+                 h *= 0x100000001b3ULL;
+                }
+           for (int i = 0; port && i < 2; i++, port >>= 8)
+               {h ^= static_cast<unsigned char>(port & 0xff);
+                h *= 0x100000001b3ULL;
+               }
+           return h;
+          }
+
+// Combine a file hash and a node hash into a well mixed 64-bit value
+// (splitmix64 finalizer).
+//
+inline unsigned long long Mix(unsigned long long file, unsigned long long node)
+          {unsigned long long z = file ^ (node * 0x9e3779b97f4a7c15ULL);
+           z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+           z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+           return z ^ (z >> 31);
+          }
+
+// Score a node for a file; higher is better. The mixed hash is mapped to a
+// uniform value u in (0,1) and the score is weight / -ln(u), which makes the
+// chance of a node winning proportional to its weight.
+//
+inline double Score(unsigned long long file, unsigned long long node,
+                    int weight)
+          {double u = (static_cast<double>(Mix(file, node) >> 11) + 0.5)
+                    * (1.0 / 9007199254740992.0);
+           return (weight < 1 ? 1 : weight) / -std::log(u);
+          }
+
+// Return true if a node has taken more than its bounded share of the recent
+// selections. The share is the node's fraction of the total weight of the
+// candidates times the recent selections plus this one, inflated by the
+// allowed overload percentage.
+//
+inline bool Full(int recent, int weight, int totRecent, long long totWeight,
+                 int overPct)
+          {if (totWeight <= 0) return false;
+           double share = (static_cast<double>(totRecent) + 1.0)
+                        * (weight < 1 ? 1 : weight) / totWeight
+                        * (100 + overPct) / 100.0;
+           return recent + 1 > std::ceil(share);
+          }
+
+// Pick one of n candidates, 0 to n-1: the highest scoring one that is not
+// full or, if all are full, the highest scoring one. Return -1 if there are
+// no candidates.
+//
+template<class NodeF, class WeightF, class FullF>
+int         Pick(int n, unsigned long long file, NodeF node, WeightF weight,
+                 FullF full)
+          {int best = -1, top = -1;
+           double bScore = 0.0, tScore = 0.0;
+           for (int k = 0; k < n; k++)
+               {double s = Score(file, node(k), weight(k));
+                if (top < 0 || s > tScore) {top = k; tScore = s;}
+                if ((best < 0 || s > bScore) && !full(k))
+                   {best = k; bScore = s;}
+               }
+           return (best >= 0 ? best : top);
+          }
+}
+#endif
@@ -54,39 +54,29 @@ void XrdCmsKey::setHash()
 /******************************************************************************/
 /*                   C l a s s   X r d C m s K e y I t e m                    */
 /******************************************************************************/
-/******************************************************************************/
-/*                           S t a t i c   D a t a                            */
-/******************************************************************************/
-  
-XrdCmsKeyItem *XrdCmsKeyItem::TockTable[TickRate] = {0};
-XrdCmsKeyItem *XrdCmsKeyItem::Free    = 0;
-int            XrdCmsKeyItem::numFree = 0;
-int            XrdCmsKeyItem::numHave = 0;
-int            XrdCmsKeyItem::numNull = 0;
-
 /******************************************************************************/
 /* static public                   A l l o c                                  */
 /******************************************************************************/
   
-XrdCmsKeyItem *XrdCmsKeyItem::Alloc(unsigned int theTock)
+XrdCmsKeyItem *XrdCmsKeyItem::Alloc(XrdCmsKeyPool &Pool, unsigned int theTock)
 {
   XrdCmsKeyItem *kP;
 
 // Try to allocate an existing item or replenish the list
 //
-   do {if ((kP = Free))
-          {Free = kP->Next;
-           numFree--;
+   do {if ((kP = Pool.Free))
+          {Pool.Free = kP->Next;
+           Pool.numFree--;
            theTock &= TickMask;
            kP->Key.TOD    = theTock;
-           kP->Key.TODRef = TockTable[theTock];
-           TockTable[theTock] = kP;
+           kP->Key.TODRef = Pool.TockTable[theTock];
+           Pool.TockTable[theTock] = kP;
            if (!(kP->Key.Ref++)) kP->Key.Ref = 1;
             kP->Loc.roPend = kP->Loc.rwPend = 0;
            return kP;
           }
-       numNull++;
-       } while(Replenish());
+       Pool.numNull++;
+       } while(Replenish(Pool));
 
 // We failed
 //
@@ -98,7 +88,7 @@ XrdCmsKeyItem *XrdCmsKeyItem::Alloc(unsigned int theTock)
 /* public                        R e c y c l e                                */
 /******************************************************************************/
   
-void XrdCmsKeyItem::Recycle()
+void XrdCmsKeyItem::Recycle(XrdCmsKeyPool &Pool)
 {
    static char *noKey = (char *)"";
 
@@ -109,26 +99,26 @@ void XrdCmsKeyItem::Recycle()
 
 // Put entry on the free list
 //
-   Next = Free; Free = this;
-   numFree++;
+   Next = Pool.Free; Pool.Free = this;
+   Pool.numFree++;
 }
 
 /******************************************************************************/
 /* public                         R e l o a d                                 */
 /******************************************************************************/
   
-void XrdCmsKeyItem::Reload()
+void XrdCmsKeyItem::Reload(XrdCmsKeyPool &Pool)
 {
    Key.TOD &= static_cast<unsigned char>(TickMask);
-   Key.TODRef = TockTable[Key.TOD];
-   TockTable[Key.TOD] = this;
+   Key.TODRef = Pool.TockTable[Key.TOD];
+   Pool.TockTable[Key.TOD] = this;
 }
 
 /******************************************************************************/
 /* static public               R e p l e n i s h                              */
 /******************************************************************************/
 
-int XrdCmsKeyItem::Replenish()
+int XrdCmsKeyItem::Replenish(XrdCmsKeyPool &Pool)
 {
    EPNAME("Replenish");
    XrdCmsKeyItem *kP;
@@ -137,39 +127,41 @@ int XrdCmsKeyItem::Replenish()
 // Allocate a quantum of free elements and chain them into the free list
 //
    if (!(kP = new XrdCmsKeyItem[minAlloc])) return 0;
-   DEBUG("old free " <<numFree <<" + " <<minAlloc <<" = " <<numHave+minAlloc);
+   DEBUG("old free " <<Pool.numFree <<" + " <<minAlloc <<" = "
+                     <<Pool.numHave+minAlloc);
 
 // We would do this in an initializer but that causes problems when alloacting
 // temporary items on the stack. So, manually put these on the free list.
 //
    i = minAlloc;
-   while(i--) {kP->Next = Free; Free = kP; kP++;}
+   while(i--) {kP->Next = Pool.Free; Pool.Free = kP; kP++;}
   
 // Return the number we have free
 //
-   numHave += minAlloc;
-   numFree += minAlloc;
-   return numFree;
+   Pool.numHave += minAlloc;
+   Pool.numFree += minAlloc;
+   return Pool.numFree;
 }
 
 /******************************************************************************/
 /* static public                   S t a t s                                  */
 /******************************************************************************/
 
-void XrdCmsKeyItem::Stats(int &isAlloc, int &isFree, int &wasNull)
+void XrdCmsKeyItem::Stats(XrdCmsKeyPool &Pool,
+                          int &isAlloc, int &isFree, int &wasNull)
 {
 
-   isAlloc  = numHave;
-   isFree   = numFree;
-   wasNull  = numNull;
-   numNull  = 0;
+   isAlloc  = Pool.numHave;
+   isFree   = Pool.numFree;
+   wasNull  = Pool.numNull;
+   Pool.numNull  = 0;
 }
 
 /******************************************************************************/
 /* static public                  U n l o a d                                 */
 /******************************************************************************/
   
-XrdCmsKeyItem *XrdCmsKeyItem::Unload(unsigned int theTock)
+XrdCmsKeyItem *XrdCmsKeyItem::Unload(XrdCmsKeyPool &Pool, unsigned int theTock)
 {
    XrdCmsKeyItem myItem, *nP, *pP = &myItem;
 
@@ -179,31 +171,31 @@ XrdCmsKeyItem *XrdCmsKeyItem::Unload(unsigned int theTock)
 // requires knowing the hash code, we save it elsewhere in the object.
 //
    theTock &= TickMask;
-   myItem.Key.TODRef = TockTable[theTock]; TockTable[theTock] = 0;
+   myItem.Key.TODRef = Pool.TockTable[theTock]; Pool.TockTable[theTock] = 0;
    while((nP = pP->Key.TODRef))
          if (nP->Key.TOD == theTock) 
             {nP->Loc.HashSave = nP->Key.Hash; nP->Key.Hash = 0; pP = nP;}
             else {pP->Key.TODRef = nP->Key.TODRef;
-                  nP->Key.TODRef = TockTable[nP->Key.TOD];
-                  TockTable[nP->Key.TOD] = nP;
+                  nP->Key.TODRef = Pool.TockTable[nP->Key.TOD];
+                  Pool.TockTable[nP->Key.TOD] = nP;
                  }
    return myItem.Key.TODRef;
 }
 
 /******************************************************************************/
   
-XrdCmsKeyItem *XrdCmsKeyItem::Unload(XrdCmsKeyItem *theItem)
+XrdCmsKeyItem *XrdCmsKeyItem::Unload(XrdCmsKeyPool &Pool, XrdCmsKeyItem *theItem)
 {
    XrdCmsKeyItem *kP, *pP = 0;
    unsigned int theTock = theItem->Key.TOD & TickMask;
 
 // Remove the entry from the right list
 //
-   kP = TockTable[theTock];
+   kP = Pool.TockTable[theTock];
    while(kP && kP != theItem) {pP = kP; kP = kP->Key.TODRef;}
    if (kP)
       {if (pP) pP->Key.TODRef     = kP->Key.TODRef;
-          else TockTable[theTock] = kP->Key.TODRef;
+          else Pool.TockTable[theTock] = kP->Key.TODRef;
        kP->Loc.HashSave = kP->Key.Hash; kP->Key.Hash = 0;
       }
    return kP;
@@ -120,8 +120,11 @@ XrdCmsKeyLoc&  operator=(const XrdCmsKeyLoc &rhs)
   
 // The XrdCmsKeyItem object marries the XrdCmsKey and XrdCmsKeyLoc objects in
 // the key cache. It is only used by logical manipulator, XrdCmsCache, which
-// always front-ends the physical manipulator, XrdCmsNash.
+// always front-ends the physical manipulator, XrdCmsNash. Items are allocated
+// from and returned to an XrdCmsKeyPool which is owned by a single XrdCmsNash.
 //
+class XrdCmsKeyPool;
+
 class XrdCmsKeyItem
 {
 public:
@@ -130,34 +133,53 @@ public:
        XrdCmsKey      Key;
        XrdCmsKeyItem *Next;
 
-static XrdCmsKeyItem *Alloc(unsigned int theTock);
+static XrdCmsKeyItem *Alloc(XrdCmsKeyPool &Pool, unsigned int theTock);
 
-       void           Recycle();
+       void           Recycle(XrdCmsKeyPool &Pool);
 
-       void           Reload();
+       void           Reload(XrdCmsKeyPool &Pool);
 
-static int            Replenish();
+static int            Replenish(XrdCmsKeyPool &Pool);
 
-static void           Stats(int &isAlloc, int &isFree, int &wasEmpty);
+static void           Stats(XrdCmsKeyPool &Pool,
+                            int &isAlloc, int &isFree, int &wasEmpty);
 
-static XrdCmsKeyItem *Unload(unsigned int   theTock);
+static XrdCmsKeyItem *Unload(XrdCmsKeyPool &Pool, unsigned int   theTock);
 
-static XrdCmsKeyItem *Unload(XrdCmsKeyItem *theItem);
+static XrdCmsKeyItem *Unload(XrdCmsKeyPool &Pool, XrdCmsKeyItem *theItem);
 
        XrdCmsKeyItem() {}  // Warning see the constructor!
       ~XrdCmsKeyItem() {}  // These are usually never deleted
 
 static const unsigned int TickRate =   64;
 static const unsigned int TickMask =   63;
-static const          int minAlloc = 4096;
-static const          int minFree  = 1024;
+static const          int minAlloc = 1024;
+static const          int minFree  =  256;
+};
+
+/******************************************************************************/
+/*                   C l a s s   X r d C m s K e y P o o l                    */
+/******************************************************************************/
+
+// The XrdCmsKeyPool object holds the free list and the time-of-day lists of
+// key items. Items never migrate from one pool to another so that each pool,
+// together with the hash table that uses it, may be serialized independently.
+//
+class XrdCmsKeyPool
+{
+public:
+friend class XrdCmsKeyItem;
+
+        XrdCmsKeyPool() : Free(0), numFree(0), numHave(0), numNull(0)
+                        {memset(TockTable, 0, sizeof(TockTable));}
+       ~XrdCmsKeyPool() {} // Never gets deleted
 
 private:
 
-static XrdCmsKeyItem *TockTable[TickRate];
-static XrdCmsKeyItem *Free;
-static int            numFree;
-static int            numHave;
-static int            numNull;
+XrdCmsKeyItem *TockTable[XrdCmsKeyItem::TickRate];
+XrdCmsKeyItem *Free;
+int            numFree;
+int            numHave;
+int            numNull;
 };
 #endif
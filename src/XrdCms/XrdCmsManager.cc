@@ -36,6 +36,7 @@
 
 #include "Xrd/XrdScheduler.hh"
 
+#include "XrdCms/XrdCmsBatch.hh"
 #include "XrdCms/XrdCmsConfig.hh"
 #include "XrdCms/XrdCmsManager.hh"
 #include "XrdCms/XrdCmsManTree.hh"
@@ -232,27 +233,9 @@ void XrdCmsManager::Finished(const char *manP, int mPort)
   
 void XrdCmsManager::Inform(const char *What, const char *Data, int Dlen)
 {
-   EPNAME("Inform");
-   XrdCmsNode *nP;
-   int i;
-
-// Obtain a lock on the table
-//
-   MTMutex.Lock();
+   struct iovec ioV[1] = {{(char *)Data, (size_t)Dlen}};
 
-// Run through the table looking for managers to send messages to
-//
-   for (i = 0; i <= MTHi; i++)
-       {if ((nP=MastTab[i]) && !nP->isOffline)
-           {nP->Lock();
-            MTMutex.UnLock();
-            DEBUG(nP->Name() <<" " <<What);
-            nP->Send(Data, Dlen);
-            nP->UnLock();
-            MTMutex.Lock();
-           }
-       }
-   MTMutex.UnLock();
+   Inform(What, ioV, 1, Dlen);
 }
 
 /******************************************************************************/
@@ -267,15 +250,18 @@ void XrdCmsManager::Inform(const char *What, struct iovec *vP, int vN, int vT)
 //
    MTMutex.Lock();
 
-// Run through the table looking for managers to send messages to
+// Run through the table looking for managers to send messages to. A reference
+// keeps the node from being deleted while we send without locking it. When
+// batching is in effect all messages go through the batcher so that they
+// arrive in the order they were sent.
 //
    for (i = 0; i <= MTHi; i++)
        {if ((nP=MastTab[i]) && !nP->isOffline)
-           {nP->Lock();
+           {nP->Ref();
             MTMutex.UnLock();
             DEBUG(nP->Name() <<" " <<What);
-            nP->Send(vP, vN, vT);
-            nP->UnLock();
+            if (!Batch.Queue(nP, vP, vN, vT)) nP->Send(vP, vN, vT);
+            nP->unRef();
             MTMutex.Lock();
            }
        }
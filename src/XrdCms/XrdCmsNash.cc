@@ -58,7 +58,7 @@ XrdCmsKeyItem *XrdCmsNash::Add(XrdCmsKey &Key)
 
 // Allocate the entry
 //
-   if (!(hip = XrdCmsKeyItem::Alloc(Key.TOD))) return (XrdCmsKeyItem *)0;
+   if (!(hip = XrdCmsKeyItem::Alloc(Items, Key.TOD))) return (XrdCmsKeyItem *)0;
 
 // Check if we should expand the table
 //
@@ -172,7 +172,7 @@ int XrdCmsNash::Recycle(XrdCmsKeyItem *rip)
    if (nip)
       {if (pip) pip->Next = nip->Next;
           else nashtable[kent] = nip->Next;
-          rip->Recycle();
+          rip->Recycle(Items);
           nashnum--;
       }
    return nip != 0;
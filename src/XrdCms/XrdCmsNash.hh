@@ -35,6 +35,12 @@
 class XrdCmsNash
 {
 public:
+
+// Items are allocated from and recycled to this pool. They never leave it so
+// whatever serializes the table also serializes the items it contains.
+//
+XrdCmsKeyPool  Items;
+
 XrdCmsKeyItem *Add(XrdCmsKey &Key);
 
 XrdCmsKeyItem *Find(XrdCmsKey &Key);
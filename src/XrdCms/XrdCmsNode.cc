@@ -41,10 +41,13 @@
 #include "XProtocol/YProtocol.hh"
 
 #include "XrdCms/XrdCmsBaseFS.hh"
+#include "XrdCms/XrdCmsBatch.hh"
+#include "XrdCms/XrdCmsBloom.hh"
 #include "XrdCms/XrdCmsCache.hh"
 #include "XrdCms/XrdCmsCluster.hh"
 #include "XrdCms/XrdCmsClustID.hh"
 #include "XrdCms/XrdCmsConfig.hh"
+#include "XrdCms/XrdCmsHRW.hh"
 #include "XrdCms/XrdCmsManager.hh"
 #include "XrdCms/XrdCmsManList.hh"
 #include "XrdCms/XrdCmsMeter.hh"
@@ -52,6 +55,7 @@
 #include "XrdCms/XrdCmsPrepare.hh"
 #include "XrdCms/XrdCmsRRData.hh"
 #include "XrdCms/XrdCmsNode.hh"
+#include "XrdCms/XrdCmsP2C.hh"
 #include "XrdCms/XrdCmsSelect.hh"
 #include "XrdCms/XrdCmsState.hh"
 #include "XrdCms/XrdCmsTrace.hh"
@@ -99,11 +103,10 @@ XrdCmsNode::XrdCmsNode(XrdLink *lnkp, const char *theIF, const char *nid,
                        int port, int lvl, int id)
 {
     static XrdSysMutex   iMutex;
-    static const SMask_t smask_1(1);
     static int           iNum = 1;
 
     Link     =  lnkp;
-    NodeMask =  (id < 0 ? 0 : smask_1 << id);
+    NodeMask =  XrdCmsMaskBit(id);
     NodeID   = id;
     isOffline=  (lnkp == 0);
     logload  =  Config.LogPerf;
@@ -136,6 +139,8 @@ XrdCmsNode::~XrdCmsNode()
    if (Ident) free(Ident);
    if (myNID) free(myNID);
    if (myName)free(myName);
+   delete sumBloom.load();
+   delete sumNext;
 }
 
 /******************************************************************************/
@@ -170,6 +175,7 @@ void XrdCmsNode::setName(XrdLink *lnkp, const char *theIF, int port)
 //
    myName = strdup(hname);
    myNlen = strlen(hname);
+   hrwKey = XrdCmsHRW::Hash(hname, port);
 
    if (!port) strcpy(buff, lnkp->ID);
       else    sprintf(buff, "%s:%d", lnkp->ID, port);
@@ -345,7 +351,7 @@ const char *XrdCmsNode::do_Disc(XrdCmsRRData &Arg)
 
 // If we must send a disc request, do so now
 //
-   if (Config.asManager()) Link->Send((char *)&Arg.Request,sizeof(Arg.Request));
+   if (Config.asManager()) Send((char *)&Arg.Request,sizeof(Arg.Request));
 
 // Close the link and return an error
 //
@@ -364,7 +370,7 @@ const char *XrdCmsNode::do_Disc(XrdCmsRRData &Arg)
 const char *XrdCmsNode::do_Gone(XrdCmsRRData &Arg)
 {
    EPNAME("do_Gone")
-   static const SMask_t allNodes(~0);
+   static const SMask_t allNodes(FULLMASK);
    int newgone;
 
 // Do some debugging
@@ -406,7 +412,7 @@ const char *XrdCmsNode::do_Gone(XrdCmsRRData &Arg)
 const char *XrdCmsNode::do_Have(XrdCmsRRData &Arg)
 {
    EPNAME("do_Have")
-   static const SMask_t allNodes(~0);
+   static const SMask_t allNodes(FULLMASK);
    XrdCmsPInfo  pinfo;
    int isnew, Opts;
 
@@ -415,6 +421,17 @@ const char *XrdCmsNode::do_Have(XrdCmsRRData &Arg)
    TRACER(Files, (Arg.Request.modifier&CmsHaveRequest::Pending ? "P ":"") 
                  <<Arg.Path);
 
+// If this answers the state query we are timing, fold the response time into
+// the node's moving average (see XrdCmsCluster::Query()).
+//
+   long long sent = prbTime;
+   if (sent && Arg.Request.streamid == prbHash)
+      {long long dly = XrdCmsP2C::Now() - sent;
+       prbTime = 0;
+       if (dly > XrdCmsP2C::prbWait) dly = XrdCmsP2C::prbWait;
+       rspLat  = XrdCmsP2C::Ewma(rspLat, static_cast<int>(dly));
+      }
+
 // Find if we can handle the file in r/w mode and if staging is present
 //
    Opts = (Cache.Paths.Find(Arg.Path, pinfo) && (pinfo.rwvec & NodeMask)
@@ -433,6 +450,7 @@ const char *XrdCmsNode::do_Have(XrdCmsRRData &Arg)
                {Sel.Vec.hf = pinfo.rovec; Sel.Vec.wf = pinfo.rwvec;
                 isnew       = Cache.AddFile(Sel, allNodes);
                } else isnew = Cache.AddFile(Sel, NodeMask);
+            if (sumBloom.load()) Cluster.SumAdd(this, Arg.Path);
            }
 
 // Return if we have no managers or we already informed the managers
@@ -646,7 +664,7 @@ const char *XrdCmsNode::do_Locate(XrdCmsRRData &Arg)
 //
    Arg.Request.datalen = htons(bytes);
    ioV[1].iov_len      = bytes;
-   Link->Send(ioV, 2, bytes+sizeof(Arg.Request));
+   Send(ioV, 2, bytes+sizeof(Arg.Request));
    return 0;
 }
 
@@ -786,7 +804,7 @@ const char *XrdCmsNode::do_Mkpath(XrdCmsRRData &Arg)
 const char *XrdCmsNode::do_Mv(XrdCmsRRData &Arg)
 {
    EPNAME("do_Mv")
-   static const SMask_t allNodes(~0);
+   static const SMask_t allNodes(FULLMASK);
    int rc;
 
 // Do some debugging
@@ -847,7 +865,7 @@ const char *XrdCmsNode::do_Ping(XrdCmsRRData &Arg)
 // Respond: pong
 //
    if (isBad & isDoomed) return ".redirected";
-   Link->Send((char *)&pongIt, sizeof(pongIt));
+   Send((char *)&pongIt, sizeof(pongIt));
    return 0;
 }
   
@@ -916,7 +934,7 @@ const char *XrdCmsNode::do_PrepDel(XrdCmsRRData &Arg)
 const char *XrdCmsNode::do_Rm(XrdCmsRRData &Arg)
 {
    EPNAME("do_Rm")
-   static const SMask_t allNodes(~0);
+   static const SMask_t allNodes(FULLMASK);
    int rc;
 
 // Do some debugging
@@ -951,7 +969,7 @@ const char *XrdCmsNode::do_Rm(XrdCmsRRData &Arg)
 const char *XrdCmsNode::do_Rmdir(XrdCmsRRData &Arg)
 {
    EPNAME("do_Rmdir")
-   static const SMask_t allNodes(~0);
+   static const SMask_t allNodes(FULLMASK);
    int rc;
 
 // Do some debugging
@@ -1178,7 +1196,7 @@ const char *XrdCmsNode::do_Select(XrdCmsRRData &Arg)
 
 // Send back the response
 //
-   Link->Send(ioV, 2, bytes+sizeof(Arg.Request));
+   Send(ioV, 2, bytes+sizeof(Arg.Request));
    return 0;
 }
   
@@ -1285,7 +1303,7 @@ const char *XrdCmsNode::do_Space(XrdCmsRRData &Arg)
             xmsg[1].iov_base = buff;
             xmsg[1].iov_len  = blen;
             mySpace.Hdr.datalen = htons(static_cast<unsigned short>(blen));
-            Link->Send(xmsg, 2);
+            Send(xmsg, 2);
            }
    return 0;
 }
@@ -1336,7 +1354,7 @@ const char *XrdCmsNode::do_State(XrdCmsRRData &Arg)
        xmsg[1].iov_len       = Arg.Dlen;
        Arg.Request.rrCode    = kYR_have;
        Arg.Request.modifier |= kYR_raw;
-       Link->Send(xmsg, 2);
+       if (!Batch.Queue(this, xmsg, 2)) Send(xmsg, 2);
       }
    return 0;
 }
@@ -1348,7 +1366,7 @@ const char *XrdCmsNode::do_State(XrdCmsRRData &Arg)
 void XrdCmsNode::do_StateDFS(XrdCmsBaseFR *rP, int rc)
 {
    EPNAME("StateDFs");
-   static const SMask_t allNodes(~0);
+   static const SMask_t allNodes(FULLMASK);
    CmsRRHdr Request = {rP->Sid, 0, (kXR_char)(rP->Mod | kYR_raw), 0};
    XrdCmsSelect Sel(0, rP->Path, rP->PathLen);
    int isNew;
@@ -1401,7 +1419,7 @@ void XrdCmsNode::do_StateDFS(XrdCmsBaseFR *rP, int rc)
 int XrdCmsNode::do_StateFWD(XrdCmsRRData &Arg)
 {
    EPNAME("do_StateFWD");
-   static const SMask_t allNodes(~0);
+   static const SMask_t allNodes(FULLMASK);
    XrdCmsSelect Sel(0, Arg.Path, Arg.PathLen-1);
    XrdCmsPInfo  pinfo;
    int retc;
@@ -1459,8 +1477,8 @@ int XrdCmsNode::do_StateFWD(XrdCmsRRData &Arg)
 //
    if (!retc || Sel.Vec.bf != 0)
       {if (!retc) Cache.AddFile(Sel, 0);
-       Cluster.Broadcast((retc ? Sel.Vec.bf : pinfo.rovec), Arg.Request,
-                         (void *)Arg.Buff, Arg.Dlen);
+       Cluster.Query((retc ? Sel.Vec.bf : pinfo.rovec), Arg.Request,
+                     (void *)Arg.Buff, Arg.Dlen);
       }
 
 // Return true if anyone has the file at this point. In shared-nothing systems
@@ -1509,7 +1527,7 @@ const char *XrdCmsNode::do_StatFS(XrdCmsRRData &Arg)
    bytes              += sizeof(Zero);
    Arg.Request.rrCode  = kYR_data;
    Arg.Request.datalen = htons(bytes);
-   Link->Send(ioV, 3, bytes+sizeof(Arg.Request));
+   Send(ioV, 3, bytes+sizeof(Arg.Request));
    return 0;
 }
 
@@ -1550,7 +1568,7 @@ const char *XrdCmsNode::do_Stats(XrdCmsRRData &Arg)
       {ioV[1].iov_len = sizeof(theSize);
        Arg.Request.datalen = htons(szLen);
        Arg.Request.rrCode  = kYR_data;
-       Link->Send(ioV, 2);
+       Send(ioV, 2);
        StatsData.UnLock();
        return 0;
       }
@@ -1567,7 +1585,7 @@ const char *XrdCmsNode::do_Stats(XrdCmsRRData &Arg)
    ioV[2].iov_len  = statln;
    Arg.Request.datalen = htons(static_cast<unsigned short>(szLen+statln));
    Arg.Request.rrCode  = kYR_data;
-   Link->Send(ioV, 3);
+   Send(ioV, 3);
 
 // All done
 //
@@ -1655,6 +1673,64 @@ const char *XrdCmsNode::do_Status(XrdCmsRRData &Arg)
    return 0;
 }
 
+/******************************************************************************/
+/*                            d o _ S u m m a r y                             */
+/******************************************************************************/
+
+// A summary is a Bloom filter of the node's namespace which arrives in pieces.
+// Once all of the pieces have arrived the filter replaces the one we have for
+// the node. Summaries are only used by the receiving manager; they are never
+// propagated as they are only meaningful for nodes directly below us.
+//
+const char *XrdCmsNode::do_Summary(XrdCmsRRData &Arg)
+{
+   EPNAME("do_Summary")
+   CmsSummaryData Info;
+   unsigned int gen, offs, total;
+   int n;
+
+// Make sure we have a usable piece
+//
+   if (!Config.asManager()) return 0;
+   if (Arg.PathLen < (int)sizeof(Info))
+      {Say.Emsg("Node", Ident, "sent a truncated summary.");
+       return 0;
+      }
+   memcpy(&Info, Arg.Path, sizeof(Info));
+   gen   = ntohl(Info.Gen);
+   offs  = ntohl(Info.Offset);
+   total = ntohl(Info.Total);
+   n     = Arg.PathLen - sizeof(Info);
+
+// A piece at offset zero starts a new summary. Pieces arrive in order, so
+// anything else that does not continue the current summary is ignored.
+//
+   if (!offs)
+      {delete sumNext; sumNext = 0;
+       if (!total || total > (unsigned int)XrdCmsBloom::maxBytes
+       ||  !Info.Hashes || Info.Hashes > 16)
+          {Say.Emsg("Node", Ident, "sent an invalid summary.");
+           return 0;
+          }
+       sumNext = new XrdCmsBloom(total, Info.Hashes);
+       sumGen  = gen;
+       sumRcvd = 0;
+      } else if (!sumNext || gen != sumGen || offs != (unsigned int)sumRcvd
+             ||  total != (unsigned int)sumNext->Bytes()) return 0;
+
+// Add this piece and install the filter when we have all of it
+//
+   sumRcvd += sumNext->Put(offs, Arg.Path+sizeof(Info), n);
+   if (sumRcvd >= sumNext->Bytes())
+      {int ttl = ntohs(Info.TTL);
+       sumNext->Expires = (ttl ? time(0) + ttl : 0);
+       DEBUGR("installing " <<sumRcvd <<" byte summary gen " <<gen);
+       Cluster.SumInstall(this, sumNext);
+       sumNext = 0;
+      }
+   return 0;
+}
+
 /******************************************************************************/
 /*                              d o _ T r u n c                               */
 /******************************************************************************/
@@ -30,12 +30,15 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <atomic>
 #include <cstring>
 #include <unistd.h>
 #include <netinet/in.h>
 #include <sys/uio.h>
   
 #include "Xrd/XrdLink.hh"
+#include "XrdCms/XrdCmsBatch.hh"
+#include "XrdCms/XrdCmsP2C.hh"
 #include "XrdCms/XrdCmsTypes.hh"
 #include "XrdCms/XrdCmsRRQ.hh"
 #include "XrdNet/XrdNetIF.hh"
@@ -44,6 +47,7 @@
 #include "XrdSys/XrdSysRAtomic.hh"
 
 class XrdCmsBaseFR;
+class XrdCmsBloom;
 class XrdCmsBaseFS;
 class XrdCmsClustID;
 class XrdCmsDrop;
@@ -121,6 +125,7 @@ static void   do_StateDFS(XrdCmsBaseFR *rP, int rc);
 const  char  *do_StatFS(XrdCmsRRData &Arg);
 const  char  *do_Stats(XrdCmsRRData &Arg);
 const  char  *do_Status(XrdCmsRRData &Arg);
+const  char  *do_Summary(XrdCmsRRData &Arg);
 const  char  *do_Trunc(XrdCmsRRData &Arg);
 const  char  *do_Try(XrdCmsRRData &Arg);
 const  char  *do_Update(XrdCmsRRData &Arg);
@@ -181,10 +186,19 @@ inline void  unRef() {refCnt--;}
 
 static void  Report_Usage(XrdLink *lp);
 
+// Send() first flushes messages batched for the node so that it does not
+// overtake them. Post() sends right away and is meant for the batcher.
+//
 inline int   Send(const char *buff, int blen=0)
-                 {return (isOffline ? -1 : Link->Send(buff, blen));}
+                 {if (XrdCms::Batch.Active()) XrdCms::Batch.Flush(this);
+                  return Post(buff, blen);
+                 }
 inline int   Send(const struct iovec *iov, int iovcnt, int iotot=0)
-                 {return (isOffline ? -1 : Link->Send(iov, iovcnt, iotot));}
+                 {if (XrdCms::Batch.Active()) XrdCms::Batch.Flush(this);
+                  return (isOffline ? -1 : Link->Send(iov, iovcnt, iotot));
+                 }
+inline int   Post(const char *buff, int blen=0)
+                 {return (isOffline ? -1 : Link->Send(buff, blen));}
 
        void  setManager(XrdCmsManager *mP) {Manager = mP;}
 
@@ -263,6 +277,28 @@ RAtomic_char       Shrin{0};     // Share intervals used
 char               Shrip    = 0; // Share of requests to skip (set once)
 char               Rsvd[3];
 
+// The following fields provide fast feedback for the p2c selection policy. A
+// single state query at a time is timed; its response is matched by path hash.
+//
+RAtomic_int        rspLat{0};    // Moving average of query response usec
+XrdCmsP2C::Recent  selRecent;    // Recent redirects (decays with time)
+RAtomic_llong      prbTime{0};   // When the timed query was sent (0 -> none)
+RAtomic_uint       prbHash{0};   // Path hash of the timed query
+
+// The following is the node's key for the hash selection policy. It depends
+// only on the host name and data port so that it survives a restart.
+//
+unsigned long long hrwKey   = 0;
+
+// The following fields hold the namespace summary the node sends us. Only the
+// cluster replaces sumBloom (see XrdCmsCluster::SumInstall()). The pieces of a
+// summary being received are assembled in sumNext by the node's reader thread.
+//
+std::atomic<XrdCmsBloom *> sumBloom{0};
+XrdCmsBloom       *sumNext  = 0;
+unsigned int       sumGen   = 0;   // Generation being received
+int                sumRcvd  = 0;   // Bytes of it received so far
+
 // The following fields are used to keep the supervisor's free space value
 //
 static XrdSysMutex mlMutex;
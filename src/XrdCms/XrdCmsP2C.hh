@@ -0,0 +1,132 @@
+#ifndef XRDCMSP2C__H
+#define XRDCMSP2C__H
+/******************************************************************************/
+/*                                                                            */
+/*                          X r d C m s P 2 C . h h                           */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <chrono>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+// XrdCmsP2C holds the arithmetic behind the "p2c" selection policy. Each node
+// carries a moving average of how long it takes to answer a state query and a
+// count of recent redirects that decays with time. The latter stands in for
+// transfers that the node's load report does not reflect yet. A selection
+// draws two eligible nodes at random and takes the one with the lower score.
+// Drawing two, instead of taking the overall best, keeps a burst of requests
+// from herding onto the same node between feedback updates. The functions are
+// kept free of cluster state so that xrdcmssim can replay traces through the
+// very same code.
+//
+namespace XrdCmsP2C
+{
+// Return a monotonic time stamp in microseconds.
+//
+inline long long Now()
+          {return std::chrono::duration_cast<std::chrono::microseconds>
+                  (std::chrono::steady_clock::now().time_since_epoch()).count();
+          }
+
+// Fold a sample into a moving average with a weight of 1/8. A zero average
+// means no sample was seen yet so the first sample is taken as is.
+//
+inline int  Ewma(int avg, int sample)
+          {return (avg ? avg + (sample - avg) / 8 : (sample ? sample : 1));}
+
+// Return a redirect count decayed by half for each half-life that elapsed
+// since the count was last updated. The stamp is advanced in whole half-lives
+// so that the remainder is carried forward.
+//
+inline int  Decay(int cnt, long long &stamp, long long now, long long hLife)
+          {if (hLife <= 0 || now <= stamp) return cnt;
+           long long n = (now - stamp) / hLife;
+           if (!n) return cnt;
+           stamp += n * hLife;
+           return (n >= 31 ? 0 : cnt >> n);
+          }
+
+// A node's recent redirect count along with the time it was last decayed.
+// Concurrent selections decay and bump it, so both are updated under a lock.
+// Count() returns the count decayed to now plus the indicated number of new
+// redirects.
+//
+class Recent
+{
+public:
+
+int         Count(long long now, long long hLife, int add=0)
+                 {XrdSysMutexHelper cHelp(cntMutex);
+                  recCnt = Decay(recCnt, recStamp, now, hLife) + add;
+                  return recCnt;
+                 }
+
+            Recent() {}
+           ~Recent() {}
+
+private:
+
+XrdSysMutex cntMutex;
+int         recCnt   = 0;
+long long   recStamp = 0;
+};
+
+// A timed query that is not answered within prbWait usec is given up on so
+// that another one may be timed; the node may simply not have the file.
+//
+static const int prbWait = 5000000;
+
+// Score a node; lower is better. The latency floor keeps nodes with no or a
+// tiny latency from being chosen on latency alone and the load, when known,
+// scales the result. The load is a percentage (0 to 100).
+//
+static const int latFloor = 1000; // usec
+
+inline long long Score(int latency, int recent, int load)
+          {return (static_cast<long long>(latency) + latFloor)
+                * (recent + 1) * (100 + load);
+          }
+
+// Return the latency to score a node with. A node whose queries were never
+// timed has a zero latency. It is given the average of the candidates that
+// were timed (latSum over latCnt) so that it neither wins nor loses on latency
+// alone; it would otherwise look like the fastest node of all.
+//
+inline int  Latency(int latency, long long latSum, int latCnt)
+          {return (latency || latCnt <= 0 ? latency
+                  : static_cast<int>(latSum / latCnt));
+          }
+
+// Pick one of n candidates, 0 to n-1, using two random choices. Ties go to the
+// first draw. Return -1 if there are no candidates.
+//
+template<class Rng, class ScoreF>
+int         Pick(int n, Rng &rng, ScoreF score)
+          {if (n <= 1) return n - 1;
+           int a = static_cast<int>(rng() % n);
+           int b = static_cast<int>(rng() % (n-1));
+           if (b >= a) b++;
+           return (score(b) < score(a) ? b : a);
+          }
+}
+#endif
@@ -30,6 +30,7 @@
 
 #include <unistd.h>
 #include <cctype>
+#include <chrono>
 #include <cerrno>
 #include <signal.h>
 #include <cstdlib>
@@ -60,6 +61,7 @@
 #include "XrdCms/XrdCmsRouting.hh"
 #include "XrdCms/XrdCmsRTable.hh"
 #include "XrdCms/XrdCmsState.hh"
+#include "XrdCms/XrdCmsSummary.hh"
 #include "XrdCms/XrdCmsTrace.hh"
 
 #include "XrdOuc/XrdOucCRC.hh"
@@ -403,6 +405,7 @@ void XrdCmsProtocol::Pander(const char *manager, int mport)
                    Say.Emsg("Protocol", "Logged into", sname, Link->Name());
                    if (Data.SID)
                       Manager->Verify(Link, (const char *)Data.SID, sname);
+                   Summary.Resend();
                    Reason = Dispatch(isUp, TimeOut, 2);
                    rc = 0;
                    loginData.fSpace= Meter.FreeSpace(fsUtil);
@@ -962,9 +965,18 @@ const char *XrdCmsProtocol::Dispatch(Bearing cDir, int maxWait, int maxTries)
 //
 // Link->Bind(XrdSysThread::ID());
 
+// Get a read buffer if we don't have one. Whatever it held belonged to a
+// previous link and is discarded.
+//
+   if (!rdBuff && !(rdBuff = (char *)malloc(rdSize)))
+      {Say.Emsg("Protocol", "No buffers to serve", Link->Name());
+       return "insufficient buffers";
+      }
+   rdBeg = rdEnd = 0;
+
 // Read in the request header
 //
-do{if ((rc = Link->RecvAll((char *)&Data->Request, ReqSize, maxWait)) < 0)
+do{if ((rc = RecvData((char *)&Data->Request, ReqSize, maxWait)) < 0)
       {if (rc != -ETIMEDOUT) return (myNode->isBad & XrdCmsNode::isBlisted ?
                                      "blacklisted" : "request read failed");
        if (!toLeft--) return toRC;
@@ -1004,7 +1016,7 @@ do{if ((rc = Link->RecvAll((char *)&Data->Request, ReqSize, maxWait)) < 0)
                {Say.Emsg("Protocol", "No buffers to serve", Link->Name());
                 return "insufficient buffers";
                }
-            if ((rc = Link->RecvAll(Data->Buff, Data->Dlen, maxWait)) < 0)
+            if ((rc = RecvData(Data->Buff, Data->Dlen, maxWait)) < 0)
                return (rc == -ETIMEDOUT ? "read timed out" : "read failed");
             myArgs = Data->Buff; myArgt = Data->Buff + Data->Dlen;
            }
@@ -1118,6 +1130,65 @@ void XrdCmsProtocol::Ref(int rcnt)
    refMutex.UnLock();
 }
 
+/******************************************************************************/
+/*                              R e c v D a t a                               */
+/******************************************************************************/
+
+// Copy the next blen bytes of the request stream to the caller's buffer,
+// reading more from the link only when the read buffer lacks them. Bytes left
+// over remain buffered should the read time out. The wait applies to all of
+// the reads needed so a peer trickling bytes cannot hold us indefinitely.
+//
+int XrdCmsProtocol::RecvData(char *buff, int blen, int maxWait)
+{
+   std::chrono::steady_clock::time_point endT;
+   int rc, toWait = maxWait;
+
+   if (maxWait > 0) endT = std::chrono::steady_clock::now()
+                         + std::chrono::milliseconds(maxWait);
+
+   while(rdEnd - rdBeg < blen)
+        {if ((rc = RecvFill(toWait)) < 0) return rc;
+         if (maxWait > 0 && rdEnd - rdBeg < blen)
+            {toWait = std::chrono::duration_cast<std::chrono::milliseconds>
+                      (endT - std::chrono::steady_clock::now()).count();
+             if (toWait <= 0) return -ETIMEDOUT;
+            }
+        }
+
+   memcpy(buff, rdBuff+rdBeg, blen);
+   rdBeg += blen;
+   return blen;
+}
+
+/******************************************************************************/
+/*                              R e c v F i l l                               */
+/******************************************************************************/
+
+int XrdCmsProtocol::RecvFill(int maxWait)
+{
+   struct iovec ioV;
+   int rlen;
+
+// Move any partial request to the front of the buffer
+//
+   if (rdBeg)
+      {if (rdEnd > rdBeg) memmove(rdBuff, rdBuff+rdBeg, rdEnd-rdBeg);
+       rdEnd -= rdBeg; rdBeg = 0;
+      }
+
+// Read whatever is queued on the link, up to the space we have, with a single
+// read. A zero return means that either the wait timed out or the link was
+// closed. A RecvAll() that does not wait tells us which as it fails on EOF.
+//
+   ioV.iov_base = rdBuff + rdEnd;
+   ioV.iov_len  = rdSize - rdEnd;
+   if (!(rlen = Link->Recv(&ioV, 1, maxWait)))
+      rlen = Link->RecvAll(rdBuff + rdEnd, 1, 0);
+   if (rlen > 0) rdEnd += rlen;
+   return rlen;
+}
+
 /******************************************************************************/
 /*                               R e i s s u e                                */
 /******************************************************************************/
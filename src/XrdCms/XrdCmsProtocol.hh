@@ -63,7 +63,8 @@ static XrdCmsProtocol *Alloc(const char *theRole = "", XrdCmsManager *mP=0,
 
        int             Stats(char *buff, int blen, int do_sync=0);
 
-              XrdCmsProtocol() : XrdProtocol("cms protocol handler") {Init();}
+              XrdCmsProtocol() : XrdProtocol("cms protocol handler"),
+                                 rdBuff(0) {Init();}
              ~XrdCmsProtocol() {}
 
 private:
@@ -81,6 +82,8 @@ void            Init(const char *iRole="?", XrdCmsManager *uMan=0,
                      const char *iMan="?",  int iPort=0);
 XrdCmsRouting  *Login_Failed(const char *Reason);
 void            Pander(const char *manager, int mport);
+int             RecvData(char *buff, int blen, int maxWait);
+int             RecvFill(int maxWait);
 void            Reissue(XrdCmsRRData &Data);
 void            Reply_Delay(XrdCmsRRData &Data, kXR_unt32 theDelay);
 void            Reply_Error(XrdCmsRRData &Data, int ecode, const char *etext);
@@ -108,5 +111,13 @@ const  char           *myMan;
        short           RSlot;      // True only for redirectors
        char            loggedIn;   // True if login succeeded
        bool            isNBSQ;     // True if nbsq is active
+
+// Requests are read through a buffer that receives whatever is queued on the
+// link. Dispatch() handles every complete request in it before reading again.
+//
+static const int       rdSize = 2*maxReqSize;
+       char           *rdBuff;     // Allocated on first use; kept when recycled
+       int             rdBeg;      // Offset of the first unprocessed byte
+       int             rdEnd;      // Offset past the last byte read
 };
 #endif
@@ -28,25 +28,26 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
-#include <cstring>
-#include <sys/types.h>
-#include <netinet/in.h>
-#include <cinttypes>
+#include <chrono>
+#include <sched.h>
 
-#include "XrdCms/XrdCmsCluster.hh"
-#include "XrdCms/XrdCmsNode.hh"
 #include "XrdCms/XrdCmsRRQ.hh"
-#include "XrdCms/XrdCmsRTable.hh"
-#include "XrdCms/XrdCmsTrace.hh"
-#include "XrdSys/XrdSysError.hh"
-#include "XrdSys/XrdSysTimer.hh"
-#include <cstdio>
 
 using namespace XrdCms;
 
 // Note: Debugging statements have been commented out. This is time critical
 //       code and debugging may only be enabled in standalone testing as the
 //       delays introduced by DEBUG() will usually cause timeout failures.
+
+// Note: There is no queue lock. Threads adding requests and fielding responses
+//       (one per cache shard at a time), the timeout thread, and the responder
+//       hand slots to each other by changing the slot state with a compare and
+//       swap (see XrdCmsRRQSlot). A thread that finds a slot being updated
+//       spins; updates are a handful of instructions.
+
+// Note: This file holds the queue itself and has no dependencies on the rest
+//       of the cmsd. The threads that answer and expire requests are in
+//       XrdCmsRRQSend.cc.
   
 /******************************************************************************/
 /*       G l o b a l   O b j e c t s   &   S t a t i c   M e m b e r s        */
@@ -54,21 +55,40 @@ using namespace XrdCms;
   
 XrdCmsRRQ             XrdCms::RRQ;
 
-XrdSysMutex           XrdCmsRRQSlot::myMutex;
-XrdCmsRRQSlot        *XrdCmsRRQSlot::freeSlot = 0;
-short                 XrdCmsRRQSlot::initSlot = 0;
+namespace
+{
+long long Now()
+{
+   return std::chrono::duration_cast<std::chrono::microseconds>
+          (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
 
 /******************************************************************************/
-/*                    E x t e r n a l   F u n c t i o n s                     */
+/*               X r d C m s R R Q   C l a s s   M e t h o d s                */
 /******************************************************************************/
-  
-void *XrdCmsRRQ_StartTimeOut(void *parg) {return RRQ.TimeOut();}
-
-void *XrdCmsRRQ_StartRespond(void *parg) {return RRQ.Respond();}
-
 /******************************************************************************/
-/*               X r d C m s R R Q   C l a s s   M e t h o d s                */
+/*                           C o n s t r u c t o r                            */
 /******************************************************************************/
+
+XrdCmsRRQ::XrdCmsRRQ() : isWaiting(0), isReady(0), freeHead(0), readyHead(0),
+                         numWait(0), Add2Q(0), PBack(0), Resp(0), Multi(0),
+                         luFast(0), luSlow(0), rdFast(0), rdSlow(0),
+                         waitTot(0), waitMax(0),
+                         Tslice(178), Tdelay(5), myClock(0)
+{
+// Number the slots and put all of them, except slot zero which means no slot,
+// on the free list.
+//
+   for (int i = numSlots-1; i >= 0; i--)
+       {Slot[i].slotNum = i;
+        if (i) PutSlot(&Slot[i]);
+       }
+   for (int i = 0; i < wheelSize; i++)
+       for (int j = 0; j < wheelWords; j++) Wheel[i][j] = 0;
+   for (int i = 0; i < waitHistN; i++) waitHist[i] = 0;
+}
+
 /******************************************************************************/
 /*                                   A d d                                    */
 /******************************************************************************/
@@ -76,36 +96,42 @@ void *XrdCmsRRQ_StartRespond(void *parg) {return RRQ.Respond();}
 short XrdCmsRRQ::Add(short Snum, XrdCmsRRQInfo *Info)
 {
 // EPNAME("RRQ Add");
-   XrdCmsRRQSlot *sp;
+   XrdCmsRRQSlot *sp, *hp;
+   int from;
 
 // Obtain a slot and fill it in
 //
-   if (!(sp = XrdCmsRRQSlot::Alloc(Info))) return 0;
+   if (!(sp = GetSlot())) return 0;
+   sp->Info = *Info;
+   sp->Cont = sp->LkUp = 0;
+   sp->Arg1 = 0; sp->Arg2 = 0;
+   sp->Born = Now();
+   Add2Q++;
 // DEBUG("adding slot " <<sp->slotNum);
 
 // If a slot number given, check if it's the right slot and it is still queued.
 // If so, piggy-back this request to existing one and make a fast exit
 //
-   myMutex.Lock(); Stats.Add2Q++;
-   if (Snum && Slot[Snum].Info.Key == Info->Key && Slot[Snum].Expire)
-      {if (Info->isLU)
-          {sp->LkUp = Slot[Snum].LkUp;
-           Slot[Snum].LkUp = sp;
-          } else {
-           sp->Cont = Slot[Snum].Cont;
-           Slot[Snum].Cont = sp;
+   if (Snum > 0 && Snum < numSlots && Claim((hp = &Slot[Snum]), from))
+      {if (hp->Info.Key == Info->Key)
+          {sp->State.store(XrdCmsRRQSlot::isChained, std::memory_order_relaxed);
+           if (Info->isLU)
+              {sp->LkUp = hp->LkUp;
+               hp->LkUp = sp;
+              } else {
+               sp->Cont = hp->Cont;
+               hp->Cont = sp;
+              }
+           hp->State.store(from, std::memory_order_release);
+           PBack++;
+           return Snum;
           }
-       Stats.PBack++;
-       myMutex.UnLock();
-       return Snum;
+       hp->State.store(from, std::memory_order_release);
       }
 
-// Queue this slot to the pending response queue and tell the timeout scheduler
+// Make this slot wait for responses and tell the timeout scheduler
 //
-   sp->Expire = myClock+1;
-   if (waitQ.Singleton()) isWaiting.Post();
-   waitQ.Prev()->Insert(&sp->Link);
-   myMutex.UnLock();
+   Schedule(sp);
    return sp->slotNum;
 }
 
@@ -119,75 +145,45 @@ void XrdCmsRRQ::Del(short Snum, const void *Key)
 }
 
 /******************************************************************************/
-/*                                  I n i t                                   */
+/*                                E x p i r e                                 */
 /******************************************************************************/
   
-int XrdCmsRRQ::Init(int Tint, int Tdly)
+// Expire the requests whose timer bucket is for the given tick. A slot expires
+// if it is still waiting and its expiration tick has passed; its bit may be
+// stale as the slot may have been answered and reused in the meantime. A slot
+// that is being updated is looked at again on the next tick. We used to zero
+// out arg1/2 to force expiration, but they would be zero anyway if no
+// responses occurred. Now with qdn we need to leave them alone as we may have
+// deferred a fast dispatch because we were waiting for more than one responder.
+
+int XrdCmsRRQ::Expire(unsigned int tick)
 {
-   int rc;
-   pthread_t tid;
-
-// Set values
-//
-   if (Tint) Tslice = Tint;
-   if (Tdly) Tdelay = Tdly;
-   Stats.Reset();
-
-// Fill out the response structure
-//
-   dataResp.Hdr.streamid = 0;
-   dataResp.Hdr.rrCode   = kYR_data;
-   dataResp.Hdr.modifier = 0;
-   dataResp.Hdr.datalen  = 0;
-   dataResp.Val          = 0;
-
-// Fill out the data i/o vector
-//
-   data_iov[0].iov_base = (char *)&dataResp;
-   data_iov[0].iov_len  = sizeof(dataResp);
-   data_iov[1].iov_base = databuff;;
-
-// Fill out the response structure
-//
-   redrResp.Hdr.streamid = 0;
-   redrResp.Hdr.rrCode   = kYR_redirect;
-   redrResp.Hdr.modifier = 0;
-   redrResp.Hdr.datalen  = 0;
-   redrResp.Val          = 0;
-
-// Fill out the redirect i/o vector
-//
-   redr_iov[0].iov_base = (char *)&redrResp;
-   redr_iov[0].iov_len  = sizeof(redrResp);
-   redr_iov[1].iov_base = hostbuff;;
-
-// Fill out the wait info
-//
-   waitResp.Hdr.streamid = 0;
-   waitResp.Hdr.rrCode   = kYR_wait;
-   waitResp.Hdr.modifier = 0;
-   waitResp.Hdr.datalen  = htons(static_cast<unsigned short>(sizeof(waitResp.Val)));
-   waitResp.Val          = htonl(Tdelay);
-
-// Start the responder thread
-//
-   if ((rc = XrdSysThread::Run(&tid, XrdCmsRRQ_StartRespond, (void *)0,
-                               0, "Request Responder")))
-      {Say.Emsg("Config", rc, "create request responder thread");
-       return 1;
-      }
-
-// Start the timeout thread
-//
-   if ((rc = XrdSysThread::Run(&tid, XrdCmsRRQ_StartTimeOut, (void *)0,
-                               0, "Request Timeout")))
-      {Say.Emsg("Config", rc, "create request timeout thread");
-       return 1;
-      }
-
-// All done
-//
-   return 0;
+// EPNAME("RRQ Expire");
+   XrdCmsRRQSlot *sp;
+   unsigned long long bits;
+   int n, state, numExp = 0;
+
+   for (int w = 0; w < wheelWords; w++)
+       {bits = Wheel[tick % wheelSize][w].exchange(0);
+        while(bits)
+             {n = __builtin_ctzll(bits); bits &= bits - 1;
+              sp = &Slot[w*64 + n];
+              state = sp->State.load(std::memory_order_acquire);
+              if (state == XrdCmsRRQSlot::isWait
+              &&  sp->Expire.load(std::memory_order_relaxed) <= tick
+              &&  sp->State.compare_exchange_strong(state,
+                               XrdCmsRRQSlot::isReady,
+                               std::memory_order_acq_rel))
+                 {
+//                DEBUG("expired slot " <<sp->slotNum);
+                  Enqueue(sp);
+                  numExp++;
+                 }
+                 else if (state == XrdCmsRRQSlot::isBusy)
+                         Wheel[myClock % wheelSize][w].fetch_or(1ULL<<n);
+             }
+       }
+   return numExp;
 }
 
 /******************************************************************************/
@@ -198,13 +194,15 @@ int XrdCmsRRQ::Ready(int Snum, const void *Key, SMask_t mask1, SMask_t mask2)
 {
 // EPNAME("RRQ Ready");
    XrdCmsRRQSlot *sp;
+   int from;
 
 // Check if it's the right slot and it is still queued.
 //
-   myMutex.Lock();
+   if (Snum <= 0 || Snum >= numSlots) return 1;
    sp = &Slot[Snum];
-   if (sp->Info.Key != Key || !sp->Expire)
-      {myMutex.UnLock();
+   if (!Claim(sp, from)) return 1;
+   if (sp->Info.Key != Key)
+      {sp->State.store(from, std::memory_order_release);
 //     DEBUG("slot " <<Snum <<" no longer valid");
        return 1;
       }
@@ -213,298 +211,239 @@ int XrdCmsRRQ::Ready(int Snum, const void *Key, SMask_t mask1, SMask_t mask2)
 // a fixed differentiation mask. Accumulate the 1st but replace the 2nd.
 //
    sp->Arg1 |= mask1; sp->Arg2 = mask2;
-   Stats.Resp++;
+   Resp++;
 
 // Check if we should still hold on to this slot because the number of actual
 // responders is less than the number needed.
 //
    if (sp->Info.actR < sp->Info.minR)
-      {sp->Info.actR++; Stats.Multi++;
-       myMutex.UnLock();
+      {sp->Info.actR++; Multi++;
+       sp->State.store(from, std::memory_order_release);
        return 0;
       }
 
-// Move the element from the waiting queue to the ready queue
+// Move the slot to the ready list unless it is already there
 //
-   sp->Link.Remove();
-   if (readyQ.Singleton()) isReady.Post();
-   readyQ.Prev()->Insert(&sp->Link);
-   myMutex.UnLock();
+   sp->State.store(XrdCmsRRQSlot::isReady, std::memory_order_release);
+   if (from == XrdCmsRRQSlot::isWait) Enqueue(sp);
 // DEBUG("readied slot " <<Snum <<" mask " <<mask);
    return 1;
 }
 
 /******************************************************************************/
-/*                               R e s p o n d                                */
+/*                                 S e r v e                                  */
 /******************************************************************************/
   
-void *XrdCmsRRQ::Respond()
+int XrdCmsRRQ::Serve(Answerer &ans)
 {
-// EPNAME("RRQ Respond");
-   XrdCmsRRQSlot *sp;
+   XrdCmsRRQSlot *sp, *np, *fifo;
+   int from, numSent = 0;
 
-// In an endless loop, process all ready elements
+// Process all ready elements. The ready list is a stack so we take all of it
+// at once and reverse it to respond in arrival order.
 //
-   do {isReady.Wait();     // DEBUG("responder awoken");
-   do {myMutex.Lock();
-       Stats.rdFast += rdFast; Stats.rdSlow += rdSlow;
-       Stats.luFast += luFast; Stats.luSlow += luSlow;
-       if (readyQ.Singleton()) {myMutex.UnLock(); break;}
-       sp = readyQ.Next()->Item(); sp->Link.Remove(); sp->Expire = 0;
-       myMutex.UnLock();
-
-    // A locate request can be pggy-backed on a select request and vice-versa
-    // We separate the two queues here as each has a different response.
+   while((np = readyHead.exchange(0, std::memory_order_acquire)))
+   {fifo = 0;
+    while((sp = np)) {np = sp->Next; sp->Next = fifo; fifo = sp;}
+    while((sp = fifo))
+      {fifo = sp->Next;
+
+    // Take the slot over; it may still be getting one last response recorded
     //
-       if (sp->Info.isLU)
-          {if (sp->Cont)
-              {sp->Cont->Arg1 = sp->Arg1;
-               sendRedResp(sp->Cont);
-              }
-           sendLocResp(sp);
-          } else {
-           if (sp->LkUp)
-              {sp->LkUp->Arg1 = sp->Arg1; sp->LkUp->Arg2 = sp->Arg2;
-               sendLocResp(sp->LkUp);
-              }
-           sendRedResp(sp);
-          }
-       sp->Recycle();
-      } while(1);
-      } while(1);
+       Claim(sp, from);
+       sp->State.store(XrdCmsRRQSlot::isSent, std::memory_order_relaxed);
 
-// Keep the compiler happy
-//
-   return (void *)0;
+    // Answer everyone waiting on the slot and then free it
+    //
+       ans.Answer(sp);
+       Waited(sp);
+       Recycle(sp);
+       numSent++;
+      }
+   }
+   return numSent;
 }
 
 /******************************************************************************/
-/*                           s e n d L o c R e s p                            */
+/*                            S t a t i s t i c s                             */
 /******************************************************************************/
-  
-void XrdCmsRRQ::sendLocResp(XrdCmsRRQSlot *lP)
-{
-   static const int ovhd = sizeof(kXR_unt32);
-   XrdCmsSelected *sP;
-   XrdCmsNode *nP;
-   XrdCmsCluster::CmsLSOpts lsopts;
-   int bytes;
-   bool oksel;
-
-// Send a delay if we timed out
-//
-   if (!(lP->Arg1))
-      {sendLwtResp(lP);
-       return;
-      }
 
-// Get the list of servers that have this file. If none found, then force the
-// client to wait as this should never happen and the long path is called for.
-// ASAP responses always respond in with IPv6 addresses or mapped IPv4 ones.
-//
-   lsopts = static_cast<XrdCmsCluster::CmsLSOpts>(lP->Info.lsLU);
-   if (!(sP = Cluster.List(lP->Arg1, lsopts, oksel))
-   || (!(bytes = XrdCmsNode::do_LocFmt(databuff,sP,lP->Arg2,lP->Info.rwVec))))
-      {sendLwtResp(lP);
-       return;
-      }
+void XrdCmsRRQ::Statistics(Info &Data)
+{
+   long long hist[waitHistN], tot = 0, sum;
+   int i;
 
-// Complete the I/O vector
+// Copy the counters
 //
-   bytes++;
-   data_iov[1].iov_len  = bytes;
-   bytes += ovhd;
-   dataResp.Hdr.datalen = htons(static_cast<unsigned short>(bytes));
-   bytes += sizeof(dataResp.Hdr);
-
-// Send the reply to each waiting redirector
+   Data.Add2Q  = Add2Q;
+   Data.PBack  = PBack;
+   Data.Resp   = Resp;
+   Data.Multi  = Multi;
+   Data.luFast = luFast;
+   Data.luSlow = luSlow;
+   Data.rdFast = rdFast;
+   Data.rdSlow = rdSlow;
+   Data.WaitMax= waitMax;
+
+// Compute the wait time summary from the histogram
 //
-   RTable.Lock();
-   do {if ((nP = RTable.Find(lP->Info.Rnum, lP->Info.Rinst)))
-          {dataResp.Hdr.streamid = lP->Info.ID;
-           nP->Send(data_iov, iov_cnt, bytes);
-          }
-       luFast++;
-      } while((lP = lP->LkUp));
-   RTable.UnLock();
+   for (i = 0; i < waitHistN; i++) tot += (hist[i] = waitHist[i]);
+   Data.Waits   = tot;
+   Data.WaitAvg = (tot ? static_cast<long long>(waitTot) / tot : 0);
+   Data.WaitP50 = Data.WaitP99 = 0;
+   if (!tot) return;
+   for (i = 0, sum = 0; i < waitHistN && (sum += hist[i])*2 < tot; i++) {}
+   Data.WaitP50 = 1LL << (i < waitHistN ? i : waitHistN-1);
+   for (i = 0, sum = 0; i < waitHistN && (sum += hist[i])*100 < tot*99; i++) {}
+   Data.WaitP99 = 1LL << (i < waitHistN ? i : waitHistN-1);
 }
 
 /******************************************************************************/
-/*                           s e n d L w t R e s p                            */
+/*                       P r i v a t e   M e t h o d s                        */
 /******************************************************************************/
-  
-void XrdCmsRRQ::sendLwtResp(XrdCmsRRQSlot *rP)
+/******************************************************************************/
+/*                                 C l a i m                                  */
+/******************************************************************************/
+
+// Take over a slot that is waiting or ready, returning the state it was in.
+
+bool XrdCmsRRQ::Claim(XrdCmsRRQSlot *sp, int &from)
 {
-// EPNAME("sendLwtResp");
-   XrdCmsNode *nP;
+   int state = sp->State.load(std::memory_order_acquire);
 
-// For each request, find the redirector and ask it to send a wait
-//
-   RTable.Lock();
-do{if ((nP = RTable.Find(rP->Info.Rnum, rP->Info.Rinst)))
-      {waitResp.Hdr.streamid = rP->Info.ID; luSlow++;
-       nP->Send((char *)&waitResp, sizeof(waitResp));
-//     DEBUG("Redirect delay " <<nP->Name() <<' ' <<Tdelay);
-      }
-//    else {DEBUG("redirector " <<Info->Rnum <<'.' <<Info->Rinst <<"not found");}
-  } while((rP = rP->LkUp));
-   RTable.UnLock();
+   while(1)
+        {if (state == XrdCmsRRQSlot::isBusy)
+            {sched_yield();
+             state = sp->State.load(std::memory_order_acquire);
+             continue;
+            }
+         if (state != XrdCmsRRQSlot::isWait && state != XrdCmsRRQSlot::isReady)
+            return false;
+         from = state;
+         if (sp->State.compare_exchange_weak(state, XrdCmsRRQSlot::isBusy,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire))
+            return true;
+        }
 }
-  
+
 /******************************************************************************/
-/*                           s e n d R e d R e s p                            */
+/*                               E n q u e u e                                */
 /******************************************************************************/
-  
-void XrdCmsRRQ::sendRedResp(XrdCmsRRQSlot *rP)
-{
-// EPNAME("sendRedResp");
-   static const int ovhd = sizeof(kXR_unt32);
-   XrdCmsNode *nP;
-   int doredir = 0, port = 0, hlen = 0;
 
-// Determine where the client should be redirected
-//
-   if ((doredir = (rP->Arg1 && Cluster.Select(rP->Arg1, port, hostbuff, hlen,
-                                              rP->Info.isRW, rP->Info.actR,
-                                              rP->Info.ifOP))))
-      {redrResp.Val = htonl(port);
-       redrResp.Hdr.datalen = htons(static_cast<unsigned short>(hlen+ovhd));
-       redr_iov[1].iov_len  = hlen;
-       hlen += ovhd + sizeof(redrResp.Hdr);
-      }
+// Put a slot that stopped waiting on the ready list and wake the responder if
+// the list was empty. The list is a stack that only the responder empties.
 
-// For each request, find the redirector and ask it to send the message
-//
-   RTable.Lock();
-do{if ((nP = RTable.Find(rP->Info.Rnum, rP->Info.Rinst)))
-      {if (doredir){redrResp.Hdr.streamid = rP->Info.ID; rdFast++;
-                    nP->Send(redr_iov, iov_cnt, hlen);
-//                  DEBUG("Fast redirect " <<nP->Name() <<" -> " <<hostbuff);
-                   }
-              else {waitResp.Hdr.streamid = rP->Info.ID; rdSlow++;
-                    nP->Send((char *)&waitResp, sizeof(waitResp));
-//                  DEBUG("Redirect delay " <<nP->Name() <<' ' <<Tdelay);
-                   }
-      } 
-//    else {DEBUG("redirector " <<Info->Rnum <<'.' <<Info->Rinst <<"not found");}
-  } while((rP = rP->Cont));
-   RTable.UnLock();
+void XrdCmsRRQ::Enqueue(XrdCmsRRQSlot *sp)
+{
+   XrdCmsRRQSlot *hp = readyHead.load(std::memory_order_relaxed);
+
+   numWait--;
+   do {sp->Next = hp;}
+      while(!readyHead.compare_exchange_weak(hp, sp, std::memory_order_release,
+                                                     std::memory_order_relaxed));
+   if (!hp) isReady.Post();
 }
 
 /******************************************************************************/
-/*                               T i m e O u t                                */
+/*                               G e t S l o t                                */
 /******************************************************************************/
-  
-void *XrdCmsRRQ::TimeOut()
-{
-// EPNAME("RRQ TimeOut");
-   XrdCmsRRQSlot *sp;
 
-// We measure millisecond intervals to timeout waiting requests. We used to zero
-// out arg1/2 to force expiration, but they would be zero anyway if no responses
-// occurred. Now with qdn we need to leave them alone as we may have deferred
-// a fast dispatch because we were waiting for more than one responder.
-//
-   while(1)
-        {isWaiting.Wait();
-         myMutex.Lock();
-         while(1)
-              {myClock++;
-               myMutex.UnLock();
-               XrdSysTimer::Wait(Tslice);
-               myMutex.Lock();
-               while((sp=waitQ.Next()->Item()) && sp->Expire < myClock)
-                    {sp->Link.Remove();
-                     if (readyQ.Singleton()) isReady.Post();
-//                   sp->Arg1 = 0; sp->Arg2 = 0;
-//                   DEBUG("expired slot " <<sp->slotNum);
-                     readyQ.Prev()->Insert(&sp->Link);
-                    }
-               if (waitQ.Singleton()) break;
-              }
-         myMutex.UnLock();
-        }
+// The free list is a stack of slot numbers. Its head carries a tag that is
+// bumped on every change so that a slot popped and pushed back in between
+// cannot fool a concurrent pop.
 
-// Keep the compiler happy
-//
-   return (void *)0;
+XrdCmsRRQSlot *XrdCmsRRQ::GetSlot()
+{
+   unsigned long long head = freeHead.load(std::memory_order_acquire), next;
+   int snum;
+
+   do {if (!(snum = static_cast<int>(head & 0xffffffff))) return 0;
+       next = ((head >> 32) + 1) << 32
+            | static_cast<unsigned int>(Slot[snum].freeNext.load(
+                                        std::memory_order_relaxed));
+      } while(!freeHead.compare_exchange_weak(head, next,
+                                              std::memory_order_acquire,
+                                              std::memory_order_acquire));
+   return &Slot[snum];
 }
 
 /******************************************************************************/
-/*           X r d C m s R R Q S l o t   C l a s s   M e t h o d s            */
-/******************************************************************************/
-/******************************************************************************/
-/*                           C o n s t r u c t o r                            */
+/*                               P u t S l o t                                */
 /******************************************************************************/
 
-XrdCmsRRQSlot::XrdCmsRRQSlot() : Link(this)
+void XrdCmsRRQ::PutSlot(XrdCmsRRQSlot *sp)
 {
-
-   slotNum  = initSlot++;
-   if (slotNum)
-      {Cont     = freeSlot;
-       freeSlot = this;
-      } else Cont = 0;
-   Arg1 = Arg2 = 0;
-   Info.Key = 0;
+   unsigned long long head = freeHead.load(std::memory_order_relaxed), next;
+
+   sp->Info.Key = 0;
+   sp->State.store(XrdCmsRRQSlot::isFree, std::memory_order_relaxed);
+   do {sp->freeNext.store(static_cast<int>(head & 0xffffffff),
+                          std::memory_order_relaxed);
+       next = ((head >> 32) + 1) << 32 | static_cast<unsigned int>(sp->slotNum);
+      } while(!freeHead.compare_exchange_weak(head, next,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
 }
 
 /******************************************************************************/
-/*                                 A l l o c                                  */
+/*                               R e c y c l e                                */
 /******************************************************************************/
-  
-XrdCmsRRQSlot *XrdCmsRRQSlot::Alloc(XrdCmsRRQInfo *theInfo)
+
+void XrdCmsRRQ::Recycle(XrdCmsRRQSlot *sp)
 {
-   XrdCmsRRQSlot *sp;
+   XrdCmsRRQSlot *xp, *np;
 
-   myMutex.Lock();
-   if ((sp = freeSlot))
-      {sp->Info = *theInfo;
-       freeSlot = sp->Cont;
-       sp->Cont = 0;
-       sp->LkUp = 0;
-       sp->Arg1 = 0;
-       sp->Arg2 = 0;
-      }
-   myMutex.UnLock();
-   return sp;
+// Free items in the lookup chain and the select chain, then the slot itself
+//
+   np = sp->LkUp;
+   while((xp = np)) {np = xp->LkUp; PutSlot(xp);}
+   np = sp->Cont;
+   while((xp = np)) {np = xp->Cont; PutSlot(xp);}
+   PutSlot(sp);
 }
 
 /******************************************************************************/
-/*                               R e c y c l e                                */
+/*                              S c h e d u l e                               */
 /******************************************************************************/
-  
-void XrdCmsRRQSlot::Recycle()
-{
-   XrdCmsRRQSlot *sp, *np;
 
-   myMutex.Lock();
-   if (!Link.Singleton()) Link.Remove();
+void XrdCmsRRQ::Schedule(XrdCmsRRQSlot *sp)
+{
+   unsigned int expTick = myClock.load() + 1;
+   int snum = sp->slotNum;
 
-// Remove items in the lookup chain first
+// Publish the slot as waiting and enter it into the wheel. The timeout thread
+// is only woken when the first request starts waiting.
 //
-   np = LkUp;
-   while((sp = np))
-        {np           = sp->LkUp;
-         sp->Cont     = freeSlot;
-         freeSlot     = sp;
-         sp->Info.Key = 0;
-        }
+   sp->Expire.store(expTick, std::memory_order_relaxed);
+   sp->State.store(XrdCmsRRQSlot::isWait, std::memory_order_release);
+   Wheel[expTick % wheelSize][snum/64].fetch_or(1ULL << (snum % 64));
+   if (numWait++ == 0) isWaiting.Post();
+}
 
-// Now remove items in the select chain
-//
-   np = Cont;
-   while((sp = np))
-        {np           = sp->Cont;
-         sp->Cont     = freeSlot;
-         freeSlot     = sp;
-         sp->Info.Key = 0;
-        }
+/******************************************************************************/
+/*                                W a i t e d                                 */
+/******************************************************************************/
 
-// Now put this item in the free chain
-//
-   Info.Key = 0;
-   Cont     = freeSlot;
-   freeSlot = this;
-   myMutex.UnLock();
+// Record how long each request answered with this slot waited. Only the
+// responder thread calls this so the maximum needs no compare and swap.
+
+void XrdCmsRRQ::Waited(XrdCmsRRQSlot *sp)
+{
+   long long now = Now();
+   XrdCmsRRQSlot *xp;
+
+   auto record = [&](XrdCmsRRQSlot *rp)
+                 {long long wait = now - rp->Born;
+                  int i;
+                  if (wait < 0) wait = 0;
+                  for (i = 0; i < waitHistN-1 && (1LL << i) <= wait; i++) {}
+                  waitHist[i]++;
+                  waitTot += wait;
+                  if (wait > waitMax) waitMax = wait;
+                 };
+
+   record(sp);
+   for (xp = sp->LkUp; xp; xp = xp->LkUp) record(xp);
+   for (xp = sp->Cont; xp; xp = xp->Cont) record(xp);
 }
@@ -30,14 +30,15 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <atomic>
 #include <sys/uio.h>
 
 #include "XProtocol/XPtypes.hh"
 #include "XProtocol/YProtocol.hh"
 
 #include "XrdCms/XrdCmsTypes.hh"
-#include "XrdOuc/XrdOucDLlist.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include "XrdSys/XrdSysRAtomic.hh"
   
 /******************************************************************************/
 /*                         X r d C m s R R Q I n f o                          */
@@ -69,31 +70,52 @@ SMask_t   rwVec;   // R/W servers for corresponding path (if isLU is true)
 /******************************************************************************/
 /*                         X r d C m s R R Q S l o t                          */
 /******************************************************************************/
-  
+
+// A slot holds one pending request. Slots live in a fixed array and are found
+// by their number, which is what the cache remembers as the pending request.
+// Ownership of a slot passes between threads by atomically changing its state;
+// only the thread that moved a slot into isBusy or isSent may touch its other
+// members until it moves the slot on.
+//
 class XrdCmsRRQSlot
 {
 friend class XrdCmsRRQ;
 
-static XrdCmsRRQSlot *Alloc(XrdCmsRRQInfo *Info);
+public:
 
-       void           Recycle();
+// An answerer may look at a request and at the ones chained to it
+//
+const XrdCmsRRQInfo &getInfo()  const {return Info;}
+      SMask_t        getArg1()  const {return Arg1;}
+      SMask_t        getArg2()  const {return Arg2;}
+      XrdCmsRRQSlot *nextCont() const {return Cont;}
+      XrdCmsRRQSlot *nextLkUp() const {return LkUp;}
 
-       XrdCmsRRQSlot();
+       XrdCmsRRQSlot() : State(isFree), freeNext(0), Cont(0), LkUp(0), Next(0),
+                         Arg1(0), Arg2(0), Expire(0), Born(0), slotNum(0)
+                       {Info.Key = 0;}
       ~XrdCmsRRQSlot() {}
 
 private:
 
-static   XrdSysMutex                 myMutex;
-static   XrdCmsRRQSlot              *freeSlot;
-static   short                       initSlot;
+enum  sState {isFree = 0, // On the free list
+              isWait,     // Waiting for responses
+              isBusy,     // Being updated by whoever moved it here
+              isReady,    // On the ready list
+              isSent,     // Being responded to
+              isChained   // Piggy-backed onto another slot
+             };
 
-         XrdOucDLlist<XrdCmsRRQSlot> Link;
+         std::atomic<int>            State;
+         std::atomic<int>            freeNext;
          XrdCmsRRQSlot              *Cont;
          XrdCmsRRQSlot              *LkUp;
+         XrdCmsRRQSlot              *Next;
          XrdCmsRRQInfo               Info;
          SMask_t                     Arg1;
          SMask_t                     Arg2;
-unsigned int                         Expire;
+         std::atomic<unsigned int>   Expire;
+         long long                   Born;
          int                         slotNum;
 };
 
@@ -105,16 +127,40 @@ class XrdCmsRRQ
 {
 public:
 
+// Requests that stopped waiting are handed to an answerer, one slot at a time.
+// Requests for the same key that were piggy-backed are chained to the slot.
+//
+class Answerer
+{
+public:
+virtual void Answer(XrdCmsRRQSlot *sp) = 0;
+
+             Answerer() {}
+virtual     ~Answerer() {}
+};
+
 short Add(short Snum, XrdCmsRRQInfo *ip);
 
 void  Del(short Snum, const void *Key);
 
+// Expire() readies the requests that timed out at the given tick and returns
+// how many it readied. Tick() returns the current tick and starts the next.
+//
+int   Expire(unsigned int tick);
+
+unsigned int Tick() {return myClock++;}
+
 int   Init(int Tint=0, int Tdly=0);
 
 int   Ready(int Snum, const void *Key, SMask_t mask1, SMask_t mask2);
 
 void *Respond();
 
+// Serve() answers all ready requests in arrival order and frees their slots.
+// It returns the number of slots answered. Only one thread may call it.
+//
+int   Serve(Answerer &ans);
+
 struct Info
       {
         Info()
@@ -129,6 +175,11 @@ struct Info
 	 luSlow = 0;
 	 rdFast = 0;
 	 rdSlow = 0;
+	 Waits  = 0;
+	 WaitAvg= 0;
+	 WaitP50= 0;
+	 WaitP99= 0;
+	 WaitMax= 0;
 	}
 
        long long Add2Q;    // Number added to queue
@@ -139,30 +190,55 @@ struct Info
        long long luSlow;   // Slow lookups
        long long rdFast;   // Fast redirects
        long long rdSlow;   // Slow redirects
+       long long Waits;    // Number of requests answered
+       long long WaitAvg;  // Average usec a request waited for its answer
+       long long WaitP50;  // Median wait in usec (power of 2 upper bound)
+       long long WaitP99;  // 99th percentile wait in usec (ditto)
+       long long WaitMax;  // Longest wait in usec
       };
 
-void  Statistics(Info &Data) {myMutex.Lock(); Data = Stats; myMutex.UnLock();}
+void  Statistics(Info &Data);
 
 void *TimeOut();
 
-      XrdCmsRRQ() : isWaiting(0), isReady(0),
-                    luFast(0),    luSlow(0),  rdFast(0), rdSlow(0),
-                    Tslice(178),  Tdelay(5),  myClock(0) {}
+      XrdCmsRRQ();
      ~XrdCmsRRQ() {}
 
 private:
 
+class Sender;
+
+void           Answer(XrdCmsRRQSlot *sp);
+bool           Claim(XrdCmsRRQSlot *sp, int &from);
+void           Enqueue(XrdCmsRRQSlot *sp);
+XrdCmsRRQSlot *GetSlot();
+void           PutSlot(XrdCmsRRQSlot *sp);
+void           Recycle(XrdCmsRRQSlot *sp);
+void           Schedule(XrdCmsRRQSlot *sp);
+void           Waited(XrdCmsRRQSlot *sp);
 void sendLocResp(XrdCmsRRQSlot *lP);
 void sendLwtResp(XrdCmsRRQSlot *rP);
 void sendRedResp(XrdCmsRRQSlot *rP);
 static const int numSlots = 1024;
 
-         XrdSysMutex                   myMutex;
+// The timer wheel has a bucket per clock tick, each a bit vector of the slots
+// that expire at that tick. Requests expire one tick after they were added so
+// only a few buckets are ever in use.
+//
+static const int wheelSize = 4;
+static const int wheelWords= numSlots/64;
+
+// Waits are kept in a histogram with power of two usec buckets
+//
+static const int waitHistN = 24;
+
          XrdSysSemaphore               isWaiting;
          XrdSysSemaphore               isReady;
          XrdCmsRRQSlot                 Slot[numSlots];
-         XrdOucDLlist<XrdCmsRRQSlot>   waitQ;
-         XrdOucDLlist<XrdCmsRRQSlot>   readyQ;  // Redirect/Locate ready queue
+         std::atomic<unsigned long long> freeHead; // Tag << 32 | slot number
+         std::atomic<XrdCmsRRQSlot *>  readyHead;  // Redirect/Locate ready list
+         std::atomic<unsigned long long> Wheel[wheelSize][wheelWords];
+         std::atomic<int>              numWait;
 static   const int                     iov_cnt = 2;
          struct iovec                  data_iov[iov_cnt];
          struct iovec                  redr_iov[iov_cnt];
@@ -173,14 +249,20 @@ union   {char                          hostbuff[288];
          char                          databuff[XrdCms::CmsLocateRequest::RHLen
                                                *STMax];
         };
-         Info                          Stats;
-         int                           luFast;
-         int                           luSlow;
-         int                           rdFast;
-         int                           rdSlow;
+         RAtomic_llong                 Add2Q;
+         RAtomic_llong                 PBack;
+         RAtomic_llong                 Resp;
+         RAtomic_llong                 Multi;
+         RAtomic_llong                 luFast;
+         RAtomic_llong                 luSlow;
+         RAtomic_llong                 rdFast;
+         RAtomic_llong                 rdSlow;
+         RAtomic_llong                 waitHist[waitHistN];
+         RAtomic_llong                 waitTot;
+         RAtomic_llong                 waitMax;
          int                           Tslice;
          int                           Tdelay;
-unsigned int                           myClock;
+         std::atomic<unsigned int>     myClock;
 };
 
 namespace XrdCms
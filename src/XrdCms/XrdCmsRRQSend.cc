@@ -0,0 +1,330 @@
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d C m s R R Q S e n d . c c                       */
+/*                                                                            */
+/* (c) 2007 by the Board of Trustees of the Leland Stanford, Jr., University  */
+/*                            All Rights Reserved                             */
+/*   Produced by Andrew Hanushevsky for Stanford University under contract    */
+/*              DE-AC02-76-SFO0515 with the Department of Energy              */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <cstring>
+#include <sys/types.h>
+#include <netinet/in.h>
+
+#include "XrdCms/XrdCmsCluster.hh"
+#include "XrdCms/XrdCmsNode.hh"
+#include "XrdCms/XrdCmsRRQ.hh"
+#include "XrdCms/XrdCmsRTable.hh"
+#include "XrdCms/XrdCmsTrace.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysTimer.hh"
+
+using namespace XrdCms;
+
+// Note: These are the threads that answer and expire the requests held in the
+//       request queue (see XrdCmsRRQ.cc), along with the responses they send.
+  
+/******************************************************************************/
+/*                    X r d C m s R R Q : : S e n d e r                       */
+/******************************************************************************/
+
+// The responder answers requests by sending the responses to the redirectors
+
+class XrdCmsRRQ::Sender : public XrdCmsRRQ::Answerer
+{
+public:
+void Answer(XrdCmsRRQSlot *sp) override {rrq.Answer(sp);}
+
+     Sender(XrdCmsRRQ &q) : rrq(q) {}
+    ~Sender() {}
+private:
+XrdCmsRRQ &rrq;
+};
+
+/******************************************************************************/
+/*                    E x t e r n a l   F u n c t i o n s                     */
+/******************************************************************************/
+  
+void *XrdCmsRRQ_StartTimeOut(void *parg) {return RRQ.TimeOut();}
+
+void *XrdCmsRRQ_StartRespond(void *parg) {return RRQ.Respond();}
+
+/******************************************************************************/
+/*               X r d C m s R R Q   C l a s s   M e t h o d s                */
+/******************************************************************************/
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+  
+int XrdCmsRRQ::Init(int Tint, int Tdly)
+{
+   int rc;
+   pthread_t tid;
+
+// Set values
+//
+   if (Tint) Tslice = Tint;
+   if (Tdly) Tdelay = Tdly;
+
+// Fill out the response structure
+//
+   dataResp.Hdr.streamid = 0;
+   dataResp.Hdr.rrCode   = kYR_data;
+   dataResp.Hdr.modifier = 0;
+   dataResp.Hdr.datalen  = 0;
+   dataResp.Val          = 0;
+
+// Fill out the data i/o vector
+//
+   data_iov[0].iov_base = (char *)&dataResp;
+   data_iov[0].iov_len  = sizeof(dataResp);
+   data_iov[1].iov_base = databuff;;
+
+// Fill out the response structure
+//
+   redrResp.Hdr.streamid = 0;
+   redrResp.Hdr.rrCode   = kYR_redirect;
+   redrResp.Hdr.modifier = 0;
+   redrResp.Hdr.datalen  = 0;
+   redrResp.Val          = 0;
+
+// Fill out the redirect i/o vector
+//
+   redr_iov[0].iov_base = (char *)&redrResp;
+   redr_iov[0].iov_len  = sizeof(redrResp);
+   redr_iov[1].iov_base = hostbuff;;
+
+// Fill out the wait info
+//
+   waitResp.Hdr.streamid = 0;
+   waitResp.Hdr.rrCode   = kYR_wait;
+   waitResp.Hdr.modifier = 0;
+   waitResp.Hdr.datalen  = htons(static_cast<unsigned short>(sizeof(waitResp.Val)));
+   waitResp.Val          = htonl(Tdelay);
+
+// Start the responder thread
+//
+   if ((rc = XrdSysThread::Run(&tid, XrdCmsRRQ_StartRespond, (void *)0,
+                               0, "Request Responder")))
+      {Say.Emsg("Config", rc, "create request responder thread");
+       return 1;
+      }
+
+// Start the timeout thread
+//
+   if ((rc = XrdSysThread::Run(&tid, XrdCmsRRQ_StartTimeOut, (void *)0,
+                               0, "Request Timeout")))
+      {Say.Emsg("Config", rc, "create request timeout thread");
+       return 1;
+      }
+
+// All done
+//
+   return 0;
+}
+
+/******************************************************************************/
+/*                               R e s p o n d                                */
+/******************************************************************************/
+  
+void *XrdCmsRRQ::Respond()
+{
+// EPNAME("RRQ Respond");
+   Sender mySender(*this);
+
+// In an endless loop, process all ready elements.
+//
+   do {isReady.Wait();     // DEBUG("responder awoken");
+       Serve(mySender);
+      } while(1);
+
+// Keep the compiler happy
+//
+   return (void *)0;
+}
+
+/******************************************************************************/
+/*                               T i m e O u t                                */
+/******************************************************************************/
+  
+void *XrdCmsRRQ::TimeOut()
+{
+// EPNAME("RRQ TimeOut");
+   unsigned int tick;
+
+// We measure millisecond intervals to timeout waiting requests. Each tick we
+// expire the requests in the wheel bucket of the previous tick.
+//
+   while(1)
+        {isWaiting.Wait();
+         do {tick = myClock++;
+             XrdSysTimer::Wait(Tslice);
+             Expire(tick);
+            } while(numWait.load() > 0);
+        }
+
+// Keep the compiler happy
+//
+   return (void *)0;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                A n s w e r                                 */
+/******************************************************************************/
+
+void XrdCmsRRQ::Answer(XrdCmsRRQSlot *sp)
+{
+// A locate request can be pggy-backed on a select request and vice-versa
+// We separate the two queues here as each has a different response.
+//
+   if (sp->Info.isLU)
+      {if (sp->Cont)
+          {sp->Cont->Arg1 = sp->Arg1;
+           sendRedResp(sp->Cont);
+          }
+       sendLocResp(sp);
+      } else {
+       if (sp->LkUp)
+          {sp->LkUp->Arg1 = sp->Arg1; sp->LkUp->Arg2 = sp->Arg2;
+           sendLocResp(sp->LkUp);
+          }
+       sendRedResp(sp);
+      }
+}
+
+/******************************************************************************/
+/*                           s e n d L o c R e s p                            */
+/******************************************************************************/
+  
+void XrdCmsRRQ::sendLocResp(XrdCmsRRQSlot *lP)
+{
+   static const int ovhd = sizeof(kXR_unt32);
+   XrdCmsSelected *sP;
+   XrdCmsNode *nP;
+   XrdCmsCluster::CmsLSOpts lsopts;
+   int bytes;
+   bool oksel;
+
+// Send a delay if we timed out
+//
+   if (!(lP->Arg1))
+      {sendLwtResp(lP);
+       return;
+      }
+
+// Get the list of servers that have this file. If none found, then force the
+// client to wait as this should never happen and the long path is called for.
+// ASAP responses always respond in with IPv6 addresses or mapped IPv4 ones.
+//
+   lsopts = static_cast<XrdCmsCluster::CmsLSOpts>(lP->Info.lsLU);
+   if (!(sP = Cluster.List(lP->Arg1, lsopts, oksel))
+   || (!(bytes = XrdCmsNode::do_LocFmt(databuff,sP,lP->Arg2,lP->Info.rwVec))))
+      {sendLwtResp(lP);
+       return;
+      }
+
+// Complete the I/O vector
+//
+   bytes++;
+   data_iov[1].iov_len  = bytes;
+   bytes += ovhd;
+   dataResp.Hdr.datalen = htons(static_cast<unsigned short>(bytes));
+   bytes += sizeof(dataResp.Hdr);
+
+// Send the reply to each waiting redirector
+//
+   RTable.Lock();
+   do {if ((nP = RTable.Find(lP->Info.Rnum, lP->Info.Rinst)))
+          {dataResp.Hdr.streamid = lP->Info.ID;
+           nP->Send(data_iov, iov_cnt, bytes);
+          }
+       luFast++;
+      } while((lP = lP->LkUp));
+   RTable.UnLock();
+}
+
+/******************************************************************************/
+/*                           s e n d L w t R e s p                            */
+/******************************************************************************/
+  
+void XrdCmsRRQ::sendLwtResp(XrdCmsRRQSlot *rP)
+{
+// EPNAME("sendLwtResp");
+   XrdCmsNode *nP;
+
+// For each request, find the redirector and ask it to send a wait
+//
+   RTable.Lock();
+do{if ((nP = RTable.Find(rP->Info.Rnum, rP->Info.Rinst)))
+      {waitResp.Hdr.streamid = rP->Info.ID; luSlow++;
+       nP->Send((char *)&waitResp, sizeof(waitResp));
+//     DEBUG("Redirect delay " <<nP->Name() <<' ' <<Tdelay);
+      }
+//    else {DEBUG("redirector " <<Info->Rnum <<'.' <<Info->Rinst <<"not found");}
+  } while((rP = rP->LkUp));
+   RTable.UnLock();
+}
+  
+/******************************************************************************/
+/*                           s e n d R e d R e s p                            */
+/******************************************************************************/
+  
+void XrdCmsRRQ::sendRedResp(XrdCmsRRQSlot *rP)
+{
+// EPNAME("sendRedResp");
+   static const int ovhd = sizeof(kXR_unt32);
+   XrdCmsNode *nP;
+   int doredir = 0, port = 0, hlen = 0;
+
+// Determine where the client should be redirected
+//
+   if ((doredir = (rP->Arg1 && Cluster.Select(rP->Arg1, port, hostbuff, hlen,
+                                              rP->Info.isRW, rP->Info.actR,
+                                              rP->Info.ifOP))))
+      {redrResp.Val = htonl(port);
+       redrResp.Hdr.datalen = htons(static_cast<unsigned short>(hlen+ovhd));
+       redr_iov[1].iov_len  = hlen;
+       hlen += ovhd + sizeof(redrResp.Hdr);
+      }
+
+// For each request, find the redirector and ask it to send the message
+//
+   RTable.Lock();
+do{if ((nP = RTable.Find(rP->Info.Rnum, rP->Info.Rinst)))
+      {if (doredir){redrResp.Hdr.streamid = rP->Info.ID; rdFast++;
+                    nP->Send(redr_iov, iov_cnt, hlen);
+//                  DEBUG("Fast redirect " <<nP->Name() <<" -> " <<hostbuff);
+                   }
+              else {waitResp.Hdr.streamid = rP->Info.ID; rdSlow++;
+                    nP->Send((char *)&waitResp, sizeof(waitResp));
+//                  DEBUG("Redirect delay " <<nP->Name() <<' ' <<Tdelay);
+                   }
+      } 
+//    else {DEBUG("redirector " <<Info->Rnum <<'.' <<Info->Rinst <<"not found");}
+  } while((rP = rP->Cont));
+   RTable.UnLock();
+}
@@ -117,13 +117,14 @@ void XrdCmsRTable::Send(const char *What, const char *data, int dlen)
    EPNAME("Send");
    int i;
 
-// Send the data to all nodes in this table
+// Send the data to all nodes in this table. Redirectors are never sent
+// batched messages so there is nothing to flush (see XrdCmsNode::Send()).
 //
    myMutex.Lock();
    for (i = 1; i <= Hwm; i++) 
        if (Rtable[i])
           {DEBUG(What <<" to " <<Rtable[i]->Ident);
-           Rtable[i]->Send(data, dlen);
+           Rtable[i]->Post(data, dlen);
           }
    myMutex.UnLock();
 }
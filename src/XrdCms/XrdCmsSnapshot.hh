@@ -0,0 +1,107 @@
+#ifndef XRDCMSSNAPSHOT__H
+#define XRDCMSSNAPSHOT__H
+/******************************************************************************/
+/*                                                                            */
+/*                     X r d C m s S n a p s h o t . h h                      */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <atomic>
+#include <thread>
+
+// The XrdCmsSnapshot template holds a read-mostly object that readers access
+// without taking a lock. There are two copies of the object. Readers pin the
+// current copy by bumping its reader count and writers fill in the other copy
+// and then flip the current index. Publish() returns only after every reader
+// of the previous copy has left. So, anything that was reachable only through
+// the previous copy may be safely released once Publish() returns. Writers
+// must be serialized by the caller; readers never block.
+//
+template<class T>
+class XrdCmsSnapshot
+{
+struct Copy_t
+      {T                Data;
+       std::atomic<int> Readers;
+       Copy_t() : Data(), Readers(0) {}
+      };
+
+public:
+
+// A Reader pins the current copy for its lifetime. Readers must not wait on
+// anything that a writer may hold while calling Publish().
+//
+class Reader
+{
+public:
+
+const T  &operator*()  const {return snCopy->Data;}
+const T  *operator->() const {return &(snCopy->Data);}
+
+          Reader(XrdCmsSnapshot &snap)
+                {int i;
+                 do {i = snap.Now.load();
+                     snCopy = &snap.Copy[i];
+                     snCopy->Readers++;
+                     if (i == snap.Now.load()) break;
+                     snCopy->Readers--;
+                    } while(true);
+                }
+
+         ~Reader() {snCopy->Readers--;}
+
+private:
+         Reader(const Reader &) = delete;
+Reader  &operator=(const Reader &) = delete;
+
+Copy_t   *snCopy;
+};
+
+// Publish a new value. The caller must serialize all calls to this method.
+//
+void      Publish(const T &val)
+                 {int nxt = 1 - Now.load();
+                  Drain(nxt);
+                  Copy[nxt].Data = val;
+                  Now.store(nxt);
+                  Drain(1 - nxt);
+                  Pubs++;
+                 }
+
+long long Publishes() const {return Pubs.load();}
+
+          XrdCmsSnapshot() : Now(0), Pubs(0) {}
+         ~XrdCmsSnapshot() {}
+
+private:
+
+// A reader that picked up a stale index may briefly bump the count of the
+// other copy before backing off, so we simply spin until the count settles.
+//
+void      Drain(int i)
+                 {while(Copy[i].Readers.load()) std::this_thread::yield();}
+
+Copy_t                 Copy[2];
+std::atomic<int>       Now;
+std::atomic<long long> Pubs;
+};
+#endif
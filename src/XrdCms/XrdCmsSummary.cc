@@ -0,0 +1,281 @@
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d C m s S u m m a r y . c c                       */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "XProtocol/YProtocol.hh"
+
+#include "XrdCms/XrdCmsBloom.hh"
+#include "XrdCms/XrdCmsConfig.hh"
+#include "XrdCms/XrdCmsManager.hh"
+#include "XrdCms/XrdCmsPList.hh"
+#include "XrdCms/XrdCmsSummary.hh"
+#include "XrdCms/XrdCmsTrace.hh"
+
+#include "XrdOss/XrdOss.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysTimer.hh"
+
+using namespace XrdCms;
+
+/******************************************************************************/
+/*                        G l o b a l   O b j e c t s                         */
+/******************************************************************************/
+
+       XrdCmsSummary   XrdCms::Summary;
+
+/******************************************************************************/
+/*                    E x t e r n a l   F u n c t i o n s                     */
+/******************************************************************************/
+
+void *XrdCmsSummary_Start(void *parg) {return Summary.Summarize();}
+
+/******************************************************************************/
+/*                                   A d d                                    */
+/******************************************************************************/
+
+void XrdCmsSummary::Add(const char *lfn)
+{
+   unsigned long long h;
+
+// Add the file to the current filter and, if we are walking the namespace,
+// remember it so that the filter being built also gets it.
+//
+   if (!sumInt) return;
+   h = XrdCmsBloom::Hash(lfn);
+   sumCV.Lock();
+   if (sumBloom) sumBloom->Add(h);
+   if (inScan) scanAdds.push_back(h);
+   sumCV.UnLock();
+}
+
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+
+int XrdCmsSummary::Init(int every, int bitsPer)
+{
+   pthread_t tid;
+   int rc;
+
+// Start the summary thread
+//
+   if (every <= 0) return 0;
+   sumInt  = every;
+   sumBits = bitsPer;
+   if ((rc = XrdSysThread::Run(&tid, XrdCmsSummary_Start, (void *)0,
+                               0, "Namespace summary")))
+      sumInt = 0;
+   return rc;
+}
+
+/******************************************************************************/
+/*                                R e s e n d                                 */
+/******************************************************************************/
+
+void XrdCmsSummary::Resend()
+{
+   if (!sumInt) return;
+   sumCV.Lock();
+   doResend = true;
+   sumCV.Signal();
+   sumCV.UnLock();
+}
+
+/******************************************************************************/
+/*                             S u m m a r i z e                              */
+/******************************************************************************/
+
+void *XrdCmsSummary::Summarize()
+{
+   time_t nextBuild = 0;
+   bool   resend;
+
+// Rebuild the filter every interval and send it each time we do so or when
+// asked to. A resend is delayed a bit so that the login can complete.
+//
+   do {if (time(0) >= nextBuild)
+          {Build();
+           nextBuild = time(0) + sumInt;
+           Send(sumBloom);
+          }
+       sumCV.Lock();
+       if (!doResend)
+          {int wt = static_cast<int>(nextBuild - time(0));
+           if (wt > 0) sumCV.Wait(wt);
+          }
+       resend = doResend; doResend = false;
+       sumCV.UnLock();
+       if (resend)
+          {XrdSysTimer::Snooze(2);
+           if (time(0) < nextBuild) Send(sumBloom);
+          }
+      } while(1);
+
+   return (void *)0;
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                 B u i l d                                  */
+/******************************************************************************/
+
+void XrdCmsSummary::Build()
+{
+   EPNAME("Summary");
+   std::vector<unsigned long long> hVec;
+   std::string path;
+   XrdCmsPList *pP, *xP;
+   XrdCmsBloom *bP, *oldP;
+   size_t plen;
+
+// Indicate that a walk is in progress so that new files are not lost
+//
+   sumCV.Lock();
+   inScan = true;
+   scanAdds.clear();
+   sumCV.UnLock();
+
+// Walk each exported path unless it lies within one we already walk
+//
+   for (pP = Config.PathList.First(); pP; pP = pP->Next())
+       {for (xP = Config.PathList.First(); xP; xP = xP->Next())
+            {plen = strlen(xP->Path());
+             if (xP != pP && !strncmp(xP->Path(), pP->Path(), plen)
+             &&  (xP->Path()[plen-1] == '/' || pP->Path()[plen] == '/'
+                                            || !pP->Path()[plen])
+             &&  strcmp(xP->Path(), pP->Path())) break;
+            }
+        if (xP) continue;
+        path = pP->Path();
+        Walk(path, hVec, 0);
+       }
+
+// Build the new filter sized for what we found with room to grow and make it
+// the current one.
+//
+   sumCV.Lock();
+   hVec.insert(hVec.end(), scanAdds.begin(), scanAdds.end());
+   scanAdds.clear();
+   inScan = false;
+   bP = new XrdCmsBloom(XrdCmsBloom::Size(hVec.size() + hVec.size()/4,
+                                          sumBits),
+                        XrdCmsBloom::HashCnt(sumBits));
+   for (auto h : hVec) bP->Add(h);
+   oldP = sumBloom; sumBloom = bP;
+   sumCV.UnLock();
+   delete oldP;
+
+   DEBUG(hVec.size() <<" files in " <<bP->Bytes() <<" byte filter");
+}
+
+/******************************************************************************/
+/*                                  S e n d                                   */
+/******************************************************************************/
+
+void XrdCmsSummary::Send(XrdCmsBloom *bP)
+{
+   EPNAME("Summary");
+   CmsRRHdr       Hdr = {0, kYR_summary, kYR_raw, 0};
+   CmsSummaryData Info;
+   char           Piece[maxPiece];
+   struct iovec   ioV[3] = {{(char *)&Hdr,  sizeof(Hdr)},
+                            {(char *)&Info, sizeof(Info)},
+                            {Piece,         0}};
+   int n, offs = 0, ttl = sumInt*3;
+
+// Send the filter in pieces. All pieces have the same generation number so
+// that the manager can tell when a new transmission starts. Each piece is
+// copied under the lock that Add() sets bits under; it is sent without it.
+//
+   Info.Gen    = htonl(++sumGen);
+   Info.Total  = htonl(static_cast<kXR_unt32>(bP->Bytes()));
+   Info.TTL    = htons(static_cast<kXR_unt16>(ttl > 65535 ? 65535 : ttl));
+   Info.Hashes = static_cast<kXR_char>(bP->Hashes());
+   Info.Rsvd   = 0;
+
+   while(1)
+        {sumCV.Lock();
+         n = bP->Get(offs, Piece, maxPiece);
+         sumCV.UnLock();
+         if (!n) break;
+         Info.Offset = htonl(static_cast<kXR_unt32>(offs));
+         Hdr.datalen = htons(static_cast<unsigned short>(sizeof(Info) + n));
+         ioV[2].iov_len = n;
+         XrdCmsManager::Inform("summary", ioV, 3, sizeof(Hdr)+sizeof(Info)+n);
+         offs += n;
+        }
+
+   DEBUG("sent " <<offs <<" byte filter gen " <<sumGen);
+}
+
+/******************************************************************************/
+/*                                  W a l k                                   */
+/******************************************************************************/
+
+void XrdCmsSummary::Walk(std::string &path,
+                         std::vector<unsigned long long> &hVec, int depth)
+{
+   XrdOucEnv   myEnv;
+   XrdOssDF   *dP;
+   std::vector<std::string> subDirs;
+   struct stat Stat;
+   char        eName[1024];
+   size_t      plen = path.size();
+   bool        statRet;
+
+// Open the directory. Paths that cannot be read are simply skipped.
+//
+   if (depth > 64 || !(dP = Config.ossFS->newDir("cmsd"))) return;
+   if (dP->Opendir(path.c_str(), myEnv)) {delete dP; return;}
+   statRet = (dP->StatRet(&Stat) == 0);
+   if (plen && path[plen-1] != '/') {path += '/'; plen++;}
+
+// Record every file and remember the subdirectories for later so that we only
+// hold one directory open at a time.
+//
+   while(!dP->Readdir(eName, sizeof(eName)) && *eName)
+        {if (*eName == '.' && (!eName[1] || (eName[1] == '.' && !eName[2])))
+            continue;
+         path.resize(plen); path += eName;
+         if (!statRet && Config.ossFS->Stat(path.c_str(), &Stat)) continue;
+              if (S_ISDIR(Stat.st_mode)) subDirs.push_back(path);
+         else if (S_ISREG(Stat.st_mode)) hVec.push_back(XrdCmsBloom::Hash(path.c_str()));
+        }
+   dP->Close();
+   delete dP;
+
+// Now do the subdirectories
+//
+   for (auto &sd : subDirs) Walk(sd, hVec, depth+1);
+}
@@ -0,0 +1,94 @@
+#ifndef __CMS_SUMMARY__H
+#define __CMS_SUMMARY__H
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d C m s S u m m a r y . h h                       */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <string>
+#include <vector>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdCmsBloom;
+
+/******************************************************************************/
+/*                         X r d C m s S u m m a r y                          */
+/******************************************************************************/
+
+// The XrdCmsSummary object runs on data servers. It periodically walks the
+// exported namespace, builds a Bloom filter of the file names it finds, and
+// sends the filter to all of our managers. In between, files that are created
+// are added to the current filter as the admin interface reports them so that
+// the next transmission includes them. Removed files linger until the next
+// walk, which only costs the manager an extra query.
+//
+class XrdCmsSummary
+{
+public:
+
+// Add() records a newly created file (the logical file name).
+//
+void         Add(const char *lfn);
+
+// Init() starts the summary thread. It returns 0 on success and errno o/w.
+//
+int          Init(int every, int bitsPer);
+
+// Resend() asks that the current filter be sent as soon as possible. This is
+// called when we log into a manager as it has no filter from us.
+//
+void         Resend();
+
+// Summarize() does the work (internal thread).
+//
+void        *Summarize();
+
+             XrdCmsSummary() : sumCV(0), sumBloom(0), sumGen(0), sumInt(0),
+                               sumBits(0), doResend(false), inScan(false) {}
+            ~XrdCmsSummary() {}
+
+static const int maxPiece = 16368; // Largest piece of a filter to send
+
+private:
+
+void         Build();
+void         Send(XrdCmsBloom *bP);
+void         Walk(std::string &path, std::vector<unsigned long long> &hVec,
+                  int depth);
+
+XrdSysCondVar    sumCV;      // Protects the members below
+XrdCmsBloom     *sumBloom;   // Current filter (replaced only by our thread)
+std::vector<unsigned long long> scanAdds; // Adds that came in during a walk
+unsigned int     sumGen;
+int              sumInt;
+int              sumBits;
+bool             doResend;
+bool             inScan;
+};
+
+namespace XrdCms
+{
+extern    XrdCmsSummary Summary;
+}
+#endif
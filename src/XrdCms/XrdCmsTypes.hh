@@ -30,13 +30,45 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
   
+// The following defines our cell size (maximum subscribers). By default a
+// manager tracks up to 64 nodes with a native 64-bit server mask. A larger
+// cell size (a multiple of 64, e.g. 256 or 1024) may be set at build time via
+// XRDCMS_MAXNODES in which case the server mask becomes a wide bit vector.
+// The cell size is local to the manager and does not change the protocol.
+//
+#include "XrdCms/XrdCmsCellSize.hh"
+
+#define STMax XRDCMS_MAXNODES
+
+#if XRDCMS_MAXNODES > 64
+
+#include "XrdCms/XrdCmsWideMask.hh"
+
+static_assert(XRDCMS_MAXNODES % 64 == 0, "XRDCMS_MAXNODES not a multiple of 64");
+
+typedef XrdCmsWideMask<XRDCMS_MAXNODES/64> SMask_t;
+
+#define FULLMASK SMask_t::Full()
+
+inline SMask_t XrdCmsMaskBit(int n)            {return SMask_t::Bit(n);}
+inline int     XrdCmsMaskCnt(const SMask_t &m) {return m.Count();}
+inline int     XrdCmsMaskLow(const SMask_t &m) {return m.LowBit();}
+inline bool    XrdCmsMaskMulti(const SMask_t &m) {return m.Multiple();}
+
+#else
+
 typedef unsigned long long SMask_t;
 
 #define FULLMASK 0xFFFFFFFFFFFFFFFFULL
 
-// The following defines our cell size (maximum subscribers)
-//
-#define STMax 64
+inline SMask_t XrdCmsMaskBit(int n)
+                      {return (n >= 0 && n < 64 ? 1ULL << n : 0ULL);}
+inline int     XrdCmsMaskCnt(const SMask_t &m) {return __builtin_popcountll(m);}
+inline int     XrdCmsMaskLow(const SMask_t &m)
+                      {return (m ? __builtin_ctzll(m) : -1);}
+inline bool    XrdCmsMaskMulti(const SMask_t &m) {return (m & (m - 1)) != 0;}
+
+#endif
 
 // The following defines the maximum number of redirectors. It is one greater
 // than the actual maximum as the zeroth is never used.
@@ -0,0 +1,132 @@
+#ifndef XRDCMSWIDEMASK__H
+#define XRDCMSWIDEMASK__H
+/******************************************************************************/
+/*                                                                            */
+/*                     X r d C m s W i d e M a s k . h h                      */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+// The XrdCmsWideMask template is a fixed size bit vector that stands in for
+// the native 64-bit server mask when a manager must track more than 64 nodes.
+// It behaves like an unsigned integer for the logical operations the cluster
+// code uses. The words are kept in a plain array and all operations are
+// straight loops over it so that the compiler can vectorize them.
+//
+template<int N>
+class XrdCmsWideMask
+{
+public:
+
+static const int Bits = N*64;
+
+unsigned long long W[N];
+
+// Population count and lowest set bit (-1 if none)
+//
+inline int     Count() const
+                    {int n = 0;
+                     for (int i = 0; i < N; i++) n += __builtin_popcountll(W[i]);
+                     return n;
+                    }
+
+inline int     LowBit() const
+                    {for (int i = 0; i < N; i++)
+                         if (W[i]) return i*64 + __builtin_ctzll(W[i]);
+                     return -1;
+                    }
+
+inline bool    Multiple() const
+                    {int n = 0;
+                     for (int i = 0; i < N; i++)
+                         if (W[i] && (n++ || (W[i] & (W[i]-1)))) return true;
+                     return false;
+                    }
+
+static XrdCmsWideMask Bit(int n)
+                    {XrdCmsWideMask m;
+                     if (n >= 0 && n < Bits) m.W[n >> 6] = 1ULL << (n & 63);
+                     return m;
+                    }
+
+static XrdCmsWideMask Full()
+                    {XrdCmsWideMask m;
+                     for (int i = 0; i < N; i++) m.W[i] = ~0ULL;
+                     return m;
+                    }
+
+// Logical operators
+//
+inline XrdCmsWideMask &operator&=(const XrdCmsWideMask &rhs)
+                    {for (int i = 0; i < N; i++) W[i] &= rhs.W[i];
+                     return *this;
+                    }
+inline XrdCmsWideMask &operator|=(const XrdCmsWideMask &rhs)
+                    {for (int i = 0; i < N; i++) W[i] |= rhs.W[i];
+                     return *this;
+                    }
+inline XrdCmsWideMask &operator^=(const XrdCmsWideMask &rhs)
+                    {for (int i = 0; i < N; i++) W[i] ^= rhs.W[i];
+                     return *this;
+                    }
+
+inline XrdCmsWideMask  operator~() const
+                    {XrdCmsWideMask m;
+                     for (int i = 0; i < N; i++) m.W[i] = ~W[i];
+                     return m;
+                    }
+
+friend XrdCmsWideMask  operator&(XrdCmsWideMask lhs, const XrdCmsWideMask &rhs)
+                    {return lhs &= rhs;}
+friend XrdCmsWideMask  operator|(XrdCmsWideMask lhs, const XrdCmsWideMask &rhs)
+                    {return lhs |= rhs;}
+friend XrdCmsWideMask  operator^(XrdCmsWideMask lhs, const XrdCmsWideMask &rhs)
+                    {return lhs ^= rhs;}
+
+friend bool            operator==(const XrdCmsWideMask &lhs,
+                                  const XrdCmsWideMask &rhs)
+                    {unsigned long long diff = 0;
+                     for (int i = 0; i < N; i++) diff |= lhs.W[i] ^ rhs.W[i];
+                     return diff == 0;
+                    }
+
+inline explicit operator bool() const
+                    {unsigned long long any = 0;
+                     for (int i = 0; i < N; i++) any |= W[i];
+                     return any != 0;
+                    }
+
+inline bool    operator!() const {return !static_cast<bool>(*this);}
+
+// Constructors. An integer initializer only sets the low order word as it
+// would for a native mask; use Full() for a mask with all bits set.
+//
+               XrdCmsWideMask() {for (int i = 0; i < N; i++) W[i] = 0;}
+
+               XrdCmsWideMask(unsigned long long v)
+                             {W[0] = v; for (int i = 1; i < N; i++) W[i] = 0;}
+
+               XrdCmsWideMask(int v)
+                             {W[0] = static_cast<unsigned long long>(v);
+                              for (int i = 1; i < N; i++) W[i] = 0;
+                             }
+};
+#endif
@@ -403,6 +403,7 @@ int XrdHttpReq::parseFirstLine(char *line, int len) {
     // keepalive is disabled by default.
     if (!strcmp(p+1, "HTTP/1.0\r\n")) {
       keepalive = false;
+      m_http10 = true;
     }
     line[pos] = ' ';
   }
@@ -2446,6 +2447,13 @@ int XrdHttpReq::PostProcessHTTPReq(bool final_) {
     {
 
       if (xrdresp == kXR_error) {
+        // Once the multistatus body is being streamed the status line has
+        // already gone out; all we can do is to truncate the response.
+        if (m_propfind_streaming) {
+          TRACEI(REQ, "PROPFIND listing of " << resource.c_str()
+                      << " failed after streaming started: " << etext);
+          return -1;
+        }
         prot->SendSimpleResp(httpStatusCode, NULL, NULL,
                              httpErrorBody.c_str(), httpErrorBody.length(), false);
         return -1;
@@ -2655,9 +2663,37 @@ int XrdHttpReq::PostProcessHTTPReq(bool final_) {
 
 
 
+          // For large directories the bridge delivers the listing in several
+          // partial responses. Rather than accumulating the whole body, stream
+          // each bunch of entries as a chunk as soon as it arrives so that the
+          // memory used stays bounded by a single partial response. Listings
+          // that fit in one response, and HTTP/1.0 clients that cannot take
+          // chunked responses, still get a single body with a content length.
+          std::string s = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<D:multistatus xmlns:D=\"DAV:\" xmlns:ns1=\"http://apache.org/dav/props/\" xmlns:ns0=\"DAV:\">\n";
+          if (!final_ && !m_http10) {
+            if (!m_propfind_streaming) {
+              if (prot->StartChunkedResp(207, "Multi-Status", "Content-Type: text/xml; charset=\"utf-8\"", -1, keepalive))
+                return -1;
+              m_propfind_streaming = true;
+              stringresp.insert(0, s);
+            }
+            if (!stringresp.empty() && prot->ChunkResp(stringresp.c_str(), stringresp.length()))
+              return -1;
+            stringresp.clear();
+            break;
+          }
+
+          if (final_ && m_propfind_streaming) {
+            stringresp += "</D:multistatus>\n";
+            if (prot->ChunkResp(stringresp.c_str(), stringresp.length()) ||
+                prot->ChunkResp(nullptr, 0))
+              return -1;
+            stringresp.clear();
+            return keepalive ? 1 : -1;
+          }
+
           // If this was the last bunch of entries, send the buffer and empty it immediately
           if (final_) {
-            std::string s = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<D:multistatus xmlns:D=\"DAV:\" xmlns:ns1=\"http://apache.org/dav/props/\" xmlns:ns0=\"DAV:\">\n";
             stringresp.insert(0, s);
             stringresp += "</D:multistatus>\n";
             prot->SendSimpleResp(207, (char *) "Multi-Status", (char *) "Content-Type: text/xml; charset=\"utf-8\"",
@@ -2837,6 +2873,8 @@ void XrdHttpReq::reset() {
   redirdest = "";
 
   stringresp = "";
+  m_http10 = false;
+  m_propfind_streaming = false;
 
   host = "";
   destination = "";
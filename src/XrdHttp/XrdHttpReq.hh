@@ -357,6 +357,12 @@ public:
   /// If we want to give a string as a response, we compose it here
   std::string stringresp;
 
+  /// The request line announced HTTP/1.0, hence no chunked responses
+  bool m_http10{false};
+
+  /// A PROPFIND multistatus body is being streamed to the client in chunks
+  bool m_propfind_streaming{false};
+
   /// State machine to talk to the bridge
   int reqstate;
 
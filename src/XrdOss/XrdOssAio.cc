@@ -102,6 +102,14 @@ const int OSS_AIO_WRITE_DONE = SIGRTMAX;
 int XrdOssFile::Fsync(XrdSfsAio *aiop)
 {
 
+// Use io_uring if it is running
+//
+   if (XrdOssUring::isOn())
+      {aiop->sfsAio.aio_fildes = fd;
+       aiop->TIdent = tident;
+       if (XrdOssUring::Fsync(ringFD(), aiop)) return 0;
+      }
+
 #ifdef _POSIX_ASYNCHRONOUS_IO
    int rc;
 
@@ -154,13 +162,26 @@ int XrdOssFile::Fsync(XrdSfsAio *aiop)
 int XrdOssFile::Read(XrdSfsAio *aiop)
 {
 
+// Use io_uring if it is running. Compressed files and direct reads, which may
+// need a bounce buffer, must be read synchronously. Memory mapped files are
+// simply copied from memory.
+//
+   if (XrdOssUring::isOn() && !cxobj && !(ioPol & polDIO) && !mmFile)
+      {aiop->sfsAio.aio_fildes = fd;
+       aiop->TIdent = tident;
+       if (XrdOssUring::Read(ringFD(), aiop))
+          {if (ioPol) Streamed(aiop->sfsAio.aio_offset, aiop->sfsAio.aio_nbytes);
+           return 0;
+          }
+      }
+
 #ifdef _POSIX_ASYNCHRONOUS_IO
    EPNAME("AioRead");
    int rc;
 
 // Complete the aio request block and do the operation
 //
-   if (XrdOssSys::AioAllOk)
+   if (XrdOssSys::AioAllOk && !(ioPol & polDIO) && !mmFile)
       {aiop->sfsAio.aio_fildes = fd;
        aiop->sfsAio.aio_sigevent.sigev_signo  = OSS_AIO_READ_DONE;
        aiop->TIdent = tident;
@@ -170,7 +191,11 @@ int XrdOssFile::Read(XrdSfsAio *aiop)
 
        // Start the operation
        //
-          if (!(rc = aio_read(&aiop->sfsAio))) return 0;
+          if (!(rc = aio_read(&aiop->sfsAio)))
+             {if (ioPol) Streamed(aiop->sfsAio.aio_offset,
+                                  aiop->sfsAio.aio_nbytes);
+              return 0;
+             }
           if (errno != EAGAIN && errno != ENOSYS) return -errno;
 
       // Aio failed keep track of the problem (msg every 1024 events). Note
@@ -194,6 +219,38 @@ int XrdOssFile::Read(XrdSfsAio *aiop)
    return 0;
 }
 
+/******************************************************************************/
+/*                                p g R e a d                                 */
+/******************************************************************************/
+
+/*
+  Function: Async read `blen' bytes from the associated file and compute the
+            page checksums into aiop->cksVec, if present.
+
+  Input:    aiop      - An aio request object
+            opts      - pgRead options.
+
+   Output:  <0 -> Operation failed, value is negative errno value.
+            =0 -> Operation queued or completed.
+*/
+
+int XrdOssFile::pgRead(XrdSfsAio *aiop, uint64_t opts)
+{
+
+// Only io_uring can do this asynchronously as the checksums must be computed
+// when the data arrives. Everything else is done the old way.
+//
+   if (XrdOssUring::isOn() && !cxobj && !(ioPol & polDIO) && !mmFile)
+      {aiop->sfsAio.aio_fildes = fd;
+       aiop->TIdent = tident;
+       if (XrdOssUring::Read(ringFD(), aiop, true))
+          {if (ioPol) Streamed(aiop->sfsAio.aio_offset, aiop->sfsAio.aio_nbytes);
+           return 0;
+          }
+      }
+   return XrdOssDF::pgRead(aiop, opts);
+}
+
 /******************************************************************************/
 /*                                 W r i t e                                  */
 /******************************************************************************/
@@ -211,6 +268,14 @@ int XrdOssFile::Read(XrdSfsAio *aiop)
   
 int XrdOssFile::Write(XrdSfsAio *aiop)
 {
+
+// Use io_uring if it is running
+//
+   if (XrdOssUring::isOn())
+      {aiop->sfsAio.aio_fildes = fd;
+       aiop->TIdent = tident;
+       if (XrdOssUring::Write(ringFD(), aiop)) return 0;
+      }
 #ifdef _POSIX_ASYNCHRONOUS_IO
    EPNAME("AioWrite");
    int rc;
@@ -37,6 +37,8 @@
 #include <signal.h>
 #include <strings.h>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #if defined(__linux__)
 #include <linux/fs.h>
 #endif
@@ -57,6 +59,8 @@
 #include "XrdOss/XrdOssConfig.hh"
 #include "XrdOss/XrdOssError.hh"
 #include "XrdOss/XrdOssMio.hh"
+#include "XrdOss/XrdOssReadV.hh"
+#include "XrdOss/XrdOssReadPol.hh"
 #include "XrdOss/XrdOssTrace.hh"
 #include "XrdOuc/XrdOucCloneSeg.hh"
 #include "XrdOuc/XrdOucEnv.hh"
@@ -457,7 +461,14 @@ int XrdOssSys::Stats(char *buff, int blen)
 {
    static const char statfmt1[] = "<stats id=\"oss\" v=\"2\">";
    static const char statfmt2[] = "</stats>";
-   static const int  statflen = sizeof(statfmt1) + sizeof(statfmt2);
+   static const char statfmtv[] = "<rv><req>%lld</req><seg>%lld</seg>"
+                                  "<io>%lld</io><gap>%lld</gap></rv>";
+   static const char statfmtp[] = "<pol><dio>%lld</dio><bnc>%lld</bnc>"
+                                  "<str>%lld</str><ra>%lld</ra>"
+                                  "<drop>%lld</drop></pol>";
+   static const int  statflen = sizeof(statfmt1) + sizeof(statfmt2)
+                              + sizeof(statfmtv) + 4*16
+                              + sizeof(statfmtp) + 5*16;
    char *bp = buff;
    int n;
 
@@ -476,6 +487,27 @@ int XrdOssSys::Stats(char *buff, int blen)
    n = getStats(bp, blen);
    bp += n; blen -= n;
 
+// Generate vector read statistics
+//
+   if (blen > 0)
+      {n = snprintf(bp, blen, statfmtv, static_cast<long long>(rvReqs),
+                    static_cast<long long>(rvSegs),
+                    static_cast<long long>(rvRuns),
+                    static_cast<long long>(rvGapB));
+       if (n < blen) {bp += n; blen -= n;}
+      }
+
+// Generate I/O policy statistics
+//
+   if (blen > 0)
+      {n = snprintf(bp, blen, statfmtp, static_cast<long long>(dioBytes),
+                    static_cast<long long>(dioBounce),
+                    static_cast<long long>(strBytes),
+                    static_cast<long long>(strRABytes),
+                    static_cast<long long>(strDropped));
+       if (n < blen) {bp += n; blen -= n;}
+      }
+
 // Add trailer
 //
    if (blen >= (int)sizeof(statfmt2))
@@ -889,10 +921,41 @@ int XrdOssFile::Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &Env)
           mopts |= OSSMIO_MLOK;
        if (popts & XRDEXP_MMAP  || Info.Attr.Flags & XrdFrcXAttrMem::memMap)
           mopts |= OSSMIO_MMAP;
+       if (!mopts && (popts & XRDEXP_MSMALL) && XrdOssMio::isSmall(buf.st_size))
+          mopts = OSSMIO_MMAP;
        if (mopts) mmFile = XrdOssMio::Map(local_path, fd, mopts);
       } else mmFile = 0;
 
    canClone = !(popts & XRDEXP_NOFICL);
+
+// Register the file with io_uring so that requests skip the file table lookup
+//
+   if (fd >= 0 && XrdOssUring::isOn()) ringReg = XrdOssUring::Register(fd);
+
+// Apply the I/O policy of the path. Direct I/O is only used for reads as
+// unaligned writes would need read-modify-write cycles that are not safe when
+// there are several writers. Memory mapped files are in memory anyway.
+//
+   ioPol = 0;
+   if (fd >= 0)
+      {
+#ifdef O_DIRECT
+       if (popts & XRDEXP_DIO && (Oflag & O_ACCMODE) == O_RDONLY && !mmFile)
+          {int fFlags = fcntl(fd, F_GETFL);
+           if (fFlags >= 0 && !fcntl(fd, F_SETFL, fFlags | O_DIRECT))
+              ioPol |= polDIO;
+          }
+#endif
+       if (popts & XRDEXP_STREAM && !(ioPol & polDIO))
+          {ioPol |= polStream;
+#if defined(__linux__) || (defined(__FreeBSD_kernel__) && defined(__GLIBC__))
+           posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+           posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE);
+#endif
+          }
+       if (ioPol) rdPol = new XrdOssReadPol;
+      }
+
 // Return the result of this open
 //
    return (fd < 0 ? fd : XrdOssOK);
@@ -920,6 +983,17 @@ int XrdOssFile::Close(long long *retsz)
            XrdOssCache::Adjust(cacheP, buf.st_size - FSize);
         if (retsz) *retsz = buf.st_size;
        }
+    if (ringReg) {XrdOssUring::Unregister(fd); ringReg = false;}
+#if defined(__linux__) || (defined(__FreeBSD_kernel__) && defined(__GLIBC__))
+    off_t dropOff, seqEnd;
+    if (ioPol & polStream && XrdOssSS->strDrop
+    &&  rdPol->Behind(dropOff, seqEnd))
+       {posix_fadvise(fd, dropOff, 0, POSIX_FADV_DONTNEED);
+        if (seqEnd > dropOff) XrdOssSS->strDropped += seqEnd - dropOff;
+       }
+#endif
+    if (rdPol) {delete rdPol; rdPol = 0;}
+    ioPol = 0;
     if (close(fd)) return -errno;
     if (mmFile) {XrdOssMio::Recycle(mmFile); mmFile = 0;}
 #ifdef XRDOSSCX
@@ -983,12 +1057,71 @@ ssize_t XrdOssFile::Read(void *buff, off_t offset, size_t blen)
            else   retval = cxobj->Read((char *)buff, blen, offset);
         else 
 #endif
-             do { retval = pread(fd, buff, blen, offset); }
-                while(retval < 0 && errno == EINTR);
+        if (mmFile) return mmFile->Read(buff, offset, blen);
+        else if (ioPol) return ReadPol(buff, offset, blen);
+           else do { retval = pread(fd, buff, blen, offset); }
+                   while(retval < 0 && errno == EINTR);
 
      return (retval >= 0 ? retval : (ssize_t)-errno);
 }
 
+/******************************************************************************/
+/*                                r e a d P o l                               */
+/******************************************************************************/
+
+/*
+  Function: Read `blen' bytes from the associated file, placing in 'buff'
+            the data, according to the file's I/O policy.
+
+  Input:    buff      - Address of the buffer in which to place the data.
+            offset    - The absolute 64-bit byte offset at which to read.
+            blen      - The size of the buffer.
+
+  Output:   Returns the number bytes read upon success and -errno upon failure.
+*/
+
+ssize_t XrdOssFile::ReadPol(void *buff, off_t offset, size_t blen)
+{
+     ssize_t retval;
+
+// Direct reads must be aligned in memory, offset, and length. If any of them
+// is not, read the enclosing aligned range into a bounce buffer.
+//
+     if (ioPol & polDIO)
+        {if (XrdOssReadPol::Aligned(buff, offset, blen))
+            {do { retval = pread(fd, buff, blen, offset); }
+                while(retval < 0 && errno == EINTR);
+             if (retval < 0) return (ssize_t)-errno;
+            } else {
+             off_t  bOff;
+             size_t bLen;
+             bool   mine;
+             char  *bBuff;
+             XrdOssReadPol::Enclose(offset, blen, bOff, bLen);
+             if (!(bBuff = rdPol->Bounce(bLen, mine))) return -ENOMEM;
+             do { retval = pread(fd, bBuff, bLen, bOff); }
+                while(retval < 0 && errno == EINTR);
+             if (retval < 0) {retval = -errno; rdPol->Unbounce(bBuff, mine);
+                              return retval;
+                             }
+             retval = XrdOssReadPol::Useful(retval, offset, bOff, blen);
+             if (retval) memcpy(buff, bBuff + (offset - bOff), retval);
+             rdPol->Unbounce(bBuff, mine);
+             XrdOssSS->dioBounce += retval;
+            }
+         XrdOssSS->dioBytes += retval;
+         return retval;
+        }
+
+// Otherwise this is a streamed file
+//
+     do { retval = pread(fd, buff, blen, offset); }
+        while(retval < 0 && errno == EINTR);
+     if (retval < 0) return (ssize_t)-errno;
+     if (retval > 0) Streamed(offset, retval);
+     return retval;
+}
+
 /******************************************************************************/
 /*                                  r e a d v                                 */
 /******************************************************************************/
@@ -1011,6 +1144,35 @@ ssize_t XrdOssFile::ReadV(XrdOucIOVec *readV, int n)
    ssize_t rdsz, totBytes = 0;
    int i;
 
+// Memory mapped files are copied from memory. Direct reads may need bounce
+// buffers. In either case, each element is read on its own.
+//
+   if (mmFile || (ioPol & polDIO))
+      {for (i = 0; i < n; i++)
+           {rdsz = (mmFile ? mmFile->Read(readV[i].data, readV[i].offset,
+                                          readV[i].size)
+                           : ReadPol(readV[i].data, readV[i].offset, readV[i].size));
+            if (rdsz != readV[i].size) return (rdsz < 0 ? rdsz : -ESPIPE);
+            totBytes += rdsz;
+           }
+       return totBytes;
+      }
+
+// Merge the elements into as few reads as possible. If io_uring is running,
+// issue all of the reads at once. Otherwise, if nothing could be merged, the
+// plain loop below with its pre-advise is just as good.
+//
+   if (!cxobj && n > 1 && (XrdOssSS->rvGap >= 0 || XrdOssUring::isOn()))
+      {XrdOssReadV rvPlan;
+       rvPlan.Plan(readV, n, XrdOssSS->rvGap, XrdOssSS->rvMaxRun);
+       XrdOssSS->rvReqs++;
+       XrdOssSS->rvSegs += n;
+       XrdOssSS->rvRuns += rvPlan.Runs.size();
+       XrdOssSS->rvGapB += rvPlan.gapBytes;
+       if (XrdOssUring::isOn()) return XrdOssUring::ReadV(ringFD(), rvPlan);
+       if (static_cast<int>(rvPlan.Runs.size()) < n) return rvPlan.Read(fd);
+      }
+
 // For platforms that support fadvise, pre-advise what we will be reading
 //
 #if (defined(__linux__) || (defined(__FreeBSD_kernel__) && defined(__GLIBC__))) && defined(HAVE_ATOMICS)
@@ -1097,12 +1259,56 @@ ssize_t XrdOssFile::ReadRaw(void *buff, off_t offset, size_t blen)
      if (cxobj)   retval = cxobj->ReadRaw((char *)buff, blen, offset);
         else 
 #endif
-             do { retval = pread(fd, buff, blen, offset); }
-                while(retval < 0 && errno == EINTR);
+        if (ioPol & polDIO) return ReadPol(buff, offset, blen);
+           else do { retval = pread(fd, buff, blen, offset); }
+                   while(retval < 0 && errno == EINTR);
 
      return (retval >= 0 ? retval : (ssize_t)-errno);
 }
 
+/******************************************************************************/
+/*                              S t r e a m e d                               */
+/******************************************************************************/
+
+/*
+  Function: Account for a read of a streamed file and advise the kernel.
+
+  Input:    offset    - The absolute 64-bit byte offset that was read.
+            blen      - The number of bytes read.
+
+  Output:   None. Once the file is read sequentially, the kernel is asked to
+            read ahead of the reader and what is left behind is dropped from
+            the page cache. Synchronous, aio, and io_uring readers may call
+            this concurrently; the read state is kept under rdPol's lock.
+*/
+
+void XrdOssFile::Streamed(off_t offset, size_t blen)
+{
+   XrdOssReadPol::Hints hints;
+
+   XrdOssSS->strBytes += blen;
+
+// See if this read makes the access sequential and, if so, what to do
+//
+   if (!rdPol->Streamed(offset, blen, XrdOssSS->strRA, XrdOssSS->strDrop,
+                        hints)) return;
+
+#if defined(__linux__)
+// Keep the kernel reading ahead of the client
+//
+   if (hints.raLen && !readahead(fd, hints.raOff, hints.raLen))
+      XrdOssSS->strRABytes += hints.raLen;
+#endif
+
+#if defined(__linux__) || (defined(__FreeBSD_kernel__) && defined(__GLIBC__))
+// Drop what the client has already read
+//
+   if (hints.dropLen
+   &&  !posix_fadvise(fd, hints.dropOff, hints.dropLen, POSIX_FADV_DONTNEED))
+      XrdOssSS->strDropped += hints.dropLen;
+#endif
+}
+
 /******************************************************************************/
 /*                                 w r i t e                                  */
 /******************************************************************************/
@@ -38,11 +38,13 @@
 #include "XrdOss/XrdOssConfig.hh"
 #include "XrdOss/XrdOssError.hh"
 #include "XrdOss/XrdOssStatInfo.hh"
+#include "XrdOss/XrdOssUring.hh"
 #include "XrdOuc/XrdOucExport.hh"
 #include "XrdOuc/XrdOucPList.hh"
 #include "XrdOuc/XrdOucStream.hh"
 #include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include "XrdSys/XrdSysRAtomic.hh"
 
 /******************************************************************************/
 /*                              o o s s _ D i r                               */
@@ -85,6 +87,7 @@ class oocx_CXFile;
 class XrdSfsAio;
 class XrdOssCache_FS;
 class XrdOssMioFile;
+class XrdOssReadPol;
   
 class XrdOssFile : public XrdOssDF
 {
@@ -110,6 +113,8 @@ int     Ftruncate(unsigned long long);
 int     getFD() {return fd;}
 off_t   getMmap(void **addr);
 int     isCompressed(char *cxidp=0);
+using   XrdOssDF::pgRead;
+int     pgRead(XrdSfsAio *aiop, uint64_t opts);
 ssize_t Read(               off_t, size_t);
 ssize_t Read(       void *, off_t, size_t);
 int     Read(XrdSfsAio *aiop);
@@ -123,12 +128,19 @@ int     Write(XrdSfsAio *aiop);
                   : XrdOssDF(tid, DF_isFile, fdnum),
                     cxobj(0), cacheP(0), mmFile(0),
                     rawio(0), cxpgsz(0),
-                    canClone(false)  {cxid[0] = '\0';}
+                    canClone(false), ringReg(false), ioPol(0), rdPol(0)
+                    {cxid[0] = '\0';}
 
 virtual ~XrdOssFile() {if (fd >= 0) Close();}
 
 private:
 int     Open_ufs(const char *, int, int, unsigned long long);
+int     ringFD() {return (ringReg ? fd | XrdOssUring::isFixed : fd);}
+ssize_t ReadPol(void *buff, off_t offset, size_t blen);
+void    Streamed(off_t offset, size_t blen);
+
+static const char polDIO    = 0x01;   // Reads bypass the page cache
+static const char polStream = 0x02;   // Sequential reads are managed
 
 static int      AioFailure;
 oocx_CXFile    *cxobj;
@@ -139,6 +151,9 @@ int             rawio;
 int             cxpgsz;
 char            cxid[4];
 bool            canClone;
+bool            ringReg;
+char            ioPol;
+XrdOssReadPol  *rdPol;
 };
 
 /******************************************************************************/
@@ -170,7 +185,8 @@ int       Configure(const char *, XrdSysError &, XrdOucEnv *envP);
 void      Config_Display(XrdSysError &);
 virtual
 int       Create(const char *, const char *, mode_t, XrdOucEnv &, int opts=0);
-uint64_t  Features() {return XRDOSS_HASNAIO|XRDOSS_HASFICL;} // Turn async I/O off for disk and clone aware
+uint64_t  Features() {return (XrdOssUring::isOn() ? 0 : XRDOSS_HASNAIO)
+                            | XRDOSS_HASFICL;} // Async I/O only via io_uring
 int       GenLocalPath(const char *, char *);
 int       GenRemotePath(const char *, char *);
 int       Init(XrdSysLogger *, const char *, XrdOucEnv *envP);
@@ -286,6 +302,21 @@ int               prActive;  //    preread activity count
 short             prDepth;   //    preread depth
 short             prQSize;   //    preread maximum allowed
 
+int               rvGap;     //    readv merge gap (negative means no merging)
+int               rvMaxRun;  //    readv merge maximum run length
+RAtomic_llong     rvReqs;    //    readv requests
+RAtomic_llong     rvSegs;    //    readv elements requested
+RAtomic_llong     rvRuns;    //    readv reads actually issued
+RAtomic_llong     rvGapB;    //    readv bytes read to bridge holes
+
+long long         strRA;     //    stream readahead window
+long long         strDrop;   //    stream drop behind chunk
+RAtomic_llong     dioBytes;  //    bytes read with direct I/O
+RAtomic_llong     dioBounce; //    bytes read through bounce buffers
+RAtomic_llong     strBytes;  //    bytes read by streamed files
+RAtomic_llong     strRABytes;//    bytes of readahead issued
+RAtomic_llong     strDropped;//    bytes dropped from the page cache
+
 XrdVersionInfo   *myVersion; //    Compilation version set by constructor
    
          XrdOssSys();
@@ -297,6 +328,8 @@ protected:
 long long minalloc;          //    Minimum allocation
 int       ovhalloc;          //    Allocation overage
 int       fuzalloc;          //    Allocation fuzz
+int       ldalloc;           //    Allocation load weight
+int       ldscanint;         //    Seconds between load samples
 int       cscanint;          //    Seconds between cache scans
 int       xfrspeed;          //    Average transfer speed (bytes/second)
 int       xfrovhd;           //    Minimum seconds to get a file
@@ -363,12 +396,15 @@ int    xmemf(XrdOucStream &Config, XrdSysError &Eroute);
 int    xnml(XrdOucStream &Config, XrdSysError &Eroute);
 int    xpath(XrdOucStream &Config, XrdSysError &Eroute);
 int    xprerd(XrdOucStream &Config, XrdSysError &Eroute);
+int    xreadv(XrdOucStream &Config, XrdSysError &Eroute);
+int    xuring(XrdOucStream &Config, XrdSysError &Eroute);
 int    xspace(XrdOucStream &Config, XrdSysError &Eroute, int *isCD=0);
 int    xspace(XrdOucStream &Config, XrdSysError &Eroute,
               const char *grp, bool isAsgn);
 int    xspaceBuild(OssSpaceConfig &sInfo, XrdSysError &Eroute);
 int    xstg(XrdOucStream &Config, XrdSysError &Eroute);
 int    xstl(XrdOucStream &Config, XrdSysError &Eroute);
+int    xstrio(XrdOucStream &Config, XrdSysError &Eroute);
 int    xusage(XrdOucStream &Config, XrdSysError &Eroute);
 int    xtrace(XrdOucStream &Config, XrdSysError &Eroute);
 int    xxfr(XrdOucStream &Config, XrdSysError &Eroute);
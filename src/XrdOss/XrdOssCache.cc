@@ -77,6 +77,7 @@ XrdOssCache_FS     *XrdOssCache::fsfirst = 0;
 XrdOssCache_FS     *XrdOssCache::fslast  = 0;
 XrdOssCache_FSData *XrdOssCache::fsdata  = 0;
 double              XrdOssCache::fuzAlloc= 0.0;
+double              XrdOssCache::ldAlloc = 0.0;
 long long           XrdOssCache::minAlloc= 0;
 int                 XrdOssCache::fsCount = 0;
 int                 XrdOssCache::ovhAlloc= 0;
@@ -118,9 +119,11 @@ XrdOssCache_FSData::XrdOssCache_FSData(const char *fsp,
      if (size > XrdOssCache::fsLarge) XrdOssCache::fsLarge= size;
      if (frsz > XrdOssCache::fsFree)  XrdOssCache::fsFree = frsz;
      fsid = fsID;
+     iotk = -1;
      updt = time(0);
      next = 0;
      stat = 0;
+     busy = 0;
 
 // This is created only for new partitions!
 //
@@ -515,7 +518,10 @@ int XrdOssCache::Alloc(XrdOssCache::allocInfo &aInfo)
 
 // Find a cache that will fit this allocation request. We start with the next
 // entry past the last one we selected and go full round looking for a
-// compatable entry (enough space and in the right space group).
+// compatable entry (enough space and in the right space group). When load
+// balancing, the free space of a partition is discounted by how busy its
+// device is so that writes steer away from saturated disks. A saturated disk
+// may then have no free space left to compare, yet is still a candidate.
 //
    fsp_sel = 0; maxfree = 0;
    fsp = cgp->curr->next; fspend = fsp; // End when we hit the start again
@@ -525,10 +531,15 @@ int XrdOssCache::Alloc(XrdOssCache::allocInfo &aInfo)
                         ||  strncmp(aInfo.cgPath,fsp->path,aInfo.cgPlen)))) continue;
        curfree = fsp->fsdata->frsz;
        if (size > curfree) continue;
+       if (ldAlloc > 0.0)
+          curfree -= static_cast<long long>(curfree * ldAlloc
+                                           * fsp->fsdata->busy / 100.0);
 
              if (fuzAlloc > 0.999) {fsp_sel = fsp; break;}
        else  if (!fuzAlloc || !fsp_sel)
-                {if (curfree > maxfree) {fsp_sel = fsp; maxfree = curfree;}}
+                {if (!fsp_sel || curfree > maxfree)
+                    {fsp_sel = fsp; maxfree = curfree;}
+                }
        else {diffree = (!(curfree + maxfree) ? 0.0
                      : static_cast<double>(XRDABS(maxfree - curfree)) /
                        static_cast<double>(       maxfree + curfree));
@@ -537,9 +548,20 @@ int XrdOssCache::Alloc(XrdOssCache::allocInfo &aInfo)
       } while((fsp = fsp->next) != fspend);
 
 // Check if we can realy fit this file. If so, update current scan pointer
+// and temporarily adjust down the free space.
 //
    if (!fsp_sel) return -ENOSPC;
    cgp->curr = fsp_sel;
+   DEBUG("free=" <<fsp_sel->fsdata->frsz <<'-' <<size <<" busy="
+                 <<fsp_sel->fsdata->busy <<"% path=" <<fsp_sel->fsdata->path);
+   fsp_sel->fsdata->frsz -= size;
+   fsp_sel->fsdata->stat |= XrdOssFSData_REFRESH;
+   aInfo.cgFSp  = fsp_sel;
+
+// The rest does not need the cache context, which is not held for the
+// possibly slow file creation.
+//
+   myMutex.UnLock();
 
 // Construct the target filename
 //
@@ -551,28 +573,33 @@ int XrdOssCache::Alloc(XrdOssCache::allocInfo &aInfo)
 
 // Verify that target name was constructed
 //
-   if (!(*aInfo.cgPFbf)) return -ENAMETOOLONG;
+   if (!(*aInfo.cgPFbf)) datfd = -ENAMETOOLONG;
 
-// Simply open the file in the local filesystem, creating it if need be.
+// Simply open the file in the local filesystem, creating it if need be. As
+// we run unlocked, a concurrent allocation may create the directory first.
 //
-   if (aInfo.aMode)
+   else if (aInfo.aMode)
       {madeDir = 0;
        do {do {datfd = open(aInfo.cgPFbf,O_CREAT|O_TRUNC|O_WRONLY,aInfo.aMode);}
                while(datfd < 0 && errno == EINTR);
            if (datfd >= 0 || errno != ENOENT || madeDir) break;
            *Info.Slash='\0'; rc=mkdir(aInfo.cgPFbf,theMode); *Info.Slash='/';
            madeDir = 1;
-          } while(!rc);
-       if (datfd < 0) return (errno ? -errno : -EFAULT);
+          } while(!rc || errno == EEXIST);
+       if (datfd < 0) datfd = (errno ? -errno : -EFAULT);
       }
 
-// All done (temporarily adjust down the free space)x
+// If the file could not be created, give back the space reserved for it
+//
+   if (datfd < 0)
+      {Mutex.Lock();
+       fsp_sel->fsdata->frsz += size;
+       Mutex.UnLock();
+       aInfo.cgFSp = 0;
+      }
+
+// All done
 //
-   DEBUG("free=" <<fsp_sel->fsdata->frsz <<'-' <<size <<" path=" 
-                 <<fsp_sel->fsdata->path);
-   fsp_sel->fsdata->frsz -= size;
-   fsp_sel->fsdata->stat |= XrdOssFSData_REFRESH;
-   aInfo.cgFSp  = fsp_sel;
    return datfd;
 }
   
@@ -665,13 +692,14 @@ int XrdOssCache::Init(const char *UPath, const char *Qfile, int isSOL, int us)
 
 /******************************************************************************/
 
-int XrdOssCache::Init(long long aMin, int ovhd, int aFuzz)
+int XrdOssCache::Init(long long aMin, int ovhd, int aFuzz, int aLoad)
 {
 // Set values
 //
    minAlloc = aMin;
    ovhAlloc = ovhd;
    fuzAlloc = static_cast<double>(aFuzz)/100.0;
+   ldAlloc  = static_cast<double>(aLoad)/100.0;
    return 0;
 }
 
@@ -702,6 +730,120 @@ void XrdOssCache::List(const char *lname, XrdSysError &Eroute)
         } while(fsp != fsfirst);
 }
   
+/******************************************************************************/
+/*                                  L o a d                                   */
+/******************************************************************************/
+
+void *XrdOssCache::Load(int ldscanint)
+{
+#ifdef __linux__
+   EPNAME("CacheLoad")
+   const struct timespec naptime = {ldscanint, 0};
+   std::map<dev_t, long long> ioTicks;
+   std::map<dev_t, long long>::iterator it;
+   XrdOssCache_FSData *fsdp;
+   XrdOucStream strm;
+   struct timespec tNow;
+   long long msNow, msLast = 0, msDiff;
+   char *line, *tok;
+   int fd, i, busy, vMaj, vMin;
+
+// Nothing to do if there are no partitions
+//
+   if (!fsdata) return (void *)0;
+
+// Periodically sample the time each device was busy doing I/O (the 13th
+// field in /proc/diskstats) and turn it into a percentage of the elapsed time.
+// Partitions whose device is not listed (e.g. network file systems) are never
+// considered busy.
+//
+   while(1)
+        {if ((fd = open("/proc/diskstats", O_RDONLY)) < 0)
+            {OssEroute.Emsg("CacheLoad", errno, "open /proc/diskstats");
+             return (void *)0;
+            }
+         strm.Attach(fd);
+         ioTicks.clear();
+         while((line = strm.GetLine()))
+              {if (!(tok = strm.GetToken()) || !isdigit(*tok)) continue;
+               vMaj = atoi(tok);
+               if (!(tok = strm.GetToken()) || !isdigit(*tok)) continue;
+               vMin = atoi(tok);
+               for (i = 0; i < 11 && (tok = strm.GetToken()); i++) {}
+               if (tok && isdigit(*tok))
+                  ioTicks[makedev(vMaj, vMin)] = atoll(tok);
+              }
+         strm.Close();
+
+         clock_gettime(CLOCK_MONOTONIC, &tNow);
+         msNow  = tNow.tv_sec*1000LL + tNow.tv_nsec/1000000;
+         msDiff = msNow - msLast;
+
+         Mutex.Lock();
+         for (fsdp = fsdata; fsdp; fsdp = fsdp->next)
+             {if ((it = ioTicks.find(fsdp->fsid)) == ioTicks.end()) continue;
+              if (msLast && msDiff > 0 && fsdp->iotk >= 0)
+                 {busy = static_cast<int>((it->second - fsdp->iotk)*100/msDiff);
+                  if (busy > 100) busy = 100;
+                     else if (busy < 0) busy = 0;
+                  fsdp->busy = static_cast<short>((fsdp->busy + busy)/2);
+                  DEBUG("busy=" <<fsdp->busy <<"% path=" <<fsdp->path);
+                 }
+              fsdp->iotk = it->second;
+             }
+         LoadHint();
+         Mutex.UnLock();
+
+         msLast = msNow;
+         nanosleep(&naptime, 0);
+        }
+#endif
+
+// Keep the compiler happy
+//
+   return (void *)0;
+}
+
+/******************************************************************************/
+/* Private:                     L o a d H i n t                               */
+/******************************************************************************/
+
+// Called with the cache context lock held.
+//
+void XrdOssCache::LoadHint()
+{
+   static const int hintInt = 600, bHigh = 90, bLow = 50;
+   static time_t nextHint = 0;
+   XrdOssCache_Group *cgp;
+   XrdOssCache_FS *fsp, *fsHi, *fsLo;
+   time_t tNow = time(0);
+   char buff[512];
+
+// Hints are rate limited to avoid flooding the log
+//
+   if (tNow < nextHint || !fsfirst) return;
+
+// In each space, suggest moving data when one device is saturated while
+// another one that could take the writes is not.
+//
+   for (cgp = XrdOssCache_Group::fsgroups; cgp; cgp = cgp->next)
+       {fsHi = fsLo = 0; fsp = fsfirst;
+        do {if (fsp->fsgroup != cgp) continue;
+            if (!fsHi || fsp->fsdata->busy > fsHi->fsdata->busy) fsHi = fsp;
+            if ((!fsLo || fsp->fsdata->busy < fsLo->fsdata->busy)
+            &&  fsp->fsdata->frsz > minAlloc) fsLo = fsp;
+           } while((fsp = fsp->next) != fsfirst);
+        if (fsHi && fsLo && fsHi->fsdata->busy >= bHigh
+        &&  fsLo->fsdata->busy < bLow && fsHi->fsdata != fsLo->fsdata)
+           {snprintf(buff, sizeof(buff), "%s is %d%% busy while %s is %d%% "
+                     "busy; consider rebalancing space", fsHi->fsdata->path,
+                     fsHi->fsdata->busy, fsLo->fsdata->path,fsLo->fsdata->busy);
+            OssEroute.Emsg("CacheLoad", cgp->group, buff);
+            nextHint = tNow + hintInt;
+           }
+       }
+}
+
 /******************************************************************************/
 /*                               M a p D e v s                                */
 /******************************************************************************/
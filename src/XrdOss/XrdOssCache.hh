@@ -111,11 +111,13 @@ XrdOssCache_FSData *next;
 long long           size;
 long long           frsz;
 dev_t               fsid;
+long long           iotk;     // Device busy milliseconds at last load sample
 const char         *path;
 const char         *pact;
 const char         *devN;
 time_t              updt;
 int                 stat;
+short               busy;     // Percent of time the device is busy
 unsigned short      bdevID;
 unsigned short      partID;
 
@@ -246,10 +248,12 @@ static XrdOssCache_FS *Find(const char *Path, int lklen=0);
 static int             Init(const char *UDir, const char *Qfile,
                             int isSOL, int usync=0);
 
-static int             Init(long long aMin, int ovhd, int aFuzz);
+static int             Init(long long aMin, int ovhd, int aFuzz, int aLoad=0);
 
 static void            List(const char *lname, XrdSysError &Eroute);
 
+static void           *Load(int ldscanint);
+
 static void            MapDevs(bool dBug=false);
 
 static char           *Parse(const char *token, char *cbuff, int cblen);
@@ -273,6 +277,9 @@ static int                 fsCount;  // Number of file systems
 
 private:
 static bool MapDM(const char *ldm, char *buff, int blen);
+static void LoadHint();
+
+static double              ldAlloc;
 
 static long long           minAlloc;
 static double              fuzAlloc;
@@ -53,6 +53,7 @@
 #include "XrdOss/XrdOssOpaque.hh"
 #include "XrdOss/XrdOssSpace.hh"
 #include "XrdOss/XrdOssTrace.hh"
+#include "XrdOss/XrdOssUring.hh"
 #include "XrdOuc/XrdOuca2x.hh"
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdSys/XrdSysError.hh"
@@ -178,6 +179,8 @@ void *XrdOssxfr(void *carg)       {return XrdOssSS->Stage_In(carg);}
 
 void *XrdOssCacheScan(void *carg) {return XrdOssCache::Scan(*((int *)carg));}
 
+void *XrdOssCacheLoad(void *carg) {return XrdOssCache::Load(*((int *)carg));}
+
 /******************************************************************************/
 /*                           C o n s t r u c t o r                            */
 /******************************************************************************/
@@ -222,6 +225,8 @@ XrdOssSys::XrdOssSys()
    minalloc      = 0;
    ovhalloc      = 0;
    fuzalloc      = 0;
+   ldalloc       = 0;
+   ldscanint     = 10;
    xfrspeed      = 9*1024*1024;
    xfrovhd       = 30;
    xfrhold       =  3*60*60;
@@ -248,6 +253,19 @@ XrdOssSys::XrdOssSys()
    prActive      = 0;
    prDepth       = 0;
    prQSize       = 0;
+   rvGap         = 4096;
+   rvMaxRun      = 8*1024*1024;
+   rvReqs        = 0;
+   rvSegs        = 0;
+   rvRuns        = 0;
+   rvGapB        = 0;
+   strRA         = 4*1024*1024;
+   strDrop       = 16*1024*1024;
+   dioBytes      = 0;
+   dioBounce     = 0;
+   strBytes      = 0;
+   strRABytes    = 0;
+   strDropped    = 0;
    STT_Lib       = 0;
    STT_Parms     = 0;
    STT_Func      = 0;
@@ -372,15 +390,16 @@ int XrdOssSys::Configure(const char *configfn, XrdSysError &Eroute,
    if (m1 || m2) Eroute.Say("++++++ Configuring ", m1, m2, "mode . . .");
   }
    NoGo |= XrdOssCache::Init(UDir, QFile, Solitary, USync)
-          |XrdOssCache::Init(minalloc, ovhalloc, fuzalloc);
+          |XrdOssCache::Init(minalloc, ovhalloc, fuzalloc, ldalloc);
 
 // Configure the MSS interface including staging
 //
    if (!NoGo) NoGo = ConfigStage(Eroute);
 
-// Configure async I/O
+// Configure async I/O. Use io_uring if so wanted and POSIX aio otherwise.
 //
-   if (!NoGo) NoGo = !AioInit();
+   if (!NoGo && !(XrdOssUring::isSet() && XrdOssUring::Init(Eroute)))
+      NoGo = !AioInit();
 
 // Initialize memory mapping setting to speed execution
 //
@@ -416,6 +435,9 @@ int XrdOssSys::Configure(const char *configfn, XrdSysError &Eroute,
       {if ((retc = XrdSysThread::Run(&tid, XrdOssCacheScan,
                                     (void *)&cscanint, 0, "space scan")))
           Eroute.Emsg("Config", retc, "create space scan thread");
+       if (ldalloc && (retc = XrdSysThread::Run(&tid, XrdOssCacheLoad,
+                                    (void *)&ldscanint, 0, "space load")))
+          Eroute.Emsg("Config", retc, "create space load thread");
       }
 
 // Display the final config if we can continue
@@ -456,7 +478,7 @@ int XrdOssSys::Configure(const char *configfn, XrdSysError &Eroute,
 
 void XrdOssSys::Config_Display(XrdSysError &Eroute)
 {
-     char buff[4096], *cloc;
+     char buff[4096], ldbuff[64], *cloc;
      XrdOucPList *fp;
 
      // Preset some tests
@@ -471,8 +493,12 @@ void XrdOssSys::Config_Display(XrdSysError &Eroute)
      if (!ConfigFN || !ConfigFN[0]) cloc = (char *)"Default";
         else cloc = ConfigFN;
 
+     if (ldalloc) snprintf(ldbuff, sizeof(ldbuff), " load %d every %d",
+                           ldalloc, ldscanint);
+        else *ldbuff = 0;
+
      snprintf(buff, sizeof(buff), "Config effective %s oss configuration:\n"
-                                  "       oss.alloc        %lld %d %d\n"
+                                  "       oss.alloc        %lld %d %d%s\n"
                                   "       oss.spacescan    %d\n"
                                   "       oss.fdlimit      %d %d\n"
                                   "       oss.maxsize      %lld\n"
@@ -485,7 +511,7 @@ void XrdOssSys::Config_Display(XrdSysError &Eroute)
                                   "       oss.trace        %x\n"
                                   "       oss.xfr          %d deny %d keep %d",
              cloc,
-             minalloc, ovhalloc, fuzalloc,
+             minalloc, ovhalloc, fuzalloc, ldbuff,
              cscanint,
              FDFence, FDLimit, MaxSize,
              XrdOssConfig_Val(N2N_Lib,    namelib),
@@ -502,6 +528,18 @@ void XrdOssSys::Config_Display(XrdSysError &Eroute)
 
      XrdOssMio::Display(Eroute);
 
+     XrdOssUring::Display(Eroute);
+
+     if (rvGap < 0) Eroute.Say("       oss.readv nomerge");
+        else {snprintf(buff, sizeof(buff), "       oss.readv merge gap %d "
+                       "maxrun %d", rvGap, rvMaxRun);
+              Eroute.Say(buff);
+             }
+
+     snprintf(buff, sizeof(buff), "       oss.streamio readahead %lld "
+              "dropbehind %lld", strRA, strDrop);
+     Eroute.Say(buff);
+
      XrdOssCache::List("       oss.", Eroute);
            List_Path("       oss.defaults ", "", DirFlags, Eroute);
      fp = RPList.First();
@@ -530,6 +568,7 @@ void XrdOssSys::ConfigCache(XrdSysError &Eroute, bool pass2)
      const unsigned long long conFlags = 
                     XRDEXP_NOCHECK | XRDEXP_NODREAD |
                     XRDEXP_MLOK    | XRDEXP_MKEEP   | XRDEXP_MMAP  |
+                    XRDEXP_MSMALL  |
                     XRDEXP_MIG     | XRDEXP_MWMODE  | XRDEXP_PURGE |
                     XRDEXP_RCREATE | XRDEXP_STAGE   | XRDEXP_STAGEMM;
 
@@ -629,6 +668,16 @@ void XrdOssSys::ConfigMio(XrdSysError &Eroute)
       }
 #endif
 
+// Small files are only mapped in paths that ask for it and only when a size
+// has been given, so warn about either one being missing.
+//
+   if ((flags & XRDEXP_MSMALL) && !XrdOssMio::isSmall(1))
+      Eroute.Say("Config warning: mmapsmall has no effect without "
+                 "'memfile small'.");
+      else if (!(flags & XRDEXP_MSMALL) && XrdOssMio::isSmall(1))
+              Eroute.Say("Config warning: 'memfile small' has no effect as "
+                         "no path is mmapsmall.");
+
 // If no memory flags are set, turn off memory mapped files
 //
    if (!(flags & XRDEXP_MEMAP) || setoff)
@@ -1117,10 +1166,13 @@ int XrdOssSys::ConfigXeq(char *var, XrdOucStream &Config, XrdSysError &Eroute)
    TS_Xeq("namelib",       xnml);
    TS_Xeq("path",          xpath);
    TS_Xeq("preread",       xprerd);
+   TS_Xeq("readv",         xreadv);
    TS_Xeq("space",         xspace);
    TS_Xeq("stagecmd",      xstg);
    TS_Xeq("statlib",       xstl);
+   TS_Xeq("streamio",      xstrio);
    TS_Xeq("trace",         xtrace);
+   TS_Xeq("uring",         xuring);
    TS_Xeq("usage",         xusage);
    TS_Xeq("xfr",           xxfr);
 
@@ -1181,6 +1233,7 @@ int XrdOssSys::ConfigXeq(char *var, XrdOucStream &Config, XrdSysError &Eroute)
 /* Function: aalloc
 
    Purpose:  To parse the directive: alloc <min> [<headroom> [<fuzz>]]
+                                         [load <weight> [every <sec>]]
 
              <min>       minimum amount of free space needed in a partition.
                          (asterisk uses default).
@@ -1190,6 +1243,11 @@ int XrdOssSys::ConfigXeq(char *var, XrdOucStream &Config, XrdSysError &Eroute)
                          quantities that may be ignored when selecting a space
                            0 - reduces to finding the largest free space
                          100 - reduces to simple round-robin allocation
+             <weight>    percentage by which the free space of a partition is
+                         discounted when its device is fully busy. Device
+                         load is sampled from /proc/diskstats (Linux only).
+                         It is ignored for round-robin allocation.
+             <sec>       seconds between device load samples (default 10).
 
    Output: 0 upon success or !0 upon failure.
 */
@@ -1200,25 +1258,49 @@ int XrdOssSys::xalloc(XrdOucStream &Config, XrdSysError &Eroute)
     long long mina = 0;
     int       fuzz = 0;
     int       hdrm = 0;
+    int       ldwt = 0;
+    int       ldsi = ldscanint;
 
     if (!(val = Config.GetWord()))
        {Eroute.Emsg("Config", "alloc minfree not specified"); return 1;}
     if (strcmp(val, "*") &&
         XrdOuca2x::a2sz(Eroute, "alloc minfree", val, &mina, 0)) return 1;
 
-    if ((val = Config.GetWord()))
+    if ((val = Config.GetWord()) && strcmp(val, "load"))
        {if (strcmp(val, "*") &&
             XrdOuca2x::a2i(Eroute,"alloc headroom",val,&hdrm,0,100)) return 1;
 
-        if ((val = Config.GetWord()))
+        if ((val = Config.GetWord()) && strcmp(val, "load"))
            {if (strcmp(val, "*") &&
             XrdOuca2x::a2i(Eroute, "alloc fuzz", val, &fuzz, 0, 100)) return 1;
+            val = Config.GetWord();
+           }
+       }
+
+    if (val)
+       {if (strcmp(val, "load"))
+           {Eroute.Emsg("Config", "invalid alloc option -", val); return 1;}
+        if (!(val = Config.GetWord()))
+           {Eroute.Emsg("Config", "alloc load weight not specified"); return 1;}
+        if (XrdOuca2x::a2i(Eroute, "alloc load weight", val, &ldwt, 0, 100))
+           return 1;
+        if ((val = Config.GetWord()))
+           {if (strcmp(val, "every"))
+               {Eroute.Emsg("Config", "invalid alloc option -", val); return 1;}
+            if (!(val = Config.GetWord()))
+               {Eroute.Emsg("Config", "alloc load interval not specified");
+                return 1;
+               }
+            if (XrdOuca2x::a2tm(Eroute, "alloc load interval", val, &ldsi, 1))
+               return 1;
            }
        }
 
     minalloc = mina;
     ovhalloc = hdrm;
     fuzalloc = fuzz;
+    ldalloc  = ldwt;
+    ldscanint= ldsi;
     return 0;
 }
 
@@ -1367,6 +1449,7 @@ int XrdOssSys::xmaxsz(XrdOucStream &Config, XrdSysError &Eroute)
 
    Purpose:  Parse the directive: memfile [off] [max <msz>]
                                           [check xattr] [preload]
+                                          [small <fsz>]
 
              check      Applies memory mapping options based on file's xattrs.
                         For backward compatibility, we also accept:
@@ -1375,6 +1458,8 @@ int XrdOssSys::xmaxsz(XrdOucStream &Config, XrdSysError &Eroute)
              off        Disables memory mapping regardless of other options.
              on         Enables memory mapping
              preload    Preloads the file after every opn reference.
+             small      Memory map any file in an mmapsmall path whose size is
+                        at most <fsz> bytes, even if the path is not mmap.
              <msz>      Maximum amount of memory to use (can be n% or real mem).
 
    Output: 0 upon success or !0 upon failure.
@@ -1384,7 +1469,7 @@ int XrdOssSys::xmemf(XrdOucStream &Config, XrdSysError &Eroute)
 {
     char *val;
     int i, j, V_check=-1, V_preld = -1, V_on=-1;
-    long long V_max = 0;
+    long long V_max = 0, V_small = 0;
 
     static struct mmapopts {const char *opname; int otyp;
                             const char *opmsg;} mmopts[] =
@@ -1392,7 +1477,8 @@ int XrdOssSys::xmemf(XrdOucStream &Config, XrdSysError &Eroute)
         {"off",        0, ""},
         {"preload",    1, "memfile preload"},
         {"check",      2, "memfile check"},
-        {"max",        3, "memfile max"}};
+        {"max",        3, "memfile max"},
+        {"small",      4, "memfile small"}};
     int numopts = sizeof(mmopts)/sizeof(struct mmapopts);
 
     if (!(val = Config.GetWord()))
@@ -1430,6 +1516,9 @@ int XrdOssSys::xmemf(XrdOucStream &Config, XrdSysError &Eroute)
                                                 mmopts[i].opmsg, val, &V_max,
                                                 10*1024*1024)) return 1;
                                   break;
+                          case 4: if (XrdOuca2x::a2sz(Eroute, mmopts[i].opmsg,
+                                                val, &V_small, 1)) return 1;
+                                  break;
                           default: V_on = 0; break;
                          }
                   val = Config.GetWord();
@@ -1439,7 +1528,7 @@ int XrdOssSys::xmemf(XrdOucStream &Config, XrdSysError &Eroute)
 // Set the values
 //
    XrdOssMio::Set(V_on, V_preld, V_check);
-   XrdOssMio::Set(V_max);
+   XrdOssMio::Set(V_max, V_small);
    return 0;
 }
 
@@ -1594,6 +1683,63 @@ int XrdOssSys::xprerd(XrdOucStream &Config, XrdSysError &Eroute)
       return 0;
 }
   
+/******************************************************************************/
+/*                                x r e a d v                                 */
+/******************************************************************************/
+
+/* Function: xreadv
+
+   Purpose:  Parse the directive: readv [merge | nomerge] [gap <sz>]
+                                        [maxrun <sz>]
+
+             merge      Merge vector read elements into fewer reads (default).
+             nomerge    Read each element separately.
+             gap        The largest hole between two elements that is read
+                        and discarded to merge them (default 4k).
+             maxrun     The largest merged read (default 8m). It must be less
+                        than 2g as a single read returns at most 0x7ffff000
+                        bytes and the run length is kept in an int.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdOssSys::xreadv(XrdOucStream &Config, XrdSysError &Eroute)
+{
+    static const long long m16 = 16777216LL;
+    static const long long maxRun = 0x7ffff000LL; // Linux MAX_RW_COUNT
+    char *val;
+    long long gap = (rvGap < 0 ? 4096 : rvGap), mrun = rvMaxRun;
+    bool merge = true;
+
+    if (!(val = Config.GetWord()))
+       {Eroute.Emsg("Config", "readv option not specified"); return 1;}
+
+    do {     if (!strcmp(val, "merge"))   merge = true;
+        else if (!strcmp(val, "nomerge")) merge = false;
+        else if (!strcmp(val, "gap"))
+                {if (!(val = Config.GetWord()))
+                    {Eroute.Emsg("Config", "readv gap not specified");
+                     return 1;
+                    }
+                 if (XrdOuca2x::a2sz(Eroute,"readv gap",val,&gap,0,m16))
+                    return 1;
+                }
+        else if (!strcmp(val, "maxrun"))
+                {if (!(val = Config.GetWord()))
+                    {Eroute.Emsg("Config", "readv maxrun not specified");
+                     return 1;
+                    }
+                 if (XrdOuca2x::a2sz(Eroute,"readv maxrun",val,&mrun,4096,
+                                     maxRun)) return 1;
+                }
+        else {Eroute.Emsg("Config", "invalid readv option -", val); return 1;}
+       } while((val = Config.GetWord()));
+
+    rvGap    = (merge ? static_cast<int>(gap) : -1);
+    rvMaxRun = static_cast<int>(mrun);
+    return 0;
+}
+
 /******************************************************************************/
 /*                                x s p a c e                                 */
 /******************************************************************************/
@@ -1921,6 +2067,57 @@ do{     if (!strcmp(val, "-2")) STT_V2    = 1;
    return 0;
 }
 
+/******************************************************************************/
+/*                                x s t r i o                                 */
+/******************************************************************************/
+
+/* Function: xstrio
+
+   Purpose:  To parse the directive: streamio [readahead <sz>] [dropbehind <sz>]
+
+             readahead  How far ahead of a sequential reader the kernel is
+                        asked to read (default 4m). Zero disables readahead.
+             dropbehind How much data a sequential reader must leave behind
+                        before it is dropped from the page cache (default 16m).
+                        Zero disables dropping.
+
+             The directive applies to files in paths exported with "stream".
+
+   Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdOssSys::xstrio(XrdOucStream &Config, XrdSysError &Eroute)
+{
+    static const long long m1g = 1024*1024*1024LL;
+    char *val;
+    long long ra = strRA, drop = strDrop;
+
+    if (!(val = Config.GetWord()))
+       {Eroute.Emsg("Config", "streamio option not specified"); return 1;}
+
+    do {     if (!strcmp(val, "readahead"))
+                {if (!(val = Config.GetWord()))
+                    {Eroute.Emsg("Config", "streamio readahead not specified");
+                     return 1;
+                    }
+                 if (XrdOuca2x::a2sz(Eroute,"streamio readahead",val,&ra,0,m1g))
+                    return 1;
+                }
+        else if (!strcmp(val, "dropbehind"))
+                {if (!(val = Config.GetWord()))
+                    {Eroute.Emsg("Config", "streamio dropbehind not specified");
+                     return 1;
+                    }
+                 if (XrdOuca2x::a2sz(Eroute,"streamio dropbehind",val,&drop,
+                                     0,m1g)) return 1;
+                }
+        else {Eroute.Emsg("Config", "invalid streamio option -", val); return 1;}
+       } while((val = Config.GetWord()));
+
+    strRA = ra; strDrop = drop;
+    return 0;
+}
+
 /******************************************************************************/
 /*                                x t r a c e                                 */
 /******************************************************************************/
@@ -1968,6 +2165,65 @@ int XrdOssSys::xtrace(XrdOucStream &Config, XrdSysError &Eroute)
     return 0;
 }
 
+/******************************************************************************/
+/*                                x u r i n g                                 */
+/******************************************************************************/
+
+/* Function: xuring
+
+   Purpose:  Parse the directive: uring {off | on} [rings <n>] [depth <n>]
+                                        [regfiles]
+
+             off        Use POSIX async I/O (the default).
+             on         Use io_uring for async I/O and vector reads.
+             rings      The number of rings to use (default 1).
+             depth      The submission queue depth of each ring (default 256).
+             regfiles   Register open files with the rings.
+
+   Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdOssSys::xuring(XrdOucStream &Config, XrdSysError &Eroute)
+{
+    char *val;
+    int V_on, V_rings = -1, V_depth = -1, V_regf = -1;
+
+    if (!(val = Config.GetWord()))
+       {Eroute.Emsg("Config", "uring option not specified"); return 1;}
+    if (!strcmp(val, "on")) V_on = 1;
+       else if (!strcmp(val, "off")) V_on = 0;
+               else {Eroute.Emsg("Config", "invalid uring option -", val);
+                     return 1;
+                    }
+
+    while((val = Config.GetWord()))
+         {if (!strcmp(val, "regfiles")) V_regf = 1;
+             else if (!strcmp(val, "rings"))
+                     {if (!(val = Config.GetWord()))
+                         {Eroute.Emsg("Config", "uring rings not specified");
+                          return 1;
+                         }
+                      if (XrdOuca2x::a2i(Eroute, "uring rings", val,
+                                        &V_rings, 1, 64)) return 1;
+                     }
+             else if (!strcmp(val, "depth"))
+                     {if (!(val = Config.GetWord()))
+                         {Eroute.Emsg("Config", "uring depth not specified");
+                          return 1;
+                         }
+                      if (XrdOuca2x::a2i(Eroute, "uring depth", val,
+                                        &V_depth, 8, 4096)) return 1;
+                     }
+             else Eroute.Say("Config warning: ignoring invalid uring option '",
+                             val, "'.");
+         }
+
+// Set the values
+//
+   XrdOssUring::Set(V_on, V_rings, V_depth, V_regf);
+   return 0;
+}
+
 /******************************************************************************/
 /*                                x u s a g e                                 */
 /******************************************************************************/
@@ -2157,6 +2413,8 @@ void XrdOssSys::List_Path(const char *pfx, const char *pname,
      if (flags & XRDEXP_INPLACE) ss += " inplace";
      if (flags & XRDEXP_LOCAL)   ss += " local";
      if (flags & XRDEXP_GLBLRO)  ss += " globalro";
+     if (flags & XRDEXP_DIO)     ss += " dio";
+     if (flags & XRDEXP_STREAM)  ss += " stream";
 
      if (!(flags & XRDEXP_PFCACHE))
         {if (flags & XRDEXP_PFCACHE_X) ss += " nocache";
@@ -2175,6 +2433,7 @@ void XrdOssSys::List_Path(const char *pfx, const char *pname,
          ss += (flags & XRDEXP_MKEEP    ? " mkeep"   : " nomkeep");
          ss += (flags & XRDEXP_MLOK     ? " mlock"   : " nomlock");
         }
+     if (flags & XRDEXP_MSMALL)  ss += " mmapsmall";
 
      Eroute.Say(pfx, pname, rwmode, ss.c_str());
 }
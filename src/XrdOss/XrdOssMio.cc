@@ -67,6 +67,7 @@ long long      XrdOssMio::MM_pages    = 1024*1024*1024;
 long long      XrdOssMio::MM_pages    = (long long)sysconf(_SC_PHYS_PAGES);
 #endif
 long long      XrdOssMio::MM_max      = MM_pagsz*MM_pages/2;
+long long      XrdOssMio::MM_small    = 0;
 long long      XrdOssMio::MM_inuse    = 0;
 
 extern XrdSysError OssEroute;
@@ -79,11 +80,13 @@ extern XrdSysTrace OssTrace;
 
 void XrdOssMio::Display(XrdSysError &Eroute)
 {
-     char buff[1080];
-     snprintf(buff, sizeof(buff), "       oss.memfile %s%s%s max %lld",
+     char buff[1080], sbuff[64];
+     if (MM_small > 0) snprintf(sbuff, sizeof(sbuff), " small %lld", MM_small);
+        else *sbuff = 0;
+     snprintf(buff, sizeof(buff), "       oss.memfile %s%s%s max %lld%s",
              (MM_on      ? ""            : "off "),
              (MM_preld   ? "preload"     : ""),
-             (MM_chk     ? "check xattr" : ""), MM_max);
+             (MM_chk     ? "check xattr" : ""), MM_max, sbuff);
      Eroute.Say(buff);
 }
 
@@ -138,14 +141,23 @@ XrdOssMioFile *XrdOssMio::Map(char *path, int fd, int opts)
            return 0;
           }
       }
-   MM_inuse += statb.st_size;
 
-// Memory map the file
+// Memory map the file. The mapping is shared so that all the opens of the file
+// as well as the page cache use the same pages.
 //
-   if ((thefile = mmap(0,statb.st_size,PROT_READ,MAP_PRIVATE,fd,0))==MAP_FAILED)
+   if ((thefile = mmap(0,statb.st_size,PROT_READ,MAP_SHARED,fd,0))==MAP_FAILED)
       {OssEroute.Emsg("Mio", errno, "mmap file", path);
        return 0;
       } else {DEBUG("mmap " <<statb.st_size <<" bytes for " <<path);}
+   MM_inuse += statb.st_size;
+
+// Tell the kernel the whole file will be needed, so that it is read in with
+// large requests, and that large files may be backed by huge pages.
+//
+   madvise(thefile, statb.st_size, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+   if (statb.st_size >= MM_hugesz) madvise(thefile, statb.st_size, MADV_HUGEPAGE);
+#endif
 
 // Lock the file, if need be. Turn off locking if we don't have privs
 //
@@ -168,6 +180,7 @@ XrdOssMioFile *XrdOssMio::Map(char *path, int fd, int opts)
    if (!(mp = new XrdOssMioFile(hashname)))
       {OssEroute.Emsg("Mio", "Unable to allocate mmap file object for", path);
        munmap((char *)thefile, statb.st_size);
+       MM_inuse -= statb.st_size;
        return 0;
       }
 
@@ -183,7 +196,7 @@ XrdOssMioFile *XrdOssMio::Map(char *path, int fd, int opts)
 //
    if (MM_Hash.Add(hashname, mp))
       {OssEroute.Emsg("Mio", "Hash add failed for", path);
-       munmap((char *)thefile, statb.st_size);
+       MM_inuse -= statb.st_size;
        delete mp;
        return 0;
       }
@@ -324,10 +337,11 @@ void XrdOssMio::Set(int V_on, int V_preld,  int V_check)
    if (V_check   >= 0) MM_chk     = (char)V_check;
 }
 
-void XrdOssMio::Set(long long V_max)
+void XrdOssMio::Set(long long V_max, long long V_small)
 {
    if (V_max > 0) MM_max = V_max;
       else if (V_max < 0) MM_max = MM_pagsz*MM_pages*(-V_max)/100;
+   if (V_small > 0) MM_small = V_small;
 }
  
 /******************************************************************************/
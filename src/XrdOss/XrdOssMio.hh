@@ -50,6 +50,9 @@ static char           isAuto() {return MM_chk;}
 
 static char           isOn()   {return MM_on;}
 
+static bool           isSmall(off_t fsz)
+                             {return MM_small > 0 && fsz > 0 && fsz <= MM_small;}
+
 static XrdOssMioFile *Map(char *path, int fd, int opts);
 
 static void          *preLoad(void *arg);
@@ -58,7 +61,7 @@ static void           Recycle(XrdOssMioFile *mp);
 
 static void           Set(int V_off, int V_preld, int V_check);
 
-static void           Set(long long V_max);
+static void           Set(long long V_max, long long V_small=0);
 
 private:
 static int  Reclaim(off_t amount);
@@ -76,6 +79,8 @@ static char       MM_chk;
 static char       MM_okmlock;
 static char       MM_preld;
 static long long  MM_max;
+static long long  MM_small;
+static const long long MM_hugesz = 2*1024*1024;
 static long long  MM_pagsz;
 static long long  MM_pages;
 static long long  MM_inuse;
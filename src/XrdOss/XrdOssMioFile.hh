@@ -30,6 +30,7 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <cstring>
 #include <ctime>
 #include <sys/types.h>
   
@@ -40,6 +41,13 @@ friend class XrdOssMio;
 
 off_t Export(void **Addr) {*Addr = Base; return Size;}
 
+ssize_t Read(void *buff, off_t offset, size_t blen)
+            {if (offset >= Size) return 0;
+             if (static_cast<off_t>(blen) > Size - offset) blen = Size - offset;
+             memcpy(buff, static_cast<char *>(Base) + offset, blen);
+             return static_cast<ssize_t>(blen);
+            }
+
        XrdOssMioFile(char *hname)
                     {strcpy(HashName, hname); 
                      inUse = 1; Next = 0; Size = 0;
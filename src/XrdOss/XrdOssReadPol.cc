@@ -0,0 +1,132 @@
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d O s s R e a d P o l . c c                       */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <cstdlib>
+
+#include "XrdOss/XrdOssReadPol.hh"
+
+/******************************************************************************/
+/*                            D e s t r u c t o r                             */
+/******************************************************************************/
+
+XrdOssReadPol::~XrdOssReadPol()
+{
+   if (bBuff) free(bBuff);
+}
+
+/******************************************************************************/
+/*                                B e h i n d                                 */
+/******************************************************************************/
+
+bool XrdOssReadPol::Behind(off_t &dropOff, off_t &seqEnd)
+{
+   XrdSysMutexHelper sHelp(sMutex);
+
+   dropOff = dropEnd;
+   seqEnd  = seqNext;
+   return seqCnt >= seqReads;
+}
+
+/******************************************************************************/
+/*                                B o u n c e                                 */
+/******************************************************************************/
+
+char *XrdOssReadPol::Bounce(size_t bLen, bool &mine)
+{
+   void *bP;
+
+// Use the file's buffer if we can have it, growing it if need be. Buffers are
+// sized in 64K units so that reads of similar sizes do not regrow it.
+//
+   if (bLen <= maxBounce && bMutex.CondLock())
+      {if (bSize < bLen)
+          {size_t nSize = (bLen + 65535) & ~static_cast<size_t>(65535);
+           if (posix_memalign(&bP, dioAlign, nSize))
+              {bMutex.UnLock();
+               return 0;
+              }
+           if (bBuff) free(bBuff);
+           bBuff = static_cast<char *>(bP);
+           bSize = nSize;
+          }
+       mine = true;
+       return bBuff;
+      }
+
+// Another read has it or it would be too large to keep, get one of our own
+//
+   mine = false;
+   if (posix_memalign(&bP, dioAlign, bLen)) return 0;
+   return static_cast<char *>(bP);
+}
+
+/******************************************************************************/
+/*                              S t r e a m e d                               */
+/******************************************************************************/
+
+bool XrdOssReadPol::Streamed(off_t offset, size_t blen, long long raSize,
+                             long long dropSize, Hints &hints)
+{
+   XrdSysMutexHelper sHelp(sMutex);
+   off_t endOff = offset + blen;
+
+   hints.raOff = hints.raLen = hints.dropOff = hints.dropLen = 0;
+
+// See if this read continues the previous one. If not, a new run starts here.
+//
+   if (offset != seqNext)
+      {seqCnt = 1; raEnd = dropEnd = offset; seqNext = endOff;
+       return false;
+      }
+   seqNext = endOff;
+   if (seqCnt < seqReads && ++seqCnt < seqReads) return false;
+
+// Keep the kernel reading ahead of the reader
+//
+   if (raSize && raEnd - endOff < raSize/2)
+      {hints.raOff = (raEnd > endOff ? raEnd : endOff);
+       raEnd = endOff + raSize;
+       hints.raLen = raEnd - hints.raOff;
+      }
+
+// Drop what the reader has left behind
+//
+   if (dropSize && offset - dropEnd >= dropSize)
+      {hints.dropOff = dropEnd;
+       hints.dropLen = offset - dropEnd;
+       dropEnd = offset;
+      }
+   return true;
+}
+
+/******************************************************************************/
+/*                              U n b o u n c e                               */
+/******************************************************************************/
+
+void XrdOssReadPol::Unbounce(char *bP, bool mine)
+{
+   if (mine) bMutex.UnLock();
+      else free(bP);
+}
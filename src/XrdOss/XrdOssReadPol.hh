@@ -0,0 +1,118 @@
+#ifndef _XRDOSS_READPOL_H
+#define _XRDOSS_READPOL_H
+/******************************************************************************/
+/*                                                                            */
+/*                      X r d O s s R e a d P o l . h h                       */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <sys/types.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+// XrdOssReadPol holds the state behind the I/O policy of a file opened in a
+// path with the dio or stream option (see XrdOssFile::ReadPol()).
+//
+// Direct reads must be aligned in memory, offset, and length. An unaligned
+// read is done by reading the enclosing aligned range into a bounce buffer.
+// Each file keeps one such buffer for reuse; a read that finds it busy uses a
+// buffer of its own.
+//
+// Streamed files are watched for sequential access. Once seqReads reads in a
+// row each continue where the previous one ended, the kernel is asked to
+// read ahead of the reader and what the reader left behind is dropped from
+// the page cache. Synchronous and asynchronous readers may run concurrently,
+// so the bookkeeping is done under a lock.
+//
+class XrdOssReadPol
+{
+public:
+
+static const unsigned long long dioAlign = 4096;
+
+// Return true if a read can be done directly, i.e. without a bounce buffer
+//
+static bool    Aligned(const void *buff, off_t offset, size_t blen)
+                      {return !((reinterpret_cast<unsigned long long>(buff)
+                                | offset | blen) & (dioAlign-1));
+                      }
+
+// Compute the aligned range, bOff and bLen, that encloses a read
+//
+static void    Enclose(off_t offset, size_t blen, off_t &bOff, size_t &bLen)
+                      {bOff = offset & ~static_cast<off_t>(dioAlign-1);
+                       bLen = ((offset + blen + dioAlign-1) & ~(dioAlign-1))
+                            - bOff;
+                      }
+
+// Return how many of the got bytes read into the enclosing range belong to
+// the caller's range. There are fewer than blen if the file ends early.
+//
+static size_t  Useful(ssize_t got, off_t offset, off_t bOff, size_t blen)
+                      {got -= offset - bOff;
+                       if (got <= 0) return 0;
+                       return (static_cast<size_t>(got) > blen ? blen : got);
+                      }
+
+// Bounce() returns an aligned buffer of at least bLen bytes, or nil if there
+// is not enough memory. Upon return, mine is true if the buffer is the file's
+// own buffer. The buffer must be handed back via Unbounce().
+//
+char          *Bounce(size_t bLen, bool &mine);
+
+void           Unbounce(char *bP, bool mine);
+
+// Streamed() accounts for a read of blen bytes at offset and returns true if
+// the access is sequential. In that case hints says what should be read ahead
+// (raSize bytes beyond the read, topped up once half of it is consumed) and
+// what should be dropped (in pieces of at least dropSize bytes). Lengths are
+// zero for what need not be done.
+//
+struct Hints {off_t raOff, raLen, dropOff, dropLen;};
+
+bool           Streamed(off_t offset, size_t blen, long long raSize,
+                        long long dropSize, Hints &hints);
+
+// Behind() returns true if the access is sequential along with where the
+// reader is and where what it left behind starts to be kept.
+//
+bool           Behind(off_t &dropOff, off_t &seqEnd);
+
+               XrdOssReadPol() {}
+              ~XrdOssReadPol();
+
+static const int    seqReads  = 3;                 // Reads in a row
+static const size_t maxBounce = 16*1024*1024;      // Largest buffer kept
+
+private:
+
+XrdSysMutex    bMutex;
+char          *bBuff = 0;
+size_t         bSize = 0;
+
+XrdSysMutex    sMutex;
+off_t          seqNext = 0;
+off_t          raEnd   = 0;
+off_t          dropEnd = 0;
+int            seqCnt  = 0;
+};
+#endif
@@ -0,0 +1,130 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d O s s R e a d V . c c                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+
+#include "XrdOss/XrdOssReadV.hh"
+#include "XrdOuc/XrdOucIOVec.hh"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/******************************************************************************/
+/*                      S t a t i c   V a r i a b l e s                       */
+/******************************************************************************/
+
+namespace
+{
+// Holes are read into this buffer. Its contents are never looked at so it is
+// shared by all concurrent reads.
+//
+char gapBuff[XrdOssReadV::gapBSize];
+}
+
+/******************************************************************************/
+/*                                  P l a n                                   */
+/******************************************************************************/
+
+void XrdOssReadV::Plan(XrdOucIOVec *readV, int n, int maxGap, int maxRun)
+{
+   std::vector<int> order(n);
+   long long runEnd = 0, gap;
+   bool isSorted = true;
+   Run *rP = 0;
+
+// Vector reads usually arrive in offset order; only sort them if not
+//
+   for (int i = 0; i < n; i++)
+       {order[i] = i;
+        if (i && readV[i].offset < readV[i-1].offset) isSorted = false;
+       }
+   if (!isSorted)
+      std::stable_sort(order.begin(), order.end(),
+                       [readV](int a, int b)
+                              {return readV[a].offset < readV[b].offset;});
+
+// Build the runs
+//
+   Runs.clear(); IOV.clear(); reqBytes = gapBytes = 0;
+   Runs.reserve(n); IOV.reserve(n);
+   for (int i : order)
+       {XrdOucIOVec &rv = readV[i];
+        if (rv.size <= 0) continue;
+        reqBytes += rv.size;
+
+   // Extend the current run if the hole is small enough and the run does not
+   // become too long. Overlaps (negative holes) cannot be expressed in a
+   // single preadv() and always start a new run.
+   //
+        gap = rv.offset - runEnd;
+        if (rP && gap >= 0 && gap <= maxGap
+        &&  rP->Bytes + gap + rv.size <= maxRun
+        &&  rP->iovCnt + 1 + (gap + gapBSize - 1)/gapBSize <= IOV_MAX)
+           {while(gap)
+                 {int len = (gap > gapBSize ? gapBSize : static_cast<int>(gap));
+                  IOV.push_back({gapBuff, static_cast<size_t>(len)});
+                  rP->iovCnt++; rP->Bytes += len; gapBytes += len; gap -= len;
+                 }
+           } else {
+            Runs.push_back({static_cast<off_t>(rv.offset), 0,
+                            static_cast<int>(IOV.size()), 0});
+            rP = &Runs.back();
+           }
+
+        IOV.push_back({rv.data, static_cast<size_t>(rv.size)});
+        rP->iovCnt++; rP->Bytes += rv.size;
+        runEnd = rv.offset + rv.size;
+       }
+}
+
+/******************************************************************************/
+/*                                  R e a d                                   */
+/******************************************************************************/
+
+ssize_t XrdOssReadV::Read(int fd, const Run &run, const struct iovec *iov)
+{
+   ssize_t rdsz;
+
+   do {rdsz = preadv(fd, iov + run.iovBeg, run.iovCnt, run.Offset);}
+      while(rdsz < 0 && errno == EINTR);
+
+   if (rdsz < 0) return -errno;
+   return (rdsz == run.Bytes ? 0 : -ESPIPE);
+}
+
+/******************************************************************************/
+
+ssize_t XrdOssReadV::Read(int fd)
+{
+   ssize_t rc;
+
+   for (const Run &run : Runs)
+       if ((rc = Read(fd, run, IOV.data()))) return rc;
+   return reqBytes;
+}
@@ -0,0 +1,75 @@
+#ifndef _XRDOSS_READV_H
+#define _XRDOSS_READV_H
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d O s s R e a d V . h h                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+struct XrdOucIOVec;
+
+// XrdOssReadV turns a vector read into as few positioned vector reads as
+// possible. The elements are ordered by offset and consecutive ones are
+// merged into a run when the hole between them is at most the allowed gap.
+// Each run is a single preadv() whose iovec scatters the data directly into
+// the callers' buffers; the bytes in a hole are read into a scratch buffer
+// and discarded. Overlapping elements always start a new run.
+//
+class XrdOssReadV
+{
+public:
+
+struct Run {off_t   Offset;   // File offset of the run
+            ssize_t Bytes;    // Bytes to read, including holes
+            int     iovBeg;   // Index of the first iovec in IOV
+            int     iovCnt;   // Number of iovecs in the run
+           };
+
+std::vector<Run>          Runs;
+std::vector<struct iovec> IOV;
+long long                 reqBytes;  // Bytes requested by the caller
+long long                 gapBytes;  // Bytes read only to bridge holes
+
+// Plan the vector read. Elements are merged when the hole is at most maxGap
+// bytes (a negative value merges nothing) and the run stays within maxRun.
+//
+void           Plan(XrdOucIOVec *readV, int n, int maxGap, int maxRun);
+
+// Read a single run or all of them. Return 0 or reqBytes upon success, and
+// -errno otherwise. A run that comes up short is an error (-ESPIPE).
+//
+static ssize_t Read(int fd, const Run &run, const struct iovec *iov);
+
+ssize_t        Read(int fd);
+
+               XrdOssReadV() : reqBytes(0), gapBytes(0) {}
+              ~XrdOssReadV() {}
+
+// The largest hole a single iovec can bridge
+//
+static const int gapBSize = 65536;
+};
+#endif
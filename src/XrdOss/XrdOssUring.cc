@@ -0,0 +1,582 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d O s s U r i n g . c c                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#include "XrdOss/XrdOssReadV.hh"
+#include "XrdOss/XrdOssTrace.hh"
+#include "XrdOss/XrdOssUring.hh"
+#include "XrdOuc/XrdOucPgrwUtils.hh"
+#include "XrdSfs/XrdSfsAio.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+/******************************************************************************/
+/*                      S t a t i c   V a r i a b l e s                       */
+/******************************************************************************/
+
+bool XrdOssUring::cfgOn    = false;
+int  XrdOssUring::cfgRings = 1;
+int  XrdOssUring::cfgDepth = 256;
+bool XrdOssUring::cfgRegF  = false;
+int  XrdOssUring::numRings = 0;
+
+extern XrdSysError OssEroute;
+
+extern XrdSysTrace OssTrace;
+
+/******************************************************************************/
+/*                         L o c a l   O b j e c t s                          */
+/******************************************************************************/
+
+#ifdef HAVE_IO_URING
+namespace
+{
+// The kind of request is kept in the low order bits of the user data, the
+// rest is the address of the aio object or the vector read segment.
+//
+enum reqKind {kRead = 0, kPgRead, kWrite, kFsync, kReadV, kMask = 7};
+
+// A vector read waits for all of its queued segments
+//
+struct rvWait
+      {XrdSysSemaphore       Done;
+       std::atomic<int>      Left;
+       std::atomic<ssize_t>  Error;
+       rvWait() : Done(0), Left(1), Error(0) {}
+      };
+
+struct alignas(8) rvSeg
+      {rvWait *wP;
+       ssize_t Size;
+      };
+
+// Each ring is mapped into our address space. Submissions are serialized by
+// the ring's mutex; completions are reaped by the ring's own thread.
+//
+struct Ring
+      {XrdSysMutex           sqMutex;
+       std::atomic<unsigned> inFlight{0};
+       unsigned             *sqHead   = 0;
+       unsigned             *sqTail   = 0;
+       unsigned             *sqMask   = 0;
+       unsigned             *sqArray  = 0;
+       io_uring_sqe         *sqes     = 0;
+       unsigned             *cqHead   = 0;
+       unsigned             *cqTail   = 0;
+       unsigned             *cqMask   = 0;
+       io_uring_cqe         *cqes     = 0;
+       unsigned              sqEntries= 0;
+       unsigned              cqEntries= 0;
+       int                   ringFD   = -1;
+       int                   errCnt   = 0;
+      };
+
+Ring    *Rings   = 0;
+unsigned ringCnt = 0;     // Number of usable rings
+int      regMax  = 0;     // Number of registered file slots
+std::atomic<unsigned> nextRing{0};
+
+int sysSetup(unsigned entries, io_uring_params *p)
+   {return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));}
+
+int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+   {return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));}
+
+int sysRegister(int fd, unsigned opcode, void *arg, unsigned nargs)
+   {return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode,
+                                    arg, nargs));}
+
+unsigned ldAcq(unsigned *p) {return __atomic_load_n(p, __ATOMIC_ACQUIRE);}
+
+void     stRel(unsigned *p, unsigned v) {__atomic_store_n(p, v, __ATOMIC_RELEASE);}
+
+/******************************************************************************/
+/*                                  D o n e                                   */
+/******************************************************************************/
+
+// Complete a request. This runs in the completion thread of the ring.
+
+void Done(unsigned long long uData, int res)
+{
+   EPNAME("UringDone");
+   int kind = static_cast<int>(uData & kMask);
+
+// Vector read segments only account for themselves
+//
+   if (kind == kReadV)
+      {rvSeg  *sP = reinterpret_cast<rvSeg *>(uData & ~(unsigned long long)kMask);
+       rvWait *wP = sP->wP;
+       ssize_t noErr = 0;
+       if (res != sP->Size)
+          wP->Error.compare_exchange_strong(noErr, (res < 0 ? res : -ESPIPE));
+       if (--(wP->Left) == 0) wP->Done.Post();
+       return;
+      }
+
+// Everything else is an aio request
+//
+   XrdSfsAio *aiop = reinterpret_cast<XrdSfsAio *>(uData & ~(unsigned long long)kMask);
+   aiop->Result = res;
+   DEBUG((kind == kWrite || kind == kFsync ? "write" : "read")
+         <<" completed for " <<aiop->TIdent <<"; result=" <<res
+         <<" aiocb=" <<Xrd::hex1 <<aiop);
+
+   switch(kind)
+         {case kPgRead: if (res > 0 && aiop->cksVec)
+                           XrdOucPgrwUtils::csCalc((const char *)aiop->sfsAio.aio_buf,
+                                           (off_t)aiop->sfsAio.aio_offset,
+                                           (size_t)res, aiop->cksVec);
+                        // Fall through
+          case kRead:   aiop->doneRead();
+                        break;
+          default:      aiop->doneWrite();
+                        break;
+         }
+}
+
+/******************************************************************************/
+/*                                  R e a p                                   */
+/******************************************************************************/
+
+// Each ring has a thread that waits for completions and runs them. The queue
+// entries are copied out first so that the kernel may reuse them while the
+// (possibly slow) completion callbacks run.
+
+void *Reap(void *carg)
+{
+   Ring *rP = static_cast<Ring *>(carg);
+   struct {unsigned long long uData; int res;} done[64];
+   unsigned head, tail;
+   int n;
+
+   while(1)
+        {if (sysEnter(rP->ringFD, 0, 1, IORING_ENTER_GETEVENTS) < 0
+         &&  errno != EINTR)
+            {if ((rP->errCnt++ & 0x3ff) == 0)
+                OssEroute.Emsg("Uring", errno, "wait for io_uring completions");
+             sched_yield();
+             continue;
+            }
+         do {head = *rP->cqHead;
+             tail = ldAcq(rP->cqTail);
+             for (n = 0; head != tail && n < 64; head++, n++)
+                 {io_uring_cqe *cqe = &rP->cqes[head & *rP->cqMask];
+                  done[n].uData = cqe->user_data;
+                  done[n].res   = cqe->res;
+                 }
+             stRel(rP->cqHead, head);
+             rP->inFlight -= n;
+             for (int i = 0; i < n; i++) Done(done[i].uData, done[i].res);
+            } while(n);
+        }
+   return (void *)0;
+}
+
+/******************************************************************************/
+/*                                S u b m i t                                 */
+/******************************************************************************/
+
+// Queue a request on the next ring. Return false if it could not be queued.
+
+bool Submit(int fd, int op, void *buff, size_t blen, off_t offs,
+            unsigned long long uData)
+{
+   Ring *rP = &Rings[nextRing++ % ringCnt];
+   io_uring_sqe *sqe;
+   unsigned tail, idx;
+   int rc, retry = 0;
+
+// Make sure we can take this request. We never allow more requests in flight
+// than the completion queue can hold so that it cannot overflow.
+//
+   rP->sqMutex.Lock();
+   tail = *rP->sqTail;
+   if (rP->inFlight >= rP->cqEntries
+   ||  tail - ldAcq(rP->sqHead) >= rP->sqEntries)
+      {rP->sqMutex.UnLock();
+       return false;
+      }
+
+// Fill out the submission entry
+//
+   idx = tail & *rP->sqMask;
+   sqe = &rP->sqes[idx];
+   memset(sqe, 0, sizeof(io_uring_sqe));
+   sqe->opcode    = static_cast<unsigned char>(op);
+   if (fd & XrdOssUring::isFixed)
+      {sqe->fd    = fd & ~XrdOssUring::isFixed;
+       sqe->flags = IOSQE_FIXED_FILE;
+      } else sqe->fd = fd;
+   sqe->addr      = reinterpret_cast<unsigned long long>(buff);
+   sqe->len       = static_cast<unsigned>(blen);
+   sqe->off       = static_cast<unsigned long long>(offs);
+   sqe->user_data = uData;
+   rP->sqArray[idx] = idx;
+   stRel(rP->sqTail, tail+1);
+   rP->inFlight++;
+
+// Tell the kernel. It may take fewer entries than were offered, in which case
+// we offer the rest again. The kernel consumes entries in order so ours was
+// taken once the head passed it. A lack of kernel resources is usually
+// transient so we retry a few times.
+//
+   do {rc = sysEnter(rP->ringFD, tail+1 - ldAcq(rP->sqHead), 0, 0);
+       if (ldAcq(rP->sqHead) == tail+1) break;
+       if (rc < 0 && errno == EINTR) continue;
+       if (rc < 0 && errno != EAGAIN && errno != EBUSY) break;
+       if (++retry > 3) break;
+       sched_yield();
+      } while(1);
+
+// If the kernel did not take the request, withdraw it so that the caller can
+// do it synchronously. Nobody would ever see its completion otherwise. Ours is
+// the last entry as we hold the submission lock.
+//
+   if (ldAcq(rP->sqHead) != tail+1)
+      {if ((rP->errCnt++ & 0x3ff) == 0)
+          OssEroute.Emsg("Uring", (rc < 0 ? errno : EAGAIN),
+                         "submit io_uring request");
+       stRel(rP->sqTail, tail);
+       rP->inFlight--;
+       rP->sqMutex.UnLock();
+       return false;
+      }
+   rP->sqMutex.UnLock();
+   return true;
+}
+
+/******************************************************************************/
+/*                                 P r o b e                                  */
+/******************************************************************************/
+
+// Verify that the kernel supports the operations we use.
+
+bool Probe(int ringFD)
+{
+   static const int ops[] = {IORING_OP_READ, IORING_OP_READV,
+                             IORING_OP_WRITE, IORING_OP_FSYNC};
+   size_t psz = sizeof(io_uring_probe) + 256*sizeof(io_uring_probe_op);
+   std::vector<char> pbuff(psz, 0);
+   io_uring_probe *pP = reinterpret_cast<io_uring_probe *>(pbuff.data());
+
+   if (sysRegister(ringFD, IORING_REGISTER_PROBE, pP, 256) < 0) return false;
+   for (int op : ops)
+       if (op > pP->last_op || !(pP->ops[op].flags & IO_URING_OP_SUPPORTED))
+          return false;
+   return true;
+}
+
+/******************************************************************************/
+/*                                 S e t u p                                  */
+/******************************************************************************/
+
+// Create a ring and map it into our address space.
+
+int Setup(Ring &ring, int depth)
+{
+   io_uring_params p;
+   size_t sqSz, cqSz;
+   char *sqP, *cqP;
+   void *sqeP;
+
+   memset(&p, 0, sizeof(p));
+   if ((ring.ringFD = sysSetup(depth, &p)) < 0) return errno;
+   if (!Probe(ring.ringFD)) return ENOTSUP;
+
+   sqSz = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+   cqSz = p.cq_off.cqes  + p.cq_entries*sizeof(io_uring_cqe);
+   if (p.features & IORING_FEAT_SINGLE_MMAP) sqSz = cqSz = (sqSz > cqSz ? sqSz : cqSz);
+
+   sqP = static_cast<char *>(mmap(0, sqSz, PROT_READ|PROT_WRITE,
+                             MAP_SHARED|MAP_POPULATE, ring.ringFD,
+                             IORING_OFF_SQ_RING));
+   if (sqP == MAP_FAILED) return errno;
+   if (p.features & IORING_FEAT_SINGLE_MMAP) cqP = sqP;
+      else {cqP = static_cast<char *>(mmap(0, cqSz, PROT_READ|PROT_WRITE,
+                                      MAP_SHARED|MAP_POPULATE, ring.ringFD,
+                                      IORING_OFF_CQ_RING));
+            if (cqP == MAP_FAILED) return errno;
+           }
+   sqeP = mmap(0, p.sq_entries*sizeof(io_uring_sqe), PROT_READ|PROT_WRITE,
+               MAP_SHARED|MAP_POPULATE, ring.ringFD, IORING_OFF_SQES);
+   if (sqeP == MAP_FAILED) return errno;
+
+   ring.sqHead    = reinterpret_cast<unsigned *>(sqP + p.sq_off.head);
+   ring.sqTail    = reinterpret_cast<unsigned *>(sqP + p.sq_off.tail);
+   ring.sqMask    = reinterpret_cast<unsigned *>(sqP + p.sq_off.ring_mask);
+   ring.sqArray   = reinterpret_cast<unsigned *>(sqP + p.sq_off.array);
+   ring.sqes      = static_cast<io_uring_sqe *>(sqeP);
+   ring.cqHead    = reinterpret_cast<unsigned *>(cqP + p.cq_off.head);
+   ring.cqTail    = reinterpret_cast<unsigned *>(cqP + p.cq_off.tail);
+   ring.cqMask    = reinterpret_cast<unsigned *>(cqP + p.cq_off.ring_mask);
+   ring.cqes      = reinterpret_cast<io_uring_cqe *>(cqP + p.cq_off.cqes);
+   ring.sqEntries = p.sq_entries;
+   ring.cqEntries = p.cq_entries;
+
+// Register a sparse file table, if so wanted. Slots are filled in as files
+// are opened and the slot number is the file descriptor itself.
+//
+   if (regMax)
+      {std::vector<int> fds(regMax, -1);
+       if (sysRegister(ring.ringFD, IORING_REGISTER_FILES, fds.data(),
+                       regMax) < 0) return errno;
+      }
+   return 0;
+}
+}
+#endif
+
+/******************************************************************************/
+/*                               D i s p l a y                                */
+/******************************************************************************/
+
+void XrdOssUring::Display(XrdSysError &Eroute)
+{
+     char buff[128];
+
+     if (!cfgOn) Eroute.Say("       oss.uring off");
+        else {snprintf(buff, sizeof(buff), "       oss.uring on rings %d "
+                       "depth %d%s", cfgRings, cfgDepth,
+                       (cfgRegF ? " regfiles" : ""));
+              Eroute.Say(buff);
+             }
+}
+
+/******************************************************************************/
+/*                                 F s y n c                                  */
+/******************************************************************************/
+
+bool XrdOssUring::Fsync(int fd, XrdSfsAio *aiop)
+{
+#ifdef HAVE_IO_URING
+   if (numRings)
+      return Submit(fd, IORING_OP_FSYNC, 0, 0, 0,
+                    reinterpret_cast<unsigned long long>(aiop) | kFsync);
+#endif
+   return false;
+}
+
+/******************************************************************************/
+/*                                  I n i t                                   */
+/******************************************************************************/
+
+bool XrdOssUring::Init(XrdSysError &Eroute)
+{
+#ifdef HAVE_IO_URING
+   pthread_t tid;
+   int i, rc;
+
+// Nothing to do if we are not enabled
+//
+   if (!cfgOn) return false;
+
+// Size the registered file table to cover the descriptors we may have. Older
+// kernels allow at most 32K registered files; higher ones are not registered.
+//
+   if (cfgRegF)
+      {struct rlimit rlim;
+       if (getrlimit(RLIMIT_NOFILE, &rlim) || rlim.rlim_cur == RLIM_INFINITY
+       ||  rlim.rlim_cur > 32768) regMax = 32768;
+          else regMax = static_cast<int>(rlim.rlim_cur);
+      }
+
+// Create the rings
+//
+   Rings = new Ring[cfgRings];
+   for (i = 0; i < cfgRings; i++)
+       if ((rc = Setup(Rings[i], cfgDepth)))
+          {Eroute.Emsg("Config", rc, "create io_uring; "
+                                    "falling back to POSIX async I/O");
+           return false;
+          }
+
+// Start a completion thread for each ring. The rings are not usable until
+// all threads are running.
+//
+   for (i = 0; i < cfgRings; i++)
+       if ((rc = XrdSysThread::Run(&tid, Reap, (void *)&Rings[i], 0,
+                                   "oss uring completions")))
+          {Eroute.Emsg("Config", rc, "create io_uring completion thread; "
+                                    "falling back to POSIX async I/O");
+           return false;
+          }
+   numRings = cfgRings;
+   ringCnt  = static_cast<unsigned>(cfgRings);
+   return true;
+#else
+   if (cfgOn) Eroute.Say("Config warning: io_uring is not supported on this "
+                         "platform; falling back to POSIX async I/O.");
+   return false;
+#endif
+}
+
+/******************************************************************************/
+/*                                  R e a d                                   */
+/******************************************************************************/
+
+bool XrdOssUring::Read(int fd, XrdSfsAio *aiop, bool pgRead)
+{
+#ifdef HAVE_IO_URING
+   if (numRings)
+      return Submit(fd, IORING_OP_READ, (void *)aiop->sfsAio.aio_buf,
+                    aiop->sfsAio.aio_nbytes, aiop->sfsAio.aio_offset,
+                    reinterpret_cast<unsigned long long>(aiop)
+                    | (pgRead ? kPgRead : kRead));
+#endif
+   return false;
+}
+
+/******************************************************************************/
+/*                                 R e a d V                                  */
+/******************************************************************************/
+
+ssize_t XrdOssUring::ReadV(int fd, XrdOssReadV &rvPlan)
+{
+#ifdef HAVE_IO_URING
+   rvWait theWait;
+   int n = static_cast<int>(rvPlan.Runs.size());
+   std::vector<rvSeg> segs(n);
+   int sysFD = fd & ~isFixed;
+   ssize_t rc;
+
+// Queue all of the runs, reading the ones that could not be queued
+//
+   for (int i = 0; i < n; i++)
+       {XrdOssReadV::Run &run = rvPlan.Runs[i];
+        segs[i].wP = &theWait; segs[i].Size = run.Bytes;
+        theWait.Left++;
+        if (numRings
+        &&  Submit(fd, IORING_OP_READV, &rvPlan.IOV[run.iovBeg], run.iovCnt,
+                   run.Offset,
+                   reinterpret_cast<unsigned long long>(&segs[i]) | kReadV))
+           continue;
+        theWait.Left--;
+        if ((rc = XrdOssReadV::Read(sysFD, run, rvPlan.IOV.data())))
+           {ssize_t noErr = 0;
+            theWait.Error.compare_exchange_strong(noErr, rc);
+            break;
+           }
+       }
+
+// Wait for whatever is still outstanding. We must wait even after an error as
+// the segments refer to our stack.
+//
+   if (--theWait.Left) theWait.Done.Wait();
+   return (theWait.Error ? theWait.Error.load() : rvPlan.reqBytes);
+#else
+   return -ENOTSUP;
+#endif
+}
+
+/******************************************************************************/
+/*                              R e g i s t e r                               */
+/******************************************************************************/
+
+bool XrdOssUring::Register(int fd)
+{
+#ifdef HAVE_IO_URING
+   io_uring_files_update upd;
+   int i;
+
+   if (!numRings || !regMax || fd < 0 || fd >= regMax) return false;
+   memset(&upd, 0, sizeof(upd));
+   upd.offset = fd;
+   upd.fds    = reinterpret_cast<unsigned long long>(&fd);
+   for (i = 0; i < numRings; i++)
+       if (sysRegister(Rings[i].ringFD, IORING_REGISTER_FILES_UPDATE,
+                       &upd, 1) < 0) break;
+   if (i >= numRings) return true;
+
+// Undo whatever we did as the file will not be used as a fixed file
+//
+   int none = -1;
+   upd.fds = reinterpret_cast<unsigned long long>(&none);
+   while(i--) sysRegister(Rings[i].ringFD, IORING_REGISTER_FILES_UPDATE, &upd, 1);
+   return false;
+#else
+   return false;
+#endif
+}
+
+/******************************************************************************/
+/*                                   S e t                                    */
+/******************************************************************************/
+
+void XrdOssUring::Set(int on, int rings, int depth, int regf)
+{
+   if (on    >= 0) cfgOn    = on != 0;
+   if (rings >  0) cfgRings = rings;
+   if (depth >  0) cfgDepth = depth;
+   if (regf  >= 0) cfgRegF  = regf != 0;
+}
+
+/******************************************************************************/
+/*                            U n r e g i s t e r                             */
+/******************************************************************************/
+
+void XrdOssUring::Unregister(int fd)
+{
+#ifdef HAVE_IO_URING
+   io_uring_files_update upd;
+   int none = -1;
+
+   if (!numRings || fd < 0 || fd >= regMax) return;
+   memset(&upd, 0, sizeof(upd));
+   upd.offset = fd;
+   upd.fds    = reinterpret_cast<unsigned long long>(&none);
+   for (int i = 0; i < numRings; i++)
+       sysRegister(Rings[i].ringFD, IORING_REGISTER_FILES_UPDATE, &upd, 1);
+#endif
+}
+
+/******************************************************************************/
+/*                                 W r i t e                                  */
+/******************************************************************************/
+
+bool XrdOssUring::Write(int fd, XrdSfsAio *aiop)
+{
+#ifdef HAVE_IO_URING
+   if (numRings)
+      return Submit(fd, IORING_OP_WRITE, (void *)aiop->sfsAio.aio_buf,
+                    aiop->sfsAio.aio_nbytes, aiop->sfsAio.aio_offset,
+                    reinterpret_cast<unsigned long long>(aiop) | kWrite);
+#endif
+   return false;
+}
@@ -0,0 +1,101 @@
+#ifndef _XRDOSS_URING_H
+#define _XRDOSS_URING_H
+/******************************************************************************/
+/*                                                                            */
+/*                        X r d O s s U r i n g . h h                         */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <sys/types.h>
+
+class XrdOssReadV;
+class XrdSfsAio;
+class XrdSysError;
+
+// XrdOssUring is the io_uring based asynchronous I/O engine used by XrdOssFile
+// when "oss.uring on" is configured. Requests are spread over one or more
+// rings, each with its own completion thread that runs the aio completion
+// callbacks, so neither signals nor a thread per request are needed. When a
+// request cannot be queued (rings full or engine off) the caller performs
+// it synchronously, just as it does when POSIX aio is unavailable.
+//
+class XrdOssUring
+{
+public:
+
+// Display the configuration.
+//
+static void    Display(XrdSysError &Eroute);
+
+// Queue an fsync, read, pgRead, or write. The file number is the one to use
+// in the request; it is the registered slot if the file was registered. The
+// return value is true if the request was queued. Its completion is then
+// reported via the aio object's doneRead() or doneWrite().
+//
+static bool    Fsync(int fd, XrdSfsAio *aiop);
+
+static bool    Read(int fd, XrdSfsAio *aiop, bool pgRead=false);
+
+static bool    Write(int fd, XrdSfsAio *aiop);
+
+// Perform a planned vector read by queueing all of its runs at once and
+// waiting for them. Runs that cannot be queued are read synchronously.
+// Returns the bytes requested or -errno; a short run is an error (-ESPIPE).
+//
+static ssize_t ReadV(int fd, XrdOssReadV &rvPlan);
+
+// Initialize the rings and start the completion threads. Returns true if the
+// engine is on, false if it is off or could not be started.
+//
+static bool    Init(XrdSysError &Eroute);
+
+// Return true if the engine was configured or is running.
+//
+static bool    isSet() {return cfgOn;}
+
+static bool    isOn()  {return numRings > 0;}
+
+// Register or unregister a file descriptor with all rings if registered files
+// were configured. Register() returns true if the descriptor is registered;
+// requests for it should then be marked as using a fixed file.
+//
+static bool    Register(int fd);
+
+static void    Unregister(int fd);
+
+// Set the configuration; negative values leave the corresponding setting.
+//
+static void    Set(int on, int rings, int depth, int regf);
+
+// The fixed file flag is or'ed into the file number passed above.
+//
+static const int isFixed = 0x40000000;
+
+private:
+
+static bool    cfgOn;
+static int     cfgRings;
+static int     cfgDepth;
+static bool    cfgRegF;
+static int     numRings;
+};
+#endif
@@ -28,9 +28,16 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <algorithm>
+#include <ctype.h>
+#include <dirent.h>
+#include <stdlib.h>
 #include <sys/param.h>
 #include <sys/stat.h>
 
+#include <string>
+#include <vector>
+
 #include "Xrd/XrdScheduler.hh"
 
 #include "XrdOss/XrdOss.hh"
@@ -41,6 +48,7 @@
 #include "XrdOssArc/XrdOssArcFSMon.hh"
 #include "XrdOssArc/XrdOssArcStopMon.hh"
 #include "XrdOssArc/XrdOssArcTrace.hh"
+#include "XrdOssArc/XrdOssArcZipWriter.hh"
 
 #include "XrdOuc/XrdOucProg.hh"
 #include "XrdOuc/XrdOucUtils.hh"
@@ -50,6 +58,8 @@
 #include "XrdSys/XrdSysPlatform.hh"
 #include "XrdSys/XrdSysPthread.hh"
 
+#include "XrdXrootd/XrdXrootdGStream.hh"
+
 /******************************************************************************/
 /*                        G l o b a l   O b j e c t s                         */
 /******************************************************************************/
@@ -433,6 +443,14 @@ bool XrdOssArcBackup::Archive(const char* dsName, const char* dsDir)
        return false;
       }
 
+// If we compose the archives ourselves, do so now. The archive script treats
+// an existing read-only archive as complete and only disposes of it.
+//
+   if (Config.cmpReaders && !Compose(dsName, dsDir))
+      {Elog.Emsg("Archive", "Dataset", dsName, "needs manual intervention!!!");
+       return false;
+      }
+
 // Do some tracing
 //
    DEBUG("Running "<<Config.ArchiverName<<' '<<argV[0]<<' '
@@ -460,6 +478,104 @@ bool XrdOssArcBackup::Archive(const char* dsName, const char* dsDir)
    return true;   
 }
   
+/******************************************************************************/
+/* Private:                      C o m p o s e                                */
+/******************************************************************************/
+
+bool XrdOssArcBackup::Compose(const char* dsName, const char* dsDir)
+{
+   TraceInfo("Compose",0);
+   std::vector<int> segs;
+   std::string arcBase(Config.arFName), arcSfx;
+   struct dirent* dP;
+   DIR* dirP;
+   char* eP;
+   int n;
+
+// Archive sources are placed in subdirectories named ~1, ~2, etc. and each
+// one becomes a separate archive. They must be numbered consecutively.
+//
+   if (!(dirP = opendir(dsDir)))
+      {Elog.Emsg("Compose", errno, "open dataset directory", dsDir);
+       return false;
+      }
+   while((dP = readdir(dirP)))
+        {if (dP->d_name[0] != '~' || !isdigit(dP->d_name[1])) continue;
+         n = strtol(dP->d_name+1, &eP, 10);
+         if (!*eP) segs.push_back(n);
+        }
+   closedir(dirP);
+   std::sort(segs.begin(), segs.end());
+   for (int i = 0; i < (int)segs.size(); i++)
+       if (segs[i] != i+1)
+          {Elog.Emsg("Compose", "Missing or extra archive source directory "
+                                "in", dsDir);
+           return false;
+          }
+   if (segs.empty())
+      {Elog.Emsg("Compose", "Missing archive source directory ~1 in", dsDir);
+       return false;
+      }
+
+// Archives are named <base><n>-<count>.<sfx>, the same as the archiver does
+//
+   std::string::size_type pos = arcBase.rfind('.');
+   if (pos != std::string::npos)
+      {arcSfx = arcBase.substr(pos);
+       arcBase.erase(pos);
+      }
+
+// Compose each archive
+//
+   XrdOssArcZipWriter zWriter(Config.cmpReaders, Config.cmpWinSz);
+   for (int seg : segs)
+       {XrdOssArcZipWriter::Stats zStats;
+        std::string eText;
+        char srcDir[MAXPATHLEN], arcFN[MAXPATHLEN], arcPath[MAXPATHLEN];
+        int rc;
+
+        snprintf(arcFN, sizeof(arcFN), "%s%d-%d%s", arcBase.c_str(), seg,
+                 (int)segs.size(), arcSfx.c_str());
+        snprintf(srcDir,  sizeof(srcDir),  "%s/~%d", dsDir, seg);
+        n = snprintf(arcPath, sizeof(arcPath), "%s/%s", dsDir, arcFN);
+        if (n >= (int)sizeof(arcPath))
+           {Elog.Emsg("Compose", ENAMETOOLONG, "compose archive in", dsDir);
+            return false;
+           }
+
+        DEBUG("Composing "<<arcPath<<" from "<<srcDir<<" using "
+                          <<Config.cmpReaders<<" readers");
+
+        if ((rc = zWriter.Build(srcDir, arcPath, zStats, eText)))
+           {Elog.Emsg("Compose", rc, eText.c_str());
+            return false;
+           }
+        if (zStats.idxRC) Elog.Emsg("Compose", zStats.idxRC, eText.c_str());
+
+    // Report the throughput
+    //
+        double mbps = (zStats.elapsed > 0 ? zStats.arcBytes / zStats.elapsed
+                                            / 1048576.0 : 0.0);
+        char buff[MAXPATHLEN+1024];
+        snprintf(buff, sizeof(buff), "%s:%s %s composed; %d files %lld bytes "
+                 "in %.3f sec (%.1f MB/s)", Scope, dsName, arcFN,
+                 zStats.numFiles, zStats.arcBytes, zStats.elapsed, mbps);
+        Elog.Emsg("Compose", buff);
+
+        if (Config.gStream)
+           {n = snprintf(buff, sizeof(buff), "{\"event\":\"ossarc_compose\","
+                         "\"scope\":\"%s\",\"dsn\":\"%s\",\"archive\":\"%s\","
+                         "\"files\":%d,\"bytes\":%lld,\"arcbytes\":%lld,"
+                         "\"secs\":%.3f,\"mbps\":%.1f}", Scope, dsName, arcFN,
+                         zStats.numFiles, zStats.numBytes, zStats.arcBytes,
+                         zStats.elapsed, mbps);
+            if (n < (int)sizeof(buff)) Config.gStream->Insert(buff, n+1);
+           }
+       }
+
+   return true;
+}
+  
 /******************************************************************************/
 /*                                  D o I t                                   */
 /******************************************************************************/
@@ -90,6 +90,7 @@ char* theScope() {return Scope;}
 private:
 
        bool Add2Bkp(const char* dsn);
+       bool Compose(const char* dsName, const char* dsDir);
        int  GetManifest();
 
 const char* Scope;
@@ -163,6 +163,10 @@ XrdOssArcConfig::XrdOssArcConfig()
    stopChk     = 10;
    bkpLocal    = true;
 
+   gStream     = 0;
+   cmpReaders  = 0;
+   cmpWinSz    = 8*1024*1024;
+
    arcSZ_Skip  = false;
    arcSZ_Want  = 0;  // The XrdOssArc_BkpUtils defines the default
    arcSZ_MinV  = 0;
@@ -494,6 +498,7 @@ bool XrdOssArcConfig::ConfigProc(const char* drctv)
 //
         if (!strcmp(drctv, "arcsize")) return xqArcsz();
    else if (!strcmp(drctv, "backup"))  return xqBkup();
+   else if (!strcmp(drctv, "compose")) return xqCompose();
    else if (!strcmp(drctv, "manifest"))return xqManf();
    else if (!strcmp(drctv, "msscmd"))
            return xqGrab("msscmd", MssComCmd, Conf->LastLine());
@@ -521,6 +526,10 @@ bool  XrdOssArcConfig::ConfigXeq(const char* cfName, const char* parms,
    int rc;
    bool NoGo = false;
 
+// Pick up the monitoring stream, if any, to report archive statistics
+//
+   if (envP) gStream = (XrdXrootdGStream*)envP->GetPtr("oss.gStream*");
+
 // Get all relevant config options. Ignore the parms.
 //
    if ((rc = Cfile.Gather(cfName, XrdOucGatherConf::full_lines)) <= 0)
@@ -867,6 +876,60 @@ bool XrdOssArcConfig::xqGrab(const char* what, char*& theDest,
    return true;
 }
   
+/******************************************************************************/
+/* Private:                    x q C o m p o s e                              */
+/******************************************************************************/
+/*
+  compose {archiver | internal} [readers <n>] [window <sz>]
+*/
+
+bool XrdOssArcConfig::xqCompose()
+{
+   static const long long minWin = 1024*1024, maxWin = 256*1024*1024;
+   char* val;
+   long long wsz;
+   int   num, rc;
+
+// Get the mode, there must be one
+//
+   if (!(val = Conf->GetToken()))
+      {Conf->MsgfE("No compose mode specified");
+       return false;
+      }
+
+        if (!strcmp(val, "archiver")) cmpReaders = 0;
+   else if (!strcmp(val, "internal")) cmpReaders = 4;
+   else {Conf->MsgE("Invalid compose mode -", val);
+         return false;
+        }
+
+// Now process all of the options
+//
+   while((val = Conf->GetToken()))
+        {     if (!strcmp(val, "readers"))
+                 {if (!(val = Conf->GetToken())) return MissArg("'readers' value");
+                  rc = XrdOuca2x::a2i(Elog, "compose readers value", val, &num,
+                                      1, 64);
+                  if (rc) {Conf->EchoLine(); return false;}
+                  if (cmpReaders) cmpReaders = num;
+                 }
+         else if (!strcmp(val, "window"))
+                 {if (!(val = Conf->GetToken())) return MissArg("'window' value");
+                  rc = XrdOuca2x::a2sz(Elog, "compose window value", val, &wsz,
+                                       minWin, maxWin);
+                  if (rc) {Conf->EchoLine(); return false;}
+                  cmpWinSz = (int)((wsz + 4095) & ~4095LL);
+                 }
+         else {Conf->MsgE("unknown compose option -", val);
+               return false;
+              }
+        }
+
+// All done
+//
+   return true;
+}
+  
 /******************************************************************************/
 /* Private:                       x q M a n f                                 */
 /******************************************************************************/
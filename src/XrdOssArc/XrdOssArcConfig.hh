@@ -33,6 +33,7 @@ class XrdOucEnv;
 class XrdOucProg;
 class XrdOucGatherConf;
 class XrdOssArcStopMon;
+class XrdXrootdGStream;
 
 class XrdOssArcConfig
 {
@@ -118,6 +119,10 @@ long long   arcSZ_MaxV;    // Maximum size archive can have
 bool        arcSZ_Skip;    // When true skip archiving if size can't be met
 bool        bkpLocal;      // T->Use fuse mount for backup, else do remote copy.
 
+XrdXrootdGStream* gStream; // Monitoring stream for archive statistics or nil
+int         cmpReaders;    // Threads composing an archive, 0 -> use archiver
+int         cmpWinSz;      // Bytes of the archive each thread writes at once
+
 private:
 void ConfigPath(char** pDest, const char* pRoot);
 bool ConfigProc(const char* drctv);
@@ -130,6 +135,7 @@ bool xqArcsz();
 bool xqBkup();
 bool xqBkupPS(char* tval);
 bool xqBkupScope();
+bool xqCompose();
 bool xqManf();
 bool xqPaths();
 bool xqRse();
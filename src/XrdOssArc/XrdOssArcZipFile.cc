@@ -35,6 +35,7 @@
 #include <sys/stat.h>
 
 #include <zip.h>
+#include <zlib.h>
 
 #include "XrdOss/XrdOss.hh"
 #include "XrdOssArc/XrdOssArcZipFile.hh"
@@ -42,6 +43,7 @@
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysFD.hh"
+#include "XrdZip/XrdZipLFH.hh"
 
 /******************************************************************************/
 /*                        G l o b a l   O b j e c t s                         */
@@ -59,9 +61,6 @@ using namespace XrdOssArcGlobals;
 
 XrdOssArcZipFile::XrdOssArcZipFile(const char* path, int &rc)
 {
-   XrdOucEnv zipEnv;
-   int zFD, zrc;
-
 // Try to open the file. We only support read mode.
 //
    if ((zFD = XrdSysFD_Open(path, O_RDONLY)) < 0)
@@ -69,8 +68,8 @@ XrdOssArcZipFile::XrdOssArcZipFile(const char* path, int &rc)
        return;
       }
 
-// Get the stat information for the archive now using the retrned FD as
-// as attaching the FD to a zipfile "destroys" the original FD.
+// Get the stat information for the archive as it identifies the archive's
+// index.
 //
    if (fstat(zFD, &zFStat)) memset(&zFStat, 0, sizeof(zFStat));
 
@@ -78,13 +77,12 @@ XrdOssArcZipFile::XrdOssArcZipFile(const char* path, int &rc)
 //
    zPath = strdup(path);
 
-// Convert open to archive open
+// Members are found via the archive's index and stored members are read
+// directly from the archive. Should the archive not be indexable, fallback
+// to using the zip library.
 //
-   if ((zFile = zip_fdopen(zFD, ZIP_CHECKCONS, &zrc)) == 0)
-      {rc = zip2syserr("fdopen", zrc);
-       close(zFD);
-       return;
-      }
+   if (!(zIndex = XrdOssArcZipIndex::Get(path, zFD, zFStat, rc)))
+      rc = zipOpen();
 }
   
 /******************************************************************************/
@@ -107,8 +105,9 @@ XrdOssArcZipFile::~XrdOssArcZipFile()
        zFile = 0;
       }
 
-// Free up any storage
+// Close our view of the archive and free up any storage
 //
+   if (zFD >= 0) close(zFD);
    if (zPath) free(zPath);
 }
 
@@ -130,6 +129,7 @@ int XrdOssArcZipFile::Close()
 // Remove all vestigaes of this subfile
 //
    if (zMember) {free(zMember); zMember = 0;}
+   zEnt = 0;
 
 // All done
 //
@@ -146,7 +146,7 @@ int XrdOssArcZipFile::Open(const char* member)
 
 // Make sure we have an open archive here
 //
-   if (zFile == 0) return -EBADF;
+   if (zFile == 0 && !zIndex) return -EBADF;
 
 // If an archive member is alreaddy open then close it
 //
@@ -161,6 +161,30 @@ int XrdOssArcZipFile::Open(const char* member)
 //
    if (zMember) free(zMember);
    zMember = strdup(member);
+   zEnt    = 0;
+
+// Lookup the member in the index. Stored members are read directly from the
+// archive, others must be inflated by the zip library. An index that does not
+// match the archive is discarded and the zip library used instead.
+//
+   if (zIndex)
+      {const XrdOssArcZipIndex::Entry* ent = zIndex->Find(zMember);
+       if (!ent) return -ENOENT;
+       if (ent->method == 0)
+          {if (Verify(ent))
+              {zEnt = ent;
+               zOffset = 0;
+               zEOF = false;
+               zCrcOff = 0;
+               zCrc    = crc32(0L, Z_NULL, 0);
+               zCrcBad = false;
+               return 0;
+              }
+           XrdOssArcZipIndex::Purge(zPath);
+           zIndex.reset();
+          }
+       if (!zFile && (rc = zipOpen())) return rc;
+      }
 
 // Open the archive member
 //
@@ -187,6 +211,22 @@ int XrdOssArcZipFile::Open(const char* member)
 
 ssize_t XrdOssArcZipFile::Read(void *buff, off_t offset, size_t blen)
 {
+// Stored members are read directly from the archive so reads may be done in
+// parallel. The only state kept is the running CRC of the member.
+//
+   if (zEnt)
+      {if (offset < 0) return -EINVAL;
+       if ((uint64_t)offset >= zEnt->size || !blen) return 0;
+       if (blen > zEnt->size - offset) blen = zEnt->size - offset;
+       ssize_t ret;
+       do {ret = pread(zFD, buff, blen, zEnt->dataOff + offset);}
+          while(ret < 0 && errno == EINTR);
+       if (ret < 0) return -errno;
+       if (!CrcCheck(buff, offset, ret))
+          return zip2syserr("read", ZIP_ER_CRC);
+       return ret;
+      }
+
 // Make sure this file is actually open
 //
    if (zSubFile == 0) return -EBADF;
@@ -228,12 +268,20 @@ int XrdOssArcZipFile::Stat(struct stat& buf)
 
 // Make sure this file is actually open
 //
-   if (zSubFile == 0) return -EBADF;
+   if (zSubFile == 0 && !zEnt) return -EBADF;
 
 // Iniialize the stat buffer
 //
   memcpy(&buf, &zFStat, sizeof(struct stat));
 
+// If the member was found via the index, use the index information
+//
+   if (zEnt)
+      {buf.st_ino  = zEnt->cdIndex;
+       buf.st_size = zEnt->size;
+       return 0;
+      }
+
 // Clear the stat structures
 //
    zip_stat_init(&zStat);
@@ -263,6 +311,21 @@ int XrdOssArcZipFile::Stat(const char* mName, struct stat& buf)
 //
   memcpy(&buf, &zFStat, sizeof(struct stat));
 
+// Use the index if we have one. The size of a compressed member is only known
+// to the zip library.
+//
+   if (zIndex)
+      {const XrdOssArcZipIndex::Entry* ent = zIndex->Find(mName);
+       if (!ent) return -ENOENT;
+       if (ent->method == 0)
+          {buf.st_ino  = ent->cdIndex;
+           buf.st_size = ent->size;
+           return 0;
+          }
+       int rc;
+       if (!zFile && (rc = zipOpen())) return rc;
+      }
+
 // Clear the stat structures
 //
    zip_stat_init(&zStat);
@@ -282,6 +345,86 @@ int XrdOssArcZipFile::Stat(const char* mName, struct stat& buf)
    return 0;
 }
 
+/******************************************************************************/
+/* Private:                     C r c C h e c k                               */
+/******************************************************************************/
+
+// Accumulate the CRC of a stored member as it is read. Like the zip library,
+// the CRC is only verified when the member is read sequentially from its start
+// to its end; reading past the data seen so far stops the check while rereads
+// are ignored. Once a mismatch is found all further reads fail.
+//
+bool XrdOssArcZipFile::CrcCheck(const void* buff, off_t offset, size_t blen)
+{
+   XrdSysMutexHelper cHelp(zCrcMutex);
+
+   if (zCrcBad) return false;
+   if (zCrcOff < 0 || offset > zCrcOff || offset + (off_t)blen <= zCrcOff)
+      {if (offset > zCrcOff) zCrcOff = -1;
+       return true;
+      }
+
+   size_t skip = zCrcOff - offset;
+   zCrc = crc32(zCrc, (const Bytef*)buff + skip, blen - skip);
+   zCrcOff = offset + blen;
+
+   if ((uint64_t)zCrcOff == zEnt->size && zCrc != zEnt->crc)
+      {zCrcBad = true;
+       return false;
+      }
+   return true;
+}
+
+/******************************************************************************/
+/* Private:                       V e r i f y                                 */
+/******************************************************************************/
+
+// Verify that the local header of a member is where the index says it is. This
+// catches an index that no longer describes the archive.
+//
+bool XrdOssArcZipFile::Verify(const XrdOssArcZipIndex::Entry* ent)
+{
+   char lfh[XrdZip::LFH::lfhBaseSize + 1024];
+   size_t hlen = XrdZip::LFH::lfhBaseSize + ent->nameLen;
+   ssize_t rlen;
+
+   if (hlen > sizeof(lfh)) hlen = sizeof(lfh);
+   do {rlen = pread(zFD, lfh, hlen, ent->lfhOff);}
+      while(rlen < 0 && errno == EINTR);
+
+   if (rlen == (ssize_t)hlen
+   &&  XrdZip::to<uint32_t>(lfh) == XrdZip::LFH::lfhSign
+   &&  XrdZip::to<uint16_t>(lfh + 26) == ent->nameLen
+   &&  !memcmp(lfh + XrdZip::LFH::lfhBaseSize, zIndex->Name(ent),
+               hlen - XrdZip::LFH::lfhBaseSize)
+   &&  ent->lfhOff + XrdZip::LFH::lfhBaseSize + ent->nameLen
+                   + XrdZip::to<uint16_t>(lfh + 28) == ent->dataOff) return true;
+
+   Elog.Emsg("ZipFile", "Index does not match archive", zPath);
+   return false;
+}
+
+/******************************************************************************/
+/* Private:                      z i p O p e n                                */
+/******************************************************************************/
+
+int XrdOssArcZipFile::zipOpen()
+{
+   int fd, zrc;
+
+// Attaching an FD to a zipfile "destroys" the FD so give it a copy.
+//
+   if ((fd = XrdSysFD_Dup(zFD)) < 0) return -errno;
+
+// Convert open to archive open
+//
+   if ((zFile = zip_fdopen(fd, ZIP_CHECKCONS, &zrc)) == 0)
+      {close(fd);
+       return zip2syserr("fdopen", zrc);
+      }
+   return 0;
+}
+
 /******************************************************************************/
 /*                               z i p E m s g                                */
 /******************************************************************************/
@@ -30,10 +30,14 @@
 /* specific prior written permission of the institution or contributor.       */
 /******************************************************************************/
 
+#include <memory>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 
-struct  stat;
+#include "XrdOssArc/XrdOssArcZipIndex.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
 struct  zip;
 typedef zip zip_t;
 struct  zip_file;
@@ -62,16 +66,27 @@ int     Stat(const char* mName, struct stat& buf);
 
 private:
 
+bool CrcCheck(const void* buff, off_t offset, size_t blen);
+bool Verify(const XrdOssArcZipIndex::Entry* ent);
+int  zipOpen();
 void zipEmsg(const char *what, zip_error_t* zerr);
 int  zip2syserr(const char *what, zip_error_t* zerr, bool msg=true);
 int  zip2syserr(const char *what, int zrc, bool msg=true);
 
+std::shared_ptr<XrdOssArcZipIndex> zIndex;
+const XrdOssArcZipIndex::Entry*    zEnt = 0;
+XrdSysMutex                        zCrcMutex;
+off_t                              zCrcOff = 0;
+uint32_t                           zCrc    = 0;
+bool                               zCrcBad = false;
+
 struct stat zFStat;
 char*       zPath     = 0;
 char*       zMember   = 0;
 zip_t*      zFile     = 0;
 zip_file_t* zSubFile  = 0;
 off_t       zOffset   = 0;
+int         zFD       = -1;
 bool        zSeek     = false;
 bool        zEOF      = false;
 };
@@ -0,0 +1,516 @@
+/******************************************************************************/
+/*                                                                            */
+/*                  X r d O s s A r c Z i p I n d e x . c c                   */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "XrdOssArc/XrdOssArcTrace.hh"
+#include "XrdOssArc/XrdOssArcZipIndex.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysFD.hh"
+#include "XrdSys/XrdSysPthread.hh"
+#include "XrdZip/XrdZipCDFH.hh"
+#include "XrdZip/XrdZipEOCD.hh"
+#include "XrdZip/XrdZipLFH.hh"
+#include "XrdZip/XrdZipZIP64EOCD.hh"
+#include "XrdZip/XrdZipZIP64EOCDL.hh"
+
+using namespace XrdZip;
+
+/******************************************************************************/
+/*                        G l o b a l   O b j e c t s                         */
+/******************************************************************************/
+
+namespace XrdOssArcGlobals
+{
+extern XrdSysError     Elog;
+}
+using namespace XrdOssArcGlobals;
+
+/******************************************************************************/
+/*                        L o c a l   O b j e c t s                           */
+/******************************************************************************/
+
+namespace
+{
+const char idxMagic[8] = {'X','r','d','Z','I','d','x','1'};
+
+// Indexes are cached by archive path. An entry is only used if the archive
+// still has the same identity; the least recently used entry is dropped when
+// the cache is full.
+//
+struct CacheEnt
+      {std::shared_ptr<XrdOssArcZipIndex> index;
+       dev_t     dev;
+       ino_t     ino;
+       off_t     size;
+       time_t    mtime;
+       long long lastUse;
+      };
+
+const size_t                    cacheMax = 128;
+XrdSysMutex                     cacheMutex;
+std::map<std::string, CacheEnt> idxCache;
+long long                       useCount = 0;
+
+int pReadAll(int fd, char* buff, size_t blen, off_t offs)
+{
+   ssize_t rlen;
+
+   while(blen)
+        {if ((rlen = pread(fd, buff, blen, offs)) <= 0)
+            {if (rlen < 0 && errno == EINTR) continue;
+             return (rlen < 0 ? -errno : -ENODATA);
+            }
+         buff += rlen; blen -= rlen; offs += rlen;
+        }
+   return 0;
+}
+
+int nameCmp(const char* n1, size_t l1, const char* n2, size_t l2)
+{
+   int rc = memcmp(n1, n2, std::min(l1, l2));
+   if (rc) return rc;
+   return (l1 < l2 ? -1 : (l1 > l2 ? 1 : 0));
+}
+}
+
+/******************************************************************************/
+/*                            D e s t r u c t o r                             */
+/******************************************************************************/
+
+XrdOssArcZipIndex::~XrdOssArcZipIndex()
+{
+   if (idxMapped && idxBase) munmap((void*)idxBase, idxLen);
+}
+
+/******************************************************************************/
+/*                                 C o u n t                                  */
+/******************************************************************************/
+
+uint32_t XrdOssArcZipIndex::Count() const {return idxHdr->count;}
+
+/******************************************************************************/
+/*                                  F i n d                                   */
+/******************************************************************************/
+
+const XrdOssArcZipIndex::Entry* XrdOssArcZipIndex::Find(const char* name) const
+{
+   size_t nlen = strlen(name);
+   const Entry* ent = std::lower_bound(idxEnts, idxEnts + idxHdr->count, name,
+                      [this, nlen](const Entry& e, const char* n)
+                        {return nameCmp(idxNames + e.nameOff, e.nameLen,
+                                        n, nlen) < 0;});
+
+   if (ent == idxEnts + idxHdr->count
+   ||  nameCmp(idxNames + ent->nameOff, ent->nameLen, name, nlen)) return 0;
+   return ent;
+}
+
+/******************************************************************************/
+/*                                   G e t                                    */
+/******************************************************************************/
+
+std::shared_ptr<XrdOssArcZipIndex>
+XrdOssArcZipIndex::Get(const char* arcPath, int arcFD,
+                       const struct stat& arcStat, int& rc)
+{
+   TraceInfo("ZipIndex",0);
+   std::shared_ptr<XrdOssArcZipIndex> index;
+   std::string idxPath(arcPath);
+
+// Check if we already have an index for this archive
+//
+   cacheMutex.Lock();
+   auto it = idxCache.find(idxPath);
+   if (it != idxCache.end())
+      {CacheEnt& ce = it->second;
+       if (ce.dev == arcStat.st_dev && ce.ino   == arcStat.st_ino
+       &&  ce.size == arcStat.st_size && ce.mtime == arcStat.st_mtime)
+          {ce.lastUse = ++useCount;
+           index = ce.index;
+           cacheMutex.UnLock();
+           rc = 0;
+           return index;
+          }
+       idxCache.erase(it);
+      }
+   cacheMutex.UnLock();
+
+// Try to map the persisted index. Failing that, build one from the archive's
+// central directory. We do not persist the built index as the archive may
+// reside in a tape buffer where we should not be creating files.
+//
+   index.reset(new XrdOssArcZipIndex);
+   idxPath.append(".idx");
+   if ((rc = index->Load(idxPath, arcStat.st_size)))
+      {std::vector<Member> members;
+       std::string eText;
+       DEBUG("Building index for "<<arcPath<<"; "<<idxPath<<' '
+             <<(rc == -ENOENT ? "not found" : "unusable"));
+       if ((rc = Scan(arcFD, arcStat.st_size, members, eText)))
+          {Elog.Emsg("ZipIndex", rc, eText.c_str(), arcPath);
+           return std::shared_ptr<XrdOssArcZipIndex>();
+          }
+       Encode(members, arcStat.st_size, index->idxImage);
+       index->Setup(index->idxImage.data(), index->idxImage.size(),
+                    arcStat.st_size);
+      }
+
+// Add the index to the cache, making room if need be. Should another thread
+// have beaten us to it, use its index.
+//
+   std::string arcKey(arcPath);
+   XrdSysMutexHelper cHelp(cacheMutex);
+   it = idxCache.find(arcKey);
+   if (it != idxCache.end() && it->second.ino == arcStat.st_ino
+   &&  it->second.dev == arcStat.st_dev)
+      {it->second.lastUse = ++useCount;
+       return it->second.index;
+      }
+   if (it == idxCache.end() && idxCache.size() >= cacheMax)
+      {auto lru = idxCache.begin();
+       for (auto cit = idxCache.begin(); cit != idxCache.end(); ++cit)
+           if (cit->second.lastUse < lru->second.lastUse) lru = cit;
+       idxCache.erase(lru);
+      }
+   idxCache[arcKey] = {index, arcStat.st_dev, arcStat.st_ino, arcStat.st_size,
+                       arcStat.st_mtime, ++useCount};
+   return index;
+}
+
+/******************************************************************************/
+/*                                  N a m e                                   */
+/******************************************************************************/
+
+const char* XrdOssArcZipIndex::Name(const Entry* ent) const
+{
+   return idxNames + ent->nameOff;
+}
+
+/******************************************************************************/
+/*                                 P u r g e                                  */
+/******************************************************************************/
+
+void XrdOssArcZipIndex::Purge(const char* arcPath)
+{
+   XrdSysMutexHelper cHelp(cacheMutex);
+   idxCache.erase(arcPath);
+}
+
+/******************************************************************************/
+/*                                  S a v e                                   */
+/******************************************************************************/
+
+int XrdOssArcZipIndex::Save(const char* arcPath, off_t arcSize,
+                            std::vector<Member>& members, std::string& eText)
+{
+   std::string idxPath(arcPath), tmpPath;
+   std::vector<char> image;
+   int fd, rc = 0;
+
+// Encode the index
+//
+   if (members.size() > UINT32_MAX)
+      {eText = "index more than 4G members";
+       return -EOVERFLOW;
+      }
+   Encode(members, arcSize, image);
+
+// Write the index under a temporary name and rename it when complete
+//
+   idxPath.append(".idx");
+   tmpPath = idxPath + ".part";
+   if ((fd = XrdSysFD_Open(tmpPath.c_str(), O_WRONLY|O_CREAT|O_TRUNC,
+                           S_IRUSR|S_IRGRP|S_IROTH)) < 0)
+      {rc = -errno;
+       eText = "create " + tmpPath;
+       return rc;
+      }
+
+   const char* bP = image.data();
+   size_t left = image.size();
+   while(left)
+        {ssize_t wlen = write(fd, bP, left);
+         if (wlen < 0)
+            {if (errno == EINTR) continue;
+             rc = -errno;
+             break;
+            }
+         bP += wlen; left -= wlen;
+        }
+   if (rc) eText = "write " + tmpPath;
+   if (close(fd) && !rc) {rc = -errno; eText = "close " + tmpPath;}
+   if (!rc && rename(tmpPath.c_str(), idxPath.c_str()))
+      {rc = -errno; eText = "rename " + tmpPath;}
+   if (rc) {unlink(tmpPath.c_str()); unlink(idxPath.c_str());}
+   return rc;
+}
+
+/******************************************************************************/
+/* Private:                       E n c o d e                                 */
+/******************************************************************************/
+
+void XrdOssArcZipIndex::Encode(std::vector<Member>& members, off_t arcSize,
+                               std::vector<char>& image)
+{
+   Header hdr;
+   size_t namesLen = 0, eOff;
+
+// Order the members by name. Should a name appear more than once, the first
+// occurrence is the one that will be found.
+//
+   std::stable_sort(members.begin(), members.end(),
+                    [](const Member& a, const Member& b)
+                      {return a.name < b.name;});
+
+// Construct the header
+//
+   for (auto& m : members) namesLen += m.name.size();
+   memcpy(hdr.magic, idxMagic, sizeof(hdr.magic));
+   hdr.hdrSize  = sizeof(Header);
+   hdr.count    = members.size();
+   hdr.arcSize  = arcSize;
+   hdr.namesOff = sizeof(Header) + members.size() * sizeof(Entry);
+   hdr.namesLen = namesLen;
+
+// Lay out the header, the entries, and the name table
+//
+   image.assign(hdr.namesOff + namesLen, 0);
+   memcpy(image.data(), &hdr, sizeof(hdr));
+   eOff = sizeof(Header);
+   namesLen = 0;
+   for (auto& m : members)
+       {Entry ent;
+        ent.lfhOff  = m.lfhOff;
+        ent.dataOff = m.dataOff;
+        ent.size    = m.size;
+        ent.crc     = m.crc;
+        ent.nameOff = namesLen;
+        ent.nameLen = m.name.size();
+        ent.method  = m.method;
+        ent.cdIndex = m.cdIndex;
+        memcpy(image.data() + eOff, &ent, sizeof(ent));
+        memcpy(image.data() + hdr.namesOff + namesLen, m.name.data(),
+               m.name.size());
+        eOff     += sizeof(ent);
+        namesLen += m.name.size();
+       }
+}
+
+/******************************************************************************/
+/* Private:                         L o a d                                   */
+/******************************************************************************/
+
+int XrdOssArcZipIndex::Load(const std::string& idxPath, off_t arcSize)
+{
+   struct stat Stat;
+   void* mP;
+   int fd, rc;
+
+// Open the index and map it
+//
+   if ((fd = XrdSysFD_Open(idxPath.c_str(), O_RDONLY)) < 0) return -errno;
+   if (fstat(fd, &Stat))
+      {rc = -errno;
+       close(fd);
+       return rc;
+      }
+   if (Stat.st_size < (off_t)sizeof(Header))
+      {close(fd);
+       return -EINVAL;
+      }
+   mP = mmap(0, Stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   rc = (mP == MAP_FAILED ? -errno : 0);
+   close(fd);
+   if (rc) return rc;
+
+// Validate the index against the archive
+//
+   if (!Setup((const char*)mP, Stat.st_size, arcSize))
+      {munmap(mP, Stat.st_size);
+       Elog.Emsg("ZipIndex", "Ignoring invalid or stale index", idxPath.c_str());
+       return -EINVAL;
+      }
+   idxMapped = true;
+   return 0;
+}
+
+/******************************************************************************/
+/* Private:                         S c a n                                   */
+/******************************************************************************/
+
+// Construct the member list from the central directory of the archive. Every
+// member's local header is read as its extra field need not match the one in
+// the central directory.
+//
+int XrdOssArcZipIndex::Scan(int arcFD, off_t arcSize,
+                            std::vector<Member>& members, std::string& eText)
+{
+   uint64_t cdOff, cdSize, cdCnt;
+   off_t tailOff;
+   int rc;
+
+// Find the end of central directory record; it is near the end of the file
+//
+   size_t tailLen = std::min<off_t>(arcSize, EOCD::eocdBaseSize
+                                           + EOCD::maxCommentLength);
+   std::vector<char> tail(tailLen);
+   tailOff = arcSize - tailLen;
+   if ((rc = pReadAll(arcFD, tail.data(), tailLen, tailOff)))
+      {eText = "read end of";
+       return rc;
+      }
+   const char* eP = EOCD::Find(tail.data(), tailLen);
+   if (!eP)
+      {eText = "find end of central directory in";
+       return -ENOEXEC;
+      }
+
+   try {EOCD eocd(eP, tail.data() + tailLen - eP);
+        off_t eocdOff = tailOff + (eP - tail.data());
+        cdOff  = eocd.cdOffset;
+        cdSize = eocd.cdSize;
+        cdCnt  = eocd.nbCdRec;
+
+    // Large archives have their central directory described by the zip64 end
+    // of central directory record which is found via its locator.
+    //
+        char zBuff[ZIP64_EOCD::zip64EocdBaseSize];
+        if (eocdOff >= ZIP64_EOCDL::zip64EocdlSize
+        && !pReadAll(arcFD, zBuff, ZIP64_EOCDL::zip64EocdlSize,
+                     eocdOff - ZIP64_EOCDL::zip64EocdlSize)
+        &&  to<uint32_t>(zBuff) == ZIP64_EOCDL::zip64EocdlSign)
+           {ZIP64_EOCDL eocdl(zBuff);
+            if ((rc = pReadAll(arcFD, zBuff, sizeof(zBuff),
+                               eocdl.zip64EocdOffset))
+            ||  to<uint32_t>(zBuff) != ZIP64_EOCD::zip64EocdSign)
+               {eText = "read zip64 end of central directory in";
+                return (rc ? rc : -ENOEXEC);
+               }
+            ZIP64_EOCD eocd64(zBuff);
+            cdOff  = eocd64.cdOffset;
+            cdSize = eocd64.cdSize;
+            cdCnt  = eocd64.nbCdRec;
+           }
+       } catch(const bad_data&)
+              {eText = "parse end of central directory in";
+               return -ENOEXEC;
+              }
+
+   if (cdOff + cdSize > (uint64_t)arcSize || cdCnt > UINT32_MAX)
+      {eText = "parse central directory in";
+       return -ENOEXEC;
+      }
+
+// Read the central directory
+//
+   std::vector<char> cdBuff(cdSize);
+   if ((rc = pReadAll(arcFD, cdBuff.data(), cdSize, cdOff)))
+      {eText = "read central directory in";
+       return rc;
+      }
+
+// Record each member
+//
+   members.clear();
+   members.reserve(cdCnt);
+   const char* cP = cdBuff.data();
+   uint64_t left = cdSize;
+   char lfhBuff[LFH::lfhBaseSize];
+
+   try {for (uint32_t i = 0; i < cdCnt; i++)
+            {if (left < CDFH::cdfhBaseSize
+             ||  to<uint32_t>(cP) != CDFH::cdfhSign) throw bad_data();
+             CDFH cdfh(cP, std::min<uint64_t>(left, UINT32_MAX));
+             cP += cdfh.cdfhSize; left -= cdfh.cdfhSize;
+
+             Member m;
+             m.name    = cdfh.filename;
+             m.crc     = cdfh.ZCRC32;
+             m.method  = cdfh.compressionMethod;
+             m.cdIndex = i;
+             m.size    = cdfh.compressedSize;
+             m.lfhOff  = cdfh.offset;
+             if (m.size == ovrflw<uint32_t>::value
+             ||  cdfh.offset == ovrflw<uint32_t>::value)
+                {if (!cdfh.extra) throw bad_data();
+                 if (m.size == ovrflw<uint32_t>::value)
+                    m.size = cdfh.extra->compressedSize;
+                 m.lfhOff = CDFH::GetOffset(cdfh);
+                }
+
+             if ((rc = pReadAll(arcFD, lfhBuff, sizeof(lfhBuff), m.lfhOff))
+             ||  to<uint32_t>(lfhBuff) != LFH::lfhSign)
+                {eText = "read local header for " + m.name + " in";
+                 return (rc ? rc : -ENOEXEC);
+                }
+             m.dataOff = m.lfhOff + LFH::lfhBaseSize
+                       + to<uint16_t>(lfhBuff + 26) + to<uint16_t>(lfhBuff + 28);
+             if (m.dataOff + m.size > arcSize) throw bad_data();
+             members.push_back(std::move(m));
+            }
+       } catch(const bad_data&)
+              {eText = "parse central directory in";
+               return -ENOEXEC;
+              }
+
+   return 0;
+}
+
+/******************************************************************************/
+/* Private:                        S e t u p                                  */
+/******************************************************************************/
+
+bool XrdOssArcZipIndex::Setup(const char* base, size_t blen, off_t arcSize)
+{
+   const Header* hdr = (const Header*)base;
+
+// Verify that the index is ours, is complete, and describes this archive
+//
+   if (blen < sizeof(Header) || memcmp(hdr->magic, idxMagic, sizeof(idxMagic))
+   ||  hdr->hdrSize != sizeof(Header) || hdr->arcSize != (uint64_t)arcSize
+   ||  hdr->namesOff != sizeof(Header) + (uint64_t)hdr->count * sizeof(Entry)
+   ||  hdr->namesOff + hdr->namesLen != blen) return false;
+
+   const Entry* ent = (const Entry*)(base + sizeof(Header));
+   for (uint32_t i = 0; i < hdr->count; i++, ent++)
+       if ((uint64_t)ent->nameOff + ent->nameLen > hdr->namesLen
+       ||  ent->dataOff + ent->size > (uint64_t)arcSize) return false;
+
+   idxBase  = base;
+   idxLen   = blen;
+   idxHdr   = hdr;
+   idxEnts  = (const Entry*)(base + sizeof(Header));
+   idxNames = base + hdr->namesOff;
+   return true;
+}
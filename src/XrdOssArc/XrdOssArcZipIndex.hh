@@ -0,0 +1,137 @@
+#ifndef _XRDOSSARCZIPINDEX_H
+#define _XRDOSSARCZIPINDEX_H
+/******************************************************************************/
+/*                                                                            */
+/*                  X r d O s s A r c Z i p I n d e x . h h                   */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+struct stat;
+
+// XrdOssArcZipIndex is a sorted index of the members of a stored zip archive.
+// It records, by member name, where the member's local header and data reside
+// along with its size and CRC so that a member can be found by binary search
+// and read directly from the archive file without walking the central
+// directory. The index is persisted as "<archive>.idx" when the archive is
+// composed and is memory mapped when used. Should an archive not have an
+// index (e.g. it was created by the archiver script) one is built from the
+// central directory upon first use and kept in memory. Indexes are shared by
+// all opens of the same archive.
+//
+class XrdOssArcZipIndex
+{
+public:
+
+// The index entry for a member. All offsets are relative to the start of the
+// archive; nameOff is relative to the start of the name table.
+//
+struct Entry
+      {uint64_t lfhOff;      // Offset of the local file header
+       uint64_t dataOff;     // Offset of the member data
+       uint64_t size;        // Size of the member data (i.e. compressed)
+       uint32_t crc;         // CRC32 of the uncompressed member
+       uint32_t nameOff;     // Offset of the name in the name table
+       uint16_t nameLen;     // Length of the name
+       uint16_t method;      // Compression method (0 -> stored)
+       uint32_t cdIndex;     // Position of the member in the archive
+      };
+
+// Information used to create an index.
+//
+struct Member
+      {std::string name;
+       off_t       lfhOff;
+       off_t       dataOff;
+       off_t       size;
+       uint32_t    crc;
+       uint16_t    method;
+       uint32_t    cdIndex;
+      };
+
+// Return the number of members in the index.
+//
+uint32_t           Count() const;
+
+// Find a member by name. Returns the entry or nil if the member does not exist.
+//
+const Entry*       Find(const char* name) const;
+
+// Return the shared index of the archive opened as arcFD whose attributes are
+// in arcStat. The index is mapped or built as needed. Upon failure, nil is
+// returned with rc holding -errno.
+//
+static std::shared_ptr<XrdOssArcZipIndex>
+                   Get(const char* arcPath, int arcFD,
+                       const struct stat& arcStat, int& rc);
+
+// Return the name of an entry; it is not null terminated.
+//
+const char*        Name(const Entry* ent) const;
+
+// Remove the cached index for arcPath (e.g. it is found to be stale).
+//
+static void        Purge(const char* arcPath);
+
+// Write the index of the arcSize byte archive arcPath to "<arcPath>.idx". The
+// members vector is sorted by name. Returns 0 upon success and -errno upon
+// failure with eText describing what failed.
+//
+static int         Save(const char* arcPath, off_t arcSize,
+                        std::vector<Member>& members, std::string& eText);
+
+                   XrdOssArcZipIndex() {}
+                  ~XrdOssArcZipIndex();
+
+private:
+
+struct Header
+      {char     magic[8];    // "XrdZIdx" plus version
+       uint32_t hdrSize;     // Size of this header
+       uint32_t count;       // Number of entries
+       uint64_t arcSize;     // Size of the indexed archive
+       uint64_t namesOff;    // Offset of the name table
+       uint64_t namesLen;    // Size of the name table
+      };
+
+static void Encode(std::vector<Member>& members, off_t arcSize,
+                   std::vector<char>& image);
+       int  Load(const std::string& idxPath, off_t arcSize);
+static int  Scan(int arcFD, off_t arcSize, std::vector<Member>& members,
+                 std::string& eText);
+       bool Setup(const char* base, size_t blen, off_t arcSize);
+
+std::vector<char>  idxImage;
+const char*        idxBase  = 0;
+size_t             idxLen   = 0;
+const Header*      idxHdr   = 0;
+const Entry*       idxEnts  = 0;
+const char*        idxNames = 0;
+bool               idxMapped = false;
+};
+#endif
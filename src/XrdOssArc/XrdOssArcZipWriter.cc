@@ -0,0 +1,414 @@
+/******************************************************************************/
+/*                                                                            */
+/*                 X r d O s s A r c Z i p W r i t e r . c c                  */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#include "XrdOssArc/XrdOssArcZipIndex.hh"
+#include "XrdOssArc/XrdOssArcZipWriter.hh"
+#include "XrdSys/XrdSysFD.hh"
+#include "XrdZip/XrdZipCDFH.hh"
+#include "XrdZip/XrdZipEOCD.hh"
+#include "XrdZip/XrdZipLFH.hh"
+#include "XrdZip/XrdZipZIP64EOCD.hh"
+#include "XrdZip/XrdZipZIP64EOCDL.hh"
+
+using namespace XrdZip;
+
+/******************************************************************************/
+/*                        L o c a l   F u n c t i o n s                       */
+/******************************************************************************/
+
+namespace
+{
+int pWriteAll(int fd, const char* buff, size_t blen, off_t offs)
+{
+   ssize_t wlen;
+
+   while(blen)
+        {if ((wlen = pwrite(fd, buff, blen, offs)) < 0)
+            {if (errno == EINTR) continue;
+             return -errno;
+            }
+         buff += wlen; blen -= wlen; offs += wlen;
+        }
+   return 0;
+}
+}
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdOssArcZipWriter::XrdOssArcZipWriter(int readers, int bufsz)
+                   : arcEnd(0), nextWin(0), numWins(0), arcFD(-1), errRC(0),
+                     numReaders(readers < 1 ? 1 : readers),
+                     winSize(bufsz < 65536 ? 65536 : bufsz) {}
+
+/******************************************************************************/
+/*                            D e s t r u c t o r                             */
+/******************************************************************************/
+
+XrdOssArcZipWriter::~XrdOssArcZipWriter() {}
+
+/******************************************************************************/
+/*                                 B u i l d                                  */
+/******************************************************************************/
+
+int XrdOssArcZipWriter::Build(const char* srcDir, const char* arcPath,
+                              Stats& stats, std::string& eText)
+{
+   auto tBeg = std::chrono::steady_clock::now();
+   std::string tmpPath(arcPath);
+   off_t arcOff = 0;
+   int rc;
+
+// Collect all of the members in name order
+//
+   srcRoot = srcDir;
+   while(srcRoot.size() > 1 && srcRoot.back() == '/') srcRoot.pop_back();
+   members.clear();
+   errRC = 0; errText.clear();
+   if ((rc = Scan(srcRoot, "")))
+      {eText = errText;
+       return rc;
+      }
+   std::sort(members.begin(), members.end(),
+             [](const Member& a, const Member& b) {return a.name < b.name;});
+
+// Lay out the archive. Since members are stored, every local header and its
+// data can be placed now; the CRC is filled in once the data has been read.
+//
+   for (auto& m : members)
+       {m.lfhOff  = arcOff;
+        m.dataOff = arcOff + m.hdr.size();
+        arcOff    = m.dataOff + m.size;
+       }
+   arcEnd  = arcOff;
+   numWins = (arcEnd + winSize - 1) / winSize;
+   nextWin = 0;
+
+// Create the archive under a temporary name
+//
+   tmpPath.append(".part");
+   if ((arcFD = XrdSysFD_Open(tmpPath.c_str(), O_WRONLY|O_CREAT|O_TRUNC,
+                              S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH)) < 0)
+      {rc = -errno;
+       eText = "create " + tmpPath;
+       return rc;
+      }
+
+// Start the readers; this thread is one of them
+//
+   int nThreads = (numWins < numReaders ? (int)numWins : numReaders);
+   std::vector<pthread_t> tids;
+   for (int i = 1; i < nThreads; i++)
+       {pthread_t tid;
+        if (XrdSysThread::Run(&tid, Reader, (void*)this, XRDSYSTHREAD_HOLD,
+                              "arc composer")) break;
+        tids.push_back(tid);
+       }
+   ReadWindows();
+   for (auto tid : tids) XrdSysThread::Join(tid, 0);
+
+// Complete the archive
+//
+   if (!(rc = errRC) && !(rc = Finish(arcFD, arcEnd)))
+      {if (fchmod(arcFD, S_IRUSR|S_IRGRP|S_IROTH))
+          {rc = -errno; errText = "make r/o " + tmpPath;}
+      }
+   if (close(arcFD) && !rc) {rc = -errno; errText = "close " + tmpPath;}
+   arcFD = -1;
+   if (!rc && rename(tmpPath.c_str(), arcPath))
+      {rc = -errno; errText = "rename " + tmpPath;}
+
+// Check for errors
+//
+   if (rc)
+      {unlink(tmpPath.c_str());
+       eText = errText;
+       return rc;
+      }
+
+// Persist the member index of the archive. The archive is usable without it
+// so a failure is only reported.
+//
+   struct stat Stat;
+   if (stat(arcPath, &Stat)) Stat.st_size = arcEnd;
+   std::vector<XrdOssArcZipIndex::Member> idxVec;
+   idxVec.reserve(members.size());
+   for (size_t i = 0; i < members.size(); i++)
+       {Member& m = members[i];
+        idxVec.push_back({m.name, m.lfhOff, m.dataOff, m.size,
+                          m.lfh->ZCRC32, 0, (uint32_t)i});
+       }
+   stats.idxRC = XrdOssArcZipIndex::Save(arcPath, Stat.st_size, idxVec, eText);
+
+// Return the statistics
+//
+   stats.numFiles = members.size();
+   stats.numBytes = 0;
+   for (auto& m : members) stats.numBytes += m.size;
+   stats.arcBytes = Stat.st_size;
+   stats.elapsed  = std::chrono::duration<double>
+                       (std::chrono::steady_clock::now() - tBeg).count();
+   members.clear();
+   return 0;
+}
+
+/******************************************************************************/
+/* Private:                         F i l l                                   */
+/******************************************************************************/
+
+// Fill the window [wBeg, wEnd) of the archive with the header bytes and the
+// member data that fall into it, recording the CRC of each member piece.
+//
+int XrdOssArcZipWriter::Fill(char* wBuff, off_t wBeg, off_t wEnd,
+                             std::string& eText)
+{
+   auto mIt = std::upper_bound(members.begin(), members.end(), wBeg,
+                               [](off_t off, const Member& m)
+                                 {return off < m.dataOff + m.size;});
+
+   for (; mIt != members.end() && mIt->lfhOff < wEnd; ++mIt)
+       {Member& m = *mIt;
+        off_t oBeg, oEnd;
+
+    // Copy whatever portion of the local header is in the window
+    //
+        oBeg = std::max(wBeg, m.lfhOff);
+        oEnd = std::min(wEnd, m.dataOff);
+        if (oBeg < oEnd)
+           memcpy(wBuff + (oBeg - wBeg), m.hdr.data() + (oBeg - m.lfhOff),
+                  oEnd - oBeg);
+
+    // Read whatever portion of the data is in the window
+    //
+        oBeg = std::max(wBeg, m.dataOff);
+        oEnd = std::min(wEnd, m.dataOff + m.size);
+        if (oBeg >= oEnd) continue;
+
+        std::string path = srcRoot + '/' + m.name;
+        char*  bP   = wBuff + (oBeg - wBeg);
+        off_t  mOff = oBeg - m.dataOff;
+        size_t left = oEnd - oBeg;
+        ssize_t rlen;
+        int fd;
+
+        if ((fd = XrdSysFD_Open(path.c_str(), O_RDONLY)) < 0)
+           {int rc = -errno;
+            eText = "open " + path;
+            return rc;
+           }
+        posix_fadvise(fd, mOff, left, POSIX_FADV_SEQUENTIAL);
+        while(left)
+             {if ((rlen = pread(fd, bP, left, mOff)) <= 0)
+                 {if (rlen < 0 && errno == EINTR) continue;
+                  int rc = (rlen < 0 ? -errno : -ENODATA);
+                  close(fd);
+                  eText = "read " + path;
+                  return rc;
+                 }
+              bP += rlen; mOff += rlen; left -= rlen;
+             }
+        close(fd);
+
+        uint32_t crc = crc32(0L, (const Bytef*)wBuff + (oBeg - wBeg),
+                             oEnd - oBeg);
+        XrdSysMutexHelper mHelp(pMutex);
+        m.pieces.push_back({oBeg - m.dataOff, (size_t)(oEnd - oBeg), crc});
+       }
+   return 0;
+}
+
+/******************************************************************************/
+/* Private:                       F i n i s h                                 */
+/******************************************************************************/
+
+// Combine the piece CRCs, patch the local headers, and append the central
+// directory.
+//
+int XrdOssArcZipWriter::Finish(int fd, off_t cdOff)
+{
+   std::vector<std::unique_ptr<CDFH>> cdvec;
+   buffer_t cdBuff;
+   int rc;
+
+   cdvec.reserve(members.size());
+   for (auto& m : members)
+       {uLong crc = crc32(0L, Z_NULL, 0);
+        off_t done = 0;
+
+        std::sort(m.pieces.begin(), m.pieces.end(),
+                  [](const Piece& a, const Piece& b)
+                    {return a.offset < b.offset;});
+        for (auto& p : m.pieces)
+            {if (p.offset != done) break;
+             crc = crc32_combine(crc, p.crc, p.length);
+             done += p.length;
+            }
+        if (done != m.size)
+           {errText = "completely read " + m.name;
+            return -EIO;
+           }
+
+        m.lfh->ZCRC32 = crc;
+        m.hdr.clear();
+        m.lfh->Serialize(m.hdr);
+        if ((rc = pWriteAll(fd, m.hdr.data(), m.hdr.size(), m.lfhOff)))
+           {errText = "update header for " + m.name;
+            return rc;
+           }
+        cdvec.emplace_back(new CDFH(m.lfh.get(), m.mode, m.lfhOff));
+       }
+
+// Serialize the central directory followed by the end records. We force the
+// zip64 records if there are too many members for the classic record.
+//
+   uint32_t cdSize = 0;
+   for (auto& cdfh : cdvec) cdSize += cdfh->cdfhSize;
+   EOCD eocd(cdOff, cdvec.size(), cdSize);
+   if (cdvec.size() >= ovrflw<uint16_t>::value) eocd.useZip64 = true;
+
+   cdBuff.reserve(cdSize + 256);
+   for (auto& cdfh : cdvec) cdfh->Serialize(cdBuff);
+   if (eocd.useZip64)
+      {ZIP64_EOCD  zip64eocd(cdOff, cdvec.size(), cdSize);
+       ZIP64_EOCDL zip64eocdl(eocd, zip64eocd);
+       zip64eocd.Serialize(cdBuff);
+       zip64eocdl.Serialize(cdBuff);
+      }
+   eocd.Serialize(cdBuff);
+
+   if ((rc = pWriteAll(fd, cdBuff.data(), cdBuff.size(), cdOff)))
+      errText = "write central directory";
+   return rc;
+}
+
+/******************************************************************************/
+/* Private:                       R e a d e r                                 */
+/******************************************************************************/
+
+void* XrdOssArcZipWriter::Reader(void* parg)
+{
+   static_cast<XrdOssArcZipWriter*>(parg)->ReadWindows();
+   return 0;
+}
+
+/******************************************************************************/
+/* Private:                  R e a d W i n d o w s                            */
+/******************************************************************************/
+
+void XrdOssArcZipWriter::ReadWindows()
+{
+   std::string eText;
+   void* wBuff;
+   long long wNum;
+   int rc;
+
+// Get an aligned window buffer
+//
+   if ((rc = posix_memalign(&wBuff, 4096, winSize)))
+      {XrdSysMutexHelper mHelp(pMutex);
+       if (!errRC) {errRC = -rc; errText = "allocate window buffer";}
+       return;
+      }
+
+// Assemble and write windows until there are none left or someone failed
+//
+   while(true)
+        {pMutex.Lock();
+         if (errRC || nextWin >= numWins) {pMutex.UnLock(); break;}
+         wNum = nextWin++;
+         pMutex.UnLock();
+
+         off_t wBeg = wNum * winSize;
+         off_t wEnd = std::min(wBeg + (off_t)winSize, arcEnd);
+         if (!(rc = Fill((char*)wBuff, wBeg, wEnd, eText))
+         &&  (rc = pWriteAll(arcFD, (char*)wBuff, wEnd - wBeg, wBeg)))
+            eText = "write archive window";
+         if (rc)
+            {XrdSysMutexHelper mHelp(pMutex);
+             if (!errRC) {errRC = rc; errText = eText;}
+             break;
+            }
+        }
+
+   free(wBuff);
+}
+
+/******************************************************************************/
+/* Private:                         S c a n                                   */
+/******************************************************************************/
+
+int XrdOssArcZipWriter::Scan(const std::string& dir, const std::string& pfx)
+{
+   struct dirent* dP;
+   struct stat Stat;
+   DIR* dirP;
+   int rc = 0;
+
+   if (!(dirP = opendir(dir.c_str())))
+      {rc = -errno;
+       errText = "open directory " + dir;
+       return rc;
+      }
+
+   while((dP = readdir(dirP)))
+        {if (!strcmp(dP->d_name, ".") || !strcmp(dP->d_name, "..")) continue;
+         std::string path = dir + '/' + dP->d_name;
+         std::string name = pfx + dP->d_name;
+         if (stat(path.c_str(), &Stat))
+            {rc = -errno;
+             errText = "stat " + path;
+             break;
+            }
+         if (S_ISDIR(Stat.st_mode))
+            {if ((rc = Scan(path, name + '/'))) break;
+             continue;
+            }
+         if (!S_ISREG(Stat.st_mode)) continue;
+
+         Member m;
+         m.name = name;
+         m.size = Stat.st_size;
+         m.mode = Stat.st_mode;
+         m.lfh.reset(new LFH(name, 0, Stat.st_size, Stat.st_mtime));
+         m.lfh->Serialize(m.hdr);
+         members.push_back(std::move(m));
+        }
+
+   closedir(dirP);
+   return rc;
+}
@@ -0,0 +1,105 @@
+#ifndef _XRDOSSARCZIPWRITER_H
+#define _XRDOSSARCZIPWRITER_H
+/******************************************************************************/
+/*                                                                            */
+/*                 X r d O s s A r c Z i p W r i t e r . h h                  */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+namespace XrdZip {struct LFH;}
+
+// XrdOssArcZipWriter builds a stored (i.e. uncompressed) zip archive of all
+// of the files in a directory tree, equivalent to "zip -r -0". Since nothing
+// is compressed the position of every header and member in the archive is
+// known once the tree has been scanned. The archive is then cut into fixed
+// size, aligned windows that are assembled concurrently by reader threads:
+// each reader fills a window from the headers and member data falling into
+// it, computes the CRC32 of every member piece, and writes the window with a
+// single aligned write. Once all windows are written, the piece CRCs are
+// combined into the member CRCs, the local headers are patched, and the
+// central directory is appended.
+//
+class XrdOssArcZipWriter
+{
+public:
+
+struct Stats
+      {long long numBytes;   // Bytes of member data
+       long long arcBytes;   // Size of the archive
+       int       numFiles;   // Number of members
+       double    elapsed;    // Seconds to build the archive
+       int       idxRC;      // Result of writing the archive index
+      };
+
+// Build the archive arcPath from the files under srcDir, naming members by
+// their path relative to srcDir. The archive is first written to a
+// temporary file that is renamed upon success. Returns 0 upon success and
+// -errno upon failure with eText describing what failed. The archive's index
+// is written to "<arcPath>.idx"; should that fail, stats.idxRC holds -errno
+// and eText describes the failure.
+//
+int  Build(const char* srcDir, const char* arcPath, Stats& stats,
+           std::string& eText);
+
+     XrdOssArcZipWriter(int readers, int bufsz);
+    ~XrdOssArcZipWriter();
+
+private:
+
+struct Piece  {off_t offset; size_t length; uint32_t crc;};
+
+struct Member {std::string                  name;
+               std::unique_ptr<XrdZip::LFH> lfh;
+               std::vector<char>            hdr;
+               std::vector<Piece>           pieces;
+               off_t                        lfhOff;
+               off_t                        dataOff;
+               off_t                        size;
+               mode_t                       mode;
+              };
+
+static void* Reader(void* parg);
+       void  ReadWindows();
+       int   Fill(char* wBuff, off_t wBeg, off_t wEnd, std::string& eText);
+       int   Finish(int fd, off_t cdOff);
+       int   Scan(const std::string& dir, const std::string& pfx);
+
+XrdSysMutex         pMutex;
+std::vector<Member> members;
+std::string         srcRoot;
+std::string         errText;
+off_t               arcEnd;
+long long           nextWin;
+long long           numWins;
+int                 arcFD;
+int                 errRC;
+int                 numReaders;
+int                 winSize;
+};
+#endif
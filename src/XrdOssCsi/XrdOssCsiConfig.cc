@@ -86,6 +86,16 @@ int XrdOssCsiConfig::Init(XrdSysError &Eroute, const char *config_fn, const char
       {
          disableLooseWrite_ = true;
       }
+      else if (item == "tagstore")
+      {
+         if (value == "mmap") tagMmap_ = true;
+         else if (value == "file") tagMmap_ = false;
+         else
+         {
+            Eroute.Emsg("Config", "invalid tagstore type -", value.c_str());
+            NoGo = 1;
+         }
+      }
    }
 
    if (NoGo) return NoGo;
@@ -99,6 +109,7 @@ int XrdOssCsiConfig::Init(XrdSysError &Eroute, const char *config_fn, const char
    Eroute.Say("       allow files without CRCs: ", allowMissingTags_ ? "yes" : "no");
    Eroute.Say("       pgWrite can extend      : ", disablePgExtend_ ? "no" : "yes");
    Eroute.Say("       loose writes            : ", disableLooseWrite_ ? "no" : "yes");
+   Eroute.Say("       tagstore                : ", tagMmap_ ? "mmap" : "file");
    Eroute.Say("       trace level             : ", std::to_string((long long int)OssCsiTrace.What).c_str());
    Eroute.Say("       prefix                  : ", tagParam_.prefix_.empty() ? "[empty]" : tagParam_.prefix_.c_str());
 
@@ -153,9 +164,22 @@ int XrdOssCsiConfig::readConfig(XrdSysError &Eroute, const char *ConfigFN)
 int XrdOssCsiConfig::ConfigXeq(char *var, XrdOucStream &Config, XrdSysError &Eroute)
 {
    TS_Xeq("trace",         xtrace);
+   TS_Xeq("tagstore",      xtagstore);
    return 0;
 }
 
+int XrdOssCsiConfig::xtagstore(XrdOucStream &Config, XrdSysError &Eroute)
+{
+    char *val;
+
+    if (!(val = Config.GetWord()))
+       {Eroute.Emsg("Config", "tagstore type not specified"); return 1;}
+    if (!strcmp(val, "mmap")) tagMmap_ = true;
+       else if (!strcmp(val, "file")) tagMmap_ = false;
+       else {Eroute.Emsg("Config", "invalid tagstore type -", val); return 1;}
+    return 0;
+}
+
 int XrdOssCsiConfig::xtrace(XrdOucStream &Config, XrdSysError &Eroute)
 {
     char *val;
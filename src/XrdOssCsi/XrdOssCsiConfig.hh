@@ -188,7 +188,7 @@ class XrdOssCsiConfig
 {
 public:
 
-  XrdOssCsiConfig() : fillFileHole_(true), xrdtSpaceName_("public"), allowMissingTags_(true), disablePgExtend_(false), disableLooseWrite_(false) { }
+  XrdOssCsiConfig() : fillFileHole_(true), xrdtSpaceName_("public"), allowMissingTags_(true), disablePgExtend_(false), disableLooseWrite_(false), tagMmap_(false) { }
   ~XrdOssCsiConfig() { }
 
   int Init(XrdSysError &, const char *, const char *, XrdOucEnv *);
@@ -203,6 +203,8 @@ public:
 
   bool disableLooseWrite() const { return disableLooseWrite_; }
 
+  bool tagMmap() const { return tagMmap_; }
+
   TagPath tagParam_;
 
 private:
@@ -212,11 +214,14 @@ private:
 
   int xtrace(XrdOucStream &, XrdSysError &);
 
+  int xtagstore(XrdOucStream &, XrdSysError &);
+
   bool fillFileHole_;
   std::string xrdtSpaceName_;
   bool allowMissingTags_;
   bool disablePgExtend_;
   bool disableLooseWrite_;
+  bool tagMmap_;
 };
 
 #endif
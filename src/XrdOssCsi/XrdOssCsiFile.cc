@@ -32,6 +32,7 @@
 #include "XrdOssCsi.hh"
 #include "XrdOssCsiTrace.hh"
 #include "XrdOssCsiTagstoreFile.hh"
+#include "XrdOssCsiTagstoreMmap.hh"
 #include "XrdOssCsiPages.hh"
 #include "XrdOssCsiRanges.hh"
 #include "XrdOuc/XrdOucCRC.hh"
@@ -257,8 +258,11 @@ int XrdOssCsiFile::createPageUpdater(const int Oflag, XrdOucEnv &Env)
    }
 
    std::unique_ptr<XrdOssDF> integFile(parentOss_->newFile(tident));
-   std::unique_ptr<XrdOssCsiTagstore> ts(new
-      XrdOssCsiTagstoreFile(pmi_->dpath, std::move(integFile), tident));
+   std::unique_ptr<XrdOssCsiTagstore> ts;
+   if (config_.tagMmap())
+      ts.reset(new XrdOssCsiTagstoreMmap(pmi_->dpath, std::move(integFile), tident));
+   else
+      ts.reset(new XrdOssCsiTagstoreFile(pmi_->dpath, std::move(integFile), tident));
    std::unique_ptr<XrdOssCsiPages> pages(new
       XrdOssCsiPages(pmi_->dpath, std::move(ts), config_.fillFileHole(), config_.allowMissingTags(),
                      config_.disablePgExtend(), config_.disableLooseWrite(), tident));
@@ -348,6 +352,7 @@ ssize_t XrdOssCsiFile::Read(void *buff, off_t offset, size_t blen)
 
    XrdOssCsiRangeGuard rg;
    Pages()->LockTrackinglen(rg, offset, offset+blen, true);
+   Pages()->PrefetchRange(offset, blen);
 
    const ssize_t bread = successor_->Read(buff, offset, blen);
    if (bread<0 || blen==0) return bread;
@@ -363,6 +368,7 @@ ssize_t XrdOssCsiFile::ReadRaw(void *buff, off_t offset, size_t blen)
 
    XrdOssCsiRangeGuard rg;
    Pages()->LockTrackinglen(rg, offset, offset+blen, true);
+   Pages()->PrefetchRange(offset, blen);
 
    const ssize_t bread = successor_->ReadRaw(buff, offset, blen);
    if (bread<0 || blen==0) return bread;
@@ -388,6 +394,7 @@ ssize_t XrdOssCsiFile::ReadV(XrdOucIOVec *readV, int n)
       if (p2>end) end = p2;
    }
    Pages()->LockTrackinglen(rg, start, end, true);
+   Pages()->PrefetchRange(start, end-start);
 
    // standard OSS gives -ESPIPE in case of partial read of an element
    ssize_t rret = successor_->ReadV(readV, n);
@@ -478,6 +485,7 @@ ssize_t XrdOssCsiFile::pgRead(void *buffer, off_t offset, size_t rdlen, uint32_t
 
    XrdOssCsiRangeGuard rg;
    Pages()->LockTrackinglen(rg, offset, offset+rdlen, true);
+   Pages()->PrefetchRange(offset, rdlen);
 
    // if we return a short amount of data the caller will have to deal with
    // joining csvec values from repeated reads: for simplicity try to read as
@@ -289,6 +289,7 @@ void XrdOssCsiFileAioJob::DoItRead1()
    // lock range
    fp_->Pages()->LockTrackinglen(nio_->rg_, (off_t)aiop_->sfsAio.aio_offset,
                                 (off_t)(aiop_->sfsAio.aio_offset+aiop_->sfsAio.aio_nbytes), true);
+   fp_->Pages()->PrefetchRange((off_t)aiop_->sfsAio.aio_offset, aiop_->sfsAio.aio_nbytes);
 
    const int ret = fp_->successor_->Read(nio_);
    if (ret<0)
@@ -540,6 +540,21 @@ void XrdOssCsiPages::LockTrackinglen(XrdOssCsiRangeGuard &rg, const off_t offset
    rg.Wait();
 }
 
+//
+// PrefetchRange
+//
+// Called before the data for a read is fetched. Hints to the tagstore that the
+// tags covering the range will be needed, so the tag read overlaps with the
+// data read rather than following it.
+//
+void XrdOssCsiPages::PrefetchRange(const off_t offset, const size_t blen)
+{
+   if (blen == 0) return;
+   const off_t p1 = offset / XrdSys::PageSize;
+   const off_t p2 = (offset+blen+XrdSys::PageSize-1) / XrdSys::PageSize;
+   ts_->PrefetchTags(p1, p2-p1);
+}
+
 int XrdOssCsiPages::truncate(XrdOssDF *const fd, const off_t len, XrdOssCsiRangeGuard &rg)
 {
    EPNAME("truncate");
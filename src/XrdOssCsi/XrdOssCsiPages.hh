@@ -64,6 +64,7 @@ public:
    int FetchRange(XrdOssDF *, const void *, off_t, size_t, uint32_t *, uint64_t, XrdOssCsiRangeGuard&);
    int StoreRange(XrdOssDF *, const void *, off_t, size_t, uint32_t *, uint64_t, XrdOssCsiRangeGuard&);
    void LockTrackinglen(XrdOssCsiRangeGuard &, off_t, off_t, bool);
+   void PrefetchRange(off_t, size_t);
 
    bool IsReadOnly() const { return rdonly_; }
    int truncate(XrdOssDF *, off_t, XrdOssCsiRangeGuard&);
@@ -48,6 +48,9 @@ public:
    virtual ssize_t WriteTags(const uint32_t *, off_t, size_t)=0;
    virtual ssize_t ReadTags(uint32_t *, off_t, size_t)=0;
 
+   // hint that the tags for the given page range will soon be read
+   virtual void PrefetchTags(off_t, size_t) { }
+
    virtual off_t GetTrackedTagSize() const=0;
    virtual off_t GetTrackedDataSize() const=0;
    virtual bool IsVerified() const=0;
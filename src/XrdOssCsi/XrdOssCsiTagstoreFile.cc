@@ -200,6 +200,14 @@ ssize_t XrdOssCsiTagstoreFile::ReadTags(uint32_t *const buf, const off_t off, co
    return nread/4;
 }
 
+void XrdOssCsiTagstoreFile::PrefetchTags(const off_t off, const size_t n)
+{
+   // ask the tag file to start reading the tags in the background, so that
+   // they are (usually) in memory once the data read completes
+   if (!isOpen || n==0) return;
+   (void)fd_->Read(20LL+4*off, 4*n);
+}
+
 int XrdOssCsiTagstoreFile::Truncate(const off_t size, bool datatoo)
 {
    if (!isOpen)
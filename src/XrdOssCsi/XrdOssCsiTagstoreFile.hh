@@ -53,6 +53,7 @@ public:
 
    virtual ssize_t WriteTags(const uint32_t *, off_t, size_t) /* override */;
    virtual ssize_t ReadTags(uint32_t *, off_t, size_t) /* override */;
+   virtual void PrefetchTags(off_t, size_t) /* override */;
 
    virtual int Truncate(off_t, bool) /* override */;
 
@@ -133,7 +134,7 @@ public:
       return nwritten;
    }
 
-private:
+protected:
    const std::string fn_;
    std::unique_ptr<XrdOssDF> fd_;
    off_t trackinglen_;
@@ -0,0 +1,267 @@
+/******************************************************************************/
+/*                                                                            */
+/*              X r d O s s C s i T a g s t o r e M m a p . c c               */
+/*                                                                            */
+/* (C) Copyright 2026 CERN.                                                   */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* In applying this licence, CERN does not waive the privileges and           */
+/* immunities granted to it by virtue of its status as an Intergovernmental   */
+/* Organization or submit itself to any jurisdiction.                         */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include "XrdOssCsiTrace.hh"
+#include "XrdOssCsiTagstoreMmap.hh"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+extern XrdOucTrace  OssCsiTrace;
+
+int XrdOssCsiTagstoreMmap::Open(const char *path, const off_t dsize, const int Oflag, XrdOucEnv &Env)
+{
+   EPNAME("TagstoreMmap::Open");
+
+   const int ret = XrdOssCsiTagstoreFile::Open(path, dsize, Oflag, Env);
+   if (ret<0) return ret;
+
+   // tags in the other byte order need swapping and a tag file which is not
+   // a local file can not be mapped: both are left to the base class
+   if (machineIsBige_ != fileIsBige_ || fd_->getFD() < 0) return 0;
+
+   writable_ = ((Oflag & O_ACCMODE) != O_RDONLY);
+
+   XrdSysRWLockHelper lck(maplck_, false);
+   int mret = StatLength();
+   if (mret>=0) mret = Map(filelen_);
+   if (mret<0)
+   {
+      TRACE(Warn, "Could not map tagfile for " << fn_ << ", will use read and write, error " << mret);
+   }
+   return 0;
+}
+
+int XrdOssCsiTagstoreMmap::Close()
+{
+   if (!isOpen) return -EBADF;
+   {
+      XrdSysRWLockHelper lck(maplck_, false);
+      Unmap();
+   }
+   return XrdOssCsiTagstoreFile::Close();
+}
+
+void XrdOssCsiTagstoreMmap::Flush()
+{
+   if (!isOpen) return;
+   {
+      XrdSysRWLockHelper lck(maplck_);
+      if (map_ && dirty_.exchange(false)) (void)msync(map_, filelen_, MS_ASYNC);
+   }
+   XrdOssCsiTagstoreFile::Flush();
+}
+
+int XrdOssCsiTagstoreMmap::Fsync()
+{
+   if (!isOpen) return -EBADF;
+   {
+      XrdSysRWLockHelper lck(maplck_);
+      if (map_ && dirty_.exchange(false) && msync(map_, filelen_, MS_SYNC))
+      {
+         const int rc = errno;
+         dirty_ = true;
+         return -rc;
+      }
+   }
+   return XrdOssCsiTagstoreFile::Fsync();
+}
+
+ssize_t XrdOssCsiTagstoreMmap::WriteTags(const uint32_t *const buf, const off_t off, const size_t n)
+{
+   if (!isOpen) return -EBADF;
+   const off_t end = 20LL + 4*(off+(off_t)n);
+
+   XrdSysRWLockHelper lck(maplck_);
+   if (map_ && writable_ && end > filelen_)
+   {
+      // the tag file has to be extended, which excludes all other access to
+      // the mapping. The length is checked again as another writer may have
+      // extended it while the lock was released.
+      lck.UnLock();
+      lck.Lock(&maplck_, false);
+      if (map_ && end > filelen_)
+      {
+         const int gret = Grow(end);
+         if (gret<0) return gret;
+      }
+   }
+
+   if (!map_ || !writable_)
+   {
+      lck.UnLock();
+      return XrdOssCsiTagstoreFile::WriteTags(buf, off, n);
+   }
+
+   memcpy(&map_[20LL+4*off], buf, 4*n);
+   dirty_ = true;
+   return n;
+}
+
+ssize_t XrdOssCsiTagstoreMmap::ReadTags(uint32_t *const buf, const off_t off, const size_t n)
+{
+   if (!isOpen) return -EBADF;
+
+   XrdSysRWLockHelper lck(maplck_);
+   if (!map_)
+   {
+      lck.UnLock();
+      return XrdOssCsiTagstoreFile::ReadTags(buf, off, n);
+   }
+
+   // as for a short read of the tag file
+   if (20LL + 4*(off+(off_t)n) > filelen_) return -EDOM;
+
+   memcpy(buf, &map_[20LL+4*off], 4*n);
+   return n;
+}
+
+void XrdOssCsiTagstoreMmap::PrefetchTags(const off_t off, const size_t n)
+{
+   if (!isOpen || n==0) return;
+
+   XrdSysRWLockHelper lck(maplck_);
+   if (!map_)
+   {
+      lck.UnLock();
+      XrdOssCsiTagstoreFile::PrefetchTags(off, n);
+      return;
+   }
+
+   const off_t p1 = std::min((off_t)(20LL + 4*off), filelen_);
+   const off_t p2 = std::min((off_t)(20LL + 4*(off+(off_t)n)), filelen_);
+   const off_t mpsz = sysconf(_SC_PAGESIZE);
+   const off_t a1 = (p1/mpsz)*mpsz;
+   if (p2 > a1) (void)madvise(&map_[a1], p2-a1, MADV_WILLNEED);
+}
+
+int XrdOssCsiTagstoreMmap::Truncate(const off_t size, bool datatoo)
+{
+   XrdSysRWLockHelper lck(maplck_, false);
+   const int tret = XrdOssCsiTagstoreFile::Truncate(size, datatoo);
+   if (map_)
+   {
+      const int sret = StatLength();
+      if (sret<0) Unmap();
+   }
+   return tret;
+}
+
+int XrdOssCsiTagstoreMmap::ResetSizes(const off_t size)
+{
+   XrdSysRWLockHelper lck(maplck_, false);
+   const int rret = XrdOssCsiTagstoreFile::ResetSizes(size);
+   if (map_)
+   {
+      const int sret = StatLength();
+      if (sret<0) Unmap();
+   }
+   return rret;
+}
+
+//
+// Map the tag file, reserving space for it to grow to at least len bytes.
+// The current mapping is kept if it is already large enough. Called with
+// maplck_ write locked (or during Open).
+//
+int XrdOssCsiTagstoreMmap::Map(const off_t len)
+{
+   size_t want = std::max(len, filelen_);
+   want += want/2;
+   want = ((want + mapChunk_ - 1) / mapChunk_) * mapChunk_;
+   if (map_ && want <= maplen_) return 0;
+
+   // unmapping does not lose any modified tags: the mapping is shared so
+   // they are already in the page cache of the file
+   Unmap();
+   void *p = mmap(NULL, want, PROT_READ | (writable_ ? PROT_WRITE : 0),
+                  MAP_SHARED, fd_->getFD(), 0);
+   if (p == MAP_FAILED) return -errno;
+   map_ = (uint8_t*)p;
+   maplen_ = want;
+   return 0;
+}
+
+void XrdOssCsiTagstoreMmap::Unmap()
+{
+   if (!map_) return;
+   (void)munmap(map_, maplen_);
+   map_ = NULL;
+   maplen_ = 0;
+}
+
+//
+// Extend the tag file to len bytes. Pages of the mapping beyond the end of
+// file may not be touched, so the file is extended before tags are stored.
+// The blocks are allocated here, rather than when the pages are first
+// written back, as running out of space on a store to the mapping raises
+// SIGBUS. Lack of space is returned as an error, as for a write of the tags.
+// Should the space not be reservable for another reason the mapping is
+// dropped and the tags are written with system calls by the base class.
+// Called with maplck_ write locked.
+//
+int XrdOssCsiTagstoreMmap::Grow(const off_t len)
+{
+   EPNAME("TagstoreMmap::Grow");
+   const int fret = posix_fallocate(fd_->getFD(), filelen_, len - filelen_);
+   if (fret)
+   {
+      if (fret == ENOSPC || fret == EDQUOT || fret == EFBIG) return -fret;
+      TRACE(Warn, "Could not reserve space in tagfile for " << fn_ << ", will use read and write, error " << -fret);
+      Unmap();
+      return 0;
+   }
+   filelen_ = len;
+   if ((size_t)len > maplen_)
+   {
+      const int mret = Map(len);
+      if (mret<0)
+      {
+         TRACE(Warn, "Could not remap tagfile for " << fn_ << ", will use read and write, error " << mret);
+      }
+   }
+   return 0;
+}
+
+int XrdOssCsiTagstoreMmap::StatLength()
+{
+   struct stat sb;
+   const int ssret = fd_->Fstat(&sb);
+   if (ssret<0) return ssret;
+   filelen_ = sb.st_size;
+   return 0;
+}
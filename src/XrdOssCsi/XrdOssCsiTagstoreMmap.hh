@@ -0,0 +1,88 @@
+#ifndef _XRDOSSCSITAGSTOREMMAP_H
+#define _XRDOSSCSITAGSTOREMMAP_H
+/******************************************************************************/
+/*                                                                            */
+/*              X r d O s s C s i T a g s t o r e M m a p . h h               */
+/*                                                                            */
+/* (C) Copyright 2026 CERN.                                                   */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* In applying this licence, CERN does not waive the privileges and           */
+/* immunities granted to it by virtue of its status as an Intergovernmental   */
+/* Organization or submit itself to any jurisdiction.                         */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include "XrdOssCsiTagstoreFile.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+#include <atomic>
+
+//
+// Tagstore that keeps the tags in the same file format as
+// XrdOssCsiTagstoreFile, but accesses them through a shared memory mapping
+// of the tag file rather than with a read or write system call per request.
+// Tag updates from concurrent writers are stores to the mapping and are
+// written back together, with a single msync, on Flush or Fsync.
+//
+// Address space is reserved beyond the end of the tag file so that it can
+// grow without being remapped. Disk space is allocated as the file is
+// extended so that running out of it is an error rather than a SIGBUS. Tag files in the non-native byte order, or
+// which are not local files, are accessed as by the base class.
+//
+class XrdOssCsiTagstoreMmap : public XrdOssCsiTagstoreFile
+{
+public:
+   XrdOssCsiTagstoreMmap(const std::string &fn, std::unique_ptr<XrdOssDF> fd, const char *tid) :
+      XrdOssCsiTagstoreFile(fn, std::move(fd), tid), map_(NULL), maplen_(0), filelen_(0), writable_(false), dirty_(false) { }
+   virtual ~XrdOssCsiTagstoreMmap() { if (isOpen) { (void)Close(); } }
+
+   virtual int Open(const char *, off_t, int, XrdOucEnv &) /* override */;
+   virtual int Close() /* override */;
+
+   virtual void Flush() /* override */;
+   virtual int Fsync() /* override */;
+
+   virtual ssize_t WriteTags(const uint32_t *, off_t, size_t) /* override */;
+   virtual ssize_t ReadTags(uint32_t *, off_t, size_t) /* override */;
+   virtual void PrefetchTags(off_t, size_t) /* override */;
+
+   virtual int Truncate(off_t, bool) /* override */;
+   virtual int ResetSizes(off_t) /* override */;
+
+private:
+   int Map(off_t);
+   void Unmap();
+   int Grow(off_t);
+   int StatLength();
+
+   XrdSysRWLock maplck_;   // write locked to change the mapping or file length
+   uint8_t *map_;
+   size_t maplen_;
+   off_t filelen_;
+   bool writable_;
+   std::atomic<bool> dirty_;
+
+   // mapping length is rounded up to a multiple of this
+   static const size_t mapChunk_ = 1024*1024;
+};
+
+#endif
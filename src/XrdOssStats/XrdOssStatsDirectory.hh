@@ -13,11 +13,12 @@ namespace XrdOssStats {
 
 class Directory : public XrdOssWrapDF {
 public:
-    Directory(std::unique_ptr<XrdOssDF> ossDF, XrdSysError &log, FileSystem &oss) :
+    Directory(std::unique_ptr<XrdOssDF> ossDF, XrdSysError &log, FileSystem &oss, const char *user) :
         XrdOssWrapDF(*ossDF),
         m_wrappedDir(std::move(ossDF)),
         m_log(log),
-        m_oss(oss)
+        m_oss(oss),
+        m_user(user)
     {
     }
 
@@ -27,21 +28,31 @@ public:
     Opendir(const char *path,
             XrdOucEnv &env) override 
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_dirlist_ops, m_oss.m_slow_ops.m_dirlist_ops, m_oss.m_times.m_dirlist, m_oss.m_slow_times.m_dirlist, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_dirlist_ops, m_oss.m_slow_ops.m_dirlist_ops, m_oss.m_times.m_dirlist, m_oss.m_slow_times.m_dirlist, m_oss, FileSystem::HistDirlist, Where(path));
         return wrapDF.Opendir(path, env);
     }
 
     int Readdir(char *buff, int blen) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_dirlist_entries, m_oss.m_slow_ops.m_dirlist_entries, m_oss.m_times.m_dirlist, m_oss.m_slow_times.m_dirlist, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_dirlist_entries, m_oss.m_slow_ops.m_dirlist_entries, m_oss.m_times.m_dirlist, m_oss.m_slow_times.m_dirlist, m_oss, FileSystem::HistNone, FileSystem::OpOrigin());
         return wrapDF.Readdir(buff, blen);
     }
 
 
 private:
+    FileSystem::OpOrigin Where(const char *path) const
+    {
+        FileSystem::OpOrigin org;
+        org.path = path;
+        org.user = m_user;
+        org.prefix = m_oss.PrefixOf(path);
+        return org;
+    }
+
     std::unique_ptr<XrdOssDF> m_wrappedDir;
     XrdSysError m_log;
     FileSystem &m_oss;
+    const char *m_user;
 };
 
 } // namespace XrdOssStats
@@ -15,86 +15,90 @@ namespace XrdOssStats {
 
 class File : public XrdOssWrapDF {
 public:
-    File(std::unique_ptr<XrdOssDF> wrapDF, XrdSysError &log, FileSystem &oss) :
+    File(std::unique_ptr<XrdOssDF> wrapDF, XrdSysError &log, FileSystem &oss, const char *user) :
       XrdOssWrapDF(*wrapDF),
       m_wrapped(std::move(wrapDF)),
       m_log(log),
       m_oss(oss)
-    {}
+    {
+        if (oss.m_top_files && user) m_user = user;
+    }
 
     virtual ~File();
 
     int     Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &env) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_open_ops, m_oss.m_slow_ops.m_open_ops, m_oss.m_times.m_open, m_oss.m_slow_times.m_open, m_oss.m_slow_duration);
+        if (m_oss.m_top_files) m_path = path;
+        m_prefix = m_oss.PrefixOf(path);
+        FileSystem::OpTimer op(m_oss.m_ops.m_open_ops, m_oss.m_slow_ops.m_open_ops, m_oss.m_times.m_open, m_oss.m_slow_times.m_open, m_oss, FileSystem::HistOpen, Where());
         return wrapDF.Open(path, Oflag, Mode, env);
     }
 
     int     Fchmod(mode_t mode) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_chmod_ops, m_oss.m_slow_ops.m_chmod_ops, m_oss.m_times.m_chmod, m_oss.m_slow_times.m_chmod, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_chmod_ops, m_oss.m_slow_ops.m_chmod_ops, m_oss.m_times.m_chmod, m_oss.m_slow_times.m_chmod, m_oss, FileSystem::HistChmod, Where());
         return wrapDF.Fchmod(mode);
     }
 
     int     Fstat(struct stat *buf) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_stat_ops, m_oss.m_slow_ops.m_stat_ops, m_oss.m_times.m_stat, m_oss.m_slow_times.m_stat, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_stat_ops, m_oss.m_slow_ops.m_stat_ops, m_oss.m_times.m_stat, m_oss.m_slow_times.m_stat, m_oss, FileSystem::HistStat, Where());
         return wrapDF.Fstat(buf);
     }
 
     int     Ftruncate(unsigned long long size) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_truncate_ops, m_oss.m_slow_ops.m_truncate_ops, m_oss.m_times.m_truncate, m_oss.m_slow_times.m_truncate, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_truncate_ops, m_oss.m_slow_ops.m_truncate_ops, m_oss.m_times.m_truncate, m_oss.m_slow_times.m_truncate, m_oss, FileSystem::HistTruncate, Where());
         return wrapDF.Ftruncate(size);
     }
 
     ssize_t pgRead (void* buffer, off_t offset, size_t rdlen,
                         uint32_t* csvec, uint64_t opts) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_pgread_ops, m_oss.m_slow_ops.m_pgread_ops, m_oss.m_times.m_pgread, m_oss.m_slow_times.m_pgread, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_pgread_ops, m_oss.m_slow_ops.m_pgread_ops, m_oss.m_times.m_pgread, m_oss.m_slow_times.m_pgread, m_oss, FileSystem::HistPgRead, Where());
         return wrapDF.pgRead(buffer, offset, rdlen, csvec, opts);
     }
 
     int     pgRead (XrdSfsAio* aioparm, uint64_t opts) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_pgread_ops, m_oss.m_slow_ops.m_pgread_ops, m_oss.m_times.m_pgread, m_oss.m_slow_times.m_pgread, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_pgread_ops, m_oss.m_slow_ops.m_pgread_ops, m_oss.m_times.m_pgread, m_oss.m_slow_times.m_pgread, m_oss, FileSystem::HistPgRead, Where());
         return wrapDF.pgRead(aioparm, opts);
     }
 
     ssize_t pgWrite(void* buffer, off_t offset, size_t wrlen,
                         uint32_t* csvec, uint64_t opts) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_pgwrite_ops, m_oss.m_slow_ops.m_pgwrite_ops, m_oss.m_times.m_pgwrite, m_oss.m_slow_times.m_pgwrite, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_pgwrite_ops, m_oss.m_slow_ops.m_pgwrite_ops, m_oss.m_times.m_pgwrite, m_oss.m_slow_times.m_pgwrite, m_oss, FileSystem::HistPgWrite, Where());
         return wrapDF.pgWrite(buffer, offset, wrlen, csvec, opts);
     }
 
     int     pgWrite(XrdSfsAio* aioparm, uint64_t opts) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_pgwrite_ops, m_oss.m_slow_ops.m_pgwrite_ops, m_oss.m_times.m_pgwrite, m_oss.m_slow_times.m_pgwrite, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_pgwrite_ops, m_oss.m_slow_ops.m_pgwrite_ops, m_oss.m_times.m_pgwrite, m_oss.m_slow_times.m_pgwrite, m_oss, FileSystem::HistPgWrite, Where());
         return wrapDF.pgWrite(aioparm, opts);
     }
 
     ssize_t Read(off_t offset, size_t size) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_read_ops, m_oss.m_slow_ops.m_read_ops, m_oss.m_times.m_read, m_oss.m_slow_times.m_read, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_read_ops, m_oss.m_slow_ops.m_read_ops, m_oss.m_times.m_read, m_oss.m_slow_times.m_read, m_oss, FileSystem::HistRead, Where());
         return wrapDF.Read(offset, size);
     }
 
     ssize_t Read(void *buffer, off_t offset, size_t size) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_read_ops, m_oss.m_slow_ops.m_read_ops, m_oss.m_times.m_read, m_oss.m_slow_times.m_read, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_read_ops, m_oss.m_slow_ops.m_read_ops, m_oss.m_times.m_read, m_oss.m_slow_times.m_read, m_oss, FileSystem::HistRead, Where());
         return wrapDF.Read(buffer, offset, size);
     }
 
     int     Read(XrdSfsAio *aiop) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_read_ops, m_oss.m_slow_ops.m_read_ops, m_oss.m_times.m_read, m_oss.m_slow_times.m_read, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_read_ops, m_oss.m_slow_ops.m_read_ops, m_oss.m_times.m_read, m_oss.m_slow_times.m_read, m_oss, FileSystem::HistRead, Where());
         return wrapDF.Read(aiop);
     }
 
     ssize_t ReadRaw(void *buffer, off_t offset, size_t size) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_read_ops, m_oss.m_slow_ops.m_read_ops, m_oss.m_times.m_read, m_oss.m_slow_times.m_read, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_read_ops, m_oss.m_slow_ops.m_read_ops, m_oss.m_times.m_read, m_oss.m_slow_times.m_read, m_oss, FileSystem::HistRead, Where());
         return wrapDF.ReadRaw(buffer, offset, size);
     }
 
@@ -110,35 +114,50 @@ public:
         if (dur > m_oss.m_slow_duration) {
             m_oss.m_slow_ops.m_readv_ops++;
             m_oss.m_slow_ops.m_readv_segs += rdvcnt;
-            m_oss.m_times.m_readv += std::chrono::nanoseconds(dur).count();
+            m_oss.m_slow_times.m_readv += ns;
         }
+        m_oss.Record(FileSystem::HistReadV, dur, Where());
         return result;
     }
 
     ssize_t Write(const void *buffer, off_t offset, size_t size) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_write_ops, m_oss.m_slow_ops.m_write_ops, m_oss.m_times.m_write, m_oss.m_slow_times.m_write, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_write_ops, m_oss.m_slow_ops.m_write_ops, m_oss.m_times.m_write, m_oss.m_slow_times.m_write, m_oss, FileSystem::HistWrite, Where());
         return wrapDF.Write(buffer, offset, size);
     }
 
     int     Write(XrdSfsAio *aiop) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_write_ops, m_oss.m_slow_ops.m_write_ops, m_oss.m_times.m_write, m_oss.m_slow_times.m_write, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_write_ops, m_oss.m_slow_ops.m_write_ops, m_oss.m_times.m_write, m_oss.m_slow_times.m_write, m_oss, FileSystem::HistWrite, Where());
         return wrapDF.Write(aiop);
     }
 
     ssize_t WriteV(XrdOucIOVec *writeV, int wrvcnt) override
     {
-        FileSystem::OpTimer op(m_oss.m_ops.m_write_ops, m_oss.m_slow_ops.m_write_ops, m_oss.m_times.m_write, m_oss.m_slow_times.m_write, m_oss.m_slow_duration);
+        FileSystem::OpTimer op(m_oss.m_ops.m_write_ops, m_oss.m_slow_ops.m_write_ops, m_oss.m_times.m_write, m_oss.m_slow_times.m_write, m_oss, FileSystem::HistWrite, Where());
         return wrapDF.WriteV(writeV, wrvcnt);
     }
 
 private:
+    FileSystem::OpOrigin Where() const
+    {
+        FileSystem::OpOrigin org;
+        org.path = m_path.c_str();
+        org.user = m_user.c_str();
+        org.prefix = m_prefix;
+        return org;
+    }
+
     std::unique_ptr<XrdOssDF> m_wrapped;
     XrdSysError &m_log;
     const XrdSecEntity* m_client;
     FileSystem &m_oss;
 
+    // Only kept when the slowest files and users are tracked
+    std::string m_path;
+    std::string m_user;
+    int m_prefix{-1};
+
 };
 
 } // namespace XrdOssStats
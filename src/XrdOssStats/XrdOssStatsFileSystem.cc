@@ -4,16 +4,62 @@
 #include "XrdOssStatsDirectory.hh"
 #include "XrdOssStatsFile.hh"
 #include "XrdOssStatsFileSystem.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdSec/XrdSecEntity.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdXrootd/XrdXrootdGStream.hh"
 
 #include <cinttypes>
+#include <cstring>
 #include <stdexcept>
 #include <thread>
 
 using namespace XrdOssStats;
 using namespace XrdOssStats::detail;
 
+namespace {
+
+// The g-stream names of the operations with a latency histogram; the order
+// matches FileSystem::HistOp.
+const char *g_hist_names[] = {"open", "read", "readv", "pgread", "write", "pgwrite",
+                              "dirlist", "stat", "truncate", "unlink", "rename", "chmod"};
+
+// Keys longer than this are truncated in the top-K report so that a full
+// report always fits into a single g-stream record.
+const size_t g_topk_maxkey = 512;
+const size_t g_topk_maxk = 32;
+
+// Append `str` to `out` as the body of a JSON string.
+void
+JSONEscape(std::string &out, const std::string &str)
+{
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        } else {
+            out += c;
+        }
+    }
+}
+
+// Reduce a trace identifier ("user.pid:sid@host") to "user@host" so that all
+// of the connections of a user from a host are counted together.
+std::string
+UserOf(const char *tident)
+{
+    const char *dot = strchr(tident, '.');
+    const char *at = strchr(tident, '@');
+    if (!dot || !at || dot > at) return tident;
+    return std::string(tident, dot - tident) + at;
+}
+
+} // namespace
+
 FileSystem::FileSystem(XrdOss *oss, XrdSysLogger *lp, const char *configfn, XrdOucEnv *envP) :
     XrdOssWrapper(*oss),
     m_oss(oss),
@@ -76,9 +122,21 @@ FileSystem::InitSuccessful(std::string &errMsg) {
 void *
 FileSystem::AggregateBootstrap(void *me) {
     auto myself = static_cast<FileSystem*>(me);
+    auto topk_last = std::chrono::steady_clock::now();
     while (1) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
         myself->AggregateStats();
+        if (myself->m_hist_enabled) {
+            myself->ReportHistograms(myself->m_hist);
+            for (auto &hset : myself->m_prefix_hist) {
+                myself->ReportHistograms(*hset);
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (myself->m_top_files && now - topk_last >= myself->m_topk_every) {
+            myself->ReportTopK(now - topk_last);
+            topk_last = now;
+        }
     }
     return nullptr;
 }
@@ -88,7 +146,7 @@ FileSystem::Config(const char *configfn)
 {
     m_log.setMsgMask(LogMask::Error | LogMask::Warning);
 
-    XrdOucGatherConf statsConf("fsstats.trace fsstats.slowop", &m_log);
+    XrdOucGatherConf statsConf("fsstats.trace fsstats.slowop fsstats.histogram fsstats.topk", &m_log);
     int result;
     if ((result = statsConf.Gather(configfn, XrdOucGatherConf::trim_lines)) < 0) {
         m_log.Emsg("Config", -result, "parsing config file", configfn);
@@ -122,10 +180,89 @@ FileSystem::Config(const char *configfn)
                 m_log.Emsg("Config", "fsstats.slowop couldn't parse duration", val, errmsg.c_str());
                 return false;
             }
+        } else if (!strcmp(val, "histogram")) {
+            m_hist_enabled = true;
+            while ((val = statsConf.GetToken())) {
+                if (!strcmp(val, "off")) {
+                    m_hist_enabled = false;
+                } else if (!strcmp(val, "on")) {
+                    m_hist_enabled = true;
+                } else if (!strcmp(val, "prefix")) {
+                    if (!(val = statsConf.GetToken()) || val[0] != '/') {
+                        m_log.Emsg("Config", "fsstats.histogram prefix requires an absolute path.  Usage: fsstats.histogram [on|off] [prefix <path>] ...");
+                        return false;
+                    }
+                    std::unique_ptr<HistSet> hset(new HistSet);
+                    hset->m_prefix = val;
+                    while (hset->m_prefix.size() > 1 && hset->m_prefix.back() == '/') {
+                        hset->m_prefix.pop_back();
+                    }
+                    m_prefix_hist.push_back(std::move(hset));
+                } else {
+                    m_log.Emsg("Config", "fsstats.histogram has an invalid option", val);
+                    return false;
+                }
+            }
+        } else if (!strcmp(val, "topk")) {
+            char *eP;
+            long k;
+            if (!(val = statsConf.GetToken())) {
+                m_log.Emsg("Config", "fsstats.topk requires an argument.  Usage: fsstats.topk <k> [min <duration>] [every <duration>]");
+                return false;
+            }
+            k = strtol(val, &eP, 10);
+            if (*eP || k < 0 || k > static_cast<long>(g_topk_maxk)) {
+                m_log.Emsg("Config", "fsstats.topk count must be between 0 and 32; got", val);
+                return false;
+            }
+            while ((val = statsConf.GetToken())) {
+                std::chrono::steady_clock::duration *dur;
+                if (!strcmp(val, "min")) {dur = &m_topk_min;}
+                else if (!strcmp(val, "every")) {dur = &m_topk_every;}
+                else {
+                    m_log.Emsg("Config", "fsstats.topk has an invalid option", val);
+                    return false;
+                }
+                std::string errmsg;
+                const char *opt = val;
+                if (!(val = statsConf.GetToken()) || !ParseDuration(val, *dur, errmsg)) {
+                    m_log.Emsg("Config", "fsstats.topk couldn't parse duration for", opt, errmsg.c_str());
+                    return false;
+                }
+            }
+            if (m_topk_every < std::chrono::seconds(1)) {
+                m_topk_every = std::chrono::seconds(1);
+            }
+            if (k) {
+                m_top_files.reset(new TopK(k));
+                m_top_users.reset(new TopK(k));
+            } else {
+                m_top_files.reset();
+                m_top_users.reset();
+            }
         }
     }
     m_log.Emsg("Config", "Logging levels enabled", LogMaskToString(m_log.getMsgMask()).c_str());
 
+    // Unless told otherwise, the heavy hitters are computed from the slow operations
+    if (m_topk_min < std::chrono::steady_clock::duration(0)) {
+        m_topk_min = m_slow_duration;
+    }
+
+    if (m_hist_enabled) {
+        m_hist.m_last.assign(HistCount * Histogram::kBuckets, 0);
+        std::string prefixes;
+        for (auto &hset : m_prefix_hist) {
+            hset->m_last.assign(HistCount * Histogram::kBuckets, 0);
+            prefixes += " " + hset->m_prefix;
+        }
+        m_log.Emsg("Config", "Latency histograms enabled", prefixes.empty() ? "" : "for prefixes", prefixes.empty() ? "" : prefixes.c_str() + 1);
+    }
+    if (m_top_files) {
+        m_log.Emsg("Config", "Tracking the slowest files and users; count",
+                   std::to_string(m_top_files->Capacity()).c_str());
+    }
+
     return true;
 }
 
@@ -133,92 +270,92 @@ XrdOssDF *FileSystem::newDir(const char *user)
 {
     // Call the underlying OSS newDir
     std::unique_ptr<XrdOssDF> wrapped(wrapPI.newDir(user));
-    return new Directory(std::move(wrapped), m_log, *this);
+    return new Directory(std::move(wrapped), m_log, *this, user);
 }
 
 XrdOssDF *FileSystem::newFile(const char *user)
 {
     // Call the underlying OSS newFile
     std::unique_ptr<XrdOssDF> wrapped(wrapPI.newFile(user));
-    return new File(std::move(wrapped), m_log, *this);
+    return new File(std::move(wrapped), m_log, *this, user);
 }
 
 int FileSystem::Chmod(const char * path, mode_t mode, XrdOucEnv *env)
 {
-    OpTimer op(m_ops.m_chmod_ops, m_slow_ops.m_chmod_ops, m_times.m_chmod, m_slow_times.m_chmod, m_slow_duration);
+    OpTimer op(m_ops.m_chmod_ops, m_slow_ops.m_chmod_ops, m_times.m_chmod, m_slow_times.m_chmod, *this, HistChmod, Origin(path, env));
     return wrapPI.Chmod(path, mode, env);
 }
 
 int       FileSystem::Rename(const char *oPath, const char *nPath,
                         XrdOucEnv  *oEnvP, XrdOucEnv *nEnvP)
 {
-    OpTimer op(m_ops.m_rename_ops, m_slow_ops.m_rename_ops, m_times.m_rename, m_slow_times.m_rename, m_slow_duration);
+    OpTimer op(m_ops.m_rename_ops, m_slow_ops.m_rename_ops, m_times.m_rename, m_slow_times.m_rename, *this, HistRename, Origin(oPath, oEnvP));
     return wrapPI.Rename(oPath, nPath, oEnvP, nEnvP);
 }
 
 int       FileSystem::Stat(const char *path, struct stat *buff,
                     int opts, XrdOucEnv *env)
 {
-    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, m_slow_duration);
+    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, *this, HistStat, Origin(path, env));
     return wrapPI.Stat(path, buff, opts, env);
 }
 
 int       FileSystem::StatFS(const char *path, char *buff, int &blen,
                         XrdOucEnv  *env)
 {
-    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, m_slow_duration);
+    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, *this, HistStat, Origin(path, env));
     return wrapPI.StatFS(path, buff, blen, env);
 }
 
 int       FileSystem::StatLS(XrdOucEnv &env, const char *path,
                         char *buff, int &blen)
 {
-    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, m_slow_duration);
+    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, *this, HistStat, Origin(path, &env));
     return wrapPI.StatLS(env, path, buff, blen);
 }
 
 int       FileSystem::StatPF(const char *path, struct stat *buff, int opts)
 {
-    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, m_slow_duration);
+    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, *this, HistStat, Origin(path, nullptr));
     return wrapPI.StatPF(path, buff, opts);
 }
 
 int       FileSystem::StatPF(const char *path, struct stat *buff)
 {
-    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, m_slow_duration);
+    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, *this, HistStat, Origin(path, nullptr));
     return wrapPI.StatPF(path, buff, 0);
 }
 
 int       FileSystem::StatVS(XrdOssVSInfo *vsP, const char *sname, int updt)
 {
-    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, m_slow_duration);
+    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, *this, HistStat, OpOrigin());
     return wrapPI.StatVS(vsP, sname, updt);
 }
 
 int       FileSystem::StatXA(const char *path, char *buff, int &blen,
                         XrdOucEnv *env)
 {
-    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, m_slow_duration);
+    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, *this, HistStat, Origin(path, env));
     return wrapPI.StatXA(path, buff, blen, env);
 }
 
 int       FileSystem::StatXP(const char *path, unsigned long long &attr,
                         XrdOucEnv  *env)
 {
-    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, m_slow_duration);
+    OpTimer op(m_ops.m_stat_ops, m_slow_ops.m_stat_ops, m_times.m_stat, m_slow_times.m_stat, *this, HistStat, Origin(path, env));
     return wrapPI.StatXP(path, attr, env);
 }
 
 int       FileSystem::Truncate(const char *path, unsigned long long fsize,
                         XrdOucEnv *env)
 {
-    OpTimer op(m_ops.m_truncate_ops, m_slow_ops.m_truncate_ops, m_times.m_truncate, m_slow_times.m_truncate, m_slow_duration);
+    OpTimer op(m_ops.m_truncate_ops, m_slow_ops.m_truncate_ops, m_times.m_truncate, m_slow_times.m_truncate, *this, HistTruncate, Origin(path, env));
     return wrapPI.Truncate(path, fsize, env);
 }
 
 int       FileSystem::Unlink(const char *path, int Opts, XrdOucEnv *env)
 {
-    OpTimer op(m_ops.m_unlink_ops, m_slow_ops.m_unlink_ops, m_times.m_unlink, m_slow_times.m_unlink, m_slow_duration);
+    OpTimer op(m_ops.m_unlink_ops, m_slow_ops.m_unlink_ops, m_times.m_unlink, m_slow_times.m_unlink, *this, HistUnlink, Origin(path, env));
     return wrapPI.Unlink(path, Opts, env);
 }
 
@@ -279,13 +416,138 @@ void FileSystem::AggregateStats()
     }
 }
 
-FileSystem::OpTimer::OpTimer(RAtomic_uint64_t &op_count, RAtomic_uint64_t &slow_op_count, RAtomic_uint64_t &timing, RAtomic_uint64_t &slow_timing, std::chrono::steady_clock::duration duration)
+FileSystem::OpOrigin
+FileSystem::Origin(const char *path, XrdOucEnv *env) const
+{
+    OpOrigin org;
+    org.path = path;
+    const XrdSecEntity *client = env ? env->secEnv() : nullptr;
+    if (client) org.user = client->tident;
+    org.prefix = PrefixOf(path);
+    return org;
+}
+
+// Return the index of the longest configured prefix containing `path`, or -1.
+int
+FileSystem::PrefixOf(const char *path) const
+{
+    int best = -1;
+    size_t best_len = 0;
+    if (!m_hist_enabled || !path) return -1;
+    for (size_t idx = 0; idx < m_prefix_hist.size(); idx++) {
+        const std::string &prefix = m_prefix_hist[idx]->m_prefix;
+        auto len = prefix.size();
+        if (len < best_len || strncmp(path, prefix.c_str(), len)) continue;
+        if (len == 1 || path[len] == '/' || path[len] == '\0') {
+            best = static_cast<int>(idx);
+            best_len = len;
+        }
+    }
+    return best;
+}
+
+void
+FileSystem::Record(HistOp hop, std::chrono::steady_clock::duration dur, const OpOrigin &org)
+{
+    uint64_t ns = std::chrono::nanoseconds(dur).count();
+    if (m_hist_enabled && hop != HistNone) {
+        m_hist.m_hist[hop].Add(ns);
+        if (org.prefix >= 0) m_prefix_hist[org.prefix]->m_hist[hop].Add(ns);
+    }
+    if (m_top_files && dur >= m_topk_min) {
+        if (org.path && *org.path) m_top_files->Add(org.path, ns);
+        if (org.user && *org.user) m_top_users->Add(UserOf(org.user), ns);
+    }
+}
+
+// Send the latency quantiles of each operation seen since the last report
+void
+FileSystem::ReportHistograms(HistSet &hset)
+{
+    std::string buf = "{\"event\":\"oss_hist" + (m_runmode.empty() ? "" : "_" + m_runmode) + "\"";
+    if (!hset.m_prefix.empty()) {
+        buf += ",\"prefix\":\"";
+        JSONEscape(buf, hset.m_prefix);
+        buf += "\"";
+    }
+
+    uint64_t counts[Histogram::kBuckets];
+    bool active = false;
+    for (int hop = 0; hop < HistCount; hop++) {
+        uint64_t *last = hset.m_last.data() + hop * Histogram::kBuckets;
+        hset.m_hist[hop].Snapshot(counts);
+        for (int idx = 0; idx < Histogram::kBuckets; idx++) {
+            auto now = counts[idx];
+            counts[idx] -= last[idx];
+            last[idx] = now;
+        }
+        auto summary = Histogram::Summarize(counts);
+        if (!summary.count) continue;
+        active = true;
+
+        char entry[256];
+        snprintf(entry, sizeof(entry),
+            ",\"%s\":{\"n\":%" PRIu64 ",\"p50\":%.6f,\"p90\":%.6f,\"p99\":%.6f,\"p999\":%.6f,\"max\":%.6f}",
+            g_hist_names[hop], summary.count,
+            summary.p50/1e9, summary.p90/1e9, summary.p99/1e9, summary.p999/1e9, summary.max/1e9);
+        buf += entry;
+    }
+    if (!active) return;
+    buf += "}";
+
+    m_log.Log(LogMask::Debug, "Aggregate", buf.c_str());
+    if (m_gstream && !m_gstream->Insert(buf.c_str(), buf.size() + 1)) {
+        m_log.Log(LogMask::Error, "Aggregate", "Failed to send g-stream histogram packet");
+    }
+}
+
+// Send the files and users with the most time in slow operations during the
+// last period and start a new period.
+void
+FileSystem::ReportTopK(std::chrono::steady_clock::duration period)
+{
+    auto files = m_top_files->Drain();
+    auto users = m_top_users->Drain();
+    if (files.empty() && users.empty()) return;
+
+    char num[160];
+    snprintf(num, sizeof(num), "\",\"period\":%.1f", std::chrono::duration<double>(period).count());
+    std::string buf = "{\"event\":\"oss_topk" + (m_runmode.empty() ? "" : "_" + m_runmode) + num;
+
+    auto list = [&](const char *name, const std::vector<TopK::Entry> &entries) {
+        buf += ",\"";
+        buf += name;
+        buf += "\":[";
+        bool first = true;
+        for (const auto &entry : entries) {
+            buf += first ? "{\"name\":\"" : ",{\"name\":\"";
+            first = false;
+            JSONEscape(buf, entry.key.substr(0, g_topk_maxkey));
+            snprintf(num, sizeof(num), "\",\"t\":%.4f,\"n\":%" PRIu64 ",\"err\":%.4f}",
+                     entry.ns/1e9, entry.count, entry.error/1e9);
+            buf += num;
+        }
+        buf += "]";
+    };
+    list("files", files);
+    list("users", users);
+    buf += "}";
+
+    m_log.Log(LogMask::Debug, "Aggregate", buf.c_str());
+    if (m_gstream && !m_gstream->Insert(buf.c_str(), buf.size() + 1)) {
+        m_log.Log(LogMask::Error, "Aggregate", "Failed to send g-stream top-K packet");
+    }
+}
+
+FileSystem::OpTimer::OpTimer(RAtomic_uint64_t &op_count, RAtomic_uint64_t &slow_op_count, RAtomic_uint64_t &timing, RAtomic_uint64_t &slow_timing, FileSystem &fs, HistOp hop, const OpOrigin &org)
     : m_op_count(op_count),
     m_slow_op_count(slow_op_count),
     m_timing(timing),
     m_slow_timing(slow_timing),
-    m_start(std::chrono::steady_clock::now()),
-    m_slow_duration(duration)
+    m_fs(fs),
+    m_hop(hop),
+    m_org(org),
+    m_start(std::chrono::steady_clock::now())
 {}
 
 FileSystem::OpTimer::~OpTimer()
@@ -293,8 +555,9 @@ FileSystem::OpTimer::~OpTimer()
     auto dur = std::chrono::steady_clock::now() - m_start;
     m_op_count++;
     m_timing += std::chrono::nanoseconds(dur).count();
-    if (dur > m_slow_duration) {
+    if (dur > m_fs.m_slow_duration) {
         m_slow_op_count++;
         m_slow_timing += std::chrono::nanoseconds(dur).count();
     }
+    m_fs.Record(m_hop, dur, m_org);
 }
@@ -3,12 +3,14 @@
 #define __XRDOSSSTATS_FILESYSTEM_H
 
 #include "XrdOss/XrdOssWrapper.hh"
+#include "XrdOssStatsHistogram.hh"
 #include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysRAtomic.hh"
 
 #include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 class XrdXrootdGStream;
 
@@ -66,6 +68,46 @@ private:
     static void * AggregateBootstrap(void *instance);
     void AggregateStats();
 
+    // The operations that have a latency histogram; the order matches OpTiming.
+    enum HistOp {
+        HistOpen = 0,
+        HistRead,
+        HistReadV,
+        HistPgRead,
+        HistWrite,
+        HistPgWrite,
+        HistDirlist,
+        HistStat,
+        HistTruncate,
+        HistUnlink,
+        HistRename,
+        HistChmod,
+        HistCount,
+        HistNone = HistCount
+    };
+
+    // Where an operation came from: the path (if known), the client's trace
+    // identifier (if known), and the index of the configured path prefix it
+    // falls under (or -1).
+    struct OpOrigin {
+        const char *path{nullptr};
+        const char *user{nullptr};
+        int prefix{-1};
+    };
+
+    OpOrigin Origin(const char *path, XrdOucEnv *env) const;
+    int PrefixOf(const char *path) const;
+    void Record(HistOp hop, std::chrono::steady_clock::duration dur, const OpOrigin &org);
+
+    struct HistSet {
+        Histogram m_hist[HistCount];
+        std::vector<uint64_t> m_last;
+        std::string m_prefix;
+    };
+
+    void ReportHistograms(HistSet &hset);
+    void ReportTopK(std::chrono::steady_clock::duration period);
+
     XrdXrootdGStream* m_gstream{nullptr};
 
     // Indicates whether the class was able to initialize.
@@ -87,7 +129,7 @@ private:
 
     class OpTimer {
         public:
-            OpTimer(RAtomic_uint64_t &op_count, RAtomic_uint64_t &slow_op_count, RAtomic_uint64_t &timing, RAtomic_uint64_t &slow_timing, std::chrono::steady_clock::duration duration);
+            OpTimer(RAtomic_uint64_t &op_count, RAtomic_uint64_t &slow_op_count, RAtomic_uint64_t &timing, RAtomic_uint64_t &slow_timing, FileSystem &fs, HistOp hop, const OpOrigin &org);
             ~OpTimer();
 
         private:
@@ -95,8 +137,10 @@ private:
             RAtomic_uint64_t &m_slow_op_count;
             RAtomic_uint64_t &m_timing;
             RAtomic_uint64_t &m_slow_timing;
+            FileSystem &m_fs;
+            HistOp m_hop;
+            OpOrigin m_org;
             std::chrono::steady_clock::time_point m_start;
-            std::chrono::steady_clock::duration m_slow_duration;
     };
 
     struct OpRecord {
@@ -136,6 +180,17 @@ private:
     OpRecord m_slow_ops;
     OpTiming m_slow_times;
     std::chrono::steady_clock::duration m_slow_duration;
+
+    // Latency histograms, overall and per configured path prefix
+    bool m_hist_enabled{false};
+    HistSet m_hist;
+    std::vector<std::unique_ptr<HistSet>> m_prefix_hist;
+
+    // Heavy hitters among slow operations; null unless fsstats.topk is set
+    std::unique_ptr<TopK> m_top_files;
+    std::unique_ptr<TopK> m_top_users;
+    std::chrono::steady_clock::duration m_topk_min{-1};
+    std::chrono::steady_clock::duration m_topk_every{std::chrono::seconds(60)};
 };
 
 } // XrdOssStats
@@ -0,0 +1,156 @@
+#ifndef __XRDOSSSTATS_HISTOGRAM_H
+#define __XRDOSSSTATS_HISTOGRAM_H
+
+#include "XrdSys/XrdSysPthread.hh"
+#include "XrdSys/XrdSysRAtomic.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace XrdOssStats {
+
+// A lock-free, log-linear latency histogram.
+//
+// Every power of two between 1us and ~69s is split into four linear
+// sub-buckets, so a duration is never more than 25% away from the bounds
+// of its bucket.  Shorter durations share the first bucket and longer ones
+// the last.  Recording a duration is a single relaxed atomic increment; the
+// aggregation thread takes snapshots and diffs them to summarize an interval.
+class Histogram {
+public:
+    static constexpr int kSubBits = 2;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kMinShift = 10; // 1024ns
+    static constexpr int kMaxShift = 36; // ~68.7s
+    static constexpr int kBuckets = (kMaxShift - kMinShift) * kSub + 2;
+
+    Histogram() {for (auto &bucket : m_buckets) bucket = 0;}
+
+    static int Index(uint64_t ns) {
+        if (ns < (1ULL << kMinShift)) return 0;
+        int lg = 63 - __builtin_clzll(ns);
+        if (lg >= kMaxShift) return kBuckets - 1;
+        int sub = static_cast<int>(ns >> (lg - kSubBits)) & (kSub - 1);
+        return (lg - kMinShift) * kSub + sub + 1;
+    }
+
+    // The smallest duration, in nanoseconds, that is past the bucket.  The
+    // last bucket is open-ended and reports its lower bound instead.
+    static uint64_t UpperBound(int idx) {
+        if (idx <= 0) return 1ULL << kMinShift;
+        if (idx >= kBuckets - 1) return 1ULL << kMaxShift;
+        int lg = kMinShift + (idx - 1) / kSub;
+        uint64_t step = 1ULL << (lg - kSubBits);
+        return (1ULL << lg) + ((idx - 1) % kSub + 1) * step;
+    }
+
+    void Add(uint64_t ns) {m_buckets[Index(ns)]++;}
+
+    void Snapshot(uint64_t *counts) {
+        for (int idx = 0; idx < kBuckets; idx++) counts[idx] = m_buckets[idx];
+    }
+
+    struct Summary {
+        uint64_t count{0};
+        uint64_t p50{0};
+        uint64_t p90{0};
+        uint64_t p99{0};
+        uint64_t p999{0};
+        uint64_t max{0};
+    };
+
+    // Summarize a set of bucket counts (typically the difference of two
+    // snapshots).  Quantiles are reported as the upper bound of the bucket
+    // holding them.
+    static Summary Summarize(const uint64_t *counts) {
+        Summary result;
+        int last = -1;
+        for (int idx = 0; idx < kBuckets; idx++) {
+            if (counts[idx]) {
+                result.count += counts[idx];
+                last = idx;
+            }
+        }
+        if (!result.count) return result;
+        result.max = UpperBound(last);
+
+        const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+        uint64_t *values[] = {&result.p50, &result.p90, &result.p99, &result.p999};
+        uint64_t seen = 0;
+        int qidx = 0;
+        for (int idx = 0; idx <= last && qidx < 4; idx++) {
+            seen += counts[idx];
+            while (qidx < 4 && seen >= quantiles[qidx] * result.count) {
+                *values[qidx++] = UpperBound(idx);
+            }
+        }
+        return result;
+    }
+
+private:
+    RAtomic_uint64_t m_buckets[kBuckets];
+};
+
+// Tracks the keys (files or users) that accumulated the most time in slow
+// operations using the space-saving algorithm: at most K keys are kept and a
+// new key evicts the one with the least time, inheriting that time as its
+// error bound.  Updates take a mutex, so only slow operations are fed in.
+class TopK {
+public:
+    struct Entry {
+        std::string key;
+        uint64_t ns{0};    // Time attributed to the key
+        uint64_t error{0}; // Upper bound on the overcount in ns
+        uint64_t count{0}; // Operations seen since the key was admitted
+    };
+
+    explicit TopK(size_t k) : m_k(k) {m_entries.reserve(k);}
+
+    size_t Capacity() const {return m_k;}
+
+    void Add(const std::string &key, uint64_t ns) {
+        XrdSysMutexHelper lock(m_mutex);
+        Entry *min = nullptr;
+        for (auto &entry : m_entries) {
+            if (entry.key == key) {
+                entry.ns += ns;
+                entry.count++;
+                return;
+            }
+            if (!min || entry.ns < min->ns) min = &entry;
+        }
+        if (m_entries.size() < m_k) {
+            m_entries.push_back({key, ns, 0, 1});
+            return;
+        }
+        if (!min) return;
+        min->key = key;
+        min->error = min->ns;
+        min->ns += ns;
+        min->count = 1;
+    }
+
+    // Return the tracked keys, heaviest first, and start over.
+    std::vector<Entry> Drain() {
+        std::vector<Entry> result;
+        {
+            XrdSysMutexHelper lock(m_mutex);
+            result.swap(m_entries);
+            m_entries.reserve(m_k);
+        }
+        std::sort(result.begin(), result.end(),
+                  [](const Entry &a, const Entry &b) {return a.ns > b.ns;});
+        return result;
+    }
+
+private:
+    XrdSysMutex m_mutex;
+    size_t m_k;
+    std::vector<Entry> m_entries;
+};
+
+} // namespace XrdOssStats
+
+#endif // __XRDOSSSTATS_HISTOGRAM_H
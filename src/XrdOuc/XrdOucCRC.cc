@@ -199,20 +199,11 @@ uint32_t XrdOucCRC::Calc32C(const void* data, size_t count, uint32_t prevcs)
   
 void XrdOucCRC::Calc32C(const void* data, size_t count, uint32_t* csval)
 {
-   int i, numpages = count/XrdSys::PageSize;
-   const uint8_t* dataP = (const uint8_t*)data;
-
-// Calculate the CRC32C for each page
-//
-   for (i = 0; i < numpages; i++)
-       {csval[i] = crc32c(0, dataP, XrdSys::PageSize);
-        count -= XrdSys::PageSize;
-        dataP += XrdSys::PageSize;
-       }
+   static_assert(XrdSys::PageSize == 4096, "crc32c_pages() assumes 4K pages");
 
-// if there is anything left, calculate that as well
+// Calculate the CRC32C for each page, several at a time
 //
-   if (count > 0) csval[i] = crc32c(0, dataP, count);
+   crc32c_pages(data, count, csval);
 }
 
 /******************************************************************************/
@@ -236,33 +227,26 @@ bool XrdOucCRC::Ver32C(const void*    data,  size_t    count,
 int  XrdOucCRC::Ver32C(const void*     data,  size_t    count,
                        const uint32_t* csval, uint32_t& valcs)
 {
-   int i, numpages = count/XrdSys::PageSize;
+   static const int batch = 64;
    const uint8_t* dataP = (const uint8_t*)data;
-   uint32_t actualCS;
-
-// Calculate the CRC32C for each page and make sure it is the same.
-//
-   for (i = 0; i < numpages; i++)
-       {
-        actualCS = crc32c(0, dataP, XrdSys::PageSize);
-        if (csval[i] != actualCS)
-           {valcs = actualCS;
-            return i;
-           }
-        count -= XrdSys::PageSize;
-        dataP += XrdSys::PageSize;
-       }
+   uint32_t actualCS[batch];
+   int i, n, pgNum = 0;
 
-// if there is anything left, verify that as well
+// Calculate the CRC32C for a batch of pages at a time and make sure each one
+// is the same.
 //
-   if (count > 0)
-      {
-       actualCS = crc32c(0, dataP, count);
-       if (csval[i] != actualCS)
-          {valcs = actualCS;
-           return i;
-          }
-      }
+   while(count > 0)
+        {size_t blen = (count < (size_t)batch*XrdSys::PageSize
+                     ?  count : (size_t)batch*XrdSys::PageSize);
+         crc32c_pages(dataP, blen, actualCS);
+         n = (blen + XrdSys::PageSize - 1)/XrdSys::PageSize;
+         for (i = 0; i < n; i++)
+             if (csval[pgNum+i] != actualCS[i])
+                {valcs = actualCS[i];
+                 return pgNum+i;
+                }
+         pgNum += n; dataP += blen; count -= blen;
+        }
 
 // Everything matched.
 //
@@ -309,27 +293,13 @@ bool XrdOucCRC::Ver32C(const void*     data,  size_t count,
 bool XrdOucCRC::Ver32C(const void*     data,  size_t    count,
                        const uint32_t* csval, uint32_t* valcs)
 {
-   int i, numpages = count/XrdSys::PageSize;
-   const uint8_t* dataP = (const uint8_t*)data;
+   int i, numpages = (count + XrdSys::PageSize - 1)/XrdSys::PageSize;
    bool retval = true;
 
-// Calculate the CRC32C for each page and make sure it is the same.
+// Calculate the CRC32C for all the pages and make sure each one is the same.
 //
-   for (i = 0; i < numpages; i++)
-       {
-        valcs[i] = crc32c(0, dataP, XrdSys::PageSize);
-        if (csval[i] != valcs[i]) retval = false;
-        count -= XrdSys::PageSize;
-        dataP += XrdSys::PageSize;
-       }
-
-// if there is anything left, verify that as well
-//
-   if (count > 0)
-      {
-       valcs[i] = crc32c(0, dataP, count);
-       if (csval[i] != valcs[i]) retval = false;
-      }
+   crc32c_pages(data, count, valcs);
+   for (i = 0; i < numpages; i++) if (csval[i] != valcs[i]) retval = false;
 
 // All done.
 //
@@ -45,6 +45,9 @@
                      XrdOucCRC32C.hh with corresponding change to include
                      statement herein. Add required casts to allow C++
                      compilation.
+        17 Oct 2026  Check for SSE 4.2 only once. Add crc32c_pages() which
+                     computes the CRC-32C of each page of a buffer, three
+                     pages at a time when the hardware instruction is there.
  */
 
 #include <pthread.h>
@@ -265,11 +268,56 @@ static uint32_t crc32c_hw(uint32_t crc, void const *buf, size_t len) {
 
 /* Compute a CRC-32C.  If the crc32 instruction is available, use the hardware
    version.  Otherwise, use the software version. */
+static int crc32c_have_hw(void) {
+    static int const sse42 = [] { int have; SSE42(have); return have; }();
+    return sse42;
+}
+
 uint32_t crc32c(uint32_t crc, void const *buf, size_t len) {
-    int sse42;
-    
-    SSE42(sse42);
-    return sse42 ? crc32c_hw(crc, buf, len) : crc32c_sw(crc, buf, len);
+    return crc32c_have_hw() ? crc32c_hw(crc, buf, len)
+                            : crc32c_sw(crc, buf, len);
+}
+
+/* Page size for the page by page crc and the associated string constants for
+   use in constructing the assembler instructions. */
+#define PAGE 4096
+#define PAGEx1 "4096"
+#define PAGEx2 "8192"
+
+/* Compute the CRC-32C of each page using the Intel hardware instruction.
+   Three pages are done at a time using three independent crc instructions,
+   which covers the latency of the instruction as the LONG and SHORT loops
+   above do, but without having to shift and combine the partial crcs. */
+static void crc32c_hw_pages(void const *buf, size_t len, uint32_t *csvec) {
+    unsigned char const *next = (unsigned char const *)buf;
+
+    while (len >= PAGE*3) {
+        uint64_t crc0 = 0xffffffff;
+        uint64_t crc1 = 0xffffffff;
+        uint64_t crc2 = 0xffffffff;
+        unsigned char const * const end = next + PAGE;
+        do {
+            __asm__("crc32q\t" "(%3), %0\n\t"
+                    "crc32q\t" PAGEx1 "(%3), %1\n\t"
+                    "crc32q\t" PAGEx2 "(%3), %2"
+                    : "=r"(crc0), "=r"(crc1), "=r"(crc2)
+                    : "r"(next), "0"(crc0), "1"(crc1), "2"(crc2));
+            next += 8;
+        } while (next < end);
+        *csvec++ = ~(uint32_t)crc0;
+        *csvec++ = ~(uint32_t)crc1;
+        *csvec++ = ~(uint32_t)crc2;
+        next += PAGE*2;
+        len -= PAGE*3;
+    }
+
+    /* do the remaining pages, the last one possibly short, one at a time */
+    while (len) {
+        size_t n = len < PAGE ? len : PAGE;
+        *csvec++ = crc32c_hw(0, next, n);
+        next += n;
+        len -= n;
+    }
 }
 
 #else /* !__x86_64__ */
@@ -429,6 +477,24 @@ uint32_t crc32c_sw(uint32_t crc, void const *buf, size_t len) {
         return crc32c_sw_big(crc, buf, len);
 }
 
+/* Compute the CRC-32C of each 4096 byte page of buf[0..len-1], the last page
+   possibly being short, into csvec. */
+void crc32c_pages(void const *buf, size_t len, uint32_t *csvec) {
+#ifdef __x86_64__
+    if (crc32c_have_hw()) {
+        crc32c_hw_pages(buf, len, csvec);
+        return;
+    }
+#endif
+    unsigned char const *next = (unsigned char const *)buf;
+    while (len) {
+        size_t n = len < 4096 ? len : 4096;
+        *csvec++ = crc32c(0, next, n);
+        next += n;
+        len -= n;
+    }
+}
+
 #ifdef TEST
 
 #include <cstdio>
@@ -16,4 +16,9 @@ uint32_t crc32c(uint32_t crc, void const *buf, size_t len);
 // crc32c_sw() is the same, but does not use the hardware instruction, even if
 // available.
 uint32_t crc32c_sw(uint32_t crc, void const *buf, size_t len);
+
+// crc32c_pages() stores the CRC-32C of each 4096 byte page of buf[0..len-1]
+// into csvec, the last page possibly being short. csvec must have room for
+// (len+4095)/4096 values. Several pages are done at once when possible.
+void crc32c_pages(void const *buf, size_t len, uint32_t *csvec);
 #endif
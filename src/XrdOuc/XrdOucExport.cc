@@ -38,7 +38,7 @@
   
 /* Function: ParseDefs
 
-   Purpose:  Parse: defaults [[no]cache] [[no]check] [[no]dread]
+   Purpose:  Parse: defaults [[no]cache] [[no]check] [[no]dio] [[no]dread]
 
                              [[no]filter] [forcero]
 
@@ -46,9 +46,11 @@
                               
                              [[no]mig] [[not]migratable] [[no]mkeep]
 
-                             [[no]mlock] [[no]mmap] [outplace] [readonly]
+                             [[no]mlock] [[no]mmap] [[no]mmapsmall]
 
-                             [[no]stage] [stage+] [[no]rcreate]
+                             [outplace] [readonly]
+
+                             [[no]stage] [stage+] [[no]stream] [[no]rcreate]
 
                              [[not]writable] [[no]xattrs]
 
@@ -87,6 +89,8 @@ unsigned long long XrdOucExport::ParseDefs(XrdOucStream      &Config,
         {"mlock",         0,              XRDEXP_MLOK,    XRDEXP_MLOK_X},
         {"nommap",        XRDEXP_MMAP,    0,              XRDEXP_MMAP_X},
         {"mmap",          0,              XRDEXP_MMAP,    XRDEXP_MMAP_X},
+        {"nommapsmall",   XRDEXP_MSMALL,  0,              XRDEXP_MSMALL_X},
+        {"mmapsmall",     0,              XRDEXP_MSMALL,  XRDEXP_MSMALL_X},
         {"mwfiles",       0,              XRDEXP_MWMODE,  XRDEXP_MWMODE_X},
         {"nopurge",       XRDEXP_PURGE,   0,              XRDEXP_PURGE_X},
         {"purge",         0,              XRDEXP_PURGE,   XRDEXP_PURGE_X},
@@ -107,7 +111,11 @@ unsigned long long XrdOucExport::ParseDefs(XrdOucStream      &Config,
         {"xattrs",        XRDEXP_NOXATTR, 0,              XRDEXP_NOXATTR_X},
         {"noxattrs",      0,              XRDEXP_NOXATTR, XRDEXP_NOXATTR_X},
         {"noficl",        0,              XRDEXP_NOFICL,  XRDEXP_NOFICL_X},
-        {"ficl",          XRDEXP_NOFICL,  0,              XRDEXP_NOFICL_X}
+        {"ficl",          XRDEXP_NOFICL,  0,              XRDEXP_NOFICL_X},
+        {"nodio",         XRDEXP_DIO,     0,              XRDEXP_DIO_X},
+        {"dio",           0,              XRDEXP_DIO,     XRDEXP_DIO_X},
+        {"nostream",      XRDEXP_STREAM,  0,              XRDEXP_STREAM_X},
+        {"stream",        0,              XRDEXP_STREAM,  XRDEXP_STREAM_X}
        };
     int i, numopts = sizeof(rpopts)/sizeof(struct rpathopts);
     char *val;
@@ -146,6 +154,7 @@ unsigned long long XrdOucExport::ParseDefs(XrdOucStream      &Config,
              <options> a blank separated list of options:
                        [no]cache    - is [not] file caching
                        [no]check    - [don't] check if new file exists in MSS
+                       [no]dio      - [don't] read files with direct I/O
                        [no]dread    - [don't] read actual directory contents
                            forcero  - force r/w opens to r/o opens
                            inplace  - do not use extended cache for creation
@@ -157,10 +166,14 @@ unsigned long long XrdOucExport::ParseDefs(XrdOucStream      &Config,
                        [no]mkeep    - this is [not] a memory keepable name space
                        [no]mlock    - this is [not] a memory lockable name space
                        [no]mmap     - this is [not] a memory mappable name space
+                       [no]mmapsmall- [don't] memory map files no larger than
+                                      the oss.memfile small size
                        [no]rcreate  - [don't] create file in MSS as well
                            r/o      - do not allow modifications (read/only)
                            r/w      - path is writable/modifiable
                        [no]stage    - [don't] stage in files.
+                       [no]stream   - [don't] manage the page cache for
+                                      sequentially read files.
 
    Output: XrdOucPList object upon success or 0 upon failure.
 */
@@ -193,7 +206,7 @@ XrdOucPList *XrdOucExport::ParsePath(XrdOucStream &Config, XrdSysError &Eroute,
 // Make sure that we have no conflicting options
 //
    if ((rpval & XRDEXP_MEMAP) && !(rpval & XRDEXP_NOTRW))
-      {Eroute.Emsg("config", "warning, file memory mapping forced path", path,
+      {Eroute.Emsg("config", "warning, file memory mapping forced path", pbuff,
                              "to be readonly");
        rpval |= XRDEXP_FORCERO;
       }
@@ -75,19 +75,24 @@
 #define XRDEXP_GLBLRO_X   0x0018000000000000LL
 #define XRDEXP_STAGEMM    0x0000000000200020LL
 //                        0x0020000000000000LL
-//                        0x0040000000400000LL
+#define XRDEXP_MSMALL     0x0000000000400000LL
+#define XRDEXP_MSMALL_X   0x0040000000000000LL
 //                        0x0080000000800000LL
-#define XRDEXP_AVAILABLE  0xff000000ff000000LL
+#define XRDEXP_AVAILABLE  0xf0000000f0000000LL
 #define XRDEXP_MASKSHIFT  32
 #define XRDEXP_SETTINGS   0x00000000ffffffffLL
 
-#define XRDEXP_MEMAP      0x0000000000003800LL
+#define XRDEXP_MEMAP      0x0000000000403800LL
 #define XRDEXP_REMOTE     0x0000000000000420LL
 #define XRDEXP_MIGPRG     0x0000000000004400LL
 
 #define XRDEXP_ROOTDIR    0x0000000001000000LL
 #define XRDEXP_NOFICL     0x0000000002000000LL
 #define XRDEXP_NOFICL_X   0x0200000000000000LL
+#define XRDEXP_DIO        0x0000000004000000LL
+#define XRDEXP_DIO_X      0x0400000000000000LL
+#define XRDEXP_STREAM     0x0000000008000000LL
+#define XRDEXP_STREAM_X   0x0800000000000000LL
 
 
 // The following options are prescreened elsewhere
@@ -52,6 +52,7 @@
 
 #include "XrdNet/XrdNetSecurity.hh"
 #include "XrdPss/XrdPss.hh"
+#include "XrdPss/XrdPssReader.hh"
 #include "XrdPss/XrdPssTrace.hh"
 #include "XrdPss/XrdPssUrlInfo.hh"
 #include "XrdPss/XrdPssUtils.hh"
@@ -609,7 +610,21 @@ int XrdPssSys::Stat(const char *path, struct stat *buff, int Opts, XrdOucEnv *eP
 */
 int XrdPssSys::Stats(char *bp, int bl)
 {
-   return XrdPosixConfig::Stats("pss", bp, bl);
+   int n;
+
+// If the maximum length is wanted, return the sum of both
+//
+   if (!bl) return XrdPosixConfig::Stats("pss", bp, bl)
+                 + (XrdPssReader::Enabled() ? XrdPssReader::Stats(bp, 0) : 0);
+
+// Append the reader statistics if it is being used
+//
+   n = XrdPosixConfig::Stats("pss", bp, bl);
+   if (XrdPssReader::Enabled() && n >= 0 && n < bl)
+      {int k = XrdPssReader::Stats(bp+n, bl-n);
+       if (k > 0 && k < bl-n) n += k;
+      }
+   return n;
 }
 
 /******************************************************************************/
@@ -1003,6 +1018,11 @@ int XrdPssFile::Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &Env)
           }
       }
 
+// Reads of files opened read-only go through the reader if enabled
+//
+   if (!rwMode && XrdPssReader::Enabled())
+      rdAgg = new XrdPssReader(fd);
+
 // All done
 //
    return XrdOssOK;
@@ -1035,6 +1055,10 @@ int XrdPssFile::Close(long long *retsz)
         return XrdOssOK;
        }
 
+// Detach the reader, if any, so it no longer uses the file descriptor
+//
+    if (rdAgg) {rdAgg->Detach(); rdAgg = 0;}
+
 // Close the file
 //
     rc = XrdPosixXrootd::Close(fd);
@@ -1229,6 +1253,12 @@ ssize_t XrdPssFile::Read(void *buff, off_t offset, size_t blen)
 
      if (fd < 0) return (ssize_t)-XRDOSS_E8004;
 
+     if (rdAgg)
+        {if ((retval = rdAgg->Read(buff, offset, blen)) < 0)
+            lastEtrc = XrdPosixXrootd::QueryError(lastEtext, fd);
+         return retval;
+        }
+
      if ((retval = XrdPosixXrootd::Pread(fd, buff, blen, offset)) < 0)
         {int rc = -errno;
          lastEtrc = XrdPosixXrootd::QueryError(lastEtext, fd);
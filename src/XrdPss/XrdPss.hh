@@ -44,6 +44,8 @@
 #include "XrdOuc/XrdOucSid.hh"
 #include "XrdOss/XrdOss.hh"
 
+class XrdPssReader;
+
 /******************************************************************************/
 /*                             X r d P s s D i r                              */
 /******************************************************************************/
@@ -117,7 +119,8 @@ int     Write(XrdSfsAio *aiop) override;
          // Constructor and destructor
          XrdPssFile(const char *tid)
                    : XrdOssDF(tid, XrdOssDF::DF_isFile|XrdOssDF::DF_isProxy),
-                     rpInfo(0), tpcPath(0), entity(0), lastEtrc(0) {}
+                     rpInfo(0), tpcPath(0), entity(0), rdAgg(0),
+                     lastEtrc(0) {}
 
 virtual ~XrdPssFile() {if (fd >= 0) Close();
                        if (rpInfo) delete(rpInfo);
@@ -140,6 +143,7 @@ struct tprInfo
 
       char         *tpcPath;
 const XrdSecEntity *entity;
+XrdPssReader       *rdAgg;
 std::string         lastEtext;
 int                 lastEtrc;
 };
@@ -248,5 +252,6 @@ int    xexp( XrdSysError *Eroute, XrdOucStream &Config);
 int    xperm(XrdSysError *errp,   XrdOucStream &Config);
 int    xpers(XrdSysError *errp,   XrdOucStream &Config);
 int    xorig(XrdSysError *errp,   XrdOucStream &Config);
+int    xragg(XrdSysError *errp,   XrdOucStream &Config);
 };
 #endif
@@ -36,6 +36,7 @@
 #include "XrdPosix/XrdPosixXrootd.hh"
 #include "XrdPss/XrdPss.hh"
 #include "XrdPss/XrdPssAioCB.hh"
+#include "XrdPss/XrdPssReader.hh"
 #include "XrdSfs/XrdSfsAio.hh"
 
 // All AIO interfaces are defined here.
@@ -165,6 +166,10 @@ int XrdPssFile::pgWrite(XrdSfsAio *aiop, uint64_t opts)
 int XrdPssFile::Read(XrdSfsAio *aiop)
 {
 
+// If reads are aggregated, let the reader handle it
+//
+   if (rdAgg) {rdAgg->Read(aiop); return 0;}
+
 // Execute this request in an asynchronous fashion
 //
    XrdPosixXrootd::Pread(fd, (void *)aiop->sfsAio.aio_buf,
@@ -40,11 +40,14 @@
 
 #include "XrdVersion.hh"
 
+#include "XProtocol/XProtocol.hh"
+
 #include "XrdNet/XrdNetAddr.hh"
 #include "XrdNet/XrdNetUtils.hh"
 #include "XrdNet/XrdNetSecurity.hh"
 
 #include "XrdPss/XrdPss.hh"
+#include "XrdPss/XrdPssReader.hh"
 #include "XrdPss/XrdPssTrace.hh"
 #include "XrdPss/XrdPssUrlInfo.hh"
 #include "XrdPss/XrdPssUtils.hh"
@@ -148,6 +151,10 @@ XrdOucPsx *psxConfig;
 XrdSecsssID::authType sssMap;      // persona setting
 
 std::vector<const char *> protVec;    // Additional wanted protocols
+
+int  raggHeld  = 0;                   // pss.readagg coalesce
+int  raggMerge = 0;                   // pss.readagg merge
+int  raggRASz  = 0;                   // pss.readagg readahead
 }
 
 using namespace XrdProxy;
@@ -246,6 +253,22 @@ int XrdPssSys::Configure(const char *cfn, XrdOucEnv *envP)
 //
    if(psxConfig->hasCache()) myFeatures |= XRDOSS_HASCACH;
 
+// Read aggregation is pointless when a cache does it for us. Reads can only be
+// coalesced into vector reads when the origin speaks the xroot protocol.
+//
+   if (raggHeld || raggRASz)
+      {if (psxConfig->hasCache())
+          {eDest.Say("Config warning: ignoring 'pss.readagg'; "
+                     "a cache is configured!");
+           raggHeld = raggRASz = 0;
+          } else if (raggHeld && !xrdProxy)
+          {eDest.Say("Config warning: disabling 'pss.readagg coalesce'; "
+                     "origin is not xroot!");
+           raggHeld = 0;
+          }
+       XrdPssReader::SetOpts(raggHeld, raggMerge, raggRASz);
+      }
+
 // If we need to reproxy, then open the directory where the reproxy information
 // will ne placed. The path is in the Env.
 //
@@ -516,6 +539,7 @@ int XrdPssSys::ConfigXeq(char *var, XrdOucStream &Config)
    TS_Xeq("origin",        xorig);
    TS_Xeq("permit",        xperm);
    TS_Xeq("persona",       xpers);
+   TS_Xeq("readagg",       xragg);
    TS_PSX("setopt",        ParseSet);
    TS_PSX("trace",         ParseTrace);
 
@@ -967,3 +991,80 @@ int XrdPssSys::xpers(XrdSysError *Eroute, XrdOucStream &Config)
 //
     return 0;
 }
+  
+/******************************************************************************/
+/*                                 x r a g g                                  */
+/******************************************************************************/
+
+/* Function: xragg
+
+   Purpose:  To parse the directive: readagg [coalesce {<n> | off}]
+                                             [merge <sz>]
+                                             [readahead {<sz> | off}]
+
+             coalesce  once <n> upstream reads of a file are in flight, hold
+                       further reads and send them as one vector read when
+                       one completes. The default is 2.
+             merge     the largest read that is held, the default is 256k.
+             readahead the size of each read-ahead block used for sequential
+                       reads; two are allocated per file. The default is 2m.
+
+   Output: 0 upon success or 1 upon failure.
+*/
+
+int XrdPssSys::xragg(XrdSysError *errp, XrdOucStream &Config)
+{
+    static const long long maxsz = 0x40000000LL;
+    long long llval;
+    char *val;
+    int  ival;
+
+// Preset the defaults
+//
+   raggHeld  = 2;
+   raggMerge = 256*1024;
+   raggRASz  = 2*1024*1024;
+
+// Process the options
+//
+   while((val = Config.GetWord()))
+        {     if (!strcmp(val, "coalesce"))
+                 {if (!(val = Config.GetWord()))
+                     {errp->Emsg("Config", "readagg coalesce value not "
+                                           "specified");
+                      return 1;
+                     }
+                  if (!strcmp(val, "off")) raggHeld = 0;
+                     else {if (XrdOuca2x::a2i(*errp, "readagg coalesce", val,
+                                              &ival, 1, 64)) return 1;
+                           raggHeld = ival;
+                          }
+                 }
+         else if (!strcmp(val, "merge"))
+                 {if (!(val = Config.GetWord()))
+                     {errp->Emsg("Config", "readagg merge value not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2sz(*errp, "readagg merge", val, &llval,
+                                      1, XrdProto::maxRVdsz)) return 1;
+                  raggMerge = static_cast<int>(llval);
+                 }
+         else if (!strcmp(val, "readahead"))
+                 {if (!(val = Config.GetWord()))
+                     {errp->Emsg("Config", "readagg readahead value not "
+                                           "specified");
+                      return 1;
+                     }
+                  if (!strcmp(val, "off")) raggRASz = 0;
+                     else {if (XrdOuca2x::a2sz(*errp, "readagg readahead", val,
+                                               &llval, 4096, maxsz)) return 1;
+                           raggRASz = static_cast<int>(llval);
+                          }
+                 }
+         else {errp->Emsg("Config","invalid readagg option -", val); return 1;}
+        }
+
+// All done
+//
+   return 0;
+}
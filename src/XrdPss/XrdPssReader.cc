@@ -0,0 +1,663 @@
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d P s s R e a d e r . c c                        */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "XProtocol/XProtocol.hh"
+#include "XrdOuc/XrdOucIOVec.hh"
+#include "XrdPosix/XrdPosixCallBack.hh"
+#include "XrdPosix/XrdPosixXrootd.hh"
+#include "XrdPss/XrdPssReader.hh"
+#include "XrdSfs/XrdSfsAio.hh"
+#include "XrdSys/XrdSysRAtomic.hh"
+
+/******************************************************************************/
+/*                         L o c a l   O b j e c t s                          */
+/******************************************************************************/
+
+namespace
+{
+struct
+{
+RAtomic_llong Reads;      // Reads received from clients
+RAtomic_llong Upstream;   // Requests sent to the origin
+RAtomic_llong VecReads;   // Vector reads among them
+RAtomic_llong Merged;     // Client reads carried by those vector reads
+RAtomic_llong Retried;    // Client reads reissued after a vector read failed
+                          // or came up short
+RAtomic_llong raFills;    // Read-ahead blocks requested
+RAtomic_llong raHits;     // Client reads served from read-ahead blocks
+}   rdStats;
+
+// The origin that reads through the proxied file
+//
+class PosixOrigin : public XrdPssReaderOrigin
+{
+public:
+
+void Pread(int fd, void *buff, size_t blen, off_t offset,
+           XrdPosixCallBackIO *cbp) override
+          {XrdPosixXrootd::Pread(fd, buff, blen, offset, cbp);}
+
+void VRead(int fd, const XrdOucIOVec *readV, int n,
+           XrdPosixCallBackIO *cbp) override
+          {XrdPosixXrootd::VRead(fd, readV, n, cbp);}
+};
+
+PosixOrigin posixOrigin;
+}
+
+/******************************************************************************/
+/*                        S t a t i c   M e m b e r s                         */
+/******************************************************************************/
+
+int XrdPssReader::maxHeld  = 0;
+int XrdPssReader::maxMerge = 0;
+int XrdPssReader::raSize   = 0;
+
+/******************************************************************************/
+/*                         L o c a l   C l a s s e s                          */
+/******************************************************************************/
+
+struct XrdPssReader::rdReq
+{
+rdReq           *next;
+char            *buff;
+long long        offset;
+int              size;
+int              got;      // Bytes already placed in buff
+bool             filler;   // Read that started a read-ahead fill
+ssize_t          result;
+XrdSfsAio       *aiop;     // Async request or...
+XrdSysSemaphore *sem;      // ...synchronous one
+};
+
+class XrdPssReader::upReq : public XrdPosixCallBackIO
+{
+public:
+
+enum Kind {isSingle = 0, isVector, isFill};
+
+void Complete(ssize_t result) override
+            {if (result < 0) result = (errno ? -errno : -EIO);
+             reader->Done(this, result);
+            }
+
+     upReq(XrdPssReader *rP, Kind what, rdReq *reqs, raBlk *bP=0)
+          : next(0), reader(rP), kind(what), rdList(reqs), blk(bP) {}
+    ~upReq() {}
+
+// Bytes asked for by a vector read
+//
+long long Bytes()
+         {long long n = 0;
+          for (auto &v : ioV) n += v.size;
+          return n;
+         }
+
+upReq                   *next;
+XrdPssReader            *reader;
+Kind                     kind;
+rdReq                   *rdList;
+raBlk                   *blk;
+std::vector<XrdOucIOVec> ioV;
+};
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdPssReader::XrdPssReader(int fd, XrdPssReaderOrigin *orig)
+             : rdCV(0), origin(orig ? orig : &posixOrigin), heldFirst(0),
+               heldLast(0), lastEnd(-1), fileFD(fd), numRefs(1), numFlight(0),
+               numIssuing(0), seqCount(0), isDetached(false)
+{
+   memset(raBlock, 0, sizeof(raBlock));
+}
+
+/******************************************************************************/
+/*                            D e s t r u c t o r                             */
+/******************************************************************************/
+
+XrdPssReader::~XrdPssReader()
+{
+   if (raBlock[0].buff) free(raBlock[0].buff);
+   if (raBlock[1].buff) free(raBlock[1].buff);
+}
+
+/******************************************************************************/
+/*                                D e t a c h                                 */
+/******************************************************************************/
+
+void XrdPssReader::Detach()
+{
+   rdReq *rP, *fail;
+   bool doDel;
+
+// Make sure no one is issuing a request using our file descriptor as it is
+// about to be closed. Afterwards no new requests will be issued.
+//
+   rdCV.Lock();
+   isDetached = true;
+   while(numIssuing) rdCV.Wait();
+
+// There should be no held reads as the file is closed only when all reads
+// have completed. If there are, they must fail.
+//
+   fail = heldFirst; heldFirst = heldLast = 0;
+   doDel = (--numRefs == 0);
+   rdCV.UnLock();
+
+   while((rP = fail)) {fail = rP->next; Complete(rP, -EBADF);}
+   if (doDel) delete this;
+}
+
+/******************************************************************************/
+/*                                  R e a d                                   */
+/******************************************************************************/
+
+void XrdPssReader::Read(XrdSfsAio *aiop)
+{
+   rdReq *rP = new rdReq;
+
+   rP->buff   = (char *)aiop->sfsAio.aio_buf;
+   rP->offset = (long long)aiop->sfsAio.aio_offset;
+   rP->size   = (int)aiop->sfsAio.aio_nbytes;
+   rP->got    = 0;
+   rP->filler = false;
+   rP->aiop   = aiop;
+   rP->sem    = 0;
+   Submit(rP);
+}
+
+/******************************************************************************/
+
+ssize_t XrdPssReader::Read(void *buff, off_t offset, size_t blen)
+{
+   XrdSysSemaphore rdSem(0);
+   rdReq myReq;
+
+   myReq.buff   = (char *)buff;
+   myReq.offset = (long long)offset;
+   myReq.size   = (int)blen;
+   myReq.got    = 0;
+   myReq.filler = false;
+   myReq.aiop   = 0;
+   myReq.sem    = &rdSem;
+   Submit(&myReq);
+   rdSem.Wait();
+   return myReq.result;
+}
+
+/******************************************************************************/
+/*                               S e t O p t s                                */
+/******************************************************************************/
+
+void XrdPssReader::SetOpts(int held, int mrgsz, int rasz)
+{
+   maxHeld  = held;
+   maxMerge = (mrgsz > XrdProto::maxRVdsz ? XrdProto::maxRVdsz : mrgsz);
+   raSize   = rasz;
+}
+
+/******************************************************************************/
+/*                                 S t a t s                                  */
+/******************************************************************************/
+
+int XrdPssReader::Stats(char *buff, int blen)
+{
+   static const char statfmt[] = "<stats id=\"pssrd\">"
+          "<rd>%lld</rd><up>%lld</up><saved>%lld</saved>"
+          "<rdv>%lld<merged>%lld</merged><retried>%lld</retried></rdv>"
+          "<ra><fills>%lld</fills><hits>%lld</hits></ra>"
+          "</stats>";
+   long long reads, upstream, saved;
+
+// If the caller wants the maximum length, then provide it
+//
+   if (!blen) return sizeof(statfmt) + (8 * 20);
+
+// Compute the number of requests that did not have to go to the origin
+//
+   reads    = rdStats.Reads;
+   upstream = rdStats.Upstream;
+   saved    = (reads > upstream ? reads - upstream : 0);
+
+// Format the statistics
+//
+   int n = snprintf(buff, blen, statfmt, reads, upstream, saved,
+                   static_cast<long long>(rdStats.VecReads),
+                   static_cast<long long>(rdStats.Merged),
+                   static_cast<long long>(rdStats.Retried),
+                   static_cast<long long>(rdStats.raFills),
+                   static_cast<long long>(rdStats.raHits));
+   return (n < blen ? n : 0);
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                 A h e a d                                  */
+/******************************************************************************/
+
+// The lock must be held upon entry. Once half of a block has been consumed
+// the other block is filled with what follows it.
+
+void XrdPssReader::Ahead(raBlk &blk, long long endOff, upReq *&issue)
+{
+   raBlk &other = raBlock[&blk == raBlock ? 1 : 0];
+   long long next = blk.offset + blk.len;
+
+   if (isDetached || blk.state != raBlk::Ready || blk.len < blk.want
+   ||  (endOff - blk.offset) * 2 < blk.len) return;
+
+   if (other.state == raBlk::Filling
+   || (other.state == raBlk::Ready && other.offset == next)) return;
+
+   Fill(other, next, 0, issue);
+}
+
+/******************************************************************************/
+/*                              C o m p l e t e                               */
+/******************************************************************************/
+
+// The lock must not be held as completing the request may start another one.
+
+void XrdPssReader::Complete(rdReq *rP, ssize_t result)
+{
+   if (rP->aiop)
+      {rP->aiop->Result = result;
+       rP->aiop->doneRead();
+       delete rP;
+      } else {
+       rP->result = result;
+       rP->sem->Post();
+      }
+}
+
+/******************************************************************************/
+/*                                  D o n e                                   */
+/******************************************************************************/
+
+void XrdPssReader::Done(upReq *uP, ssize_t result)
+{
+   upReq *issue = 0;
+   rdReq *rP, *done = 0, *fail = 0, *retry = uP->rdList;
+   long long endOff = -1;
+   bool doDel;
+
+   rdCV.Lock();
+   numFlight--;
+   numRefs--;
+
+// Set the result of each read carried by the request. Should the request
+// have failed, each read is retried on its own so that it gets its own result.
+// A vector read that returned fewer bytes than asked for is retried as well
+// since we cannot tell which of the reads came up short.
+//
+   switch(uP->kind)
+         {case upReq::isSingle:
+               if (result >= 0) {rP = retry; rP->result = rP->got + result;}
+                  else retry->result = result;
+               done = retry; retry = 0;
+               break;
+          case upReq::isVector:
+               if (result >= 0 && result == uP->Bytes())
+                  {for (rP = retry; rP; rP = rP->next) rP->result = rP->size;
+                   done = retry; retry = 0;
+                  } else {
+                   for (rP = retry; rP; rP = rP->next) rdStats.Retried++;
+                  }
+               break;
+          case upReq::isFill:
+               raBlk &blk = *(uP->blk);
+               retry = blk.waiters; blk.waiters = 0;
+               if (result < 0) {blk.state = raBlk::Empty; break;}
+               blk.len = result; blk.state = raBlk::Ready;
+               while((rP = retry))
+                    {retry = rP->next;
+                     Serve(blk, rP);
+                     if (rP->got && !rP->filler) rdStats.raHits++;
+                     rP->result = rP->got;
+                     rP->next = done; done = rP;
+                     if (rP->offset + rP->size > endOff)
+                        endOff = rP->offset + rP->size;
+                    }
+               if (endOff >= 0) Ahead(blk, endOff, issue);
+               break;
+         }
+
+// Reissue whatever must be retried unless the file is going away
+//
+   while((rP = retry))
+        {retry = rP->next;
+         if (isDetached) {rP->next = fail; fail = rP;}
+            else Single(rP, issue);
+        }
+
+// Send off any held reads now that a request completed
+//
+   Drain(issue, fail);
+   if (issue) numIssuing++;
+   doDel = (!numRefs && !numIssuing);
+   rdCV.UnLock();
+   delete uP;
+
+// Complete all of the finished reads
+//
+   while((rP = done)) {done = rP->next; Complete(rP, rP->result);}
+   while((rP = fail)) {fail = rP->next; Complete(rP, -EBADF);}
+
+// Issue any new requests or delete ourselves if we are no longer needed
+//
+   if (issue) Issue(issue);
+      else if (doDel) delete this;
+}
+
+/******************************************************************************/
+/*                                 D r a i n                                  */
+/******************************************************************************/
+
+// The lock must be held upon entry. Held reads are sent as vector reads as
+// long as we stay within the number of reads in flight.
+
+void XrdPssReader::Drain(upReq *&issue, rdReq *&fail)
+{
+   rdReq *rP, *pP;
+   upReq *uP;
+   int n, bytes;
+
+   while(heldFirst)
+        {if (isDetached)
+            {heldLast->next = fail; fail = heldFirst;
+             heldFirst = heldLast = 0;
+             break;
+            }
+         if (numFlight >= maxHeld) break;
+
+     // Take as many reads as fit into a single vector read. Held reads are
+     // never larger than one, so at least the first one is taken.
+     //
+         pP = heldFirst; n = 1; bytes = pP->size - pP->got;
+         while((rP = pP->next) && n < XrdProto::maxRvecsz
+         &&    bytes + (rP->size - rP->got) <= XrdProto::maxRVdsz)
+              {bytes += rP->size - rP->got; n++;
+               pP = rP;
+              }
+         rP = heldFirst;
+         if (!(heldFirst = pP->next)) heldLast = 0;
+         pP->next = 0;
+
+     // A lone read is sent as is
+     //
+         if (n == 1) {Single(rP, issue); continue;}
+
+     // Construct the vector read
+     //
+         uP = new upReq(this, upReq::isVector, rP);
+         uP->ioV.reserve(n);
+         for (; rP; rP = rP->next)
+             {XrdOucIOVec ioV = {rP->offset + rP->got, rP->size - rP->got,
+                                 0, rP->buff + rP->got};
+              uP->ioV.push_back(ioV);
+             }
+         uP->next = issue; issue = uP;
+         numFlight++; numRefs++;
+         rdStats.Upstream++; rdStats.VecReads++; rdStats.Merged += n;
+        }
+}
+
+/******************************************************************************/
+/*                                  F i l l                                   */
+/******************************************************************************/
+
+// The lock must be held upon entry. The read, if any, is served by the fill.
+
+void XrdPssReader::Fill(raBlk &blk, long long offset, rdReq *rP,
+                        upReq *&issue)
+{
+   upReq *uP;
+
+// Allocate the buffer the first time around
+//
+   if (!blk.buff && !(blk.buff = (char *)malloc(raSize)))
+      {if (rP) Single(rP, issue);
+       return;
+      }
+
+// Set up the block and its request
+//
+   blk.offset  = offset;
+   blk.want    = raSize;
+   blk.len     = 0;
+   blk.state   = raBlk::Filling;
+   blk.waiters = rP;
+   if (rP) {rP->next = 0; rP->filler = true;}
+
+   uP = new upReq(this, upReq::isFill, 0, &blk);
+   uP->next = issue; issue = uP;
+   numFlight++; numRefs++;
+   rdStats.Upstream++; rdStats.raFills++;
+}
+
+/******************************************************************************/
+/*                                  F i n d                                   */
+/******************************************************************************/
+
+// The lock must be held upon entry. Returns the block holding the start of
+// the read; a block being filled must hold all of it.
+
+XrdPssReader::raBlk *XrdPssReader::Find(long long offset, int size)
+{
+   for (int i = 0; i < 2; i++)
+       {raBlk &blk = raBlock[i];
+        if (offset < blk.offset) continue;
+        if (blk.state == raBlk::Ready)
+           {int span = (blk.len < blk.want ? blk.want : blk.len);
+            if (offset < blk.offset + span) return &blk;
+           }
+        else if (blk.state == raBlk::Filling
+             &&  offset + size <= blk.offset + blk.want) return &blk;
+       }
+   return 0;
+}
+
+/******************************************************************************/
+/*                                 I s s u e                                  */
+/******************************************************************************/
+
+// The lock must not be held. The caller must have counted us as issuing.
+
+void XrdPssReader::Issue(upReq *issue)
+{
+   upReq *uP;
+   bool doDel;
+
+// Send off each request. Note that the request may complete, and be deleted,
+// before the call returns.
+//
+   while((uP = issue))
+        {issue = uP->next;
+         switch(uP->kind)
+               {case upReq::isSingle:
+                     {rdReq *rP = uP->rdList;
+                      origin->Pread(fileFD, rP->buff + rP->got,
+                                    rP->size - rP->got,
+                                    rP->offset + rP->got, uP);
+                     }
+                     break;
+                case upReq::isVector:
+                     origin->VRead(fileFD, uP->ioV.data(),
+                                   (int)uP->ioV.size(), uP);
+                     break;
+                case upReq::isFill:
+                     origin->Pread(fileFD, uP->blk->buff,
+                                   uP->blk->want, uP->blk->offset, uP);
+                     break;
+               }
+        }
+
+// We are no longer using the file descriptor
+//
+   rdCV.Lock();
+   numIssuing--;
+   if (isDetached && !numIssuing) rdCV.Broadcast();
+   doDel = (!numRefs && !numIssuing);
+   rdCV.UnLock();
+   if (doDel) delete this;
+}
+
+/******************************************************************************/
+/*                                 S e r v e                                  */
+/******************************************************************************/
+
+// The lock must be held upon entry. Copies what the block holds of the read
+// and returns true if nothing more can be had, either because the read is
+// complete or because the block ends at the end of the file.
+
+int XrdPssReader::Serve(raBlk &blk, rdReq *rP)
+{
+   long long start = rP->offset + rP->got;
+   long long avail = blk.offset + blk.len - start;
+   int n = rP->size - rP->got;
+
+   if (avail < n) n = (avail > 0 ? (int)avail : 0);
+   if (n) memcpy(rP->buff + rP->got, blk.buff + (start - blk.offset), n);
+   rP->got += n;
+   return rP->got >= rP->size || blk.len < blk.want;
+}
+
+/******************************************************************************/
+/*                                S i n g l e                                 */
+/******************************************************************************/
+
+// The lock must be held upon entry.
+
+void XrdPssReader::Single(rdReq *rP, upReq *&issue)
+{
+   upReq *uP = new upReq(this, upReq::isSingle, rP);
+
+   rP->next = 0;
+   uP->next = issue; issue = uP;
+   numFlight++; numRefs++;
+   rdStats.Upstream++;
+}
+
+/******************************************************************************/
+/*                                S u b m i t                                 */
+/******************************************************************************/
+
+void XrdPssReader::Submit(rdReq *rP)
+{
+   upReq *issue = 0;
+   raBlk *bP;
+   bool   isDone = false;
+
+   rdStats.Reads++;
+   rdCV.Lock();
+   if (isDetached) {rdCV.UnLock(); Complete(rP, -EBADF); return;}
+
+// Track sequential access
+//
+   if (rP->offset == lastEnd) seqCount++;
+      else seqCount = 0;
+   lastEnd = rP->offset + rP->size;
+
+// Check if the read can be served from a read-ahead block
+//
+   if (raSize && rP->size <= raSize/2)
+      {if ((bP = Find(rP->offset, rP->size)))
+          {raBlk &other = raBlock[bP == raBlock ? 1 : 0];
+           if (bP->state == raBlk::Filling)
+              {rP->next = bP->waiters; bP->waiters = rP;
+               rdCV.UnLock();
+               return;
+              }
+
+       // Copy out what we have. The rest may follow in the other block,
+       // otherwise it is read on its own.
+       //
+           if (!(isDone = Serve(*bP, rP)))
+              {if (other.offset == bP->offset + bP->len
+               &&  other.state  == raBlk::Ready) isDone = Serve(other, rP);
+                  else if (other.offset == bP->offset + bP->len
+                       &&  other.state  == raBlk::Filling
+                       &&  lastEnd <= other.offset + other.want)
+                          {rP->next = other.waiters; other.waiters = rP;
+                           rP = 0;
+                          }
+               if (rP && !isDone) Single(rP, issue);
+              }
+           if (isDone && rP->got) rdStats.raHits++;
+           Ahead(*bP, lastEnd, issue);
+          }
+
+   // Start reading ahead once the access looks sequential. The block is
+   // filled starting with this read so it is not sent separately. Prefer
+   // an empty block and otherwise replace the one with the lower offset.
+   //
+       else if (seqCount >= 2)
+               {raBlk *fP = 0;
+                for (int i = 0; i < 2; i++)
+                    {raBlk &blk = raBlock[i];
+                     if (blk.state == raBlk::Filling) continue;
+                     if (!fP || blk.state == raBlk::Empty
+                     ||  (fP->state == raBlk::Ready && blk.offset < fP->offset))
+                        fP = &blk;
+                    }
+                if (fP) Fill(*fP, rP->offset, rP, issue);
+                   else Single(rP, issue);
+               }
+
+       if (bP || seqCount >= 2)
+          {if (issue) numIssuing++;
+           rdCV.UnLock();
+           if (isDone) Complete(rP, rP->got);
+           if (issue) Issue(issue);
+           return;
+          }
+      }
+
+// Hold the read if the file already has enough reads in flight; it will be
+// sent along with others as a vector read. Otherwise, send it now.
+//
+   if (maxHeld && rP->size <= maxMerge && numFlight >= maxHeld)
+      {rP->next = 0;
+       if (heldLast) heldLast->next = rP;
+          else heldFirst = rP;
+       heldLast = rP;
+       rdCV.UnLock();
+       return;
+      }
+   Single(rP, issue);
+   numIssuing++;
+   rdCV.UnLock();
+   Issue(issue);
+}
@@ -0,0 +1,157 @@
+#ifndef __PSS_READER_HH__
+#define __PSS_READER_HH__
+/******************************************************************************/
+/*                                                                            */
+/*                       X r d P s s R e a d e r . h h                        */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/*                                                                            */
+/* The copyright holder's institutional names and contributor's names may not */
+/* be used to endorse or promote products derived from this software without  */
+/* specific prior written permission of the institution or contributor.       */
+/******************************************************************************/
+
+#include <sys/types.h>
+
+#include "XrdSys/XrdSysPthread.hh"
+
+class XrdPosixCallBackIO;
+class XrdSfsAio;
+struct XrdOucIOVec;
+
+/* XrdPssReaderOrigin is where a reader sends its upstream requests. Requests
+   are always completed via their callback. The default origin reads through
+   XrdPosixXrootd.
+*/
+
+class XrdPssReaderOrigin
+{
+public:
+
+virtual void Pread(int fd, void *buff, size_t blen, off_t offset,
+                   XrdPosixCallBackIO *cbp) = 0;
+
+// The result is the total number of bytes read.
+//
+virtual void VRead(int fd, const XrdOucIOVec *readV, int n,
+                   XrdPosixCallBackIO *cbp) = 0;
+
+             XrdPssReaderOrigin() {}
+virtual     ~XrdPssReaderOrigin() {}
+};
+
+/* XrdPssReader aggregates the reads issued against a proxied file so that
+   fewer requests travel to the origin.
+
+   Coalescing: while the configured number of upstream reads is in flight,
+   further small reads are held. As soon as an upstream read completes, all
+   held reads are sent together as a single vector read. An idle file thus
+   sees no added latency while a busy one trades many round trips for one.
+   Should the vector read fail or come up short (e.g. a read extends past the
+   end of the file) each read is reissued on its own so it gets its own result.
+
+   Read-ahead: after three consecutive sequential reads, the next read is
+   widened to fill a read-ahead block from which the following reads are
+   served. Two blocks are kept so that the next one is filled while the
+   current one is consumed.
+
+   Only plain reads go through the reader. Page reads are sent to the origin
+   as they are so that their checksums are carried end to end.
+
+   A reader is bound to one open upstream file and, therefore, to the identity
+   under which it was opened; reads of different clients are never mixed.
+*/
+
+class XrdPssReader
+{
+public:
+
+// Read asynchronously; the request is always completed via its callback.
+//
+       void    Read(XrdSfsAio *aiop);
+
+// Read synchronously returning the bytes read or -errno.
+//
+       ssize_t Read(void *buff, off_t offset, size_t blen);
+
+// Detach the reader from its file. Upon return no further upstream requests
+// will be issued using the file descriptor and the reader deletes itself once
+// the last one completes.
+//
+       void    Detach();
+
+static bool    Enabled() {return maxHeld > 0 || raSize > 0;}
+
+// Set the options: the number of upstream reads in flight at which reads
+// are held for coalescing (0 disables it), the largest read that is held, and
+// the read-ahead block size (0 disables it).
+//
+static void    SetOpts(int held, int mrgsz, int rasz);
+
+// Format statistics as an XML fragment; if blen is 0 return the maximum
+// length it may have.
+//
+static int     Stats(char *buff, int blen);
+
+// The origin, if given, must outlive the reader.
+//
+               XrdPssReader(int fd, XrdPssReaderOrigin *orig=0);
+
+private:
+              ~XrdPssReader();
+
+struct rdReq;
+class  upReq;
+
+struct raBlk
+      {char     *buff;
+       long long offset;
+       int       want;
+       int       len;
+       enum     {Empty = 0, Filling, Ready} state;
+       rdReq    *waiters;
+      };
+
+void    Ahead(raBlk &blk, long long endOff, upReq *&issue);
+void    Complete(rdReq *rP, ssize_t result);
+void    Done(upReq *uP, ssize_t result);
+void    Drain(upReq *&issue, rdReq *&fail);
+void    Fill(raBlk &blk, long long offset, rdReq *rP, upReq *&issue);
+raBlk  *Find(long long offset, int size);
+void    Issue(upReq *issue);
+int     Serve(raBlk &blk, rdReq *rP);
+void    Single(rdReq *rP, upReq *&issue);
+void    Submit(rdReq *rP);
+
+static int  maxHeld;
+static int  maxMerge;
+static int  raSize;
+
+XrdSysCondVar rdCV;
+XrdPssReaderOrigin *origin;
+raBlk         raBlock[2];
+rdReq        *heldFirst;
+rdReq        *heldLast;
+long long     lastEnd;
+int           fileFD;
+int           numRefs;
+int           numFlight;
+int           numIssuing;
+int           seqCount;
+bool          isDetached;
+};
+#endif
@@ -29,6 +29,7 @@
 #include "XrdOss/XrdOssWrapper.hh"
 #include "XrdSfs/XrdSfsAio.hh"
 #include "XrdSys/XrdSysLogger.hh"
+#include "XrdThrottle/XrdThrottleAio.hh"
 #include "XrdThrottle/XrdThrottleConfig.hh"
 #include "XrdThrottle/XrdThrottleManager.hh"
 #include "XrdThrottle/XrdThrottleTrace.hh"
@@ -60,6 +61,8 @@ virtual int Open(const char *path, int Oflag, mode_t Mode,
 
     if (rval < 0) {
         m_throttle.CloseFile(m_user);
+    } else {
+        m_class = m_throttle.GetFileClass(m_user, m_uid, env.secEnv());
     }
 
     return rval;
@@ -67,6 +70,7 @@ virtual int Open(const char *path, int Oflag, mode_t Mode,
 
 virtual int Close(long long *retsz) override {
    m_throttle.CloseFile(m_user);
+   m_class.reset();
    return wrapDF.Close(retsz);
 }
 
@@ -82,14 +86,9 @@ virtual ssize_t pgRead (void* buffer, off_t offset, size_t rdlen,
         buffer, offset, rdlen, csvec, opts);
 }
 
-virtual int pgRead(XrdSfsAio *aioparm, uint64_t opts) override
-{  // We disable all AIO-based reads.
-   aioparm->Result = pgRead((char *)aioparm->sfsAio.aio_buf,
-                                    aioparm->sfsAio.aio_offset,          
-                                    aioparm->sfsAio.aio_nbytes,
-                                    aioparm->cksVec, opts);
-   aioparm->doneRead();
-   return 0;
+virtual int pgRead(XrdSfsAio *aioparm, uint64_t opts) override {
+    return DoThrottleAio(aioparm,
+        [&](XrdSfsAio *aiop) {return wrapDF.pgRead(aiop, opts);});
 }
 
 virtual ssize_t pgWrite(void* buffer, off_t offset, size_t wrlen,
@@ -100,14 +99,9 @@ virtual ssize_t pgWrite(void* buffer, off_t offset, size_t wrlen,
         buffer, offset, wrlen, csvec, opts);
 }
 
-virtual int pgWrite(XrdSfsAio *aioparm, uint64_t opts) override
-{  // We disable all AIO-based writes.
-   aioparm->Result = this->pgWrite((char *)aioparm->sfsAio.aio_buf,
-                                           aioparm->sfsAio.aio_offset, 
-                                           aioparm->sfsAio.aio_nbytes,
-                                           aioparm->cksVec, opts);
-   aioparm->doneWrite();
-   return 0;
+virtual int pgWrite(XrdSfsAio *aioparm, uint64_t opts) override {
+    return DoThrottleAio(aioparm,
+        [&](XrdSfsAio *aiop) {return wrapDF.pgWrite(aiop, opts);});
 }
 
 virtual ssize_t Read(off_t offset, size_t size) override {
@@ -121,12 +115,9 @@ virtual ssize_t Read(void* buffer, off_t offset, size_t size) override {
         buffer, offset, size);
 }
 
-virtual int Read(XrdSfsAio *aiop) override {
-    aiop->Result = this->Read((char *)aiop->sfsAio.aio_buf,
-                                   aiop->sfsAio.aio_offset,
-                                   aiop->sfsAio.aio_nbytes);
-    aiop->doneRead();
-    return 0;
+virtual int Read(XrdSfsAio *aioparm) override {
+    return DoThrottleAio(aioparm,
+        [&](XrdSfsAio *aiop) {return wrapDF.Read(aiop);});
 }
 
 virtual ssize_t ReadV(XrdOucIOVec *readV, int rdvcnt) override {
@@ -144,19 +135,16 @@ virtual ssize_t Write(const void* buffer, off_t offset, size_t size) override {
         buffer, offset, size);
 }
 
-virtual int Write(XrdSfsAio *aiop) override {
-    aiop->Result = this->Write((char *)aiop->sfsAio.aio_buf,
-                                    aiop->sfsAio.aio_offset,
-                                    aiop->sfsAio.aio_nbytes);
-    aiop->doneWrite();
-    return 0;
+virtual int Write(XrdSfsAio *aioparm) override {
+    return DoThrottleAio(aioparm,
+        [&](XrdSfsAio *aiop) {return wrapDF.Write(aiop);});
 }
 
 private:
 
     template <class Fn, class... Args>
     int DoThrottle(size_t rdlen, size_t ops, Fn &&fn, Args &&... args) {
-        m_throttle.Apply(rdlen, ops, m_uid);
+        m_throttle.Apply(rdlen, ops, m_uid, m_class.get());
         bool ok = true;
         XrdThrottleTimer timer = m_throttle.StartIOTimer(m_uid, ok);
         if (!ok) {
@@ -166,12 +154,28 @@ private:
         return std::invoke(fn, wrapDF, std::forward<Args>(args)...);
     }
 
+    // Submit an async request through the throttle.  The request is timed
+    // from submission until the wrapped file reports its completion (see
+    // XrdThrottleAio::Submit).
+    template <class Fn>
+    int DoThrottleAio(XrdSfsAio *aioparm, Fn &&submit) {
+        bool ok = true;
+        auto rc = XrdThrottleAio::Submit(aioparm, m_throttle, m_uid,
+                      m_class.get(), std::forward<Fn>(submit), ok);
+        if (!ok) {
+            TRACE(DEBUG, "Throttling in progress");
+            return -EMFILE;
+        }
+        return rc;
+    }
+
     XrdSysError *m_log{nullptr};
     XrdThrottleManager &m_throttle;
     XrdOucTrace *m_trace{nullptr};
     std::unique_ptr<XrdOssDF> m_wrapped;
     std::string m_user;
     uint16_t m_uid;
+    XrdThrottle::Scheduler::Handle m_class;
 
     static constexpr char TraceID[] = "XrdThrottleFile";
 };
@@ -128,6 +128,7 @@ private:
    std::string m_loadshed;
    std::string m_connection_id; // Identity for the connection; may or may authenticated
    std::string m_user;
+   XrdThrottle::Scheduler::Handle m_class; // Scheduler class of the file; null unless hierarchical.
    XrdThrottleManager &m_throttle;
    XrdSysError &m_eroute;
 };
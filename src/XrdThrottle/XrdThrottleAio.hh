@@ -0,0 +1,125 @@
+/*
+ * XrdThrottleAio
+ *
+ * An asynchronous I/O request passed through the throttle.
+ *
+ * The throttle substitutes this object for the caller's request when handing
+ * it to the wrapped file.  The I/O timer is started when the request is
+ * submitted and is stopped when the wrapped file reports completion, just
+ * before the completion is forwarded to the caller.  This way an async request
+ * is charged for the time it is actually in flight rather than for the time
+ * it took to be queued.
+ *
+ * Overlapping requests are each charged their own in-flight time; the sum is
+ * what the manager uses as the user's concurrency.  Each request also holds a
+ * slot against the concurrency limit until it completes, so a client issuing
+ * many requests at once is throttled the same way as many synchronous readers.
+ *
+ * The wrapped file may complete a request before it returns from the submit,
+ * whatever it then returns.  So while Submit() runs, the substitute request is
+ * owned by both Submit() and the completion, and the last one to let go of it
+ * deletes it.
+ */
+
+#ifndef __XrdThrottleAio_hh_
+#define __XrdThrottleAio_hh_
+
+#include <atomic>
+
+#include "XrdSfs/XrdSfsAio.hh"
+#include "XrdThrottle/XrdThrottleManager.hh"
+
+class XrdThrottleAio final : public XrdSfsAio
+{
+public:
+
+// Create the substitute request for aiop and start its I/O timer.  Should
+// the user have waited too long for the concurrency limit, ok is set to false;
+// the request must then be recycled without being submitted.
+//
+XrdThrottleAio(XrdSfsAio *aiop, XrdThrottleManager &throttle, uint16_t uid,
+               bool &ok)
+   : m_parent(aiop),
+     m_timer(throttle.StartIOTimer(uid, ok))
+{
+   sfsAio.aio_fildes  = aiop->sfsAio.aio_fildes;
+   sfsAio.aio_buf     = aiop->sfsAio.aio_buf;
+   sfsAio.aio_nbytes  = aiop->sfsAio.aio_nbytes;
+   sfsAio.aio_offset  = aiop->sfsAio.aio_offset;
+   sfsAio.aio_reqprio = aiop->sfsAio.aio_reqprio;
+   cksVec             = aiop->cksVec;
+   TIdent             = aiop->TIdent;
+}
+
+// Submit the caller's request aiop through the throttle.  The rate limits are
+// applied and the substitute request is handed to submit, which must return
+// zero if the wrapped file accepted it; the wrapped file then completes it.
+// Any other result means the request will never complete unless it already
+// has, so the substitute is then released at once, stopping its timer and
+// releasing its concurrency slot.  A request must not be completed after
+// submit returned an error.  Should the user have waited too long for the
+// concurrency limit, ok is set to false and nothing is submitted.  Otherwise,
+// the result of submit is returned.
+//
+template <class Fn>
+static int Submit(XrdSfsAio *aiop, XrdThrottleManager &throttle, uint16_t uid,
+                  XrdThrottle::Scheduler::Class *fclass, Fn &&submit, bool &ok)
+{
+   throttle.Apply(aiop->sfsAio.aio_nbytes, 1, uid, fclass);
+   auto taio = new XrdThrottleAio(aiop, throttle, uid, ok);
+   if (!ok) {
+      taio->Recycle();
+      return 0;
+   }
+   taio->m_refs.store(2, std::memory_order_relaxed);
+   int rc = submit(taio);
+   if (rc != 0 && !taio->m_done.exchange(true)) taio->Release();
+   taio->Release();
+   return rc;
+}
+
+virtual void doneRead() override
+{
+   XrdSfsAio *parent = Complete();
+   parent->doneRead();
+}
+
+virtual void doneWrite() override
+{
+   XrdSfsAio *parent = Complete();
+   parent->doneWrite();
+}
+
+virtual void Recycle() override {Release();}
+
+private:
+
+// Hand the result to the caller's request and let go of ourselves.  Unless
+// Submit() still holds us, this stops the timer so that the caller's
+// completion runs outside of the accounting.
+//
+XrdSfsAio *Complete()
+{
+   XrdSfsAio *parent = m_parent;
+   parent->Result = Result;
+   m_done.store(true);
+   Release();
+   return parent;
+}
+
+// Drop a reference; the last one deletes us, which stops the timer.
+//
+void Release()
+{
+   if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+}
+
+virtual ~XrdThrottleAio() {}
+
+XrdSfsAio         *m_parent;
+XrdThrottleTimer   m_timer;
+std::atomic<int>   m_refs{1};
+std::atomic<bool>  m_done{false};
+};
+
+#endif
@@ -69,6 +69,7 @@ Configuration::Configure(const std::string &config_file)
         TS_Xeq("throttle.throttle", xthrottle);
         TS_Xeq("throttle.loadshed", xloadshed);
         TS_Xeq("throttle.max_wait_time", xmaxwait);
+        TS_Xeq("throttle.scheduler", xscheduler);
         TS_Xeq("throttle.trace", xtrace);
         TS_Xeq("throttle.userconfig", xuserconfig);
         if (NoGo)
@@ -159,6 +160,34 @@ Configuration::xmaxwait(XrdOucStream &Config)
     return 0;
 }
 
+/******************************************************************************/
+/*                           x s c h e d u l e r                              */
+/******************************************************************************/
+
+/* Function: xscheduler
+
+   Purpose:  Parse the directive: throttle.scheduler {fairshare | hierarchical}
+
+             fairshare    share the rates equally among the active users (default).
+             hierarchical share the rates by VO, user, and file using token buckets
+                          and weighted fair queuing.
+
+  Output: 0 upon success or !0 upon failure.
+*/
+int
+Configuration::xscheduler(XrdOucStream &Config)
+{
+    auto val = Config.GetWord();
+    if (!val || val[0] == '\0')
+       {m_log.Emsg("Config", "Scheduler not specified!  Example usage: throttle.scheduler hierarchical"); return 1;}
+
+    if (!strcmp(val, "fairshare")) m_hierarchical_scheduler = false;
+    else if (!strcmp(val, "hierarchical")) m_hierarchical_scheduler = true;
+    else {m_log.Emsg("Config", "Invalid throttle scheduler", val); return 1;}
+
+    return 0;
+}
+
 /******************************************************************************/
 /*                            x t h r o t t l e                               */
 /******************************************************************************/
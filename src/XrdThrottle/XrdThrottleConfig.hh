@@ -92,6 +92,11 @@ public:
     // If not set, the default is 1000 ms.
     long long GetThrottleRecomputeIntervalMS() const { return m_throttle_recompute_interval_ms; }
 
+    // Get whether the hierarchical token-bucket scheduler is used instead of
+    // the fairshare one.
+    // If not set, the default is false.
+    bool GetHierarchicalScheduler() const { return m_hierarchical_scheduler; }
+
     // Get the configuration for the trace levels.
     // If not set, the default is 0.
     int GetTraceLevels() const { return m_trace_levels; }
@@ -105,6 +110,7 @@ private:
     int xmaxopen(XrdOucStream &Config);
     int xmaxconn(XrdOucStream &Config);
     int xmaxwait(XrdOucStream &Config);
+    int xscheduler(XrdOucStream &Config);
     int xthrottle(XrdOucStream &Config);
     int xtrace(XrdOucStream &Config);
     int xuserconfig(XrdOucStream &Config);
@@ -122,6 +128,7 @@ private:
     long long m_throttle_data_rate{-1};
     long long m_throttle_iops_rate{-1};
     long long m_throttle_recompute_interval_ms{1000};
+    bool m_hierarchical_scheduler{false};
     int m_trace_levels{0};
     std::string m_user_config_file;
 };
@@ -4,6 +4,7 @@
 #include "XrdSec/XrdSecEntityAttr.hh"
 
 #include "XrdThrottle.hh"
+#include "XrdThrottleAio.hh"
 
 using namespace XrdThrottle;
 
@@ -19,7 +20,7 @@ using namespace XrdThrottle;
 
 #define DO_THROTTLE(amount) \
 DO_LOADSHED \
-m_throttle.Apply(amount, 1, m_uid); \
+m_throttle.Apply(amount, 1, m_uid, m_class.get()); \
 bool ok; \
 auto xtimer = m_throttle.StartIOTimer(m_uid, ok); \
 if (!ok) { \
@@ -27,6 +28,20 @@ if (!ok) { \
    return SFS_ERROR; \
 }
 
+// Async requests are timed from submission until the underlying file reports
+// their completion (see XrdThrottleAio::Submit).  The submit expression refers
+// to the substitute request as taio.
+#define DO_THROTTLE_AIO(aioparm, submit) \
+DO_LOADSHED \
+bool ok; \
+auto retval = XrdThrottleAio::Submit(aioparm, m_throttle, m_uid, m_class.get(), \
+                 [&](XrdSfsAio *taio) {return submit;}, ok); \
+if (!ok) { \
+   error.setErrInfo(EMFILE, "I/O limit exceeded and wait time hit"); \
+   return SFS_ERROR; \
+} \
+return retval;
+
 
 File::File(const char                     *user,
                  unique_sfs_ptr            sfs,
@@ -68,6 +83,7 @@ File::open(const char                *fileName,
    auto retval = m_sfs->open(fileName, openMode, createMode, client, opaque);
    if (retval != SFS_ERROR) {
       m_is_open = true;
+      m_class = m_throttle.GetFileClass(m_user, m_uid, client);
    } else {
       m_throttle.CloseFile(m_user);
    }
@@ -79,6 +95,7 @@ File::close()
 {
    m_is_open = false;
    m_throttle.CloseFile(m_user);
+   m_class.reset();
    return m_sfs->close();
 }
 
@@ -125,13 +142,8 @@ File::pgRead(XrdSfsFileOffset   offset,
 
 XrdSfsXferSize
 File::pgRead(XrdSfsAio *aioparm, uint64_t opts)
-{  // We disable all AIO-based reads.
-   aioparm->Result = this->pgRead((XrdSfsFileOffset)aioparm->sfsAio.aio_offset,
-                                            (char *)aioparm->sfsAio.aio_buf,
-                                    (XrdSfsXferSize)aioparm->sfsAio.aio_nbytes,
-                                                    aioparm->cksVec, opts);
-   aioparm->doneRead();
-   return SFS_OK;
+{
+   DO_THROTTLE_AIO(aioparm, m_sfs->pgRead(taio, opts))
 }
 
 XrdSfsXferSize
@@ -147,13 +159,8 @@ File::pgWrite(XrdSfsFileOffset   offset,
 
 XrdSfsXferSize
 File::pgWrite(XrdSfsAio *aioparm, uint64_t opts)
-{  // We disable all AIO-based writes.
-   aioparm->Result = this->pgWrite((XrdSfsFileOffset)aioparm->sfsAio.aio_offset,
-                                             (char *)aioparm->sfsAio.aio_buf,
-                                     (XrdSfsXferSize)aioparm->sfsAio.aio_nbytes,
-                                                     aioparm->cksVec, opts);
-   aioparm->doneWrite();
-   return SFS_OK;
+{
+   DO_THROTTLE_AIO(aioparm, m_sfs->pgWrite(taio, opts))
 }
 
 int
@@ -175,12 +182,8 @@ File::read(XrdSfsFileOffset   fileOffset,
 
 int
 File::read(XrdSfsAio *aioparm)
-{  // We disable all AIO-based reads.
-   aioparm->Result = this->read((XrdSfsFileOffset)aioparm->sfsAio.aio_offset,
-                                          (char *)aioparm->sfsAio.aio_buf,
-                                  (XrdSfsXferSize)aioparm->sfsAio.aio_nbytes);
-   aioparm->doneRead();
-   return SFS_OK;
+{
+   DO_THROTTLE_AIO(aioparm, m_sfs->read(taio))
 }
 
 XrdSfsXferSize
@@ -195,11 +198,7 @@ File::write(      XrdSfsFileOffset   fileOffset,
 int
 File::write(XrdSfsAio *aioparm)
 {
-   aioparm->Result = this->write((XrdSfsFileOffset)aioparm->sfsAio.aio_offset,
-                                           (char *)aioparm->sfsAio.aio_buf,
-                                   (XrdSfsXferSize)aioparm->sfsAio.aio_nbytes);
-   aioparm->doneWrite();
-   return SFS_OK;
+   DO_THROTTLE_AIO(aioparm, m_sfs->write(taio))
 }
 
 int
@@ -53,7 +53,9 @@ XrdThrottleManager::XrdThrottleManager(XrdSysError *lP, XrdOucTrace *tP) :
    m_last_round_allocation(100*1024),
    m_loadshed_host(""),
    m_loadshed_port(0),
-   m_loadshed_frequency(0)
+   m_loadshed_frequency(0),
+   m_scheduler([this](XrdThrottle::Scheduler::Level level, const std::string &name)
+               {return (level == XrdThrottle::Scheduler::VO) ? GetVOWeight(name) : GetUserWeight(name);})
 {
 }
 
@@ -72,6 +74,7 @@ XrdThrottleManager::FromConfig(XrdThrottle::Configuration &config)
        config.GetThrottleIOPSRate(),
        config.GetThrottleConcurrency(),
        static_cast<float>(config.GetThrottleRecomputeIntervalMS())/1000.0);
+    SetHierarchical(config.GetHierarchicalScheduler());
 
     m_trace->What = config.GetTraceLevels();
 
@@ -147,6 +150,21 @@ XrdThrottleManager::GetUserInfo(const XrdSecEntity *client) {
     return std::make_tuple(user, uid);
 }
 
+XrdThrottle::Scheduler::Handle
+XrdThrottleManager::GetFileClass(const std::string &user, uint16_t uid, const XrdSecEntity *client)
+{
+    if (!m_hierarchical) return nullptr;
+
+    // A client may belong to several VOs; the first one is the one it is
+    // accounted under.
+    std::string vo;
+    if (client && client->vorg) {
+        vo = client->vorg;
+        vo = vo.substr(0, vo.find(' '));
+    }
+    return m_scheduler.Open(vo, user, uid);
+}
+
 /*
  * Take as many shares as possible to fulfill the request; update
  * request with current remaining value, or zero if satisfied.
@@ -339,8 +357,17 @@ XrdThrottleManager::CloseFile(const std::string &entity)
  * this applies the limits as best possible, stalling the thread if necessary.
  */
 void
-XrdThrottleManager::Apply(int reqsize, int reqops, int uid)
+XrdThrottleManager::Apply(int reqsize, int reqops, int uid, XrdThrottle::Scheduler::Class *file)
 {
+   if (m_hierarchical && file)
+   {
+      if (m_scheduler.Acquire(*file, reqsize, reqops))
+      {
+         TRACE(BANDWIDTH, "Request of " << reqsize << " bytes waited for its class' tokens.");
+         m_loadshed_limit_hit++;
+      }
+      return;
+   }
    if (m_bytes_per_second < 0)
       reqsize = 0;
    if (m_ops_per_second < 0)
@@ -581,6 +608,7 @@ XrdThrottleManager::Recompute()
       TRACE(DEBUG, "Recomputing fairshares for throttle.");
       RecomputeInternal();
       ComputeWaiterOrder();
+      if (m_hierarchical) RecomputeClasses();
       TRACE(DEBUG, "Finished recomputing fairshares for throttle; sleeping for " << m_interval_length_seconds << " seconds.");
       XrdSysTimer::Wait(static_cast<int>(1000*m_interval_length_seconds));
    }
@@ -683,6 +711,45 @@ XrdThrottleManager::RecomputeInternal()
    m_compute_var.Broadcast();
 }
 
+/*
+ * Refill the hierarchical scheduler's classes and report the per-class
+ * statistics of the last interval to the g-stream.
+ */
+void
+XrdThrottleManager::RecomputeClasses()
+{
+   auto stats = m_scheduler.Recompute();
+   if (!m_gstream) return;
+
+   // Names come from the client's credentials; keep them from breaking the
+   // JSON record.
+   auto clean = [](std::string name) {
+      for (auto &c : name) {
+         if (c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20) c = '_';
+      }
+      return name;
+   };
+   for (const auto &cls : stats)
+   {
+      bool is_vo = cls.level == XrdThrottle::Scheduler::VO;
+      auto name = clean(cls.name);
+      auto vo = clean(cls.vo);
+      char buf[1024];
+      auto len = snprintf(buf, sizeof(buf),
+                          R"({"event":"throttle_class","level":"%s","name":"%s","vo":"%s","requests":%llu,"delayed":%llu,)"
+                          R"("bytes":%llu,"ops":%llu,"rate":%.0f,"wait_avg":%.6f,"wait_p50":%.6f,"wait_p99":%.6f,"wait_max":%.6f})",
+                          is_vo ? "vo" : "user", name.c_str(), vo.c_str(),
+                          static_cast<unsigned long long>(cls.requests), static_cast<unsigned long long>(cls.delayed),
+                          static_cast<unsigned long long>(cls.bytes), static_cast<unsigned long long>(cls.ops),
+                          cls.rate, cls.wait_avg, cls.wait_p50, cls.wait_p99, cls.wait_max);
+      auto suc = (len < static_cast<int>(sizeof(buf))) ? m_gstream->Insert(buf, len + 1) : false;
+      if (!suc)
+      {
+         TRACE(IOLOAD, "Failed g-stream insertion of throttle_class record (len=" << len << ")");
+      }
+   }
+}
+
 /*
  * Do a simple hash across the username.
  */
@@ -742,6 +809,20 @@ XrdThrottleManager::StartIOTimer(uint16_t uid, bool &ok)
       m_loadshed_limit_hit++;
       m_io_active.fetch_sub(1, std::memory_order_acq_rel);
       TRACE(DEBUG, "ThrottleManager (user=" << uid << "): IO concurrency limit hit; waiting for other IOs to finish.");
+      if (m_hierarchical) {
+         // Wait in fair order; the slot is taken on our behalf when our turn comes.
+         auto take = [&] {
+            if (m_io_active.fetch_add(1, std::memory_order_acq_rel) < static_cast<unsigned>(m_concurrency_limit)) return true;
+            m_io_active.fetch_sub(1, std::memory_order_acq_rel);
+            return false;
+         };
+         ok = m_scheduler.AcquireSlot(uid, take, std::chrono::steady_clock::now() + m_max_wait_time);
+         if (!ok) {
+            TRACE(DEBUG, "ThrottleManager (user=" << uid << "): timed out waiting for other IOs to finish.");
+            return XrdThrottleTimer();
+         }
+         break;
+      }
       ok = m_waiter_info[uid].Wait();
       if (!ok) {
         TRACE(DEBUG, "ThrottleManager (user=" << uid << "): timed out waiting for other IOs to finish.");
@@ -763,6 +844,11 @@ XrdThrottleManager::StopIOTimer(std::chrono::steady_clock::duration & event_dura
    m_io_active_time += event_duration.count();
    auto old_active = m_io_active.fetch_sub(1, std::memory_order_acq_rel);
    m_waiter_info[uid].m_io_time += event_duration.count();
+   if (m_hierarchical)
+   {
+      if (old_active <= static_cast<unsigned>(m_concurrency_limit)) m_scheduler.ReleaseSlot();
+      return;
+   }
    if (old_active == static_cast<unsigned>(m_concurrency_limit))
    {
       // If we are below the concurrency limit threshold and have another waiter
@@ -876,6 +962,16 @@ XrdThrottleManager::Waiter::Wait()
  * [wildcarduser]
  * name = wildcarduser*
  * maxconn = 10
+ *
+ * The hierarchical scheduler also takes a weight for users and VOs:
+ *
+ * [heavyuser]
+ * name = heavyuser
+ * weight = 4
+ *
+ * [cms]
+ * vo = cms
+ * weight = 2
  */
 int
 XrdThrottleManager::LoadUserLimits(const std::string &config_file)
@@ -895,11 +991,27 @@ XrdThrottleManager::LoadUserLimits(const std::string &config_file)
     }
 
     std::unordered_map<std::string, UserLimit> new_limits;
+    std::unordered_map<std::string, float> new_vo_weights;
 
     // Process all sections
     for (const auto &section : reader.Sections())
     {
-        // Get the name parameter (required for all sections)
+        double weight = reader.GetReal(section, "weight", 0);
+
+        // A VO section only carries the VO's weight
+        std::string vo = reader.Get(section, "vo", "");
+        if (!vo.empty())
+        {
+            if (weight <= 0)
+            {
+                m_log->Say("ThrottleManager", "Section", section.c_str(), "has invalid or missing 'weight' parameter; skipping");
+                continue;
+            }
+            new_vo_weights[vo] = static_cast<float>(weight);
+            continue;
+        }
+
+        // Get the name parameter (required for all user sections)
         std::string name = reader.Get(section, "name", "");
         if (name.empty())
         {
@@ -908,25 +1020,28 @@ XrdThrottleManager::LoadUserLimits(const std::string &config_file)
         }
 
         long max_conn = reader.GetInteger(section, "maxconn", 0);
-        if (max_conn <= 0)
+        if (max_conn <= 0 && weight <= 0)
         {
             m_log->Say("ThrottleManager", "Section", section.c_str(), "has invalid or missing 'maxconn' parameter; skipping");
             continue;
         }
 
         UserLimit limit;
-        limit.max_conn = static_cast<unsigned long>(max_conn);
+        limit.max_conn = (max_conn > 0) ? static_cast<unsigned long>(max_conn) : 0;
+        limit.weight = (weight > 0) ? static_cast<float>(weight) : 0;
         // Check if name contains wildcard (including '*' for default/catch-all)
         limit.is_wildcard = (name.find('*') != std::string::npos);
         new_limits[name] = limit;
     }
 
     // Atomically replace the limits map
-    size_t num_entries = new_limits.size();
+    size_t num_entries = new_limits.size() + new_vo_weights.size();
     {
         std::unique_lock<std::shared_mutex> lock(m_user_limits_mutex);
         m_user_limits = std::move(new_limits);
+        m_vo_weights = std::move(new_vo_weights);
     }
+    m_scheduler.Reweight();
 
     m_log->Say("ThrottleManager", "Loaded", std::to_string(num_entries).c_str(), "per-user limit entries from", config_file.c_str());
     return 0;
@@ -949,37 +1064,69 @@ XrdThrottleManager::ReloadUserLimits()
 /*
  * Get the per-user connection limit for a given username.
  * Returns 0 if no per-user limit is set (use global), otherwise returns the limit.
+ */
+unsigned long
+XrdThrottleManager::GetUserMaxConn(const std::string &username)
+{
+    return MatchUserLimit(username, &UserLimit::max_conn);
+}
+
+/*
+ * Get the scheduler weight for a given username; 0 if none is set.
+ */
+float
+XrdThrottleManager::GetUserWeight(const std::string &username)
+{
+    return MatchUserLimit(username, &UserLimit::weight);
+}
+
+/*
+ * Get the scheduler weight for a given VO; 0 if none is set.
+ */
+float
+XrdThrottleManager::GetVOWeight(const std::string &vo)
+{
+    std::shared_lock lock(m_user_limits_mutex);
+    auto iter = m_vo_weights.find(vo);
+    return (iter == m_vo_weights.end()) ? 0 : iter->second;
+}
+
+/*
+ * Find the per-user setting for a given username; entries that do not set
+ * it are skipped.
  * Supports wildcard matching (e.g., "user*" matches "user1", "user2", etc.)
  * Special case: "*" matches all users (default/catch-all)
  * Priority: exact match > wildcard match (longest prefix) > "*" > global
  */
-unsigned long
-XrdThrottleManager::GetUserMaxConn(const std::string &username)
+template <class T>
+T
+XrdThrottleManager::MatchUserLimit(const std::string &username, T UserLimit::*field)
 {
     std::shared_lock lock(m_user_limits_mutex);
 
     // First, try exact match
     auto exact_iter = m_user_limits.find(username);
-    if (exact_iter != m_user_limits.end() && !exact_iter->second.is_wildcard)
+    if (exact_iter != m_user_limits.end() && !exact_iter->second.is_wildcard &&
+        exact_iter->second.*field > 0)
     {
-        return exact_iter->second.max_conn;
+        return exact_iter->second.*field;
     }
 
     // Then, try wildcard matches (prefer longest matching prefix)
-    unsigned long best_match = 0;
+    T best_match = 0;
     size_t best_prefix_len = 0;
-    unsigned long catch_all_match = 0;
+    T catch_all_match = 0;
 
     for (const auto &entry : m_user_limits)
     {
-        if (!entry.second.is_wildcard) continue;
+        if (!entry.second.is_wildcard || entry.second.*field <= 0) continue;
 
         const std::string &pattern = entry.first;
 
         // Special case: "*" is a catch-all pattern - store it but don't use it yet
         if (pattern == "*")
         {
-            catch_all_match = entry.second.max_conn;
+            catch_all_match = entry.second.*field;
             continue;
         }
 
@@ -995,7 +1142,7 @@ XrdThrottleManager::GetUserMaxConn(const std::string &username)
             if (prefix.length() > best_prefix_len)
             {
                 best_prefix_len = prefix.length();
-                best_match = entry.second.max_conn;
+                best_match = entry.second.*field;
             }
         }
     }
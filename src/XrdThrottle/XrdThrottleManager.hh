@@ -15,6 +15,9 @@
  * Note that we do not actually keep close track of users, but rather
  * put them into a hash.  This way, we can pretend there's a constant
  * number of users and use a lock-free algorithm.
+ *
+ * Alternatively, the rates may be enforced by the hierarchical scheduler
+ * (see XrdThrottleScheduler), which shares them out by VO, user, and file.
  */
 
 #ifndef __XrdThrottleManager_hh_
@@ -40,6 +43,7 @@
 
 #include "XrdSys/XrdSysRAtomic.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include "XrdThrottle/XrdThrottleScheduler.hh"
 
 class XrdSecEntity;
 class XrdSysError;
@@ -63,7 +67,9 @@ void        Init();
 bool        OpenFile(const std::string &entity, std::string &open_error_message);
 bool        CloseFile(const std::string &entity);
 
-void        Apply(int reqsize, int reqops, int uid);
+// Apply the rate limits to a request.  When the hierarchical scheduler is in
+// use, the file's class (see GetFileClass) must be given.
+void        Apply(int reqsize, int reqops, int uid, XrdThrottle::Scheduler::Class *file = nullptr);
 
 void        FromConfig(XrdThrottle::Configuration &config);
 
@@ -74,9 +80,18 @@ bool        IsThrottling() {return (m_ops_per_second > 0) || (m_bytes_per_second
 // The UID is a hash of the user name; it is not guaranteed to be unique.
 std::tuple<std::string, uint16_t> GetUserInfo(const XrdSecEntity *client);
 
+// Returns the scheduler class for a file opened by the given user, or null if
+// the hierarchical scheduler is not in use.  The class lives as long as the
+// handle is held.
+XrdThrottle::Scheduler::Handle GetFileClass(const std::string &user, uint16_t uid, const XrdSecEntity *client);
+
 void        SetThrottles(float reqbyterate, float reqoprate, int concurrency, float interval_length)
             {m_interval_length_seconds = interval_length; m_bytes_per_second = reqbyterate;
-             m_ops_per_second = reqoprate; m_concurrency_limit = concurrency;}
+             m_ops_per_second = reqoprate; m_concurrency_limit = concurrency;
+             m_scheduler.SetLimits(reqbyterate, reqoprate, interval_length);}
+
+// Use the hierarchical token-bucket scheduler instead of the fairshare one.
+void        SetHierarchical(bool hierarchical) {m_hierarchical = hierarchical;}
 
 void        SetLoadShed(std::string &hostname, unsigned port, unsigned frequency)
             {m_loadshed_host = hostname; m_loadshed_port = port; m_loadshed_frequency = frequency;}
@@ -98,6 +113,11 @@ int         ReloadUserLimits();
 // Returns 0 if no per-user limit is set (use global), otherwise returns the limit
 unsigned long GetUserMaxConn(const std::string &username);
 
+// Get the scheduler weight for a given username or VO
+// Returns 0 if no weight is set (the scheduler then uses 1)
+float       GetUserWeight(const std::string &username);
+float       GetVOWeight(const std::string &vo);
+
 void        SetMonitor(XrdXrootdGStream *gstream) {m_gstream = gstream;}
 
 //int         Stats(char *buff, int blen, int do_sync=0) {return m_pool.Stats(buff, blen, do_sync);}
@@ -108,6 +128,10 @@ void        SetMonitor(XrdXrootdGStream *gstream) {m_gstream = gstream;}
 // if we block for too long, the second return value will return false.
 XrdThrottleTimer StartIOTimer(uint16_t uid, bool &ok);
 
+// Returns the number of I/O operations in progress, each of which holds a
+// slot against the concurrency limit.
+uint32_t    ActiveIO() const {return m_io_active.load(std::memory_order_acquire);}
+
 void        PrepLoadShed(const char *opaque, std::string &lsOpaque);
 
 bool        CheckLoadShed(const std::string &opaque);
@@ -136,6 +160,8 @@ void        Recompute();
 
 void        RecomputeInternal();
 
+void        RecomputeClasses();
+
 static
 void *      RecomputeBootstrap(void *pp);
 
@@ -262,12 +288,19 @@ std::mutex m_file_mutex;
 // Per-user connection limits
 struct UserLimit {
     unsigned long max_conn{0};  // 0 means no limit (use global)
+    float weight{0};            // 0 means the default weight
     bool is_wildcard{false};    // true if this is a wildcard pattern
 };
 std::unordered_map<std::string, UserLimit> m_user_limits;
+std::unordered_map<std::string, float> m_vo_weights;
 std::shared_mutex m_user_limits_mutex;
 std::string m_user_config_file;
 
+// Find the per-user setting for a username; entries where the setting is zero
+// are ignored.
+template <class T>
+T           MatchUserLimit(const std::string &username, T UserLimit::*field);
+
 // Track the ongoing I/O operations.  We have several linked lists (hashed on the
 // CPU ID) of I/O operations that are in progress.  This way, we can periodically sum
 // up the time spent in ongoing operations - which is important for operations that
@@ -292,6 +325,10 @@ std::chrono::steady_clock::duration m_max_wait_time{std::chrono::seconds(30)};
 // Monitoring handle, if configured
 XrdXrootdGStream* m_gstream{nullptr};
 
+// The hierarchical scheduler; only used if m_hierarchical is set.
+XrdThrottle::Scheduler m_scheduler;
+bool m_hierarchical{false};
+
 static const char *TraceID;
 
 };
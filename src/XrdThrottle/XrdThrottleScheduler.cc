@@ -0,0 +1,561 @@
+#include "XrdThrottle/XrdThrottleScheduler.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace XrdThrottle;
+
+/*
+ * A node of the class tree.
+ */
+class Scheduler::Class
+{
+public:
+
+// Waits are recorded in power-of-two buckets of microseconds; bucket 0
+// holds requests that did not wait.
+static constexpr int m_buckets = 32;
+
+Class(Level level, const std::string &name, Class *parent, uint16_t uid)
+   : m_name(name), m_level(level), m_parent(parent), m_uid(uid)
+{
+   for (auto &count : m_wait_hist) count = 0;
+}
+
+// Record a request that was admitted after waiting wait_ns.
+void Account(int64_t bytes, int64_t ops, int64_t wait_ns)
+{
+   m_requests++;
+   m_bytes_used += bytes;
+   m_ops_used += ops;
+   if (wait_ns > 0) {
+      m_delayed++;
+      m_wait_ns += wait_ns;
+      int64_t prev = m_wait_max_ns;
+      while (wait_ns > prev && !m_wait_max_ns.compare_exchange_weak(prev, wait_ns)) {}
+   }
+   int64_t wait_us = wait_ns / 1000;
+   int bucket = 0;
+   while (wait_us && bucket < m_buckets - 1) {
+      wait_us >>= 1;
+      bucket++;
+   }
+   m_wait_hist[bucket]++;
+}
+
+// Collect and reset the statistics for the last interval.
+void Drain(ClassStats &stats)
+{
+   stats.name = m_name;
+   stats.vo = (m_level == User) ? m_parent->m_name : m_name;
+   stats.level = m_level;
+   stats.requests = m_requests.exchange(0);
+   stats.delayed = m_delayed.exchange(0);
+   stats.bytes = m_bytes_used.exchange(0);
+   stats.ops = m_ops_used.exchange(0);
+   stats.rate = m_bytes.Rate();
+   auto wait_ns = m_wait_ns.exchange(0);
+   stats.wait_avg = stats.requests ? static_cast<double>(wait_ns) / stats.requests / 1e9 : 0;
+   stats.wait_max = static_cast<double>(m_wait_max_ns.exchange(0)) / 1e9;
+
+   std::array<uint32_t, m_buckets> hist;
+   uint64_t total = 0;
+   for (int idx = 0; idx < m_buckets; idx++) {
+      hist[idx] = m_wait_hist[idx].exchange(0);
+      total += hist[idx];
+   }
+   stats.wait_p50 = Quantile(hist, total, 0.5);
+   stats.wait_p99 = Quantile(hist, total, 0.99);
+}
+
+// Upper bound, in seconds, of the wait the given fraction of requests were
+// under.
+static double Quantile(const std::array<uint32_t, m_buckets> &hist, uint64_t total, double fraction)
+{
+   uint64_t want = static_cast<uint64_t>(std::ceil(fraction * total));
+   uint64_t seen = 0;
+   for (int idx = 0; idx < m_buckets; idx++) {
+      seen += hist[idx];
+      if (seen >= want) {
+         return idx ? static_cast<double>(1ULL << idx) / 1e6 : 0;
+      }
+   }
+   return 0;
+}
+
+const std::string m_name;
+const Level m_level;
+Class * const m_parent;
+const uint16_t m_uid;
+
+TokenBucket m_bytes;
+TokenBucket m_ops;
+XrdSys::RAtomic<float> m_weight{1};
+XrdSys::RAtomic<int64_t> m_last_use{0}; // Time of the last request charged to the class.
+XrdSys::RAtomic<unsigned> m_waiters{0}; // Requests of this user or file in the token queue.
+
+// Protected by the scheduler mutex.
+unsigned m_refs{0}; // Number of child classes.
+double m_active_weight{0}; // Sum of the weights of the active children.
+bool m_active{false};
+
+// Finish tag of the user's flow; protected by the token queue.
+double m_finish{0};
+
+// Statistics since the last recompute.
+XrdSys::RAtomic<uint64_t> m_requests{0};
+XrdSys::RAtomic<uint64_t> m_delayed{0};
+XrdSys::RAtomic<uint64_t> m_bytes_used{0};
+XrdSys::RAtomic<uint64_t> m_ops_used{0};
+XrdSys::RAtomic<int64_t> m_wait_ns{0};
+XrdSys::RAtomic<int64_t> m_wait_max_ns{0};
+std::array<XrdSys::RAtomic<uint32_t>, m_buckets> m_wait_hist;
+};
+
+/******************************************************************************/
+/*                           T o k e n B u c k e t                            */
+/******************************************************************************/
+
+int64_t
+TokenBucket::Level(int64_t now_ns)
+{
+   double rate = m_rate;
+   if (rate < 0) {
+      return std::numeric_limits<int64_t>::max();
+   }
+   // A new bucket starts out full.  A new class still cannot go faster than
+   // its parent allows, as every request is also held to the parent's bucket.
+   auto last = m_last_ns.load(std::memory_order_relaxed);
+   if (!last) {
+      if (m_last_ns.compare_exchange_strong(last, now_ns, std::memory_order_relaxed)) {
+         int64_t burst = m_burst;
+         return m_tokens.fetch_add(burst, std::memory_order_relaxed) + burst;
+      }
+      return m_tokens.load(std::memory_order_relaxed);
+   }
+   auto elapsed = now_ns - last;
+   if (elapsed < m_min_refill_ns ||
+       !m_last_ns.compare_exchange_strong(last, now_ns, std::memory_order_relaxed)) {
+      return m_tokens.load(std::memory_order_relaxed);
+   }
+
+   // We own the refill for [last, now).  Add the tokens and then cap the
+   // bucket; a concurrent charge landing in between is simply kept.
+   int64_t burst = m_burst;
+   double add = static_cast<double>(elapsed) * rate / 1e9;
+   double room = static_cast<double>(burst - m_tokens.load(std::memory_order_relaxed));
+   int64_t tokens = (add >= room) ? static_cast<int64_t>(std::max(room, 0.0)) : static_cast<int64_t>(add);
+   auto level = m_tokens.fetch_add(tokens, std::memory_order_relaxed) + tokens;
+   while (level > burst &&
+          !m_tokens.compare_exchange_weak(level, burst, std::memory_order_relaxed)) {}
+   return std::min(level, burst);
+}
+
+int64_t
+TokenBucket::Eta(int64_t now_ns)
+{
+   auto level = Level(now_ns);
+   if (level >= 0) {
+      return 0;
+   }
+   double rate = m_rate;
+   if (rate <= 0) {
+      return std::numeric_limits<int64_t>::max();
+   }
+   return static_cast<int64_t>(static_cast<double>(-level) * 1e9 / rate);
+}
+
+/******************************************************************************/
+/*                             F a i r Q u e u e                              */
+/******************************************************************************/
+
+bool
+FairQueue::Wait(double &finish, double cost, const std::function<bool()> &admit,
+                const std::function<Clock::duration()> &eta,
+                Clock::time_point deadline)
+{
+   std::unique_lock<std::mutex> lock(m_mutex);
+
+   Waiter self;
+   self.m_start = std::max(m_vtime, finish);
+   self.m_finish = self.m_start + cost;
+   self.m_seq = m_seq++;
+   self.m_admit = &admit;
+   self.m_eta = eta ? &eta : nullptr;
+   finish = self.m_finish;
+   m_waiters.insert(&self);
+   m_size++;
+
+   while (!self.m_granted) {
+      auto now = Clock::now();
+      if (now >= deadline) {
+         bool head = (*m_waiters.begin() == &self);
+         m_waiters.erase(&self);
+         m_size--;
+         if (head && !m_waiters.empty()) {
+            (*m_waiters.begin())->m_cv.notify_one();
+         }
+         return false;
+      }
+      auto sleep = m_max_sleep;
+      if (*m_waiters.begin() == &self) {
+         sleep = Dispatch();
+         if (self.m_granted) break;
+      }
+      self.m_cv.wait_until(lock, std::min(now + sleep, deadline));
+   }
+   return true;
+}
+
+/*
+ * Run the admission tests of the waiters in order of their finish tags,
+ * granting those that pass.  Returns how long until another pass is worth
+ * doing.  Must hold m_mutex.
+ */
+FairQueue::Clock::duration
+FairQueue::Dispatch()
+{
+   auto next = m_max_sleep;
+   auto head = *m_waiters.begin();
+   int scanned = 0;
+   for (auto iter = m_waiters.begin(); iter != m_waiters.end() && scanned < m_max_scan; scanned++) {
+      auto waiter = *iter;
+      if ((*waiter->m_admit)()) {
+         waiter->m_granted = true;
+         m_vtime = std::max(m_vtime, waiter->m_start);
+         iter = m_waiters.erase(iter);
+         m_size--;
+         waiter->m_cv.notify_one();
+      } else {
+         if (waiter->m_eta) {
+            next = std::min(next, (*waiter->m_eta)());
+         }
+         iter++;
+      }
+   }
+
+   // If the head was admitted, its successor takes over the dispatching.
+   if (!m_waiters.empty() && *m_waiters.begin() != head) {
+      (*m_waiters.begin())->m_cv.notify_one();
+   }
+   return std::max<Clock::duration>(next, std::chrono::milliseconds(1));
+}
+
+void
+FairQueue::Kick()
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (!m_waiters.empty()) {
+      Dispatch();
+   }
+}
+
+/******************************************************************************/
+/*                             S c h e d u l e r                              */
+/******************************************************************************/
+
+Scheduler::Scheduler(WeightFunc weights, ClockFunc clock)
+   : m_root(new Class(Root, "", nullptr, 0)),
+     m_weights(std::move(weights)),
+     m_clock(std::move(clock))
+{
+   for (auto &weight : m_slot_weight) {
+      weight = 1;
+   }
+   m_slot_finish.fill(0);
+}
+
+Scheduler::~Scheduler() {}
+
+int64_t
+Scheduler::Now()
+{
+   if (m_clock) return m_clock();
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void
+Scheduler::SetLimits(double bytes_per_second, double ops_per_second, double interval_seconds)
+{
+   m_bytes_per_second = bytes_per_second;
+   m_ops_per_second = ops_per_second;
+   m_interval_seconds = interval_seconds;
+   auto interval = std::chrono::duration_cast<FairQueue::Clock::duration>(
+      std::chrono::duration<double>(interval_seconds));
+   m_token_queue.SetMaxSleep(interval);
+   m_slot_queue.SetMaxSleep(interval);
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+   AssignRate(*m_root);
+   for (auto &vo : m_vos) AssignRate(*vo.second);
+   for (auto &user : m_users) AssignRate(*user.second);
+   for (auto file : m_files) AssignRate(*file);
+}
+
+/*
+ * The root gets the server-wide limits; every other class gets its parent's
+ * rate split by weight among the parent's active children.  An inactive class
+ * gets the share it would have if it became active.  Each bucket holds up to
+ * one interval's worth of tokens.
+ */
+void
+Scheduler::AssignRate(Class &cls)
+{
+   double bytes_rate = m_bytes_per_second;
+   double ops_rate = m_ops_per_second;
+   if (ops_rate > 0) ops_rate *= m_op_scale;
+   if (cls.m_parent) {
+      auto &parent = *cls.m_parent;
+      double weight = cls.m_weight;
+      double total = parent.m_active_weight + (cls.m_active ? 0 : weight);
+      double fraction = (total > 0) ? weight / total : 1;
+      bytes_rate = parent.m_bytes.Rate();
+      ops_rate = parent.m_ops.Rate();
+      if (bytes_rate > 0) bytes_rate *= fraction;
+      if (ops_rate > 0) ops_rate *= fraction;
+   }
+   double interval = m_interval_seconds;
+   cls.m_bytes.SetRate(bytes_rate, static_cast<int64_t>(std::max(bytes_rate, 0.0) * interval));
+   cls.m_ops.SetRate(ops_rate, static_cast<int64_t>(std::max(ops_rate, 0.0) * interval));
+}
+
+/*
+ * Find or create the class of the given level and name; must hold m_mutex.
+ */
+Scheduler::Class *
+Scheduler::GetClass(Level level, const std::string &name, Class *parent, uint16_t uid)
+{
+   auto &classes = (level == VO) ? m_vos : m_users;
+   auto key = (level == VO) ? name : parent->m_name + '\n' + name;
+   auto iter = classes.find(key);
+   if (iter != classes.end()) {
+      return iter->second.get();
+   }
+
+   auto cls = new Class(level, name, parent, uid);
+   float weight = m_weights ? m_weights(level, name) : 0;
+   cls->m_weight = (weight > 0) ? weight : 1;
+   cls->m_last_use = Now();
+   if (level == User && uid < m_max_users) {
+      m_slot_weight[uid] = static_cast<float>(cls->m_weight);
+   }
+   parent->m_refs++;
+   AssignRate(*cls);
+   classes[key].reset(cls);
+   return cls;
+}
+
+Scheduler::Handle
+Scheduler::Open(const std::string &vo, const std::string &user, uint16_t uid)
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   auto vo_class = GetClass(VO, vo, m_root.get(), 0);
+   auto user_class = GetClass(User, user, vo_class, uid);
+   auto file = new Class(File, "", user_class, uid);
+   user_class->m_refs++;
+   AssignRate(*file);
+   m_files.insert(file);
+   return Handle(file, [this](Class *cls) {Close(cls);});
+}
+
+void
+Scheduler::Close(Class *file)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_files.erase(file);
+      file->m_parent->m_refs--;
+      file->m_parent->m_last_use = Now();
+   }
+   delete file;
+}
+
+/*
+ * Admit the request if, for each kind of token it needs, no class from the
+ * file up is in debt; then charge every one of them.
+ */
+bool
+Scheduler::Admit(Class &file, int64_t bytes, int64_t mops)
+{
+   // Every bucket on the path is brought up to date before it is charged.
+   auto now = Now();
+   bool ok = true;
+   for (Class *cls = &file; cls; cls = cls->m_parent) {
+      if (bytes && cls->m_bytes.Level(now) < 0) ok = false;
+      if (mops && cls->m_ops.Level(now) < 0) ok = false;
+   }
+   if (!ok) return false;
+   for (Class *cls = &file; cls; cls = cls->m_parent) {
+      if (bytes) cls->m_bytes.Charge(bytes);
+      if (mops) cls->m_ops.Charge(mops);
+   }
+   return true;
+}
+
+/*
+ * The request may proceed once the last of the classes on its path is out of
+ * debt.
+ */
+FairQueue::Clock::duration
+Scheduler::Eta(Class &file, int64_t bytes, int64_t mops)
+{
+   auto now = Now();
+   int64_t eta = 0;
+   for (Class *cls = &file; cls; cls = cls->m_parent) {
+      if (bytes) eta = std::max(eta, cls->m_bytes.Eta(now));
+      if (mops) eta = std::max(eta, cls->m_ops.Eta(now));
+   }
+   return std::chrono::nanoseconds(eta);
+}
+
+double
+Scheduler::Cost(Class &user, int64_t bytes, int64_t mops)
+{
+   double cost = 0;
+   double rate = user.m_bytes.Rate();
+   if (bytes && rate > 0) cost = static_cast<double>(bytes) / rate;
+   rate = user.m_ops.Rate();
+   if (mops && rate > 0) cost = std::max(cost, static_cast<double>(mops) / rate);
+   return cost;
+}
+
+bool
+Scheduler::Acquire(Class &file, int64_t bytes, int64_t ops)
+{
+   int64_t want_bytes = (m_bytes_per_second < 0) ? 0 : bytes;
+   int64_t want_mops = (m_ops_per_second < 0) ? 0 : ops * m_op_scale;
+   auto &user = *file.m_parent;
+
+   if (TryAcquire(file, bytes, ops)) return false;
+
+   auto start = Now();
+   std::function<bool()> admit = [&] {return Admit(file, want_bytes, want_mops);};
+   std::function<FairQueue::Clock::duration()> eta = [&] {return Eta(file, want_bytes, want_mops);};
+   file.m_waiters++;
+   user.m_waiters++;
+   m_token_queue.Wait(user.m_finish, Cost(user, want_bytes, want_mops), admit, eta,
+                      FairQueue::Clock::time_point::max());
+   user.m_waiters--;
+   file.m_waiters--;
+   Account(file, bytes, ops, std::max<int64_t>(Now() - start, 1));
+   return true;
+}
+
+bool
+Scheduler::TryAcquire(Class &file, int64_t bytes, int64_t ops)
+{
+   int64_t want_bytes = (m_bytes_per_second < 0) ? 0 : bytes;
+   int64_t want_mops = (m_ops_per_second < 0) ? 0 : ops * m_op_scale;
+   auto &user = *file.m_parent;
+
+   // A user with queued requests queues behind them rather than overtaking.
+   // A file whose request is turned away still counts as active so that it
+   // keeps its share of the user's rate.
+   if ((want_bytes || want_mops) &&
+       (user.m_waiters || !Admit(file, want_bytes, want_mops)))
+   {
+      file.m_last_use = Now();
+      return false;
+   }
+   Account(file, bytes, ops, 0);
+   return true;
+}
+
+void
+Scheduler::Account(Class &file, int64_t bytes, int64_t ops, int64_t wait_ns)
+{
+   auto now = Now();
+   for (Class *cls = &file; cls->m_level != Root; cls = cls->m_parent) {
+      cls->m_last_use = now;
+      if (cls->m_level != File) cls->Account(bytes, ops, wait_ns);
+   }
+}
+
+bool
+Scheduler::AcquireSlot(uint16_t uid, const std::function<bool()> &take,
+                       FairQueue::Clock::time_point deadline)
+{
+   uid %= m_max_users;
+   return m_slot_queue.Wait(m_slot_finish[uid], 1.0 / m_slot_weight[uid], take, {}, deadline);
+}
+
+void
+Scheduler::Reweight()
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   for (auto &entry : m_vos) {
+      float weight = m_weights ? m_weights(VO, entry.second->m_name) : 0;
+      entry.second->m_weight = (weight > 0) ? weight : 1;
+   }
+   for (auto &entry : m_users) {
+      auto &cls = *entry.second;
+      float weight = m_weights ? m_weights(User, cls.m_name) : 0;
+      cls.m_weight = (weight > 0) ? weight : 1;
+      if (cls.m_uid < m_max_users) m_slot_weight[cls.m_uid] = static_cast<float>(cls.m_weight);
+   }
+}
+
+/*
+ * Called once per interval by the manager's recompute thread.
+ *
+ * A class is active if a request was charged to it during the last two
+ * intervals or it has requests waiting.  The activity is rolled up the tree
+ * and the rates are then handed out from the root down.
+ */
+std::vector<Scheduler::ClassStats>
+Scheduler::Recompute()
+{
+   std::vector<ClassStats> result;
+   auto now = Now();
+   auto active_since = now - static_cast<int64_t>(2e9 * m_interval_seconds);
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      m_root->m_active_weight = 0;
+      for (auto &vo : m_vos) vo.second->m_active_weight = 0;
+      for (auto &user : m_users) user.second->m_active_weight = 0;
+
+      auto mark = [&](Class &cls) {
+         cls.m_active = cls.m_last_use >= active_since || cls.m_waiters || cls.m_active_weight > 0;
+         if (cls.m_active) cls.m_parent->m_active_weight += cls.m_weight;
+      };
+      for (auto file : m_files) mark(*file);
+      for (auto &user : m_users) mark(*user.second);
+      for (auto &vo : m_vos) mark(*vo.second);
+
+      AssignRate(*m_root);
+      for (auto &vo : m_vos) AssignRate(*vo.second);
+      for (auto &user : m_users) AssignRate(*user.second);
+      for (auto file : m_files) AssignRate(*file);
+
+      // Report the VOs first and then their users.
+      for (auto classes : {&m_vos, &m_users}) {
+         for (auto &entry : *classes) {
+            if (entry.second->m_requests) {
+               result.emplace_back();
+               entry.second->Drain(result.back());
+            }
+         }
+      }
+
+      // Forget the users, and then the VOs, that have been idle for a while.
+      auto idle_since = now - m_idle_ns;
+      for (auto classes : {&m_users, &m_vos}) {
+         for (auto iter = classes->begin(); iter != classes->end();) {
+            auto &cls = *iter->second;
+            if (!cls.m_refs && !cls.m_waiters && cls.m_last_use < idle_since) {
+               cls.m_parent->m_refs--;
+               iter = classes->erase(iter);
+            } else {
+               iter++;
+            }
+         }
+      }
+   }
+
+   // The rates may have changed; let the waiters see whether they can go.
+   m_token_queue.Kick();
+   return result;
+}
@@ -0,0 +1,279 @@
+/*
+ * XrdThrottleScheduler
+ *
+ * A hierarchical token-bucket scheduler for the throttle.
+ *
+ * Each open file is a class whose parent is the user that opened it; the
+ * user's parent is the user's VO and the VO's parent is the server itself.
+ * Every class has a bucket of bytes and a bucket of operations which are
+ * refilled at the class' assured rate: the parent's rate split among its
+ * active children in proportion to their weights.  Files all weigh the same,
+ * so the files of a user share the user's rate equally.
+ *
+ * A request may proceed only when no class on its path, from its file up to
+ * the server, is in debt; the request is then charged to every one of them.
+ * Every class is thus held to its assured rate, and since a bucket is never
+ * charged while in debt, its debt never exceeds the requests admitted at
+ * once.  Opening more files gains a user nothing as every file is also held
+ * to the user's buckets.  The share of an idle class goes to its busy
+ * siblings at the next recompute, which splits the rates among the active
+ * classes only.  The check and the charge are lock-free; only a request that
+ * cannot proceed takes a lock.
+ *
+ * Requests that cannot proceed wait in a fair queue ordered by virtual
+ * finish time (start-time fair queuing).  The cost of a request is the time
+ * the user's assured rate needs to serve it, so every user with waiters
+ * advances through the queue at a pace proportional to their weight.  The
+ * same discipline orders the waiters for the concurrency limit.
+ */
+
+#ifndef __XrdThrottleScheduler_hh_
+#define __XrdThrottleScheduler_hh_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "XrdSys/XrdSysRAtomic.hh"
+
+namespace XrdThrottle {
+
+/*
+ * A token bucket that may be drawn from concurrently without locks.
+ *
+ * The bucket starts full and is refilled lazily by whoever looks at it.  It
+ * may go into debt; a request is admitted whenever the bucket is not in debt
+ * and then charged in full, so requests larger than the bucket still make
+ * progress.
+ */
+class TokenBucket
+{
+public:
+
+// Set the refill rate, in tokens per second, and the most tokens the bucket
+// may hold.  A negative rate disables the bucket.
+void    SetRate(double rate, int64_t burst) {m_burst = burst; m_rate = rate;}
+
+double  Rate() {return m_rate;}
+
+// Refill the bucket up to now and return its level; negative when in debt.
+int64_t Level(int64_t now_ns);
+
+// Time, in nanoseconds, until the bucket is out of debt.
+int64_t Eta(int64_t now_ns);
+
+void    Charge(int64_t tokens) {m_tokens.fetch_sub(tokens, std::memory_order_relaxed);}
+
+private:
+
+// Refills of less than this are skipped to bound the rounding loss.
+static constexpr int64_t m_min_refill_ns = 1000000;
+
+std::atomic<int64_t> m_tokens{0};
+std::atomic<int64_t> m_last_ns{0};
+XrdSys::RAtomic<double> m_rate{-1};
+XrdSys::RAtomic<int64_t> m_burst{0};
+};
+
+/*
+ * A queue of waiters served in order of their virtual finish time.
+ *
+ * The waiter at the head of the queue runs the admission test for the queue,
+ * on behalf of every waiter in order, until its own request is admitted; the
+ * next one then takes over.  A waiter whose admission test fails does not
+ * block the ones behind it, so a class that can proceed is never held up by
+ * one that cannot.
+ */
+class FairQueue
+{
+public:
+
+using Clock = std::chrono::steady_clock;
+
+// Wait until admit() succeeds or the deadline passes; returns false in the
+// latter case.  The cost is in virtual seconds and finish is the finish tag
+// of the waiter's flow, which must only be used with this queue.  When given,
+// eta() estimates how long until admit() could succeed.
+bool    Wait(double &finish, double cost, const std::function<bool()> &admit,
+             const std::function<Clock::duration()> &eta,
+             Clock::time_point deadline);
+
+// Admit whatever waiters can now proceed.
+void    Kick();
+
+bool    Empty() {return m_size == 0;}
+
+size_t  Size() {return m_size;}
+
+// Longest time the head of the queue sleeps before testing again.
+void    SetMaxSleep(Clock::duration max_sleep)
+           {std::lock_guard<std::mutex> lock(m_mutex); m_max_sleep = max_sleep;}
+
+        FairQueue() : m_max_sleep(std::chrono::seconds(1)) {}
+
+private:
+
+struct Waiter
+{
+   double m_start;
+   double m_finish;
+   uint64_t m_seq;
+   const std::function<bool()> *m_admit;
+   const std::function<Clock::duration()> *m_eta;
+   bool m_granted{false};
+   std::condition_variable m_cv;
+};
+
+struct Order
+{
+   bool operator()(const Waiter *a, const Waiter *b) const
+   {return a->m_finish < b->m_finish || (a->m_finish == b->m_finish && a->m_seq < b->m_seq);}
+};
+
+Clock::duration Dispatch();
+
+// Number of waiters the head examines per pass.
+static constexpr int m_max_scan = 64;
+
+std::mutex m_mutex;
+std::set<Waiter *, Order> m_waiters;
+XrdSys::RAtomic<size_t> m_size{0};
+double m_vtime{0};
+uint64_t m_seq{0};
+Clock::duration m_max_sleep;
+};
+
+class Scheduler
+{
+public:
+
+enum Level {Root = 0, VO, User, File};
+
+class Class;
+
+// Opaque handle for a file class; closing the file releases the handle.
+using Handle = std::shared_ptr<Class>;
+
+// Returns the configured weight for the VO or user of the given name, or 0
+// if none is configured.
+using WeightFunc = std::function<float(Level, const std::string &)>;
+
+// Returns the current time in nanoseconds of a monotonic clock.
+using ClockFunc = std::function<int64_t()>;
+
+// Statistics of a class over the last recompute interval.
+struct ClassStats
+{
+   std::string name;
+   std::string vo;
+   Level level;
+   uint64_t requests;
+   uint64_t delayed;
+   uint64_t bytes;
+   uint64_t ops;
+   double rate;
+   double wait_avg;
+   double wait_p50;
+   double wait_p99;
+   double wait_max;
+};
+
+// Create the class for a file opened by the given user of the given VO (which
+// may be empty).
+Handle  Open(const std::string &vo, const std::string &user, uint16_t uid);
+
+// Wait until the request may proceed and charge it to the file's classes.
+// Returns true if the request had to wait.
+bool    Acquire(Class &file, int64_t bytes, int64_t ops);
+
+// Charge the request to the file's classes if it may proceed without waiting;
+// returns false, charging nothing, if it would have to wait.
+bool    TryAcquire(Class &file, int64_t bytes, int64_t ops);
+
+// Wait for a slot below the concurrency limit in fair order.  take() tries
+// to grab a slot; returns false if the deadline passes first.
+bool    AcquireSlot(uint16_t uid, const std::function<bool()> &take,
+                    FairQueue::Clock::time_point deadline);
+
+// Called whenever a slot below the concurrency limit frees up.
+void    ReleaseSlot() {if (!m_slot_queue.Empty()) m_slot_queue.Kick();}
+
+// Recompute the assured rates of all classes, forget idle ones, and return
+// the statistics of the classes active during the last interval.
+std::vector<ClassStats> Recompute();
+
+// Look up the weights of all classes again.
+void    Reweight();
+
+// Number of requests waiting for tokens.
+size_t  Waiting() {return m_token_queue.Size();}
+
+// Set the server-wide limits; a negative rate means no limit.
+void    SetLimits(double bytes_per_second, double ops_per_second, double interval_seconds);
+
+// The clock defaults to the steady clock.
+        Scheduler(WeightFunc weights, ClockFunc clock = nullptr);
+       ~Scheduler();
+
+private:
+
+int64_t Now();
+
+bool    Admit(Class &file, int64_t bytes, int64_t mops);
+
+// Record a request admitted after waiting wait_ns.
+void    Account(Class &file, int64_t bytes, int64_t ops, int64_t wait_ns);
+
+// Set the rates of a class from its parent's; must hold m_mutex.
+void    AssignRate(Class &cls);
+
+// Virtual time a user's assured rate needs to serve the request.
+double  Cost(Class &user, int64_t bytes, int64_t mops);
+
+FairQueue::Clock::duration Eta(Class &file, int64_t bytes, int64_t mops);
+
+void    Close(Class *file);
+
+Class  *GetClass(Level level, const std::string &name, Class *parent, uint16_t uid);
+
+// Operations are counted in thousandths so slow refills are not lost.
+static constexpr int64_t m_op_scale = 1000;
+
+// Users and VOs idle for this long without any open file are forgotten.
+static constexpr int64_t m_idle_ns = 60LL * 1000 * 1000 * 1000;
+
+std::unique_ptr<Class> m_root;
+std::unordered_map<std::string, std::unique_ptr<Class>> m_vos;
+std::unordered_map<std::string, std::unique_ptr<Class>> m_users;
+std::set<Class *> m_files;
+std::mutex m_mutex; // Protects the class maps and the tree structure.
+
+WeightFunc m_weights;
+ClockFunc m_clock;
+
+XrdSys::RAtomic<double> m_bytes_per_second{-1};
+XrdSys::RAtomic<double> m_ops_per_second{-1};
+XrdSys::RAtomic<double> m_interval_seconds{1.0};
+int64_t m_last_recompute{0};
+
+FairQueue m_token_queue;
+FairQueue m_slot_queue;
+
+// Weight and finish tag of each hashed user for the concurrency queue; the
+// tags are protected by the queue.
+static constexpr int m_max_users = 1024;
+std::array<XrdSys::RAtomic<float>, m_max_users> m_slot_weight;
+std::array<double, m_max_users> m_slot_finish;
+};
+
+} // namespace XrdThrottle
+
+#endif
@@ -73,6 +73,7 @@
 #include "XrdXrootd/XrdXrootdJob.hh"
 #include "XrdXrootd/XrdXrootdPrepare.hh"
 #include "XrdXrootd/XrdXrootdProtocol.hh"
+#include "XrdXrootd/XrdXrootdRedirCache.hh"
 #include "XrdXrootd/XrdXrootdRedirHelper.hh"
 #include "XrdXrootd/XrdXrootdRedirPI.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
@@ -444,6 +445,22 @@ int XrdXrootdProtocol::Configure(char *parms, XrdProtocol_Config *pi)
    if (fsFeatures & XrdSfs::hasCACH) myRole |= kXR_attrCache;
    myRole |= tlsFlags;
 
+// Create the redirect cache if one was wanted. It only makes sense when we
+// are a redirector as only then does the file system hand out redirects.
+// Cache hits must be authorized as the file system would have done, so get
+// the authorization plugin the file system loaded, if any.
+//
+   if (rdcHold >= 0)
+      {if (!isRedir)
+          eDest.Say("Config warning: 'rdrcache' ignored; not a redirector");
+          else {RdrCache = new XrdXrootdRedirCache(rdcHold, rdcNxHold,
+                                                   rdcMaxEnt);
+                SI->setRC(RdrCache);
+                if (pi->theEnv) rdcAuth = (XrdAccAuthorize *)
+                                pi->theEnv->GetPtr("XrdAccAuthorize*");
+               }
+      }
+
 // Turn off client redirects if we are neither a redirector nor a proxy server
 //
    if (CL_Redir && !isRedir && !isProxy)
@@ -607,6 +624,7 @@ int XrdXrootdProtocol::Config(const char *ConfigFN)
              else if TS_Xeq("monitor",       xmon);
              else if TS_Zeq("pmark",         XrdNetPMarkCfg::Parse);
              else if TS_Xeq("prep",          xprep);
+             else if TS_Xeq("rdrcache",      xrdc);
              else if TS_Xeq("redirect",      xred);
              else if TS_Xeq("redirlib",      xrdl);
              else if TS_Xeq("seclib",        xsecl);
@@ -1589,6 +1607,76 @@ int XrdXrootdProtocol::xprep(XrdOucStream &Config)
    return 0;
 }
 
+/******************************************************************************/
+/*                                  x r d c                                   */
+/******************************************************************************/
+
+/* Function: xrdc
+
+   Purpose:  To parse the directive: rdrcache {off | [hold <sec>]
+                                               [nxhold <sec>] [max <num>]}
+
+             off       do not cache redirects (the default).
+             hold      how long the redirect target for a file is reused. The
+                       default is 5 seconds. A zero value only caches the
+                       non-existence of files.
+             nxhold    how long the fact that a file does not exist is reused.
+                       The default is 3 seconds. A file created in the
+                       meantime is reported to the cmsd right away and is
+                       not found until the entry expires, so keep it short.
+             max       the maximum number of files to cache. The default is
+                       65536.
+
+  Output: 0 upon success or !0 upon failure.
+*/
+
+int XrdXrootdProtocol::xrdc(XrdOucStream &Config)
+{
+   char *val;
+   int hold = XrdXrootdRedirCache::defHold;
+   int nxhold = XrdXrootdRedirCache::defNxHold;
+   int maxent = XrdXrootdRedirCache::defMaxEnt;
+
+// Process all of the options
+//
+   while((val = Config.GetWord()) && *val)
+        {     if (!strcmp(val, "off")) {rdcHold = -1; return 0;}
+         else if (!strcmp(val, "hold"))
+                 {if (!(val = Config.GetWord()) || !*val)
+                     {eDest.Emsg("Config", "rdrcache hold value not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2tm(eDest,"rdrcache hold",val,&hold,0,3600))
+                     return 1;
+                 }
+         else if (!strcmp(val, "nxhold"))
+                 {if (!(val = Config.GetWord()) || !*val)
+                     {eDest.Emsg("Config", "rdrcache nxhold value not "
+                                           "specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2tm(eDest, "rdrcache nxhold", val, &nxhold,
+                                      0, 86400)) return 1;
+                 }
+         else if (!strcmp(val, "max"))
+                 {if (!(val = Config.GetWord()) || !*val)
+                     {eDest.Emsg("Config", "rdrcache max value not specified");
+                      return 1;
+                     }
+                  if (XrdOuca2x::a2i(eDest,"rdrcache max",val,&maxent,1))
+                     return 1;
+                 }
+         else {eDest.Emsg("Config", "invalid rdrcache option", val); return 1;}
+        }
+
+// Set the values
+//
+   rdcHold   = hold;
+   rdcNxHold = nxhold;
+   rdcMaxEnt = maxent;
+   return 0;
+}
+
 /******************************************************************************/
 /*                                  x r d l                                   */
 /******************************************************************************/
@@ -91,6 +91,8 @@ XrdBuffManager       *XrdXrootdProtocol::BPool;
 XrdSysError          &XrdXrootdProtocol::eDest = XrdXrootd::eLog;
 XrdNetPMark          *XrdXrootdProtocol::PMark    = 0;
 XrdXrootdRedirPI     *XrdXrootdProtocol::RedirPI  = 0;
+XrdXrootdRedirCache  *XrdXrootdProtocol::RdrCache = 0;
+XrdAccAuthorize      *XrdXrootdProtocol::rdcAuth  = 0;
 XrdXrootdStats       *XrdXrootdProtocol::SI;
 XrdXrootdJob         *XrdXrootdProtocol::JobCKS   = 0;
 char                 *XrdXrootdProtocol::JobCKT   = 0;
@@ -107,6 +109,9 @@ int                   XrdXrootdProtocol::Port;
 int                   XrdXrootdProtocol::Window;
 int                   XrdXrootdProtocol::tlsPort = 0;
 int                   XrdXrootdProtocol::redirIPHold = 8*60*60; // 8 Hours
+int                   XrdXrootdProtocol::rdcHold   = -1;  // Cache is off
+int                   XrdXrootdProtocol::rdcNxHold = 0;
+int                   XrdXrootdProtocol::rdcMaxEnt = 0;
 char                  XrdXrootdProtocol::isRedir = 0;
 char                  XrdXrootdProtocol::JobLCL  = 0;
 char                  XrdXrootdProtocol::JobCKCGI=0;
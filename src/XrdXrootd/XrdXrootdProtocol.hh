@@ -66,6 +66,7 @@
 /*                   x r d _ P r o t o c o l _ X R o o t d                    */
 /******************************************************************************/
 
+class XrdAccAuthorize;
 class XrdNetSocket;
 class XrdOucEnv;
 class XrdOucErrInfo;
@@ -88,6 +89,7 @@ class XrdXrootdJob;
 class XrdXrootdMonitor;
 class XrdXrootdPgwCtl;
 class XrdXrootdPio;
+class XrdXrootdRedirCache;
 class XrdXrootdRedirPI;
 class XrdXrootdStats;
 class XrdXrootdXPath;
@@ -320,6 +322,10 @@ static int   ConfigSecurity(XrdOucEnv &xEnv, const char *cfn);
        int   fsOvrld(char opc, const char *Path, char *Cgi);
        int   fsRedirNoEnt(const char *eMsg, char *Cgi, int popt);
        int   fsRedirPI(const char *trg, int port, int trglen);
+       bool  fsRdrCache(int &rc, char opC, const char *Path, char *Cgi,
+                        bool doPos);
+       void  fsRdrSave(int rc, XrdOucErrInfo &myError, const char *Path,
+                       bool doPos);
        int   getBuff(const int isRead, int Quantum);
        char *getCksType(char *opaque, char *cspec=0, int cslen=0);
        int   getData(const char *dtype, char *buff, int blen);
@@ -357,6 +363,7 @@ static char *xmondest(const char *what, char *val);
 static int   xmongs(XrdOucStream &Config);
 static bool  xmongsend(XrdOucStream &Config, char *val, char *&dest,
                        int &opt, int &fmt, int &hdr);
+static int   xrdc(XrdOucStream &Config);
 static int   xrdl(XrdOucStream &Config);
 static char* xrdlopt(XrdOucStream &Config, char* val);
 static int   xred(XrdOucStream &Config);
@@ -406,6 +413,8 @@ static XrdBuffManager       *BPool;     // Buffer manager
 static XrdSysError          &eDest;     // Error message handler
 static XrdNetPMark          *PMark;     // Packet marking API
 static XrdXrootdRedirPI     *RedirPI;   // Redirect plugin
+static XrdXrootdRedirCache  *RdrCache;  // Redirect cache (redirectors only)
+static XrdAccAuthorize      *rdcAuth;   // Authorization checked on cache hits
 static const char           *myInst;
 static const char           *TraceID;
 static int                   RQLxist;   // Something is present in RQList
@@ -433,6 +442,9 @@ static int                 Port;
 static int                 Window;
 static int                 tlsPort;
 static int                 redirIPHold;
+static int                 rdcHold;
+static int                 rdcNxHold;
+static int                 rdcMaxEnt;
 static char               *Notify;
 static const char         *myCName;
 static int                 myCNlen;
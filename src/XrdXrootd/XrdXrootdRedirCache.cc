@@ -0,0 +1,216 @@
+/******************************************************************************/
+/*                                                                            */
+/*                X r d X r o o t d R e d i r C a c h e . c c                 */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/******************************************************************************/
+
+#include <cstdio>
+
+#include "XrdXrootd/XrdXrootdRedirCache.hh"
+
+/******************************************************************************/
+/*                           C o n s t r u c t o r                            */
+/******************************************************************************/
+
+XrdXrootdRedirCache::XrdXrootdRedirCache(int hold, int nxhold, int maxEnt,
+                                         time_t (*clock)())
+                    : numHit(0), numNoEnt(0), numMiss(0), numDrop(0),
+                      Clock(clock), Hold(hold), nxHold(nxhold)
+{
+   slotMax = (maxEnt < nSlots ? 1 : maxEnt/nSlots);
+}
+
+/******************************************************************************/
+/*                                   A d d                                    */
+/******************************************************************************/
+
+void XrdXrootdRedirCache::Add(const char *path, int nClass,
+                              const char *host, int port)
+{
+   rdrSlot &slot = Slot(path);
+   time_t   now  = Now();
+
+// If the file was missing, it is now here. Replace any target we have for
+// this network class or add a new one.
+//
+   slot.Mutex.Lock();
+   rdrEnt &ent = Get(slot, path, now);
+   ent.nxExpires = 0;
+   for (auto &loc : ent.Loc)
+       {if (loc.nClass == nClass)
+           {loc.Host = host; loc.Port = port; loc.Expires = now + Hold;
+            slot.Mutex.UnLock();
+            return;
+           }
+       }
+   ent.Loc.push_back({host, now + Hold, port, nClass});
+   slot.Mutex.UnLock();
+}
+
+/******************************************************************************/
+/*                              A d d N o E n t                               */
+/******************************************************************************/
+
+void XrdXrootdRedirCache::AddNoEnt(const char *path)
+{
+   rdrSlot &slot = Slot(path);
+   time_t   now  = Now();
+
+   slot.Mutex.Lock();
+   rdrEnt &ent = Get(slot, path, now);
+   ent.Loc.clear();
+   ent.nxExpires = now + nxHold;
+   slot.Mutex.UnLock();
+}
+
+/******************************************************************************/
+/*                                  D r o p                                   */
+/******************************************************************************/
+
+void XrdXrootdRedirCache::Drop(const char *path)
+{
+   rdrSlot &slot = Slot(path);
+
+   slot.Mutex.Lock();
+   if (slot.Map.erase(path)) numDrop++;
+   slot.Mutex.UnLock();
+}
+
+/******************************************************************************/
+/*                                  F i n d                                   */
+/******************************************************************************/
+
+XrdXrootdRedirCache::Result
+XrdXrootdRedirCache::Find(const char *path, int nClass,
+                         std::string &host, int &port)
+{
+   rdrSlot &slot = Slot(path);
+   time_t   now  = Now();
+
+// Look up the entry. A missing file is missing for everyone.
+//
+   slot.Mutex.Lock();
+   auto it = slot.Map.find(path);
+   if (it != slot.Map.end())
+      {rdrEnt &ent = it->second;
+       if (ent.nxExpires)
+          {if (ent.nxExpires > now)
+              {slot.Mutex.UnLock();
+               numNoEnt++;
+               return NoEnt;
+              }
+           ent.nxExpires = 0;
+          }
+
+   // Find the target for the client's network class, discarding it if stale
+   //
+       if (nClass >= 0)
+          {for (auto lit = ent.Loc.begin(); lit != ent.Loc.end(); ++lit)
+               {if (lit->nClass != nClass) continue;
+                if (lit->Expires > now)
+                   {host = lit->Host; port = lit->Port;
+                    slot.Mutex.UnLock();
+                    numHit++;
+                    return Found;
+                   }
+                ent.Loc.erase(lit);
+                break;
+               }
+          }
+       if (ent.Loc.empty() && !ent.nxExpires) slot.Map.erase(it);
+      }
+   slot.Mutex.UnLock();
+
+// Nothing usable here
+//
+   numMiss++;
+   return Miss;
+}
+
+/******************************************************************************/
+/*                                 S t a t s                                  */
+/******************************************************************************/
+
+int XrdXrootdRedirCache::Stats(char *buff, int blen)
+{
+   static const char statfmt[] = "<rdc><hit>%lld</hit><nx>%lld</nx>"
+                                 "<miss>%lld</miss><inv>%lld</inv></rdc>";
+   static const long long LLMax = 0x7fffffffffffffffLL;
+
+// If no buffer, caller wants the maximum size we will generate
+//
+   if (!buff)
+      {char dummy[256];
+       return snprintf(dummy, sizeof(dummy), statfmt, LLMax, LLMax,
+                       LLMax, LLMax);
+      }
+
+// Format the counters
+//
+   int len = snprintf(buff, blen, statfmt,
+                      static_cast<long long>(numHit),
+                      static_cast<long long>(numNoEnt),
+                      static_cast<long long>(numMiss),
+                      static_cast<long long>(numDrop));
+   return (len < blen ? len : 0);
+}
+
+/******************************************************************************/
+/*                       P r i v a t e   M e t h o d s                        */
+/******************************************************************************/
+/******************************************************************************/
+/*                                   G e t                                    */
+/******************************************************************************/
+
+// Must be called with the slot mutex held!
+
+XrdXrootdRedirCache::rdrEnt &XrdXrootdRedirCache::Get(rdrSlot &slot,
+                                                      const char *path,
+                                                      time_t now)
+{
+   auto it = slot.Map.find(path);
+   if (it != slot.Map.end()) return it->second;
+
+// Make room if the slot is full. First toss whatever has expired and, if that
+// was not enough, some arbitrary entry.
+//
+   if (slot.Map.size() >= slotMax)
+      {for (auto mit = slot.Map.begin(); mit != slot.Map.end();)
+           {bool live = mit->second.nxExpires > now;
+            for (auto &loc : mit->second.Loc)
+                if (loc.Expires > now) {live = true; break;}
+            if (live) ++mit;
+               else mit = slot.Map.erase(mit);
+           }
+       if (slot.Map.size() >= slotMax) slot.Map.erase(slot.Map.begin());
+      }
+
+   return slot.Map[path];
+}
+
+/******************************************************************************/
+/*                                  S l o t                                   */
+/******************************************************************************/
+
+XrdXrootdRedirCache::rdrSlot &XrdXrootdRedirCache::Slot(const char *path)
+{
+   unsigned int h = 2166136261U;
+
+   while(*path) {h ^= static_cast<unsigned char>(*path++); h *= 16777619U;}
+   return Slots[h % nSlots];
+}
@@ -0,0 +1,160 @@
+#ifndef __XRDXROOTDREDIRCACHE__
+#define __XRDXROOTDREDIRCACHE__
+/******************************************************************************/
+/*                                                                            */
+/*                X r d X r o o t d R e d i r C a c h e . h h                 */
+/*                                                                            */
+/* This file is part of the XRootD software suite.                            */
+/*                                                                            */
+/* XRootD is free software: you can redistribute it and/or modify it under    */
+/* the terms of the GNU Lesser General Public License as published by the     */
+/* Free Software Foundation, either version 3 of the License, or (at your     */
+/* option) any later version.                                                 */
+/*                                                                            */
+/* XRootD is distributed in the hope that it will be useful, but WITHOUT      */
+/* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or      */
+/* FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public       */
+/* License for more details.                                                  */
+/*                                                                            */
+/* You should have received a copy of the GNU Lesser General Public License   */
+/* along with XRootD in a file called COPYING.LESSER (LGPL license) and file  */
+/* COPYING (GPL license).  If not, see <http://www.gnu.org/licenses/>.        */
+/******************************************************************************/
+
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "XrdSys/XrdSysPthread.hh"
+#include "XrdSys/XrdSysRAtomic.hh"
+
+//------------------------------------------------------------------------------
+//! @class XrdXrootdRedirCache
+//!
+//! Short lived cache of the answers a redirector got from its file system
+//! (i.e. the cms client) for read-only opens and locates. A positive entry
+//! holds the redirect target the cms chose for a file; a negative entry
+//! records that the cms said the file does not exist. Repeated lookups of
+//! the same file within the hold time are then answered without another
+//! trip to the cmsd and, for missing files, without waiting out the cmsd's
+//! full lookup delay again.
+//!
+//! The cms picks the target relative to the client's network (private vs
+//! public, IPv4 vs IPv6), so positive entries are kept per network class.
+//! Negative entries apply to every client. Entries for a path are dropped
+//! whenever the protocol sees a request that may create or remove it.
+//------------------------------------------------------------------------------
+
+class XrdXrootdRedirCache
+{
+public:
+
+//------------------------------------------------------------------------------
+//! Outcome of a lookup.
+//------------------------------------------------------------------------------
+
+enum Result {Miss = 0, Found, NoEnt};
+
+//------------------------------------------------------------------------------
+//! Record a redirect target for a path.
+//!
+//! @param  path    the logical file name without cgi.
+//! @param  nClass  the client's network class (see Find()).
+//! @param  host    the redirect host as returned by the file system.
+//! @param  port    the redirect port.
+//------------------------------------------------------------------------------
+
+void    Add(const char *path, int nClass, const char *host, int port);
+
+//------------------------------------------------------------------------------
+//! Record that a path does not exist. Any positive entries are discarded.
+//------------------------------------------------------------------------------
+
+void    AddNoEnt(const char *path);
+
+//------------------------------------------------------------------------------
+//! Drop everything known about a path.
+//------------------------------------------------------------------------------
+
+void    Drop(const char *path);
+
+//------------------------------------------------------------------------------
+//! Look up a path.
+//!
+//! @param  path    the logical file name without cgi.
+//! @param  nClass  the client's network class, an opaque small integer. A
+//!                 negative value only looks for a negative entry.
+//! @param  host    when Found, holds the redirect host.
+//! @param  port    when Found, holds the redirect port.
+//!
+//! @return Found, NoEnt, or Miss when nothing valid is cached.
+//------------------------------------------------------------------------------
+
+Result  Find(const char *path, int nClass, std::string &host, int &port);
+
+//------------------------------------------------------------------------------
+//! Format the cache statistics as an xml fragment.
+//!
+//! @param  buff    the buffer to use or nil to return the maximum length.
+//! @param  blen    the length of the buffer.
+//!
+//! @return the number of characters placed in the buffer.
+//------------------------------------------------------------------------------
+
+int     Stats(char *buff, int blen);
+
+//------------------------------------------------------------------------------
+//! Constructor
+//!
+//! @param  hold    seconds a positive entry remains valid.
+//! @param  nxHold  seconds a negative entry remains valid.
+//! @param  maxEnt  maximum number of paths to cache.
+//! @param  clock   the time source; nil uses time(0). Only tests change it.
+//------------------------------------------------------------------------------
+
+        XrdXrootdRedirCache(int hold, int nxHold, int maxEnt,
+                            time_t (*clock)() = 0);
+
+       ~XrdXrootdRedirCache() {}
+
+// Statistics, also used by the unit tests
+//
+RAtomic_llong   numHit;    // Lookups answered with a redirect
+RAtomic_llong   numNoEnt;  // Lookups answered with file not found
+RAtomic_llong   numMiss;   // Lookups that went to the file system
+RAtomic_llong   numDrop;   // Entries dropped because the path changed
+
+static constexpr int defHold   = 5;     // Default positive hold time
+static constexpr int defNxHold = 3;     // Default negative hold time
+static constexpr int defMaxEnt = 65536; // Default number of cached paths
+
+private:
+
+static const int nSlots = 16;
+
+struct rdrLoc {std::string Host;
+               time_t      Expires;
+               int         Port;
+               int         nClass;
+              };
+
+struct rdrEnt {std::vector<rdrLoc> Loc;
+               time_t              nxExpires = 0;
+              };
+
+struct rdrSlot{XrdSysMutex                             Mutex;
+               std::unordered_map<std::string, rdrEnt> Map;
+              };
+
+rdrSlot &Slot(const char *path);
+rdrEnt  &Get(rdrSlot &slot, const char *path, time_t now);
+time_t   Now() {return (Clock ? Clock() : time(0));}
+
+rdrSlot   Slots[nSlots];
+time_t  (*Clock)();
+size_t    slotMax;
+int       Hold;
+int       nxHold;
+};
+#endif
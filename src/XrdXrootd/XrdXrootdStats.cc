@@ -31,6 +31,7 @@
   
 #include "Xrd/XrdStats.hh"
 #include "XrdSfs/XrdSfsInterface.hh"
+#include "XrdXrootd/XrdXrootdRedirCache.hh"
 #include "XrdXrootd/XrdXrootdResponse.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
  
@@ -43,6 +44,7 @@ XrdXrootdStats::XrdXrootdStats(XrdStats *sp)
 
 xstats   = sp;
 fsP      = 0;
+rcP      = 0;
 
 Count    = 0;     // Stats: Number of matches
 errorCnt = 0;     // Stats: Number of errors returned
@@ -88,7 +90,7 @@ int XrdXrootdStats::Stats(char *buff, int blen, int do_sync)
    "<sig><ok>%d</ok><bad>%d</bad><ign>%d</ign></sig>"
    "<aio><num>%lld</num><max>%d</max><rej>%lld</rej></aio>"
    "<err>%d</err><rdr>%lld</rdr><dly>%d</dly>"
-   "<lgn><num>%d</num><af>%d</af><au>%d</au><ua>%d</ua></lgn></stats>";
+   "<lgn><num>%d</num><af>%d</af><au>%d</au><ua>%d</ua></lgn>";
 //                                   1 2 3 4 5 6 7 8
    static const long long LLMax = 0x7fffffffffffffffLL;
    static const int       INMax = 0x7fffffff;
@@ -105,6 +107,7 @@ int XrdXrootdStats::Stats(char *buff, int blen, int do_sync)
                       INMax, INMax, INMax,
                       LLMax, INMax, LLMax, INMax, LLMax, INMax,
                       INMax, INMax, INMax, INMax);
+       len += (rcP ? rcP->Stats(0,0) : 0) + 8; // </stats>
        return len + (fsP ? fsP->getStats(0,0) : 0);
       }
 
@@ -121,6 +124,13 @@ int XrdXrootdStats::Stats(char *buff, int blen, int do_sync)
                   LoginAT, AuthBad, LoginAU, LoginUA);
    statsMutex.UnLock();
 
+// Add the redirect cache statistics, if any, and close off our section
+//
+   if (len >= blen) return 0;
+   if (rcP) len += rcP->Stats(buff+len, blen-len);
+   len += snprintf(buff+len, blen-len, "</stats>");
+   if (len >= blen) return 0;
+
 // Now include filesystem statistics and return
 //
    if (fsP) len += fsP->getStats(buff+len, blen-len);
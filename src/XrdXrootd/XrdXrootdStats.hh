@@ -34,6 +34,7 @@
 
 class XrdSfsFileSystem;
 class XrdStats;
+class XrdXrootdRedirCache;
 class XrdXrootdResponse;
 
 class XrdXrootdStats : public XrdOucStats
@@ -70,6 +71,8 @@ int              ignSCnt;      // Stats: Number of signature ignored
 
 void             setFS(XrdSfsFileSystem *fsp) {fsP = fsp;}
 
+void             setRC(XrdXrootdRedirCache *rcp) {rcP = rcp;}
+
 int              Stats(char *buff, int blen, int do_sync=0);
 
 int              Stats(XrdXrootdResponse &resp, const char *opts);
@@ -79,6 +82,7 @@ int              Stats(XrdXrootdResponse &resp, const char *opts);
 private:
 
 XrdSfsFileSystem *fsP;
+XrdXrootdRedirCache *rcP;
 XrdStats *xstats;
 };
 #endif
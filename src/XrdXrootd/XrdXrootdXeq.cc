@@ -41,6 +41,7 @@
 #include "XrdSys/XrdSysError.hh"
 #include "XrdSys/XrdSysPlatform.hh"
 #include "XrdSys/XrdSysTimer.hh"
+#include "XrdAcc/XrdAccAuthorize.hh"
 #include "XrdCks/XrdCksData.hh"
 #include "XrdOuc/XrdOucCloneSeg.hh"
 #include "XrdOuc/XrdOucEnv.hh"
@@ -68,6 +69,7 @@
 #include "XrdXrootd/XrdXrootdPio.hh"
 #include "XrdXrootd/XrdXrootdPrepare.hh"
 #include "XrdXrootd/XrdXrootdProtocol.hh"
+#include "XrdXrootd/XrdXrootdRedirCache.hh"
 #include "XrdXrootd/XrdXrootdRedirHelper.hh"
 #include "XrdXrootd/XrdXrootdRedirPI.hh"
 #include "XrdXrootd/XrdXrootdStats.hh"
@@ -1043,6 +1045,16 @@ int XrdXrootdProtocol::do_Locate()
        if (!doDig && !Squash(Path))return vpEmsg("Locating", Path);
       }
 
+// If we are caching redirects, a file known not to exist need not be located
+// again unless the client asks for a refresh.
+//
+   bool rdcOK = RdrCache && Path && !doDig;
+   if (rdcOK)
+      {if (opts & kXR_refresh) {RdrCache->Drop(Path); rdcOK = false;}
+          else if (fsRdrCache(rc, XROOTD_MON_LOCATE, Path, opaque, false))
+                  return rc;
+      }
+
 // Preform the actual function. For regular Fs add back any opaque info
 //
    if (doDig) rc = digFS->fsctl(fsctl_cmd, fn, myError, CRED);
@@ -1054,6 +1066,12 @@ int XrdXrootdProtocol::do_Locate()
               rc =  osFS->fsctl(fsctl_cmd, fn, myError, CRED);
              }
    TRACEP(FS, "rc=" <<rc <<" locate " <<fn);
+   if (rdcOK)
+      {char *qP = (opaque ? index(Path, '?') : 0);
+       if (qP) *qP = 0;
+       fsRdrSave(rc, myError, Path, false);
+       if (qP) *qP = '?';
+      }
    return fsError(rc, (doDig ? 0 : XROOTD_MON_LOCATE), myError, Path, opaque);
 }
 
@@ -1320,6 +1338,10 @@ int XrdXrootdProtocol::do_Mv()
    if (*newp == '\0')
       Response.Send(kXR_ArgMissing, "new path specified for mv");
 
+// Forget any redirect we may have cached for either path
+//
+   if (RdrCache) {RdrCache->Drop(oldp); RdrCache->Drop(newp);}
+
 // Preform the actual function
 //
    rc = osFS->rename(oldp, newp, myError, CRED, Opaque, Npaque);
@@ -1620,6 +1642,18 @@ int XrdXrootdProtocol::do_Open()
        );
    }
 
+// If we are caching redirects, answer plain read opens from the cache. Other
+// opens may create, truncate, or retry the file so forget what we know.
+//
+   bool rdcOK = false;
+   if (RdrCache && !doDig)
+      {if ('r' == usage && !(opts & kXR_refresh)
+       &&  !(opaque && (strstr(opaque, "tried") || strstr(opaque, "cms."))))
+          {if (fsRdrCache(rc, opC, fn, opaque, true)) return rc;
+           rdcOK = true;
+          } else RdrCache->Drop(fn);
+      }
+
 // Add the multi-write option if this path supports it
 //
    if (popt & XROOTDXP_NOMWCHK) openopts |= SFS_O_MULTIW;
@@ -1686,7 +1720,9 @@ int XrdXrootdProtocol::do_Open()
 //
    if ((rc = fp->open(fn, (XrdSfsFileOpenMode)openopts,
                      (mode_t)mode, CRED, oinfo.c_str())))
-      return fsError(rc, opC, fp->error, fn, opaque);
+      {if (rdcOK) fsRdrSave(rc, fp->error, fn, true);
+       return fsError(rc, opC, fp->error, fn, opaque);
+      }
 
 // If file needs to be cloned, do so now
 //
@@ -2919,6 +2955,10 @@ int XrdXrootdProtocol::do_Rm()
    if (rpCheck(argp->buff, &opaque)) return rpEmsg("Removing", argp->buff);
    if (!Squash(argp->buff))          return vpEmsg("Removing", argp->buff);
 
+// Forget any redirect we may have cached for the file
+//
+   if (RdrCache) RdrCache->Drop(argp->buff);
+
 // Preform the actual function
 //
    rc = osFS->rem(argp->buff, myError, CRED, opaque);
@@ -4137,6 +4177,85 @@ int XrdXrootdProtocol::fsRedirNoEnt(const char *eMsg, char *Cgi, int popt)
    return Response.Send(kXR_redirect, ioV, 4, tlen);
 }
 
+/******************************************************************************/
+/*                            f s R d r C a c h e                             */
+/******************************************************************************/
+
+// The cms picks redirect targets based on the client's network, so does the
+// redirect cache.
+
+namespace
+{
+int rdcNet(int clientPV)
+{
+   return (clientPV & (XrdOucEI::uPrip|XrdOucEI::uIPv4|XrdOucEI::uIPv64)) >> 25;
+}
+}
+
+// Answer a request from the redirect cache. Returns true with the response's
+// return code in rc when it did so and false when the file system must be
+// asked. Only when doPos is true may the answer be a redirect. Either way,
+// the client must be authorized as the file system would do for a read open
+// or a locate. If it is not, the file system is asked so that the client
+// gets the same error it would have without the cache.
+
+bool XrdXrootdProtocol::fsRdrCache(int &rc, char opC, const char *Path,
+                                   char *Cgi, bool doPos)
+{
+   XrdOucErrInfo myError(Link->ID, Monitor.Did, clientPV);
+   std::string host;
+   int port;
+   XrdXrootdRedirCache::Result hit;
+
+   hit = RdrCache->Find(Path, (doPos ? rdcNet(clientPV) : -1), host, port);
+   if (hit == XrdXrootdRedirCache::Miss) return false;
+
+   if (rdcAuth && Client)
+      {XrdOucEnv azEnv(Cgi, 0, Client);
+       if (!rdcAuth->Access(Client, Path, (doPos ? AOP_Read : AOP_Stat),
+                            &azEnv))
+          {TRACEP(FS, "rdrcache hit not authorized " <<Path);
+           return false;
+          }
+      }
+
+   switch(hit)
+         {case XrdXrootdRedirCache::Found:
+               TRACEP(FS, "rdrcache hit " <<Path);
+               myError.setErrInfo(port, host.c_str());
+               rc = fsError(SFS_REDIRECT, opC, myError, Path, Cgi);
+               return true;
+          case XrdXrootdRedirCache::NoEnt:
+               TRACEP(FS, "rdrcache noent " <<Path);
+               myError.setErrInfo(ENOENT, XrdSysE2T(ENOENT));
+               rc = fsError(SFS_ERROR, opC, myError, Path, Cgi);
+               return true;
+          default: break;
+         }
+   return false;
+}
+
+/******************************************************************************/
+/*                             f s R d r S a v e                              */
+/******************************************************************************/
+
+// Record the file system's answer in the redirect cache. Only redirects to a
+// host and port are kept; url redirects carry client specific information.
+
+void XrdXrootdProtocol::fsRdrSave(int rc, XrdOucErrInfo &myError,
+                                  const char *Path, bool doPos)
+{
+   int ecode;
+   const char *eMsg = myError.getErrText(ecode);
+
+   if (rc == SFS_REDIRECT)
+      {if (doPos && rdcHold > 0 && ecode > 0 && eMsg && *eMsg)
+          RdrCache->Add(Path, rdcNet(clientPV), eMsg, ecode);
+      }
+   else if (rc == SFS_ERROR && XProtocol::mapError(ecode) == kXR_NotFound)
+           RdrCache->AddNoEnt(Path);
+}
+
 /******************************************************************************/
 /*                             f s R e d i r P I                              */
 /******************************************************************************/
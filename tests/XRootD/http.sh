@@ -235,6 +235,42 @@ function test_http() {
   HTTP_CONTENTS=$(curl -v -L "${HTTP_HOST}/${TMPDIR}" | tr '"' '\n' | tr '<' '\n' | tr '>' '\n' | grep testlistings/ | wc -l | tr -d ' ')
   assert_eq 2 "$HTTP_CONTENTS"
 
+  ## Large PROPFIND listings are streamed as chunks ending with a zero-length chunk
+  propfindDir="${TMPDIR}/propfind"
+  mkdir -p "${REMOTE_DIR}${propfindDir}"
+  (cd "${REMOTE_DIR}${propfindDir}" && seq -f 'entry_%05g' 3000 | xargs touch)
+  curl -s --raw -i -X PROPFIND -H 'Depth: 1' "${HTTP_HOST}/${propfindDir}" > "$outputFilePath"
+  assert_eq 1 "$(grep -c -i '^Transfer-Encoding: chunked' "$outputFilePath")" "PROPFIND listing was not chunked"
+  assert_eq 0 "$(grep -c -i '^Content-Length:' "$outputFilePath")" "Chunked PROPFIND listing has a Content-Length"
+  propfindEntries=$(python3 - "$outputFilePath" <<'EOF'
+import re, sys
+data = open(sys.argv[1], 'rb').read()
+head, sep, body = data.partition(b'\r\n\r\n')
+assert sep, 'no end of headers'
+chunks = []
+while True:
+    size, sep, body = body.partition(b'\r\n')
+    assert sep and re.fullmatch(rb'[0-9a-fA-F]+', size), 'bad chunk size line %r' % size[:20]
+    size = int(size, 16)
+    if size == 0:
+        assert body == b'\r\n', 'bad final chunk'
+        break
+    assert body[size:size+2] == b'\r\n', 'chunk not terminated by CRLF'
+    chunks.append(body[:size])
+    body = body[size+2:]
+assert len(chunks) > 1, 'listing sent in a single chunk'
+xml = b''.join(chunks)
+assert xml.startswith(b'<?xml') and xml.rstrip().endswith(b'</D:multistatus>'), 'bad multistatus'
+print(xml.count(b'<D:response'))
+EOF
+)
+  assert_eq 3001 "$propfindEntries" "Chunked PROPFIND listing is malformed"
+
+  ## HTTP/1.0 clients get the same listing in one response
+  HTTP_CODE=$(curl -s --http1.0 -X PROPFIND -H 'Depth: 1' --output "$outputFilePath" --write-out '%{http_code}' "${HTTP_HOST}/${propfindDir}")
+  assert_eq 207 "$HTTP_CODE"
+  assert_eq 3001 "$(grep -o '<D:response' "$outputFilePath" | wc -l | tr -d ' ')"
+
   ## OPTIONS has appropriate static headers
   curl -s -X OPTIONS -v --raw "${HTTP_HOST}/$alphabetFilePath" 2>&1 | tr -d '\r' > "$outputFilePath"
   cat "$outputFilePath"
@@ -0,0 +1,178 @@
+//------------------------------------------------------------------------------
+// Unit tests for the shortest-remaining-first policy of XrdBwm.
+//
+// The policy runs on a clock set by the tests, so waiting and transfer times
+// are simulated. The tests cover serving queued requests shortest first,
+// aging of long waiting requests, promotion of requests about to miss their
+// deadline, and the throughput learned from completed transfers.
+//------------------------------------------------------------------------------
+
+#include "XrdBwm/XrdBwmPolicy2.hh"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+const long long MB = 1000000;
+
+// The policy with a clock that only moves when told to
+//
+class TestPolicy : public XrdBwmPolicy2
+{
+public:
+   double theTime = 1000000000;
+
+   TestPolicy(int slots, double aging)
+             : XrdBwmPolicy2(slots, slots, aging, MB, 0) {}
+
+protected:
+   double Now() override {return theTime;}
+};
+
+class XrdBwmPolicy2Test : public ::testing::Test
+{
+protected:
+   // Returns the handle, negative when the request was queued
+   //
+   int Schedule(XrdBwmPolicy2 &policy, long long size, time_t deadline = 0)
+   {
+      XrdBwmPolicy::SchedParms parms = {};
+      parms.Direction = XrdBwmPolicy::Outgoing;
+      parms.Size      = size;
+      parms.Deadline  = deadline;
+      return policy.Schedule(resp, sizeof(resp), parms);
+   }
+
+   // Finish the active request and return the one dispatched in its place.
+   // Dispatch() blocks until a slot is free, so it is only called if one is.
+   //
+   int Next(XrdBwmPolicy2 &policy, int active)
+   {
+      int rc = policy.Done(active);
+      EXPECT_EQ(rc, 1);
+      return (rc == 1 ? policy.Dispatch(resp, sizeof(resp)) : 0);
+   }
+
+   char resp[256];
+};
+
+} // namespace
+
+TEST_F(XrdBwmPolicy2Test, ShortestFirst)
+{
+   TestPolicy policy(1, 0);
+   int numqIn, numqOut, numXeq;
+
+   int a = Schedule(policy, MB);
+   ASSERT_GT(a, 0);
+   int b = Schedule(policy, 10*MB);
+   int c = Schedule(policy, MB);
+   int d = Schedule(policy, 5*MB);
+   ASSERT_LT(b, 0);
+   ASSERT_LT(c, 0);
+   ASSERT_LT(d, 0);
+   policy.Status(numqIn, numqOut, numXeq);
+   EXPECT_EQ(numqOut, 3);
+   EXPECT_EQ(numXeq, 1);
+
+// Queued requests go in order of their expected transfer time
+//
+   EXPECT_EQ(Next(policy, a), -c);
+   EXPECT_EQ(Next(policy, -c), -d);
+   EXPECT_EQ(Next(policy, -d), -b);
+   EXPECT_EQ(policy.Done(b), 1);
+
+// Requests of the same size go in arrival order and a queued request that
+// goes away is simply dropped.
+//
+   a = Schedule(policy, MB);
+   b = Schedule(policy, MB);
+   policy.theTime += 0.001;
+   c = Schedule(policy, MB);
+   policy.theTime += 0.001;
+   d = Schedule(policy, MB);
+   EXPECT_EQ(policy.Done(c), -1);
+   EXPECT_EQ(Next(policy, a), -b);
+   EXPECT_EQ(Next(policy, -b), -d);
+   EXPECT_EQ(policy.Done(d), 1);
+   policy.Status(numqIn, numqOut, numXeq);
+   EXPECT_EQ(numqOut, 0);
+   EXPECT_EQ(numXeq, 0);
+}
+
+TEST_F(XrdBwmPolicy2Test, Aging)
+{
+// The slot is held by a request of unknown size so that its completion does
+// not change the throughput. Without aging a short request overtakes a long
+// one however long it waited.
+//
+   TestPolicy fixed(1, 0);
+   int a = Schedule(fixed, 0);
+   int b = Schedule(fixed, 10*MB);
+   fixed.theTime += 9.5;
+   int c = Schedule(fixed, MB);
+   EXPECT_EQ(Next(fixed, a), -c);
+
+// With aging each second waited counts against the expected time, so the
+// long request is worth 0.5 seconds by the time the short one arrives.
+//
+   TestPolicy aged(1, 1.0);
+   a = Schedule(aged, 0);
+   b = Schedule(aged, 10*MB);
+   aged.theTime += 9.5;
+   c = Schedule(aged, MB);
+   EXPECT_EQ(Next(aged, a), -b);
+   EXPECT_EQ(Next(aged, -b), -c);
+}
+
+TEST_F(XrdBwmPolicy2Test, Deadline)
+{
+   TestPolicy policy(1, 0);
+   time_t start = static_cast<time_t>(policy.theTime);
+
+// A request with time to spare before its deadline waits its turn
+//
+   int a = Schedule(policy, 0);
+   int b = Schedule(policy, 5*MB, start + 10);
+   int c = Schedule(policy, MB);
+   EXPECT_EQ(Next(policy, a), -c);
+
+// Once its slack runs out it goes ahead of shorter requests
+//
+   int d = Schedule(policy, MB);
+   policy.theTime += 4.5;
+   EXPECT_EQ(Next(policy, -c), -b);
+   EXPECT_EQ(Next(policy, -b), -d);
+}
+
+TEST_F(XrdBwmPolicy2Test, LearnedRate)
+{
+   TestPolicy policy(2, 0);
+
+// Until a transfer completes the configured rate is shared by the active
+// transfers.
+//
+   int a = Schedule(policy, MB);
+   ASSERT_GT(a, 0);
+   EXPECT_EQ(std::string(resp), "bwm.eta=1000000001&bwm.rate=1000000");
+
+// Two megabytes that took two seconds with another transfer active show the
+// link delivers two megabytes a second.
+//
+   int b = Schedule(policy, 2*MB);
+   policy.theTime += 2;
+   EXPECT_EQ(policy.Done(b), 1);
+   ASSERT_EQ(policy.Query(a, resp, sizeof(resp)), 1);
+   EXPECT_EQ(std::string(resp), "bwm.eta=1000000002&bwm.rate=2000000");
+
+// Completions too quick to measure teach nothing
+//
+   b = Schedule(policy, 4*MB);
+   EXPECT_EQ(policy.Done(b), 1);
+   ASSERT_EQ(policy.Query(a, resp, sizeof(resp)), 1);
+   EXPECT_EQ(std::string(resp), "bwm.eta=1000000002&bwm.rate=2000000");
+
+   EXPECT_EQ(policy.Done(a), 1);
+   EXPECT_EQ(policy.Query(a, resp, sizeof(resp)), 0);
+}
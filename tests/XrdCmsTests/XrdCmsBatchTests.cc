@@ -0,0 +1,165 @@
+#undef NDEBUG
+
+#include "XrdCms/XrdCmsBatch.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace XrdCms;
+
+// The batcher is tested without a cluster. Nodes are stand-in pointers and
+// what the batcher would write to a node is appended to that node's wire.
+
+namespace
+{
+XrdSysMutex                         wireMutex;
+std::map<XrdCmsNode *, std::string> Wire;
+std::atomic<int>                    numHeld{0};
+
+// When set, a batch write signals inWrite and waits for goOn
+//
+std::atomic<bool>                   stallWrites{false};
+XrdSysSemaphore                     inWrite(0);
+XrdSysSemaphore                     goOn(0);
+
+void Record(XrdCmsNode *nP, const char *buff, int blen)
+{
+   XrdSysMutexHelper mHelp(wireMutex);
+   Wire[nP].append(buff, blen);
+}
+
+std::string OnWire(XrdCmsNode *nP)
+{
+   XrdSysMutexHelper mHelp(wireMutex);
+   return Wire[nP];
+}
+
+// Wait for a node to have received the indicated bytes
+//
+bool WaitFor(XrdCmsNode *nP, const std::string &what)
+{
+   for (int i = 0; i < 400; i++)
+       {if (OnWire(nP) == what) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+       }
+   return false;
+}
+
+bool Queue(XrdCmsNode *nP, const std::string &msg)
+{
+   struct iovec iov = {(void *)msg.data(), msg.size()};
+   return Batch.Queue(nP, &iov, 1);
+}
+
+// This is what XrdCmsNode::Send() does
+//
+void Direct(XrdCmsNode *nP, const std::string &msg)
+{
+   Batch.Flush(nP);
+   Record(nP, msg.data(), (int)msg.size());
+}
+
+int nodeA, nodeB;
+XrdCmsNode *NodeA = reinterpret_cast<XrdCmsNode *>(&nodeA);
+XrdCmsNode *NodeB = reinterpret_cast<XrdCmsNode *>(&nodeB);
+}
+
+void XrdCmsBatch::Hold(XrdCmsNode *nP) {numHeld++;}
+
+void XrdCmsBatch::Drop(XrdCmsNode *nP) {numHeld--;}
+
+void XrdCmsBatch::Write(XrdCmsNode *nP, const char *buff, int blen, int mnum)
+{
+   if (stallWrites) {inWrite.Post(); goOn.Wait();}
+   Record(nP, buff, blen);
+}
+
+class XrdCmsBatchTest : public ::testing::Test
+{
+protected:
+   static void SetUpTestSuite()
+   {
+      ASSERT_EQ(Batch.Init(100, 64), 0);
+      ASSERT_TRUE(Batch.Active());
+   }
+
+   void SetUp() override
+   {
+      XrdSysMutexHelper mHelp(wireMutex);
+      Wire.clear();
+   }
+
+   void TearDown() override
+   {
+      Batch.Flush(NodeA);
+      Batch.Flush(NodeB);
+      EXPECT_EQ(numHeld.load(), 0);
+   }
+};
+
+TEST_F(XrdCmsBatchTest, Window)
+{
+// Queued messages go out together once the window closes
+//
+   EXPECT_TRUE(Queue(NodeA, "q1;"));
+   EXPECT_TRUE(Queue(NodeB, "b1;"));
+   EXPECT_TRUE(Queue(NodeA, "q2;"));
+   EXPECT_TRUE(WaitFor(NodeA, "q1;q2;"));
+   EXPECT_TRUE(WaitFor(NodeB, "b1;"));
+}
+
+TEST_F(XrdCmsBatchTest, DirectAfterQueued)
+{
+// A direct send goes out after what was queued for the node without waiting
+// for the window; other nodes' batches are left alone.
+//
+   EXPECT_TRUE(Queue(NodeA, "q1;"));
+   EXPECT_TRUE(Queue(NodeB, "b1;"));
+   EXPECT_TRUE(Queue(NodeA, "q2;"));
+   Direct(NodeA, "d1;");
+   EXPECT_EQ(OnWire(NodeA), "q1;q2;d1;");
+
+// What is queued afterwards starts a new batch
+//
+   EXPECT_TRUE(Queue(NodeA, "q3;"));
+   EXPECT_TRUE(WaitFor(NodeA, "q1;q2;d1;q3;"));
+   EXPECT_TRUE(WaitFor(NodeB, "b1;"));
+}
+
+TEST_F(XrdCmsBatchTest, TooLarge)
+{
+// A message too large to batch is sent directly and must still follow the
+// ones queued before it.
+//
+   std::string big(XrdCmsBatch::maxBytes + 1, 'x');
+   EXPECT_TRUE(Queue(NodeA, "q1;"));
+   if (!Queue(NodeA, big)) Direct(NodeA, big);
+   EXPECT_EQ(OnWire(NodeA), "q1;" + big);
+}
+
+TEST_F(XrdCmsBatchTest, DirectWhileSending)
+{
+// The flusher takes the batch and is held up writing it. A direct send
+// must wait for that write rather than overtake it.
+//
+   stallWrites = true;
+   EXPECT_TRUE(Queue(NodeA, "q1;"));
+   inWrite.Wait();
+   stallWrites = false;
+
+   std::atomic<bool> sent{false};
+   std::thread direct([&] {Direct(NodeA, "d1;"); sent = true;});
+   std::this_thread::sleep_for(std::chrono::milliseconds(50));
+   EXPECT_FALSE(sent.load());
+   EXPECT_EQ(OnWire(NodeA), "");
+
+   goOn.Post();
+   direct.join();
+   EXPECT_EQ(OnWire(NodeA), "q1;d1;");
+}
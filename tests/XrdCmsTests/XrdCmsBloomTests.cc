@@ -0,0 +1,66 @@
+#undef NDEBUG
+
+#include "XrdCms/XrdCmsBloom.hh"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+static std::string FileName(int i)
+{
+   return "/store/data/run" + std::to_string(i/100) + "/f" + std::to_string(i);
+}
+
+// The hash travels between hosts as part of the filter so it must not change
+//
+TEST(XrdCmsBloom, Hash)
+{
+   EXPECT_EQ(XrdCmsBloom::Hash(""),  0xcbf29ce484222325ULL);
+   EXPECT_EQ(XrdCmsBloom::Hash("a"), 0xaf63dc4c8601ec8cULL);
+   EXPECT_NE(XrdCmsBloom::Hash("/a/b"), XrdCmsBloom::Hash("/a/c"));
+}
+
+TEST(XrdCmsBloom, Sizing)
+{
+   EXPECT_EQ(XrdCmsBloom::Size(0, 8), 1024);
+   EXPECT_EQ(XrdCmsBloom::Size(100000, 10), 125000);
+   EXPECT_EQ(XrdCmsBloom::Size(1LL<<40, 10), XrdCmsBloom::maxBytes);
+   EXPECT_EQ(XrdCmsBloom::HashCnt(10), 7);
+   EXPECT_EQ(XrdCmsBloom::HashCnt(1),  1);
+   EXPECT_EQ(XrdCmsBloom::HashCnt(64), 16);
+}
+
+// There are never false negatives and false positives stay near the expected
+// rate, which is about 1% for 10 bits per name.
+//
+TEST(XrdCmsBloom, Membership)
+{
+   const int n = 20000;
+   XrdCmsBloom bf(XrdCmsBloom::Size(n, 10), XrdCmsBloom::HashCnt(10));
+   int fp = 0;
+
+   for (int i = 0; i < n; i++) bf.Add(FileName(i).c_str());
+   for (int i = 0; i < n; i++) ASSERT_TRUE(bf.Test(FileName(i).c_str()));
+   for (int i = n; i < 2*n; i++) if (bf.Test(FileName(i).c_str())) fp++;
+   EXPECT_LT(fp, n/50);
+}
+
+// A filter copied piecewise answers exactly like the original
+//
+TEST(XrdCmsBloom, GetPut)
+{
+   XrdCmsBloom src(5000, 5), dst(5000, 5);
+   char buff[1024];
+   int n, offs = 0;
+
+   for (int i = 0; i < 1000; i++) src.Add(FileName(i).c_str());
+   while((n = src.Get(offs, buff, sizeof(buff))))
+        {EXPECT_EQ(dst.Put(offs, buff, n), n);
+         offs += n;
+        }
+   EXPECT_EQ(offs, 5000);
+   EXPECT_EQ(dst.Put(5000, buff, 1), 0);
+   for (int i = 0; i < 2000; i++)
+       EXPECT_EQ(dst.Test(FileName(i).c_str()), src.Test(FileName(i).c_str()));
+}
@@ -0,0 +1,117 @@
+#undef NDEBUG
+
+#include "XrdCms/XrdCmsTypes.hh"
+#include "XrdCms/XrdCmsHRW.hh"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// These tests use the server mask the cmsd is built with. They are most
+// useful when built with XRDCMS_MAXNODES above 64 (see the CI workflow) as
+// they then cover nodes beyond the first 64 bits of the mask.
+
+namespace
+{
+// A cell of STMax nodes, each with its own mask bit and hash key
+//
+struct Cell
+{
+   SMask_t            Mask[STMax];
+   unsigned long long Key[STMax];
+
+   Cell()
+       {for (int i = 0; i < STMax; i++)
+            {Mask[i] = XrdCmsMaskBit(i);
+             Key[i]  = XrdCmsHRW::Hash(("srv" + std::to_string(i)
+                                        + ".example.org").c_str(), 1094);
+            }
+       }
+
+// Select a node for a file among those in the file's mask the way the
+// cluster does for the hash policy: scan the table for candidates and pick
+// the highest ranking one.
+//
+   int Select(SMask_t fMask, unsigned long long file)
+       {std::vector<int> cand;
+        for (int i = 0; i < STMax; i++)
+            if (Mask[i] & fMask) cand.push_back(i);
+        if (cand.empty()) return -1;
+        int k = XrdCmsHRW::Pick(static_cast<int>(cand.size()), file,
+                                [&](int j) {return Key[cand[j]];},
+                                [](int) {return 1;},
+                                [](int) {return false;});
+        return cand[k];
+       }
+};
+
+unsigned long long File(int i)
+{
+   return XrdCmsHRW::Hash(("/store/data/file" + std::to_string(i)).c_str());
+}
+}
+
+TEST(XrdCmsCell, MaskBits)
+{
+   Cell cell;
+   SMask_t all = 0;
+
+   for (int i = 0; i < STMax; i++)
+       {EXPECT_EQ(XrdCmsMaskCnt(cell.Mask[i]), 1);
+        EXPECT_EQ(XrdCmsMaskLow(cell.Mask[i]), i);
+        EXPECT_TRUE((all & cell.Mask[i]) == 0) << "node " << i;
+        all |= cell.Mask[i];
+       }
+   EXPECT_EQ(all, FULLMASK);
+   EXPECT_EQ(XrdCmsMaskCnt(all), STMax);
+   EXPECT_FALSE(XrdCmsMaskBit(STMax));
+   EXPECT_FALSE(XrdCmsMaskBit(-1));
+}
+
+TEST(XrdCmsCell, Selection)
+{
+   Cell cell;
+   const int hi = STMax - 1, mid = STMax / 2 + 1;
+
+// A file on a single node is found through the lowest bit of its mask, as
+// in shared-nothing clusters.
+//
+   SMask_t one = cell.Mask[hi];
+   EXPECT_FALSE(XrdCmsMaskMulti(one));
+   EXPECT_EQ(XrdCmsMaskLow(one), hi);
+   EXPECT_EQ(cell.Select(one, File(0)), hi);
+
+// A file on several nodes goes to one of them and always the same one
+//
+   SMask_t some = cell.Mask[3] | cell.Mask[mid] | cell.Mask[hi];
+   EXPECT_TRUE(XrdCmsMaskMulti(some));
+   EXPECT_EQ(XrdCmsMaskLow(some), 3);
+   std::vector<int> hits(STMax, 0);
+   for (int f = 0; f < 3000; f++)
+       {int n = cell.Select(some, File(f));
+        ASSERT_TRUE(n == 3 || n == mid || n == hi) << "picked node " << n;
+        EXPECT_EQ(cell.Select(some, File(f)), n);
+        hits[n]++;
+       }
+   EXPECT_GT(hits[3],   800);
+   EXPECT_GT(hits[mid], 800);
+   EXPECT_GT(hits[hi],  800);
+
+// Every node in a full cell gets files, the top ones included
+//
+   std::vector<int> all(STMax, 0);
+   for (int f = 0; f < 200 * STMax; f++) all[cell.Select(FULLMASK, File(f))]++;
+   for (int i = 0; i < STMax; i++) EXPECT_GT(all[i], 100) << "node " << i;
+
+// When the top node leaves only its files move
+//
+   SMask_t left = FULLMASK & ~cell.Mask[hi];
+   EXPECT_EQ(XrdCmsMaskCnt(left), STMax - 1);
+   for (int f = 0; f < 2000; f++)
+       {int was = cell.Select(FULLMASK, File(f));
+        int now = cell.Select(left, File(f));
+        EXPECT_NE(now, hi);
+        if (was != hi) {EXPECT_EQ(now, was) << "file " << f;}
+       }
+}
@@ -0,0 +1,145 @@
+#undef NDEBUG
+
+#include "XrdCms/XrdCmsHRW.hh"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+// Pick a node for a file among the nodes given by their keys and weights
+// without any load bound.
+//
+int PickOf(const std::vector<unsigned long long> &keys,
+           const std::vector<int> &wts, unsigned long long file)
+{
+   return XrdCmsHRW::Pick(static_cast<int>(keys.size()), file,
+                          [&](int k) {return keys[k];},
+                          [&](int k) {return wts[k];},
+                          [](int) {return false;});
+}
+
+std::vector<unsigned long long> Nodes(int n)
+{
+   std::vector<unsigned long long> keys;
+   for (int i = 0; i < n; i++)
+       keys.push_back(XrdCmsHRW::Hash(("srv" + std::to_string(i)
+                                       + ".example.org").c_str(), 1094));
+   return keys;
+}
+
+unsigned long long File(int i)
+{
+   return XrdCmsHRW::Hash(("/store/data/file" + std::to_string(i)).c_str());
+}
+}
+
+TEST(XrdCmsHRW, Hash)
+{
+   EXPECT_EQ(XrdCmsHRW::Hash(""), 0xcbf29ce484222325ULL);
+   EXPECT_EQ(XrdCmsHRW::Hash("a"), 0xaf63dc4c8601ec8cULL);
+   EXPECT_NE(XrdCmsHRW::Hash("host", 1094), XrdCmsHRW::Hash("host", 1095));
+   EXPECT_EQ(XrdCmsHRW::Hash("host", 0), XrdCmsHRW::Hash("host"));
+}
+
+TEST(XrdCmsHRW, Deterministic)
+{
+   std::vector<unsigned long long> keys = Nodes(8), rev(keys.rbegin(),
+                                                        keys.rend());
+   std::vector<int> wts(8, 1);
+
+// The same file always goes to the same node regardless of node order
+//
+   for (int i = 0; i < 1000; i++)
+       {int k = PickOf(keys, wts, File(i));
+        ASSERT_GE(k, 0);
+        EXPECT_EQ(k, PickOf(keys, wts, File(i)));
+        EXPECT_EQ(keys[k], rev[PickOf(rev, wts, File(i))]);
+       }
+   EXPECT_EQ(PickOf({}, {}, File(0)), -1);
+}
+
+TEST(XrdCmsHRW, MinimalRemap)
+{
+   const int nNodes = 10, nFiles = 20000;
+   std::vector<unsigned long long> keys = Nodes(nNodes), less = keys;
+   std::vector<int> wts(nNodes, 1), lwts(nNodes-1, 1);
+   int moved = 0, owned = 0;
+
+// Removing a node moves only the files that node had
+//
+   less.erase(less.begin() + 3);
+   for (int i = 0; i < nFiles; i++)
+       {unsigned long long before = keys[PickOf(keys, wts, File(i))];
+        unsigned long long after  = less[PickOf(less, lwts, File(i))];
+        if (before == keys[3]) owned++;
+           else if (before != after) moved++;
+       }
+   EXPECT_EQ(moved, 0);
+   EXPECT_NEAR(owned, nFiles/nNodes, nFiles/nNodes/5);
+}
+
+TEST(XrdCmsHRW, Weights)
+{
+   std::vector<unsigned long long> keys = Nodes(3);
+   std::vector<int> wts = {1, 2, 5};
+   int cnt[3] = {0, 0, 0};
+   const int nFiles = 40000;
+
+// Files spread in proportion to the weights
+//
+   for (int i = 0; i < nFiles; i++) cnt[PickOf(keys, wts, File(i))]++;
+   EXPECT_NEAR(cnt[0], nFiles*1/8, nFiles/50);
+   EXPECT_NEAR(cnt[1], nFiles*2/8, nFiles/50);
+   EXPECT_NEAR(cnt[2], nFiles*5/8, nFiles/50);
+}
+
+TEST(XrdCmsHRW, Full)
+{
+// With no history nobody is full
+//
+   EXPECT_FALSE(XrdCmsHRW::Full(0, 1, 0, 4, 25));
+
+// Four equal nodes and 100 recent selections: the share is 25 and with 25%
+// overload a node may have taken up to 31.
+//
+   EXPECT_FALSE(XrdCmsHRW::Full(30, 1, 100, 4, 25));
+   EXPECT_TRUE (XrdCmsHRW::Full(32, 1, 100, 4, 25));
+   EXPECT_TRUE (XrdCmsHRW::Full(26, 1, 100, 4, 0));
+   EXPECT_FALSE(XrdCmsHRW::Full(60, 3, 100, 4, 0));
+   EXPECT_FALSE(XrdCmsHRW::Full(99, 1, 100, 0, 0));
+}
+
+TEST(XrdCmsHRW, Spill)
+{
+   std::vector<unsigned long long> keys = Nodes(4);
+   std::vector<int> recent(4, 0);
+   int total = 0;
+
+// Hammer a single file. Its owner takes the first selections and the load
+// spills over to the next ranked nodes once it is over its bound.
+//
+   int owner = PickOf(keys, std::vector<int>(4, 1), File(7));
+   for (int i = 0; i < 400; i++)
+       {int k = XrdCmsHRW::Pick(4, File(7),
+                                [&](int j) {return keys[j];},
+                                [](int) {return 1;},
+                                [&](int j) {return XrdCmsHRW::Full(recent[j], 1,
+                                                     total, 4, 25);});
+        if (i == 0) {EXPECT_EQ(k, owner);}
+        recent[k]++; total++;
+       }
+   for (int i = 0; i < 4; i++)
+       {EXPECT_LE(recent[i], 126);
+        EXPECT_GT(recent[i], 0);
+       }
+
+// When everyone is full the owner is still chosen
+//
+   EXPECT_EQ(XrdCmsHRW::Pick(4, File(7),
+                             [&](int j) {return keys[j];},
+                             [](int) {return 1;},
+                             [](int) {return true;}), owner);
+}
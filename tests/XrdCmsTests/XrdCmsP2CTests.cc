@@ -0,0 +1,96 @@
+#undef NDEBUG
+
+#include "XrdCms/XrdCmsP2C.hh"
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(XrdCmsP2C, Ewma)
+{
+   int avg = XrdCmsP2C::Ewma(0, 800);
+   EXPECT_EQ(avg, 800);
+   EXPECT_EQ(XrdCmsP2C::Ewma(0, 0), 1);
+
+// The average moves an eighth of the way and converges on a steady sample
+//
+   EXPECT_EQ(XrdCmsP2C::Ewma(avg, 1600), 900);
+   for (int i = 0; i < 100; i++) avg = XrdCmsP2C::Ewma(avg, 5000);
+   EXPECT_NEAR(avg, 5000, 8);
+}
+
+TEST(XrdCmsP2C, Decay)
+{
+   long long stamp = 1000000;
+
+   EXPECT_EQ(XrdCmsP2C::Decay(64, stamp, 1500000, 1000000), 64);
+   EXPECT_EQ(stamp, 1000000);
+   EXPECT_EQ(XrdCmsP2C::Decay(64, stamp, 3500000, 1000000), 16);
+   EXPECT_EQ(stamp, 3000000);
+   EXPECT_EQ(XrdCmsP2C::Decay(16, stamp, 4000000, 1000000), 8);
+   EXPECT_EQ(XrdCmsP2C::Decay(8, stamp, 1LL<<50, 1000000), 0);
+}
+
+TEST(XrdCmsP2C, Score)
+{
+   EXPECT_LT(XrdCmsP2C::Score(100, 0, 0), XrdCmsP2C::Score(5000, 0, 0));
+   EXPECT_LT(XrdCmsP2C::Score(100, 0, 0), XrdCmsP2C::Score(100, 1, 0));
+   EXPECT_LT(XrdCmsP2C::Score(100, 0, 0), XrdCmsP2C::Score(100, 0, 50));
+   EXPECT_EQ(XrdCmsP2C::Score(0, 0, 0),   XrdCmsP2C::Score(0, 0, 0));
+}
+
+// A node that was never timed is scored with the average latency of those
+// that were, so it is neither the best nor the worst on latency alone.
+//
+TEST(XrdCmsP2C, Untimed)
+{
+   EXPECT_EQ(XrdCmsP2C::Latency(0, 6000, 2), 3000);
+   EXPECT_EQ(XrdCmsP2C::Latency(500, 6000, 2), 500);
+   EXPECT_EQ(XrdCmsP2C::Latency(0, 0, 0), 0);
+
+   int fast = 2000, slow = 4000;
+   long long untimed = XrdCmsP2C::Score(XrdCmsP2C::Latency(0, fast+slow, 2),
+                                        0, 0);
+   EXPECT_GT(untimed, XrdCmsP2C::Score(fast, 0, 0));
+   EXPECT_LT(untimed, XrdCmsP2C::Score(slow, 0, 0));
+}
+
+// Concurrent selections decay and bump the same count; none may be lost and
+// the count must decay as a whole.
+//
+TEST(XrdCmsP2C, Recent)
+{
+   XrdCmsP2C::Recent recent;
+   std::vector<std::thread> sel;
+
+   for (int t = 0; t < 4; t++)
+       sel.emplace_back([&recent]
+                        {for (int i = 0; i < 20000; i++)
+                             recent.Count(500000, 1000000, 1);
+                        });
+   for (auto &t : sel) t.join();
+   EXPECT_EQ(recent.Count(500000, 1000000), 80000);
+   EXPECT_EQ(recent.Count(1000000, 1000000), 40000);
+   EXPECT_EQ(recent.Count(1500000, 1000000), 40000);
+   EXPECT_EQ(recent.Count(3000000, 1000000), 10000);
+}
+
+// The worst candidate can never win a comparison and no other candidate is
+// starved, which is what keeps requests from herding.
+//
+TEST(XrdCmsP2C, Pick)
+{
+   std::minstd_rand rng(7);
+   std::vector<int> hits(8, 0);
+   auto score = [](int k) {return static_cast<long long>(k);};
+
+   EXPECT_EQ(XrdCmsP2C::Pick(0, rng, score), -1);
+   EXPECT_EQ(XrdCmsP2C::Pick(1, rng, score),  0);
+
+   for (int i = 0; i < 8000; i++) hits[XrdCmsP2C::Pick(8, rng, score)]++;
+   EXPECT_EQ(hits[7], 0);
+   for (int k = 0; k < 7; k++) EXPECT_GT(hits[k], 0);
+   for (int k = 1; k < 7; k++) EXPECT_GT(hits[k-1], hits[k]);
+}
@@ -0,0 +1,293 @@
+#undef NDEBUG
+
+#include "XrdCms/XrdCmsRRQ.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+// Records every request answered, including those chained to the slot.
+//
+class Recorder : public XrdCmsRRQ::Answerer
+{
+public:
+
+void Answer(XrdCmsRRQSlot *sp) override
+{
+   XrdCmsRRQSlot *xp;
+
+   Record(sp, sp);
+   for (xp = sp->nextLkUp(); xp; xp = xp->nextLkUp()) Record(xp, sp);
+   for (xp = sp->nextCont(); xp; xp = xp->nextCont()) Record(xp, sp);
+}
+
+     Recorder(int maxID) : Count(maxID+1, 0), Arg1(maxID+1, 0), Arg2(maxID+1, 0) {}
+
+std::vector<int>     Count;
+std::vector<SMask_t> Arg1;
+std::vector<SMask_t> Arg2;
+int                  Total = 0;
+
+private:
+
+void Record(XrdCmsRRQSlot *xp, XrdCmsRRQSlot *hp)
+{
+   unsigned int id = xp->getInfo().ID;
+
+   ASSERT_LT(id, Count.size());
+   Count[id]++; Total++;
+   Arg1[id] = hp->getArg1();
+   Arg2[id] = hp->getArg2();
+}
+};
+
+void *KeyOf(unsigned int id) {return reinterpret_cast<void *>(uintptr_t(id) * 16);}
+
+XrdCmsRRQInfo Request(unsigned int id, bool isLU = false, int minR = 0)
+{
+   XrdCmsRRQInfo info(1, 1, id, minR);
+   info.Key  = KeyOf(id);
+   info.isLU = isLU;
+   return info;
+}
+
+// Expire everything that is waiting by running the clock past its deadline
+//
+void ExpireAll(XrdCmsRRQ &rrq)
+{
+   for (int i = 0; i < 4; i++) rrq.Expire(rrq.Tick());
+}
+
+// Take every free slot to count them, then give them all back
+//
+int FreeSlots(XrdCmsRRQ &rrq)
+{
+   XrdCmsRRQInfo info = Request(1);
+   Recorder rec(1);
+   int n = 0;
+
+   while(rrq.Add(0, &info)) n++;
+   ExpireAll(rrq);
+   EXPECT_EQ(rrq.Serve(rec), n);
+   return n;
+}
+}
+
+TEST(XrdCmsRRQ, ReadyAnswers)
+{
+   auto rrq = std::make_unique<XrdCmsRRQ>();
+   Recorder rec(10);
+   XrdCmsRRQInfo info = Request(1);
+   short snum;
+
+   snum = rrq->Add(0, &info);
+   ASSERT_GT(snum, 0);
+   EXPECT_EQ(rrq->Serve(rec), 0);
+
+// A response for a different key is ignored
+//
+   EXPECT_EQ(rrq->Ready(snum, KeyOf(2), XrdCmsMaskBit(3), 0), 1);
+   EXPECT_EQ(rrq->Serve(rec), 0);
+
+   EXPECT_EQ(rrq->Ready(snum, KeyOf(1), XrdCmsMaskBit(3), XrdCmsMaskBit(4)), 1);
+   EXPECT_EQ(rrq->Serve(rec), 1);
+   EXPECT_EQ(rec.Count[1], 1);
+   EXPECT_TRUE(rec.Arg1[1] == XrdCmsMaskBit(3));
+   EXPECT_TRUE(rec.Arg2[1] == XrdCmsMaskBit(4));
+
+// The slot is free now so late responses go nowhere
+//
+   EXPECT_EQ(rrq->Ready(snum, KeyOf(1), XrdCmsMaskBit(5), 0), 1);
+   ExpireAll(*rrq);
+   EXPECT_EQ(rrq->Serve(rec), 0);
+   EXPECT_EQ(rec.Total, 1);
+
+   XrdCmsRRQ::Info stats;
+   rrq->Statistics(stats);
+   EXPECT_EQ(stats.Add2Q, 1);
+   EXPECT_EQ(stats.Waits, 1);
+}
+
+TEST(XrdCmsRRQ, PiggyBack)
+{
+   auto rrq = std::make_unique<XrdCmsRRQ>();
+   Recorder rec(10);
+   XrdCmsRRQInfo info1 = Request(1);
+   XrdCmsRRQInfo info2 = Request(2, true);
+   XrdCmsRRQInfo info3 = Request(3);
+   XrdCmsRRQInfo info4 = Request(4);
+   short snum;
+
+// Requests for the same key ride along with the first one, others do not
+//
+   info2.Key = info3.Key = info1.Key;
+   snum = rrq->Add(0, &info1);
+   ASSERT_GT(snum, 0);
+   EXPECT_EQ(rrq->Add(snum, &info2), snum);
+   EXPECT_EQ(rrq->Add(snum, &info3), snum);
+   EXPECT_NE(rrq->Add(snum, &info4), snum);
+
+   rrq->Ready(snum, info1.Key, XrdCmsMaskBit(7), 0);
+   EXPECT_EQ(rrq->Serve(rec), 1);
+   for (int i = 1; i <= 3; i++)
+       {EXPECT_EQ(rec.Count[i], 1) <<"request " <<i;
+        EXPECT_TRUE(rec.Arg1[i] == XrdCmsMaskBit(7)) <<"request " <<i;
+       }
+   EXPECT_EQ(rec.Count[4], 0);
+
+   ExpireAll(*rrq);
+   EXPECT_EQ(rrq->Serve(rec), 1);
+   EXPECT_EQ(rec.Count[4], 1);
+   EXPECT_FALSE(rec.Arg1[4]);
+
+   XrdCmsRRQ::Info stats;
+   rrq->Statistics(stats);
+   EXPECT_EQ(stats.PBack, 2);
+   EXPECT_EQ(stats.Waits, 4);
+}
+
+TEST(XrdCmsRRQ, MinResponses)
+{
+   auto rrq = std::make_unique<XrdCmsRRQ>();
+   Recorder rec(10);
+   XrdCmsRRQInfo info = Request(1, false, 1);
+   short snum;
+
+   snum = rrq->Add(0, &info);
+   ASSERT_GT(snum, 0);
+   EXPECT_EQ(rrq->Ready(snum, info.Key, XrdCmsMaskBit(1), 0), 0);
+   EXPECT_EQ(rrq->Serve(rec), 0);
+   EXPECT_EQ(rrq->Ready(snum, info.Key, XrdCmsMaskBit(2), 0), 1);
+   EXPECT_EQ(rrq->Serve(rec), 1);
+   EXPECT_TRUE(rec.Arg1[1] == (XrdCmsMaskBit(1) | XrdCmsMaskBit(2)));
+}
+
+TEST(XrdCmsRRQ, TimeOut)
+{
+   auto rrq = std::make_unique<XrdCmsRRQ>();
+   Recorder rec(10);
+   XrdCmsRRQInfo info1 = Request(1), info2 = Request(2);
+   short snum1, snum2;
+
+// A request waits for the tick after the one it was added in
+//
+   snum1 = rrq->Add(0, &info1);
+   snum2 = rrq->Add(0, &info2);
+   ASSERT_GT(snum1, 0);
+   ASSERT_GT(snum2, 0);
+   EXPECT_EQ(rrq->Expire(rrq->Tick()), 0);
+   EXPECT_EQ(rrq->Serve(rec), 0);
+
+// A deleted request is answered without servers and is not expired again
+//
+   rrq->Del(snum2, info2.Key);
+   EXPECT_EQ(rrq->Expire(rrq->Tick()), 1);
+   EXPECT_EQ(rrq->Serve(rec), 2);
+   EXPECT_EQ(rec.Count[1], 1);
+   EXPECT_EQ(rec.Count[2], 1);
+   EXPECT_FALSE(rec.Arg1[1]);
+   EXPECT_FALSE(rec.Arg1[2]);
+
+   ExpireAll(*rrq);
+   EXPECT_EQ(rrq->Serve(rec), 0);
+}
+
+TEST(XrdCmsRRQ, SlotsAreReused)
+{
+   auto rrq = std::make_unique<XrdCmsRRQ>();
+
+// Slot zero means no slot so one less than the table size is usable
+//
+   EXPECT_EQ(FreeSlots(*rrq), 1023);
+   EXPECT_EQ(FreeSlots(*rrq), 1023);
+}
+
+// Several threads add requests, answer some of them, delete some and leave the
+// rest to time out, while other threads run the clock and answer ready slots.
+// Every request added must be answered exactly once and no slot may be lost.
+//
+TEST(XrdCmsRRQ, Stress)
+{
+   static const int numProd = 4;
+   static const int numReq  = 20000;
+   static const unsigned int maxID = numProd * numReq * 2;
+   auto rrq = std::make_unique<XrdCmsRRQ>();
+   Recorder rec(maxID);
+   std::vector<char> added(maxID+1, 0), deleted(maxID+1, 0);
+   std::atomic<int> producing(numProd);
+   std::atomic<bool> done(false);
+   std::vector<std::thread> threads;
+   int numAdded = 0;
+
+   for (int p = 0; p < numProd; p++)
+       threads.emplace_back([&, p]()
+          {for (int i = 0; i < numReq; i++)
+               {unsigned int id = p * numReq + i + 1;
+                unsigned int pb = id + numProd * numReq;
+                XrdCmsRRQInfo info = Request(id);
+                SMask_t mask = XrdCmsMaskBit(id % STMax);
+                short snum;
+
+                while(!(snum = rrq->Add(0, &info))) std::this_thread::yield();
+                added[id] = 1;
+
+                switch(i % 4)
+                      {case 0: rrq->Ready(snum, info.Key, mask, 0);
+                               break;
+                       case 1: rrq->Del(snum, info.Key);
+                               deleted[id] = 1;
+                               break;
+                       case 2: break;
+                       case 3: {XrdCmsRRQInfo info2 = Request(pb, i & 4);
+                                info2.Key = info.Key;
+                                if (rrq->Add(snum, &info2)) added[pb] = 1;
+                                rrq->Ready(snum, info.Key, mask, 0);
+                               }
+                               break;
+                      }
+               }
+           producing--;
+          });
+
+   threads.emplace_back([&]()
+      {while(!done)
+            {rrq->Expire(rrq->Tick());
+             std::this_thread::yield();
+            }
+      });
+
+   do {if (!rrq->Serve(rec)) std::this_thread::yield();}
+      while(producing.load() > 0);
+
+// Let whatever is still waiting time out
+//
+   for (int i = 0; i < 64; i++)
+       {rrq->Serve(rec);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+       }
+   done = true;
+   for (auto &t : threads) t.join();
+   ExpireAll(*rrq);
+   rrq->Serve(rec);
+
+   for (unsigned int id = 1; id <= maxID; id++)
+       {if (added[id]) numAdded++;
+        ASSERT_EQ(rec.Count[id], added[id]) <<"request " <<id;
+        if (deleted[id]) {EXPECT_FALSE(rec.Arg1[id]) <<"request " <<id;}
+       }
+   EXPECT_EQ(rec.Total, numAdded);
+
+   XrdCmsRRQ::Info stats;
+   rrq->Statistics(stats);
+   EXPECT_EQ(stats.Add2Q, numAdded);
+   EXPECT_EQ(stats.Waits, numAdded);
+
+   EXPECT_EQ(FreeSlots(*rrq), 1023);
+}
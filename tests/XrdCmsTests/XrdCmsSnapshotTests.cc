@@ -0,0 +1,147 @@
+#undef NDEBUG
+
+#include "XrdCms/XrdCmsSnapshot.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+struct Item
+{
+   std::atomic<bool> alive{true};
+};
+
+struct Table
+{
+   Item *item;
+   int   a;
+   int   b;
+   Table() : item(0), a(0), b(0) {}
+};
+}
+
+TEST(XrdCmsSnapshot, PublishRead)
+{
+   XrdCmsSnapshot<Table> snap;
+
+   {XrdCmsSnapshot<Table>::Reader rd(snap);
+    EXPECT_EQ(rd->a, 0);
+   }
+
+   Table t;
+   for (int i = 1; i <= 3; i++)
+       {t.a = i; t.b = -i;
+        snap.Publish(t);
+        XrdCmsSnapshot<Table>::Reader rd(snap);
+        EXPECT_EQ(rd->a, i);
+        EXPECT_EQ((*rd).b, -i);
+       }
+   EXPECT_EQ(snap.Publishes(), 3);
+}
+
+// Readers must always see a consistent copy and anything that the writer
+// retires after Publish() returns must no longer be visible to any reader.
+//
+TEST(XrdCmsSnapshot, GracePeriod)
+{
+   XrdCmsSnapshot<Table> snap;
+   std::atomic<bool> done{false};
+   std::atomic<long long> bad{0}, reads{0};
+   std::vector<Item> items(256);
+   std::vector<std::thread> readers;
+   Table t;
+
+   t.item = &items[0];
+   snap.Publish(t);
+
+   for (int i = 0; i < 2; i++)
+       readers.emplace_back([&]()
+          {while(!done)
+                {XrdCmsSnapshot<Table>::Reader rd(snap);
+                 if (rd->a != -rd->b || !rd->item->alive) bad++;
+                 reads++;
+                }
+          });
+
+   while(reads < 100) std::this_thread::yield();
+   for (size_t i = 1; i < items.size(); i++)
+       {Item *old = t.item;
+        t.item = &items[i]; t.a = i; t.b = -t.a;
+        snap.Publish(t);
+        old->alive = false;
+        std::this_thread::yield();
+       }
+   done = true;
+   for (auto &th : readers) th.join();
+
+   EXPECT_EQ(bad, 0);
+}
+
+// Informational: compare how long readers take to get at the table while a
+// writer keeps updating it, using the snapshot and a read/write lock.
+//
+namespace
+{
+template<class F>
+void ReadLatency(const char *what, F doRead, std::function<void()> doWrite)
+{
+   std::atomic<bool> done{false};
+   std::vector<std::vector<double>> lats(4);
+   std::vector<std::thread> readers;
+
+   for (int i = 0; i < 4; i++)
+       readers.emplace_back([&, i]()
+          {lats[i].reserve(200000);
+           while(!done && lats[i].size() < 200000)
+                {auto t0 = std::chrono::steady_clock::now();
+                 doRead();
+                 auto t1 = std::chrono::steady_clock::now();
+                 lats[i].push_back(
+                     std::chrono::duration<double,std::nano>(t1-t0).count());
+                }
+          });
+
+   for (int i = 0; i < 2000; i++)
+       {doWrite();
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+       }
+   done = true;
+   for (auto &th : readers) th.join();
+
+   std::vector<double> all;
+   for (auto &v : lats) all.insert(all.end(), v.begin(), v.end());
+   std::sort(all.begin(), all.end());
+   auto pct = [&all](double p) {return all[(size_t)(p*(all.size()-1))];};
+   std::cout <<what <<" reads " <<all.size() <<" ns p50 " <<pct(0.50)
+             <<" p99 " <<pct(0.99) <<" max " <<all.back() <<std::endl;
+}
+}
+
+TEST(XrdCmsSnapshot, ReadLatency)
+{
+   XrdCmsSnapshot<Table> snap;
+   XrdSysRWLock rwLock;
+   Table shared, t;
+   std::atomic<int> sink{0};
+
+   ReadLatency("snapshot",
+       [&]() {XrdCmsSnapshot<Table>::Reader rd(snap); sink += rd->a;},
+       [&]() {t.a++; t.b = -t.a; snap.Publish(t);});
+
+   ReadLatency("rwlock  ",
+       [&]() {rwLock.ReadLock(); sink += shared.a; rwLock.UnLock();},
+       [&]() {rwLock.WriteLock();
+              shared.a++; shared.b = -shared.a;
+              std::this_thread::sleep_for(std::chrono::microseconds(5));
+              rwLock.UnLock();
+             });
+}
@@ -0,0 +1,82 @@
+#undef NDEBUG
+
+#include "XrdCms/XrdCmsWideMask.hh"
+
+#include <chrono>
+#include <iostream>
+
+#include <gtest/gtest.h>
+
+typedef XrdCmsWideMask<4> Mask256;
+
+TEST(XrdCmsWideMask, BitOps)
+{
+   Mask256 m;
+   EXPECT_FALSE(m);
+   EXPECT_EQ(m.LowBit(), -1);
+   EXPECT_EQ(m.Count(), 0);
+
+   m |= Mask256::Bit(200);
+   EXPECT_TRUE(m);
+   EXPECT_EQ(m.LowBit(), 200);
+   EXPECT_EQ(m.Count(), 1);
+   EXPECT_FALSE(m.Multiple());
+
+   m |= Mask256::Bit(3);
+   EXPECT_EQ(m.LowBit(), 3);
+   EXPECT_EQ(m.Count(), 2);
+   EXPECT_TRUE(m.Multiple());
+
+   EXPECT_TRUE((m & Mask256::Bit(200)) != 0);
+   EXPECT_TRUE((m & Mask256::Bit(64)) == 0);
+   m &= ~Mask256::Bit(3);
+   EXPECT_EQ(m, Mask256::Bit(200));
+
+   EXPECT_EQ(Mask256::Full().Count(), 256);
+   EXPECT_EQ((~Mask256::Full()).Count(), 0);
+   EXPECT_FALSE(Mask256::Bit(256));
+   EXPECT_FALSE(Mask256::Bit(-1));
+}
+
+TEST(XrdCmsWideMask, IntegerCompat)
+{
+   Mask256 m(0x5ULL);
+   EXPECT_EQ(m.Count(), 2);
+   EXPECT_EQ(m.LowBit(), 0);
+   m = 0;
+   EXPECT_TRUE(!m);
+   Mask256 n = (m ? m : 0);
+   EXPECT_EQ(n, m);
+}
+
+// Measure the cost of a typical selection scan, i.e. finding every node in
+// a candidate mask, as the node count grows. This is informational only.
+//
+template<int N>
+static double ScanCost(int nodes)
+{
+   XrdCmsWideMask<N> all, cand;
+   int found = 0, loops = 20000;
+
+   for (int i = 0; i < nodes; i++) all |= XrdCmsWideMask<N>::Bit(i);
+   for (int i = 0; i < nodes; i += 3) cand |= XrdCmsWideMask<N>::Bit(i);
+
+   auto t0 = std::chrono::steady_clock::now();
+   for (int j = 0; j < loops; j++)
+       {XrdCmsWideMask<N> m = cand & all;
+        int n;
+        while((n = m.LowBit()) >= 0)
+             {found++; m &= ~XrdCmsWideMask<N>::Bit(n);}
+       }
+   auto t1 = std::chrono::steady_clock::now();
+
+   EXPECT_EQ(found, loops * ((nodes + 2) / 3));
+   return std::chrono::duration<double, std::nano>(t1 - t0).count() / loops;
+}
+
+TEST(XrdCmsWideMask, SelectionCost)
+{
+   std::cout << "scan   64 nodes: " << ScanCost<1>(64)   << " ns" << std::endl;
+   std::cout << "scan  256 nodes: " << ScanCost<4>(256)  << " ns" << std::endl;
+   std::cout << "scan 1024 nodes: " << ScanCost<16>(1024) << " ns" << std::endl;
+}
@@ -0,0 +1,255 @@
+//------------------------------------------------------------------------------
+// Unit tests for reading archive members through XrdOssArcZipFile.
+//
+// XrdOssArcFile hands every member open, read, and stat to XrdOssArcZipFile
+// once the archive is staged, so these are the calls exercised here. Stored
+// members found through the index are read directly from the archive and
+// their CRC is checked as they are read; other members go through libzip.
+// These tests are only built when libzip is available.
+//------------------------------------------------------------------------------
+
+#include "XrdOssArc/XrdOssArcZipFile.hh"
+#include "XrdOssArc/XrdOssArcZipIndex.hh"
+#include "XrdOssArc/XrdOssArcZipWriter.hh"
+
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zip.h>
+
+namespace {
+
+class XrdOssArcZipFileTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      char tmpl[] = "/tmp/xrdossarczipXXXXXX";
+      ASSERT_NE(mkdtemp(tmpl), nullptr);
+      dir     = tmpl;
+      srcDir  = dir + "/src";
+      arcPath = dir + "/arc.zip";
+      ASSERT_EQ(mkdir(srcDir.c_str(), 0755), 0);
+   }
+
+   void TearDown() override
+   {
+      XrdOssArcZipIndex::Purge(arcPath.c_str());
+      std::string cmd = "rm -rf " + dir;
+      (void)system(cmd.c_str());
+   }
+
+   void AddFile(const std::string& name, size_t size)
+   {
+      std::string data(size, 0);
+      for (size_t i = 0; i < size; i++) data[i] = char(name.size()*13 + i*5);
+      int fd = open((srcDir + '/' + name).c_str(), O_WRONLY|O_CREAT, 0644);
+      ASSERT_GE(fd, 0);
+      ASSERT_EQ(write(fd, data.data(), size), (ssize_t)size);
+      close(fd);
+      files[name] = data;
+   }
+
+   void Build()
+   {
+      XrdOssArcZipWriter writer(2, 65536);
+      XrdOssArcZipWriter::Stats stats;
+      std::string eText;
+
+      ASSERT_EQ(writer.Build(srcDir.c_str(), arcPath.c_str(), stats, eText), 0)
+                <<eText;
+      ASSERT_EQ(stats.idxRC, 0) <<eText;
+   }
+
+   // Overwrite bytes of the archive keeping its modification time so that
+   // its saved index still applies.
+   //
+   void Patch(off_t offset, const std::string& bytes)
+   {
+      struct stat Stat;
+      int fd = open(arcPath.c_str(), O_RDWR);
+      ASSERT_GE(fd, 0);
+      ASSERT_EQ(fstat(fd, &Stat), 0);
+      ASSERT_EQ(pwrite(fd, bytes.data(), bytes.size(), offset),
+                (ssize_t)bytes.size());
+      struct timespec times[2] = {Stat.st_atim, Stat.st_mtim};
+      ASSERT_EQ(futimens(fd, times), 0);
+      close(fd);
+   }
+
+   // Return the index entry of a member
+   //
+   XrdOssArcZipIndex::Entry Entry(const std::string& name)
+   {
+      struct stat Stat;
+      XrdOssArcZipIndex::Entry ent = {};
+      int rc = -1, fd = open(arcPath.c_str(), O_RDONLY);
+      EXPECT_GE(fd, 0);
+      EXPECT_EQ(fstat(fd, &Stat), 0);
+      auto index = XrdOssArcZipIndex::Get(arcPath.c_str(), fd, Stat, rc);
+      EXPECT_TRUE(index != nullptr);
+      if (index && index->Find(name.c_str())) ent = *index->Find(name.c_str());
+      close(fd);
+      return ent;
+   }
+
+   // Read a member sequentially in pieces of bsz bytes, returning the last
+   // result of a read.
+   //
+   ssize_t ReadAll(XrdOssArcZipFile& zf, std::string& data, size_t bsz)
+   {
+      std::vector<char> buff(bsz);
+      ssize_t ret;
+      data.clear();
+      while((ret = zf.Read(buff.data(), data.size(), bsz)) > 0)
+           data.append(buff.data(), ret);
+      return ret;
+   }
+
+   std::map<std::string, std::string> files;
+   std::string dir;
+   std::string srcDir;
+   std::string arcPath;
+};
+
+} // namespace
+
+TEST_F(XrdOssArcZipFileTest, IndexHit)
+{
+   AddFile("a",     1000);
+   AddFile("big",   300000);
+   AddFile("empty", 0);
+   Build();
+
+// Break the end of central directory so that libzip could not open the
+// archive. Members must still be served through the saved index.
+//
+   struct stat Stat;
+   ASSERT_EQ(stat(arcPath.c_str(), &Stat), 0);
+   Patch(Stat.st_size - 22, "XXXX");
+
+   int rc = -1;
+   XrdOssArcZipFile zf(arcPath.c_str(), rc);
+   ASSERT_EQ(rc, 0);
+
+   for (auto& f : files)
+       {ASSERT_EQ(zf.Open(f.first.c_str()), 0) <<f.first;
+        struct stat mStat;
+        ASSERT_EQ(zf.Stat(mStat), 0);
+        EXPECT_EQ(mStat.st_size, (off_t)f.second.size());
+        std::string data;
+        EXPECT_EQ(ReadAll(zf, data, 65536), 0) <<f.first;
+        EXPECT_EQ(data, f.second) <<f.first;
+       }
+
+// Random reads and reads past the end
+//
+   ASSERT_EQ(zf.Open("big"), 0);
+   char buff[100];
+   EXPECT_EQ(zf.Read(buff, 200000, sizeof(buff)), (ssize_t)sizeof(buff));
+   EXPECT_EQ(std::string(buff, sizeof(buff)), files["big"].substr(200000, 100));
+   EXPECT_EQ(zf.Read(buff, 299950, sizeof(buff)), 50);
+   EXPECT_EQ(zf.Read(buff, 300000, sizeof(buff)), 0);
+
+// Members can be looked up without opening them
+//
+   struct stat mStat;
+   EXPECT_EQ(zf.Stat("a", mStat), 0);
+   EXPECT_EQ(mStat.st_size, 1000);
+   EXPECT_EQ(zf.Stat("nothere", mStat), -ENOENT);
+   EXPECT_EQ(zf.Open("nothere"), -ENOENT);
+   EXPECT_EQ(zf.Close(), 0);
+}
+
+TEST_F(XrdOssArcZipFileTest, CrcMismatch)
+{
+   AddFile("a",   1000);
+   AddFile("bad", 200000);
+   Build();
+
+// Corrupt a byte of the member's data. Its header still matches the index so
+// the open succeeds.
+//
+   XrdOssArcZipIndex::Entry ent = Entry("bad");
+   ASSERT_EQ(ent.size, 200000u);
+   char orig;
+   int fd = open(arcPath.c_str(), O_RDONLY);
+   ASSERT_EQ(pread(fd, &orig, 1, ent.dataOff + 150000), 1);
+   close(fd);
+   Patch(ent.dataOff + 150000, std::string(1, char(~orig)));
+
+   int rc = -1;
+   XrdOssArcZipFile zf(arcPath.c_str(), rc);
+   ASSERT_EQ(rc, 0);
+   ASSERT_EQ(zf.Open("bad"), 0);
+
+// A read that skips ahead disables the check
+//
+   char buff[4096];
+   EXPECT_EQ(zf.Read(buff, 100000, sizeof(buff)), (ssize_t)sizeof(buff));
+   std::string data;
+   EXPECT_EQ(ReadAll(zf, data, 65536), 0);
+   EXPECT_EQ(data.size(), 200000u);
+
+// Reading it sequentially fails once the end is reached and thereafter
+//
+   ASSERT_EQ(zf.Open("bad"), 0);
+   EXPECT_EQ(ReadAll(zf, data, 65536), -EILSEQ);
+   EXPECT_EQ(data.size(), 196608u);
+   EXPECT_EQ(zf.Read(buff, 0, sizeof(buff)), -EILSEQ);
+
+// Other members are unaffected
+//
+   ASSERT_EQ(zf.Open("a"), 0);
+   EXPECT_EQ(ReadAll(zf, data, 333), 0);
+   EXPECT_EQ(data, files["a"]);
+}
+
+TEST_F(XrdOssArcZipFileTest, Deflated)
+{
+   std::string text(100000, 0), raw(5000, 0);
+   for (size_t i = 0; i < text.size(); i++) text[i] = "abcdefgh"[i % 8];
+   for (size_t i = 0; i < raw.size(); i++)  raw[i]  = char(i * 7);
+
+// Make an archive without an index holding a deflated and a stored member
+//
+   int zrc;
+   zip_t* za = zip_open(arcPath.c_str(), ZIP_CREATE|ZIP_TRUNCATE, &zrc);
+   ASSERT_NE(za, nullptr);
+   zip_source_t* src = zip_source_buffer(za, text.data(), text.size(), 0);
+   zip_int64_t idx = zip_file_add(za, "text", src, ZIP_FL_OVERWRITE);
+   ASSERT_GE(idx, 0);
+   ASSERT_EQ(zip_set_file_compression(za, idx, ZIP_CM_DEFLATE, 0), 0);
+   src = zip_source_buffer(za, raw.data(), raw.size(), 0);
+   idx = zip_file_add(za, "raw", src, ZIP_FL_OVERWRITE);
+   ASSERT_GE(idx, 0);
+   ASSERT_EQ(zip_set_file_compression(za, idx, ZIP_CM_STORE, 0), 0);
+   ASSERT_EQ(zip_close(za), 0);
+
+   int rc = -1;
+   XrdOssArcZipFile zf(arcPath.c_str(), rc);
+   ASSERT_EQ(rc, 0);
+
+// The deflated member is inflated by libzip
+//
+   struct stat mStat;
+   EXPECT_EQ(zf.Stat("text", mStat), 0);
+   EXPECT_EQ(mStat.st_size, (off_t)text.size());
+   ASSERT_EQ(zf.Open("text"), 0);
+   std::string data;
+   EXPECT_EQ(ReadAll(zf, data, 4096), 0);
+   EXPECT_EQ(data, text);
+
+// The stored member is found through the index built from the archive
+//
+   ASSERT_EQ(zf.Open("raw"), 0);
+   EXPECT_EQ(ReadAll(zf, data, 4096), 0);
+   EXPECT_EQ(data, raw);
+   EXPECT_EQ(zf.Close(), 0);
+}
@@ -0,0 +1,259 @@
+//------------------------------------------------------------------------------
+// Unit tests for the member index of XrdOssArc zip archives.
+//
+// Archives are built from a temporary directory tree by the stored archive
+// writer, which also saves their index. The tests cover looking up members in
+// a saved index, building the index from the central directory when there is
+// none or it is stale, and the ordering and cacheing of indexes. None of it
+// needs the zip library.
+//------------------------------------------------------------------------------
+
+#include "XrdOssArc/XrdOssArcZipIndex.hh"
+#include "XrdOssArc/XrdOssArcZipWriter.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysLogger.hh"
+#include "XrdSys/XrdSysTrace.hh"
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+namespace XrdOssArcGlobals
+{
+XrdSysLogger    Logger(2, 0);
+XrdSysError     Elog(&Logger, "OssArc_");
+XrdSysTrace     ArcTrace("OssArc");
+}
+
+namespace {
+
+class XrdOssArcZipIndexTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      char tmpl[] = "/tmp/xrdossarcidxXXXXXX";
+      ASSERT_NE(mkdtemp(tmpl), nullptr);
+      dir     = tmpl;
+      srcDir  = dir + "/src";
+      arcPath = dir + "/arc.zip";
+      ASSERT_EQ(mkdir(srcDir.c_str(), 0755), 0);
+      ASSERT_EQ(mkdir((srcDir + "/sub").c_str(), 0755), 0);
+
+      AddFile("a",       1000);
+      AddFile("ab",      70000);
+      AddFile("b",       0);
+      AddFile("sub/c",   200000);
+      AddFile("sub/d.e", 10);
+   }
+
+   void TearDown() override
+   {
+      XrdOssArcZipIndex::Purge(arcPath.c_str());
+      if (arcFD >= 0) close(arcFD);
+      std::string cmd = "rm -rf " + dir;
+      (void)system(cmd.c_str());
+   }
+
+   void AddFile(const std::string& name, size_t size)
+   {
+      std::string data(size, 0);
+      for (size_t i = 0; i < size; i++) data[i] = char(name.size()*31 + i*7);
+      int fd = open((srcDir + '/' + name).c_str(), O_WRONLY|O_CREAT, 0644);
+      ASSERT_GE(fd, 0);
+      ASSERT_EQ(write(fd, data.data(), size), (ssize_t)size);
+      close(fd);
+      files[name] = data;
+   }
+
+   void Build()
+   {
+      XrdOssArcZipWriter writer(2, 65536);
+      XrdOssArcZipWriter::Stats stats;
+      std::string eText;
+
+      ASSERT_EQ(writer.Build(srcDir.c_str(), arcPath.c_str(), stats, eText), 0)
+                <<eText;
+      ASSERT_EQ(stats.idxRC, 0) <<eText;
+      ASSERT_EQ(stats.numFiles, (int)files.size());
+      arcFD = open(arcPath.c_str(), O_RDONLY);
+      ASSERT_GE(arcFD, 0);
+      ASSERT_EQ(fstat(arcFD, &arcStat), 0);
+   }
+
+   std::shared_ptr<XrdOssArcZipIndex> Get()
+   {
+      int rc = -1;
+      auto index = XrdOssArcZipIndex::Get(arcPath.c_str(), arcFD, arcStat, rc);
+      EXPECT_EQ(rc, 0);
+      return index;
+   }
+
+   // Check that every file is found and that its data is where the index
+   // says it is.
+   //
+   void CheckAll(const XrdOssArcZipIndex& index)
+   {
+      ASSERT_EQ(index.Count(), files.size());
+      for (auto& f : files)
+          {const XrdOssArcZipIndex::Entry* ent = index.Find(f.first.c_str());
+           ASSERT_NE(ent, nullptr) <<f.first;
+           EXPECT_EQ(std::string(index.Name(ent), ent->nameLen), f.first);
+           EXPECT_EQ(ent->method, 0);
+           ASSERT_EQ(ent->size, f.second.size()) <<f.first;
+           std::string data(ent->size, 0);
+           EXPECT_EQ(pread(arcFD, &data[0], ent->size, ent->dataOff),
+                     (ssize_t)ent->size);
+           EXPECT_EQ(data, f.second) <<f.first;
+           EXPECT_EQ(ent->crc, crc32(0L, (const Bytef*)f.second.data(),
+                                     f.second.size())) <<f.first;
+           EXPECT_LT(ent->lfhOff, ent->dataOff);
+          }
+   }
+
+   std::map<std::string, std::string> files;
+   std::string dir;
+   std::string srcDir;
+   std::string arcPath;
+   struct stat arcStat;
+   int         arcFD = -1;
+};
+
+} // namespace
+
+TEST_F(XrdOssArcZipIndexTest, Saved)
+{
+   Build();
+   ASSERT_EQ(access((arcPath + ".idx").c_str(), R_OK), 0);
+   auto index = Get();
+   ASSERT_TRUE(index);
+   CheckAll(*index);
+}
+
+TEST_F(XrdOssArcZipIndexTest, Scanned)
+{
+   Build();
+   auto saved = Get();
+   ASSERT_TRUE(saved);
+
+// Without an index, the same one is built from the central directory
+//
+   XrdOssArcZipIndex::Purge(arcPath.c_str());
+   ASSERT_EQ(unlink((arcPath + ".idx").c_str()), 0);
+   auto index = Get();
+   ASSERT_TRUE(index);
+   EXPECT_NE(index, saved);
+   CheckAll(*index);
+
+   for (auto& f : files)
+       {const XrdOssArcZipIndex::Entry* e1 = saved->Find(f.first.c_str());
+        const XrdOssArcZipIndex::Entry* e2 = index->Find(f.first.c_str());
+        EXPECT_EQ(e1->lfhOff,  e2->lfhOff);
+        EXPECT_EQ(e1->dataOff, e2->dataOff);
+        EXPECT_EQ(e1->cdIndex, e2->cdIndex);
+       }
+}
+
+TEST_F(XrdOssArcZipIndexTest, Stale)
+{
+   std::vector<XrdOssArcZipIndex::Member> members;
+   std::string eText;
+
+   Build();
+
+// An index of another archive is ignored and the archive scanned instead
+//
+   members.push_back({"a", 0, 100, 10, 0, 0, 0});
+   ASSERT_EQ(XrdOssArcZipIndex::Save(arcPath.c_str(), arcStat.st_size + 1,
+                                     members, eText), 0) <<eText;
+   auto index = Get();
+   ASSERT_TRUE(index);
+   CheckAll(*index);
+
+// A truncated index is ignored as well
+//
+   XrdOssArcZipIndex::Purge(arcPath.c_str());
+   ASSERT_EQ(XrdOssArcZipIndex::Save(arcPath.c_str(), arcStat.st_size,
+                                     members, eText), 0) <<eText;
+   ASSERT_EQ(truncate((arcPath + ".idx").c_str(), 40), 0);
+   index = Get();
+   ASSERT_TRUE(index);
+   CheckAll(*index);
+}
+
+TEST_F(XrdOssArcZipIndexTest, NotAnArchive)
+{
+   std::string path = srcDir + "/sub/c";
+   struct stat Stat;
+   int rc = 0, fd = open(path.c_str(), O_RDONLY);
+
+   ASSERT_GE(fd, 0);
+   ASSERT_EQ(fstat(fd, &Stat), 0);
+   EXPECT_FALSE(XrdOssArcZipIndex::Get(path.c_str(), fd, Stat, rc));
+   EXPECT_EQ(rc, -ENOEXEC);
+   close(fd);
+}
+
+TEST_F(XrdOssArcZipIndexTest, Lookup)
+{
+   std::vector<XrdOssArcZipIndex::Member> members;
+   std::string eText;
+
+   Build();
+
+// Members are found by their full name only, whatever the order they were
+// given in. Should a name be duplicated the first one is found.
+//
+   members.push_back({"zz",    300, 330, 5, 3, 8, 0});
+   members.push_back({"m",     200, 230, 5, 2, 0, 1});
+   members.push_back({"mm",    100, 130, 5, 1, 0, 2});
+   members.push_back({"m",     400, 430, 5, 4, 0, 3});
+   members.push_back({"a/b/c",   0,  30, 5, 5, 0, 4});
+   ASSERT_EQ(XrdOssArcZipIndex::Save(arcPath.c_str(), arcStat.st_size,
+                                     members, eText), 0) <<eText;
+   auto index = Get();
+   ASSERT_TRUE(index);
+   ASSERT_EQ(index->Count(), 5u);
+
+   const XrdOssArcZipIndex::Entry* ent = index->Find("m");
+   ASSERT_NE(ent, nullptr);
+   EXPECT_EQ(ent->lfhOff, 200u);
+   EXPECT_EQ(ent->cdIndex, 1u);
+
+   ent = index->Find("zz");
+   ASSERT_NE(ent, nullptr);
+   EXPECT_EQ(ent->dataOff, 330u);
+   EXPECT_EQ(ent->crc, 3u);
+   EXPECT_EQ(ent->method, 8);
+
+   ASSERT_NE(index->Find("mm"), nullptr);
+   ASSERT_NE(index->Find("a/b/c"), nullptr);
+   EXPECT_EQ(index->Find(""), nullptr);
+   EXPECT_EQ(index->Find("a"), nullptr);
+   EXPECT_EQ(index->Find("a/b"), nullptr);
+   EXPECT_EQ(index->Find("mmm"), nullptr);
+   EXPECT_EQ(index->Find("z"), nullptr);
+   EXPECT_EQ(index->Find("zzz"), nullptr);
+}
+
+TEST_F(XrdOssArcZipIndexTest, Cached)
+{
+   Build();
+   auto index = Get();
+   ASSERT_TRUE(index);
+   EXPECT_EQ(Get(), index);
+
+// A changed archive gets a new index
+//
+   arcStat.st_mtime++;
+   auto other = Get();
+   ASSERT_TRUE(other);
+   EXPECT_NE(other, index);
+   CheckAll(*other);
+}
@@ -0,0 +1,228 @@
+//------------------------------------------------------------------------------
+// Unit tests for the XrdOssArc stored archive writer.
+//
+// The tests check that the end of the central directory switches to the
+// zip64 records exactly when there are too many members for the classic
+// record, and that a failed build reports what failed and leaves neither the
+// archive nor its temporary file behind.
+//------------------------------------------------------------------------------
+
+#include "XrdOssArc/XrdOssArcZipIndex.hh"
+#include "XrdOssArc/XrdOssArcZipWriter.hh"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const uint32_t eocdSig    = 0x06054b50;
+const uint32_t z64EocdSig = 0x06064b50;
+const uint32_t z64LocSig  = 0x07064b50;
+
+template<typename T>
+T Get(const std::vector<char>& buff, size_t off)
+{
+   T val;
+   memcpy(&val, buff.data() + off, sizeof(T));
+   return val;
+}
+
+class XrdOssArcZipWriterTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      char tmpl[] = "/tmp/xrdossarcwrtXXXXXX";
+      ASSERT_NE(mkdtemp(tmpl), nullptr);
+      dir     = tmpl;
+      srcDir  = dir + "/src";
+      arcPath = dir + "/arc.zip";
+      ASSERT_EQ(mkdir(srcDir.c_str(), 0755), 0);
+   }
+
+   void TearDown() override
+   {
+      XrdOssArcZipIndex::Purge(arcPath.c_str());
+      std::string cmd = "rm -rf " + dir;
+      (void)system(cmd.c_str());
+   }
+
+   void AddFile(const std::string& name, const std::string& data)
+   {
+      int fd = open((srcDir + '/' + name).c_str(), O_WRONLY|O_CREAT, 0644);
+      ASSERT_GE(fd, 0);
+      ASSERT_EQ(write(fd, data.data(), data.size()), (ssize_t)data.size());
+      close(fd);
+   }
+
+   void AddFiles(int count)
+   {
+      char name[32];
+      for (int i = 0; i < count; i++)
+          {snprintf(name, sizeof(name), "m%05d", i);
+           std::string path = srcDir + '/' + name;
+           int fd = open(path.c_str(), O_WRONLY|O_CREAT, 0644);
+           ASSERT_GE(fd, 0);
+           close(fd);
+          }
+   }
+
+   int Build(std::string& eText)
+   {
+      XrdOssArcZipWriter writer(2, 65536);
+      XrdOssArcZipWriter::Stats stats;
+      return writer.Build(srcDir.c_str(), arcPath.c_str(), stats, eText);
+   }
+
+   // Read the tail of the archive, which has no comment, so that the end of
+   // central directory record is its last 22 bytes.
+   //
+   void Tail(std::vector<char>& buff)
+   {
+      struct stat Stat;
+      int fd = open(arcPath.c_str(), O_RDONLY);
+      ASSERT_GE(fd, 0);
+      ASSERT_EQ(fstat(fd, &Stat), 0);
+      size_t tlen = std::min((off_t)128, Stat.st_size);
+      buff.resize(tlen);
+      ASSERT_EQ(pread(fd, buff.data(), tlen, Stat.st_size - tlen),
+                (ssize_t)tlen);
+      close(fd);
+      ASSERT_EQ(Get<uint32_t>(buff, tlen - 22), eocdSig);
+   }
+
+   bool Exists(const std::string& path)
+   {
+      struct stat Stat;
+      return !stat(path.c_str(), &Stat);
+   }
+
+   std::string dir;
+   std::string srcDir;
+   std::string arcPath;
+};
+
+} // namespace
+
+TEST_F(XrdOssArcZipWriterTest, Classic)
+{
+   std::vector<char> tail;
+   std::string eText;
+
+// One member short of the limit still fits the classic record
+//
+   AddFiles(65534);
+   ASSERT_EQ(Build(eText), 0) <<eText;
+   Tail(tail);
+   size_t eocd = tail.size() - 22;
+   EXPECT_EQ(Get<uint16_t>(tail, eocd + 8),  65534);
+   EXPECT_EQ(Get<uint16_t>(tail, eocd + 10), 65534);
+   EXPECT_NE(Get<uint32_t>(tail, eocd - 20), z64LocSig);
+}
+
+TEST_F(XrdOssArcZipWriterTest, Zip64)
+{
+   std::vector<char> tail;
+   std::string eText;
+
+// At the limit the classic record saturates and the zip64 records follow
+// the central directory.
+//
+   AddFiles(65535);
+   ASSERT_EQ(Build(eText), 0) <<eText;
+   Tail(tail);
+   size_t eocd = tail.size() - 22;
+   EXPECT_EQ(Get<uint16_t>(tail, eocd + 8),  0xffff);
+   EXPECT_EQ(Get<uint16_t>(tail, eocd + 10), 0xffff);
+
+   size_t loc = eocd - 20;
+   ASSERT_EQ(Get<uint32_t>(tail, loc), z64LocSig);
+   size_t z64 = loc - 56;
+   ASSERT_EQ(Get<uint32_t>(tail, z64), z64EocdSig);
+   EXPECT_EQ(Get<uint64_t>(tail, z64 + 24), 65535u);
+   EXPECT_EQ(Get<uint64_t>(tail, z64 + 32), 65535u);
+
+// The member index can be rebuilt from the zip64 central directory
+//
+   ASSERT_EQ(unlink((arcPath + ".idx").c_str()), 0);
+   int fd = open(arcPath.c_str(), O_RDONLY);
+   ASSERT_GE(fd, 0);
+   struct stat Stat;
+   ASSERT_EQ(fstat(fd, &Stat), 0);
+   int rc = -1;
+   auto index = XrdOssArcZipIndex::Get(arcPath.c_str(), fd, Stat, rc);
+   EXPECT_EQ(rc, 0);
+   ASSERT_TRUE(index != nullptr);
+   EXPECT_EQ(index->Count(), 65535u);
+   EXPECT_NE(index->Find("m65534"), nullptr);
+   close(fd);
+}
+
+TEST_F(XrdOssArcZipWriterTest, RenameFails)
+{
+   std::string eText;
+
+// The archive name is taken by a non-empty directory so the temporary file
+// cannot be renamed over it. The temporary file must be removed.
+//
+   AddFile("a", "some data");
+   ASSERT_EQ(mkdir(arcPath.c_str(), 0755), 0);
+   ASSERT_EQ(mkdir((arcPath + "/x").c_str(), 0755), 0);
+
+   int rc = Build(eText);
+   EXPECT_EQ(rc, -EISDIR);
+   EXPECT_EQ(eText, "rename " + arcPath + ".part");
+   EXPECT_FALSE(Exists(arcPath + ".part"));
+   EXPECT_FALSE(Exists(arcPath + ".idx"));
+   EXPECT_TRUE(Exists(arcPath + "/x"));
+}
+
+TEST_F(XrdOssArcZipWriterTest, CreateFails)
+{
+   std::string eText;
+
+   AddFile("a", "some data");
+   arcPath = dir + "/nodir/arc.zip";
+   EXPECT_EQ(Build(eText), -ENOENT);
+   EXPECT_EQ(eText, "create " + arcPath + ".part");
+   EXPECT_FALSE(Exists(arcPath));
+}
+
+TEST_F(XrdOssArcZipWriterTest, ScanFails)
+{
+   std::string eText;
+
+   srcDir = dir + "/nosrc";
+   EXPECT_EQ(Build(eText), -ENOENT);
+   EXPECT_EQ(eText, "open directory " + srcDir);
+   EXPECT_FALSE(Exists(arcPath));
+   EXPECT_FALSE(Exists(arcPath + ".part"));
+}
+
+TEST_F(XrdOssArcZipWriterTest, ReadFails)
+{
+   std::string eText;
+
+// A member that cannot be opened fails the build with the error of the open
+// and leaves nothing behind. Permissions do not stop the super user.
+//
+   if (!geteuid()) GTEST_SKIP() << "running as root";
+   AddFile("a", "some data");
+   AddFile("b", "more data");
+   ASSERT_EQ(chmod((srcDir + "/b").c_str(), 0), 0);
+
+   EXPECT_EQ(Build(eText), -EACCES);
+   EXPECT_EQ(eText, "open " + srcDir + "/b");
+   EXPECT_FALSE(Exists(arcPath));
+   EXPECT_FALSE(Exists(arcPath + ".part"));
+}
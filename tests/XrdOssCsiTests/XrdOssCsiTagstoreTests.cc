@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------------
+// Unit tests for the memory mapped tagstore of XrdOssCsi.
+//
+// The tag file is a local file accessed through a minimal XrdOssDF. The tests
+// cover extending the tag file through the mapping, the file format being the
+// one of the plain file tagstore, and a tag file that can not be extended.
+//------------------------------------------------------------------------------
+
+#include "XrdOssCsi/XrdOssCsiTagstoreFile.hh"
+#include "XrdOssCsi/XrdOssCsiTagstoreMmap.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdOuc/XrdOucTrace.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysLogger.hh"
+#include "XrdSys/XrdSysPageSize.hh"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+XrdSysLogger theLogger(2, 0);
+XrdSysError  theEroute(&theLogger, "csi_");
+}
+
+XrdOucTrace OssCsiTrace(&theEroute);
+
+namespace {
+
+// A tag file that is a plain local file
+//
+class LocalDF : public XrdOssDF
+{
+public:
+   using XrdOssDF::Read;
+   using XrdOssDF::Write;
+
+   int Open(const char *path, int Oflag, mode_t Mode, XrdOucEnv &) override
+      {fd = open(path, Oflag, Mode); return (fd < 0 ? -errno : 0);}
+
+   int Close(long long *retsz = 0) override
+      {int rc = (fd < 0 || !close(fd) ? 0 : -errno); fd = -1; return rc;}
+
+   int Fstat(struct stat *buf) override
+      {return (fstat(fd, buf) ? -errno : 0);}
+
+   int Fsync() override {return (fsync(fd) ? -errno : 0);}
+
+   int Ftruncate(unsigned long long flen) override
+      {return (ftruncate(fd, flen) ? -errno : 0);}
+
+   ssize_t Read(off_t, size_t) override {return 0;}
+
+   ssize_t Read(void *buff, off_t offs, size_t blen) override
+      {ssize_t rc = pread(fd, buff, blen, offs); return (rc < 0 ? -errno : rc);}
+
+   ssize_t Write(const void *buff, off_t offs, size_t blen) override
+      {ssize_t rc = pwrite(fd, buff, blen, offs); return (rc < 0 ? -errno : rc);}
+
+   int getFD() override {return fd;}
+
+   LocalDF() : XrdOssDF("test", DF_isFile) {}
+  ~LocalDF() {if (fd >= 0) close(fd);}
+};
+
+class XrdOssCsiTagstoreMmapTest : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      char tmpl[] = "/tmp/xrdosscsitagsXXXXXX";
+      ASSERT_NE(mkdtemp(tmpl), nullptr);
+      dir  = tmpl;
+      path = dir + "/file.xrdt";
+   }
+
+   void TearDown() override
+   {
+      unlink(path.c_str());
+      rmdir(dir.c_str());
+   }
+
+   template<class T>
+   std::unique_ptr<XrdOssCsiTagstore> OpenTags(off_t dsize)
+   {
+      std::unique_ptr<XrdOssCsiTagstore> ts(
+         new T(path, std::unique_ptr<XrdOssDF>(new LocalDF), "test"));
+      EXPECT_EQ(ts->Open(path.c_str(), dsize, O_RDWR|O_CREAT, env), 0);
+      return ts;
+   }
+
+   static std::vector<uint32_t> Tags(size_t n, uint32_t seed)
+   {
+      std::vector<uint32_t> tags(n);
+      for (size_t i = 0; i < n; i++) tags[i] = seed + 2654435761U*i;
+      return tags;
+   }
+
+   std::string dir;
+   std::string path;
+   XrdOucEnv   env;
+};
+
+} // namespace
+
+TEST_F(XrdOssCsiTagstoreMmapTest, Grow)
+{
+// Enough tags to outgrow the initial mapping, written in several pieces
+//
+   const size_t n = 600000, piece = n/4;
+   std::vector<uint32_t> tags = Tags(n, 17), back(n);
+   struct stat sb;
+
+   auto ts = OpenTags<XrdOssCsiTagstoreMmap>(0);
+
+// Storing the last tag extends the file to exactly hold all of them. Its
+// blocks must have been allocated so no store to the mapping needs any.
+//
+   ASSERT_EQ(ts->WriteTags(&tags[n-1], n-1, 1), 1);
+   ASSERT_EQ(stat(path.c_str(), &sb), 0);
+   EXPECT_EQ(sb.st_size, (off_t)(20 + 4*n));
+   EXPECT_GE((off_t)sb.st_blocks*512, sb.st_size & ~(off_t)(sb.st_blksize-1));
+
+   for (size_t i = 0; i < n; i += piece)
+       ASSERT_EQ(ts->WriteTags(&tags[i], i, piece), (ssize_t)piece);
+   ASSERT_EQ(ts->ReadTags(back.data(), 0, n), (ssize_t)n);
+   EXPECT_EQ(tags, back);
+
+// Reading past the tags is as for a short tag file
+//
+   EXPECT_EQ(ts->ReadTags(back.data(), n, 1), -EDOM);
+
+   ASSERT_EQ(ts->SetTrackedSize(n*XrdSys::PageSize), 0);
+   ASSERT_EQ(ts->Fsync(), 0);
+   ASSERT_EQ(ts->Close(), 0);
+
+// The tags are readable by the plain file tagstore
+//
+   auto fs = OpenTags<XrdOssCsiTagstoreFile>(n*XrdSys::PageSize);
+   std::fill(back.begin(), back.end(), 0);
+   ASSERT_EQ(fs->ReadTags(back.data(), 0, n), (ssize_t)n);
+   EXPECT_EQ(tags, back);
+   EXPECT_EQ(fs->Close(), 0);
+}
+
+TEST_F(XrdOssCsiTagstoreMmapTest, OutOfSpace)
+{
+// A file size limit makes extending the tag file fail just as a full disk
+// does. Extending it must fail with an error and not kill us with SIGBUS.
+//
+   const rlim_t limit = 64*1024;
+   const size_t inLimit = (limit - 20)/4;
+   std::vector<uint32_t> tags = Tags(2*inLimit, 5), back(inLimit);
+   struct rlimit oldLim, newLim;
+
+   auto ts = OpenTags<XrdOssCsiTagstoreMmap>(0);
+
+   ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &oldLim), 0);
+   newLim = oldLim;
+   newLim.rlim_cur = limit;
+   void (*oldSig)(int) = signal(SIGXFSZ, SIG_IGN);
+   ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &newLim), 0);
+
+   const ssize_t bad  = ts->WriteTags(tags.data(), 0, 2*inLimit);
+   const ssize_t good = ts->WriteTags(tags.data(), 0, inLimit);
+
+   setrlimit(RLIMIT_FSIZE, &oldLim);
+   signal(SIGXFSZ, oldSig);
+
+   EXPECT_EQ(bad, -EFBIG);
+   ASSERT_EQ(good, (ssize_t)inLimit);
+   ASSERT_EQ(ts->ReadTags(back.data(), 0, inLimit), (ssize_t)inLimit);
+   EXPECT_TRUE(std::equal(back.begin(), back.end(), tags.begin()));
+   EXPECT_EQ(ts->Close(), 0);
+}
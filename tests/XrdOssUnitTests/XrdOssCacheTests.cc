@@ -0,0 +1,176 @@
+//------------------------------------------------------------------------------
+// Unit tests for XrdOssCache space allocation.
+//
+// Three partitions of a space are set up in temporary directories. As they
+// are all on the same file system each is given its own partition data so
+// that its free space and device load can be set by the tests. They are xa
+// partitions, whose files are spread over directories made as needed. The
+// tests cover the choice of partition with and without load balancing,
+// giving back the reserved space when the file can not be created, and
+// concurrent allocations creating the same directories.
+//------------------------------------------------------------------------------
+
+#include "XrdOss/XrdOssCache.hh"
+#include "XrdOss/XrdOssPath.hh"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const char *theSpace = "osscachetest";
+
+const long long GB = 1024LL*1024LL*1024LL;
+
+std::string         theDir;
+XrdOssCache_FS     *thePart[3];
+
+class XrdOssCacheTest : public ::testing::Test
+{
+protected:
+   static void SetUpTestSuite()
+   {
+      char tmpl[] = "/tmp/xrdosscacheXXXXXX";
+      ASSERT_NE(mkdtemp(tmpl), nullptr);
+      theDir = tmpl;
+      ASSERT_EQ(XrdOssPath::InitPrefix(), 0);
+
+      for (int i = 0; i < 3; i++)
+          {std::string path = theDir + "/p" + std::to_string(i);
+           STATFS_t fsbuff;
+           int rc;
+           ASSERT_EQ(mkdir(path.c_str(), 0755), 0);
+           thePart[i] = new XrdOssCache_FS(rc, theSpace, path.c_str(),
+                                           XrdOssCache_FS::isXA);
+           ASSERT_EQ(rc, 0);
+           ASSERT_EQ(FS_Stat(path.c_str(), &fsbuff), 0);
+           thePart[i]->fsdata = new XrdOssCache_FSData(path.c_str(), fsbuff,
+                                                       static_cast<dev_t>(-1-i));
+          }
+   }
+
+   static void TearDownTestSuite()
+   {
+      std::string cmd = "rm -rf " + theDir;
+      if (!theDir.empty()) (void)system(cmd.c_str());
+   }
+
+   void SetUp() override
+   {
+      XrdOssCache::Init(0, 0, 0, 0);
+      Set(0, 10*GB, 0);
+      Set(1, 10*GB, 0);
+      Set(2, 10*GB, 0);
+   }
+
+   void TearDown() override {XrdOssCache::Init(0, 0, 0, 0);}
+
+   static void Set(int i, long long frsz, short busy)
+   {
+      thePart[i]->fsdata->frsz = frsz;
+      thePart[i]->fsdata->busy = busy;
+   }
+
+   static int Which(XrdOssCache_FS *fsp)
+   {
+      for (int i = 0; i < 3; i++) if (fsp == thePart[i]) return i;
+      return -1;
+   }
+
+   // Returns the partition chosen or -errno
+   //
+   static int Alloc(const char *lfn, long long size, mode_t mode = 0)
+   {
+      char pfn[1024];
+      XrdOssCache::allocInfo aInfo(lfn, pfn, sizeof(pfn));
+      int rc;
+
+      aInfo.cgName = theSpace;
+      aInfo.cgSize = size;
+      aInfo.aMode  = mode;
+      if ((rc = XrdOssCache::Alloc(aInfo)) < 0) return rc;
+      if (mode) close(rc);
+      return Which(aInfo.cgFSp);
+   }
+};
+
+} // namespace
+
+TEST_F(XrdOssCacheTest, MostFreeSpace)
+{
+   Set(1, 20*GB, 90);
+   EXPECT_EQ(Alloc("/a", GB), 1);
+   EXPECT_EQ(thePart[1]->fsdata->frsz, 19*GB);
+}
+
+TEST_F(XrdOssCacheTest, LoadAware)
+{
+// A busy device has its free space discounted by weight% of its load, so the
+// idle partition with less space wins once load is weighed in.
+//
+   Set(0, 20*GB, 80);
+   Set(1, 12*GB, 10);
+   Set(2,  8*GB,  0);
+   EXPECT_EQ(Alloc("/a", 1), 0);
+
+   XrdOssCache::Init(0, 0, 0, 100);
+   Set(0, 20*GB, 80);
+   EXPECT_EQ(Alloc("/b", 1), 1);
+
+// With half the weight partition 0 counts as 12GB and partition 1 as 11.4GB
+//
+   XrdOssCache::Init(0, 0, 0, 50);
+   Set(1, 12*GB, 10);
+   EXPECT_EQ(Alloc("/c", 1), 0);
+
+// A partition that can not hold the file is never chosen, however idle
+//
+   XrdOssCache::Init(0, 0, 0, 100);
+   Set(0, 20*GB, 100);
+   Set(1,     GB, 0);
+   Set(2,     GB, 0);
+   EXPECT_EQ(Alloc("/d", 2*GB), 0);
+}
+
+TEST_F(XrdOssCacheTest, FailureGivesBackSpace)
+{
+   std::string gone = theDir + "/gone";
+
+// Files can not be created in a partition whose directory went away
+//
+   Set(2, 20*GB, 0);
+   ASSERT_EQ(rename(thePart[2]->path, gone.c_str()), 0);
+   EXPECT_EQ(Alloc("/f", GB, 0644), -ENOENT);
+   ASSERT_EQ(rename(gone.c_str(), thePart[2]->path), 0);
+   EXPECT_EQ(thePart[2]->fsdata->frsz, 20*GB);
+
+   EXPECT_EQ(Alloc("/f", GB, 0644), 2);
+   EXPECT_EQ(thePart[2]->fsdata->frsz, 19*GB);
+}
+
+TEST_F(XrdOssCacheTest, Concurrent)
+{
+// Files are created unlocked, each thread making the directories it needs
+// unless another thread got there first.
+//
+   static const int nThreads = 8, nFiles = 100;
+   std::vector<std::thread> threads;
+   std::atomic<int> failed(0);
+
+   Set(1, 100*GB, 0);
+   for (int i = 0; i < nThreads; i++)
+       threads.emplace_back([&failed]()
+          {for (int j = 0; j < nFiles; j++)
+               if (Alloc("/f", 1, 0644) != 1) failed++;
+          });
+   for (auto &t : threads) t.join();
+   EXPECT_EQ(failed.load(), 0);
+   EXPECT_EQ(thePart[1]->fsdata->frsz, 100*GB - nThreads*nFiles);
+}
@@ -0,0 +1,123 @@
+//------------------------------------------------------------------------------
+// Unit tests for memory mapping small files in the default oss.
+//
+// The oss is configured with a small file size and three exports in a
+// temporary directory: one that asks for small files to be mapped, one that
+// does not, and a writable one that asks for it. Files are mapped only in the
+// paths that ask for it and only when they are small enough.
+//------------------------------------------------------------------------------
+
+#include "XrdOss/XrdOssApi.hh"
+#include "XrdOuc/XrdOucEnv.hh"
+#include "XrdOuc/XrdOucExport.hh"
+#include "XrdSys/XrdSysLogger.hh"
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const int smallSize = 4096;
+
+XrdSysLogger theLogger(2, 0);
+XrdOssSys   *theOss = 0;
+std::string  theDir;
+
+class XrdOssMioTest : public ::testing::Test
+{
+protected:
+   static void SetUpTestSuite()
+   {
+      char tmpl[] = "/tmp/xrdossmioXXXXXX";
+      ASSERT_NE(mkdtemp(tmpl), nullptr);
+      theDir = tmpl;
+
+      std::string cfn = theDir + "/oss.cfg";
+      std::ofstream cfg(cfn);
+      cfg <<"oss.memfile small " <<smallSize <<"\n"
+          <<"oss.path   " <<theDir <<"/small r/o mmapsmall\n"
+          <<"oss.path   " <<theDir <<"/plain r/o\n"
+          <<"oss.path   " <<theDir <<"/rw mmapsmall\n";
+      cfg.close();
+
+      for (const char *sub : {"/small", "/plain", "/rw"})
+          ASSERT_EQ(mkdir((theDir + sub).c_str(), 0755), 0);
+
+// The config file is only read for the instance the server would be running
+//
+      setenv("XRDINSTANCE", "xrootd anon@localhost", 1);
+      theOss = new XrdOssSys();
+      ASSERT_EQ(theOss->Init(&theLogger, cfn.c_str(), 0), 0);
+   }
+
+   static void TearDownTestSuite()
+   {
+      std::string cmd = "rm -rf " + theDir;
+      if (!theDir.empty()) (void)system(cmd.c_str());
+   }
+
+   // Returns how much of the file is mapped
+   //
+   static off_t Mapped(const char *sub, off_t size)
+   {
+      std::string path = theDir + sub + "/f" + std::to_string(size);
+      std::string data(size, 'x');
+      XrdOucEnv env;
+      void *addr;
+      off_t mlen;
+
+      int fd = open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+      EXPECT_GE(fd, 0);
+      EXPECT_EQ(write(fd, data.data(), size), (ssize_t)size);
+      close(fd);
+
+      XrdOssFile *fp = new XrdOssFile("test");
+      EXPECT_EQ(fp->Open(path.c_str(), O_RDONLY, 0, env), 0);
+      mlen = fp->getMmap(&addr);
+      if (mlen) {EXPECT_EQ(memcmp(addr, data.data(), size), 0);}
+      fp->Close();
+      delete fp;
+      return mlen;
+   }
+};
+
+} // namespace
+
+TEST_F(XrdOssMioTest, Export)
+{
+   std::string path = theDir + "/small";
+
+   EXPECT_TRUE(theOss->PathOpts(path.c_str()) & XRDEXP_MSMALL);
+   path = theDir + "/plain";
+   EXPECT_FALSE(theOss->PathOpts(path.c_str()) & XRDEXP_MSMALL);
+
+// Mapping files requires the path to be read-only
+//
+   path = theDir + "/rw";
+   EXPECT_TRUE(theOss->PathOpts(path.c_str()) & XRDEXP_MSMALL);
+   EXPECT_TRUE(theOss->PathOpts(path.c_str()) & XRDEXP_NOTRW);
+}
+
+TEST_F(XrdOssMioTest, SmallFiles)
+{
+   EXPECT_EQ(Mapped("/small", 100), 100);
+   EXPECT_EQ(Mapped("/small", smallSize), smallSize);
+   EXPECT_EQ(Mapped("/rw", 100), 100);
+}
+
+TEST_F(XrdOssMioTest, NotMapped)
+{
+// Small files are not mapped by default
+//
+   EXPECT_EQ(Mapped("/plain", 100), 0);
+
+// Nor are files that are too large or empty
+//
+   EXPECT_EQ(Mapped("/small", smallSize+1), 0);
+   EXPECT_EQ(Mapped("/small", 0), 0);
+}
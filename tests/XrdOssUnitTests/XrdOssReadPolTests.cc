@@ -0,0 +1,258 @@
+//------------------------------------------------------------------------------
+// Unit tests for XrdOssReadPol.
+//
+// The tests check the aligned range used for unaligned direct reads, how much
+// of a bounce read belongs to the caller (including short reads at EOF), the
+// reuse of the per-file bounce buffer, when streamed access becomes
+// sequential, and the readahead and drop windows that then apply.
+//------------------------------------------------------------------------------
+
+#include "XrdOss/XrdOssReadPol.hh"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const off_t A = XrdOssReadPol::dioAlign;
+
+}
+
+TEST(XrdOssReadPol, Aligned)
+{
+   alignas(4096) static char buff[3*4096];
+
+   EXPECT_TRUE (XrdOssReadPol::Aligned(buff,     0,   A));
+   EXPECT_TRUE (XrdOssReadPol::Aligned(buff,     5*A, 2*A));
+   EXPECT_FALSE(XrdOssReadPol::Aligned(buff+1,   0,   A));
+   EXPECT_FALSE(XrdOssReadPol::Aligned(buff,     100, A));
+   EXPECT_FALSE(XrdOssReadPol::Aligned(buff,     0,   A-1));
+}
+
+TEST(XrdOssReadPol, Enclose)
+{
+   off_t  bOff;
+   size_t bLen;
+
+// Unaligned offset within a single block
+//
+   XrdOssReadPol::Enclose(100, 200, bOff, bLen);
+   EXPECT_EQ(bOff, 0);
+   EXPECT_EQ(bLen, (size_t)A);
+
+// Aligned offset, unaligned length
+//
+   XrdOssReadPol::Enclose(2*A, A+1, bOff, bLen);
+   EXPECT_EQ(bOff, 2*A);
+   EXPECT_EQ(bLen, (size_t)(2*A));
+
+// Unaligned offset and length straddling blocks
+//
+   XrdOssReadPol::Enclose(A-1, 2, bOff, bLen);
+   EXPECT_EQ(bOff, 0);
+   EXPECT_EQ(bLen, (size_t)(2*A));
+
+// Unaligned offset ending exactly on a boundary
+//
+   XrdOssReadPol::Enclose(3*A+10, A-10, bOff, bLen);
+   EXPECT_EQ(bOff, 3*A);
+   EXPECT_EQ(bLen, (size_t)A);
+
+// Large offsets are not truncated
+//
+   off_t big = (off_t)1 << 40;
+   XrdOssReadPol::Enclose(big+7, 3*A, bOff, bLen);
+   EXPECT_EQ(bOff, big);
+   EXPECT_EQ(bLen, (size_t)(4*A));
+}
+
+TEST(XrdOssReadPol, Useful)
+{
+// Full read of the enclosing range yields what the caller asked for
+//
+   EXPECT_EQ(XrdOssReadPol::Useful(A, 100, 0, 200), 200u);
+   EXPECT_EQ(XrdOssReadPol::Useful(2*A, A-1, 0, 2), 2u);
+
+// The file ends within the caller's range: a short read
+//
+   EXPECT_EQ(XrdOssReadPol::Useful(250, 100, 0, 200), 150u);
+   EXPECT_EQ(XrdOssReadPol::Useful(A+5, A-1, 0, 100), 6u);
+
+// The file ends before the caller's range starts or exactly at it
+//
+   EXPECT_EQ(XrdOssReadPol::Useful(50, 100, 0, 200), 0u);
+   EXPECT_EQ(XrdOssReadPol::Useful(100, 100, 0, 200), 0u);
+   EXPECT_EQ(XrdOssReadPol::Useful(0, 100, 0, 200), 0u);
+}
+
+TEST(XrdOssReadPol, Bounce)
+{
+   XrdOssReadPol pol;
+   bool mine, mine2;
+
+// The file's buffer is aligned and reused, grown only when needed
+//
+   char *b1 = pol.Bounce(A, mine);
+   ASSERT_NE(b1, nullptr);
+   EXPECT_TRUE(mine);
+   EXPECT_EQ((uintptr_t)b1 % A, 0u);
+   b1[A-1] = 'x';
+   pol.Unbounce(b1, mine);
+
+   char *b2 = pol.Bounce(2*A, mine);
+   ASSERT_NE(b2, nullptr);
+   EXPECT_TRUE(mine);
+   EXPECT_EQ(b2, b1);
+
+// While it is in use another read gets a buffer of its own
+//
+   char *b3 = pol.Bounce(A, mine2);
+   ASSERT_NE(b3, nullptr);
+   EXPECT_FALSE(mine2);
+   EXPECT_NE(b3, b2);
+   EXPECT_EQ((uintptr_t)b3 % A, 0u);
+   pol.Unbounce(b3, mine2);
+   pol.Unbounce(b2, mine);
+
+// A buffer larger than what is kept is never the file's
+//
+   char *b4 = pol.Bounce(XrdOssReadPol::maxBounce + A, mine);
+   ASSERT_NE(b4, nullptr);
+   EXPECT_FALSE(mine);
+   pol.Unbounce(b4, mine);
+
+   char *b5 = pol.Bounce(3*A, mine);
+   EXPECT_TRUE(mine);
+   pol.Unbounce(b5, mine);
+}
+
+TEST(XrdOssReadPol, Sequential)
+{
+   XrdOssReadPol pol;
+   XrdOssReadPol::Hints h;
+   const long long ra = 0, drop = 0;
+
+// The third read in a row is the first one treated as sequential
+//
+   EXPECT_FALSE(pol.Streamed(1000, 100, ra, drop, h));
+   EXPECT_FALSE(pol.Streamed(1100, 100, ra, drop, h));
+   EXPECT_TRUE (pol.Streamed(1200, 100, ra, drop, h));
+   EXPECT_TRUE (pol.Streamed(1300, 100, ra, drop, h));
+
+// A jump starts over
+//
+   EXPECT_FALSE(pol.Streamed(5000, 100, ra, drop, h));
+   EXPECT_FALSE(pol.Streamed(5100, 100, ra, drop, h));
+   EXPECT_FALSE(pol.Streamed(1000, 100, ra, drop, h));
+   EXPECT_FALSE(pol.Streamed(1100, 100, ra, drop, h));
+   EXPECT_TRUE (pol.Streamed(1200, 100, ra, drop, h));
+
+   off_t dropOff, seqEnd;
+   EXPECT_TRUE(pol.Behind(dropOff, seqEnd));
+   EXPECT_EQ(dropOff, 1000);
+   EXPECT_EQ(seqEnd, 1300);
+
+   EXPECT_FALSE(pol.Streamed(0, 100, ra, drop, h));
+   EXPECT_FALSE(pol.Behind(dropOff, seqEnd));
+}
+
+TEST(XrdOssReadPol, Readahead)
+{
+   XrdOssReadPol pol;
+   XrdOssReadPol::Hints h;
+   const long long ra = 1000;
+
+   pol.Streamed(0,   100, ra, 0, h);
+   pol.Streamed(100, 100, ra, 0, h);
+
+// The first sequential read reads ahead a full window past its end
+//
+   ASSERT_TRUE(pol.Streamed(200, 100, ra, 0, h));
+   EXPECT_EQ(h.raOff, 300);
+   EXPECT_EQ(h.raLen, 1000);
+
+// Nothing more is asked for until half the window is consumed
+//
+   for (off_t off = 300; off < 800; off += 100)
+       {ASSERT_TRUE(pol.Streamed(off, 100, ra, 0, h));
+        EXPECT_EQ(h.raLen, 0) << "at " << off;
+       }
+
+// Then only what lies beyond the previous window is added
+//
+   ASSERT_TRUE(pol.Streamed(800, 100, ra, 0, h));
+   EXPECT_EQ(h.raOff, 1300);
+   EXPECT_EQ(h.raLen, 600);
+   EXPECT_EQ(h.dropLen, 0);
+}
+
+TEST(XrdOssReadPol, DropBehind)
+{
+   XrdOssReadPol pol;
+   XrdOssReadPol::Hints h;
+   const long long drop = 1000;
+
+   pol.Streamed(5000, 400, 0, drop, h);
+   pol.Streamed(5400, 400, 0, drop, h);
+
+// Nothing is dropped until a full chunk lies behind the reader
+//
+   ASSERT_TRUE(pol.Streamed(5800, 400, 0, drop, h));
+   EXPECT_EQ(h.dropLen, 0);
+
+   ASSERT_TRUE(pol.Streamed(6200, 400, 0, drop, h));
+   EXPECT_EQ(h.dropOff, 5000);
+   EXPECT_EQ(h.dropLen, 1200);
+   EXPECT_EQ(h.raLen, 0);
+
+// The next chunk starts where the last drop ended
+//
+   ASSERT_TRUE(pol.Streamed(6600, 400, 0, drop, h));
+   EXPECT_EQ(h.dropLen, 0);
+   ASSERT_TRUE(pol.Streamed(7000, 400, 0, drop, h));
+   EXPECT_EQ(h.dropLen, 0);
+   ASSERT_TRUE(pol.Streamed(7400, 400, 0, drop, h));
+   EXPECT_EQ(h.dropOff, 6200);
+   EXPECT_EQ(h.dropLen, 1200);
+
+   off_t dropOff, seqEnd;
+   EXPECT_TRUE(pol.Behind(dropOff, seqEnd));
+   EXPECT_EQ(dropOff, 7400);
+   EXPECT_EQ(seqEnd, 7800);
+}
+
+TEST(XrdOssReadPol, Concurrent)
+{
+   XrdOssReadPol pol;
+   const int nThreads = 4, nReads = 20000;
+   const size_t bsz = 4096;
+   std::vector<std::thread> thr;
+
+// Readers interleave on one file. Whatever the order in which they get the
+// lock, what they are told to drop must never overlap.
+//
+   std::vector<std::vector<XrdOssReadPol::Hints>> drops(nThreads);
+   for (int t = 0; t < nThreads; t++)
+       thr.emplace_back([&, t] {
+          XrdOssReadPol::Hints h;
+          for (int i = 0; i < nReads; i++)
+              {off_t off = (off_t)(i * nThreads + t) * bsz;
+               if (pol.Streamed(off, bsz, 64*bsz, 16*bsz, h) && h.dropLen)
+                  drops[t].push_back(h);
+              }
+       });
+   for (auto &th : thr) th.join();
+
+   std::vector<std::pair<off_t, off_t>> all;
+   for (auto &d : drops)
+       for (auto &h : d)
+           {EXPECT_GT(h.dropLen, 0);
+            all.emplace_back(h.dropOff, h.dropOff + h.dropLen);
+           }
+   std::sort(all.begin(), all.end());
+   for (size_t i = 1; i < all.size(); i++)
+       EXPECT_LE(all[i-1].second, all[i].first);
+}
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// Unit tests for XrdOssReadV.
+//
+// The tests check how vector read elements are merged into runs (adjacent,
+// within the gap, out of order, overlapping, bounded by the run length) and
+// that a planned read scatters the data into the callers' buffers.
+//------------------------------------------------------------------------------
+
+#include "XrdOss/XrdOssReadV.hh"
+#include "XrdOuc/XrdOucIOVec.hh"
+
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+class XrdOssReadVTest : public ::testing::Test
+{
+protected:
+   void Add(long long offs, int size)
+   {
+      XrdOucIOVec el;
+      el.offset = offs; el.size = size; el.info = 0;
+      el.data   = buff + used; used += size;
+      rv.push_back(el);
+   }
+
+   std::vector<XrdOucIOVec> rv;
+   XrdOssReadV              plan;
+   char                     buff[1024*1024];
+   int                      used = 0;
+};
+
+} // namespace
+
+TEST_F(XrdOssReadVTest, Adjacent)
+{
+   Add(0, 100); Add(100, 100); Add(200, 50);
+   plan.Plan(rv.data(), rv.size(), 0, 1024*1024);
+   ASSERT_EQ(plan.Runs.size(), 1u);
+   EXPECT_EQ(plan.Runs[0].Offset, 0);
+   EXPECT_EQ(plan.Runs[0].Bytes, 250);
+   EXPECT_EQ(plan.Runs[0].iovCnt, 3);
+   EXPECT_EQ(plan.reqBytes, 250);
+   EXPECT_EQ(plan.gapBytes, 0);
+
+// Without merging every element is its own run
+//
+   plan.Plan(rv.data(), rv.size(), -1, 1024*1024);
+   EXPECT_EQ(plan.Runs.size(), 3u);
+}
+
+TEST_F(XrdOssReadVTest, Gaps)
+{
+   Add(0, 100); Add(150, 100); Add(1000, 100);
+   plan.Plan(rv.data(), rv.size(), 50, 1024*1024);
+   ASSERT_EQ(plan.Runs.size(), 2u);
+   EXPECT_EQ(plan.Runs[0].Bytes, 250);
+   EXPECT_EQ(plan.Runs[0].iovCnt, 3);
+   EXPECT_EQ(plan.Runs[1].Offset, 1000);
+   EXPECT_EQ(plan.gapBytes, 50);
+
+// A hole larger than the scratch buffer takes several iovecs
+//
+   plan.Plan(rv.data(), rv.size(), 1000000, 1024*1024);
+   ASSERT_EQ(plan.Runs.size(), 1u);
+   EXPECT_EQ(plan.Runs[0].Bytes, 1100);
+   EXPECT_EQ(plan.gapBytes, 800);
+
+   rv.clear(); used = 0;
+   Add(0, 10); Add(3*XrdOssReadV::gapBSize + 10, 10);
+   plan.Plan(rv.data(), rv.size(), 4*XrdOssReadV::gapBSize, 1024*1024);
+   ASSERT_EQ(plan.Runs.size(), 1u);
+   EXPECT_EQ(plan.Runs[0].iovCnt, 5);
+}
+
+TEST_F(XrdOssReadVTest, OrderAndOverlap)
+{
+   Add(200, 100); Add(0, 100); Add(100, 100); Add(250, 10); Add(300, 0);
+   plan.Plan(rv.data(), rv.size(), 0, 1024*1024);
+
+// Sorted, the first three are adjacent; the overlapping one starts a new run
+// and the empty one is dropped.
+//
+   ASSERT_EQ(plan.Runs.size(), 2u);
+   EXPECT_EQ(plan.Runs[0].Offset, 0);
+   EXPECT_EQ(plan.Runs[0].Bytes, 300);
+   EXPECT_EQ(plan.IOV[0].iov_base, rv[1].data);
+   EXPECT_EQ(plan.IOV[2].iov_base, rv[0].data);
+   EXPECT_EQ(plan.Runs[1].Offset, 250);
+   EXPECT_EQ(plan.reqBytes, 310);
+}
+
+TEST_F(XrdOssReadVTest, MaxRun)
+{
+   for (int i = 0; i < 10; i++) Add(i*1000, 1000);
+   plan.Plan(rv.data(), rv.size(), 0, 4000);
+   ASSERT_EQ(plan.Runs.size(), 3u);
+   EXPECT_EQ(plan.Runs[0].Bytes, 4000);
+   EXPECT_EQ(plan.Runs[2].Bytes, 2000);
+}
+
+TEST_F(XrdOssReadVTest, Read)
+{
+   char tmpl[] = "/tmp/xrdossreadvXXXXXX";
+   int fd = mkstemp(tmpl);
+   ASSERT_GE(fd, 0);
+   unlink(tmpl);
+
+   std::vector<char> data(100000);
+   for (size_t i = 0; i < data.size(); i++) data[i] = static_cast<char>(i*11);
+   ASSERT_EQ(write(fd, data.data(), data.size()),
+             static_cast<ssize_t>(data.size()));
+
+   for (int i = 0; i < 50; i++) Add((49-i)*1500 + (i%3)*7, 1000);
+   plan.Plan(rv.data(), rv.size(), 600, 1024*1024);
+   EXPECT_LT(plan.Runs.size(), rv.size());
+   EXPECT_EQ(plan.Read(fd), 50*1000);
+   for (auto &el : rv)
+       {ASSERT_EQ(memcmp(el.data, data.data() + el.offset, el.size), 0);}
+
+// A read past the end of file is an error
+//
+   rv[0].offset = data.size() - 10;
+   plan.Plan(rv.data(), rv.size(), 600, 1024*1024);
+   EXPECT_EQ(plan.Read(fd), -ESPIPE);
+   close(fd);
+}
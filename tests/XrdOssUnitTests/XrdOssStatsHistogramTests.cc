@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+// Unit tests for the latency histogram and heavy-hitter tracking of the
+// XrdOssStats plugin.
+//
+// The tests check the bucket boundaries, the interval quantiles computed from
+// snapshots, and that the space-saving top-K keeps the heaviest keys.
+//------------------------------------------------------------------------------
+
+#include "XrdOssStats/XrdOssStatsHistogram.hh"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace XrdOssStats;
+
+TEST(XrdOssStatsHistogram, Buckets)
+{
+   EXPECT_EQ(Histogram::Index(0), 0);
+   EXPECT_EQ(Histogram::Index(1023), 0);
+   EXPECT_EQ(Histogram::Index(1024), 1);
+   EXPECT_EQ(Histogram::Index(1279), 1);
+   EXPECT_EQ(Histogram::Index(1280), 2);
+   EXPECT_EQ(Histogram::Index(~0ULL), Histogram::kBuckets - 1);
+
+// Every value lies below the upper bound of its bucket and at or above the
+// upper bound of the previous one; buckets are at most 25% wide.
+//
+   for (uint64_t ns = 1024; ns < (1ULL << Histogram::kMaxShift); ns = ns * 9 / 7)
+       {int idx = Histogram::Index(ns);
+        ASSERT_LT(ns, Histogram::UpperBound(idx));
+        ASSERT_GE(ns, Histogram::UpperBound(idx - 1));
+        ASSERT_LE(Histogram::UpperBound(idx) - Histogram::UpperBound(idx - 1),
+                  Histogram::UpperBound(idx - 1) / 4);
+       }
+}
+
+TEST(XrdOssStatsHistogram, Summarize)
+{
+   Histogram hist;
+   uint64_t counts[Histogram::kBuckets];
+
+   for (int i = 0; i < 1000; i++) hist.Add(100000);     // 100us
+   for (int i = 0; i < 10; i++)   hist.Add(50000000);   // 50ms
+   hist.Add(3000000000ULL);                              // 3s
+   hist.Snapshot(counts);
+
+   auto sum = Histogram::Summarize(counts);
+   EXPECT_EQ(sum.count, 1011u);
+   EXPECT_EQ(sum.p50, Histogram::UpperBound(Histogram::Index(100000)));
+   EXPECT_EQ(sum.p90, sum.p50);
+   EXPECT_EQ(sum.p99, Histogram::UpperBound(Histogram::Index(50000000)));
+   EXPECT_EQ(sum.p999, sum.p99);
+   EXPECT_EQ(sum.max, Histogram::UpperBound(Histogram::Index(3000000000ULL)));
+
+   for (auto &count : counts) count = 0;
+   EXPECT_EQ(Histogram::Summarize(counts).count, 0u);
+}
+
+TEST(XrdOssStatsHistogram, TopK)
+{
+   TopK top(3);
+   for (int i = 0; i < 10; i++)
+       {top.Add("/heavy", 1000);
+        top.Add("/file" + std::to_string(i), 10);
+       }
+   top.Add("/medium", 5000);
+
+   auto entries = top.Drain();
+   ASSERT_EQ(entries.size(), 3u);
+   EXPECT_EQ(entries[0].key, "/heavy");
+   EXPECT_EQ(entries[0].ns, 10000u);
+   EXPECT_EQ(entries[0].count, 10u);
+   EXPECT_EQ(entries[0].error, 0u);
+   EXPECT_EQ(entries[1].key, "/medium");
+   EXPECT_GE(entries[1].ns - entries[1].error, 5000u);
+
+// Draining starts a new period
+//
+   EXPECT_TRUE(top.Drain().empty());
+}
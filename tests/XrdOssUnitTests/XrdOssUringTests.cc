@@ -0,0 +1,175 @@
+//------------------------------------------------------------------------------
+// Unit tests for XrdOssUring.
+//
+// The engine is started once for the whole test program. If the kernel does
+// not allow io_uring (e.g. it is disabled or filtered) the tests are skipped.
+// The tests cover asynchronous reads, pgReads, writes and fsyncs, vector reads
+// with and without registered files, and short vector read segments.
+//------------------------------------------------------------------------------
+
+#include "XrdOss/XrdOssReadV.hh"
+#include "XrdOss/XrdOssUring.hh"
+#include "XrdOuc/XrdOucIOVec.hh"
+#include "XrdOuc/XrdOucPgrwUtils.hh"
+#include "XrdSfs/XrdSfsAio.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysLogger.hh"
+#include "XrdSys/XrdSysPageSize.hh"
+#include "XrdSys/XrdSysPthread.hh"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+class TestAio : public XrdSfsAio
+{
+public:
+   void doneRead()  override {Kind = 'r'; Done.Post();}
+   void doneWrite() override {Kind = 'w'; Done.Post();}
+   void Recycle()   override {}
+
+   XrdSysSemaphore Done{0};
+   char            Kind = 0;
+
+   TestAio(void *buff, size_t blen, off_t offs)
+          {sfsAio.aio_buf    = buff;
+           sfsAio.aio_nbytes = blen;
+           sfsAio.aio_offset = offs;
+          }
+};
+
+bool uringOK = false;
+
+class XrdOssUringTest : public ::testing::Test
+{
+protected:
+   static void SetUpTestSuite()
+   {
+      static XrdSysLogger logger(2, 0);
+      static XrdSysError  eDest(&logger, "uring_");
+      XrdOssUring::Set(1, 2, 32, 1);
+      uringOK = XrdOssUring::Init(eDest);
+   }
+
+   void SetUp() override
+   {
+      if (!uringOK) GTEST_SKIP() << "io_uring is not available";
+      char tmpl[] = "/tmp/xrdossuringXXXXXX";
+      ASSERT_GE((fd = mkstemp(tmpl)), 0);
+      unlink(tmpl);
+   }
+
+   void TearDown() override {if (fd >= 0) close(fd);}
+
+   int fd = -1;
+};
+
+} // namespace
+
+TEST_F(XrdOssUringTest, WriteRead)
+{
+   std::vector<char> out(256*1024), in(out.size());
+   for (size_t i = 0; i < out.size(); i++) out[i] = static_cast<char>(i*7);
+
+   TestAio wrAio(out.data(), out.size(), 4096);
+   ASSERT_TRUE(XrdOssUring::Write(fd, &wrAio));
+   wrAio.Done.Wait();
+   EXPECT_EQ(wrAio.Kind, 'w');
+   EXPECT_EQ(wrAio.Result, static_cast<ssize_t>(out.size()));
+
+   TestAio syAio(0, 0, 0);
+   ASSERT_TRUE(XrdOssUring::Fsync(fd, &syAio));
+   syAio.Done.Wait();
+   EXPECT_EQ(syAio.Kind, 'w');
+   EXPECT_EQ(syAio.Result, 0);
+
+   TestAio rdAio(in.data(), in.size(), 4096);
+   ASSERT_TRUE(XrdOssUring::Read(fd, &rdAio));
+   rdAio.Done.Wait();
+   EXPECT_EQ(rdAio.Kind, 'r');
+   ASSERT_EQ(rdAio.Result, static_cast<ssize_t>(in.size()));
+   EXPECT_EQ(in, out);
+
+// A read past the end of file returns zero bytes
+//
+   TestAio eofAio(in.data(), in.size(), 1024*1024);
+   ASSERT_TRUE(XrdOssUring::Read(fd, &eofAio));
+   eofAio.Done.Wait();
+   EXPECT_EQ(eofAio.Result, 0);
+}
+
+TEST_F(XrdOssUringTest, PgRead)
+{
+   std::vector<char> out(5*XrdSys::PageSize + 100), in(out.size());
+   for (size_t i = 0; i < out.size(); i++) out[i] = static_cast<char>(i*13);
+   ASSERT_EQ(pwrite(fd, out.data(), out.size(), 0),
+             static_cast<ssize_t>(out.size()));
+
+   std::vector<uint32_t> csVec(6), csExp(6);
+   XrdOucPgrwUtils::csCalc(out.data(), 0, out.size(), csExp.data());
+
+   TestAio pgAio(in.data(), in.size(), 0);
+   pgAio.cksVec = csVec.data();
+   ASSERT_TRUE(XrdOssUring::Read(fd, &pgAio, true));
+   pgAio.Done.Wait();
+   ASSERT_EQ(pgAio.Result, static_cast<ssize_t>(in.size()));
+   EXPECT_EQ(in, out);
+   EXPECT_EQ(csVec, csExp);
+}
+
+TEST_F(XrdOssUringTest, ReadV)
+{
+   const int nSeg = 200, segSz = 1000;
+   std::vector<char> out(nSeg*2*segSz), in(nSeg*segSz);
+   std::vector<XrdOucIOVec> rv(nSeg);
+   XrdOssReadV rvPlan;
+   for (size_t i = 0; i < out.size(); i++) out[i] = static_cast<char>(i*3);
+   ASSERT_EQ(pwrite(fd, out.data(), out.size(), 0),
+             static_cast<ssize_t>(out.size()));
+
+// Read every other block, in reverse order, with a plain and a fixed file.
+// Without merging there are more runs than the ring can hold and the rest
+// is read synchronously; with merging there is a single run.
+//
+   bool isReg = XrdOssUring::Register(fd);
+   for (int useReg = 0; useReg < 2; useReg++)
+   for (int maxGap = -1; maxGap <= segSz; maxGap += segSz+1)
+       {for (int i = 0; i < nSeg; i++)
+            {rv[i].offset = (nSeg-1-i)*2*segSz;
+             rv[i].size   = segSz;
+             rv[i].info   = 0;
+             rv[i].data   = in.data() + i*segSz;
+            }
+        std::fill(in.begin(), in.end(), 0);
+        rvPlan.Plan(rv.data(), nSeg, maxGap, 1024*1024);
+        EXPECT_EQ(rvPlan.Runs.size(), static_cast<size_t>(maxGap < 0 ? nSeg : 1));
+        int theFD = (useReg && isReg ? fd | XrdOssUring::isFixed : fd);
+        ASSERT_EQ(XrdOssUring::ReadV(theFD, rvPlan),
+                  static_cast<ssize_t>(nSeg*segSz));
+        for (int i = 0; i < nSeg; i++)
+            {ASSERT_EQ(memcmp(rv[i].data, out.data() + rv[i].offset, segSz), 0);}
+       }
+   if (isReg) XrdOssUring::Unregister(fd);
+
+// A segment that cannot be fully read makes the whole read fail
+//
+   rv[nSeg/2].offset = out.size() - segSz/2;
+   rvPlan.Plan(rv.data(), nSeg, -1, 1024*1024);
+   EXPECT_EQ(XrdOssUring::ReadV(fd, rvPlan), -ESPIPE);
+}
+
+TEST_F(XrdOssUringTest, BadFile)
+{
+   char buff[16];
+   TestAio rdAio(buff, sizeof(buff), 0);
+   ASSERT_TRUE(XrdOssUring::Read(1000000, &rdAio));
+   rdAio.Done.Wait();
+   EXPECT_EQ(rdAio.Result, -EBADF);
+}
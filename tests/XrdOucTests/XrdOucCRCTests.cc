@@ -0,0 +1,85 @@
+#undef NDEBUG
+
+#include "XrdOuc/XrdOucCRC.hh"
+#include "XrdOuc/XrdOucCRC32C.hh"
+#include "XrdSys/XrdSysPageSize.hh"
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class XrdOucCRCTests : public ::testing::Test
+{
+protected:
+   void SetUp() override
+   {
+      data.resize(70*XrdSys::PageSize + 123);
+      for (size_t i = 0; i < data.size(); i++)
+          data[i] = static_cast<uint8_t>((i*2654435761u) >> 13);
+   }
+
+   // Page checksums computed one page at a time
+   std::vector<uint32_t> PageByPage(size_t len)
+   {
+      std::vector<uint32_t> cs;
+      for (size_t off = 0; off < len; off += XrdSys::PageSize)
+          {size_t n = std::min(len - off, (size_t)XrdSys::PageSize);
+           cs.push_back(XrdOucCRC::Calc32C(data.data() + off, n, 0U));
+          }
+      return cs;
+   }
+
+   std::vector<uint8_t> data;
+};
+
+/*
+ * The multi-page kernel must give the same checksums as a single page at a
+ * time for any number of pages (covering the three page stride and the
+ * leftover pages) and for a short last page.
+ */
+TEST_F(XrdOucCRCTests, PagesMatchSingle)
+{
+   const size_t lens[] = {0, 1, 4095, 4096, 4097, 2*4096, 3*4096, 3*4096 + 7,
+                          5*4096, 6*4096, 7*4096 + 4095, 64*4096 + 1,
+                          70*4096 + 123};
+   for (size_t len : lens)
+      {std::vector<uint32_t> expect = PageByPage(len);
+       std::vector<uint32_t> got(expect.size() + 1, 0xdeadbeef);
+       crc32c_pages(data.data(), len, got.data());
+       EXPECT_EQ(got.back(), 0xdeadbeef) << "len " << len;
+       got.pop_back();
+       EXPECT_EQ(got, expect) << "len " << len;
+
+       std::vector<uint32_t> calc(expect.size());
+       XrdOucCRC::Calc32C(data.data(), len, calc.data());
+       EXPECT_EQ(calc, expect) << "len " << len;
+      }
+}
+
+/*
+ * Verification must find the first page that is different, including one
+ * past the internal batch size, and report its actual checksum.
+ */
+TEST_F(XrdOucCRCTests, VerifyPages)
+{
+   const size_t len = data.size();
+   std::vector<uint32_t> cs = PageByPage(len);
+   std::vector<uint32_t> valv(cs.size());
+   uint32_t valcs = 0;
+
+   EXPECT_EQ(XrdOucCRC::Ver32C(data.data(), len, cs.data(), valcs), -1);
+   EXPECT_TRUE(XrdOucCRC::Ver32C(data.data(), len, cs.data(), valv.data()));
+   EXPECT_EQ(valv, cs);
+
+   for (size_t bad : {0ul, 2ul, 65ul, cs.size() - 1})
+      {std::vector<uint32_t> badcs = cs;
+       badcs[bad] ^= 1;
+       EXPECT_EQ(XrdOucCRC::Ver32C(data.data(), len, badcs.data(), valcs),
+                 (int)bad);
+       EXPECT_EQ(valcs, cs[bad]);
+       EXPECT_FALSE(XrdOucCRC::Ver32C(data.data(), len, badcs.data(),
+                                      valv.data()));
+       EXPECT_EQ(valv, cs);
+      }
+}
@@ -0,0 +1,429 @@
+//------------------------------------------------------------------------------
+// Unit tests for the read aggregation of the proxy.
+//
+// The reader sends its upstream requests to a stub origin that serves a file
+// of known content. The stub either completes requests as they are issued or
+// holds them until the test completes them, so the tests control what is in
+// flight. The tests cover coalescing held reads into vector reads, splitting
+// them at the protocol limits, retrying reads on their own when a vector read
+// fails or comes up short, serving reads from read-ahead blocks, and detaching
+// the reader while reads are held or in flight.
+//------------------------------------------------------------------------------
+
+#include "XProtocol/XProtocol.hh"
+#include "XrdOuc/XrdOucIOVec.hh"
+#include "XrdPosix/XrdPosixCallBack.hh"
+#include "XrdPss/XrdPssReader.hh"
+#include "XrdSfs/XrdSfsAio.hh"
+
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const long long fileSize = 4*1024*1024;
+
+char Byte(long long offset) {return char(offset % 251);}
+
+// An origin serving a file of fileSize bytes, large enough for the vector reads
+// of the largest size
+//
+class StubOrigin : public XrdPssReaderOrigin
+{
+public:
+
+struct Call
+      {bool                     isVec;
+       long long                offset;
+       size_t                   blen;
+       char                    *buff;
+       std::vector<XrdOucIOVec> ioV;
+       XrdPosixCallBackIO      *cbp;
+       bool                     done;
+      };
+
+void Pread(int fd, void *buff, size_t blen, off_t offset,
+           XrdPosixCallBackIO *cbp) override
+          {calls.push_back({false, offset, blen, (char *)buff, {}, cbp, false});
+           if (autoDone) Finish(calls.size()-1);
+          }
+
+void VRead(int fd, const XrdOucIOVec *readV, int n,
+           XrdPosixCallBackIO *cbp) override
+          {calls.push_back({true, 0, 0, 0,
+                            std::vector<XrdOucIOVec>(readV, readV+n), cbp,
+                            false});
+           if (autoDone) Finish(calls.size()-1);
+          }
+
+// Complete a call with the data of the file or with the given error. A
+// vector read returns the total bytes read, which is short when one of its
+// reads extends past the end of the file.
+//
+void Finish(size_t i, int err=0)
+           {Call &call = calls[i];
+            ssize_t result = 0;
+            ASSERT_FALSE(call.done);
+            call.done = true;
+            if (err) {errno = err; call.cbp->Complete(-1); return;}
+            if (call.isVec)
+               for (auto &v : call.ioV) result += Copy(v.data, v.offset, v.size);
+               else result = Copy(call.buff, call.offset, call.blen);
+            errno = 0;
+            call.cbp->Complete(result);
+           }
+
+int  Pending() {int n = 0; for (auto &c : calls) if (!c.done) n++; return n;}
+
+std::vector<Call> calls;
+bool              autoDone = false;
+
+private:
+
+static ssize_t Copy(char *buff, long long offset, size_t blen)
+           {if (offset >= fileSize) return 0;
+            if (offset + (long long)blen > fileSize) blen = fileSize - offset;
+            for (size_t i = 0; i < blen; i++) buff[i] = Byte(offset + i);
+            return blen;
+           }
+};
+
+// An async read with its own buffer
+//
+class TestAio : public XrdSfsAio
+{
+public:
+
+void doneRead()  override {done++;}
+void doneWrite() override {}
+void Recycle()   override {}
+
+bool Good(ssize_t want)
+         {if (Result != want) return false;
+          for (ssize_t i = 0; i < want; i++)
+              if (buff[i] != Byte(sfsAio.aio_offset + i)) return false;
+          return true;
+         }
+
+     TestAio(long long offset, int size) : buff(size)
+            {memset(&sfsAio, 0, sizeof(sfsAio));
+             sfsAio.aio_buf    = buff.data();
+             sfsAio.aio_offset = offset;
+             sfsAio.aio_nbytes = size;
+             Result = -1;
+            }
+
+std::vector<char> buff;
+int               done = 0;
+};
+
+class XrdPssReaderTest : public ::testing::Test
+{
+protected:
+   void TearDown() override {XrdPssReader::SetOpts(0, 0, 0);}
+
+   // Return the read-ahead hits counted so far by all readers
+   //
+   long long Hits()
+   {
+      char buff[1024];
+      int n = XrdPssReader::Stats(buff, sizeof(buff));
+      std::string stats(buff, n > 0 ? n : 0);
+      size_t pos = stats.find("<hits>");
+      return (pos == std::string::npos ? -1 : atoll(stats.c_str() + pos + 6));
+   }
+
+   // Issue an async read
+   //
+   TestAio *Read(long long offset, int size)
+   {
+      aios.emplace_back(new TestAio(offset, size));
+      reader->Read(aios.back().get());
+      return aios.back().get();
+   }
+
+   // Issue a sync read and check what it returned
+   //
+   void ReadSync(long long offset, int size)
+   {
+      std::vector<char> buff(size);
+      ssize_t want = (offset + size > fileSize ? fileSize - offset : size);
+      ASSERT_EQ(reader->Read(buff.data(), offset, size), want);
+      for (ssize_t i = 0; i < want; i++)
+          ASSERT_EQ(buff[i], Byte(offset + i)) <<"offset " <<offset+i;
+   }
+
+   StubOrigin                            origin;
+   XrdPssReader                         *reader = new XrdPssReader(3, &origin);
+   std::vector<std::unique_ptr<TestAio>> aios;
+};
+
+} // namespace
+
+TEST_F(XrdPssReaderTest, Coalesce)
+{
+   XrdPssReader::SetOpts(1, 65536, 0);
+
+// The first read goes out right away while the others are held behind it
+//
+   TestAio *first = Read(0, 1000);
+   ASSERT_EQ(origin.calls.size(), 1u);
+   TestAio *held[3] = {Read(50000, 100), Read(20000, 4096), Read(90000, 65536)};
+   ASSERT_EQ(origin.calls.size(), 1u);
+
+// Once it completes they are all sent as one vector read
+//
+   origin.Finish(0);
+   EXPECT_TRUE(first->Good(1000));
+   ASSERT_EQ(origin.calls.size(), 2u);
+   StubOrigin::Call &vec = origin.calls[1];
+   ASSERT_TRUE(vec.isVec);
+   ASSERT_EQ(vec.ioV.size(), 3u);
+   EXPECT_EQ(vec.ioV[0].offset, 50000);
+   EXPECT_EQ(vec.ioV[1].offset, 20000);
+   EXPECT_EQ(vec.ioV[2].size, 65536);
+   for (auto aio : held) EXPECT_EQ(aio->done, 0);
+
+   origin.Finish(1);
+   for (auto aio : held)
+       {EXPECT_EQ(aio->done, 1);
+        EXPECT_TRUE(aio->Good(aio->sfsAio.aio_nbytes));
+       }
+
+// Reads larger than the merge size are never held
+//
+   Read(0, 100);
+   Read(200000, 65537);
+   EXPECT_EQ(origin.calls.size(), 4u);
+   origin.Finish(2);
+   origin.Finish(3);
+   EXPECT_TRUE(aios.back()->Good(65537));
+   reader->Detach();
+}
+
+TEST_F(XrdPssReaderTest, ElementLimit)
+{
+   const int nHeld = XrdProto::maxRvecsz + 10;
+   XrdPssReader::SetOpts(1, 65536, 0);
+
+   Read(0, 16);
+   for (int i = 0; i < nHeld; i++) Read(1000 + i*32, 16);
+
+// The held reads take two vector reads, the first with as many as fit
+//
+   origin.Finish(0);
+   ASSERT_EQ(origin.calls.size(), 2u);
+   EXPECT_EQ(origin.calls[1].ioV.size(), (size_t)XrdProto::maxRvecsz);
+   origin.Finish(1);
+   ASSERT_EQ(origin.calls.size(), 3u);
+   EXPECT_EQ(origin.calls[2].ioV.size(), 10u);
+   origin.Finish(2);
+
+   for (auto &aio : aios) EXPECT_TRUE(aio->Good(16));
+   reader->Detach();
+}
+
+TEST_F(XrdPssReaderTest, DataLimit)
+{
+   const int rdSize = XrdProto::maxRVdsz / 3 + 1;
+   XrdPssReader::SetOpts(1, XrdProto::maxRVdsz, 0);
+
+// Only two reads fit into a vector read; the third is sent on its own once
+// the vector read completes.
+//
+   Read(0, 16);
+   for (int i = 0; i < 3; i++) Read(i*rdSize, rdSize);
+   origin.Finish(0);
+   ASSERT_EQ(origin.calls.size(), 2u);
+   EXPECT_EQ(origin.calls[1].ioV.size(), 2u);
+   origin.Finish(1);
+   ASSERT_EQ(origin.calls.size(), 3u);
+   EXPECT_FALSE(origin.calls[2].isVec);
+   EXPECT_EQ(origin.calls[2].blen, (size_t)rdSize);
+   origin.Finish(2);
+
+   for (size_t i = 1; i < aios.size(); i++) EXPECT_TRUE(aios[i]->Good(rdSize));
+   reader->Detach();
+}
+
+TEST_F(XrdPssReaderTest, VectorFailed)
+{
+   XrdPssReader::SetOpts(1, 65536, 0);
+
+   Read(0, 100);
+   TestAio *a = Read(1000, 100), *b = Read(5000, 100);
+   origin.Finish(0);
+   ASSERT_EQ(origin.calls.size(), 2u);
+
+// Each read is reissued on its own and gets its own result
+//
+   origin.Finish(1, EIO);
+   ASSERT_EQ(origin.calls.size(), 4u);
+   EXPECT_EQ(a->done + b->done, 0);
+   origin.Finish(2);
+   origin.Finish(3, ENOENT);
+   EXPECT_TRUE(b->Good(100));
+   EXPECT_EQ(a->Result, -ENOENT);
+   reader->Detach();
+}
+
+TEST_F(XrdPssReaderTest, VectorShort)
+{
+   XrdPssReader::SetOpts(1, 65536, 0);
+
+// The vector read comes up short because the last read extends past the end
+// of the file. As it cannot tell which read that was, each is reissued on its
+// own so that the short one gets the right count.
+//
+   Read(0, 100);
+   TestAio *a = Read(1000, 100), *b = Read(fileSize - 50, 100);
+   origin.Finish(0);
+   ASSERT_EQ(origin.calls.size(), 2u);
+   origin.Finish(1);
+   ASSERT_EQ(origin.calls.size(), 4u);
+   EXPECT_EQ(a->done + b->done, 0);
+   origin.Finish(2);
+   origin.Finish(3);
+   EXPECT_TRUE(a->Good(100));
+   EXPECT_TRUE(b->Good(50));
+   reader->Detach();
+}
+
+TEST_F(XrdPssReaderTest, ReadAhead)
+{
+   const int rdSize = 4096, raSize = 65536;
+   XrdPssReader::SetOpts(0, 0, raSize);
+   origin.autoDone = true;
+
+// The third sequential read fills a block that serves the reads following it
+//
+   for (int i = 0; i < 3; i++) ReadSync(i*rdSize, rdSize);
+   ASSERT_EQ(origin.calls.size(), 3u);
+   EXPECT_EQ(origin.calls[2].offset, 2*rdSize);
+   EXPECT_EQ(origin.calls[2].blen, (size_t)raSize);
+   for (int i = 3; i < 10; i++) ReadSync(i*rdSize, rdSize);
+
+// Once half of it is consumed the next block is filled
+//
+   ASSERT_EQ(origin.calls.size(), 4u);
+   EXPECT_EQ(origin.calls[3].offset, 2*rdSize + raSize);
+
+// The reads carry on through both blocks and into the next one; a read that
+// straddles two blocks is served from both.
+//
+   size_t before = origin.calls.size();
+   for (int i = 10; i < 2*raSize/rdSize + 2; i++) ReadSync(i*rdSize, rdSize);
+   EXPECT_EQ(origin.calls.size(), before + 1);
+   ReadSync((2*raSize/rdSize + 2)*rdSize - 100, rdSize);
+
+// A random read is sent on its own
+//
+   before = origin.calls.size();
+   ReadSync(500000, 1000);
+   EXPECT_EQ(origin.calls.size(), before + 1);
+   reader->Detach();
+}
+
+TEST_F(XrdPssReaderTest, ReadAheadEOF)
+{
+   const int rdSize = 4096, raSize = 65536;
+   XrdPssReader::SetOpts(0, 0, raSize);
+   origin.autoDone = true;
+
+// The block at the end of the file comes up short and the reads past the end
+// of the file are served from it.
+//
+   long long start = fileSize - 3*rdSize - 1000;
+   for (int i = 0; i < 3; i++) ReadSync(start + i*rdSize, rdSize);
+   size_t before = origin.calls.size();
+   ReadSync(start + 3*rdSize, rdSize);
+   ReadSync(fileSize, rdSize);
+   EXPECT_EQ(origin.calls.size(), before);
+   reader->Detach();
+}
+
+TEST_F(XrdPssReaderTest, ReadAheadHits)
+{
+   const int rdSize = 4096, raSize = 65536;
+   XrdPssReader::SetOpts(0, 0, raSize);
+   long long hits = Hits();
+
+// The read that starts the fill is not a hit; a read waiting for the fill is
+//
+   Read(0, rdSize);
+   Read(rdSize, rdSize);
+   origin.Finish(0);
+   origin.Finish(1);
+   TestAio *filler = Read(2*rdSize, rdSize);
+   TestAio *waiter = Read(3*rdSize, rdSize);
+   ASSERT_EQ(origin.calls.size(), 3u);
+   EXPECT_EQ(origin.calls[2].blen, (size_t)raSize);
+   origin.Finish(2);
+   EXPECT_TRUE(filler->Good(rdSize));
+   EXPECT_TRUE(waiter->Good(rdSize));
+   EXPECT_EQ(Hits(), hits + 1);
+
+// A read running past the block whose rest must be read on its own is not a
+// hit either, while one served from the block is.
+//
+   origin.autoDone = true;
+   size_t before = origin.calls.size();
+   ReadSync(2*rdSize + raSize - 100, rdSize);
+   bool single = false;
+   for (size_t i = before; i < origin.calls.size(); i++)
+       if (origin.calls[i].offset == 2*rdSize + raSize
+       &&  origin.calls[i].blen   == (size_t)(rdSize - 100)) single = true;
+   EXPECT_TRUE(single);
+   EXPECT_EQ(Hits(), hits + 1);
+   ReadSync(5*rdSize, 1000);
+   EXPECT_EQ(Hits(), hits + 2);
+   reader->Detach();
+}
+
+TEST_F(XrdPssReaderTest, DetachHeld)
+{
+   XrdPssReader::SetOpts(1, 65536, 0);
+
+// Held reads fail when the reader is detached while the one in flight
+// completes normally and no further requests are sent.
+//
+   TestAio *first = Read(0, 100);
+   TestAio *a = Read(1000, 100), *b = Read(2000, 100);
+   reader->Detach();
+   EXPECT_EQ(a->Result, -EBADF);
+   EXPECT_EQ(b->Result, -EBADF);
+   EXPECT_EQ(first->done, 0);
+
+   origin.Finish(0);
+   EXPECT_TRUE(first->Good(100));
+   EXPECT_EQ(origin.calls.size(), 1u);
+}
+
+TEST_F(XrdPssReaderTest, DetachInFlight)
+{
+   XrdPssReader::SetOpts(1, 65536, 0);
+
+// A vector read that fails after the reader is detached is not retried;
+// its reads fail instead.
+//
+   Read(0, 100);
+   TestAio *a = Read(1000, 100), *b = Read(2000, 100);
+   origin.Finish(0);
+   ASSERT_EQ(origin.calls.size(), 2u);
+   reader->Detach();
+   EXPECT_EQ(a->done + b->done, 0);
+
+   TestAio *late = Read(3000, 100);
+   EXPECT_EQ(late->Result, -EBADF);
+
+   origin.Finish(1, EIO);
+   EXPECT_EQ(a->Result, -EBADF);
+   EXPECT_EQ(b->Result, -EBADF);
+   EXPECT_EQ(origin.calls.size(), 2u);
+   EXPECT_EQ(origin.Pending(), 0);
+}
@@ -0,0 +1,234 @@
+#include "XrdSfs/XrdSfsInterface.hh"
+#include "XrdThrottle/XrdThrottleAio.hh"
+#include "XrdThrottle/XrdThrottleManager.hh"
+#include "XrdSys/XrdSysError.hh"
+#include "XrdSys/XrdSysLogger.hh"
+#include "XrdOuc/XrdOucTrace.hh"
+
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// The caller's request; records how it was completed.
+class TestAio : public XrdSfsAio {
+public:
+    TestAio() {memset(&sfsAio, 0, sizeof(sfsAio));}
+
+    void doneRead() override {m_reads++;}
+    void doneWrite() override {m_writes++;}
+    void Recycle() override {m_recycled = true;}
+
+    int m_reads{0};
+    int m_writes{0};
+    bool m_recycled{false};
+};
+
+} // namespace
+
+class XrdThrottleAioTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_logger = new XrdSysLogger(STDERR_FILENO, 0);
+        m_log = new XrdSysError(m_logger, "ThrottleTest");
+        m_trace = new XrdOucTrace(m_log);
+        m_manager = new XrdThrottleManager(m_log, m_trace);
+        m_manager->SetThrottles(-1, -1, 2, 1.0);
+    }
+
+    void TearDown() override {
+        delete m_manager;
+        delete m_trace;
+        delete m_log;
+        delete m_logger;
+    }
+
+    XrdSysLogger* m_logger;
+    XrdSysError* m_log;
+    XrdOucTrace* m_trace;
+    XrdThrottleManager* m_manager;
+};
+
+TEST_F(XrdThrottleAioTests, CompletionIsForwarded) {
+    char buff[16];
+    uint32_t csvec[1];
+    TestAio parent;
+    parent.sfsAio.aio_buf = buff;
+    parent.sfsAio.aio_nbytes = sizeof(buff);
+    parent.sfsAio.aio_offset = 4096;
+    parent.cksVec = csvec;
+    parent.TIdent = "user.1:2@host";
+
+    bool ok = false;
+    auto taio = new XrdThrottleAio(&parent, *m_manager, 5, ok);
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(taio->sfsAio.aio_buf, buff);
+    EXPECT_EQ(taio->sfsAio.aio_nbytes, sizeof(buff));
+    EXPECT_EQ(taio->sfsAio.aio_offset, 4096);
+    EXPECT_EQ(taio->cksVec, csvec);
+    EXPECT_STREQ(taio->TIdent, "user.1:2@host");
+
+    // Completion may arrive on another thread
+    taio->Result = 12;
+    std::thread([taio] {taio->doneRead();}).join();
+    EXPECT_EQ(parent.Result, 12);
+    EXPECT_EQ(parent.m_reads, 1);
+    EXPECT_EQ(parent.m_writes, 0);
+    EXPECT_FALSE(parent.m_recycled);
+
+    taio = new XrdThrottleAio(&parent, *m_manager, 5, ok);
+    ASSERT_TRUE(ok);
+    taio->Result = -EIO;
+    taio->doneWrite();
+    EXPECT_EQ(parent.Result, -EIO);
+    EXPECT_EQ(parent.m_writes, 1);
+}
+
+TEST_F(XrdThrottleAioTests, OverlappingRequests) {
+    // Requests in flight at the same time each hold their own timer; completing
+    // them in any order must leave the parent requests untouched by the others.
+    TestAio parents[4];
+    XrdThrottleAio *taios[4];
+    for (int i = 0; i < 4; i++) {
+        bool ok = false;
+        taios[i] = new XrdThrottleAio(&parents[i], *m_manager, 7, ok);
+        ASSERT_TRUE(ok);
+    }
+    for (int i : {2, 0, 3, 1}) {
+        taios[i]->Result = i;
+        taios[i]->doneRead();
+    }
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(parents[i].Result, i);
+        EXPECT_EQ(parents[i].m_reads, 1);
+    }
+
+    // A request that is never submitted is simply recycled
+    bool ok = false;
+    auto taio = new XrdThrottleAio(&parents[0], *m_manager, 7, ok);
+    ASSERT_TRUE(ok);
+    taio->Recycle();
+    EXPECT_EQ(parents[0].m_reads, 1);
+    EXPECT_FALSE(parents[0].m_recycled);
+}
+
+TEST_F(XrdThrottleAioTests, SubmitCompletes) {
+    // An accepted request holds its timer and concurrency slot until the
+    // wrapped file completes it.
+    TestAio parent;
+    XrdSfsAio *taio = nullptr;
+    bool ok = false;
+    parent.sfsAio.aio_nbytes = 1024;
+
+    ASSERT_EQ(m_manager->ActiveIO(), 0u);
+    int rc = XrdThrottleAio::Submit(&parent, *m_manager, 3, nullptr,
+        [&](XrdSfsAio *aiop) {taio = aiop; return 0;}, ok);
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(rc, 0);
+    ASSERT_NE(taio, nullptr);
+    EXPECT_NE(taio, &parent);
+    EXPECT_EQ(m_manager->ActiveIO(), 1u);
+    EXPECT_EQ(parent.m_reads, 0);
+
+    taio->Result = 1024;
+    std::thread([taio] {taio->doneRead();}).join();
+    EXPECT_EQ(m_manager->ActiveIO(), 0u);
+    EXPECT_EQ(parent.Result, 1024);
+    EXPECT_EQ(parent.m_reads, 1);
+
+    // Completion may also come before the wrapped file returns
+    rc = XrdThrottleAio::Submit(&parent, *m_manager, 3, nullptr,
+        [&](XrdSfsAio *aiop) {
+            EXPECT_EQ(m_manager->ActiveIO(), 1u);
+            aiop->Result = 7;
+            aiop->doneWrite();
+            return 0;}, ok);
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(rc, 0);
+    EXPECT_EQ(m_manager->ActiveIO(), 0u);
+    EXPECT_EQ(parent.Result, 7);
+    EXPECT_EQ(parent.m_writes, 1);
+}
+
+TEST_F(XrdThrottleAioTests, SubmitRefused) {
+    // A request the wrapped file refuses is never completed, so its timer is
+    // stopped and its slot released at once; the caller's request is left
+    // for the caller to handle.  Both oss (-errno) and sfs (SFS_ERROR) style
+    // failures count as refusals.
+    TestAio parent;
+    bool ok = false;
+
+    for (int failure : {-EIO, SFS_ERROR}) {
+        int rc = XrdThrottleAio::Submit(&parent, *m_manager, 3, nullptr,
+            [&](XrdSfsAio *) {
+                EXPECT_EQ(m_manager->ActiveIO(), 1u);
+                return failure;}, ok);
+        ASSERT_TRUE(ok);
+        EXPECT_EQ(rc, failure);
+        EXPECT_EQ(m_manager->ActiveIO(), 0u);
+    }
+    EXPECT_EQ(parent.m_reads, 0);
+    EXPECT_EQ(parent.m_writes, 0);
+    EXPECT_FALSE(parent.m_recycled);
+}
+
+TEST_F(XrdThrottleAioTests, SubmitCompletesThenFails) {
+    // The wrapped file may complete a request and still report a failure.
+    // The completion is forwarded once and the substitute is released once,
+    // whichever thread the completion runs on.
+    TestAio parent;
+    bool ok = false;
+
+    int rc = XrdThrottleAio::Submit(&parent, *m_manager, 3, nullptr,
+        [&](XrdSfsAio *aiop) {
+            aiop->Result = -EIO;
+            aiop->doneRead();
+            return -EIO;}, ok);
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(rc, -EIO);
+    EXPECT_EQ(m_manager->ActiveIO(), 0u);
+    EXPECT_EQ(parent.Result, -EIO);
+    EXPECT_EQ(parent.m_reads, 1);
+
+    rc = XrdThrottleAio::Submit(&parent, *m_manager, 3, nullptr,
+        [&](XrdSfsAio *aiop) {
+            std::thread([aiop] {aiop->Result = 5; aiop->doneWrite();}).join();
+            return SFS_ERROR;}, ok);
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(rc, SFS_ERROR);
+    EXPECT_EQ(m_manager->ActiveIO(), 0u);
+    EXPECT_EQ(parent.Result, 5);
+    EXPECT_EQ(parent.m_writes, 1);
+    EXPECT_FALSE(parent.m_recycled);
+}
+
+TEST_F(XrdThrottleAioTests, SubmitOverlapping) {
+    // Each request in flight holds its own slot, released as it completes
+    TestAio parents[4];
+    XrdSfsAio *taios[4];
+    for (int i = 0; i < 4; i++) {
+        bool ok = false;
+        XrdThrottleAio::Submit(&parents[i], *m_manager, 9, nullptr,
+            [&](XrdSfsAio *aiop) {taios[i] = aiop; return 0;}, ok);
+        ASSERT_TRUE(ok);
+        EXPECT_EQ(m_manager->ActiveIO(), unsigned(i + 1));
+    }
+
+    // One more that fails does not disturb the others
+    bool ok = false;
+    TestAio failed;
+    XrdThrottleAio::Submit(&failed, *m_manager, 9, nullptr,
+        [](XrdSfsAio *) {return -ENOMEM;}, ok);
+    EXPECT_EQ(m_manager->ActiveIO(), 4u);
+
+    int left = 4;
+    for (int i : {1, 3, 0, 2}) {
+        taios[i]->Result = i;
+        taios[i]->doneRead();
+        EXPECT_EQ(m_manager->ActiveIO(), unsigned(--left));
+        EXPECT_EQ(parents[i].Result, i);
+    }
+}
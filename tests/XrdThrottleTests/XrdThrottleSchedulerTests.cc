@@ -0,0 +1,305 @@
+#include "XrdThrottle/XrdThrottleScheduler.hh"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace XrdThrottle;
+
+namespace {
+
+int64_t Seconds(double secs) {return static_cast<int64_t>(secs * 1e9);}
+
+// A clock that only moves when told to.
+class FakeClock
+{
+public:
+    Scheduler::ClockFunc Func() {return [this] {return m_now.load();};}
+
+    void Advance(double secs) {m_now += Seconds(secs);}
+
+private:
+    std::atomic<int64_t> m_now{Seconds(1)};
+};
+
+// Wait until the condition holds; the condition is expected to become true
+// shortly, so the wait is only bounded to keep a broken test from hanging.
+template <class Cond>
+bool WaitFor(Cond cond)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!cond()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+const Scheduler::ClassStats *FindStats(const std::vector<Scheduler::ClassStats> &stats,
+                                       const std::string &name)
+{
+    for (const auto &entry : stats) {
+        if (entry.name == name) return &entry;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(XrdThrottleScheduler, TokenBucketDebt) {
+    TokenBucket bucket;
+    bucket.SetRate(1000, 500);
+
+    // The bucket starts full and never holds more than the burst.
+    EXPECT_EQ(500, bucket.Level(Seconds(10)));
+    EXPECT_EQ(500, bucket.Level(Seconds(11)));
+    bucket.Charge(800);
+    EXPECT_EQ(-300, bucket.Level(Seconds(11)));
+    EXPECT_EQ(Seconds(0.3), bucket.Eta(Seconds(11)));
+
+    // Refills shorter than a millisecond are deferred.
+    EXPECT_EQ(-300, bucket.Level(Seconds(11.0005)));
+    EXPECT_EQ(-100, bucket.Level(Seconds(11.2)));
+    EXPECT_EQ(500, bucket.Level(Seconds(20)));
+
+    bucket.SetRate(-1, 0);
+    EXPECT_GT(bucket.Level(Seconds(20)), 0);
+}
+
+TEST(XrdThrottleScheduler, RatesSplitByWeight) {
+    Scheduler scheduler([](Scheduler::Level level, const std::string &name) -> float {
+        if (level == Scheduler::VO) return (name == "atlas") ? 3 : 0;
+        return (name == "heavy") ? 3 : 0;
+    });
+    scheduler.SetLimits(8000000, -1, 1.0);
+
+    auto heavy = scheduler.Open("cms", "heavy", 1);
+    auto light = scheduler.Open("cms", "light", 2);
+    auto other = scheduler.Open("atlas", "other", 3);
+    EXPECT_FALSE(scheduler.Acquire(*heavy, 1000, 1));
+    EXPECT_FALSE(scheduler.Acquire(*light, 1000, 1));
+    EXPECT_FALSE(scheduler.Acquire(*other, 1000, 1));
+
+    // atlas gets 3/4 of the server and cms the rest, which its users split 3:1.
+    auto stats = scheduler.Recompute();
+    ASSERT_EQ(5u, stats.size());
+    ASSERT_NE(nullptr, FindStats(stats, "atlas"));
+    EXPECT_DOUBLE_EQ(6000000, FindStats(stats, "atlas")->rate);
+    EXPECT_DOUBLE_EQ(2000000, FindStats(stats, "cms")->rate);
+    EXPECT_DOUBLE_EQ(1500000, FindStats(stats, "heavy")->rate);
+    EXPECT_DOUBLE_EQ(500000, FindStats(stats, "light")->rate);
+    EXPECT_DOUBLE_EQ(6000000, FindStats(stats, "other")->rate);
+    EXPECT_EQ(2000u, FindStats(stats, "cms")->bytes);
+    EXPECT_EQ(2u, FindStats(stats, "cms")->requests);
+    EXPECT_EQ("cms", FindStats(stats, "light")->vo);
+
+    // Statistics cover a single interval.
+    EXPECT_TRUE(scheduler.Recompute().empty());
+}
+
+TEST(XrdThrottleScheduler, DebtDelaysNextRequest) {
+    FakeClock clock;
+    Scheduler scheduler(nullptr, clock.Func());
+    scheduler.SetLimits(1000000, -1, 0.1);
+    auto file = scheduler.Open("", "user", 1);
+
+    // The first request proceeds but puts the whole path in debt; the next
+    // one waits until the debt is paid off.
+    EXPECT_TRUE(scheduler.TryAcquire(*file, 300000, 1));
+    EXPECT_FALSE(scheduler.TryAcquire(*file, 1000, 1));
+    clock.Advance(0.1);
+    EXPECT_FALSE(scheduler.TryAcquire(*file, 1000, 1));
+    clock.Advance(0.1);
+    EXPECT_TRUE(scheduler.TryAcquire(*file, 1000, 1));
+
+    // A blocking request is queued until the clock pays off the debt.
+    bool waited = false;
+    std::thread waiter([&] {waited = scheduler.Acquire(*file, 1000, 1);});
+    ASSERT_TRUE(WaitFor([&] {return scheduler.Waiting() == 1;}));
+    clock.Advance(0.01);
+    waiter.join();
+    EXPECT_TRUE(waited);
+    EXPECT_EQ(0u, scheduler.Waiting());
+
+    auto stats = scheduler.Recompute();
+    auto user = FindStats(stats, "user");
+    ASSERT_NE(nullptr, user);
+    EXPECT_EQ(3u, user->requests);
+    EXPECT_EQ(1u, user->delayed);
+    EXPECT_EQ(302000u, user->bytes);
+    EXPECT_DOUBLE_EQ(0.01, user->wait_max);
+    EXPECT_DOUBLE_EQ(16384e-6, user->wait_p99);
+    EXPECT_EQ(0, user->wait_p50);
+}
+
+TEST(XrdThrottleScheduler, IdleShareGoesToBusyUser) {
+    FakeClock clock;
+    Scheduler scheduler(nullptr, clock.Func());
+    scheduler.SetLimits(1000000, -1, 0.1);
+    auto busy = scheduler.Open("", "busy", 1);
+    auto quiet = scheduler.Open("", "quiet", 2);
+    EXPECT_TRUE(scheduler.TryAcquire(*busy, 1000, 1));
+    EXPECT_TRUE(scheduler.TryAcquire(*quiet, 1000, 1));
+
+    // Both users are active, so each is assured half of the rate.
+    auto stats = scheduler.Recompute();
+    ASSERT_NE(nullptr, FindStats(stats, "busy"));
+    EXPECT_DOUBLE_EQ(500000, FindStats(stats, "busy")->rate);
+    clock.Advance(0.15);
+
+    // The busy user overruns its buckets and then waits, even though the
+    // server has tokens left for the quiet user.
+    EXPECT_TRUE(scheduler.TryAcquire(*busy, 60000, 1));
+    EXPECT_FALSE(scheduler.TryAcquire(*busy, 1000, 1));
+    EXPECT_TRUE(scheduler.TryAcquire(*quiet, 1000, 1));
+    clock.Advance(0.1);
+    EXPECT_TRUE(scheduler.TryAcquire(*busy, 1000, 1));
+
+    // Once the quiet user has been idle for two intervals its share goes to
+    // the busy one; it gets its share back as soon as it is active again.
+    clock.Advance(0.11);
+    EXPECT_TRUE(scheduler.TryAcquire(*busy, 1000, 1));
+    stats = scheduler.Recompute();
+    ASSERT_NE(nullptr, FindStats(stats, "busy"));
+    ASSERT_NE(nullptr, FindStats(stats, "quiet"));
+    EXPECT_DOUBLE_EQ(1000000, FindStats(stats, "busy")->rate);
+    EXPECT_DOUBLE_EQ(500000, FindStats(stats, "quiet")->rate);
+
+    clock.Advance(0.1);
+    EXPECT_TRUE(scheduler.TryAcquire(*busy, 60000, 1));
+    EXPECT_TRUE(scheduler.TryAcquire(*busy, 60000, 1));
+    EXPECT_FALSE(scheduler.TryAcquire(*busy, 1000, 1));
+}
+
+TEST(XrdThrottleScheduler, ManyFilesDoNotBypass) {
+    FakeClock clock;
+    Scheduler scheduler(nullptr, clock.Func());
+    scheduler.SetLimits(1000000, -1, 0.1);
+    auto first = scheduler.Open("", "greedy", 1);
+
+    // A user in debt gains nothing by opening more files; each of them is
+    // also held to the user's buckets.
+    EXPECT_TRUE(scheduler.TryAcquire(*first, 1000000, 1));
+    std::vector<Scheduler::Handle> files;
+    for (int idx = 0; idx < 50; idx++) {
+        files.push_back(scheduler.Open("", "greedy", 1));
+        EXPECT_FALSE(scheduler.TryAcquire(*files.back(), 1000, 1));
+    }
+    scheduler.Recompute();
+    clock.Advance(0.5);
+    for (auto &file : files) {
+        EXPECT_FALSE(scheduler.TryAcquire(*file, 1000, 1));
+    }
+    EXPECT_FALSE(scheduler.TryAcquire(*first, 1000, 1));
+
+    clock.Advance(0.5);
+    EXPECT_TRUE(scheduler.TryAcquire(*files.back(), 1000, 1));
+}
+
+TEST(XrdThrottleScheduler, HeavyAndLightUsers) {
+    FakeClock clock;
+    Scheduler scheduler(nullptr, clock.Func());
+    scheduler.SetLimits(1000000, -1, 0.1);
+    std::vector<Scheduler::Handle> heavy;
+    for (int idx = 0; idx < 4; idx++) {
+        heavy.push_back(scheduler.Open("cms", "heavy", 1));
+    }
+    auto light = scheduler.Open("cms", "light", 2);
+
+    // The heavy user reads as fast as it is let through on four files, in
+    // large requests; the light user reads 300 KB/s in small ones.  Both are
+    // assured half of the server.  The rates settle over the first half
+    // second, when the scheduler first sees who is active.
+    std::vector<int64_t> heavy_bytes(heavy.size(), 0);
+    int64_t light_bytes = 0;
+    int light_delayed = 0;
+    for (int step = 0; step < 300; step++) {
+        bool measure = step >= 50;
+        for (size_t idx = 0; idx < heavy.size(); idx++) {
+            size_t which = (step + idx) % heavy.size();
+            while (scheduler.TryAcquire(*heavy[which], 50000, 1)) {
+                if (measure) heavy_bytes[which] += 50000;
+            }
+        }
+        if (scheduler.TryAcquire(*light, 3000, 1)) {
+            if (measure) light_bytes += 3000;
+        } else if (measure) {
+            light_delayed++;
+        }
+        clock.Advance(0.01);
+        if (step % 10 == 9) scheduler.Recompute();
+    }
+
+    // Over the last 2.5 seconds the light user is never held up by the heavy
+    // one, which gets its half of the server and no more, split evenly among
+    // its files.
+    EXPECT_EQ(0, light_delayed);
+    EXPECT_EQ(750000, light_bytes);
+    int64_t total = 0;
+    for (auto bytes : heavy_bytes) {
+        EXPECT_GE(bytes, 250000);
+        EXPECT_LE(bytes, 400000);
+        total += bytes;
+    }
+    EXPECT_GE(total, 1200000);
+    EXPECT_LE(total, 1300000);
+}
+
+TEST(XrdThrottleScheduler, FairQueueOrder) {
+    FairQueue queue;
+    queue.SetMaxSleep(std::chrono::milliseconds(5));
+
+    std::atomic<int> permits{0};
+    std::vector<int> order;
+    auto admit_for = [&](int id) {
+        return std::function<bool()>([&, id] {
+            if (permits <= 0) return false;
+            permits--;
+            order.push_back(id);
+            return true;
+        });
+    };
+
+    // Flow 1 queues two requests of cost 1; flow 2 queues one of cost 1.5
+    // after them.  Served in finish order: 1 (1.0), 2 (1.5), 1 (2.0).
+    double finish1 = 0, finish2 = 0;
+    auto admit1a = admit_for(1), admit1b = admit_for(1), admit2 = admit_for(2);
+    auto deadline = FairQueue::Clock::now() + std::chrono::seconds(10);
+    std::vector<std::thread> threads;
+    threads.emplace_back([&] {EXPECT_TRUE(queue.Wait(finish1, 1.0, admit1a, {}, deadline));});
+    ASSERT_TRUE(WaitFor([&] {return queue.Size() == 1;}));
+    threads.emplace_back([&] {EXPECT_TRUE(queue.Wait(finish1, 1.0, admit1b, {}, deadline));});
+    ASSERT_TRUE(WaitFor([&] {return queue.Size() == 2;}));
+    threads.emplace_back([&] {EXPECT_TRUE(queue.Wait(finish2, 1.5, admit2, {}, deadline));});
+    ASSERT_TRUE(WaitFor([&] {return queue.Size() == 3;}));
+
+    for (int idx = 0; idx < 3; idx++) {
+        permits++;
+        queue.Kick();
+    }
+    for (auto &thread : threads) thread.join();
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_EQ((std::vector<int>{1, 2, 1}), order);
+}
+
+TEST(XrdThrottleScheduler, SlotDeadline) {
+    Scheduler scheduler(nullptr);
+    scheduler.SetLimits(-1, -1, 0.05);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(scheduler.AcquireSlot(7, [] {return false;},
+                                       start + std::chrono::milliseconds(20)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    // A slot freed up before or after the waiter queues is taken either way.
+    std::atomic<bool> free_slot{false};
+    std::thread waiter([&] {
+        EXPECT_TRUE(scheduler.AcquireSlot(7, [&] {return free_slot.load();},
+                                          std::chrono::steady_clock::now() + std::chrono::seconds(10)));
+    });
+    free_slot = true;
+    scheduler.ReleaseSlot();
+    waiter.join();
+}
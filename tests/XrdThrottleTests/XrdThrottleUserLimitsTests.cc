@@ -233,3 +233,42 @@ maxconn = 50
     RemoveTempFile(config_file);
 }
 
+
+TEST_F(XrdThrottleUserLimitsTests, LoadUserLimits_Weights) {
+    std::string config_content = R"(
+[default]
+name = *
+maxconn = 200
+
+[user1]
+name = user1
+weight = 4
+
+[cmsusers]
+name = cms:*
+weight = 2.5
+
+[cms]
+vo = cms
+weight = 3
+
+[badvo]
+vo = atlas
+)";
+
+    std::string config_file = CreateTempConfig(config_content);
+    ASSERT_FALSE(config_file.empty());
+
+    EXPECT_EQ(0, m_manager->LoadUserLimits(config_file));
+
+    EXPECT_FLOAT_EQ(4, m_manager->GetUserWeight("user1"));
+    EXPECT_FLOAT_EQ(2.5, m_manager->GetUserWeight("cms:alice"));
+    EXPECT_FLOAT_EQ(0, m_manager->GetUserWeight("user2"));
+    EXPECT_FLOAT_EQ(3, m_manager->GetVOWeight("cms"));
+    EXPECT_FLOAT_EQ(0, m_manager->GetVOWeight("atlas"));
+
+    // A section with only a weight does not hide the connection limits.
+    EXPECT_EQ(200UL, m_manager->GetUserMaxConn("user1"));
+
+    RemoveTempFile(config_file);
+}
@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+// Unit tests for XrdXrootdRedirCache.
+//
+// The cache is driven with a fake clock so that expiry can be checked without
+// sleeping. The tests cover positive entries per network class, negative
+// entries overriding positive ones and vice versa, invalidation, bounded size
+// and the statistics the summary stream reports.
+//------------------------------------------------------------------------------
+
+#include "XrdXrootd/XrdXrootdRedirCache.hh"
+
+#include <gtest/gtest.h>
+#include <ctime>
+#include <string>
+
+namespace {
+
+time_t fakeNow = 1000;
+
+time_t FakeClock() { return fakeNow; }
+
+class XrdXrootdRedirCacheTest : public ::testing::Test
+{
+protected:
+   void SetUp() override { fakeNow = 1000; }
+
+   std::string host;
+   int         port = 0;
+};
+
+} // namespace
+
+TEST_F(XrdXrootdRedirCacheTest, PositiveExpires)
+{
+   XrdXrootdRedirCache rc(5, 60, 100, FakeClock);
+
+   EXPECT_EQ(rc.Find("/a", 0, host, port), XrdXrootdRedirCache::Miss);
+   rc.Add("/a", 0, "srv1", 1094);
+   ASSERT_EQ(rc.Find("/a", 0, host, port), XrdXrootdRedirCache::Found);
+   EXPECT_EQ(host, "srv1");
+   EXPECT_EQ(port, 1094);
+
+   fakeNow += 5;
+   EXPECT_EQ(rc.Find("/a", 0, host, port), XrdXrootdRedirCache::Miss);
+   EXPECT_EQ(static_cast<long long>(rc.numHit),  1);
+   EXPECT_EQ(static_cast<long long>(rc.numMiss), 2);
+}
+
+TEST_F(XrdXrootdRedirCacheTest, NetworkClass)
+{
+   XrdXrootdRedirCache rc(5, 60, 100, FakeClock);
+
+   rc.Add("/a", 1, "v4host", 1094);
+   rc.Add("/a", 2, "v6host", 1095);
+   EXPECT_EQ(rc.Find("/a", 0, host, port), XrdXrootdRedirCache::Miss);
+   ASSERT_EQ(rc.Find("/a", 2, host, port), XrdXrootdRedirCache::Found);
+   EXPECT_EQ(host, "v6host");
+   rc.Add("/a", 2, "v6other", 1096);
+   ASSERT_EQ(rc.Find("/a", 2, host, port), XrdXrootdRedirCache::Found);
+   EXPECT_EQ(host, "v6other");
+   EXPECT_EQ(port, 1096);
+
+// A negative class never returns a redirect
+//
+   EXPECT_EQ(rc.Find("/a", -1, host, port), XrdXrootdRedirCache::Miss);
+}
+
+TEST_F(XrdXrootdRedirCacheTest, Negative)
+{
+   XrdXrootdRedirCache rc(5, 60, 100, FakeClock);
+
+   rc.Add("/a", 0, "srv1", 1094);
+   rc.AddNoEnt("/a");
+   EXPECT_EQ(rc.Find("/a",  0, host, port), XrdXrootdRedirCache::NoEnt);
+   EXPECT_EQ(rc.Find("/a", -1, host, port), XrdXrootdRedirCache::NoEnt);
+
+   fakeNow += 59;
+   EXPECT_EQ(rc.Find("/a", 0, host, port), XrdXrootdRedirCache::NoEnt);
+   fakeNow += 1;
+   EXPECT_EQ(rc.Find("/a", 0, host, port), XrdXrootdRedirCache::Miss);
+
+// Once a file shows up the negative entry is gone
+//
+   rc.AddNoEnt("/b");
+   rc.Add("/b", 0, "srv2", 1094);
+   EXPECT_EQ(rc.Find("/b", 0, host, port), XrdXrootdRedirCache::Found);
+   EXPECT_EQ(static_cast<long long>(rc.numNoEnt), 3);
+}
+
+TEST_F(XrdXrootdRedirCacheTest, Drop)
+{
+   XrdXrootdRedirCache rc(5, 60, 100, FakeClock);
+
+   rc.Add("/a", 0, "srv1", 1094);
+   rc.AddNoEnt("/b");
+   rc.Drop("/a");
+   rc.Drop("/b");
+   rc.Drop("/c");
+   EXPECT_EQ(rc.Find("/a", 0, host, port), XrdXrootdRedirCache::Miss);
+   EXPECT_EQ(rc.Find("/b", 0, host, port), XrdXrootdRedirCache::Miss);
+   EXPECT_EQ(static_cast<long long>(rc.numDrop), 2);
+}
+
+TEST_F(XrdXrootdRedirCacheTest, Bounded)
+{
+   XrdXrootdRedirCache rc(5, 60, 16, FakeClock);
+   int found = 0;
+
+// With one path per slot the newest entry always survives
+//
+   for (int i = 0; i < 1000; i++)
+       {std::string path = "/f" + std::to_string(i);
+        rc.Add(path.c_str(), 0, "srv", 1094);
+        EXPECT_EQ(rc.Find(path.c_str(), 0, host, port),
+                  XrdXrootdRedirCache::Found);
+       }
+   for (int i = 0; i < 1000; i++)
+       {std::string path = "/f" + std::to_string(i);
+        if (rc.Find(path.c_str(), 0, host, port) == XrdXrootdRedirCache::Found)
+           found++;
+       }
+   EXPECT_GT(found, 0);
+   EXPECT_LE(found, 16);
+}
+
+TEST_F(XrdXrootdRedirCacheTest, Stats)
+{
+   XrdXrootdRedirCache rc(5, 60, 100, FakeClock);
+   char buff[256];
+
+   rc.Add("/a", 0, "srv1", 1094);
+   rc.AddNoEnt("/b");
+   rc.Find("/a", 0, host, port);
+   rc.Find("/b", 0, host, port);
+   rc.Find("/c", 0, host, port);
+   rc.Drop("/a");
+
+   int len = rc.Stats(buff, sizeof(buff));
+   EXPECT_EQ(std::string(buff, len), "<rdc><hit>1</hit><nx>1</nx>"
+                                     "<miss>1</miss><inv>1</inv></rdc>");
+   EXPECT_GE(rc.Stats(0, 0), len);
+   EXPECT_EQ(rc.Stats(buff, 8), 0);
+}
+
+TEST_F(XrdXrootdRedirCacheTest, DefaultNegativeIsShort)
+{
+   XrdXrootdRedirCache rc(XrdXrootdRedirCache::defHold,
+                          XrdXrootdRedirCache::defNxHold, 100, FakeClock);
+
+// A file created right after a failed lookup must be found within seconds
+//
+   rc.AddNoEnt("/new");
+   EXPECT_EQ(rc.Find("/new", 0, host, port), XrdXrootdRedirCache::NoEnt);
+   fakeNow += 5;
+   EXPECT_EQ(rc.Find("/new", 0, host, port), XrdXrootdRedirCache::Miss);
+}